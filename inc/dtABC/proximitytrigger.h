@@ -21,6 +21,7 @@
 #ifndef DELTA_PROXIMITY_TRIGGER
 #define DELTA_PROXIMITY_TRIGGER
 
+#include <dtCore/spatialindex.h>
 #include <dtCore/transformable.h>
 #include <dtABC/export.h>
 #include <dtABC/trigger.h>
@@ -30,12 +31,9 @@ namespace dtABC
 {
    /** The ProximityTrigger class contains a Trigger which it fires 
     * whenever a Transformable enters it's bounding shape. By default,
-    * it has a collision sphere set with a radius of 5 units. To filter
-    * what can collide with this ProximityTrigger use SetCollisionCollideBits
-    * as the OR of all the CollisionCategories you want. A ProximityTrigger
-    * is fired only once per touch of a Transformable.
-    *
-    * @note  This class currently does not work!  It may be replaced by other functionality or fixed before the next release.
+    * it is a sphere with a radius of 5 units. The sphere is a volume in the
+    * spatial index of the Scene, so it's checked once a frame, on the frame synch.
+    * A ProximityTrigger is fired only once per touch of a Transformable.
     */
    class DT_ABC_EXPORT ProximityTrigger : public dtCore::Transformable
    {
@@ -76,7 +74,7 @@ namespace dtABC
    public:
       ProximityTrigger(const std::string& name = "ProximityTrigger");
    protected:
-      virtual ~ProximityTrigger() {}
+      virtual ~ProximityTrigger();
    public:
 
       /**
@@ -95,8 +93,16 @@ namespace dtABC
       */
       const Trigger* GetTrigger() const { return mTrigger.get(); }
    
+      /// @return true if the world position is inside the sphere.
       bool IsPointInVolume(float x, float y, float z);
 
+      /// Sets the radius of the sphere.
+      void SetRadius(float radius);
+      float GetRadius() const;
+
+      ///From Transformable
+      virtual void AddedToScene(dtCore::Scene* scene);
+
 
       void SetTimeDelay(float delay){mTrigger->SetTimeDelay(delay);}
       float GetTimeDelay()const{return mTrigger->GetTimeDelay();}
@@ -107,6 +113,11 @@ namespace dtABC
 
    private:
 
+      /// Fires the trigger when something enters the sphere.
+      class Volume;
+
+      dtCore::RefPtr<dtCore::SpatialVolume>     mVolume;
+
       dtCore::RefPtr<Trigger>                   mTrigger;
       int                                       mLastTraversalNumber;
 
@@ -25,12 +25,14 @@
 #include <dtAI/export.h> //included to get rid of warning 4355- 'this' used in base member initializer list
 
 #include <dtAI/astarconfig.h>
+#include <dtAI/astarnodepool.h>
 #include <dtAI/pathfinding.h>
 #include <dtUtil/functor.h>
+#include <dtUtil/hashmap.h>
 
 #include <algorithm>
+#include <new>
 #include <vector>
-#include <set>
 
 namespace dtAI
 {
@@ -59,6 +61,15 @@ namespace dtAI
     *               granularity of time is only relevant to the user and should match the AStarConfig's
     *               MaxTime.
     *
+    *        HashFcn:   This class hashes the DataType for the lookup of the nodes that have been created.
+    *                   It defaults to dtUtil::hash, which supports pointers and the integer types.
+    *
+    *        The open list is a binary heap in which every node knows its position, so a node that is
+    *        reached by a cheaper path is moved up the heap instead of being searched for and replaced.
+    *        Nodes are found by their DataType in a hash map, which also serves as the closed list.
+    *        The nodes are built in an AStarNodePool that keeps its memory between calls to Reset().
+    *        A custom create function should construct its node in the memory from AllocateNode().
+    *
     * @usage To find a path between two points you can call Reset() with the two points
     *        and then FindPath().  Alternatively, you can set a config type which contains
     *        the path points and holds statistical info as well as pathing constraints.  If you
@@ -81,7 +92,7 @@ namespace dtAI
     *
     * Bradley Anderegg
     */
-   template<class _NodeType, class _CostFunc, class _Container, class _Timer>
+   template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn = dtUtil::hash<typename _NodeType::data_type> >
    class AStar
    {
    public:
@@ -89,12 +100,14 @@ namespace dtAI
       typedef typename _NodeType::cost_type cost_type;
       typedef typename _NodeType::data_type data_type;
       typedef std::vector<node_type*> AStarContainer;
-      typedef std::set<data_type> AStarClosedContainer;
+      /// Maps each data_type to the latest node created for it.  Nodes that aren't in the open list are closed.
+      typedef dtUtil::HashMap<data_type, node_type*, _HashFcn> AStarNodeLookup;
       typedef typename AStarContainer::iterator AStarIterator;
       typedef _CostFunc cost_function;
       typedef _Container container_type;
       typedef AStarConfig<data_type, cost_type, container_type> config_type;
-      typedef AStar<node_type, cost_function, container_type, _Timer> MyType;
+      typedef AStar<node_type, cost_function, container_type, _Timer, _HashFcn> MyType;
+      typedef AStarNodePool<node_type> node_pool_type;
 
       typedef dtUtil::Functor<node_type*, TYPELIST_4(node_type*, data_type, cost_type, cost_type)> CreateNodeFunctor;
 
@@ -169,28 +182,43 @@ namespace dtAI
       cost_function& GetCostFunction() { return mCostFunc; }
       const cost_function& GetCostFunction() const { return mCostFunc; }
 
+      /**
+       * Memory for a custom create function to construct its node in with placement new.  The node is
+       * destroyed on the next Reset().  Nodes created with plain new are still deleted with delete.
+       */
+      void* AllocateNode() { return mNodePool.Allocate(); }
+
+      const node_pool_type& GetNodePool() const { return mNodePool; }
+
    protected:
       //AStar(const AStar&); //not implemented by design
       //AStar& operator=(const AStar&); //not implemented by design
       void FreeMem();
 
       /**
-       * Internal helper functions, pulled out of main loop to be optimized
-       * at a later date
+       * Internal helper functions, pulled out of main loop
        */
       void AddNodeLink(node_type* pParent, data_type pData);
       typename AStarContainer::iterator Contains(AStarContainer& pCont, const data_type& pData);
-      typename AStarClosedContainer::iterator Contains(AStarClosedContainer& pCont, const data_type& pData);
       void Remove(AStarContainer& pCont, typename AStarContainer::iterator iterToErase);
       node_type* FindLowestCost(AStarContainer& pCont);
       void Insert(AStarContainer& pCont, node_type* pNode);
-      void Insert(AStarClosedContainer& pCont, const data_type& pData);
+
+      /// Moves a node toward the top of the heap after its cost went down.
+      void SiftUp(AStarContainer& pCont, unsigned int index);
+      /// Moves a node toward the bottom of the heap after its cost went up.
+      void SiftDown(AStarContainer& pCont, unsigned int index);
+
+      /// Calls the create function and keeps track of how the node must be freed.
+      node_type* NewNode(node_type* pParent, data_type pData, cost_type pGn, cost_type pHn);
 
       node_type* CreateNode(node_type* pParent, data_type datatype, cost_type pGn, cost_type pHn);
 
       config_type mConfig;
+      /// mOpen is a binary heap on the total cost, mDeleteMe holds the nodes that were not created in the pool.
       AStarContainer mOpen, mDeleteMe;
-      AStarClosedContainer mClosed;
+      AStarNodeLookup mNodeLookup;
+      node_pool_type mNodePool;
       cost_function mCostFunc;
       _Timer mTimer;
 
@@ -30,71 +30,49 @@ struct delete_func
 };
 
 
-struct node_type_gtr_func
-{
-   template<class T>
-   bool operator()(T& pElement1, T& pElement2)
-   {
-      return pElement2->operator<(*pElement1);
-   }
-};
-
-
-template<class T, class E>
-struct node_type_comp_func
-{
-   node_type_comp_func(const T data): mData(data){}
-
-   bool operator()(const E* pElement)
-   {
-      return pElement->GetData() == mData;
-   }
-private:
-   const T mData;
-};
-
-
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-AStar<_NodeType, _CostFunc, _Container, _Timer>::AStar()
-   : mFuncCreateNode(this, &AStar<_NodeType, _CostFunc, _Container, _Timer>::CreateNode)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::AStar()
+   : mFuncCreateNode(this, &AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::CreateNode)
 {
 
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-AStar<_NodeType, _CostFunc, _Container, _Timer>::AStar(CreateNodeFunctor createFunc)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::AStar(CreateNodeFunctor createFunc)
    : mFuncCreateNode(createFunc)
 {
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-AStar<_NodeType, _CostFunc, _Container, _Timer>::AStar(const config_type& pConfig):
-   mConfig(pConfig)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::AStar(const config_type& pConfig)
+   : mConfig(pConfig)
+   , mFuncCreateNode(this, &AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::CreateNode)
 {
    AddNodeLink(0, pConfig.mStart);
 }
 
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-AStar<_NodeType, _CostFunc, _Container, _Timer>::~AStar()
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::~AStar()
 {
    FreeMem();
 }
 
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::FreeMem()
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::FreeMem()
 {
    std::for_each(mDeleteMe.begin(), mDeleteMe.end(), delete_func());
 
    mOpen.clear();
    mDeleteMe.clear();
-   mClosed.clear();
+   mNodeLookup.clear();
+   mNodePool.Clear();
 }
 
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::Reset(const config_type& pConfig)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::Reset(const config_type& pConfig)
 {
    FreeMem();
    mConfig = pConfig;
@@ -102,16 +80,16 @@ void AStar<_NodeType, _CostFunc, _Container, _Timer>::Reset(const config_type& p
 }
 
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::Reset(data_type pFrom, data_type pTo)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::Reset(data_type pFrom, data_type pTo)
 {
    FreeMem();
    mConfig.Reset(pFrom, pTo);
    AddNodeLink(0, mConfig.Start());
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::Reset(const std::vector<data_type>& pFrom, const std::vector<data_type>& pTo)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::Reset(const std::vector<data_type>& pFrom, const std::vector<data_type>& pTo)
 {
    if (pFrom.empty() || pTo.empty()) { return; }
 
@@ -126,72 +104,130 @@ void AStar<_NodeType, _CostFunc, _Container, _Timer>::Reset(const std::vector<da
 
    while (iter != endOfList)
    {
-      node_type* newNode = mFuncCreateNode(NULL, *iter, mCostFunc(pFrom[0], *iter), mCostFunc(*iter, pTo[0]));
-      mOpen.push_back(newNode);
-      mDeleteMe.push_back(newNode);
+      node_type* newNode = NewNode(NULL, *iter, mCostFunc(pFrom[0], *iter), mCostFunc(*iter, pTo[0]));
+      Insert(mOpen, newNode);
+      mNodeLookup[*iter] = newNode;
       ++iter;
    }
-
-   std::make_heap(mOpen.begin(), mOpen.end(), node_type_gtr_func());
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::AddNodeLink(node_type* pParent, data_type pData)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::AddNodeLink(node_type* pParent, data_type pData)
 {
+   node_type* newNode = NULL;
    if (!pParent)
    {
-      node_type* newNode = mFuncCreateNode(NULL, pData, 0, mCostFunc(mConfig.Start(), mConfig.Finish()));
-      Insert(mOpen, newNode);
-      mDeleteMe.push_back(newNode);
+      newNode = NewNode(NULL, pData, 0, mCostFunc(mConfig.Start(), mConfig.Finish()));
    }
    else
    {
       cost_type costFromParent = mCostFunc(pParent->GetData(), pData);
       cost_type costToFinish   = mCostFunc(pData, mConfig.Finish());
-      node_type* newNode = mFuncCreateNode(pParent, pData, pParent->GetCostToNode() + costFromParent, costToFinish);
-      Insert(mOpen, newNode);
-      mDeleteMe.push_back(newNode);
+      newNode = NewNode(pParent, pData, pParent->GetCostToNode() + costFromParent, costToFinish);
    }
+
+   Insert(mOpen, newNode);
+   mNodeLookup[pData] = newNode;
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::Insert(AStarContainer& pCont, node_type* pNode)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+_NodeType* AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::NewNode(node_type* pParent, data_type pData, cost_type pGn, cost_type pHn)
 {
-   pCont.push_back(pNode);
-   std::push_heap(pCont.begin(), pCont.end(), node_type_gtr_func());
+   unsigned int pooledBefore = mNodePool.GetNumAllocated();
+   node_type* newNode = mFuncCreateNode(pParent, pData, pGn, pHn);
+
+   // a create function that didn't use the pool allocated the node with new
+   if (mNodePool.GetNumAllocated() == pooledBefore)
+   {
+      mDeleteMe.push_back(newNode);
+   }
+   return newNode;
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::Insert(AStarClosedContainer& pCont, const data_type& pData)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::SiftUp(AStarContainer& pCont, unsigned int index)
 {
-   pCont.insert(pData);
+   node_type* node = pCont[index];
+   while (index > 0)
+   {
+      unsigned int parent = (index - 1) / 2;
+      if (!(*node < *pCont[parent]))
+      {
+         break;
+      }
+      pCont[index] = pCont[parent];
+      pCont[index]->SetOpenIndex(index);
+      index = parent;
+   }
+   pCont[index] = node;
+   node->SetOpenIndex(index);
 }
 
-// This needs to be optimized once we have a more suitable container implementation
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-typename AStar<_NodeType, _CostFunc, _Container, _Timer>::AStarContainer::iterator AStar<_NodeType, _CostFunc, _Container, _Timer>::Contains(AStarContainer& pCont, const data_type& pData)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::SiftDown(AStarContainer& pCont, unsigned int index)
 {
-   return std::find_if (pCont.begin(), pCont.end(), node_type_comp_func<data_type, node_type>(pData));
+   node_type* node = pCont[index];
+   unsigned int size = unsigned(pCont.size());
+   for (;;)
+   {
+      unsigned int child = 2 * index + 1;
+      if (child >= size)
+      {
+         break;
+      }
+      if (child + 1 < size && *pCont[child + 1] < *pCont[child])
+      {
+         ++child;
+      }
+      if (!(*pCont[child] < *node))
+      {
+         break;
+      }
+      pCont[index] = pCont[child];
+      pCont[index]->SetOpenIndex(index);
+      index = child;
+   }
+   pCont[index] = node;
+   node->SetOpenIndex(index);
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-typename AStar<_NodeType, _CostFunc, _Container, _Timer>::AStarClosedContainer::iterator AStar<_NodeType, _CostFunc, _Container, _Timer>::Contains(AStarClosedContainer& pCont, const data_type& pData)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::Insert(AStarContainer& pCont, node_type* pNode)
 {
-   return pCont.find(pData);
+   pCont.push_back(pNode);
+   SiftUp(pCont, unsigned(pCont.size() - 1));
 }
 
-// This needs to be optimized once we have a more suitable container implementation
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-void AStar<_NodeType, _CostFunc, _Container, _Timer>::Remove(AStarContainer& pCont, typename AStarContainer::iterator iterToErase)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+typename AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::AStarContainer::iterator AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::Contains(AStarContainer& pCont, const data_type& pData)
 {
-   pCont.erase(iterToErase, iterToErase + 1);
-   std::make_heap(mOpen.begin(), mOpen.end(), node_type_gtr_func());
+   typename AStarNodeLookup::iterator found = mNodeLookup.find(pData);
+   if (found == mNodeLookup.end() || found->second->GetOpenIndex() == node_type::NOT_OPEN)
+   {
+      return pCont.end();
+   }
+   return pCont.begin() + found->second->GetOpenIndex();
 }
 
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+void AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::Remove(AStarContainer& pCont, typename AStarContainer::iterator iterToErase)
+{
+   unsigned int index = unsigned(iterToErase - pCont.begin());
+   (*iterToErase)->SetOpenIndex(node_type::NOT_OPEN);
+
+   node_type* last = pCont.back();
+   pCont.pop_back();
+   if (index < pCont.size())
+   {
+      // the last node fills the hole and may need to go either way
+      pCont[index] = last;
+      SiftDown(pCont, index);
+      SiftUp(pCont, last->GetOpenIndex());
+   }
+}
 
-// This needs to be optimized once we have a more suitable container implementation
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-_NodeType* AStar<_NodeType, _CostFunc, _Container, _Timer>::FindLowestCost(AStarContainer& pCont)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+_NodeType* AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::FindLowestCost(AStarContainer& pCont)
 {
    if (pCont.empty())
    {
@@ -200,21 +236,28 @@ _NodeType* AStar<_NodeType, _CostFunc, _Container, _Timer>::FindLowestCost(AStar
    else
    {
       node_type* node = pCont.front();
-      std::pop_heap(pCont.begin(), pCont.end(), node_type_gtr_func());
+      node->SetOpenIndex(node_type::NOT_OPEN);
+
+      node_type* last = pCont.back();
       pCont.pop_back();
+      if (!pCont.empty())
+      {
+         pCont[0] = last;
+         SiftDown(pCont, 0);
+      }
       return node;
    }
 }
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-_NodeType* AStar<_NodeType, _CostFunc, _Container, _Timer>::CreateNode(node_type* pParent, data_type datatype, cost_type pGn, cost_type pHn)
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+_NodeType* AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::CreateNode(node_type* pParent, data_type datatype, cost_type pGn, cost_type pHn)
 {
-   return new node_type(pParent, datatype, pGn, pHn);
+   return new (AllocateNode()) node_type(pParent, datatype, pGn, pHn);
 }
 
 
-template<class _NodeType, class _CostFunc, class _Container, class _Timer>
-PathFindResult AStar<_NodeType, _CostFunc, _Container, _Timer>::FindPath()
+template<class _NodeType, class _CostFunc, class _Container, class _Timer, class _HashFcn>
+PathFindResult AStar<_NodeType, _CostFunc, _Container, _Timer, _HashFcn>::FindPath()
 {
    // increment our iteration
    // reset our constraint bookkeeping vars
@@ -231,7 +274,8 @@ PathFindResult AStar<_NodeType, _CostFunc, _Container, _Timer>::FindPath()
          return NO_PATH;
       }
 
-      // start with the node of lowest cost in the open list
+      // start with the node of lowest cost in the open list,
+      // taking it off the open list puts it on the closed list
       node_type* pStart = FindLowestCost(mOpen);
 
       // check if we found a path to the end or if we have exceeded a constraint
@@ -247,9 +291,6 @@ PathFindResult AStar<_NodeType, _CostFunc, _Container, _Timer>::FindPath()
       // if we have exceeded a constraint or found a path to the end return
       if (pHasPathToFinish || pExceededMaxCost || pHasExceededTimeLimit || pAtOrExceedingMaxDepth || (mConfig.mNodesExplored >= mConfig.mMaxNodesExplored))
       {
-         // we simply add it back to the container so it will be deleted later
-         mClosed.insert(pStart->GetData());
-
          // \todo combine partial lists instead of clearing them
          mConfig.mResult.clear();
 
@@ -271,41 +312,36 @@ PathFindResult AStar<_NodeType, _CostFunc, _Container, _Timer>::FindPath()
       {
          ++mConfig.mNodesExplored;
 
-         // add it onto the closed list
-         Insert(mClosed, pStart->GetData());
-
          // we will iterate through the potential places this node can take us
          typename node_type::iterator iter = pStart->begin();
          typename node_type::iterator endOfList = pStart->end();
 
-         // \todo refactor this with a better container type
          while (iter != endOfList)
          {
             data_type pNode = *iter;
-            // if its not in the closed list
-            if (!mConfig.mCheckClosedList || Contains(mClosed, pNode) == mClosed.end())
+
+            typename AStarNodeLookup::iterator found = mNodeLookup.find(pNode);
+            node_type* pExisting = (found != mNodeLookup.end()) ? found->second : NULL;
+
+            if (pExisting != NULL && pExisting->GetOpenIndex() != node_type::NOT_OPEN)
             {
-               // if it isnt in the open list
-               typename AStarContainer::iterator pNodeLinkIter = Contains(mOpen, pNode);
-               if (pNodeLinkIter == mOpen.end())
-               {
-                  // create a new path in the open list
-                  AddNodeLink(pStart, pNode);
-               }
-               else // lets see if we can get there for cheaper
+               // it is in the open list, lets see if we can get there for cheaper
+               cost_type pNewCost = pStart->GetCostToNode() + mCostFunc(pStart->GetData(), pNode);
+
+               // if the new g(n) cost is cheaper then the old one, move the node
+               // onto the new path and up the heap
+               if (pNewCost < pExisting->GetCostToNode())
                {
-                  // compute cost to pNode from pStart
-                  cost_type pNewCost = pStart->GetCostToNode() + mCostFunc(pStart->GetData(), pNode);
-
-                  // if the new g(n) cost is cheaper then the old one delete the old one
-                  // and add the new one as the best potential path to pNode
-                  if (pNewCost < (*pNodeLinkIter)->GetCostToNode())
-                  {
-                     Remove(mOpen, pNodeLinkIter);
-                     AddNodeLink(pStart, pNode);
-                  }
+                  pExisting->SetParent(pStart, pNewCost);
+                  SiftUp(mOpen, pExisting->GetOpenIndex());
                }
             }
+            // if it has never been seen or it is closed, but we aren't checking the closed list
+            else if (pExisting == NULL || !mConfig.mCheckClosedList)
+            {
+               // create a new path in the open list
+               AddNodeLink(pStart, pNode);
+            }
             ++iter;
          }
       }
@@ -314,4 +350,3 @@ PathFindResult AStar<_NodeType, _CostFunc, _Container, _Timer>::FindPath()
 
    return NO_PATH;
 }
-
@@ -56,6 +56,7 @@ namespace dtAI
             , mCostToGoal(pHn)
             , mParent(pParent)
             , mDepth(0)
+            , mOpenIndex(NOT_OPEN)
          {
             if (pParent)
             {
@@ -119,6 +120,27 @@ namespace dtAI
 
          unsigned int GetDepth() const { return mDepth; }
 
+         /**
+          * Moves the node onto a cheaper path from a new parent.  AStar uses this to
+          * update a node that is still in the open list rather than replacing it.
+          */
+         void SetParent(node_type* pParent, cost_type pGn)
+         {
+            mParent = pParent;
+            mCostToNode = pGn;
+            mDepth = pParent ? pParent->GetDepth() + 1 : 0;
+         }
+
+         /// The value of the open index when the node is not in the open list.
+         static const unsigned int NOT_OPEN = 0xFFFFFFFF;
+
+         /**
+          * The position of this node in the AStar open list, or NOT_OPEN.
+          * This is bookkeeping for AStar and should not be changed by anything else.
+          */
+         unsigned int GetOpenIndex() const { return mOpenIndex; }
+         void SetOpenIndex(unsigned int index) { mOpenIndex = index; }
+
       protected:
          AStarNode(const AStarNode& pNode); // not implemented by design
          AStarNode& operator=(const AStarNode& pNode); // not implemented by design
@@ -131,6 +153,8 @@ namespace dtAI
          node_type* mParent;
 
          unsigned int mDepth;
+
+         unsigned int mOpenIndex;
    };
 
 } // namespace dtAI
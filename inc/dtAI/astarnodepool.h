@@ -0,0 +1,104 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef __DELTA_ASTARNODEPOOL_H__
+#define __DELTA_ASTARNODEPOOL_H__
+
+#include <type_traits>
+#include <vector>
+
+namespace dtAI
+{
+   /**
+    * Memory for the nodes AStar creates during a search.  The memory is handed out in order from blocks
+    * that are kept when the pool is cleared, so after the first few searches AStar doesn't allocate
+    * any memory for its nodes.
+    *
+    * @usage Construct the node in the memory from Allocate() with placement new.  Clear() calls the
+    *        destructor of every node constructed in the pool.
+    *
+    * @see AStar.h
+    */
+   template<class _NodeType, unsigned _BlockSize = 1024>
+   class AStarNodePool
+   {
+   public:
+      typedef _NodeType node_type;
+
+      AStarNodePool()
+         : mNumAllocated(0)
+      {
+      }
+
+      ~AStarNodePool()
+      {
+         Clear();
+         for (unsigned i = 0; i < mBlocks.size(); ++i)
+         {
+            delete[] mBlocks[i];
+         }
+      }
+
+      /**
+       * @return memory for one node.  A node must be constructed in it before the pool is cleared.
+       */
+      void* Allocate()
+      {
+         unsigned block = mNumAllocated / _BlockSize;
+         if (block == mBlocks.size())
+         {
+            mBlocks.push_back(new Storage[_BlockSize]);
+         }
+         void* result = &mBlocks[block][mNumAllocated % _BlockSize];
+         ++mNumAllocated;
+         return result;
+      }
+
+      /**
+       * Destroys all of the nodes, but keeps the memory for the next search.
+       */
+      void Clear()
+      {
+         for (unsigned i = 0; i < mNumAllocated; ++i)
+         {
+            reinterpret_cast<node_type*>(&mBlocks[i / _BlockSize][i % _BlockSize])->~node_type();
+         }
+         mNumAllocated = 0;
+      }
+
+      /// @return the number of nodes handed out since the last Clear().
+      unsigned GetNumAllocated() const { return mNumAllocated; }
+
+      /// @return the number of nodes the pool can hand out without allocating.
+      unsigned GetCapacity() const { return unsigned(mBlocks.size()) * _BlockSize; }
+
+   private:
+      AStarNodePool(const AStarNodePool&); // not implemented by design
+      AStarNodePool& operator=(const AStarNodePool&); // not implemented by design
+
+      typedef typename std::aligned_storage<sizeof(node_type), std::alignment_of<node_type>::value>::type Storage;
+
+      std::vector<Storage*> mBlocks;
+      unsigned mNumAllocated;
+   };
+
+} // namespace dtAI
+
+#endif // __DELTA_ASTARNODEPOOL_H__
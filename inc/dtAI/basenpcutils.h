@@ -28,6 +28,7 @@
 #include <dtAI/statevariable.h>
 
 #include <dtUtil/functor.h>
+#include <dtUtil/hash.h>
 
 #include <dtCore/refptr.h>
 
@@ -42,6 +43,30 @@
 
 namespace dtAI
 {
+   /**
+    * Hashes the value of a StateVar.  Anything without an overload here is hashed by
+    * how it prints, so add an overload for types used often in plans.
+    */
+   template<typename _Type>
+   size_t HashStateValue(const _Type& pData)
+   {
+      std::ostringstream ss;
+      ss << pData;
+      return dtUtil::hash<std::string>()(ss.str());
+   }
+
+   template<typename _Type>
+   size_t HashStateValue(_Type* const& pData)
+   {
+      return dtUtil::hash<const _Type*>()(pData);
+   }
+
+   inline size_t HashStateValue(const bool& pData) { return pData ? 1U : 0U; }
+   inline size_t HashStateValue(const int& pData) { return dtUtil::hash<int>()(pData); }
+   inline size_t HashStateValue(const unsigned& pData) { return dtUtil::hash<unsigned>()(pData); }
+   inline size_t HashStateValue(const float& pData) { return dtUtil::hash<float>()(pData); }
+   inline size_t HashStateValue(const double& pData) { return dtUtil::hash<double>()(pData); }
+   inline size_t HashStateValue(const std::string& pData) { return dtUtil::hash<std::string>()(pData); }
 
    /**
     * Templated IStateVariable to make implementing a basic state easier.  Call
@@ -92,6 +117,28 @@ namespace dtAI
          return ss.str();
       }
 
+      virtual size_t GetHash() const
+      {
+         return HashStateValue(mData);
+      }
+
+      virtual bool IsEqual(const IStateVariable& pOther) const
+      {
+         const StateVar<_Type>* pOtherVar = dynamic_cast<const StateVar<_Type>*>(&pOther);
+         return pOtherVar != NULL && pOtherVar->mData == mData;
+      }
+
+      virtual bool Assign(const IStateVariable& pOther)
+      {
+         const StateVar<_Type>* pOtherVar = dynamic_cast<const StateVar<_Type>*>(&pOther);
+         if (pOtherVar == NULL)
+         {
+            return false;
+         }
+         mData = pOtherVar->mData;
+         return true;
+      }
+
    private:
       _Type mData;
    };
@@ -0,0 +1,166 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_HIERARCHICALPATHFINDER_H
+#define DELTA_HIERARCHICALPATHFINDER_H
+
+#include <dtAI/export.h>
+#include <dtAI/pathfinding.h>
+#include <dtAI/primitives.h>
+#include <dtAI/waypointgraph.h>
+#include <dtCore/refptr.h>
+#include <dtUtil/hashmap.h>
+#include <osg/Referenced>
+
+#include <vector>
+
+namespace dtAI
+{
+   /**
+    * Finds paths between concrete waypoints using the search levels of a WaypointGraph, in the style of HPA*.
+    *
+    * The collections at the cluster level divide the waypoints into clusters.  A query first plans a corridor
+    * of collections from the top of the tree down to the cluster level, each level only searching the children
+    * of the level above it.  The concrete path is then found by searching only the portals of the clusters in the
+    * corridor, where a portal is a waypoint with an edge into another cluster.  The paths inside a cluster are
+    * computed the first time they are needed and kept until the cluster changes, so repeated queries through
+    * the same area mostly skip the concrete waypoints.
+    *
+    * The pathfinder listens to the graph and throws away the cached paths of a cluster when one of its waypoints
+    * or edges changes.  Rebuilding the search graph throws away everything.  The graph must have its search graph
+    * created with CreateSearchGraph() to get any benefit, without it every waypoint is its own cluster.
+    *
+    * Because the portal search is confined to the corridor, a path may be slightly longer than the shortest path.
+    * If no path exists within the corridor, the whole graph is searched.
+    */
+   class DT_AI_EXPORT HierarchicalPathfinder : public osg::Referenced, public WaypointGraph::ChangeListener
+   {
+   public:
+      /// The level of the collections used as clusters when none is given.
+      static const unsigned DEFAULT_CLUSTER_LEVEL = 3;
+
+      /**
+       * What the last call to FindPath() did.
+       */
+      struct DT_AI_EXPORT Statistics
+      {
+         Statistics();
+
+         /// @return the nodes expanded by all the parts of the search.
+         unsigned GetTotalNodesExpanded() const;
+
+         /// collections expanded planning the corridor
+         unsigned mAbstractNodesExpanded;
+         /// portals expanded by the search on the concrete level
+         unsigned mPortalNodesExpanded;
+         /// waypoints expanded computing paths inside clusters that were not cached
+         unsigned mClusterNodesExpanded;
+         unsigned mCacheHits;
+         unsigned mCacheMisses;
+         /// true if the path was found inside the corridor
+         bool mUsedCorridor;
+         float mPathCost;
+         double mSearchTimeMs;
+      };
+
+      HierarchicalPathfinder(WaypointGraph& graph, unsigned clusterLevel = DEFAULT_CLUSTER_LEVEL);
+
+      WaypointGraph& GetWaypointGraph() { return *mGraph; }
+      const WaypointGraph& GetWaypointGraph() const { return *mGraph; }
+
+      /**
+       * Finds a path between two concrete waypoints.
+       * @param result filled with the waypoints on the path, starting with from.
+       * @return PATH_FOUND or NO_PATH
+       */
+      PathFindResult FindPath(WaypointID from, WaypointID to, WaypointGraph::ConstWaypointArray& result);
+
+      /**
+       * Sets the search level of the collections used as clusters, from 1 up.  Larger clusters mean fewer
+       * portals to search but more work each time a cluster changes.  This clears the cache.
+       */
+      void SetClusterLevel(unsigned level);
+      unsigned GetClusterLevel() const;
+
+      /// Turns the corridor planning on the upper levels on and off.  It defaults to on.
+      void SetUseCorridor(bool useCorridor);
+      bool GetUseCorridor() const;
+
+      /// Throws away all the cached paths.
+      void ClearCache();
+
+      /// @return the number of waypoints with cached paths to the portals of their cluster.
+      unsigned GetNumCachedPaths() const;
+
+      const Statistics& GetLastStatistics() const;
+
+      /*virtual*/ void OnWaypointChanged(WaypointID id);
+      /*virtual*/ void OnEdgeChanged(WaypointID idFrom, WaypointID idTo);
+      /*virtual*/ void OnSearchGraphChanged();
+
+   protected:
+      virtual ~HierarchicalPathfinder();
+
+   private:
+      HierarchicalPathfinder(const HierarchicalPathfinder&); // not implemented by design
+      HierarchicalPathfinder& operator=(const HierarchicalPathfinder&); // not implemented by design
+
+      struct TreeEntry
+      {
+         float mCost;
+         WaypointID mParent;
+      };
+
+      /// the shortest paths from one waypoint to the others in its cluster
+      typedef dtUtil::HashMap<WaypointID, TreeEntry> ClusterTree;
+
+      struct Cluster
+      {
+         std::vector<WaypointID> mMembers;
+         std::vector<WaypointID> mPortals;
+         dtUtil::HashMap<WaypointID, ClusterTree> mTrees;
+      };
+
+      typedef dtUtil::HashMap<WaypointID, Cluster> ClusterMap;
+      typedef dtUtil::HashMap<WaypointID, bool> IDSet;
+
+      WaypointID GetClusterID(WaypointID id);
+      Cluster& GetCluster(WaypointID clusterID);
+      const ClusterTree& GetTree(WaypointID clusterID, WaypointID source);
+      void InvalidateCluster(WaypointID clusterID);
+
+      bool PlanCorridor(WaypointID from, WaypointID to, IDSet& corridor);
+      bool PlanCollections(WaypointID from, WaypointID to, const IDSet& allowedParents, IDSet& result);
+      PathFindResult SearchPortals(WaypointID from, WaypointID to, const IDSet* corridor, WaypointGraph::ConstWaypointArray& result);
+
+      dtCore::RefPtr<WaypointGraph> mGraph;
+      unsigned mClusterLevel;
+      bool mUseCorridor;
+
+      ClusterMap mClusters;
+      /// the cluster of each waypoint looked up since the last change to its cluster
+      dtUtil::HashMap<WaypointID, WaypointID> mWaypointClusters;
+
+      Statistics mStatistics;
+   };
+
+} // namespace dtAI
+
+#endif // DELTA_HIERARCHICALPATHFINDER_H
@@ -0,0 +1,201 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_PATHQUERYCOMPONENT_H
+#define DELTA_PATHQUERYCOMPONENT_H
+
+#include <dtAI/export.h>
+#include <dtAI/pathfinding.h>
+#include <dtAI/primitives.h>
+#include <dtCore/refptr.h>
+#include <dtCore/timer.h>
+#include <dtGame/gmcomponent.h>
+#include <dtUtil/functor.h>
+
+#include <deque>
+#include <vector>
+
+namespace dtAI
+{
+   class WaypointGraph;
+   class WaypointGraphSnapshot;
+   class PathQueryBatch;
+   class PathQueryTask;
+
+   typedef unsigned PathQueryHandle;
+
+   /**
+    * The constraints on a single path query.  A query that hits a constraint reports PARTIAL_PATH.
+    */
+   struct DT_AI_EXPORT PathQueryConfig
+   {
+      PathQueryConfig();
+
+      unsigned mMaxNodesExplored;
+      float mMaxCost;
+      unsigned mMaxDepth;
+   };
+
+   /**
+    * The answer to a path query, handed to the callback on the tick after the search finished.
+    */
+   struct DT_AI_EXPORT PathQueryResult
+   {
+      PathQueryResult();
+
+      PathQueryHandle mHandle;
+      WaypointID mFrom;
+      WaypointID mTo;
+      PathFindResult mResult;
+      /// The waypoints on the path, or partial path, starting with mFrom.
+      std::vector<WaypointID> mPath;
+      float mCost;
+      unsigned mNodesExplored;
+      /// Milliseconds from the submit until a worker started the search.
+      double mWaitTimeMs;
+      /// Milliseconds the search itself took.
+      double mSearchTimeMs;
+   };
+
+   typedef dtUtil::Functor<void, TYPELIST_1(const PathQueryResult&)> PathQueryCallback;
+
+   /**
+    * Runs path queries on a WaypointGraph in the background.  Callers submit a query and get back a handle,
+    * the queries are searched in parallel on the dtUtil::ThreadPool, and each result is handed to its callback
+    * during a TICK_LOCAL after the search finished, so the callbacks are always called from the game thread.
+    *
+    * The searches run on a WaypointGraphSnapshot, not the graph itself, so the graph may be changed while
+    * queries are running.  Call RefreshSnapshot() after changing the graph for new queries to see the change.
+    * The graph is taken from the AIInterfaceActor when a map is loaded, or it can be set with SetWaypointGraph().
+    *
+    * The queries submitted before a tick are handed to the workers as one batch, and a new batch is not started until
+    * the last has been delivered.  If the ThreadPool has not been initialized, the batch is searched on the game thread.
+    */
+   class DT_AI_EXPORT PathQueryComponent : public dtGame::GMComponent
+   {
+   public:
+      static const dtCore::RefPtr<dtCore::SystemComponentType> TYPE;
+      static const std::string DEFAULT_NAME;
+
+      /// A handle that is never returned by SubmitQuery.
+      static const PathQueryHandle INVALID_HANDLE;
+
+      PathQueryComponent(dtCore::SystemComponentType& type = *TYPE);
+
+      /*virtual*/ void ProcessMessage(const dtGame::Message& message);
+
+      /*virtual*/ void OnRemovedFromGM();
+
+      /**
+       * Sets the graph to search and builds a snapshot of it.  Pass NULL to stop searching.
+       * Queries that are already running finish on the old snapshot.
+       */
+      void SetWaypointGraph(const WaypointGraph* graph);
+      const WaypointGraph* GetWaypointGraph() const;
+
+      /// Builds a new snapshot of the current graph for the queries started after this.
+      void RefreshSnapshot();
+
+      const WaypointGraphSnapshot* GetSnapshot() const;
+
+      /**
+       * Queues a path query.
+       * @param callback called with the result on the game thread. It may be an empty functor if the
+       *                 result isn't needed.
+       * @return the handle of the query.
+       */
+      PathQueryHandle SubmitQuery(WaypointID from, WaypointID to, PathQueryCallback callback,
+               const PathQueryConfig& config = PathQueryConfig());
+
+      /**
+       * Stops the callback of a query from being called.  A query that is already running still
+       * finishes, but its result is thrown away.
+       * @return true if the query was still pending.
+       */
+      bool CancelQuery(PathQueryHandle handle);
+
+      /// @return true if the query was submitted and its result has not been delivered or canceled.
+      bool IsQueryPending(PathQueryHandle handle) const;
+
+      /// @return the number of queries waiting for a batch to start.
+      unsigned GetQueueDepth() const;
+
+      /// @return the number of queries in the running batch, including those already searched but not delivered.
+      unsigned GetNumQueriesInFlight() const;
+
+      /**
+       * Sets the most tasks a batch is split into, 0 uses one per ThreadPool thread that runs background tasks.
+       */
+      void SetMaxWorkers(unsigned maxWorkers);
+      unsigned GetMaxWorkers() const;
+
+      /// Blocks until the running batch, if any, has been searched.  The results are still delivered on the next tick.
+      void WaitForQueries();
+
+      /// @return the number of results delivered since the last ResetStatistics().
+      unsigned GetNumQueriesCompleted() const;
+      /// @return the average search time, in milliseconds, of the delivered results.
+      double GetAverageSearchTimeMs() const;
+      /// @return the longest search time, in milliseconds, of the delivered results.
+      double GetMaxSearchTimeMs() const;
+      /// @return the average time, in milliseconds, from submit until the callback was called.
+      double GetAverageLatencyMs() const;
+      void ResetStatistics();
+
+   protected:
+      virtual ~PathQueryComponent();
+
+   private:
+      struct PendingQuery
+      {
+         PathQueryHandle mHandle;
+         WaypointID mFrom;
+         WaypointID mTo;
+         PathQueryConfig mConfig;
+         PathQueryCallback mCallback;
+         dtCore::Timer_t mSubmitTime;
+      };
+
+      void TickLocal();
+      void DeliverResults();
+      void StartBatch();
+      void CleanUp();
+
+      dtCore::RefPtr<const WaypointGraph> mWaypointGraph;
+      dtCore::RefPtr<const WaypointGraphSnapshot> mSnapshot;
+
+      PathQueryHandle mNextHandle;
+      std::deque<PendingQuery> mQueue;
+      std::vector<PendingQuery> mInFlight;
+      std::vector<PathQueryHandle> mCanceled;
+
+      dtCore::RefPtr<PathQueryBatch> mBatch;
+      std::vector<dtCore::RefPtr<PathQueryTask> > mTasks;
+      unsigned mMaxWorkers;
+
+      unsigned mNumCompleted;
+      double mTotalSearchTimeMs;
+      double mMaxSearchTimeMs;
+      double mTotalLatencyMs;
+   };
+
+} // namespace dtAI
+
+#endif // DELTA_PATHQUERYCOMPONENT_H
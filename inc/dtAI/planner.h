@@ -28,6 +28,8 @@
 #include <dtAI/plannerconfig.h>
 #include <dtAI/worldstate.h>
 
+#include <dtUtil/hashmap.h>
+
 #include <list>
 #include <vector>
 
@@ -35,13 +37,16 @@ namespace dtAI
 {
    /**
     * A game oriented Planner modeled after Jeff Orkin's F.E.A.R Planner
+    *
+    * The search is A* over world states.  The open list is a binary heap, the states already
+    * expanded are kept in a hashed closed set so each is only searched once, and the nodes and their
+    * world states are pooled, so planning again with a state of the same schema doesn't allocate.
     */
    class DT_AI_EXPORT Planner
    {
    public:
       enum PlannerResult{NO_PLAN, PLAN_FOUND, PARTIAL_PLAN};
 
-      typedef std::list<const PlannerNodeLink*> PlannerContainer;
       typedef std::list<const Operator*> OperatorList;
       typedef std::vector<const Operator*> OperatorVector;
 
@@ -61,18 +66,76 @@ namespace dtAI
 
       OperatorVector GetPlanAsVector() const;
 
+      /// @return the number of nodes expanded since the last reset.
+      unsigned GetNumNodesExpanded() const { return mNumNodesExpanded; }
+
+      /// @return the number of nodes allocated, used or not.  They are kept for the next plan.
+      unsigned GetNumPooledNodes() const { return unsigned(mNodePool.size()); }
+
+      /// Deletes the pooled nodes that are not in use.
+      void TrimNodePool();
+
    private:
+      Planner(const Planner&);            // not implemented by design
+      Planner& operator=(const Planner&); // not implemented by design
+
+      struct PlannerNode
+      {
+         PlannerNodeLink mLink;
+         WorldState mState;
+         size_t mHash;
+         /// The order the node was opened in, so nodes of equal cost are searched first come first served.
+         unsigned mOrder;
+      };
+
+      /// Orders the open heap so the node with the lowest cost is on top.
+      struct PlannerNodeCompare
+      {
+         bool operator()(const PlannerNode* pLeft, const PlannerNode* pRight) const
+         {
+            float leftCost = pLeft->mLink.mGCost + pLeft->mLink.mHCost;
+            float rightCost = pRight->mLink.mGCost + pRight->mLink.mHCost;
+            if (leftCost != rightCost)
+            {
+               return leftCost > rightCost;
+            }
+            return pLeft->mOrder > pRight->mOrder;
+         }
+      };
+
+      struct StateHashFunc
+      {
+         size_t operator()(size_t pHash) const { return pHash; }
+      };
+
+      typedef std::vector<PlannerNode*> PlannerContainer;
+      typedef dtUtil::HashMultiMap<size_t, const PlannerNode*, StateHashFunc> ClosedSet;
+
       void FreeMem();
+      void OpenRootNode();
+
+      /// @return a node from the pool.  The state is left as it was, assign it.
+      PlannerNode* AllocateNode();
+      /// Returns the last allocated node to the pool.
+      void ReleaseLastNode();
+
+      void PushOpen(PlannerNode* pNode);
+      PlannerNode* PopOpen();
+
+      bool IsClosed(const PlannerNode* pNode) const;
 
-      const PlannerNodeLink* FindLowestCost();
-      void Remove(const PlannerNodeLink* pNodeLink);
-      bool Contains(PlannerNodeLink* pNodeLink);
       bool CanApplyOperator(const Operator* pOperator, const WorldState* pState);
-      void GetTraversableStates(const WorldState* pCurrentState, const std::list<Operator*>& pOperators, std::list<Operator*>& pOperatorListIn);
 
       const PlannerHelper* mHelper;
       PlannerConfig mConfig;
       PlannerContainer mOpen;
+      ClosedSet mClosed;
+
+      /// Every node ever allocated.  The first mNumNodesUsed are in the current search.
+      std::vector<PlannerNode*> mNodePool;
+      unsigned mNumNodesUsed;
+      unsigned mNumNodesOpened;
+      unsigned mNumNodesExpanded;
    };
 
 } // namespace dtAI
@@ -23,6 +23,7 @@
 #define __DELTA_STATEVARIABLE_H__
 
 #include <dtAI/export.h>
+#include <dtUtil/hash.h>
 #include <string>
 
 namespace dtAI
@@ -39,6 +40,34 @@ namespace dtAI
 
       virtual const std::string ToString() const = 0;
 
+      /**
+       * @return a hash of the value.  Variables that are equal must have the same hash.
+       * The default hashes ToString(), override it for something cheaper.
+       */
+      virtual size_t GetHash() const
+      {
+         return dtUtil::hash<std::string>()(ToString());
+      }
+
+      /**
+       * @return true if the other variable has the same value.  The planner uses this to find the
+       * world states it has already searched.  The default compares ToString().
+       */
+      virtual bool IsEqual(const IStateVariable& pOther) const
+      {
+         return ToString() == pOther.ToString();
+      }
+
+      /**
+       * Sets this variable to the value of the other one in place, so a world state can be copied
+       * without allocating.
+       * @return false if the other variable can't be assigned, so it has to be copied.  The default.
+       */
+      virtual bool Assign(const IStateVariable& /*pOther*/)
+      {
+         return false;
+      }
+
    private:
    };
 
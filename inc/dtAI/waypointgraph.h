@@ -67,6 +67,25 @@ namespace dtAI
 
       typedef std::vector< dtCore::RefPtr<SearchLevel> > SearchLevelArray;
 
+      /**
+       * Implement this to be told when the graph changes, for example to throw away cached paths.
+       * Listeners are not owned by the graph and must remove themselves before they are deleted.
+       */
+      class DT_AI_EXPORT ChangeListener
+      {
+      public:
+         virtual ~ChangeListener() {}
+
+         /// A concrete waypoint was inserted, moved by being re-inserted, or is about to be removed.
+         virtual void OnWaypointChanged(WaypointID id) = 0;
+
+         /// An edge between two concrete waypoints was added or removed.
+         virtual void OnEdgeChanged(WaypointID idFrom, WaypointID idTo) = 0;
+
+         /// The collections or search levels above the concrete waypoints changed, or the graph was cleared.
+         virtual void OnSearchGraphChanged() = 0;
+      };
+
    public:
       WaypointGraph();
 
@@ -230,6 +249,9 @@ namespace dtAI
       // clears all memory, does a lot of deleting!
       void Clear();
 
+      void AddChangeListener(ChangeListener& listener);
+      void RemoveChangeListener(ChangeListener& listener);
+
       /**
        * These are here just for debugging purposes
        */
@@ -250,6 +272,10 @@ namespace dtAI
       virtual void RemoveAllEdgesFromWaypoint_Protected(const WaypointInterface* pFrom);
       virtual void GetAllEdgesFromWaypoint_Protected(const WaypointInterface& pFrom, ConstWaypointArray& result) const;
 
+      void NotifyWaypointChanged(WaypointID id);
+      void NotifyEdgeChanged(WaypointID idFrom, WaypointID idTo);
+      void NotifySearchGraphChanged();
+
    private:
       WaypointGraphImpl* mImpl;
    };
@@ -0,0 +1,178 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_WAYPOINTGRAPHSNAPSHOT_H
+#define DELTA_WAYPOINTGRAPHSNAPSHOT_H
+
+#include <dtAI/export.h>
+#include <dtAI/astar.h>
+#include <dtAI/astarcostfunc.h>
+#include <dtAI/astarnode.h>
+#include <dtAI/astarwaypointutils.h>
+#include <dtAI/primitives.h>
+#include <dtUtil/hashmap.h>
+#include <osg/Referenced>
+#include <osg/Vec3>
+
+#include <list>
+#include <vector>
+
+namespace dtAI
+{
+   class WaypointGraph;
+
+   /**
+    * A read only copy of the bottom search level of a WaypointGraph.  The waypoints are numbered
+    * from zero and the edges are packed into one array, so a search needs neither the graph nor a lock.
+    * A snapshot never changes after it is built, so any number of threads may search it at once.
+    * Changes to the graph are not seen until a new snapshot is built.
+    */
+   class DT_AI_EXPORT WaypointGraphSnapshot : public osg::Referenced
+   {
+   public:
+      /// The index returned for a waypoint that is not in the snapshot.
+      static const unsigned INVALID_INDEX = 0xFFFFFFFF;
+
+      WaypointGraphSnapshot(const WaypointGraph& graph);
+
+      unsigned GetNumWaypoints() const { return unsigned(mIDs.size()); }
+      unsigned GetNumEdges() const { return unsigned(mEdges.size()); }
+
+      /// @return the index of the waypoint in this snapshot, or INVALID_INDEX.
+      unsigned FindIndex(WaypointID id) const;
+
+      WaypointID GetWaypointID(unsigned index) const { return mIDs[index]; }
+      const osg::Vec3& GetPosition(unsigned index) const { return mPositions[index]; }
+
+      /// @return the indices of the waypoints the waypoint at index has an edge to.
+      const unsigned* GetEdgesBegin(unsigned index) const { return mEdges.empty() ? NULL : &mEdges[0] + mEdgeOffsets[index]; }
+      const unsigned* GetEdgesEnd(unsigned index) const { return mEdges.empty() ? NULL : &mEdges[0] + mEdgeOffsets[index + 1]; }
+
+   protected:
+      virtual ~WaypointGraphSnapshot();
+
+   private:
+      WaypointGraphSnapshot(const WaypointGraphSnapshot&); // not implemented by design
+      WaypointGraphSnapshot& operator=(const WaypointGraphSnapshot&); // not implemented by design
+
+      std::vector<WaypointID> mIDs;
+      std::vector<osg::Vec3> mPositions;
+      /// the edges of waypoint i are mEdges[mEdgeOffsets[i]] up to mEdges[mEdgeOffsets[i + 1]]
+      std::vector<unsigned> mEdgeOffsets;
+      std::vector<unsigned> mEdges;
+      dtUtil::HashMap<WaypointID, unsigned> mIndices;
+   };
+
+
+   /**
+    * The AStar node for searching a WaypointGraphSnapshot, the data type is the index of the waypoint.
+    */
+   class WaypointSnapshotNode: public AStarNode<WaypointSnapshotNode, unsigned, const unsigned*, float>
+   {
+   public:
+      WaypointSnapshotNode(const WaypointGraphSnapshot& snapshot, node_type* pParent, unsigned index, cost_type pGn, cost_type pHn)
+         : BaseType(pParent, index, pGn, pHn)
+         , mBegin(snapshot.GetEdgesBegin(index))
+         , mEnd(snapshot.GetEdgesEnd(index))
+      {
+      }
+
+      // we need this one just to compile, the snapshot astar always supplies the snapshot
+      WaypointSnapshotNode(node_type* pParent, unsigned index, cost_type pGn, cost_type pHn)
+         : BaseType(pParent, index, pGn, pHn)
+         , mBegin(NULL)
+         , mEnd(NULL)
+      {
+      }
+
+      /*virtual*/ iterator begin() const
+      {
+         return mBegin;
+      }
+
+      /*virtual*/ iterator end() const
+      {
+         return mEnd;
+      }
+
+   private:
+      const unsigned* mBegin;
+      const unsigned* mEnd;
+   };
+
+
+   /**
+    * The straight line distance between two waypoints in a snapshot.
+    */
+   class WaypointSnapshotCostFunc: public AStarCostFunc<unsigned, float>
+   {
+   public:
+      WaypointSnapshotCostFunc()
+         : mSnapshot(NULL)
+      {
+      }
+
+      void SetSnapshot(const WaypointGraphSnapshot* snapshot) { mSnapshot = snapshot; }
+
+      float operator()(unsigned pFrom, unsigned pTo) const
+      {
+         return (mSnapshot->GetPosition(pFrom) - mSnapshot->GetPosition(pTo)).length();
+      }
+
+   private:
+      const WaypointGraphSnapshot* mSnapshot;
+   };
+
+
+   typedef AStar<WaypointSnapshotNode, WaypointSnapshotCostFunc, std::list<unsigned>, AStarTimer> WaypointSnapshotAStarBase;
+
+
+   /**
+    * Finds single level paths on a WaypointGraphSnapshot.  Each thread searching a snapshot
+    * needs its own one of these, but it may be kept and reused for any number of searches.
+    */
+   class DT_AI_EXPORT WaypointSnapshotAStar: public WaypointSnapshotAStarBase
+   {
+   public:
+      typedef WaypointSnapshotAStarBase::CreateNodeFunctor WaypointSnapshotAStarCreateFunctor;
+
+      WaypointSnapshotAStar();
+      virtual ~WaypointSnapshotAStar();
+
+      /// Sets the snapshot to search, which must outlive the searches.
+      void SetSnapshot(const WaypointGraphSnapshot* snapshot);
+      const WaypointGraphSnapshot* GetSnapshot() const { return mSnapshot; }
+
+      /**
+       * Finds a path between two waypoints using the constraints on the config.
+       * @param result filled with the ids of the waypoints on the path, or partial path, starting with from.
+       * @return NO_PATH if either waypoint is not in the snapshot or they are not connected.
+       */
+      PathFindResult FindSingleLevelPath(WaypointID from, WaypointID to, std::vector<WaypointID>& result);
+
+      WaypointSnapshotNode* CreateNode(WaypointSnapshotNode* pParent, unsigned index, float pGn, float pHn);
+
+   private:
+      const WaypointGraphSnapshot* mSnapshot;
+   };
+
+} // namespace dtAI
+
+#endif // DELTA_WAYPOINTGRAPHSNAPSHOT_H
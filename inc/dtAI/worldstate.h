@@ -25,32 +25,93 @@
 #include <dtAI/export.h>
 #include <dtAI/statevariable.h>
 
+#include <dtCore/refptr.h>
+#include <dtUtil/hashmap.h>
+
+#include <osg/Referenced>
+
 #include <map>
 #include <string>
 #include <ostream>
+#include <vector>
 
 namespace dtAI
 {
    /**
+    * The names of the variables in a WorldState, each given a fixed slot.  World states copied
+    * from each other share one schema, so the variables are an array indexed by the slot rather
+    * than a map searched by name, and two states can be compared and hashed slot by slot.
     *
+    * Register every variable up front, then construct the world states with the schema.
+    */
+   class DT_AI_EXPORT WorldStateSchema : public osg::Referenced
+   {
+   public:
+      static const unsigned INVALID_SLOT = ~0U;
+
+      WorldStateSchema();
+      WorldStateSchema(const WorldStateSchema& pSchema);
+
+      /// @return the slot of the variable, adding it if it's new.
+      unsigned AddVariable(const std::string& pName);
+
+      /// @return the slot of the variable or INVALID_SLOT.
+      unsigned GetSlot(const std::string& pName) const;
+
+      const std::string& GetName(unsigned pSlot) const { return mNames[pSlot]; }
+
+      /// @return the hash of the name of the variable in the slot.
+      size_t GetNameHash(unsigned pSlot) const { return mNameHashes[pSlot]; }
+
+      unsigned GetNumSlots() const { return unsigned(mNames.size()); }
+
+   protected:
+      virtual ~WorldStateSchema();
+
+   private:
+      WorldStateSchema& operator=(const WorldStateSchema&); // not implemented by design
+
+      std::vector<std::string> mNames;
+      std::vector<size_t> mNameHashes;
+      dtUtil::HashMap<std::string, unsigned> mSlots;
+   };
+
+   /**
+    * A set of named state variables.  The variables live in the slots of a WorldStateSchema.
     */
    class DT_AI_EXPORT WorldState
    {
    public:
       typedef std::pair<std::string, IStateVariable*> StringStateMapping;
       typedef std::map<std::string, IStateVariable*> StateVarMapping;
+      typedef std::vector<IStateVariable*> StateVarSlots;
 
    public:
       WorldState();
+      /// Creates a world state with an empty slot for each variable in the schema.
+      explicit WorldState(WorldStateSchema& pSchema);
       WorldState(const WorldState& pWS);
 
+      /**
+       * Copies the cost and the variables.  If both states have the same schema and the variables
+       * support IStateVariable::Assign, nothing is allocated.
+       */
       WorldState& operator=(const WorldState& pWS);
 
+      /// @return true if both states have equal variables with the same names.  The cost is ignored.
+      bool operator==(const WorldState& pWS) const;
+      bool operator!=(const WorldState& pWS) const { return !(*this == pWS); }
+
       virtual ~WorldState();
 
       float GetCost() const;
       void AddCost(float pCost);
 
+      /**
+       * Adds the variable, which this world state will own.  Nothing is added if there is already a variable
+       * with the name.  A name not in the schema is added to it, but if the schema is shared, this state
+       * gets a copy of it first so the other states are not changed.
+       */
       void AddState(const std::string& pName, IStateVariable* pStateVar);
       IStateVariable* GetState(const std::string& pState);
 
@@ -68,14 +129,35 @@ namespace dtAI
          pStateVar = dynamic_cast<const T*>(GetState(pState));
       }
 
-      const StateVarMapping& GetStateVariables() const { return mStateVariables; }
-      StateVarMapping& GetStateVariables() { return mStateVariables; }
+      /// @return the variable in the slot of the schema, or NULL.
+      IStateVariable* GetStateInSlot(unsigned pSlot)
+      {
+         return pSlot < mStateVariables.size() ? mStateVariables[pSlot] : NULL;
+      }
+
+      const IStateVariable* GetStateInSlot(unsigned pSlot) const
+      {
+         return pSlot < mStateVariables.size() ? mStateVariables[pSlot] : NULL;
+      }
+
+      /// @return the schema, or NULL if no variable has been added.
+      const WorldStateSchema* GetSchema() const { return mSchema.get(); }
+
+      /// @return a hash of the variables, which is equal for states that are ==.
+      size_t GetHash() const;
+
+      const StateVarSlots& GetStateVariables() const { return mStateVariables; }
+
+      /// Fills the map with the variables by name.  The variables are still owned by this state.
+      void GetStateVariables(StateVarMapping& pMapping) const;
 
    private:
       void FreeMem();
+      void CopyStateVariables(const WorldState& pWS);
 
       float mCost;
-      StateVarMapping mStateVariables;
+      dtCore::RefPtr<WorldStateSchema> mSchema;
+      StateVarSlots mStateVariables;
    };
 
    DT_AI_EXPORT std::ostream& operator << (std::ostream &o, const WorldState &worldState);
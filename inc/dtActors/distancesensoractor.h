@@ -118,6 +118,13 @@ namespace dtActors
          void SetTriggerDistance(float distance);
          float GetTriggerDistance() const;
 
+         /**
+          * Fills the Transformables in the scene within the trigger distance of this sensor, found through the
+          * spatial index of the scene rather than a sensor per candidate.  The sensor itself isn't included.
+          * The vector is not cleared first.
+          */
+         void FindTransformablesInRange(std::vector<dtCore::Transformable*>& toFill);
+
          ///Overridden to handle evaluating callbacks.
          virtual void OnTickLocal(const dtGame::TickMessage& tickMessage);
 
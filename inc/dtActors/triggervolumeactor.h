@@ -26,6 +26,7 @@
 #include <dtGame/gameactor.h>
 #include <dtCore/observerptr.h>
 #include <dtCore/functor.h>
+#include <dtCore/spatialindex.h>
 
 #include <osg/NodeVisitor>
 
@@ -33,6 +34,11 @@ namespace dtActors
 {
    class TriggerVolumeActorProxy;
 
+   /**
+    * A volume that tells its listeners when a Transformable enters or leaves it.  The volume is a sphere or a box
+    * centered on the actor.  It's found through the spatial index of the Scene, so the occupants are updated once a
+    * frame on the frame synch, and the events come after all the volumes in the scene have been updated.
+    */
    class DT_PLUGIN_EXPORT TriggerVolumeActor : public dtGame::GameActor
    {
       DECLARE_MANAGEMENT_LAYER(TriggerVolumeActor)
@@ -51,6 +57,18 @@ namespace dtActors
       void SetMaxTriggerCount(int maxTriggercount) { mMaxTriggerCount = maxTriggercount; }
       int GetMaxTriggerCount() const               { return mMaxTriggerCount; }
 
+      /// Sets whether the volume is a box rather than a sphere.  It's a sphere by default.
+      void SetVolumeIsBox(bool isBox);
+      bool GetVolumeIsBox() const;
+
+      /// Sets the radius of the volume when it's a sphere.
+      void SetVolumeRadius(float radius);
+      float GetVolumeRadius() const;
+
+      /// Sets the half size of the volume on each axis when it's a box.
+      void SetVolumeHalfExtents(const osg::Vec3& halfExtents);
+      osg::Vec3 GetVolumeHalfExtents() const;
+
       virtual void OnSystem(const dtUtil::RefString& str, double, double)
 ;
 
@@ -66,7 +84,8 @@ namespace dtActors
       * Registers a listener for trigger events caused by this volume.
       *
       * @param[in]  receiver       The receiver of the events.
-      * @param[in]  eventCallback  The event callback functor to call.
+      * @param[in]  eventCallback  The event callback functor to call.  An occupant that is deleted
+      *                            leaves with a NULL instigator.
       *
       * @param[in]  Returns false if the receiver was already registered.
       */
@@ -91,6 +110,9 @@ namespace dtActors
       */
       bool IsActorInVolume(dtCore::Transformable* actor);
 
+      /// @return the volume in the spatial index of the scene.
+      const dtCore::SpatialVolume& GetVolume() const;
+
 
       /**
        *	Retrieves the occupancy list.
@@ -99,7 +121,10 @@ namespace dtActors
 
    protected:
 
-      virtual ~TriggerVolumeActor() {}
+      virtual ~TriggerVolumeActor();
+
+      /// Passes the enter and leave events of the spatial index to the trigger.
+      class Volume;
 
       struct RegisterData
       {
@@ -116,8 +141,19 @@ namespace dtActors
       int mMaxTriggerCount;
       int mTriggerCount;
 
+      bool mVolumeIsBox;
+      float mVolumeRadius;
+      osg::Vec3 mVolumeHalfExtents;
+      dtCore::RefPtr<dtCore::SpatialVolume> mVolume;
+
       bool IsActorAnOccupant(dtCore::Transformable* actor);
 
+      /// @return true once the trigger has fired the maximum number of times.
+      bool IsExpired() const;
+
+      /// Sets the shape of the volume from the properties.
+      void UpdateVolumeShape();
+
       void TriggerEvent(dtCore::Transformable* instigator, TriggerEventType eventType);
    };
 }
@@ -29,6 +29,9 @@ namespace dtActors
    public:
       static const dtUtil::RefString CLASS_NAME;
       static const dtUtil::RefString PROPERTY_MAX_TRIGGER_COUNT;
+      static const dtUtil::RefString PROPERTY_VOLUME_IS_BOX;
+      static const dtUtil::RefString PROPERTY_VOLUME_RADIUS;
+      static const dtUtil::RefString PROPERTY_VOLUME_HALF_EXTENTS;
 
       TriggerVolumeActorProxy();
 
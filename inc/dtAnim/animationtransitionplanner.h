@@ -243,6 +243,10 @@ namespace dtAnim
 
       /*override*/ const std::string ToString() const;
 
+      /*override*/ size_t GetHash() const;
+      /*override*/ bool IsEqual(const dtAI::IStateVariable& pOther) const;
+      /*override*/ bool Assign(const dtAI::IStateVariable& pOther);
+
    private:
       BasicStanceEnum* mStance;
    };
@@ -266,6 +270,10 @@ namespace dtAnim
 
       virtual const std::string ToString() const;
 
+      /*override*/ size_t GetHash() const;
+      /*override*/ bool IsEqual(const dtAI::IStateVariable& pOther) const;
+      /*override*/ bool Assign(const dtAI::IStateVariable& pOther);
+
    private:
       WeaponStateEnum* mWeaponStateEnum;
    };
@@ -27,6 +27,7 @@
 #include <dtCore/refptr.h>
 #include <dtUtil/librarysharingmanager.h>
 #include <osg/Referenced>
+#include <OpenThreads/ReentrantMutex>
 #include <dtCore/actorpluginregistry.h>
 #include <dtCore/export.h>
 
@@ -40,6 +41,8 @@ namespace dtCore
     * that each library can create.  It is also the main vehicle for
     * creating a new BaseActorObject.
     * @note The ActorFactory follows the Singleton design pattern.
+    * @note Loading, unloading and looking up registries and actor types is thread safe, so maps may be parsed on
+    *       a background thread while the main thread keeps creating actors.
     * @see ActorType
     * @see BaseActorObject
     * @see ActorPluginRegistry
@@ -261,6 +264,9 @@ namespace dtCore
          RegistryMap mRegistries;
 
          dtUtil::Log* mLogger;
+
+         /// Guards the registries and the caches.  Loading a library can register it from the same thread.
+         mutable OpenThreads::ReentrantMutex mMutex;
    };
 
    template<typename RegistryClass>
@@ -285,7 +285,14 @@ namespace dtCore
          /**
           * Sets the id of a datatype
           */
-         void SetTypeId(unsigned char newId) { mId = newId; }
+         void SetTypeId(unsigned char newId);
+
+         /**
+          * Looks up a datatype by its id with a table lookup rather than searching the enumeration.
+          * This is used when reading parameters from a data stream.
+          * @return the datatype with the given id or NULL if no datatype has that id.
+          */
+         static DataType* GetValueForId(unsigned char id);
 
       protected:
          virtual int Compare(const std::string& nameString) const;
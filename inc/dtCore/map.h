@@ -51,6 +51,9 @@ namespace dtCore
       public:
          static const std::string MAP_FILE_EXTENSION;
          static const std::string PREFAB_FILE_EXTENSION;
+         /// The extensions of maps and prefabs saved in the binary format.  @see MapBinaryWriter
+         static const std::string MAP_BINARY_FILE_EXTENSION;
+         static const std::string PREFAB_BINARY_FILE_EXTENSION;
 
          enum PlaceableFilter 
          {
@@ -422,6 +425,12 @@ namespace dtCore
           */
          static bool WildMatch(const std::string& sWild, const std::string& sString);
 
+         /**
+          * @return true if the file name has one of the binary map or prefab extensions.  The backup and
+          *         saving suffixes the project adds are looked through.
+          */
+         static bool IsBinaryFileName(const std::string& fileName);
+
          /**
           * Returns the environment actor of this map or NULL if no environment is set
           * @return A pointer to the environment actor or NULL
@@ -528,7 +537,8 @@ namespace dtCore
 
          /**
           * Assigns the file name this map should be saved to. It should not have
-          * an extension.
+          * an extension.  If it doesn't, the extension of the format the map is in now is added, so a
+          * binary map stays binary.
           * @param newFileName the new file name.
           */
          void SetFileName(const std::string& newFileName);
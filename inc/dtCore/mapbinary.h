@@ -0,0 +1,225 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_MAPBINARY
+#define DELTA_MAPBINARY
+
+#include <dtCore/export.h>
+#include <dtCore/map.h>
+#include <dtCore/refptr.h>
+#include <dtCore/uniqueid.h>
+#include <dtUtil/hashmap.h>
+
+#include <osg/Referenced>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace dtUtil
+{
+   class DataStream;
+   class Log;
+}
+
+namespace dtCore
+{
+   class ActorProperty;
+   class ActorActorProperty;
+   class BaseActorObject;
+   class NamedParameter;
+   class PropertyContainer;
+
+   /**
+    * The binary map and prefab format.  It holds the same data as the XML format so a map can be converted
+    * either way without loss.  All the values are written little endian through dtUtil::DataStream:
+    *
+    *   - "DTMB", the format version and a flags byte.
+    *   - The size of the header, then the header strings, so the header can be read without the rest of the file.
+    *   - A table of every other string in the file.  Type names, actor names, property names and string values
+    *     are written as their index in the table, so each distinct string is stored once.
+    *   - The libraries, events, environment actor, actors, groups and preset cameras.
+    *
+    * Each actor and each property value is prefixed by its size, so an actor of a missing type or a property
+    * that no longer exists is skipped without understanding it.  Numbers, vectors, ids and resources are
+    * written typed, strings and enumerations through the string table, and the rest as ActorProperty::ToDataStream.
+    *
+    * @note nothing in these classes is considered part of the public api.  Load and save maps through the Project,
+    *       which picks the format by the extension of the map file name.
+    */
+   class DT_CORE_EXPORT MapBinaryParser : public osg::Referenced
+   {
+   public:
+      MapBinaryParser();
+
+      /**
+       * Completely parses a binary map file.  Be sure to store a dtCore::RefPtr to the map immediately.
+       * @param path The file path to the map.
+       * @param map Set to the loaded map.
+       * @param prefab true to load the file as a prefab, which gives the actors new ids.
+       * @return true if the map was loaded.
+       * @throws MapParsingException if the file can't be read or isn't a valid binary map.
+       */
+      bool Parse(const std::string& path, Map** map, bool prefab = false);
+
+      /// Parses a binary map from the read position of the stream. @see #Parse
+      bool Parse(dtUtil::DataStream& stream, Map** map, bool prefab = false);
+
+      /**
+       * Reads only the header data of a binary map file.  Only the start of the file is read.
+       * @throws MapParsingException if the file can't be read or isn't a valid binary map.
+       */
+      MapPtr ParseMapHeaderData(const std::string& path, bool prefab = false) const;
+      MapPtr ParseMapHeaderData(dtUtil::DataStream& stream, bool prefab = false) const;
+
+      /**
+       * Sets whether Parse maps the file into memory rather than reading it into a buffer.  It's on by default.
+       * The file isn't copied at all then, but it stays open while it's parsed.
+       */
+      void SetUseMemoryMapping(bool useMemoryMapping);
+      bool GetUseMemoryMapping() const;
+
+      /// @return true if the file starts like a binary map, whatever its extension.
+      static bool IsBinaryMapFile(const std::string& path);
+
+      bool IsParsing() const;
+
+      /// @return the map being loaded, or NULL if not parsing.
+      Map* GetMapBeingParsed();
+      const Map* GetMapBeingParsed() const;
+
+      const std::set<std::string>& GetMissingActorTypes();
+      const std::vector<std::string>& GetMissingLibraries();
+
+      bool HasDeprecatedProperty() const;
+
+   protected:
+      virtual ~MapBinaryParser();
+
+   private:
+      MapBinaryParser(const MapBinaryParser&); // not implemented by design
+      MapBinaryParser& operator=(const MapBinaryParser&); // not implemented by design
+
+      /// Reads the start of the file and the header into a new map.  @return the flags byte.
+      unsigned char ParseHeader(dtUtil::DataStream& stream, Map& map, bool prefab) const;
+
+      void ParseStringTable(dtUtil::DataStream& stream);
+      const std::string& ReadTableString(dtUtil::DataStream& stream) const;
+
+      void ParseLibraries(dtUtil::DataStream& stream);
+      void ParseEvents(dtUtil::DataStream& stream);
+
+      /**
+       * Reads an actor record and the components in it.
+       * @param container the actor the record is a component of, or NULL for an actor in the map.
+       */
+      void ParseActor(dtUtil::DataStream& stream, BaseActorObject* container, bool prefab);
+      void ParseProperties(dtUtil::DataStream& stream, PropertyContainer& propContainer);
+      void ParsePropertyValue(dtUtil::DataStream& stream, PropertyContainer& propContainer, ActorProperty& property,
+               unsigned char encoding, unsigned char dataTypeId);
+
+      void ParseGroups(dtUtil::DataStream& stream);
+      void ParsePresetCameras(dtUtil::DataStream& stream);
+
+      /// Sets the actor properties and group properties that were held back until every actor was loaded.
+      void LinkActors();
+      void SetEnvironmentActor(const dtCore::UniqueId& envActorId);
+
+      /// @return the actor loaded with the id in the file, which is not its id in a prefab.
+      BaseActorObject* FindActorByFileId(const dtCore::UniqueId& id) const;
+
+      void Reset();
+
+      struct ActorLink
+      {
+         dtCore::RefPtr<ActorActorProperty> mProperty;
+         dtCore::UniqueId mValue;
+      };
+
+      struct GroupValue
+      {
+         dtCore::RefPtr<ActorProperty> mProperty;
+         dtCore::RefPtr<NamedParameter> mValue;
+      };
+
+      dtUtil::Log* mLogger;
+      bool mUseMemoryMapping;
+      bool mIsParsing;
+      bool mHasDeprecatedProperty;
+
+      dtCore::RefPtr<Map> mMap;
+      std::vector<std::string> mStrings;
+      dtUtil::HashMap<dtCore::UniqueId, BaseActorObject*> mActorsByFileId;
+      std::vector<ActorLink> mActorLinks;
+      std::vector<GroupValue> mGroupValues;
+
+      std::set<std::string> mMissingActorTypes;
+      std::vector<std::string> mMissingLibraries;
+   };
+   typedef dtCore::RefPtr<MapBinaryParser> MapBinaryParserPtr;
+
+   /**
+    * Writes a map or prefab in the binary format.
+    * @see MapBinaryParser
+    */
+   class DT_CORE_EXPORT MapBinaryWriter : public osg::Referenced
+   {
+   public:
+      /// The first four bytes of a binary map.
+      static const char MAGIC[4];
+      static const unsigned short FORMAT_VERSION = 1;
+
+      MapBinaryWriter();
+
+      /**
+       * Saves the map to a binary file.
+       * The create time will be set on the map if this is the first time it has been saved.
+       * @param map the map to save.
+       * @param filePath the path to the file to save.
+       * @param prefab save the map as a prefab.
+       * @throws MapSaveException if any errors occur saving the file.
+       */
+      void Save(Map& map, const std::string& filePath, bool prefab = false);
+
+      /// Saves the map to the end of the stream. @see #Save
+      void Save(Map& map, dtUtil::DataStream& stream, bool prefab = false);
+
+   protected:
+      virtual ~MapBinaryWriter();
+
+   private:
+      MapBinaryWriter(const MapBinaryWriter&); // not implemented by design
+      MapBinaryWriter& operator=(const MapBinaryWriter&); // not implemented by design
+
+      /// Writes the index of the string in the table, adding it if it's new.
+      void WriteTableString(dtUtil::DataStream& stream, const std::string& value);
+
+      void WriteActor(dtUtil::DataStream& stream, BaseActorObject& actor);
+      void WriteProperties(dtUtil::DataStream& stream, BaseActorObject& actor);
+      void WritePropertyValue(dtUtil::DataStream& stream, const ActorProperty& property);
+
+      dtUtil::Log* mLogger;
+      std::vector<std::string> mStrings;
+      dtUtil::HashMap<std::string, unsigned> mStringIndices;
+   };
+   typedef dtCore::RefPtr<MapBinaryWriter> MapBinaryWriterPtr;
+}
+
+#endif // DELTA_MAPBINARY
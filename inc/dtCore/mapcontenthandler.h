@@ -125,6 +125,11 @@ namespace dtCore
           */
          void ClearMap();
 
+         /**
+          * Wrapper function to encapsulate deprecation functionality.  It's shared with the binary map parser.
+          */
+         static ActorTypePtr FindActorType(const std::string& actorTypeCategory, const std::string& actorTypeName);
+
       protected: // This class is referenced counted, but this causes an error...
 
          virtual ~MapContentHandler();
@@ -141,10 +146,6 @@ namespace dtCore
           * specified id by traversing up the previously processed actor.
           */
          BaseActorObject* FindActorById(const dtCore::UniqueId& id) const;
-         /**
-          * Wrapper function to encapsulate deprecation functionality.
-          */
-         static ActorTypePtr FindActorType(const std::string& actorTypeCategory, const std::string& actorTypeName);
 
          dtCore::RefPtr<Map> mMap;
 
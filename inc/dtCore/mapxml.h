@@ -31,6 +31,7 @@
 namespace dtCore
 {
    class MapContentHandler;
+   class MapBinaryParser;
    class ActorPropertySerializer;
    class ActorHierarchyNode;
    class ActorComponentContainer;
@@ -55,6 +56,7 @@ namespace dtCore
          /**
           * Completely parses a map file.  Be sure store an dtCore::RefPtr to the map immediately, otherwise
           * if the parser is deleted or another map file is parse, the map will get deleted.
+          * Files with a binary map or prefab extension are read with a MapBinaryParser.
           * @param path The file path to the map.
           * @param handler The content handler to be used when parsing.
           * @return A pointer to the loaded map.
@@ -98,6 +100,9 @@ namespace dtCore
       MapParser& operator=(const MapParser& assignParser);
 
       dtCore::RefPtr<MapContentHandler> mMapHandler;
+      dtCore::RefPtr<MapBinaryParser> mBinaryParser;
+      /// true if the last map parsed was binary, so the getters should ask mBinaryParser.
+      bool mParsedBinary;
    };
    typedef RefPtr<MapParser> MapParserPtr;
 
@@ -93,6 +93,21 @@ namespace dtCore
          std::vector<MapTreeData>      subCategories;
       };
 
+      /// Counts of the lookups made by GetResourcePath.
+      struct ResourcePathCacheStatistics
+      {
+         ResourcePathCacheStatistics()
+         : mNumHits(0)
+         , mNumMisses(0)
+         , mNumEntries(0)
+         {
+         }
+
+         unsigned mNumHits;    ///< Lookups answered from the cache, including resources known not to exist.
+         unsigned mNumMisses;  ///< Lookups that searched the context directories.
+         unsigned mNumEntries; ///< Paths and misses currently cached.
+      };
+
       /**
        * @return the single instance of this class.
        */
@@ -524,6 +539,23 @@ namespace dtCore
        */
       const std::string GetResourcePath(const ResourceDescriptor& resource, bool isCategory = false) const;
 
+      /**
+       * GetResourcePath remembers where it found each resource, and which resources it didn't find, so that
+       * looking one up again doesn't touch the file system.  The cache is emptied when contexts are
+       * added or removed, on Refresh, and when resources or categories are added or removed through the project.
+       * It's on by default.  Turn it off, or call ClearResourcePathCache, if files in the contexts are changed
+       * by something else while the project is open.
+       */
+      void SetResourcePathCacheEnabled(bool enabled);
+      bool GetResourcePathCacheEnabled() const;
+
+      /// Forgets all the cached resource paths and misses.  This is safe to call from any thread.
+      void ClearResourcePathCache();
+
+      /// @return the hit and miss counts since the last reset, and the current number of cached entries.
+      ResourcePathCacheStatistics GetResourcePathCacheStatistics() const;
+      void ResetResourcePathCacheStatistics();
+
       /**
        * Adds a resource to the project by copying it into the project.
        * @param newName the new name of the resource.
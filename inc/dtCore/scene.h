@@ -53,6 +53,7 @@ namespace dtCore
 {
    class Transformable;
    class DatabasePager;
+   class SpatialIndex;
    class DeltaDrawable;
    class Light;
    class View;
@@ -216,6 +217,13 @@ namespace dtCore
        */
       void ResetDatabasePager();
 
+      /**
+       * @return the spatial index holding every Transformable in the scene.  It's updated each frame
+       *         on the frame synch message, so the volumes in it see the moves made during the pre frame.
+       */
+      SpatialIndex& GetSpatialIndex();
+      const SpatialIndex& GetSpatialIndex() const;
+
    protected:
 
       friend class View;
@@ -0,0 +1,299 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_SPATIALINDEX
+#define DELTA_SPATIALINDEX
+
+#include <dtCore/export.h>
+#include <dtCore/observerptr.h>
+#include <dtCore/refptr.h>
+#include <dtUtil/hashmap.h>
+
+#include <osg/Referenced>
+#include <osg/Vec3>
+#include <OpenThreads/Mutex>
+
+#include <vector>
+
+namespace dtCore
+{
+   class SpatialIndex;
+   class Transformable;
+
+   /**
+    * A sphere or an axis aligned box in a SpatialIndex that is told about the objects entering and leaving it.
+    * The volume is either fixed or follows an anchor Transformable.  Subclass it and override OnEnter and
+    * OnLeave, then add it to the index.
+    */
+   class DT_CORE_EXPORT SpatialVolume : public osg::Referenced
+   {
+   public:
+      typedef std::vector<Transformable*> OccupantList;
+
+      SpatialVolume();
+
+      /// Makes the volume a sphere of the radius.  It's a sphere of radius 1 by default.
+      void SetSphere(float radius);
+      /// Makes the volume a box with the given half size on each axis.
+      void SetBox(const osg::Vec3& halfExtents);
+
+      bool IsBox() const { return mIsBox; }
+      float GetRadius() const { return mRadius; }
+      const osg::Vec3& GetHalfExtents() const { return mHalfExtents; }
+
+      /// Sets the transformable the volume is centered on.  The anchor is never an occupant of its own volume.
+      void SetAnchor(Transformable* anchor);
+      Transformable* GetAnchor() const;
+
+      /// Sets the center of the volume.  If there is an anchor, the index moves the center to it on each update.
+      void SetCenter(const osg::Vec3& center) { mCenter = center; }
+      const osg::Vec3& GetCenter() const { return mCenter; }
+
+      /// @return true if a sphere with the center and radius overlaps the volume.
+      bool Overlaps(const osg::Vec3& center, float radius = 0.0f) const;
+
+      /// @return the radius of a sphere around the center that holds the whole volume.
+      float GetBoundingRadius() const;
+
+      /// @return the objects in the volume as of the last SpatialIndex::Update, sorted by address.
+      const OccupantList& GetOccupants() const { return mOccupants; }
+      bool IsOccupant(const Transformable& object) const;
+
+      /// @return false to leave the object out of the volume.  Everything is accepted by default.
+      virtual bool Accepts(const Transformable& object) const;
+
+      /// Called by SpatialIndex::Update, after every volume has been updated.
+      virtual void OnEnter(Transformable& object);
+      virtual void OnLeave(Transformable& object);
+
+      /**
+       * Called by SpatialIndex::Update, with the other events, once for each occupant that was deleted since the
+       * last update.  The object is gone, so it can't be passed.  It has already been taken out of the occupants.
+       */
+      virtual void OnOccupantDeleted();
+
+   protected:
+      virtual ~SpatialVolume();
+
+   private:
+      friend class SpatialIndex;
+
+      SpatialVolume(const SpatialVolume&); // not implemented by design
+      SpatialVolume& operator=(const SpatialVolume&); // not implemented by design
+
+      bool mIsBox;
+      float mRadius;
+      osg::Vec3 mHalfExtents;
+      osg::Vec3 mCenter;
+      dtCore::ObserverPtr<Transformable> mAnchor;
+      OccupantList mOccupants;
+      /// The index the volume has been added to.
+      SpatialIndex* mIndex;
+   };
+
+   /**
+    * A broad phase index of where the Transformables are, so the ones near a point or inside a volume can be found
+    * without checking all of them.  Each object is stored in the cell of a uniform grid that holds its center, and
+    * the cells are hashed, so the world doesn't need bounds.  It's a loose grid: queries look as far out as the
+    * largest object radius.
+    *
+    * The index is kept up to date incrementally.  A Transformable tells the index it's in whenever it, or a
+    * Transformable above it, moves, and Update only reads the positions of the objects that moved.  Something that
+    * moves objects without going through a Transformable, such as a plain osg transform above them, should call
+    * MarkAllMoved.
+    *
+    * The Scene owns an index holding every Transformable added to it, and updates it every frame.
+    *
+    * MarkMoved may be called from any thread, the rest of the methods only from one at a time.
+    */
+   class DT_CORE_EXPORT SpatialIndex : public osg::Referenced
+   {
+   public:
+      static const float DEFAULT_CELL_SIZE;
+
+      /// An object that entered or left a volume in the last Update.
+      struct DT_CORE_EXPORT Event
+      {
+         Event() : mEntered(false), mDeleted(false) {}
+
+         dtCore::RefPtr<SpatialVolume> mVolume;
+         dtCore::ObserverPtr<Transformable> mObject;
+         bool mEntered;
+         /// The object left because it was deleted, so mObject is NULL.
+         bool mDeleted;
+      };
+      typedef std::vector<Event> EventList;
+
+      explicit SpatialIndex(float cellSize = DEFAULT_CELL_SIZE);
+
+      float GetCellSize() const { return mCellSize; }
+
+      /// @return the largest object radius as of the last update, which is how far past a query the cells are searched.
+      float GetMaxObjectRadius() const { return mMaxRadius; }
+
+      /**
+       * Adds the transformable, or changes its radius if it's already in the index.  A Transformable can be in one
+       * index at a time, so it's removed from any other one.
+       * @param radius the radius of a sphere around the origin of the transformable that it fills.
+       */
+      void Insert(Transformable& object, float radius = 0.0f);
+
+      /**
+       * Removes the transformable.
+       * @param notifyVolumes if true, OnLeave is called right away for each volume the object was in.
+       */
+      void Remove(Transformable& object, bool notifyVolumes = true);
+
+      /**
+       * Called by a Transformable in the index as it's deleted.  The object is taken out now, and each volume it
+       * was in gets OnOccupantDeleted on the next Update.
+       */
+      void RemoveDeleted(Transformable& object);
+
+      bool Contains(const Transformable& object) const;
+      unsigned GetNumObjects() const;
+
+      /// Called by a Transformable in the index when it moves.
+      void MarkMoved(Transformable& object);
+      /// Makes the next update read the position of every object.
+      void MarkAllMoved();
+
+      /// Adds a volume, which is updated from the next Update.
+      void AddVolume(SpatialVolume& volume);
+      /// Removes the volume and clears its occupants without calling OnLeave.
+      void RemoveVolume(SpatialVolume& volume);
+      unsigned GetNumVolumes() const { return unsigned(mVolumes.size()); }
+
+      /// Reads the positions of the objects that moved since the last call.  The queries use these positions.
+      void UpdatePositions();
+
+      /**
+       * Updates the positions, then finds the objects in each volume.  Once every volume is updated, the enter and
+       * leave events are sent in one batch, so a volume listener sees the index in a consistent state.
+       */
+      void Update();
+
+      /// @return the enter and leave events of the last Update.
+      const EventList& GetLastEvents() const { return mEvents; }
+
+      /// Fills the objects that overlap the sphere.  The vector is not cleared first.
+      void FindInSphere(const osg::Vec3& center, float radius, std::vector<Transformable*>& toFill) const;
+
+      /// Fills the objects that overlap the box.  The vector is not cleared first.
+      void FindInBox(const osg::Vec3& minCorner, const osg::Vec3& maxCorner, std::vector<Transformable*>& toFill) const;
+
+      /// Fills the objects that overlap the volume, the anchor and rejected objects excepted.  The vector is not cleared first.
+      void FindInVolume(const SpatialVolume& volume, std::vector<Transformable*>& toFill) const;
+
+      /// Gets the position of the object as of the last update.  @return false if it's not in the index.
+      bool GetPosition(const Transformable& object, osg::Vec3& position) const;
+
+   protected:
+      virtual ~SpatialIndex();
+
+   private:
+      SpatialIndex(const SpatialIndex&); // not implemented by design
+      SpatialIndex& operator=(const SpatialIndex&); // not implemented by design
+
+      struct CellKey
+      {
+         CellKey() : mX(0), mY(0), mZ(0) {}
+         CellKey(int x, int y, int z) : mX(x), mY(y), mZ(z) {}
+         bool operator<(const CellKey& other) const
+         {
+            if (mX != other.mX) return mX < other.mX;
+            if (mY != other.mY) return mY < other.mY;
+            return mZ < other.mZ;
+         }
+         bool operator==(const CellKey& other) const
+         {
+            return mX == other.mX && mY == other.mY && mZ == other.mZ;
+         }
+
+         int mX, mY, mZ;
+      };
+
+      struct CellKeyHash
+      {
+         size_t operator()(const CellKey& key) const
+         {
+            return size_t(key.mX) * 73856093U ^ size_t(key.mY) * 19349663U ^ size_t(key.mZ) * 83492791U;
+         }
+      };
+
+      /// An object in a cell, with a copy of its position so a query doesn't have to look it up.
+      struct CellEntry
+      {
+         Transformable* mObject;
+         osg::Vec3 mPosition;
+         float mRadius;
+      };
+
+      struct ObjectEntry
+      {
+         CellKey mCell;
+         float mRadius;
+      };
+
+      typedef std::vector<CellEntry> Cell;
+      typedef dtUtil::HashMap<Transformable*, ObjectEntry> ObjectMap;
+      typedef dtUtil::HashMap<CellKey, Cell, CellKeyHash> CellMap;
+
+      CellKey GetCell(const osg::Vec3& position) const;
+
+      /// Takes the object out of the cells and the volumes.  @return false if it wasn't in the index.
+      bool RemoveObject(Transformable& object, std::vector<dtCore::RefPtr<SpatialVolume> >& leftVolumes);
+
+      /// Finds the largest object radius again after the object that had it was removed or shrunk.
+      void UpdateMaxRadius();
+
+      /// Reads the position of the object and puts it in the right cell.
+      void UpdateObject(Transformable& object, ObjectEntry& entry, bool inCell);
+      void RemoveFromCell(const CellKey& key, const Transformable& object);
+
+      /// Calls func for each entry in the cells that could hold an object overlapping the box.
+      template <typename Func>
+      void ForEachCandidate(const osg::Vec3& minCorner, const osg::Vec3& maxCorner, Func& func) const;
+
+      float mCellSize;
+      /// The largest radius of an object, which is how far out of the query the cells are searched.
+      float mMaxRadius;
+      /// Set when the object with the largest radius goes, so mMaxRadius may be too big until the next update.
+      bool mMaxRadiusDirty;
+
+      ObjectMap mObjects;
+      CellMap mCells;
+      std::vector<dtCore::RefPtr<SpatialVolume> > mVolumes;
+      EventList mEvents;
+      /// The leave events of the objects deleted since the last Update.
+      EventList mDeletedEvents;
+
+      std::vector<Transformable*> mMoved;
+      bool mAllMoved;
+      OpenThreads::Mutex mMovedMutex;
+      /// Swapped with mMoved by UpdatePositions, so MarkMoved can carry on while the moves are processed.
+      std::vector<Transformable*> mMovedProcessing;
+
+      /// Reused by Update to hold the new occupants of a volume.
+      SpatialVolume::OccupantList mScratchOccupants;
+   };
+}
+
+#endif // DELTA_SPATIALINDEX
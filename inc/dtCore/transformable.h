@@ -38,6 +38,7 @@ namespace osg
 namespace dtCore
 {
    class PointAxis;
+   class SpatialIndex;
 
    class Transform;
    class TransformableImpl;
@@ -53,6 +54,12 @@ namespace dtCore
     *
     * The Transformable class creates a osg::MatrixTransform node for the
     * protected member mNode.
+    *
+    * The absolute matrix is cached.  Changing the matrix through this class, or adding or removing a child,
+    * marks the cache of this Transformable and of everything under it out of date, so repeated absolute queries
+    * between moves don't walk the scene graph.  Transforms above the top Transformable that aren't
+    * Transformables can't be tracked, so all the caches are also dropped at the start and end of each frame.
+    * Code that moves such a transform in the middle of a frame should call InvalidateAllAbsoluteMatrices().
     */
    class DT_CORE_EXPORT Transformable : public DeltaDrawable
    {
@@ -141,7 +148,10 @@ namespace dtCore
       ///Convenience function for easy type conversion without needing a dynamic cast
       virtual dtCore::Transformable* AsTransformable() { return this; }
 
-      ///Convenience function to return back the internal matrix transform node
+      /**
+       * Convenience function to return back the internal matrix transform node.
+       * Since the caller may change the matrix, this marks the cached absolute matrix out of date.
+       */
       TransformableNode* GetMatrixNode();
 
       ///Convenience function to return back the internal matrix transform node
@@ -169,6 +179,28 @@ namespace dtCore
        */
       static bool GetAbsoluteMatrix(const osg::Node* node, osg::Matrix& wcMatrix, const osg::Node* stopNode = NULL);
 
+      /**
+       * Gets the world coordinate matrix of this Transformable.  It's only computed if this Transformable or
+       * one above it has moved since the last call, otherwise the cached matrix is returned.
+       * @param wcMatrix The matrix to fill
+       */
+      void GetAbsoluteMatrix(osg::Matrix& wcMatrix) const;
+
+      /**
+       * Marks the cached absolute matrix of this Transformable and of all the Transformables under it
+       * out of date.  Call it after changing the matrix node of a Transformable directly.
+       */
+      void InvalidateAbsoluteMatrix();
+
+      /// Marks the cached absolute matrices of all the Transformables out of date.
+      static void InvalidateAllAbsoluteMatrices();
+
+      /**
+       * @return the spatial index this Transformable is in, which is the one of its Scene by default,
+       *         or NULL if it's in none.
+       */
+      SpatialIndex* GetSpatialIndex() const;
+
       ///Automatically rescales normals if you scale your objects.
       void SetNormalRescaling(bool enable);
 
@@ -196,7 +228,16 @@ namespace dtCore
       const osg::Node* GetOSGNode() const;
 
    private:
+      friend class SpatialIndex;
+
       void Ctor();
+
+      /// Only set by the SpatialIndex as the transformable is inserted and removed.
+      void SetSpatialIndex(SpatialIndex* index);
+
+      /// Gets the world coordinate matrix of the parent node, using the cache of the parent Transformable if it has one.
+      void GetParentAbsoluteMatrix(osg::Matrix& wcMatrix) const;
+
       TransformableImpl* mImpl;
    };
 
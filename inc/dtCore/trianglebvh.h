@@ -0,0 +1,141 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_TRIANGLEBVH
+#define DELTA_TRIANGLEBVH
+
+#include <dtCore/export.h>
+
+#include <osg/Referenced>
+#include <osg/BoundingBox>
+#include <osg/Matrix>
+#include <osg/Vec3>
+
+#include <vector>
+
+namespace osg
+{
+   class Node;
+}
+
+namespace dtCore
+{
+   /**
+    * A bounding volume hierarchy over a flat list of triangles, for answering a lot of segment queries against static
+    * geometry, such as ground clamping against a terrain, without walking the scene graph for each one.
+    *
+    * Add the triangles, from nodes or from indexed vertex data such as what dtPhysics::TriangleRecorder makes, then
+    * call Build.  The nodes of the tree are stored in one array in depth first order, and the triangles are stored
+    * in the order of the leaves, so a query touches little memory.
+    *
+    * Once it's built, any number of threads may intersect it at the same time.
+    */
+   class DT_CORE_EXPORT TriangleBVH : public osg::Referenced
+   {
+   public:
+      struct Hit
+      {
+         osg::Vec3 mPoint;
+         /// The normal of the triangle, by its winding.
+         osg::Vec3 mNormal;
+         /// How far along the segment the hit is, from 0 at the start to 1 at the end.
+         float mRatio;
+      };
+
+      typedef std::vector<Hit> HitList;
+
+      /// The most triangles a leaf of the tree holds.
+      static const unsigned MAX_LEAF_TRIANGLES = 4;
+
+      TriangleBVH();
+
+      /// Removes all the triangles and the tree.
+      void Clear();
+
+      /**
+       * Adds the triangles of the node and the drawables under it, transformed by the transforms between the node
+       * and the drawables.  It follows the active children only, so it takes the most detailed level of an LOD.
+       */
+      void AddNode(osg::Node& node);
+
+      /**
+       * Adds indexed triangles, three indices per triangle.
+       * @param matrix if not NULL, the vertices are transformed by it.
+       */
+      void AddTriangles(const std::vector<osg::Vec3>& verts, const std::vector<unsigned>& indices, const osg::Matrix* matrix = NULL);
+
+      void AddTriangle(const osg::Vec3& v0, const osg::Vec3& v1, const osg::Vec3& v2);
+
+      /// Builds the tree over all the triangles added.  Triangles added after this aren't found until it's called again.
+      void Build();
+
+      bool IsBuilt() const;
+
+      unsigned GetNumTriangles() const;
+      unsigned GetNumNodes() const;
+
+      /// @return the bounds of the triangles in the tree.
+      const osg::BoundingBox& GetBoundingBox() const;
+
+      /**
+       * Finds every triangle the segment passes through, on either side.
+       * @param hitsOut cleared, then filled with the hits sorted from the start of the segment to the end.
+       * @return the number of hits.
+       */
+      unsigned IntersectSegment(const osg::Vec3& start, const osg::Vec3& end, HitList& hitsOut) const;
+
+   protected:
+      virtual ~TriangleBVH();
+
+   private:
+      TriangleBVH(const TriangleBVH&); // not implemented by design
+      TriangleBVH& operator=(const TriangleBVH&); // not implemented by design
+
+      /// A triangle stored as a corner and the two edges from it, ready for the intersection test.
+      struct Triangle
+      {
+         osg::Vec3 mV0;
+         osg::Vec3 mEdge1;
+         osg::Vec3 mEdge2;
+      };
+
+      struct Node
+      {
+         osg::Vec3 mMin;
+         osg::Vec3 mMax;
+         /// For a leaf, the first triangle.  Otherwise the index of the second child; the first one follows this node.
+         unsigned mOffset;
+         /// The number of triangles in a leaf, or 0 for an inner node.
+         unsigned mCount;
+      };
+
+      /// Builds the subtree over the triangles from begin to end of mBuildOrder and returns the index of its root.
+      unsigned BuildNode(unsigned begin, unsigned end, const std::vector<osg::Vec3>& centroids, unsigned depth);
+
+      std::vector<Triangle> mTriangles;
+      std::vector<Node> mNodes;
+      /// The triangle indices while building, in the order they end up in the leaves.
+      std::vector<unsigned> mBuildOrder;
+      osg::BoundingBox mBounds;
+      bool mBuilt;
+   };
+}
+
+#endif // DELTA_TRIANGLEBVH
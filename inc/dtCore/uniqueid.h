@@ -40,29 +40,101 @@ namespace dtUtil
 namespace dtCore
 {
 
-   ///Conforms to OSF DCE 1.1
+   /**
+    * Conforms to OSF DCE 1.1
+    *
+    * Ids in the standard lowercase form, such as the ones generated by this class, are also held as 128 bits,
+    * so comparing and hashing them doesn't touch the string.  Any other string, such as a legacy or hand written id
+    * in a map file, is kept and compared only as a string.  Either way ToString() returns exactly the string the
+    * id was created from, and the ordering is the same as ordering by the strings.
+    */
    class DT_CORE_EXPORT UniqueId
    {
    public:
+      /// The number of bytes in the binary form of an id.
+      static const unsigned BINARY_SIZE = 16;
+
       /**
        * @param createNewId if true, generates a new id.  If not, it sets the id to empty.
        */
       explicit UniqueId(bool createNewId = true);
-      UniqueId(const UniqueId& toCopy) { mId = toCopy.mId; }
-
-      explicit UniqueId(const std::string& stringId) : mId(stringId) {}
-      explicit UniqueId(const char* stringId) : mId(stringId) {}
+      UniqueId(const UniqueId& toCopy)
+         : mId(toCopy.mId)
+         , mHigh(toCopy.mHigh)
+         , mLow(toCopy.mLow)
+         , mIsBinary(toCopy.mIsBinary)
+      {
+      }
+
+      explicit UniqueId(const std::string& stringId) : mId(stringId) { ParseBinary(); }
+      explicit UniqueId(const char* stringId) : mId(stringId) { ParseBinary(); }
       virtual ~UniqueId() {}
 
       bool IsNull() const { return mId.empty(); }
 
-      bool operator==(const UniqueId& rhs) const { return mId == rhs.mId; }
-      bool operator!=(const UniqueId& rhs) const { return mId != rhs.mId; }
-      bool operator< (const UniqueId& rhs) const { return mId <  rhs.mId; }
-      bool operator> (const UniqueId& rhs) const { return mId >  rhs.mId; }
+      bool operator==(const UniqueId& rhs) const
+      {
+         // A string can only be held one way, so ids held differently can't be equal.
+         if (mIsBinary != rhs.mIsBinary)
+         {
+            return false;
+         }
+         if (mIsBinary)
+         {
+            return mHigh == rhs.mHigh && mLow == rhs.mLow;
+         }
+         return mId == rhs.mId;
+      }
+
+      bool operator!=(const UniqueId& rhs) const { return !(*this == rhs); }
+
+      bool operator< (const UniqueId& rhs) const
+      {
+         // The hex digits of the lowercase form sort the same as the numbers they make up.
+         if (mIsBinary && rhs.mIsBinary)
+         {
+            return mHigh < rhs.mHigh || (mHigh == rhs.mHigh && mLow < rhs.mLow);
+         }
+         return mId < rhs.mId;
+      }
+
+      bool operator> (const UniqueId& rhs) const { return rhs < *this; }
 
       const std::string& ToString() const;
 
+      /// @return true if the id is held as 128 bits, that is, it's in the standard lowercase form.
+      bool IsBinary() const { return mIsBinary; }
+
+      /**
+       * Fills bytes with the BINARY_SIZE bytes of the id, in the order they appear in the string.
+       * @return false, leaving bytes alone, if the id isn't held in binary.
+       */
+      bool GetBytes(unsigned char* bytes) const;
+
+      /// Sets the id from BINARY_SIZE bytes in the order they appear in the string.
+      void SetBytes(const unsigned char* bytes);
+
+      /// @return a hash of the id.  It's only computed from the string if the id isn't held in binary.
+      size_t GetHash() const
+      {
+         if (mIsBinary)
+         {
+            unsigned long long folded = mHigh ^ (mLow * 0x9E3779B97F4A7C15ULL);
+            return size_t(folded ^ (folded >> 32));
+         }
+         return dtUtil::__hash_string(mId.c_str());
+      }
+
+      /**
+       * Writes the id as one byte saying how it's held, followed by the 16 bytes of a binary id or the string
+       * of any other id.  This is less than half the size of the string for generated ids, but the reader
+       * must know to expect it, unlike the stream operator.
+       */
+      void ToCompactDataStream(dtUtil::DataStream& ds) const;
+
+      /// Reads an id written by ToCompactDataStream.
+      void FromCompactDataStream(dtUtil::DataStream& ds);
+
       /**
        * The assignment operator is public so that unique id's can be changed if they are
        * member variables.  Use const to control when they are changed.
@@ -76,7 +148,18 @@ namespace dtCore
       UniqueId& operator=(const std::string& rhs);
 
    protected:
+      /// Sets the binary form from mId, if mId is in the standard lowercase form.  Call it after changing mId.
+      void ParseBinary();
+
       std::string mId;
+
+   private:
+      /// Sets the id from its two halves and writes the matching string.
+      void SetBinary(unsigned long long high, unsigned long long low);
+
+      unsigned long long mHigh;
+      unsigned long long mLow;
+      bool mIsBinary;
    };
 
    ////////////////////////////////////////////////////
@@ -98,7 +181,7 @@ namespace dtUtil
    struct hash<dtCore::UniqueId>
    {
      size_t operator()(const dtCore::UniqueId& id) const
-     { return dtUtil::__hash_string(id.ToString().c_str()); }
+     { return id.GetHash(); }
    };
 
 } // namespace dtUtil
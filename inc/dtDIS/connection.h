@@ -24,6 +24,7 @@
 
 #include <nl.h>                          // for member & implementation
 #include <cstddef>                       // for size_t definition
+#include <vector>                        // for batch receive parameters
 #include <dtDIS/dtdisexport.h>           // for library export definitions
 
 namespace dtDIS
@@ -55,6 +56,18 @@ namespace dtDIS
       /// @return the number of bytes read from the connection
       size_t Receive(char* buf, size_t numbytes);
 
+      ///\brief reads every queued datagram, up to maxPackets, in one call.
+      /// Each datagram is written into its own packetSize slot of buf, so slot i
+      /// starts at &buf[i * packetSize].  The buffers are only grown, never shrunk,
+      /// so callers should keep them around between calls to avoid reallocation.
+      /// @param buf the storage for the datagrams.
+      /// @param sizes filled with the number of bytes read for each datagram.
+      /// @param packetSize the size of each slot, i.e. the largest datagram expected.
+      /// @param maxPackets the maximum number of datagrams to read.
+      /// @return the number of datagrams read, which is also sizes.size()
+      size_t ReceiveBatch(std::vector<char>& buf, std::vector<size_t>& sizes,
+                          size_t packetSize, size_t maxPackets);
+
    private:
       void HandleError();
 
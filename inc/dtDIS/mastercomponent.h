@@ -28,6 +28,7 @@
 #include <dtDIS/outgoingmessage.h>   // for member
 #include <DIS/IncomingMessage.h>     // for member
 #include <string>                    // for parameter, member
+#include <vector>                    // for member
 #include <dtDIS/dtdisexport.h>       // for export symbols
 
 namespace dtDIS
@@ -50,6 +51,34 @@ namespace dtDIS
       static const dtCore::RefPtr<dtCore::SystemComponentType> TYPE;
       static const std::string DEFAULT_NAME;
 
+      /// The largest datagram the component will read.  DIS limits a PDU to 8192 bytes.
+      static const size_t MAX_PACKET_SIZE = 8192;
+
+      /// The size of each datagram slot in the receive buffer.  It has one spare byte so a full
+      /// slot can only mean the datagram was larger than MAX_PACKET_SIZE and was truncated.
+      static const size_t RECEIVE_SLOT_SIZE = MAX_PACKET_SIZE + 1;
+
+      /// The number of datagrams read from the socket per call into the connection.
+      static const size_t RECEIVE_BATCH_SIZE = 64;
+
+      /// Counters describing the datagrams handled during the most recent TICK_LOCAL.
+      struct ReceiveStatistics
+      {
+         ReceiveStatistics()
+            : mPacketsReceived(0)
+            , mPacketsProcessed(0)
+            , mPacketsDropped(0)
+         {
+         }
+
+         /// datagrams read from the socket.
+         unsigned mPacketsReceived;
+         /// datagrams handed to the IncomingMessage for processing.
+         unsigned mPacketsProcessed;
+         /// datagrams that were read, but discarded because they were empty or truncated.
+         unsigned mPacketsDropped;
+      };
+
       /// supply the configuration files needed to support DIS.
       /// @param config the result of reading data files needed for this component to work.  This class does not assume ownership of the memory.
       /// @param connection_file The XML file that shows the ConnectionData.
@@ -100,6 +129,15 @@ namespace dtDIS
       /// @return the SharedState instance.
       const SharedState* GetSharedState() const;
 
+      /// Sets the most datagrams that will be read from the socket each tick.
+      /// Anything left is read on the following tick.
+      /// @param maxPackets the limit, or 0, the default, to drain everything queued on the socket every tick.
+      void SetMaxPacketsPerTick(unsigned maxPackets);
+      unsigned GetMaxPacketsPerTick() const;
+
+      /// @return the receive counters for the last TICK_LOCAL processed.
+      const ReceiveStatistics& GetLastTickStatistics() const;
+
    protected:
       ~MasterComponent();
 
@@ -119,6 +157,12 @@ namespace dtDIS
       void LoadPlugins(const std::string& directory);
       void UnloadPlugins();
 
+      /// reads all the pending datagrams and hands them to the IncomingMessage.
+      void ReceivePackets();
+
+      /// writes all the pending outgoing datagrams.
+      void SendPackets();
+
    private:
       PluginManager mPluginManager;
       Connection mConnection;
@@ -126,6 +170,11 @@ namespace dtDIS
       OutgoingMessage mOutgoingMessage;
       SharedState* mConfig;
       DefaultPlugin* mDefaultPlugin;
+
+      unsigned mMaxPacketsPerTick;
+      ReceiveStatistics mLastTickStatistics;
+      std::vector<char> mReceiveBuffer;
+      std::vector<size_t> mReceiveSizes;
    };
 }
 
@@ -269,6 +269,23 @@ namespace dtGame
           */
          void SetPartialUpdate(bool newValue);
 
+         /**
+          * Writes the update using the compact encoding.  The actor type is replaced by a handle into the schema table,
+          * and each update parameter by its index in the schema for the actor type.  The first time an actor type
+          * or parameter is written to the table, its definition is written inline.  The epoch of the table is
+          * written first.
+          * @see MessageSchemaTable
+          */
+         virtual void ToCompactDataStream(dtUtil::DataStream& stream, MessageSchemaTable& schemas) const;
+
+         /**
+          * Reads an update written by ToCompactDataStream.  An update from a newer epoch that defines its actor type
+          * clears the table and moves it to that epoch.
+          * @throw dtGame::InvalidParameterException if the stream refers to a schema or parameter index that was never defined,
+          *        or was written in another epoch without defining its actor type.
+          */
+         virtual bool FromCompactDataStream(dtUtil::DataStream& stream, MessageSchemaTable& schemas);
+
       protected:
 
          /// Destructor
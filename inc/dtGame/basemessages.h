@@ -97,6 +97,19 @@ namespace dtGame
          dtCore::RefPtr<ArrayMessageParameter> mMapNames;
    };
 
+   /**
+    * Reports how far along a map change is.  The first half of the percentage covers opening the new maps, the
+    * second half adding their actors to the GM.
+    */
+   DT_DECLARE_MESSAGE_BEGIN(MapChangeProgressMessage, MapMessage, DT_GAME_EXPORT)
+      /// How much of the map change is done, from 0 to 100.
+      DECLARE_PARAMETER_INLINE(float, PercentComplete)
+      /// The number of actors added to the GM so far.
+      DECLARE_PARAMETER_INLINE(unsigned int, NumActorsAdded)
+      /// The number of actors to add, or 0 while the maps are still being opened.
+      DECLARE_PARAMETER_INLINE(unsigned int, NumActorsToAdd)
+   DT_DECLARE_MESSAGE_END()
+
    class DT_GAME_EXPORT GameEventMessage : public Message
    {
       public:
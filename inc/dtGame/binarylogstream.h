@@ -211,9 +211,10 @@ namespace dtGame
                return false;
             }
 
-            if (minorVersion != BinaryLogStream::LOGGER_MINOR_VERSION)
+            // older minor versions are still read.
+            if (minorVersion > BinaryLogStream::LOGGER_MINOR_VERSION)
             {
-               error = "Minor version mismatch.";
+               error = "Minor version is newer than this version can read.";
                return false;
             }
 
@@ -249,9 +250,10 @@ namespace dtGame
                return false;
             }
 
-            if (minorVersion != BinaryLogStream::LOGGER_MINOR_VERSION)
+            // older minor versions are still read.
+            if (minorVersion > BinaryLogStream::LOGGER_MINOR_VERSION)
             {
-               error = "Minor version mismatch.";
+               error = "Minor version is newer than this version can read.";
                return false;
             }
 
@@ -28,6 +28,10 @@
 #include <dtGame/basemessages.h>
 #include <dtUtil/log.h>
 #include <dtUtil/threadpool.h>
+#include <OpenThreads/Atomic>
+#include <osg/Timer>
+#include <algorithm>
+#include <vector>
 
 
 namespace dtGame
@@ -39,33 +43,72 @@ namespace dtGame
       typedef dtCore::RefPtr<ActorComponentType> ActorComponentPtr;
       typedef std::vector<ActorComponentPtr> ActorComponentPtrVec;
 
+      /// How many chunks of actor components are made for each immediate thread, so the threads can even out the work.
+      static const unsigned CHUNKS_PER_THREAD = 4;
+      /// How many frames pass between re-sorting and re-chunking the actor components by their measured update cost.
+      static const unsigned REBALANCE_INTERVAL = 30;
+
+      struct ActorComponentData
+      {
+         ActorComponentData()
+         : mUpdateCost(0.0f)
+         {
+         }
+
+         ActorComponentPtr mActorComp;
+         /// A running average of how long the update takes, in microseconds.
+         float mUpdateCost;
+      };
+
+      /**
+       * One of these is queued per immediate thread.  Each one takes the next chunk of actor components
+       * until they are all taken, so a thread that gets expensive actors just ends up doing fewer chunks.
+       */
       class ActorCompUpdateTask: public dtUtil::ThreadPoolTask
       {
       public:
-         ActorCompUpdateTask()
+         ActorCompUpdateTask(DataCentricGMComponent& owner)
          : mUpdateDT(0.0)
+         , mBusyTime(0.0)
+         , mOwner(owner)
          {
          }
 
          /////////////////////////////////////////////////////////////
          virtual void operator()()
          {
-            for (unsigned i = 0; i < mActorComps.size(); ++i)
+            osg::Timer* timer = osg::Timer::instance();
+            const osg::Timer_t start = timer->tick();
+            osg::Timer_t updateStart = start;
+
+            const unsigned numChunks = unsigned(mOwner.mChunkStarts.size()) - 1U;
+            unsigned chunk = unsigned(++mOwner.mNextChunk) - 1U;
+            while (chunk < numChunks)
             {
-               mActorComps[i]->Update(mUpdateDT);
+               for (unsigned i = mOwner.mChunkStarts[chunk]; i < mOwner.mChunkStarts[chunk + 1]; ++i)
+               {
+                  ActorComponentData& data = *mOwner.mUpdateOrder[i];
+                  data.mActorComp->Update(mUpdateDT);
+
+                  const osg::Timer_t updateEnd = timer->tick();
+                  data.mUpdateCost += (float(timer->delta_u(updateStart, updateEnd)) - data.mUpdateCost) * 0.25f;
+                  updateStart = updateEnd;
+               }
+               chunk = unsigned(++mOwner.mNextChunk) - 1U;
             }
+
+            mBusyTime = timer->delta_u(start, updateStart);
          }
+
          float mUpdateDT;
-         ActorComponentPtrVec mActorComps;
+         /// How long the last run took, in microseconds.
+         double mBusyTime;
+      private:
+         DataCentricGMComponent& mOwner;
       };
 
       typedef std::vector<dtCore::RefPtr<ActorCompUpdateTask> > ThreadTasksVec;
 
-      struct ActorComponentData
-      {
-          ActorComponentPtr mActorComp;
-      };
-
       typedef dtGame::GMComponent BaseClass;
       typedef std::map<dtCore::UniqueId, ActorComponentData > ActorCompMap;
       typedef typename  ActorCompMap::allocator_type AllocType_;
@@ -74,11 +117,17 @@ namespace dtGame
 
       DataCentricGMComponent(dtCore::SystemComponentType& type)
       : BaseClass(type)
+      , mNumActiveTasks(0U)
+      , mFramesUntilRebalance(0U)
+      , mUpdateOrderDirty(true)
       {
       }
 
       DataCentricGMComponent(const std::string& name)
       : BaseClass(name)
+      , mNumActiveTasks(0U)
+      , mFramesUntilRebalance(0U)
+      , mUpdateOrderDirty(true)
       {
       }
 
@@ -105,7 +154,7 @@ namespace dtGame
          }
          else
          {
-            mThreadTasks.clear();
+            mUpdateOrderDirty = true;
          }
          return true;
       }
@@ -129,7 +178,7 @@ namespace dtGame
          if (iter != mRegisteredActors.end())
          {
             mRegisteredActors.erase(iter);
-            mThreadTasks.clear();
+            mUpdateOrderDirty = true;
             result = true;
          }
          return result;
@@ -147,51 +196,104 @@ namespace dtGame
       void ClearRegisteredActors()
       {
          mRegisteredActors.clear();
+         mUpdateOrder.clear();
+         mUpdateOrderDirty = true;
       }
 
       /**
        * Build up the thread worker tasks.  You must call
        * dtUtil::ThreadPool::ExecuteTasks();
-       * yourself
+       * yourself, and not register or unregister actors until it returns.
+       * The actor components are updated in chunks that the tasks take as they go.  Every REBALANCE_INTERVAL frames,
+       * and whenever the registered actors change, they are sorted so the most expensive updates go first,
+       * and chunked so each chunk takes about the same time to update.
        * @param dt the time delta.
        */
       void BuildThreadWorkerTasks(float dt)
       {
-         if (mThreadTasks.empty())
+         const unsigned threads = dtUtil::ThreadPool::GetNumImmediateWorkerThreads();
+         while (mThreadTasks.size() < threads)
          {
-            unsigned threads = dtUtil::ThreadPool::GetNumImmediateWorkerThreads();
-
-
-            for (unsigned i = 0; i < threads; ++i)
-            {
-               mThreadTasks.push_back(new ActorCompUpdateTask);
-               mThreadTasks.back()->mActorComps.reserve(mRegisteredActors.size() + 1);
-            }
+            mThreadTasks.push_back(new ActorCompUpdateTask(*this));
+         }
 
+         if (mUpdateOrderDirty)
+         {
+            mUpdateOrder.clear();
+            mUpdateOrder.reserve(mRegisteredActors.size());
             ActorCompIter iter = mRegisteredActors.begin();
             ActorCompIter end = mRegisteredActors.end();
-
-            while (iter != end)
+            for (; iter != end; ++iter)
             {
-               for (unsigned i = 0; i < threads && iter != end; ++i)
-               {
-                  ActorCompMapping& current = *iter;
-                  mThreadTasks[i]->mActorComps.push_back(current.second.mActorComp);
-                  ++iter;
-               }
+               mUpdateOrder.push_back(&iter->second);
             }
+            mUpdateOrderDirty = false;
+            mFramesUntilRebalance = 0U;
          }
 
-         for (unsigned i = 0; i < mThreadTasks.size(); ++i)
+         if (mFramesUntilRebalance == 0U)
          {
-            if (!mThreadTasks[i]->mActorComps.empty())
-            {
-               mThreadTasks[i]->mUpdateDT = dt;
-               dtUtil::ThreadPool::AddTask(*mThreadTasks[i]);
-            }
+            BalanceUpdateOrder(threads);
+            mFramesUntilRebalance = REBALANCE_INTERVAL;
+         }
+         --mFramesUntilRebalance;
+
+         mNextChunk.exchange(0U);
+
+         // No more tasks than chunks, since the extra ones would have nothing to do.
+         mNumActiveTasks = std::min(threads, unsigned(mChunkStarts.size()) - 1U);
+         for (unsigned i = 0; i < mNumActiveTasks; ++i)
+         {
+            mThreadTasks[i]->mUpdateDT = dt;
+            dtUtil::ThreadPool::AddTask(*mThreadTasks[i]);
          }
       }
 
+      /**
+       * Fills the time each update task spent updating actor components last frame, in microseconds.
+       * Call it after the tasks have completed.
+       */
+      void GetLastUpdateTaskTimes(std::vector<double>& timesOut) const
+      {
+         timesOut.clear();
+         for (unsigned i = 0; i < mNumActiveTasks; ++i)
+         {
+            timesOut.push_back(mThreadTasks[i]->mBusyTime);
+         }
+      }
+
+      /**
+       * @return the longest time an update task took last frame divided by the average, so 1.0 means the work
+       *         was split evenly, and 2.0 means one thread took twice as long as average while the others waited.
+       *         Call it after the tasks have completed.
+       */
+      double GetLastUpdateImbalance() const
+      {
+         double total = 0.0, longest = 0.0;
+         for (unsigned i = 0; i < mNumActiveTasks; ++i)
+         {
+            total += mThreadTasks[i]->mBusyTime;
+            longest = std::max(longest, mThreadTasks[i]->mBusyTime);
+         }
+
+         if (total <= 0.0)
+         {
+            return 1.0;
+         }
+         return longest * double(mNumActiveTasks) / total;
+      }
+
+      /// @return the running average of how long the actor's component takes to update, in microseconds, or 0 if it's not registered.
+      float GetUpdateCost(const dtCore::UniqueId& id) const
+      {
+         const typename ActorCompMap::const_iterator iter = mRegisteredActors.find(id);
+         if (iter == mRegisteredActors.end())
+         {
+            return 0.0f;
+         }
+
+         return iter->second.mUpdateCost;
+      }
 
       /////////////////////////////////////////////////////////////////////////////////
       virtual void ProcessMessage(const dtGame::Message& message)
@@ -245,8 +347,59 @@ namespace dtGame
       }
 
    private:
+      struct MoreExpensiveUpdate
+      {
+         bool operator()(const ActorComponentData* lhs, const ActorComponentData* rhs) const
+         {
+            return lhs->mUpdateCost > rhs->mUpdateCost;
+         }
+      };
+
+      /**
+       * Sorts the update order so the most expensive updates come first, then splits it into chunks of about the same cost.
+       * Actors that haven't been measured yet cost nothing, so a chunk is also capped at its share of the actor count.
+       */
+      void BalanceUpdateOrder(unsigned threads)
+      {
+         std::stable_sort(mUpdateOrder.begin(), mUpdateOrder.end(), MoreExpensiveUpdate());
+
+         const unsigned numActors = unsigned(mUpdateOrder.size());
+         const unsigned targetChunks = std::max(threads, 1U) * CHUNKS_PER_THREAD;
+         const unsigned maxChunkSize = (numActors + targetChunks - 1U) / targetChunks;
+
+         double totalCost = 0.0;
+         for (unsigned i = 0; i < numActors; ++i)
+         {
+            totalCost += mUpdateOrder[i]->mUpdateCost;
+         }
+         const double targetCost = totalCost / double(targetChunks);
+
+         mChunkStarts.clear();
+         mChunkStarts.push_back(0U);
+         double chunkCost = 0.0;
+         for (unsigned i = 0; i < numActors; ++i)
+         {
+            chunkCost += mUpdateOrder[i]->mUpdateCost;
+            if ((targetCost > 0.0 && chunkCost >= targetCost) || i + 1U - mChunkStarts.back() >= maxChunkSize || i + 1U == numActors)
+            {
+               mChunkStarts.push_back(i + 1U);
+               chunkCost = 0.0;
+            }
+         }
+      }
+
       ActorCompMap mRegisteredActors;
       ThreadTasksVec mThreadTasks;
+
+      /// The registered actors in the order they are updated.  It points into mRegisteredActors, so it's rebuilt when that changes.
+      std::vector<ActorComponentData*> mUpdateOrder;
+      /// Where each chunk starts in mUpdateOrder, plus the end of the last chunk.
+      std::vector<unsigned> mChunkStarts;
+      /// The next chunk for a task to take.
+      OpenThreads::Atomic mNextChunk;
+      unsigned mNumActiveTasks;
+      unsigned mFramesUntilRebalance;
+      bool mUpdateOrderDirty;
   };
 }
 #endif /* AUTOREGISTERGMCOMPONENT_H_ */
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include <dtCore/refptr.h>
 #include <dtUtil/nodecollector.h>
@@ -39,14 +40,24 @@ namespace dtUtil
 
 namespace dtGame
 {
+   class DeadReckonTask;
    class Message;
    class TickMessage;
    class GameActorProxy;
    class GroundClamper;
 
+   /**
+    * Dead-reckons the registered actors each remote tick.  The registered actors are kept in contiguous arrays
+    * that are only rebuilt when an actor is registered or unregistered.  The dead reckoning itself is split into
+    * ranges of those arrays and run on the immediate threads of the dtUtil::ThreadPool, if it's initialized.
+    * Ground clamping, articulations and anything else that touches the scene graph stay on the calling thread.
+    */
    class DT_GAME_EXPORT DeadReckoningComponent : public dtGame::GMComponent
    {
    public:
+      /// The fewest actors each thread pool task is given.  Fewer actors than this are all dead-reckoned on the calling thread.
+      static const unsigned MIN_ACTORS_PER_TASK = 64;
+
       static const dtCore::RefPtr<dtCore::SystemComponentType> TYPE;
 
       static const std::string DEFAULT_NAME;
@@ -54,7 +65,8 @@ namespace dtGame
       DeadReckoningComponent(dtCore::SystemComponentType& type = *TYPE);
 
       /**
-       * handles a processed a message
+       * handles a processed a message.  The component only subscribes to the tick remote, actor deleted
+       * and map unload messages, so subclasses that handle other types must subscribe to them.
        * @see dtGame::GMComponent#ProcessMessage
        * @param The message
        */
@@ -116,6 +128,13 @@ namespace dtGame
       /// @return the ground clamping utility class
       BaseGroundClamper& GetGroundClamper();
 
+      /**
+       * Sets whether the dead reckoning is split across the threads of the dtUtil::ThreadPool.  It defaults to true,
+       * but it has no effect unless the thread pool is initialized.
+       */
+      void SetUseThreadPool(bool useThreadPool);
+      bool GetUseThreadPool() const;
+
    protected:
       virtual ~DeadReckoningComponent();
 
@@ -157,6 +176,13 @@ namespace dtGame
             const osg::Vec3& currLocation, const osg::Vec3& currentRate,
             float simTimeDelta, bool isPositional = false) const;
 
+      /**
+       * Increments the time since the last update and runs the dead reckoning of the registered actors
+       * from begin up to end, storing the results by index.  This is called from the thread pool, so it
+       * may not touch the scene graph or anything shared between actors.
+       */
+      void DeadReckonRange(unsigned begin, unsigned end, const dtGame::TickMessage& tickMessage);
+
       std::map<dtCore::UniqueId, dtCore::RefPtr<DeadReckoningActorComponent> > mRegisteredActors;
       dtCore::RefPtr<dtGame::BaseGroundClamper> mGroundClamper;
 
@@ -166,6 +192,28 @@ namespace dtGame
 
       void TickRemote(const dtGame::TickMessage& tickMessage);
 
+   private:
+      friend class DeadReckonTask;
+
+      /// Fills the actor arrays from mRegisteredActors.
+      void BuildActorArrays();
+
+      void RunDeadReckonTasks(const dtGame::TickMessage& tickMessage);
+
+      // The registered actors that were found in the game manager, all by the same index.
+      std::vector<dtCore::RefPtr<DeadReckoningActorComponent> > mDRHelpers;
+      std::vector<dtCore::RefPtr<dtGame::GameActorProxy> > mDRActors;
+      std::vector<dtCore::Transformable*> mDRDrawables;
+
+      // The results of dead reckoning the current frame, by the same index as the actors.
+      std::vector<dtCore::Transform> mDRTransforms;
+      std::vector<BaseGroundClamper::GroundClampRangeType*> mDRGroundClampTypes;
+      std::vector<char> mDRTransformChanged;
+
+      std::vector<dtCore::RefPtr<DeadReckonTask> > mDRTasks;
+
+      bool mActorArraysDirty;
+      bool mUseThreadPool;
    };
 
 }
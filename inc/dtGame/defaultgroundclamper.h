@@ -28,6 +28,8 @@
 
 #include <dtCore/transform.h>
 #include <dtCore/batchisector.h>
+#include <dtCore/observerptr.h>
+#include <dtCore/trianglebvh.h>
 
 #include <osg/Referenced>
 
@@ -63,6 +65,8 @@ namespace dtGame
                RuntimeData()
                   : mLastClampedOffset(0.0f)
                   , mLastClampedTime(0.0)
+                  , mLastClampedHitGeneration(0U)
+                  , mLastClampedHitValid(false)
                {
                }
 
@@ -120,6 +124,57 @@ namespace dtGame
                   return mLastClampRotation;
                }
 
+               /**
+                * Saves the result of the last one point clamp that found the ground so that
+                * the clamper can reuse it while the object stays in nearly the same place.
+                * @param position the unclamped position the clamp was run from.
+                * @param hitPoint the point on the ground it found.
+                * @param normal the ground normal at the hit point.
+                * @param generation the generation of the terrain triangle tree the hit was found in.
+                *        @see DefaultGroundClamper::GetTerrainBVHGeneration
+                */
+               void SetLastClampedHit(const osg::Vec3& position, const osg::Vec3& hitPoint, const osg::Vec3& normal,
+                  unsigned generation)
+               {
+                  mLastClampedPosition = position;
+                  mLastClampedHitPoint = hitPoint;
+                  mLastClampedNormal = normal;
+                  mLastClampedHitGeneration = generation;
+                  mLastClampedHitValid = true;
+               }
+
+               /// Forgets the last hit, such as when the last clamp found no ground.
+               void ClearLastClampedHit()
+               {
+                  mLastClampedHitValid = false;
+               }
+
+               /// @return true if SetLastClampedHit has been called since the last ClearLastClampedHit.
+               bool IsLastClampedHitValid() const
+               {
+                  return mLastClampedHitValid;
+               }
+
+               const osg::Vec3& GetLastClampedPosition() const
+               {
+                  return mLastClampedPosition;
+               }
+
+               const osg::Vec3& GetLastClampedHitPoint() const
+               {
+                  return mLastClampedHitPoint;
+               }
+
+               const osg::Vec3& GetLastClampedNormal() const
+               {
+                  return mLastClampedNormal;
+               }
+
+               unsigned GetLastClampedHitGeneration() const
+               {
+                  return mLastClampedHitGeneration;
+               }
+
             protected:
                virtual ~RuntimeData()
                {
@@ -130,6 +185,11 @@ namespace dtGame
                float mLastClampedOffset;
                double mLastClampedTime;
                osg::Matrix mLastClampRotation;
+               osg::Vec3 mLastClampedPosition;
+               osg::Vec3 mLastClampedHitPoint;
+               osg::Vec3 mLastClampedNormal;
+               unsigned mLastClampedHitGeneration;
+               bool mLastClampedHitValid;
          };
 
          DefaultGroundClamper();
@@ -145,6 +205,54 @@ namespace dtGame
           */
          unsigned GetClampBatchSize() const;
 
+         /**
+          * @return the number of one point clamps to queue before running them, which is larger when
+          *         they are run against the terrain triangle tree.
+          */
+         unsigned GetMaxClampBatchSize() const;
+
+         /**
+          * Sets whether to intersect a triangle tree built from the terrain, rather than the terrain's scene graph.
+          * The tree is built once, the first time it's needed after this is turned on or the terrain actor changes.
+          * The batched one point clamps are then run in parallel on the thread pool.
+          * Call RebuildTerrainBVH if the terrain geometry itself changes.  It defaults to false.
+          */
+         void SetUseTerrainBVH(bool useBVH);
+         bool GetUseTerrainBVH() const;
+
+         /**
+          * Sets the triangle tree to use instead of building one from the terrain node, such as one built from
+          * the vertex data of a dtPhysics::TriangleRecorder.  It's used until it's set to NULL or RebuildTerrainBVH is called.
+          * It also turns on SetUseTerrainBVH if it's not NULL.  Set it again after changing its triangles.
+          */
+         void SetTerrainBVH(dtCore::TriangleBVH* bvh);
+
+         /// @return the triangle tree in use, if any.  It may not have been built yet.
+         dtCore::TriangleBVH* GetTerrainBVH();
+
+         /// Throws away the terrain triangle tree so it will be built again from the terrain node the next time it's needed.
+         void RebuildTerrainBVH();
+
+         /**
+          * @return a number that changes each time the terrain triangle tree is set, thrown away or built for a
+          *         new terrain.  Hits saved from another generation aren't reused.
+          */
+         unsigned GetTerrainBVHGeneration() const;
+
+         /**
+          * When using the terrain triangle tree, a one point clamp is skipped and its last hit reused if
+          * the actor moved less than this distance horizontally, and vertically, since that hit was found.
+          * Set it to 0 to always run the clamp.  It defaults to 0.01.
+          */
+         void SetCoherenceDistance(float distance);
+         float GetCoherenceDistance() const;
+
+         /// @return the number of one point clamps run against the terrain since the last ResetClampCounts.
+         unsigned GetNumClampQueries() const;
+         /// @return the number of one point clamps that reused the last hit since the last ResetClampCounts.
+         unsigned GetNumCoherentClamps() const;
+         void ResetClampCounts();
+
          /**
           * Calculates the bounding box for the given actor, stores it in the data object, and populates the Vec3.
           * @param modelDimensions Capture the calculated box dimensions which is also set on data.
@@ -170,6 +278,16 @@ namespace dtGame
             dtCore::BatchIsector::SingleISector& single, float pointZ,
             osg::Vec3& outHit, osg::Vec3& outNormal);
 
+         /**
+          * Gets the ground clamping hit that is closest to the Z value from the hits found in the terrain triangle tree.
+          * It picks the same way as GetClosestHit.
+          * @param hits the hits along a vertical segment, from the top down.
+          */
+         virtual bool GetClosestHitFromList(const dtCore::TransformableActorProxy& actor,
+            GroundClampingData& data,
+            const dtCore::TriangleBVH::HitList& hits, float pointZ,
+            osg::Vec3& outHit, osg::Vec3& outNormal);
+
          /**
           * Get the surface points of the specified actor based on its model dimensions.
           * @param actor Actor to have its bounding box calculated.
@@ -314,8 +432,24 @@ namespace dtGame
 
          dtCore::BatchIsector& GetGroundClampIsector();
 
+         /**
+          * Builds the terrain triangle tree if it's needed.
+          * @return the tree, or NULL if it's not being used or the terrain has no triangles.
+          */
+         dtCore::TriangleBVH* GetOrBuildTerrainBVH();
+
       private:
 
+         /// Queues a one point clamp, and runs the queue if it's full.
+         void AddToClampBatch(const dtCore::Transform& xform, dtCore::TransformableActorProxy& actor, GroundClampingData& data);
+
+         /// RunClampBatch using the terrain triangle tree.
+         void RunClampBatchWithBVH(dtCore::TriangleBVH& bvh);
+
+         /// Moves the actor in a batch entry to the ground hit, if one was found, and saves the offset.
+         void ApplyClampResult(dtCore::Transform& xform, dtCore::TransformableActorProxy& actor,
+            GroundClampingData& data, bool foundHit, const osg::Vec3& hitPoint, const osg::Vec3& normal);
+
          typedef std::pair<dtCore::TransformableActorProxy*, GroundClampingData*> ProxyAndData;
          typedef std::vector<std::pair<dtCore::Transform, ProxyAndData> > BatchVector;
          
@@ -323,6 +457,22 @@ namespace dtGame
 
          dtCore::RefPtr<dtCore::BatchIsector> mTripleIsector;
          dtCore::RefPtr<dtCore::BatchIsector> mIsector;
+
+         dtCore::RefPtr<dtCore::TriangleBVH> mTerrainBVH;
+         /// The terrain the tree was built from, so it can be rebuilt when the terrain changes.
+         dtCore::ObserverPtr<dtCore::Transformable> mTerrainBVHSource;
+         bool mUseTerrainBVH;
+         bool mTerrainBVHSetByUser;
+         unsigned mTerrainBVHGeneration;
+         float mCoherenceDistance;
+         unsigned mNumClampQueries;
+         unsigned mNumCoherentClamps;
+         /// The hits for each query in a batch, kept to save allocations.
+         std::vector<dtCore::TriangleBVH::HitList> mBatchHits;
+         /// The points to run a query from, for the batch entries that can't reuse their last hit.
+         std::vector<osg::Vec3> mBatchQueryPoints;
+         /// The index into mBatchQueryPoints for each batch entry, or -1 to reuse its last hit.
+         std::vector<int> mBatchQueryIndices;
    };
 
 }
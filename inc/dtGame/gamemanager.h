@@ -33,6 +33,8 @@
 #include <dtUtil/enumeration.h> //for ComponentPriority
 #include <dtGame/exceptionenum.h>
 
+#include <osg/Vec3>
+
 namespace dtUtil
 {
    class Log;
@@ -372,6 +374,13 @@ namespace dtGame
          component = dynamic_cast<const ComponentType*>(GetComponentByName(name));
       }
 
+      /**
+       * Called by a GMComponent when it changes the message types it subscribes to, so the GM can rebuild
+       * the table it dispatches from.  There should be no need to call this yourself.
+       * @see GMComponent::SubscribeToMessageType
+       */
+      void OnComponentSubscriptionsChanged();
+
       /**
        * Sets an environment actor on the game manager
        * @param envActor The environment actor to set
@@ -694,6 +703,15 @@ namespace dtGame
        */
       void FindActorsByClassName(const std::string& className, dtCore::ActorPtrVector& toFill);
 
+      /**
+       * Fills a vector with the actors whose drawables are within the radius of the center.  It uses the spatial
+       * index of the scene, so only actors with a drawable in the scene are found, by the origin of the drawable.
+       * @param center the center of the search in world coordinates
+       * @param radius the radius of the search
+       * @param toFill The vector to fill
+       */
+      void FindActorsWithinRadius(const osg::Vec3& center, float radius, dtCore::ActorPtrVector& toFill);
+
 
       /**
        * Returns the game actor proxy whose is matches the parameter
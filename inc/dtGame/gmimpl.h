@@ -23,9 +23,8 @@
 
 #include <dtGame/export.h>
 
-#include <queue>
+#include <vector>
 #include <set>
-#include <list>
 #include <map>
 
 #include <dtCore/uniqueid.h>
@@ -42,6 +41,7 @@
 #include <dtCore/scene.h>
 
 #include <dtUtil/hashmap.h>
+#include <dtUtil/ringbuffer.h>
 
 
 namespace dtCore
@@ -164,11 +164,39 @@ namespace dtGame
       typedef dtUtil::HashMap<const MessageType*,  ProxyInvokableMap> ActorMessageListenerMap;
       ActorMessageListenerMap mActorMessageListeners;
 
-      typedef std::list<dtCore::RefPtr<dtGame::GMComponent> > GMComponentContainer;
+      /// Sorted by priority.  Removed components are set to NULL and erased when no message is being dispatched.
+      typedef std::vector<dtCore::RefPtr<dtGame::GMComponent> > GMComponentContainer;
       GMComponentContainer mComponentList;
+      /// The index of the component receiving a message in each dispatch in progress, so adding a component can fix them.
+      std::vector<size_t*> mComponentDispatchCursors;
 
-      std::queue<dtCore::RefPtr<const Message> > mSendNetworkMessageQueue;
-      std::queue<dtCore::RefPtr<const Message> > mSendMessageQueue;
+      /**
+       * Rebuilds the components to send each message type to from the components' subscriptions.
+       * It must not be called while a message is being dispatched.
+       */
+      void BuildComponentSubscribers();
+
+      /// @return the components, in priority order, that should get messages of the given type.
+      const GMComponentContainer& GetComponentSubscribers(const MessageType& type) const;
+
+      /// Sends one message to one component, logging anything it throws and recording the statistics.
+      void SendMessageToComponent(GMComponent& component, const Message& message, bool toNetwork,
+               bool logComponents, bool isATickLocalMessage);
+
+      typedef dtUtil::HashMap<const MessageType*, GMComponentContainer> ComponentSubscriberMap;
+      /// The components to send each subscribed type to, including the ones that get every message.
+      ComponentSubscriberMap mComponentSubscribers;
+      /// The components that get every message, which also get the types no one subscribed to.
+      GMComponentContainer mBroadcastComponents;
+      /// the number of components in the subscriber table, for counting the dispatches skipped.
+      size_t mNumComponentsInSubscribers;
+      /// the number of components that have subscribed to types, if zero the table is not used.
+      size_t mNumSubscribingComponents;
+      bool mComponentSubscribersDirty;
+
+      typedef dtUtil::RingBuffer<dtCore::RefPtr<const Message> > MessageQueue;
+      MessageQueue mSendNetworkMessageQueue;
+      MessageQueue mSendMessageQueue;
 
       dtCore::RefPtr<dtCore::Scene> mScene;
       dtCore::RefPtr<dtCore::ActorFactory> mLibMgr;
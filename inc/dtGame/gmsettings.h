@@ -65,6 +65,19 @@ namespace dtGame
        */
       DT_DECLARE_ACCESSOR(bool, EditorMode);
 
+      /**
+       * If true, and the dtUtil::ThreadPool is initialized, a map change opens the new maps, which parses them and
+       * creates their actors, on an IO thread of the pool.  The project isn't locked, so nothing else
+       * should open or close maps while that's running.  False by default.
+       */
+      DT_DECLARE_ACCESSOR(bool, LoadMapsInBackground);
+
+      /**
+       * The time in milliseconds a map change may spend adding actors to the GM each frame.  The actors left over
+       * are added on the next frames.  Zero or less, the default, adds all of them in one frame.
+       */
+      DT_DECLARE_ACCESSOR(float, MapLoadFrameBudgetMs);
+
    private:
    };
 
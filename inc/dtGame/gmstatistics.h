@@ -42,6 +42,7 @@ namespace dtGame
    class GMStatistics
    {
       friend class GameManager;
+      friend class GMImpl;
 
    public:
          GMStatistics();
@@ -149,6 +150,7 @@ namespace dtGame
          dtCore::Timer_t      mStatsLastFragmentDump;
          long                 mStatsNumProcMessages;
          long                 mStatsNumSendNetworkMessages;
+         long                 mStatsNumComponentDispatchesSkipped;        ///< messages not passed to components that didn't subscribe to them
          long                 mStatsNumFrames;
          dtCore::Timer_t      mStatsCumGMProcessTime;
          float                mStatsCurFrameActorTotal; 
@@ -27,9 +27,16 @@
 
 #include <dtUtil/enumeration.h>
 #include <dtCore/observerptr.h>
+#include <dtCore/refptr.h>
+#include <dtCore/baseactorobject.h>
 #include <dtGame/export.h> 
 #include <dtGame/gamemanager.h>
 
+namespace dtCore
+{
+   class Map;
+}
+
 namespace dtGame
 {
    class MessageType;
@@ -54,6 +61,9 @@ namespace dtGame
                ///State for unloading the old map.
                static const MapChangeState UNLOAD;
 
+               ///State for opening the new maps on a background thread.
+               static const MapChangeState OPEN;
+
                ///State for loading the new map.
                static const MapChangeState LOAD;
 
@@ -68,6 +78,11 @@ namespace dtGame
          };
       
          MapChangeStateData(dtGame::GameManager& gm);
+
+      protected:
+         virtual ~MapChangeStateData();
+
+      public:
                   
          const NameVector& GetOldMapNames() const { return mOldMapNames; }
          const NameVector& GetNewMapNames() const { return mNewMapNames; }
@@ -85,6 +100,25 @@ namespace dtGame
           */
          void ContinueMapChange();
 
+         /**
+          * @return true if the map change opens the maps in the background or adds the actors over several frames,
+          *         according to the GMSettings.  Progress messages are only sent if this is true.
+          */
+         bool IsIncrementalLoad() const;
+
+         /**
+          * Blocks until the maps being opened on the IO thread, if any, are open.  The map change
+          * itself carries on as usual on the next call to ContinueMapChange.  Call this before
+          * opening or closing maps in the Project while a map change may be running.
+          */
+         void WaitForMapsToOpen();
+
+         /**
+          * Stops the map change in progress, if any, and goes back to IDLE.  This waits for the maps
+          * being opened on the IO thread first, so they are left open in the Project.
+          */
+         void CancelMapChange();
+
          
          /// Takes a map name and loads all the actors into the GM
          /**
@@ -113,6 +147,25 @@ namespace dtGame
          // Closes all of the old maps in the old map vector.
          void CloseOldMaps();         
 
+         // Starts opening the new maps on an IO thread of the thread pool.
+         void StartOpeningNewMaps();
+
+         // Checks on the maps being opened in the background. Returns true once they are all open.
+         bool ContinueOpeningNewMaps();
+
+         // Handles a map that failed to open by ending the map change.
+         void FailMapChange(const std::string& mapName);
+
+         // Adds the events and environment of the map to the GM and collects the actors in it to add.
+         void PrepareMapForGM(dtCore::Map& map, dtCore::ActorRefPtrVector& actorsToAdd);
+
+         // Adds the collected actors to the GM until the time budget for the frame runs out. Returns true when all are added.
+         bool AddActorsToGM();
+
+         void AddActorToGM(dtCore::BaseActorObject& actor);
+
+         void SendProgressMessage(float percentComplete);
+
       private:
          dtCore::ObserverPtr<GameManager> mGameManager;
 
@@ -122,6 +175,13 @@ namespace dtGame
          const MapChangeState* mCurrentState;
          bool mAddBillboards;
 
+         class OpenMapsTask;
+         dtCore::RefPtr<OpenMapsTask> mOpenMapsTask;
+
+         dtCore::ActorRefPtrVector mActorsToAdd;
+         unsigned mNumActorsAdded;
+         bool mActorsPrepared;
+
          //disable copy constructor and operator = 
          MapChangeStateData(const MapChangeStateData&) {}
          MapChangeStateData& operator = (const MapChangeStateData&) { return *this; }
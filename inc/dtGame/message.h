@@ -39,6 +39,7 @@ namespace dtUtil
 namespace dtGame 
 {
    class MessageType;
+   class MessageSchemaTable;
    
    class DT_GAME_EXPORT Message : public osg::Referenced, public dtCore::Serializeable
    {
@@ -77,6 +78,25 @@ namespace dtGame
           */
          virtual bool FromDataStream(dtUtil::DataStream& stream);
 
+         /**
+          * Writes the subclass specific data using the compact encoding, which replaces repeated strings
+          * with indices into the schema table of the channel the stream is sent over.  Both ends of the channel
+          * must use the compact encoding, and see the messages in the same order.
+          * By default, this is the same as ToDataStream.
+          * @param stream the stream to fill.
+          * @param schemas the sending schema table for the channel.
+          */
+         virtual void ToCompactDataStream(dtUtil::DataStream& stream, MessageSchemaTable& schemas) const;
+
+         /**
+          * Reads the subclass specific data written by ToCompactDataStream.
+          * By default, this is the same as FromDataStream.
+          * @return true if it was able to assign the value based on the stream or false if not.
+          * @param stream the stream to pull the data from.
+          * @param schemas the receiving schema table for the channel.
+          */
+         virtual bool FromCompactDataStream(dtUtil::DataStream& stream, MessageSchemaTable& schemas);
+
          /**
           * Non-const version of getter to return a message parameter by name.
           * @return the parameter specified or NULL of non exists.
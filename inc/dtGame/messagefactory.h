@@ -150,11 +150,42 @@ namespace dtGame
           */
          dtCore::RefPtr<Message> CloneMessage(const Message& msg) const;
 
+         /// The most messages of one type kept for reuse when none is given.
+         static const unsigned DEFAULT_POOL_SIZE = 16;
+
+         /**
+          * Turns reuse of the messages of a type on or off.  When it is on, the factory keeps the messages it creates
+          * and hands one back out once nothing else holds a reference to it, instead of allocating a new one.
+          * A reused message has its header and parameters reset to the values of a newly created one.
+          *
+          * Only turn this on for types whose messages are created often and are not kept by their receivers.
+          * The GameManager's factory has it on for the tick and system messages.
+          *
+          * @param maxPooled the most messages of this type to keep. Messages created beyond that are not kept.
+          */
+         void SetMessageTypePooled(const MessageType& msgType, bool pooled, unsigned maxPooled = DEFAULT_POOL_SIZE);
+         bool IsMessageTypePooled(const MessageType& msgType) const;
+
+         /// @return the number of messages allocated by CreateMessage since the statistics were last reset.
+         unsigned GetNumMessagesAllocated() const;
+         /// @return the number of pooled messages CreateMessage handed out again since the statistics were last reset.
+         unsigned GetNumMessagesRecycled() const;
+         void ResetPoolStatistics();
+
       private:
+         class MessagePool;
+
+         MessageFactory(const MessageFactory&); // not implemented by design
+         MessageFactory& operator=(const MessageFactory&); // not implemented by design
+
          static void ThrowIdException(const MessageType& type);
 
+         dtCore::RefPtr<Message> AllocateMessage(const MessageType& msgType) const;
+
          std::string mName, mDescription;
 
+         MessagePool* mPool;
+
          dtCore::RefPtr<const MachineInfo> mMachine;
 
          static dtCore::RefPtr<dtUtil::ObjectFactory<const MessageType*, Message> > mMessageFactory;
@@ -0,0 +1,146 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_MESSAGESCHEMATABLE
+#define DELTA_MESSAGESCHEMATABLE
+
+#include <dtGame/export.h>
+#include <dtUtil/refstring.h>
+#include <osg/Referenced>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dtCore
+{
+   class DataType;
+   class NamedParameter;
+}
+
+namespace dtGame
+{
+   /**
+    * Holds the parameter layouts, or schemas, of the actor update messages sent or received over one channel,
+    * such as a single network connection.  The first update of an actor type sent over the channel carries
+    * the actor type and the name and type of each of its parameters.  Later updates only carry a small type handle
+    * and the index of each parameter in the schema.
+    *
+    * A table only describes one direction, so the writer and the reader each keep their own and must see
+    * the messages in the same order.  A connection needs one table for sending and one for receiving.
+    * Any message that adds definitions must be delivered reliably and in order.  Messages that only use them
+    * may be sent best effort; one that arrives before the definitions it uses can't be read and is dropped.
+    *
+    * Clearing the writer table starts a new epoch.  Each message carries the epoch it was written in, and the
+    * reader clears its own table when the first definition from the new epoch arrives, so the two can be
+    * brought back in sync if they ever disagree.
+    *
+    * @see Message#ToCompactDataStream
+    */
+   class DT_GAME_EXPORT MessageSchemaTable : public osg::Referenced
+   {
+   public:
+      struct DT_GAME_EXPORT ParameterSchema
+      {
+         ParameterSchema();
+         ParameterSchema(const dtUtil::RefString& name, dtCore::DataType& dataType, bool isList);
+
+         dtUtil::RefString mName;
+         dtCore::DataType* mDataType;
+         bool mIsList;
+      };
+
+      struct DT_GAME_EXPORT ActorTypeSchema
+      {
+         std::string mCategory;
+         std::string mName;
+         std::vector<ParameterSchema> mParameters;
+
+         /// Writer side lookup of the parameter indices by name.
+         std::map<std::string, unsigned short> mIndexMap;
+      };
+
+      MessageSchemaTable();
+
+      /**
+       * Writer side. Finds the schema for an actor type, adding it if it has not been used on this table yet.
+       * @param category the actor type category.
+       * @param name the actor type name.
+       * @param isNew set to true if the schema was just added, so its definition must be written.
+       * @return the handle of the schema.
+       */
+      unsigned short FindOrAddActorTypeSchema(const std::string& category, const std::string& name, bool& isNew);
+
+      /**
+       * Writer side. Finds the index of a parameter in a schema, appending it if it isn't there yet or if
+       * the parameter changed its data type.
+       * @param handle the handle of the schema.
+       * @param param the parameter to look up.
+       * @param isNew set to true if the parameter was just appended, so its definition must be written.
+       * @return the index of the parameter in the schema.
+       */
+      unsigned short FindOrAddParameter(unsigned short handle, const dtCore::NamedParameter& param, bool& isNew);
+
+      /**
+       * Reader side. Defines, or redefines, the actor type for the given handle.
+       */
+      void DefineActorTypeSchema(unsigned short handle, const std::string& category, const std::string& name);
+
+      /**
+       * Reader side. Appends a parameter to a schema that has been defined.
+       */
+      void DefineParameter(unsigned short handle, const ParameterSchema& param);
+
+      /**
+       * @return the schema for the handle, or NULL if it has not been defined.
+       */
+      const ActorTypeSchema* GetActorTypeSchema(unsigned short handle) const;
+
+      /// @return the number of actor types known by this table.
+      unsigned GetSchemaCount() const;
+
+      /**
+       * Writer side.  It goes up by one for each schema or parameter definition that FindOrAddActorTypeSchema
+       * or FindOrAddParameter adds, so comparing it before and after writing a message tells if the message
+       * must be sent reliably.  Clear does not reset it.
+       */
+      unsigned GetNumDefinitionsWritten() const;
+
+      /// @return the epoch of the schemas in the table.  It starts at 0.
+      unsigned char GetEpoch() const;
+
+      /// Reader side.  Sets the epoch after clearing the table to match a writer that was cleared.
+      void SetEpoch(unsigned char epoch);
+
+      /// Forgets all of the schemas and starts the next epoch, such as when a connection is reset.
+      void Clear();
+
+   protected:
+      virtual ~MessageSchemaTable();
+
+   private:
+      std::vector<ActorTypeSchema> mSchemas;
+      std::map<std::string, unsigned short> mHandleMap;
+      unsigned mNumDefinitionsWritten;
+      unsigned char mEpoch;
+   };
+}
+
+#endif // DELTA_MESSAGESCHEMATABLE
@@ -0,0 +1,242 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_INTERESTMANAGER
+#define DELTA_INTERESTMANAGER
+
+#include <dtNetGM/export.h>
+#include <dtCore/namedgroupparameter.h>
+#include <dtCore/refptr.h>
+#include <dtCore/uniqueid.h>
+#include <dtUtil/hashmap.h>
+#include <osg/Referenced>
+#include <osg/Vec3>
+#include <OpenThreads/Mutex>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace dtGame
+{
+   class ActorUpdateMessage;
+   class Message;
+}
+
+namespace dtNetGM
+{
+   /**
+    * The part of the world a client wants actor updates about.  The region is a sphere or a box around a center,
+    * which is either fixed or follows an actor, such as the player or camera actor the client publishes.
+    */
+   struct DT_NETGM_EXPORT InterestRegion
+   {
+      InterestRegion();
+
+      /// @return a sphere of the given radius.
+      static InterestRegion Sphere(const osg::Vec3& center, float radius);
+      /// @return a box with the given half size on each axis.
+      static InterestRegion Box(const osg::Vec3& center, const osg::Vec3& halfExtents);
+
+      /// true for a box of mHalfExtents, false for a sphere of mRadius.
+      bool mIsBox;
+      osg::Vec3 mCenter;
+      float mRadius;
+      osg::Vec3 mHalfExtents;
+
+      /// If not null, the region is centered on this actor once its position is known.
+      dtCore::UniqueId mAnchorActorId;
+
+      /// The full names, "category.name", of the actor types to send.  If empty, all the types are sent.
+      std::set<std::string> mActorTypes;
+
+      /**
+       * Every update of an actor within this distance of the center is sent.  Farther out, updates of the actor are
+       * sent at most every mDistantUpdateInterval seconds.  Zero or less sends everything in the region.
+       */
+      float mFullRateRadius;
+      double mDistantUpdateInterval;
+   };
+
+   /**
+    * Decides which clients the server sends each actor update to.  The actors are tracked in a grid of
+    * cells from the creates and updates that pass through the server, and an update is sent to a client only if
+    * the actor is inside the client's InterestRegion and of a type it wants.  Updates of actors far from the center
+    * of the region are thinned out.
+    *
+    * Only partial actor updates that carry nothing but the position and dead reckoning parameters are filtered,
+    * since the next one replaces them.  Any other change to an actor, creates, deletes and all the other messages
+    * go to every client, so a client always knows about every actor and its state, it just stops hearing about
+    * where the ones it doesn't care about are.  Actors whose position isn't known yet and clients without a
+    * region get everything.
+    *
+    * Once some updates of an actor have been left out for a client, the next update it gets should carry all of
+    * the dead reckoning values last seen for the actor, so it doesn't dead reckon from stale ones when the actor
+    * comes back into the region or its throttle interval ends.  See ShouldSend and AddDeadReckoningState.
+    *
+    * All the methods are thread safe.
+    */
+   class DT_NETGM_EXPORT InterestManager : public osg::Referenced
+   {
+   public:
+      /// Counts of the actor updates considered for one client.
+      struct DT_NETGM_EXPORT ClientStatistics
+      {
+         ClientStatistics();
+
+         unsigned mNumUpdatesSent;
+         unsigned mNumOutsideRegion;
+         unsigned mNumFilteredByType;
+         unsigned mNumThrottled;
+      };
+
+      static const float DEFAULT_CELL_SIZE;
+
+      explicit InterestManager(float cellSize = DEFAULT_CELL_SIZE);
+
+      float GetCellSize() const { return mCellSize; }
+
+      /// Sets or replaces the region of the client with the given machine id.
+      void SetClientInterest(const dtCore::UniqueId& clientId, const InterestRegion& region);
+      /// Forgets the client.  It will get every update again.
+      void RemoveClient(const dtCore::UniqueId& clientId);
+      bool HasClientInterest(const dtCore::UniqueId& clientId) const;
+
+      /// Sets the time used to throttle updates of distant actors.
+      void SetCurrentTime(double time);
+
+      /**
+       * Tracks the actor positions, types and dead reckoning values from creates, updates and deletes.
+       * Other messages are ignored.
+       */
+      void ObserveMessage(const dtGame::Message& message);
+
+      /**
+       * Sets the position, and the type if not empty, of an actor.
+       * @param typeFullName the actor type as "category.name".
+       */
+      void UpdateActor(const dtCore::UniqueId& actorId, const osg::Vec3& position, const std::string& typeFullName = std::string());
+      void RemoveActor(const dtCore::UniqueId& actorId);
+
+      /**
+       * @param addDeadReckoningStateOut if not NULL, set to true if the message is an actor update the client should
+       *        get with AddDeadReckoningState called on it because it missed some earlier ones.  The actor is then
+       *        considered caught up.
+       * @return false if the message is an actor update the client shouldn't get.  This updates the statistics.
+       */
+      bool ShouldSend(const dtGame::Message& message, const dtCore::UniqueId& clientId, bool* addDeadReckoningStateOut = NULL);
+
+      /**
+       * Decides on an update of only the position and dead reckoning parameters of the actor.  When it returns false,
+       * the client is marked as having missed an update of the actor.
+       * @return false if the client shouldn't get the update now.  This updates the statistics.
+       */
+      bool ShouldSendActorUpdate(const dtCore::UniqueId& actorId, const dtCore::UniqueId& clientId);
+
+      /// Adds the last dead reckoning values observed for the actor that the update doesn't already have.
+      void AddDeadReckoningState(dtGame::ActorUpdateMessage& update) const;
+
+      /// @return true if the parameter is the position or one of the values remote actors are dead reckoned from.
+      static bool IsDeadReckoningParameter(const std::string& name);
+
+      /// Fills the ids of the tracked actors in the client's region, using the grid.
+      void GetActorsInRegion(const dtCore::UniqueId& clientId, std::vector<dtCore::UniqueId>& actorsOut) const;
+
+      ClientStatistics GetClientStatistics(const dtCore::UniqueId& clientId) const;
+      void ResetStatistics();
+
+      unsigned GetNumActors() const;
+
+   protected:
+      virtual ~InterestManager();
+
+   private:
+      InterestManager(const InterestManager&); // not implemented by design
+      InterestManager& operator=(const InterestManager&); // not implemented by design
+
+      struct CellKey
+      {
+         CellKey() : mX(0), mY(0), mZ(0) {}
+         CellKey(int x, int y, int z) : mX(x), mY(y), mZ(z) {}
+         bool operator<(const CellKey& other) const
+         {
+            if (mX != other.mX) return mX < other.mX;
+            if (mY != other.mY) return mY < other.mY;
+            return mZ < other.mZ;
+         }
+
+         int mX, mY, mZ;
+      };
+
+      struct CellKeyHash
+      {
+         size_t operator()(const CellKey& key) const
+         {
+            return size_t(key.mX) * 73856093U ^ size_t(key.mY) * 19349663U ^ size_t(key.mZ) * 83492791U;
+         }
+      };
+
+      struct ActorEntry
+      {
+         osg::Vec3 mPosition;
+         CellKey mCell;
+         std::string mTypeFullName;
+         /// The last value of each dead reckoning parameter observed for the actor.
+         dtCore::RefPtr<dtCore::NamedGroupParameter> mDeadReckoningState;
+      };
+
+      struct ClientEntry
+      {
+         InterestRegion mRegion;
+         ClientStatistics mStatistics;
+         /// The time an update of each distant actor was last sent.
+         dtUtil::HashMap<dtCore::UniqueId, double> mLastSentTimes;
+         /// The actors the client missed updates of since it was last sent their dead reckoning state.
+         std::set<dtCore::UniqueId> mMissedUpdates;
+      };
+
+      typedef dtUtil::HashMap<dtCore::UniqueId, ActorEntry> ActorMap;
+      typedef dtUtil::HashMap<dtCore::UniqueId, ClientEntry> ClientMap;
+      typedef dtUtil::HashMap<CellKey, std::vector<dtCore::UniqueId>, CellKeyHash> CellMap;
+
+      /// Stores the dead reckoning parameters of the update on the actor, if it's tracked.
+      void StoreDeadReckoningState(const dtGame::ActorUpdateMessage& update);
+
+      /// Forgets the missed updates of the actor for the client. @return true if it had missed any.
+      bool ClearMissedUpdates(const dtCore::UniqueId& actorId, const dtCore::UniqueId& clientId);
+
+      CellKey GetCell(const osg::Vec3& position) const;
+      void RemoveFromCell(const CellKey& cell, const dtCore::UniqueId& actorId);
+
+      /// @return the center of the region, following the anchor actor if it's known.
+      osg::Vec3 GetRegionCenter(const InterestRegion& region) const;
+
+      float mCellSize;
+      double mCurrentTime;
+
+      ActorMap mActors;
+      ClientMap mClients;
+      CellMap mCells;
+
+      mutable OpenThreads::Mutex mMutex;
+   };
+}
+
+#endif // DELTA_INTERESTMANAGER
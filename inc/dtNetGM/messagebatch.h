@@ -0,0 +1,155 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_MESSAGEBATCH
+#define DELTA_MESSAGEBATCH
+
+#include <dtNetGM/export.h>
+#include <dtCore/uniqueid.h>
+#include <dtUtil/datastream.h>
+
+#include <vector>
+
+namespace dtGame
+{
+   class Message;
+   class MessageSchemaTable;
+}
+
+namespace dtNetGM
+{
+   /**
+    * Packs many messages into frames that each fit in one network packet.  A frame starts with BATCH_FRAME_ID
+    * in place of a message type id, followed by the messages one after another.  Each message has its type id,
+    * a flags byte, the length of its body and then the ids in its header.  The first time an id appears in a frame
+    * it's written in full, after that only as its index in the frame, so the machine ids and an actor sending
+    * several messages cost one byte each.  The sending actor is skipped when it's the same as the about actor.
+    *
+    * Messages with a causing message can't be batched and must be sent on their own.
+    * @see MessageBatchReader
+    */
+   class DT_NETGM_EXPORT MessageBatchWriter
+   {
+   public:
+      /// Written where a message type id would be to mark a frame.  No message type may use the id 0x7FFF.
+      static const unsigned short BATCH_FRAME_ID = 0xFFFF;
+
+      /// The default frame size.  It matches DataStreamPacket::MAX_PAYLOAD so a frame is sent in one packet.
+      static const unsigned DEFAULT_MAX_FRAME_SIZE = 500;
+
+      explicit MessageBatchWriter(unsigned maxFrameSize = DEFAULT_MAX_FRAME_SIZE);
+      virtual ~MessageBatchWriter();
+
+      /**
+       * Adds a message to the current frame.  If it doesn't fit, the current frame is finished first.  A message
+       * too large for a frame of its own still gets one, which is then sent in more than one packet.
+       * @param schemas if not NULL, the body is written with the compact encoding using these schemas.
+       */
+      void AddMessage(const dtGame::Message& message, dtGame::MessageSchemaTable* schemas);
+
+      /// Finishes the current frame, if it has any messages in it.
+      void Flush();
+
+      unsigned GetMaxFrameSize() const { return mMaxFrameSize; }
+
+      /**
+       * @return true if a message in the current frame adds definitions to its schema table, so the frame
+       *         must be sent reliably.
+       */
+      bool GetFrameAddsSchemaDefinitions() const { return mFrameAddsSchemaDefinitions; }
+
+      unsigned GetNumMessagesWritten() const { return mNumMessagesWritten; }
+      unsigned GetNumFramesWritten() const { return mNumFramesWritten; }
+      unsigned GetNumBytesWritten() const { return mNumBytesWritten; }
+
+   protected:
+      /// Called with each finished frame.  The frame is cleared and reused once this returns.
+      virtual void OnFrameFinished(dtUtil::DataStream& frame) = 0;
+
+   private:
+      MessageBatchWriter(const MessageBatchWriter&); // not implemented by design
+      MessageBatchWriter& operator=(const MessageBatchWriter&); // not implemented by design
+
+      /// Writes the id as an index if it's already in the frame, or in full, adding it to the frame ids.
+      void WriteId(dtUtil::DataStream& stream, const dtCore::UniqueId& id);
+
+      /// Writes the header of the message, for the body in mBody, into mEntry.
+      void WriteEntryHeader(const dtGame::Message& message, unsigned short messageTypeId);
+
+      unsigned mMaxFrameSize;
+      dtUtil::DataStream mFrame;
+      dtUtil::DataStream mEntry;
+      dtUtil::DataStream mBody;
+      std::vector<dtCore::UniqueId> mFrameIds;
+      unsigned mNumMessagesInFrame;
+      bool mFrameAddsSchemaDefinitions;
+
+      unsigned mNumMessagesWritten;
+      unsigned mNumFramesWritten;
+      unsigned mNumBytesWritten;
+   };
+
+   /**
+    * Reads the messages in a frame written by MessageBatchWriter, in place.  Read the header of each message with
+    * ReadHeader, then read the body, if wanted, directly from the frame.  The next call to ReadHeader moves to the
+    * next message whether or not the body was read.
+    */
+   class DT_NETGM_EXPORT MessageBatchReader
+   {
+   public:
+      struct DT_NETGM_EXPORT Header
+      {
+         Header();
+
+         unsigned short mMessageTypeId;
+         /// true if the body is written with the compact encoding.
+         bool mCompact;
+         dtCore::UniqueId mSource;
+         dtCore::UniqueId mDestination;
+         dtCore::UniqueId mSendingActor;
+         dtCore::UniqueId mAboutActor;
+      };
+
+      /// @return true if the unread part of the stream starts with a frame.  It doesn't change the read position.
+      static bool IsBatchFrame(dtUtil::DataStream& stream);
+
+      /// Starts reading the frame at the read position of the stream.
+      explicit MessageBatchReader(dtUtil::DataStream& frame);
+
+      /**
+       * Reads the header of the next message and leaves the frame at the start of its body.
+       * @return false if there are no more messages.
+       * @throws dtUtil::Exception if the frame is malformed.
+       */
+      bool ReadHeader(Header& header);
+
+   private:
+      MessageBatchReader(const MessageBatchReader&); // not implemented by design
+      MessageBatchReader& operator=(const MessageBatchReader&); // not implemented by design
+
+      void ReadId(dtCore::UniqueId& id);
+
+      dtUtil::DataStream& mFrame;
+      unsigned mNextMessagePosition;
+      std::vector<dtCore::UniqueId> mFrameIds;
+   };
+}
+
+#endif // DELTA_MESSAGEBATCH
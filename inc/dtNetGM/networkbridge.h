@@ -35,6 +35,7 @@
 #include <dtCore/base.h>
 #include <dtUtil/datastream.h>
 #include <dtGame/machineinfo.h>
+#include <dtGame/messageschematable.h>
 
 // Forward declaration
 namespace dtGame
@@ -104,8 +105,42 @@ namespace dtNetGM
       /**
        * Sends a DataStream across the network
        * @param The messagepacket
+       * @param allowBestEffort if true, the stream is sent best effort when the connection has an unreliable
+       *        socket.  If false, it's always sent reliably and in order with the other reliable streams.
+       * @note virtual so tests can stand in for the connection.
        */
-      void SendDataStream(dtUtil::DataStream& dataStream, bool allowBestEffort);
+      virtual void SendDataStream(dtUtil::DataStream& dataStream, bool allowBestEffort);
+
+      /// @return the number of data streams sent to this host.
+      unsigned GetNumDataStreamsSent() const { return mNumDataStreamsSent; }
+      /// @return the number of packets the data streams were sent in.
+      unsigned GetNumPacketsSent() const { return mNumPacketsSent; }
+      /// @return the number of bytes of data stream sent, not counting the packet headers.
+      unsigned GetNumBytesSent() const { return mNumBytesSent; }
+
+      /**
+       * The schema table used to compact the messages sent to this host.
+       * @see dtGame::MessageSchemaTable
+       */
+      dtGame::MessageSchemaTable& GetSendSchemaTable() const { return *mSendSchemas; }
+
+      /**
+       * The schema table used to read the compact messages received from this host.
+       * @see dtGame::MessageSchemaTable
+       */
+      dtGame::MessageSchemaTable& GetReceiveSchemaTable() const { return *mReceiveSchemas; }
+
+      /// The number of compact messages from one receive schema epoch that can't be read before a reset is asked for.
+      static const unsigned MAX_RECEIVE_SCHEMA_ERRORS = 16;
+
+      /**
+       * Counts a compact message from this host that couldn't be read with the receive schema table.  A few are
+       * expected when best effort messages overtake the definitions they use, but if they keep coming, the tables
+       * are out of sync.
+       * @return true once per receive schema epoch, when the errors reach MAX_RECEIVE_SCHEMA_ERRORS and the host
+       *         should be asked to reset its send schema table.
+       */
+      bool AddReceiveSchemaError();
 
       /**
        * Disconnects the current connection
@@ -182,7 +217,15 @@ namespace dtNetGM
       GNE::Connection* mGneConnection; // Our GNE network connection for sending Packets
       bool mConnectedClient; // bool containing accepted client status
 
+      dtCore::RefPtr<dtGame::MessageSchemaTable> mSendSchemas;
+      dtCore::RefPtr<dtGame::MessageSchemaTable> mReceiveSchemas;
+      unsigned char mReceiveSchemaErrorEpoch;
+      unsigned mNumReceiveSchemaErrors;
+
       unsigned int mLastStream;
+      unsigned mNumDataStreamsSent;
+      unsigned mNumPacketsSent;
+      unsigned mNumBytesSent;
       dtUtil::DataStream mDataStream;
       /**
        * Sets the timestamp of the machineinfo to the current time
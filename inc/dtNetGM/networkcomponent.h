@@ -56,6 +56,7 @@ namespace dtGame
    class NetServerRejectMessage;
    class ServerMessageRejected;
    class MachineInfoMessage;
+   class MessageSchemaTable;
 }
 
 namespace dtNetGM
@@ -123,6 +124,32 @@ namespace dtNetGM
       DT_DECLARE_ACCESSOR(int, GameVersion);
       DT_DECLARE_ACCESSOR(std::string, GNELogFile);
 
+      /**
+       * If true, messages sent to connected hosts use the compact encoding, which replaces the actor type and
+       * parameter names of actor updates with indices negotiated per connection and writes the ids in the message
+       * header in binary.  Receiving is automatic, but every host
+       * on the network must be running a version that understands the compact encoding.
+       * @see dtGame::MessageSchemaTable
+       */
+      DT_DECLARE_ACCESSOR(bool, CompactActorUpdates);
+
+      /**
+       * If true, the messages sent in a tick are held until the end of the tick, then packed into frames of up to
+       * one packet for each connected host instead of sending a data stream per message.  Every host on the network
+       * must be running a version that understands the batched frames.
+       * @see MessageBatchWriter
+       */
+      DT_DECLARE_ACCESSOR(bool, BatchMessages);
+
+      /// Set on the message type id of a data stream that was written with the compact encoding.
+      static const unsigned short COMPACT_ENCODING_FLAG = 0x8000;
+
+      /**
+       * Sent on its own in place of a message type id by a host that keeps failing to read the compact messages
+       * from this one.  This host then clears its send schema table for that host.  No message type may use the id 0x7FFE.
+       */
+      static const unsigned short SCHEMA_RESET_REQUEST_ID = 0xFFFE;
+
       /**
        * Called immediately after a component is added to the GM. Used to register
        * 'additional' Network Messages on the GameManager
@@ -298,8 +325,33 @@ namespace dtNetGM
       virtual MessageActionCode& OnBeforeSendMessage(const dtGame::Message& message, std::string& rejectReason);
 
 
-      dtUtil::DataStream CreateDataStream(const dtGame::Message& message);
-      dtCore::RefPtr<dtGame::Message> CreateMessage(dtUtil::DataStream& dataStream, const NetworkBridge& networkBridge);
+      /**
+       * Writes a message and its causing messages to a data stream.
+       * @param message the message to write.
+       * @param schemas the sending schema table of the destination to use the compact encoding, or NULL for the full encoding.
+       */
+      dtUtil::DataStream CreateDataStream(const dtGame::Message& message, dtGame::MessageSchemaTable* schemas = NULL);
+      dtCore::RefPtr<dtGame::Message> CreateMessage(dtUtil::DataStream& dataStream, NetworkBridge& networkBridge);
+
+      /**
+       * Writes the message for one host and sends it.  A message that adds definitions to the schema table is sent
+       * reliably, because the host can't read anything that uses them until it has them.  The caller must hold mMutex.
+       * @param schemas the sending schema table of the host to use the compact encoding, or NULL for the full encoding.
+       */
+      void SendMessageTo(const dtGame::Message& message, NetworkBridge& networkBridge, dtGame::MessageSchemaTable* schemas);
+
+      /**
+       * Reads the body of a message written with the compact encoding.  If it uses a schema the receive table
+       * doesn't have, the message is dropped, and if that keeps happening, the host is asked to reset its send table.
+       * @return false if the message should be dropped.
+       */
+      bool ReadCompactBody(dtGame::Message& msg, dtUtil::DataStream& dataStream, NetworkBridge& networkBridge);
+
+      /**
+       * Reads each message in a frame written by a MessageBatchWriter and handles it
+       * the same as a message received in a data stream of its own.
+       */
+      void ReceiveBatchFrame(NetworkBridge& networkBridge, dtUtil::DataStream& frame);
 
       /**
        * Is our GNE connection reliable
@@ -469,8 +521,36 @@ namespace dtNetGM
 
       void SendNetworkMessages(MessageBufferType& messages);
 
+      /// Sends the messages to each host in as few frames as they fit in.  Used by SendNetworkMessages when batching.
+      void SendBatchedNetworkMessages(MessageBufferType& messages);
+
+      /// @return the message to send to the given host in place of the given one, or NULL if it isn't for the host.
+      dtCore::RefPtr<const dtGame::Message> GetMessageFor(const dtGame::Message& message, const NetworkBridge& networkBridge);
+
+      /**
+       * Called for each connected client a message addressed to all the clients is about to be sent or forwarded to.
+       * Subclasses may override it to leave out clients that don't need the message, or to send them another one
+       * instead, such as a copy with more parameters.
+       * @return the message to send to the client, or NULL to not send it anything.  It returns the given message by default.
+       */
+      virtual dtCore::RefPtr<const dtGame::Message> GetMessageForClient(const dtGame::Message& message, const NetworkBridge& networkBridge);
+
       void SendNetworkMessage(const dtGame::Message& message, const DestinationType& destinationType = DestinationType::DESTINATION);
 
+      /**
+       * @return the schema table to use when writing a message for the given connection, or NULL
+       *         if it should get the full encoding.
+       */
+      dtGame::MessageSchemaTable* GetSendSchemaTableFor(NetworkBridge& networkBridge);
+
+      /// Creates an empty message with the given type id, or returns NULL if the type isn't supported.
+      dtCore::RefPtr<dtGame::Message> CreateMessageOfType(unsigned short msgId);
+
+      /// Sets the source, destination and actor ids of a message read from the network.
+      void SetReceivedMessageIds(dtGame::Message& msg, const NetworkBridge& networkBridge,
+               const dtCore::UniqueId& sourceId, const dtCore::UniqueId& destinationId,
+               const dtCore::UniqueId& sendingActorId, const dtCore::UniqueId& aboutActorId);
+
       /// When the tick is over, we force a final send. The subclasses might also do work.  
       virtual void DoEndOfTick();
 
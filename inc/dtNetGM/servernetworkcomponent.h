@@ -26,6 +26,7 @@
 
 #include <dtNetGM/export.h>
 #include <dtNetGM/networkcomponent.h>
+#include <dtNetGM/interestmanager.h>
 
 
 namespace dtGame
@@ -70,6 +71,26 @@ namespace dtNetGM
        */
       void SendFrameSyncControlMessage();
 
+      /**
+       * Sets the interest manager used to leave actor updates out of the messages sent to clients that aren't
+       * interested in the actors.  Set NULL, the default, to send every update to every client.
+       */
+      void SetInterestManager(InterestManager* interestManager);
+      InterestManager* GetInterestManager();
+      const InterestManager* GetInterestManager() const;
+
+      /**
+       * Sets the region of the world a client wants actor updates about.  This creates an InterestManager if
+       * there isn't one yet.
+       */
+      void SetClientInterest(const dtGame::MachineInfo& client, const InterestRegion& region);
+
+      /// Overridden to track the actors for the interest manager.
+      void DispatchNetworkMessage(const dtGame::Message& message) override;
+
+      /// Overridden to track the actors the clients publish for the interest manager.
+      void ForwardMessage(const dtGame::Message& message, NetworkBridge& networkBridge) override;
+
    protected:
       // Destructor
       ~ServerNetworkComponent(void);
@@ -138,6 +159,15 @@ namespace dtNetGM
        * @param machineInfo The MachineInfo of the new client
        */
       virtual void SendConnectedClientMessage(const dtGame::MachineInfo& machineInfo);
+
+      /**
+       * Overridden to leave out the actor updates the client isn't interested in, and to add the dead reckoning
+       * state of the actor to the first update sent after some were left out.
+       */
+      dtCore::RefPtr<const dtGame::Message> GetMessageForClient(const dtGame::Message& message, const NetworkBridge& networkBridge) override;
+
+   private:
+      dtCore::RefPtr<InterestManager> mInterestManager;
    };
 }
 
@@ -369,6 +369,29 @@ namespace dtUtil
           */
          const osg::Vec3d ConvertToRemoteRotation(const osg::Vec3& hpr);
 
+         /**
+          * Converts an array of remote coordinates to local translations.  The result for each one is the same
+          * as ConvertToLocalTranslation, but the setup is done once for the array and the geocentric and
+          * geodetic math is done on blocks of points at a time, so use it when there are many to convert.
+          * @param locs the remote locations.
+          * @param translationsOut filled with the local translations.  It may not overlap locs.
+          * @param count the number of locations.
+          */
+         void ConvertToLocalTranslations(const osg::Vec3d* locs, osg::Vec3* translationsOut, unsigned count);
+
+         /**
+          * Converts an array of local translations to remote coordinates, the same as calling
+          * ConvertToRemoteTranslation on each one.
+          * @see #ConvertToLocalTranslations
+          */
+         void ConvertToRemoteTranslations(const osg::Vec3* translations, osg::Vec3d* locsOut, unsigned count);
+
+         /**
+          * Converts an array of hpr rotations in degrees to remote psi, theta, phi rotations in radians, the same as
+          * calling ConvertToRemoteRotation on each one.
+          */
+         void ConvertToRemoteRotations(const osg::Vec3* hprs, osg::Vec3d* rotationsOut, unsigned count);
+
          /**
           * Creates a 4x4 rotation matrix from a set of DIS/RPR-FOM Euler angles.
           *
@@ -9,6 +9,7 @@
 #define HASH_H_
 
 #include <string>
+#include <cstring>
 #include <dtCore/refptr.h>
 
 namespace dtUtil
@@ -119,6 +120,33 @@ namespace dtUtil
        { return __x; }
      };
 
+   template<>
+     struct hash<float>
+     {
+       size_t
+       operator()(float __x) const
+       {
+          // 0.0 and -0.0 are equal, so they need the same hash.
+          if (__x == 0.0f) { return 0; }
+          unsigned int __bits;
+          std::memcpy(&__bits, &__x, sizeof(__bits));
+          return __bits;
+       }
+     };
+
+   template<>
+     struct hash<double>
+     {
+       size_t
+       operator()(double __x) const
+       {
+          if (__x == 0.0) { return 0; }
+          unsigned long long __bits;
+          std::memcpy(&__bits, &__x, sizeof(__bits));
+          return size_t(__bits ^ (__bits >> 32));
+       }
+     };
+
    template<class _Key>
     struct hash<dtCore::RefPtr<_Key> >
     {
@@ -333,6 +333,53 @@ namespace dtUtil
       ///Returns the name of this logger.
       const std::string& GetName() const;
 
+      /**
+       * What a thread logging in asynchronous mode does when the queue of messages waiting to be written is full.
+       */
+      enum AsyncOverflowPolicy
+      {
+         OVERFLOW_DROP,  ///<Throw away the message.
+         OVERFLOW_BLOCK, ///<Wait for the writer thread to make room.  Nothing is lost, but a slow observer can stall the caller.
+         OVERFLOW_COUNT  ///<Throw away the message, and have the writer log how many were dropped once it catches up.
+      };
+
+      static const unsigned DEFAULT_ASYNC_QUEUE_SIZE = 8192;
+
+      /**
+       * Switches all of the logs to asynchronous mode.  LogMessage formats the message and pushes it into a lock free
+       * queue, and a single writer thread sends it to the file, the console, and the observers.  Callers no longer
+       * wait on the file or on each other, but observers are called on the writer thread instead of the logging thread.
+       *
+       * Call this during startup or shutdown, not while other threads are logging.
+       * @param queueSize the number of messages that can be waiting to be written.  It is rounded up to a power of 2.
+       * @param policy what to do when the queue is full.
+       */
+      static void EnableAsyncLogging(unsigned queueSize = DEFAULT_ASYNC_QUEUE_SIZE, AsyncOverflowPolicy policy = OVERFLOW_BLOCK);
+
+      /**
+       * Writes out all of the queued messages, stops the writer thread, and goes back to writing each message on the
+       * thread that logged it.  This is also done when the logs are shut down.
+       */
+      static void DisableAsyncLogging();
+
+      /// @return true if the logs are in asynchronous mode.
+      static bool IsAsyncLoggingEnabled();
+
+      /// Changes the overflow policy of the asynchronous mode.  It does nothing if the logs are synchronous.
+      static void SetAsyncOverflowPolicy(AsyncOverflowPolicy policy);
+
+      /// @return the overflow policy of the asynchronous mode.
+      static AsyncOverflowPolicy GetAsyncOverflowPolicy();
+
+      /**
+       * Blocks until every message queued before the call has been written.  It does nothing if the logs
+       * are synchronous.
+       */
+      static void Flush();
+
+      /// @return the number of messages thrown away because the asynchronous queue was full.
+      static unsigned GetDroppedMessageCount();
+
       //std::ostream& operator()(const std::string& file, const std::string& method, int line, LogMessageType msgType);
 
       //Constructor and destructor are both protected since this is a singleton.
@@ -29,6 +29,9 @@
 #include <string>
 #include <vector>
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 //
 // The "is-a" macro.  Checks whether the first parameter (a pointer) is an
 // instance of the second parameter (a class).
@@ -50,7 +53,8 @@
 //
 // The management layer declaration macro.  Should be included in the
 // declarations of all heavyweight dtCore classes, with the (unquoted) name of
-// the class specified as its parameter.
+// the class specified as its parameter.  The instance list is locked so the
+// classes may be created on background threads, such as while loading a map.
 //
 
 #ifdef DECLARE_MANAGEMENT_LAYER
@@ -59,6 +63,7 @@
 #define DECLARE_MANAGEMENT_LAYER(T)                \
    private:                                        \
       static std::vector<T*> instances;            \
+      static OpenThreads::Mutex instancesMutex;    \
       static void RegisterInstance(T* instance);   \
       static void DeregisterInstance(T* instance); \
    public:                                         \
@@ -78,13 +83,16 @@
 #endif
 #define IMPLEMENT_MANAGEMENT_LAYER(T)                          \
    std::vector<T*> T::instances;                               \
+   OpenThreads::Mutex T::instancesMutex;                       \
    void T::RegisterInstance(T* instance)                       \
    {                                                           \
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(instancesMutex); \
       if (instance != NULL)                                    \
          instances.push_back(instance);                        \
    }                                                           \
    void T::DeregisterInstance(T* instance)                     \
    {                                                           \
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(instancesMutex); \
       for (std::vector<T*>::iterator it = instances.begin();   \
           it != instances.end();                               \
           ++it)                                                \
@@ -96,10 +104,19 @@
          }                                                     \
       }                                                        \
    }                                                           \
-   int T::GetInstanceCount() { return instances.size(); }      \
-   T* T::GetInstance(int index) { return instances[index]; }   \
+   int T::GetInstanceCount()                                   \
+   {                                                           \
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(instancesMutex); \
+      return instances.size();                                 \
+   }                                                           \
+   T* T::GetInstance(int index)                                \
+   {                                                           \
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(instancesMutex); \
+      return instances[index];                                 \
+   }                                                           \
    T* T::GetInstance(std::string name)                         \
    {                                                           \
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(instancesMutex); \
       for (std::vector<T*>::iterator it = instances.begin();   \
           it != instances.end();                               \
           ++it)                                                \
@@ -0,0 +1,129 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#ifndef DELTA_RINGBUFFER
+#define DELTA_RINGBUFFER
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace dtUtil
+{
+   /**
+    * A first in first out queue kept in one contiguous array that wraps around.  Unlike a std::queue on a deque,
+    * it never allocates once it has grown to the most items it has held at once.  The capacity is always a power
+    * of two and doubles when it fills.
+    *
+    * Popping an item assigns a default constructed value over it, so smart pointers are released right away.
+    */
+   template <typename T>
+   class RingBuffer
+   {
+   public:
+      typedef T value_type;
+      typedef size_t size_type;
+
+      explicit RingBuffer(size_type initialCapacity = 16)
+         : mHead(0)
+         , mSize(0)
+      {
+         size_type capacity = 1;
+         while (capacity < initialCapacity)
+         {
+            capacity <<= 1;
+         }
+         mItems.resize(capacity);
+      }
+
+      bool empty() const { return mSize == 0; }
+      size_type size() const { return mSize; }
+      size_type capacity() const { return mItems.size(); }
+
+      T& front() { return mItems[mHead]; }
+      const T& front() const { return mItems[mHead]; }
+
+      T& back() { return mItems[(mHead + mSize - 1) & (mItems.size() - 1)]; }
+      const T& back() const { return mItems[(mHead + mSize - 1) & (mItems.size() - 1)]; }
+
+      /// @return the item index places from the front.
+      T& operator[](size_type index) { return mItems[(mHead + index) & (mItems.size() - 1)]; }
+      const T& operator[](size_type index) const { return mItems[(mHead + index) & (mItems.size() - 1)]; }
+
+      void push_back(const T& item)
+      {
+         if (mSize == mItems.size())
+         {
+            Grow();
+         }
+         mItems[(mHead + mSize) & (mItems.size() - 1)] = item;
+         ++mSize;
+      }
+
+      /// Same as push_back, for code written against std::queue.
+      void push(const T& item) { push_back(item); }
+
+      void pop_front()
+      {
+         mItems[mHead] = T();
+         mHead = (mHead + 1) & (mItems.size() - 1);
+         --mSize;
+      }
+
+      /// Same as pop_front, for code written against std::queue.
+      void pop() { pop_front(); }
+
+      /// Removes all the items, but keeps the capacity.
+      void clear()
+      {
+         while (!empty())
+         {
+            pop_front();
+         }
+         mHead = 0;
+      }
+
+      void swap(RingBuffer& other)
+      {
+         mItems.swap(other.mItems);
+         std::swap(mHead, other.mHead);
+         std::swap(mSize, other.mSize);
+      }
+
+   private:
+      void Grow()
+      {
+         // unwrap into a new array twice the size, so the front is at zero again
+         std::vector<T> items(mItems.size() * 2);
+         for (size_type i = 0; i < mSize; ++i)
+         {
+            items[i] = mItems[(mHead + i) & (mItems.size() - 1)];
+         }
+         mItems.swap(items);
+         mHead = 0;
+      }
+
+      std::vector<T> mItems;
+      size_type mHead;
+      size_type mSize;
+   };
+}
+
+#endif // DELTA_RINGBUFFER
@@ -27,12 +27,17 @@
 
 #include <osg/Referenced>
 #include <OpenThreads/Block>
+#include <OpenThreads/Mutex>
+#include <dtCore/refptr.h>
 #include <dtUtil/export.h>
 #include <dtUtil/getsetmacros.h>
 #include <dtUtil/refstring.h>
+#include <vector>
 
 namespace dtUtil
 {
+   class ThreadPoolImpl;
+
    class DT_UTIL_EXPORT ThreadPoolTask : public osg::Referenced
    {
    public:
@@ -55,10 +60,43 @@ namespace dtUtil
       /// Will block the current thread until this task completes.
       bool WaitUntilComplete(int timeoutMS = -1);
 
+      /**
+       * Makes this task wait for another one to complete before it runs, so the tasks of a frame can form a graph,
+       * such as physics, then dead reckoning, then animation, then publishing.  Each time this task is added to the
+       * pool, it's held until each of its dependencies has completed since it last ran, then it's queued.
+       * Set up the dependencies while none of the tasks are in the pool, and add every task in the graph each time,
+       * in any order.  A dependency that keeps itself in the pool counts as complete once it's no longer kept.
+       */
+      void AddDependency(ThreadPoolTask& prerequisite);
+
+      /// @return the number of tasks this one waits for.
+      unsigned GetNumDependencies() const;
+
    protected:
       virtual ~ThreadPoolTask();
    private:
+      friend class ThreadPoolImpl;
+
       OpenThreads::Block mBlockUntilComplete;
+
+      /// Guards the dependency state, since the dependencies can complete on any thread.
+      mutable OpenThreads::Mutex mDependencyMutex;
+      /// The tasks that depend on this one.
+      std::vector<dtCore::RefPtr<ThreadPoolTask> > mDependents;
+      unsigned mNumDependencies;
+      unsigned mRemainingDependencies;
+      /// true if the task has been added to the pool, but is waiting for its dependencies.
+      bool mWaitingForDependencies;
+      int mWaitingQueue;
+   };
+
+   /// The loop body of ThreadPool::ParallelFor.
+   class DT_UTIL_EXPORT ParallelForBody
+   {
+   public:
+      virtual ~ParallelForBody() {}
+      /// Does the work for the indices from begin up to, but not including, end.
+      virtual void operator()(unsigned begin, unsigned end) = 0;
    };
 
    /**
@@ -98,6 +136,13 @@ namespace dtUtil
     * pool on a single core box or request 0 threads, then there will still be a  thread just for doing background tasks
     * so that things like IO specific tasks will still run in the background and not block the main thread.
     * </p>
+    * <p>
+    * IMMEDIATE tasks are scheduled by work stealing.  Each worker thread has its own queue, and the threads that
+    * aren't workers, such as the main thread, share one more.  A task added by a worker goes in its own queue, and
+    * tasks added by other threads are spread over all of them.  A thread runs the newest task in its own queue,
+    * and when that's empty, it takes the oldest task from another queue.  ParallelFor uses this to split a loop
+    * into pieces that idle threads pick up, and tasks can depend on each other with ThreadPoolTask::AddDependency.
+    * </p>
     */
    class DT_UTIL_EXPORT ThreadPool
    {
@@ -140,7 +185,62 @@ namespace dtUtil
        */
       static unsigned GetNumImmediateWorkerThreads();
 
+      /**
+       * @return the number of threads that run BACKGROUND tasks.  Unlike the immediate tasks, the main thread
+       *         doesn't help with them, so it's the number of workers, or 1 for the background only thread.
+       */
+      static unsigned GetNumBackgroundWorkerThreads();
+
+      /**
+       * Calls func(begin, end) on pieces of the range from begin up to end, on the worker threads and this one,
+       * and returns once the whole range is done.  The range is split in half until the pieces are no bigger
+       * than the grain size, and idle threads steal the pieces that haven't started, so uneven work balances itself.
+       * The grain size should give each piece enough work to be worth a task, such as a few hundred simple iterations.
+       * It may be called from inside a task.
+       * @param func anything that can be called with (unsigned begin, unsigned end).  It's called on several threads at once.
+       */
+      template <typename Func>
+      static void ParallelFor(unsigned begin, unsigned end, unsigned grainSize, Func& func)
+      {
+         ParallelForFunctor<Func> body(func);
+         ParallelFor(begin, end, grainSize, static_cast<ParallelForBody&>(body));
+      }
+
+      static void ParallelFor(unsigned begin, unsigned end, unsigned grainSize, ParallelForBody& body);
+
+      /// Counters for one of the IMMEDIATE task queues since the last ResetStatistics.
+      struct DT_UTIL_EXPORT QueueStatistics
+      {
+         QueueStatistics();
+
+         /// Tasks run by the thread, or threads, that own the queue.
+         unsigned mTasksExecuted;
+         /// Tasks the owner took from the other queues.
+         unsigned mTasksStolen;
+         /// Times the owner found all of the queues empty.
+         unsigned mFailedSteals;
+         /// Times a thread had to wait for the lock on this queue.
+         unsigned mLockContentions;
+      };
+
+      /**
+       * Fills one entry per IMMEDIATE queue.  The entries before the last are for the worker threads,
+       * and the last is for the queue shared by the other threads.
+       */
+      static void GetStatistics(std::vector<QueueStatistics>& stats);
+      static void ResetStatistics();
+
    private:
+      template <typename Func>
+      class ParallelForFunctor : public ParallelForBody
+      {
+      public:
+         ParallelForFunctor(Func& func) : mFunc(func) {}
+         virtual void operator()(unsigned begin, unsigned end) { mFunc(begin, end); }
+      private:
+         Func& mFunc;
+      };
+
       // Hide all constructors and destructors
       ThreadPool();
       ThreadPool(ThreadPool&);
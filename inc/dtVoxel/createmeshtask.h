@@ -33,6 +33,7 @@
 
 #include <openvdb/openvdb.h>
 #include <OpenThreads/Atomic>
+#include <OpenThreads/Mutex>
 
 namespace dtVoxel
 {
@@ -40,18 +41,31 @@ namespace dtVoxel
    class VoxelCellImpl;
    class VoxelCell;
    
+   /**
+    * Polygonizes the iso surface of a grid over a block of cells with marching cubes.  Each z layer of cells is
+    * meshed on its own, possibly in parallel, and vertices are welded by the lattice edge they lie on, so the mesh
+    * comes out the same no matter how many threads make it.
+    *
+    * Once it has run, the task keeps the mesh of each layer.  Edits only mark the bricks of cells around them dirty, and
+    * the next run resamples just the cells in dirty bricks and remeshes just the z layers of bricks they touch.  That
+    * saves most of the sampling for a small edit, but each dirty brick still remeshes BRICK_SIZE full layers, and
+    * merging the layers copies the whole mesh, so the cost still grows with the size of the cell.
+    */
    class DT_VOXEL_EXPORT CreateMeshTask : public dtUtil::ThreadPoolTask
    {
    public:
       enum GenerateMode{ Default, UseMaxThreads, UseSetNumThreads, RunInSingleThread };
 
+      /// The number of cells along each side of a brick, the unit of dirty tracking.
+      static const int BRICK_SIZE = 8;
+
    public:
       CreateMeshTask(const osg::Vec3& offset, const osg::Vec3& texelSize, const osg::Vec3i& resolution, double isoLevel, openvdb::FloatGrid::Ptr grid);
       ~CreateMeshTask();
 
       osg::Geode* TakeGeometry();
 
-      void SetMode();
+      void SetMode(GenerateMode mode);
       GenerateMode GetMode() const;
       
       bool IsDone() const;
@@ -60,21 +74,75 @@ namespace dtVoxel
       
       double GetTime() const;
 
-      // This resets the task if it's done, or if it's not yet run, it will add the passed in bounding box to the work order.
+      /**
+       * Marks the bricks that an edit inside the bounding box changes to be remeshed on the next run.  Edits made before
+       * the run starts are combined into it, and edits made while it is running wait for the one after.
+       * This may be called from any thread.
+       */
       void UpdateWithBounds(const osg::BoundingBox& bb);
 
+      /// @return true if the task has never run or has edits waiting for the next run.
+      bool NeedsUpdate() const;
+
+      /**
+       * Gets the combined bounds of the edits waiting for the next run.
+       * @return false if there are none.
+       */
+      bool GetPendingBounds(osg::BoundingBox& bbOut) const;
+
+      /// @return the number of edits combined into the last run, or 0 if it remeshed everything for the first time.
+      unsigned GetLastNumEdits() const;
+      /// @return the number of cells the last run resampled.
+      unsigned GetLastRemeshedCells() const;
+      /// @return the world space volume of the cells the last run resampled.
+      double GetLastRemeshedVolume() const;
+
       DT_DECLARE_ACCESSOR_INLINE(bool, SkipBackFaces);
       DT_DECLARE_ACCESSOR_INLINE(bool, CacheTriangleData);
       DT_DECLARE_ACCESSOR_INLINE(int, NumThreads);
 
    private:
+      /// The mesh of one z layer of cells, with the vertices indexed within the layer.
+      struct MeshSlab
+      {
+         std::vector<osg::Vec3> mVerts;
+         /// The edge slot each vertex came from.
+         std::vector<unsigned> mVertSlots;
+         /// The vertex made for each edge slot, or -1.
+         std::vector<int> mSlotVerts;
+         /// Three vertices per triangle.
+         std::vector<unsigned> mIndices;
+         /// For each vertex, its index among the vertices this slab owns, or -1 - the index of the same vertex in the slab below.
+         std::vector<int> mOwnedIndex;
+         unsigned mNumOwnedVerts;
+      };
+
+      typedef openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler> FastSampler;
             
       int ComputeIndex(int i, int j, int k) const;
+      int ComputeBrickIndex(int bi, int bj, int bk) const;
+
+      /// Takes the pending edits as the work for this run.
+      void BeginUpdate();
+      /// @return true if the cell has to be resampled rather than read from the cache.
+      bool IsCellDirty(int i, int j, int k) const;
+      /// @return true if the z layer of cells k has to be remeshed.
+      bool IsSlabDirty(int k) const;
       
       void RunMultiThreads();
       void RunSingleThreaded();
 
-      int SampleSingleCell(int i, int j, int k, openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler>& sampler, TRIANGLE* triangles);
+      /// Polygonizes the z layer of cells k into the slab, welding the vertices by lattice edge.
+      void MeshSingleSlab(int k, FastSampler& sampler, MeshSlab& slab);
+      /// Works out which of the slab's vertices were already made by the layer below it.
+      void ResolveSharedVerts(MeshSlab& slab, const MeshSlab* below) const;
+      /// Copies the slab's vertices and triangles into the combined arrays at the given offsets.
+      void CopySlab(const MeshSlab& slab, const MeshSlab* below, unsigned vertOffset, unsigned belowVertOffset, unsigned indexOffset,
+               osg::Vec3Array& vertArray, osg::DrawElementsUInt& drawElements) const;
+      /// Combines the slabs into one geometry and adds it to the mesh.
+      void MergeSlabs(std::vector<MeshSlab>& slabs, bool parallel);
+
+      int SampleSingleCell(int i, int j, int k, FastSampler& sampler, TRIANGLE* triangles, int* triangleEdges);
       double SampleCoord(double x, double y, double z, openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler>& fastSampler);
 
       void CopyTriangleData(const TRIANGLE* triData, TRIANGLE* toFill, int numTris);
@@ -84,19 +152,19 @@ namespace dtVoxel
       GenerateMode mMode;
       
       bool mUseCache;
-      bool mUseBoundingBox;
       double mTime;
       double mIsoLevel;
       
       osg::Vec3 mOffset;
       osg::Vec3 mTexelSize;
       osg::Vec3i mResolution;
-      osg::BoundingBox mDirtyBounds;
+      osg::Vec3i mNumBricks;
       dtCore::RefPtr<osg::Geode> mMesh;
       openvdb::FloatGrid::Ptr mGrid;
       
       typedef struct {
          TRIANGLE mTris[5];
+         unsigned char mEdges[15];
       } TRI_GROUP;
 
       typedef std::vector<TRI_GROUP> TriangleMap;
@@ -104,6 +172,23 @@ namespace dtVoxel
       
       TriangleMap mCacheData;
       TriangleOccupancyArray mOccupancy;
+
+      /// The slabs from the last run, reused for the layers no edit has touched.
+      std::vector<MeshSlab> mSlabs;
+
+      /// Guards the pending edits, which may come in while the task is running.
+      mutable OpenThreads::Mutex mPendingMutex;
+      std::vector<char> mPendingBricks;
+      osg::BoundingBox mPendingBounds;
+      unsigned mNumPendingEdits;
+      bool mHasRun;
+
+      /// The dirty bricks and z layers of bricks for the current run.
+      std::vector<char> mBricksToMesh;
+      std::vector<char> mDirtyBrickLayers;
+
+      unsigned mLastNumEdits;
+      unsigned mLastRemeshedCells;
    };
    
 } /* namespace dtVoxel */
@@ -46,8 +46,13 @@ namespace dtVoxel
    will be loaded up with the vertices at most 5 triangular facets.
    0 will be returned if the grid cell is either totally above
    of totally below the isolevel.
+   If triangleEdges is not NULL, it is filled with the cube edge, 0-11,
+   that each triangle vertex lies on, 3 per triangle, so callers can weld
+   vertices shared by neighboring cells without comparing positions.
+   A vertex that lands exactly on a cube corner is given 12 plus the
+   corner, 0-7, instead, since every edge touching that corner shares it.
    */
-   DT_VOXEL_EXPORT int PolygonizeCube(GRIDCELL g, float iso, TRIANGLE *tri, osg::Vec3* vertArray);
+   DT_VOXEL_EXPORT int PolygonizeCube(GRIDCELL g, float iso, TRIANGLE *tri, osg::Vec3* vertArray, int* triangleEdges = NULL);
 
 
 } /* namespace dtVoxel */
@@ -74,6 +74,13 @@ namespace dtVoxel
 
       void CollectDirtyCells(VoxelActor& voxelActor, const osg::BoundingBox& bb, const osg::Vec3i& textureResolution, std::list<VoxelCellUpdateInfo>& dirtyCells);
 
+      /**
+       * Queues a cell that was just regenerated to be updated again with the edits its mesh task is still holding.
+       * Unlike CollectDirtyCells, it adds no new edits, so neither the task nor the neighboring cells see them twice.
+       * @return false if the cell is already dirty or its node is not paged in.
+       */
+      bool RequeueCell(VoxelCell* cell, const osg::Vec3i& cellIndex, std::list<VoxelCellUpdateInfo>& dirtyCells);
+
 
       //void AllocateCell(const osg::Vec3& pos, const osg::Vec3i& textureResolution);
       
@@ -105,6 +112,8 @@ namespace dtVoxel
       openvdb::GridBase::Ptr ConvertToLocalResolutionGrid(openvdb::GridBase::Ptr);
 
    private:
+      void AddCellUpdate(VoxelCell* cell, const osg::Vec3i& cellIndex, osg::Group* nodeToUpdate, osg::PagedLOD* lod, std::list<VoxelCellUpdateInfo>& dirtyCells);
+
       osg::Vec3 mGridDimensions;
       osg::Vec3 mWSDimensions;
       osg::Vec3 mWSCellDimensions;
@@ -56,8 +56,8 @@ namespace dtVoxel
       void CreateMesh(VoxelActor& voxelActor, osg::Matrix& transform, const osg::Vec3& cellSize, const osg::Vec3i& resolution);
       
       /**
-       * This will either create a task to run in the background to update the cell or part of the cell, or it will update
-       * the bounds on the existing task if it has not yet run.
+       * This will either create a task to run in the background to update the cell, or it will add the bounds to the edits
+       * the existing task remeshes on its next run.
        * If the task is already, set to run, keep in mind that the only parameter that will matter is the bounds, so
        * if the other parameters have changed, the task will need to have been run before calling this function.
        */
@@ -65,6 +65,15 @@ namespace dtVoxel
 
       bool RunTask(bool allowBackgroundThreading);
 
+      /**
+       * Gets the combined bounds of the edits that came in while the mesh was being made, so it needs another update.
+       * @return false if there are none.
+       */
+      bool GetPendingMeshBounds(osg::BoundingBox& bbOut) const;
+
+      /// @return the world space volume the last mesh update resampled.
+      double GetLastRemeshedVolume() const;
+
       bool CheckTaskStatus();
 
       void TakeGeometry();
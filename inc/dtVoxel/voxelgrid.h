@@ -61,6 +61,14 @@ namespace dtVoxel
        */
       void MarkDirtyAABB(const osg::BoundingBox& bb);
 
+      /// @return the number of regions marked dirty since the remesh statistics were reset.
+      unsigned GetNumEdits() const;
+      /// @return the world space volume of the cells resampled to remesh the dirty regions.
+      double GetRemeshedVolume() const;
+      /// @return the remeshed volume divided by the number of edits, or 0 if there were none.
+      double GetRemeshedVolumePerEdit() const;
+      void ResetRemeshStatistics();
+
       /***
       * Deletes all data and recreates it, this is useful if the voxel database has been
       *  deformed but needs to be reset and revert back to the original loaded database.
@@ -118,6 +126,8 @@ namespace dtVoxel
 
       
    private:
+      void CollectDirtyCells(const osg::BoundingBox& bb);
+
       osg::Vec3 mOffset;
       osg::BoundingBox mAllocatedBounds;
       osg::Vec3i mStaticResolution, mDynamicResolution;
@@ -128,6 +138,8 @@ namespace dtVoxel
       std::vector<bool> mBlockVisibility;
       std::list<VoxelCellUpdateInfo> mDirtyCells;
       VoxelBlock* mBlocks;
+      unsigned mNumEdits;
+      double mRemeshedVolume;
 
    };
 
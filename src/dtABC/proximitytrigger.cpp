@@ -8,6 +8,26 @@ using namespace dtABC;
 
 IMPLEMENT_MANAGEMENT_LAYER(ProximityTrigger)
 
+////////////////////////////////////////////////////////////////////////////////
+class ProximityTrigger::Volume : public dtCore::SpatialVolume
+{
+public:
+   Volume(ProximityTrigger& owner)
+      : mOwner(owner)
+   {
+      SetAnchor(&owner);
+      SetSphere(5.0f);
+   }
+
+   virtual void OnEnter(dtCore::Transformable&)
+   {
+      mOwner.mTrigger->Fire();
+   }
+
+private:
+   ProximityTrigger& mOwner;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 ProximityTrigger::ProximityTrigger(const std::string& name)
    : Transformable(name)
@@ -16,9 +36,57 @@ ProximityTrigger::ProximityTrigger(const std::string& name)
 {
    RegisterInstance(this);
 
+   mVolume = new Volume(*this);
+
    // Enable the internal trigger.
    mTrigger->SetEnabled(true);
 
    // Set the update callback which keeps track of traversal numbers.
    GetOSGNode()->setUpdateCallback(new NodeCallback(this));
 }
+
+////////////////////////////////////////////////////////////////////////////////
+ProximityTrigger::~ProximityTrigger()
+{
+   if (dtCore::Scene* scene = GetSceneParent())
+   {
+      scene->GetSpatialIndex().RemoveVolume(*mVolume);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool ProximityTrigger::IsPointInVolume(float x, float y, float z)
+{
+   osg::Matrix matrix;
+   GetAbsoluteMatrix(matrix);
+   mVolume->SetCenter(matrix.getTrans());
+   return mVolume->Overlaps(osg::Vec3(x, y, z));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ProximityTrigger::SetRadius(float radius)
+{
+   mVolume->SetSphere(radius);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float ProximityTrigger::GetRadius() const
+{
+   return mVolume->GetRadius();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ProximityTrigger::AddedToScene(dtCore::Scene* scene)
+{
+   if (scene == NULL && GetSceneParent() != NULL)
+   {
+      GetSceneParent()->GetSpatialIndex().RemoveVolume(*mVolume);
+   }
+
+   Transformable::AddedToScene(scene);
+
+   if (scene != NULL)
+   {
+      scene->GetSpatialIndex().AddVolume(*mVolume);
+   }
+}
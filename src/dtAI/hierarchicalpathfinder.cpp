@@ -0,0 +1,661 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <dtAI/hierarchicalpathfinder.h>
+#include <dtAI/waypointcollection.h>
+#include <dtAI/waypointinterface.h>
+
+#include <dtCore/timer.h>
+
+#include <algorithm>
+#include <queue>
+
+namespace dtAI
+{
+   namespace
+   {
+      struct OpenEntry
+      {
+         OpenEntry(float f, float g, WaypointID id)
+            : mF(f)
+            , mG(g)
+            , mID(id)
+         {
+         }
+
+         // reversed so the std::priority_queue pops the lowest cost first
+         bool operator<(const OpenEntry& rhs) const { return mF > rhs.mF; }
+
+         float mF;
+         float mG;
+         WaypointID mID;
+      };
+
+      typedef std::priority_queue<OpenEntry> OpenList;
+
+      struct SearchLabel
+      {
+         float mG;
+         WaypointID mParent;
+         /// true if the node was reached by a path inside its cluster
+         bool mInside;
+         bool mClosed;
+      };
+
+      typedef dtUtil::HashMap<WaypointID, SearchLabel> LabelMap;
+
+      /////////////////////////////////////////////////////////////////////////////
+      float Distance(const WaypointInterface& lhs, const WaypointInterface& rhs)
+      {
+         return (lhs.GetPosition() - rhs.GetPosition()).length();
+      }
+
+      /////////////////////////////////////////////////////////////////////////////
+      const WaypointCollection* GetTreeParent(const WaypointCollection& wc)
+      {
+         return dynamic_cast<const WaypointCollection*>(wc.parent());
+      }
+
+      /////////////////////////////////////////////////////////////////////////////
+      // fills chain with the collections above a concrete waypoint, so chain[i] is on search level i + 1
+      void GetAncestors(const WaypointGraph& graph, WaypointID id, std::vector<const WaypointCollection*>& chain)
+      {
+         chain.clear();
+         const WaypointCollection* wc = graph.FindCollection(id);
+         while (wc != NULL)
+         {
+            chain.push_back(wc);
+            wc = GetTreeParent(*wc);
+         }
+      }
+
+      /////////////////////////////////////////////////////////////////////////////
+      // returns true if the label was made better
+      bool Relax(LabelMap& labels, OpenList& open, WaypointID id, WaypointID parent, float g, float h, bool inside)
+      {
+         LabelMap::iterator found = labels.find(id);
+         if (found == labels.end())
+         {
+            SearchLabel label = { g, parent, inside, false };
+            labels.insert(std::make_pair(id, label));
+         }
+         else if (!found->second.mClosed && g < found->second.mG)
+         {
+            found->second.mG = g;
+            found->second.mParent = parent;
+            found->second.mInside = inside;
+         }
+         else
+         {
+            return false;
+         }
+
+         open.push(OpenEntry(g + h, g, id));
+         return true;
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   HierarchicalPathfinder::Statistics::Statistics()
+      : mAbstractNodesExpanded(0)
+      , mPortalNodesExpanded(0)
+      , mClusterNodesExpanded(0)
+      , mCacheHits(0)
+      , mCacheMisses(0)
+      , mUsedCorridor(false)
+      , mPathCost(0.0f)
+      , mSearchTimeMs(0.0)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned HierarchicalPathfinder::Statistics::GetTotalNodesExpanded() const
+   {
+      return mAbstractNodesExpanded + mPortalNodesExpanded + mClusterNodesExpanded;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   /////////////////////////////////////////////////////////////////////////////
+   HierarchicalPathfinder::HierarchicalPathfinder(WaypointGraph& graph, unsigned clusterLevel)
+      : mGraph(&graph)
+      , mClusterLevel(std::max(clusterLevel, 1U))
+      , mUseCorridor(true)
+   {
+      mGraph->AddChangeListener(*this);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   HierarchicalPathfinder::~HierarchicalPathfinder()
+   {
+      mGraph->RemoveChangeListener(*this);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::SetClusterLevel(unsigned level)
+   {
+      mClusterLevel = std::max(level, 1U);
+      ClearCache();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned HierarchicalPathfinder::GetClusterLevel() const
+   {
+      return mClusterLevel;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::SetUseCorridor(bool useCorridor)
+   {
+      mUseCorridor = useCorridor;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool HierarchicalPathfinder::GetUseCorridor() const
+   {
+      return mUseCorridor;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::ClearCache()
+   {
+      mClusters.clear();
+      mWaypointClusters.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned HierarchicalPathfinder::GetNumCachedPaths() const
+   {
+      unsigned total = 0;
+      for (ClusterMap::const_iterator i = mClusters.begin(), iend = mClusters.end(); i != iend; ++i)
+      {
+         total += unsigned(i->second.mTrees.size());
+      }
+      return total;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const HierarchicalPathfinder::Statistics& HierarchicalPathfinder::GetLastStatistics() const
+   {
+      return mStatistics;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::OnWaypointChanged(WaypointID id)
+   {
+      InvalidateCluster(GetClusterID(id));
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::OnEdgeChanged(WaypointID idFrom, WaypointID /*idTo*/)
+   {
+      // the edge changes the paths inside the cluster it starts from, or which of its waypoints are portals
+      InvalidateCluster(GetClusterID(idFrom));
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::OnSearchGraphChanged()
+   {
+      ClearCache();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   PathFindResult HierarchicalPathfinder::FindPath(WaypointID from, WaypointID to, WaypointGraph::ConstWaypointArray& result)
+   {
+      const dtCore::Timer& timer = *dtCore::Timer::Instance();
+      dtCore::Timer_t start = timer.Tick();
+
+      mStatistics = Statistics();
+      result.clear();
+
+      const WaypointInterface* fromWp = mGraph->FindWaypoint(from);
+      const WaypointInterface* toWp = mGraph->FindWaypoint(to);
+      if (fromWp == NULL || toWp == NULL || mGraph->GetSearchLevelNum(from) != 0 || mGraph->GetSearchLevelNum(to) != 0)
+      {
+         return NO_PATH;
+      }
+
+      PathFindResult pathResult = NO_PATH;
+      if (from == to)
+      {
+         result.push_back(fromWp);
+         pathResult = PATH_FOUND;
+      }
+      else
+      {
+         IDSet corridor;
+         if (mUseCorridor && PlanCorridor(from, to, corridor))
+         {
+            pathResult = SearchPortals(from, to, &corridor, result);
+            mStatistics.mUsedCorridor = pathResult != NO_PATH;
+         }
+
+         if (pathResult == NO_PATH)
+         {
+            pathResult = SearchPortals(from, to, NULL, result);
+         }
+      }
+
+      mStatistics.mSearchTimeMs = timer.DeltaMil(start, timer.Tick());
+      return pathResult;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   WaypointID HierarchicalPathfinder::GetClusterID(WaypointID id)
+   {
+      dtUtil::HashMap<WaypointID, WaypointID>::const_iterator found = mWaypointClusters.find(id);
+      if (found != mWaypointClusters.end())
+      {
+         return found->second;
+      }
+
+      // a waypoint without a parent is a cluster by itself
+      WaypointID clusterID = id;
+
+      const WaypointCollection* wc = mGraph->FindCollection(id);
+      if (wc != NULL)
+      {
+         for (unsigned level = 1; level < mClusterLevel; ++level)
+         {
+            const WaypointCollection* parent = GetTreeParent(*wc);
+            if (parent == NULL)
+            {
+               break;
+            }
+            wc = parent;
+         }
+         clusterID = wc->GetID();
+      }
+
+      mWaypointClusters.insert(std::make_pair(id, clusterID));
+      return clusterID;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   HierarchicalPathfinder::Cluster& HierarchicalPathfinder::GetCluster(WaypointID clusterID)
+   {
+      ClusterMap::iterator found = mClusters.find(clusterID);
+      if (found != mClusters.end())
+      {
+         return found->second;
+      }
+
+      Cluster& cluster = mClusters[clusterID];
+
+      const WaypointCollection* wc = NULL;
+      if (mGraph->GetSearchLevelNum(clusterID) > 0)
+      {
+         wc = mGraph->FindCollection(clusterID);
+      }
+
+      if (wc != NULL)
+      {
+         if (wc->degree() > 0)
+         {
+            WaypointGraph::ConstWaypointArray leaves;
+            mGraph->GetLeavesUnderParent(wc, leaves);
+
+            for (unsigned i = 0; i < leaves.size(); ++i)
+            {
+               // removed waypoints are left in their collections
+               if (mGraph->FindWaypoint(leaves[i]->GetID()) == leaves[i])
+               {
+                  cluster.mMembers.push_back(leaves[i]->GetID());
+               }
+            }
+         }
+      }
+      else if (mGraph->Contains(clusterID))
+      {
+         cluster.mMembers.push_back(clusterID);
+      }
+
+      WaypointGraph::ConstWaypointArray edges;
+      for (unsigned i = 0; i < cluster.mMembers.size(); ++i)
+      {
+         WaypointID member = cluster.mMembers[i];
+         mWaypointClusters[member] = clusterID;
+
+         edges.clear();
+         mGraph->GetAllEdgesFromWaypoint(member, edges);
+         for (unsigned j = 0; j < edges.size(); ++j)
+         {
+            WaypointID neighbor = edges[j]->GetID();
+            if (mGraph->Contains(neighbor) && GetClusterID(neighbor) != clusterID)
+            {
+               cluster.mPortals.push_back(member);
+               break;
+            }
+         }
+      }
+
+      return cluster;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const HierarchicalPathfinder::ClusterTree& HierarchicalPathfinder::GetTree(WaypointID clusterID, WaypointID source)
+   {
+      Cluster& cluster = GetCluster(clusterID);
+
+      dtUtil::HashMap<WaypointID, ClusterTree>::const_iterator found = cluster.mTrees.find(source);
+      if (found != cluster.mTrees.end())
+      {
+         ++mStatistics.mCacheHits;
+         return found->second;
+      }
+
+      ++mStatistics.mCacheMisses;
+
+      // dijkstra from the source, never leaving the cluster
+      ClusterTree& tree = cluster.mTrees[source];
+      TreeEntry sourceEntry = { 0.0f, source };
+      tree.insert(std::make_pair(source, sourceEntry));
+
+      OpenList open;
+      open.push(OpenEntry(0.0f, 0.0f, source));
+
+      WaypointGraph::ConstWaypointArray edges;
+      while (!open.empty())
+      {
+         OpenEntry current = open.top();
+         open.pop();
+
+         if (current.mG > tree[current.mID].mCost)
+         {
+            continue;
+         }
+
+         ++mStatistics.mClusterNodesExpanded;
+
+         const WaypointInterface* currentWp = mGraph->FindWaypoint(current.mID);
+         edges.clear();
+         mGraph->GetAllEdgesFromWaypoint(current.mID, edges);
+
+         for (unsigned i = 0; i < edges.size(); ++i)
+         {
+            WaypointID neighbor = edges[i]->GetID();
+            if (!mGraph->Contains(neighbor) || GetClusterID(neighbor) != clusterID)
+            {
+               continue;
+            }
+
+            float cost = current.mG + Distance(*currentWp, *edges[i]);
+            ClusterTree::iterator entry = tree.find(neighbor);
+            if (entry == tree.end() || cost < entry->second.mCost)
+            {
+               TreeEntry newEntry = { cost, current.mID };
+               tree[neighbor] = newEntry;
+               open.push(OpenEntry(cost, cost, neighbor));
+            }
+         }
+      }
+
+      return tree;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void HierarchicalPathfinder::InvalidateCluster(WaypointID clusterID)
+   {
+      ClusterMap::iterator found = mClusters.find(clusterID);
+      if (found != mClusters.end())
+      {
+         const std::vector<WaypointID>& members = found->second.mMembers;
+         for (unsigned i = 0; i < members.size(); ++i)
+         {
+            mWaypointClusters.erase(members[i]);
+         }
+         mClusters.erase(found);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool HierarchicalPathfinder::PlanCorridor(WaypointID from, WaypointID to, IDSet& corridor)
+   {
+      WaypointID fromCluster = GetClusterID(from);
+      WaypointID toCluster = GetClusterID(to);
+
+      if (fromCluster == toCluster)
+      {
+         corridor[fromCluster] = true;
+         return true;
+      }
+
+      const WaypointCollection* common = mGraph->FindCommonParent(from, to);
+      if (common == NULL)
+      {
+         return false;
+      }
+
+      int commonLevel = mGraph->GetSearchLevelNum(common->GetID());
+      if (commonLevel <= int(mClusterLevel))
+      {
+         // the clusters are the tops of their trees, there is nothing above them to plan on
+         return false;
+      }
+
+      std::vector<const WaypointCollection*> fromChain, toChain;
+      GetAncestors(*mGraph, from, fromChain);
+      GetAncestors(*mGraph, to, toChain);
+
+      if (fromChain.size() < unsigned(commonLevel) || toChain.size() < unsigned(commonLevel))
+      {
+         return false;
+      }
+
+      // plan from the top down, each level only searching the children of the path on the level above
+      IDSet allowed;
+      allowed[common->GetID()] = true;
+
+      for (int level = commonLevel - 1; level >= int(mClusterLevel); --level)
+      {
+         IDSet path;
+         if (!PlanCollections(fromChain[level - 1]->GetID(), toChain[level - 1]->GetID(), allowed, path))
+         {
+            return false;
+         }
+         allowed.swap(path);
+      }
+
+      corridor.swap(allowed);
+      return true;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool HierarchicalPathfinder::PlanCollections(WaypointID from, WaypointID to, const IDSet& allowedParents, IDSet& result)
+   {
+      const WaypointInterface* toWp = mGraph->FindWaypoint(to);
+
+      LabelMap labels;
+      OpenList open;
+      Relax(labels, open, from, from, 0.0f, Distance(*mGraph->FindWaypoint(from), *toWp), false);
+
+      WaypointGraph::ConstWaypointArray edges;
+      while (!open.empty())
+      {
+         OpenEntry current = open.top();
+         open.pop();
+
+         SearchLabel& label = labels[current.mID];
+         if (label.mClosed || current.mG > label.mG)
+         {
+            continue;
+         }
+
+         if (current.mID == to)
+         {
+            WaypointID id = to;
+            result[id] = true;
+            while (id != from)
+            {
+               id = labels[id].mParent;
+               result[id] = true;
+            }
+            return true;
+         }
+
+         label.mClosed = true;
+         ++mStatistics.mAbstractNodesExpanded;
+
+         const WaypointInterface* currentWp = mGraph->FindWaypoint(current.mID);
+         edges.clear();
+         mGraph->GetAllEdgesFromWaypoint(current.mID, edges);
+
+         for (unsigned i = 0; i < edges.size(); ++i)
+         {
+            const WaypointCollection* neighbor = mGraph->FindCollection(edges[i]->GetID());
+            const WaypointCollection* parent = neighbor != NULL ? GetTreeParent(*neighbor) : NULL;
+            if (parent == NULL || allowedParents.find(parent->GetID()) == allowedParents.end())
+            {
+               continue;
+            }
+
+            Relax(labels, open, neighbor->GetID(), current.mID, current.mG + Distance(*currentWp, *neighbor),
+                     Distance(*neighbor, *toWp), false);
+         }
+      }
+
+      return false;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   PathFindResult HierarchicalPathfinder::SearchPortals(WaypointID from, WaypointID to, const IDSet* corridor,
+            WaypointGraph::ConstWaypointArray& result)
+   {
+      const WaypointInterface* toWp = mGraph->FindWaypoint(to);
+      WaypointID toCluster = GetClusterID(to);
+
+      LabelMap labels;
+      OpenList open;
+      Relax(labels, open, from, from, 0.0f, Distance(*mGraph->FindWaypoint(from), *toWp), false);
+
+      bool found = false;
+      WaypointGraph::ConstWaypointArray edges;
+      while (!open.empty() && !found)
+      {
+         OpenEntry current = open.top();
+         open.pop();
+
+         SearchLabel& label = labels[current.mID];
+         if (label.mClosed || current.mG > label.mG)
+         {
+            continue;
+         }
+
+         if (current.mID == to)
+         {
+            found = true;
+            continue;
+         }
+
+         label.mClosed = true;
+         ++mStatistics.mPortalNodesExpanded;
+
+         WaypointID currentCluster = GetClusterID(current.mID);
+         const WaypointInterface* currentWp = mGraph->FindWaypoint(current.mID);
+
+         // a node reached from inside its cluster already had all the portals of the cluster relaxed from where it was reached
+         if (!label.mInside)
+         {
+            const ClusterTree& tree = GetTree(currentCluster, current.mID);
+            const std::vector<WaypointID>& portals = GetCluster(currentCluster).mPortals;
+
+            for (unsigned i = 0; i < portals.size(); ++i)
+            {
+               ClusterTree::const_iterator entry = tree.find(portals[i]);
+               if (portals[i] != current.mID && entry != tree.end())
+               {
+                  Relax(labels, open, portals[i], current.mID, current.mG + entry->second.mCost,
+                           Distance(*mGraph->FindWaypoint(portals[i]), *toWp), true);
+               }
+            }
+
+            if (currentCluster == toCluster)
+            {
+               ClusterTree::const_iterator entry = tree.find(to);
+               if (entry != tree.end())
+               {
+                  Relax(labels, open, to, current.mID, current.mG + entry->second.mCost, 0.0f, true);
+               }
+            }
+         }
+
+         // only the edges out of the cluster are followed, the ones inside are covered by the cached paths
+         edges.clear();
+         mGraph->GetAllEdgesFromWaypoint(current.mID, edges);
+
+         for (unsigned i = 0; i < edges.size(); ++i)
+         {
+            WaypointID neighbor = edges[i]->GetID();
+            if (!mGraph->Contains(neighbor))
+            {
+               continue;
+            }
+
+            WaypointID neighborCluster = GetClusterID(neighbor);
+            if (neighborCluster == currentCluster ||
+                     (corridor != NULL && corridor->find(neighborCluster) == corridor->end()))
+            {
+               continue;
+            }
+
+            Relax(labels, open, neighbor, current.mID, current.mG + Distance(*currentWp, *edges[i]),
+                     Distance(*edges[i], *toWp), false);
+         }
+      }
+
+      if (!found)
+      {
+         return NO_PATH;
+      }
+
+      mStatistics.mPathCost = labels.find(to)->second.mG;
+
+      // walk back from the goal, filling in the paths inside each cluster from the cached trees
+      std::vector<WaypointID> reversed;
+      WaypointID id = to;
+      while (id != from)
+      {
+         const SearchLabel& label = labels.find(id)->second;
+         if (label.mInside)
+         {
+            const ClusterTree& tree = GetTree(GetClusterID(label.mParent), label.mParent);
+            while (id != label.mParent)
+            {
+               reversed.push_back(id);
+               id = tree.find(id)->second.mParent;
+            }
+         }
+         else
+         {
+            reversed.push_back(id);
+            id = label.mParent;
+         }
+      }
+      reversed.push_back(from);
+
+      result.reserve(reversed.size());
+      for (std::vector<WaypointID>::reverse_iterator i = reversed.rbegin(), iend = reversed.rend(); i != iend; ++i)
+      {
+         result.push_back(mGraph->FindWaypoint(*i));
+      }
+
+      return PATH_FOUND;
+   }
+
+} // namespace dtAI
@@ -0,0 +1,477 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <dtAI/pathquerycomponent.h>
+#include <dtAI/aiactorregistry.h>
+#include <dtAI/aiinterfaceactor.h>
+#include <dtAI/aiplugininterface.h>
+#include <dtAI/waypointgraph.h>
+#include <dtAI/waypointgraphsnapshot.h>
+
+#include <dtGame/gamemanager.h>
+#include <dtGame/message.h>
+#include <dtGame/messagetype.h>
+#include <dtUtil/threadpool.h>
+
+#include <OpenThreads/Atomic>
+
+#include <algorithm>
+#include <limits>
+
+namespace dtAI
+{
+   const dtCore::RefPtr<dtCore::SystemComponentType> PathQueryComponent::TYPE(new dtCore::SystemComponentType("PathQueryComponent","GMComponents",
+         "Searches for paths on the waypoint graph in the background.", dtGame::GMComponent::BaseGMComponentType));
+   const std::string PathQueryComponent::DEFAULT_NAME(TYPE->GetName());
+
+   const PathQueryHandle PathQueryComponent::INVALID_HANDLE = 0;
+
+   /////////////////////////////////////////////////////////////
+   PathQueryConfig::PathQueryConfig()
+   : mMaxNodesExplored(std::numeric_limits<unsigned>::max())
+   , mMaxCost(std::numeric_limits<float>::max())
+   , mMaxDepth(std::numeric_limits<unsigned>::max())
+   {
+   }
+
+   /////////////////////////////////////////////////////////////
+   PathQueryResult::PathQueryResult()
+   : mHandle(PathQueryComponent::INVALID_HANDLE)
+   , mFrom(0)
+   , mTo(0)
+   , mResult(NO_PATH)
+   , mCost(0.0f)
+   , mNodesExplored(0)
+   , mWaitTimeMs(0.0)
+   , mSearchTimeMs(0.0)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////
+   /////////////////////////////////////////////////////////////
+   /**
+    * The queries started on one tick.  The tasks take the next query from the batch until they run out,
+    * so a few long searches don't leave the other workers idle.
+    */
+   class PathQueryBatch : public osg::Referenced
+   {
+   public:
+      PathQueryBatch()
+      : mNextQuery(0)
+      {
+      }
+
+      dtCore::RefPtr<const WaypointGraphSnapshot> mSnapshot;
+      std::vector<PathQueryConfig> mConfigs;
+      std::vector<dtCore::Timer_t> mSubmitTimes;
+      std::vector<PathQueryResult> mResults;
+
+      OpenThreads::Atomic mNextQuery;
+   };
+
+   /////////////////////////////////////////////////////////////
+   /////////////////////////////////////////////////////////////
+   /**
+    * Searches queries from a batch.  The task keeps its astar so the node memory is reused between batches.
+    * The batch is done once the wait block of every task has been released.
+    */
+   class PathQueryTask : public dtUtil::ThreadPoolTask
+   {
+   public:
+      virtual void operator () ()
+      {
+         PathQueryBatch& batch = *mBatch;
+         const dtCore::Timer& timer = *dtCore::Timer::Instance();
+
+         mAStar.SetSnapshot(batch.mSnapshot.get());
+
+         unsigned numQueries = unsigned(batch.mResults.size());
+         unsigned i = 0;
+         while ((i = (++batch.mNextQuery) - 1U) < numQueries)
+         {
+            PathQueryResult& result = batch.mResults[i];
+            const PathQueryConfig& config = batch.mConfigs[i];
+
+            dtCore::Timer_t start = timer.Tick();
+            result.mWaitTimeMs = timer.DeltaMil(batch.mSubmitTimes[i], start);
+
+            WaypointSnapshotAStar::config_type& astarConfig = mAStar.GetConfig();
+            astarConfig.mMaxNodesExplored = config.mMaxNodesExplored;
+            astarConfig.mMaxCost = config.mMaxCost;
+            astarConfig.mMaxDepth = config.mMaxDepth;
+
+            result.mResult = mAStar.FindSingleLevelPath(result.mFrom, result.mTo, result.mPath);
+            result.mCost = result.mResult != NO_PATH ? astarConfig.mTotalCost : 0.0f;
+            result.mNodesExplored = astarConfig.mNodesExplored;
+            result.mSearchTimeMs = timer.DeltaMil(start, timer.Tick());
+         }
+
+         mAStar.SetSnapshot(NULL);
+      }
+
+      dtCore::RefPtr<PathQueryBatch> mBatch;
+      WaypointSnapshotAStar mAStar;
+   };
+
+   /////////////////////////////////////////////////////////////
+   /////////////////////////////////////////////////////////////
+   PathQueryComponent::PathQueryComponent(dtCore::SystemComponentType& type)
+   : dtGame::GMComponent(type)
+   , mNextHandle(INVALID_HANDLE + 1)
+   , mMaxWorkers(0)
+   , mNumCompleted(0)
+   , mTotalSearchTimeMs(0.0)
+   , mMaxSearchTimeMs(0.0)
+   , mTotalLatencyMs(0.0)
+   {
+      SetName(DEFAULT_NAME);
+   }
+
+   /////////////////////////////////////////////////////////////
+   PathQueryComponent::~PathQueryComponent()
+   {
+      WaitForQueries();
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::OnRemovedFromGM()
+   {
+      dtGame::GMComponent::OnRemovedFromGM();
+      CleanUp();
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::CleanUp()
+   {
+      WaitForQueries();
+      mBatch = NULL;
+      mQueue.clear();
+      mInFlight.clear();
+      mCanceled.clear();
+      mSnapshot = NULL;
+      mWaypointGraph = NULL;
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::ProcessMessage(const dtGame::Message& message)
+   {
+      if (message.GetMessageType() == dtGame::MessageType::TICK_LOCAL)
+      {
+         TickLocal();
+      }
+      else if (message.GetMessageType() == dtGame::MessageType::INFO_MAP_LOADED)
+      {
+         if (!mWaypointGraph.valid())
+         {
+            dtAI::AIInterfaceActor* aiInterface = NULL;
+            GetGameManager()->FindActorByType(*dtAI::AIActorRegistry::AI_INTERFACE_ACTOR_TYPE, aiInterface);
+            if (aiInterface != NULL && aiInterface->GetAIInterface() != NULL)
+            {
+               SetWaypointGraph(&aiInterface->GetAIInterface()->GetWaypointGraph());
+            }
+         }
+      }
+      else if (message.GetMessageType() == dtGame::MessageType::INFO_MAP_UNLOADED)
+      {
+         CleanUp();
+      }
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::SetWaypointGraph(const WaypointGraph* graph)
+   {
+      mWaypointGraph = graph;
+      RefreshSnapshot();
+   }
+
+   /////////////////////////////////////////////////////////////
+   const WaypointGraph* PathQueryComponent::GetWaypointGraph() const
+   {
+      return mWaypointGraph.get();
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::RefreshSnapshot()
+   {
+      if (mWaypointGraph.valid())
+      {
+         mSnapshot = new WaypointGraphSnapshot(*mWaypointGraph);
+      }
+      else
+      {
+         mSnapshot = NULL;
+      }
+   }
+
+   /////////////////////////////////////////////////////////////
+   const WaypointGraphSnapshot* PathQueryComponent::GetSnapshot() const
+   {
+      return mSnapshot.get();
+   }
+
+   /////////////////////////////////////////////////////////////
+   PathQueryHandle PathQueryComponent::SubmitQuery(WaypointID from, WaypointID to, PathQueryCallback callback,
+            const PathQueryConfig& config)
+   {
+      PendingQuery query;
+      query.mHandle = mNextHandle++;
+      if (mNextHandle == INVALID_HANDLE)
+      {
+         ++mNextHandle;
+      }
+      query.mFrom = from;
+      query.mTo = to;
+      query.mConfig = config;
+      query.mCallback = callback;
+      query.mSubmitTime = dtCore::Timer::Instance()->Tick();
+
+      mQueue.push_back(query);
+      return query.mHandle;
+   }
+
+   /////////////////////////////////////////////////////////////
+   bool PathQueryComponent::CancelQuery(PathQueryHandle handle)
+   {
+      for (std::deque<PendingQuery>::iterator i = mQueue.begin(), iend = mQueue.end(); i != iend; ++i)
+      {
+         if (i->mHandle == handle)
+         {
+            mQueue.erase(i);
+            return true;
+         }
+      }
+
+      if (IsQueryPending(handle))
+      {
+         mCanceled.push_back(handle);
+         return true;
+      }
+
+      return false;
+   }
+
+   /////////////////////////////////////////////////////////////
+   bool PathQueryComponent::IsQueryPending(PathQueryHandle handle) const
+   {
+      for (std::deque<PendingQuery>::const_iterator i = mQueue.begin(), iend = mQueue.end(); i != iend; ++i)
+      {
+         if (i->mHandle == handle)
+         {
+            return true;
+         }
+      }
+
+      for (std::vector<PendingQuery>::const_iterator i = mInFlight.begin(), iend = mInFlight.end(); i != iend; ++i)
+      {
+         if (i->mHandle == handle)
+         {
+            return std::find(mCanceled.begin(), mCanceled.end(), handle) == mCanceled.end();
+         }
+      }
+
+      return false;
+   }
+
+   /////////////////////////////////////////////////////////////
+   unsigned PathQueryComponent::GetQueueDepth() const
+   {
+      return unsigned(mQueue.size());
+   }
+
+   /////////////////////////////////////////////////////////////
+   unsigned PathQueryComponent::GetNumQueriesInFlight() const
+   {
+      return unsigned(mInFlight.size());
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::SetMaxWorkers(unsigned maxWorkers)
+   {
+      mMaxWorkers = maxWorkers;
+   }
+
+   /////////////////////////////////////////////////////////////
+   unsigned PathQueryComponent::GetMaxWorkers() const
+   {
+      return mMaxWorkers;
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::WaitForQueries()
+   {
+      if (!mBatch.valid())
+      {
+         return;
+      }
+
+      for (unsigned i = 0; i < mTasks.size(); ++i)
+      {
+         mTasks[i]->WaitUntilComplete();
+      }
+   }
+
+   /////////////////////////////////////////////////////////////
+   unsigned PathQueryComponent::GetNumQueriesCompleted() const
+   {
+      return mNumCompleted;
+   }
+
+   /////////////////////////////////////////////////////////////
+   double PathQueryComponent::GetAverageSearchTimeMs() const
+   {
+      return mNumCompleted > 0 ? mTotalSearchTimeMs / double(mNumCompleted) : 0.0;
+   }
+
+   /////////////////////////////////////////////////////////////
+   double PathQueryComponent::GetMaxSearchTimeMs() const
+   {
+      return mMaxSearchTimeMs;
+   }
+
+   /////////////////////////////////////////////////////////////
+   double PathQueryComponent::GetAverageLatencyMs() const
+   {
+      return mNumCompleted > 0 ? mTotalLatencyMs / double(mNumCompleted) : 0.0;
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::ResetStatistics()
+   {
+      mNumCompleted = 0;
+      mTotalSearchTimeMs = 0.0;
+      mMaxSearchTimeMs = 0.0;
+      mTotalLatencyMs = 0.0;
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::TickLocal()
+   {
+      DeliverResults();
+      StartBatch();
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::DeliverResults()
+   {
+      if (!mBatch.valid())
+      {
+         return;
+      }
+
+      // The pool releases a task after it returns, so a task isn't done with the batch, and can't be added
+      // for the next one, until then.  The tasks that weren't used for this batch are already released.
+      for (unsigned i = 0; i < mTasks.size(); ++i)
+      {
+         if (!mTasks[i]->WaitUntilComplete(0))
+         {
+            return;
+         }
+      }
+
+      // The callbacks may submit or cancel queries, so take everything about this batch off of the component first.
+      dtCore::RefPtr<PathQueryBatch> batch = mBatch;
+      mBatch = NULL;
+      std::vector<PendingQuery> delivered;
+      delivered.swap(mInFlight);
+      std::vector<PathQueryHandle> canceled;
+      canceled.swap(mCanceled);
+      for (unsigned i = 0; i < mTasks.size(); ++i)
+      {
+         mTasks[i]->mBatch = NULL;
+      }
+
+      const dtCore::Timer& timer = *dtCore::Timer::Instance();
+      dtCore::Timer_t now = timer.Tick();
+
+      for (unsigned i = 0; i < delivered.size(); ++i)
+      {
+         const PendingQuery& query = delivered[i];
+         const PathQueryResult& result = batch->mResults[i];
+
+         ++mNumCompleted;
+         mTotalSearchTimeMs += result.mSearchTimeMs;
+         mMaxSearchTimeMs = std::max(mMaxSearchTimeMs, result.mSearchTimeMs);
+         mTotalLatencyMs += timer.DeltaMil(query.mSubmitTime, now);
+
+         if (query.mCallback.valid() && std::find(canceled.begin(), canceled.end(), query.mHandle) == canceled.end())
+         {
+            query.mCallback(result);
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryComponent::StartBatch()
+   {
+      if (mBatch.valid() || mQueue.empty())
+      {
+         return;
+      }
+
+      mInFlight.assign(mQueue.begin(), mQueue.end());
+      mQueue.clear();
+
+      unsigned numQueries = unsigned(mInFlight.size());
+      bool background = dtUtil::ThreadPool::IsInitialized();
+
+      unsigned numTasks = 1;
+      if (background)
+      {
+         numTasks = mMaxWorkers > 0 ? mMaxWorkers : dtUtil::ThreadPool::GetNumBackgroundWorkerThreads();
+         numTasks = std::max(1U, std::min(numTasks, numQueries));
+      }
+
+      mBatch = new PathQueryBatch;
+      mBatch->mSnapshot = mSnapshot;
+      mBatch->mConfigs.resize(numQueries);
+      mBatch->mSubmitTimes.resize(numQueries);
+      mBatch->mResults.resize(numQueries);
+      for (unsigned i = 0; i < numQueries; ++i)
+      {
+         const PendingQuery& query = mInFlight[i];
+         mBatch->mConfigs[i] = query.mConfig;
+         mBatch->mSubmitTimes[i] = query.mSubmitTime;
+
+         PathQueryResult& result = mBatch->mResults[i];
+         result.mHandle = query.mHandle;
+         result.mFrom = query.mFrom;
+         result.mTo = query.mTo;
+      }
+
+      while (mTasks.size() < numTasks)
+      {
+         mTasks.push_back(new PathQueryTask);
+      }
+
+      for (unsigned i = 0; i < numTasks; ++i)
+      {
+         mTasks[i]->mBatch = mBatch;
+         if (background)
+         {
+            dtUtil::ThreadPool::AddTask(*mTasks[i], dtUtil::ThreadPool::BACKGROUND);
+         }
+         else
+         {
+            (*mTasks[i])();
+         }
+      }
+   }
+
+} // namespace dtAI
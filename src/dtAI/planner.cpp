@@ -28,40 +28,43 @@ namespace dtAI
    Planner::Planner()
       : mHelper(0)
       , mConfig()
+      , mNumNodesUsed(0)
+      , mNumNodesOpened(0)
+      , mNumNodesExpanded(0)
    {
    }
 
    Planner::~Planner()
    {
       FreeMem();
+      TrimNodePool();
    }
 
-   struct PlannerDeleteFunc
-   {
-      template<class _Type>
-         void operator()(_Type p1)
-      {
-         delete p1->mState;
-         delete p1;
-      }
-   };
-
    void Planner::FreeMem()
    {
-      std::for_each(mOpen.begin(), mOpen.end(), PlannerDeleteFunc());
+      // The nodes stay in the pool, only the search is forgotten.
       mOpen.clear();
+      mClosed.clear();
+      mNumNodesUsed = 0;
+      mNumNodesOpened = 0;
+      mNumNodesExpanded = 0;
       mConfig.mResult.clear();
    }
 
+   void Planner::TrimNodePool()
+   {
+      for (unsigned i = mNumNodesUsed; i < mNodePool.size(); ++i)
+      {
+         delete mNodePool[i];
+      }
+      mNodePool.resize(mNumNodesUsed);
+   }
+
    void Planner::Reset(const PlannerConfig& pConfig)
    {
       FreeMem();
       mConfig = pConfig;
-
-      PlannerNodeLink* pNodeLink = new PlannerNodeLink();
-      pNodeLink->mState = new WorldState(*mHelper->GetCurrentState());
-
-      mOpen.push_back(pNodeLink);
+      OpenRootNode();
    }
 
 
@@ -69,41 +72,61 @@ namespace dtAI
    {
       FreeMem();
       mHelper = pHelper;
-
-      PlannerNodeLink* pNodeLink = new PlannerNodeLink();
-      pNodeLink->mState = new WorldState(*mHelper->GetCurrentState());
-
-      mOpen.push_back(pNodeLink);
+      OpenRootNode();
    }
 
-   const PlannerNodeLink* Planner::FindLowestCost()
+   void Planner::OpenRootNode()
    {
-      PlannerContainer::const_iterator iter = mOpen.begin();
-      PlannerContainer::const_iterator endOfList = mOpen.end();
-
-      const PlannerNodeLink* pLowest = *iter;
+      PlannerNode* pNode = AllocateNode();
+      pNode->mState = *mHelper->GetCurrentState();
+      pNode->mHash = pNode->mState.GetHash();
+      PushOpen(pNode);
+   }
 
-      while (iter != endOfList)
+   Planner::PlannerNode* Planner::AllocateNode()
+   {
+      if (mNumNodesUsed == mNodePool.size())
       {
-         const PlannerNodeLink* pNLIter = (*iter);
-         if (pNLIter->operator<(*pLowest))
-         {
-            pLowest = pNLIter;
-         }
-         ++iter;
+         mNodePool.push_back(new PlannerNode());
       }
 
-      return pLowest;
+      PlannerNode* pNode = mNodePool[mNumNodesUsed++];
+      pNode->mLink = PlannerNodeLink();
+      pNode->mLink.mState = &pNode->mState;
+      return pNode;
+   }
+
+   void Planner::ReleaseLastNode()
+   {
+      --mNumNodesUsed;
    }
 
-   void Planner::Remove(const PlannerNodeLink* pNodeLink)
+   void Planner::PushOpen(PlannerNode* pNode)
    {
-      mOpen.remove(pNodeLink);
+      pNode->mOrder = mNumNodesOpened++;
+      mOpen.push_back(pNode);
+      std::push_heap(mOpen.begin(), mOpen.end(), PlannerNodeCompare());
    }
 
-   bool Planner::Contains(PlannerNodeLink* pNodeLink)
+   Planner::PlannerNode* Planner::PopOpen()
    {
-      return std::find(mOpen.begin(), mOpen.end(), pNodeLink) != mOpen.end();
+      std::pop_heap(mOpen.begin(), mOpen.end(), PlannerNodeCompare());
+      PlannerNode* pNode = mOpen.back();
+      mOpen.pop_back();
+      return pNode;
+   }
+
+   bool Planner::IsClosed(const PlannerNode* pNode) const
+   {
+      std::pair<ClosedSet::const_iterator, ClosedSet::const_iterator> range = mClosed.equal_range(pNode->mHash);
+      for (ClosedSet::const_iterator iter = range.first; iter != range.second; ++iter)
+      {
+         if (iter->second->mState == pNode->mState)
+         {
+            return true;
+         }
+      }
+      return false;
    }
 
    std::list<const Operator*> Planner::GetPlan() const
@@ -113,7 +136,7 @@ namespace dtAI
 
    std::vector<const Operator*> Planner::GetPlanAsVector() const
    {
-      return OperatorVector(GetPlan().begin(), GetPlan().end());
+      return OperatorVector(mConfig.mResult.begin(), mConfig.mResult.end());
    }
 
    PlannerConfig& Planner::GetConfig()
@@ -141,21 +164,6 @@ namespace dtAI
       return true;
    }
 
-   void Planner::GetTraversableStates(const WorldState* pCurrentState, const std::list<Operator*>& pOperators, std::list<Operator*>& pOperatorListIn)
-   {
-      std::list<Operator*>::const_iterator iter = pOperators.begin();
-      std::list<Operator*>::const_iterator endOfList = pOperators.end();
-      while (iter != endOfList)
-      {
-         if (CanApplyOperator(*iter, pCurrentState))
-         {
-            pOperatorListIn.push_back(*iter);
-         }
-         ++iter;
-      }
-
-   }
-
    Planner::PlannerResult Planner::GeneratePlan()
    {
       mConfig.mTimer.Update();
@@ -171,7 +179,15 @@ namespace dtAI
          mConfig.mCurrentElapsedTime += mConfig.mTimer.GetDT();
          mConfig.mTimer.Update();
 
-         const PlannerNodeLink* pCurrent = FindLowestCost();
+         PlannerNode* pCurrentNode = PopOpen();
+
+         // A cheaper path to the same state was already searched.
+         if (IsClosed(pCurrentNode))
+         {
+            continue;
+         }
+
+         const PlannerNodeLink* pCurrent = &pCurrentNode->mLink;
 
          bool pReachedGoal = mHelper->IsDesiredState(pCurrent->mState);
 
@@ -192,30 +208,39 @@ namespace dtAI
          }
          else
          {
-            Remove(pCurrent);
-
-            std::list<Operator*> pTraverse;
-            GetTraversableStates(pCurrent->mState, mHelper->GetOperators(), pTraverse);
+            mClosed.insert(std::make_pair(pCurrentNode->mHash, pCurrentNode));
+            ++mNumNodesExpanded;
 
-            std::list<Operator*>::iterator iter = pTraverse.begin();
-            std::list<Operator*>::iterator endOfList = pTraverse.end();
+            const PlannerHelper::OperatorList& operators = mHelper->GetOperators();
+            PlannerHelper::OperatorList::const_iterator iter = operators.begin();
+            PlannerHelper::OperatorList::const_iterator endOfList = operators.end();
 
-            while (iter != endOfList)
+            for (; iter != endOfList; ++iter)
             {
-               WorldState* pWS = new WorldState(*(pCurrent->mState));
-               PlannerNodeLink* pnl = new PlannerNodeLink();
-
-               (*iter)->Apply(pWS);
-
-               pnl->mOperator = *iter;
-               pnl->mState = pWS;
-               pnl->mParent = pCurrent;
-               pnl->mGCost = pWS->GetCost();
-               pnl->mHCost = mHelper->RemainingCost(pWS);
-
-               mOpen.push_back(pnl);
-
-               ++iter;
+               if (!CanApplyOperator(*iter, pCurrent->mState))
+               {
+                  continue;
+               }
+
+               PlannerNode* pNode = AllocateNode();
+               pNode->mState = pCurrentNode->mState;
+
+               (*iter)->Apply(&pNode->mState);
+
+               pNode->mHash = pNode->mState.GetHash();
+               if (IsClosed(pNode))
+               {
+                  ReleaseLastNode();
+                  continue;
+               }
+
+               PlannerNodeLink& pnl = pNode->mLink;
+               pnl.mOperator = *iter;
+               pnl.mParent = pCurrent;
+               pnl.mGCost = pNode->mState.GetCost();
+               pnl.mHCost = mHelper->RemainingCost(&pNode->mState);
+
+               PushOpen(pNode);
             }
 
          }
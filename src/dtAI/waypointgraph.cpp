@@ -429,6 +429,9 @@ namespace dtAI
 
       WaypointMap mWaypointOwnership;
       WaypointGraph::SearchLevelArray mSearchLevels;
+
+      //not cleared by CleanUp(), the listeners outlive a clear
+      std::vector<WaypointGraph::ChangeListener*> mListeners;
    };
 
 
@@ -456,6 +459,49 @@ namespace dtAI
    void WaypointGraph::Clear()
    {
       OnClear();
+      NotifySearchGraphChanged();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void WaypointGraph::AddChangeListener(ChangeListener& listener)
+   {
+      if (std::find(mImpl->mListeners.begin(), mImpl->mListeners.end(), &listener) == mImpl->mListeners.end())
+      {
+         mImpl->mListeners.push_back(&listener);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void WaypointGraph::RemoveChangeListener(ChangeListener& listener)
+   {
+      mImpl->mListeners.erase(std::remove(mImpl->mListeners.begin(), mImpl->mListeners.end(), &listener), mImpl->mListeners.end());
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void WaypointGraph::NotifyWaypointChanged(WaypointID id)
+   {
+      for (size_t i = 0; i < mImpl->mListeners.size(); ++i)
+      {
+         mImpl->mListeners[i]->OnWaypointChanged(id);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void WaypointGraph::NotifyEdgeChanged(WaypointID idFrom, WaypointID idTo)
+   {
+      for (size_t i = 0; i < mImpl->mListeners.size(); ++i)
+      {
+         mImpl->mListeners[i]->OnEdgeChanged(idFrom, idTo);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void WaypointGraph::NotifySearchGraphChanged()
+   {
+      for (size_t i = 0; i < mImpl->mListeners.size(); ++i)
+      {
+         mImpl->mListeners[i]->OnSearchGraphChanged();
+      }
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -503,6 +549,7 @@ namespace dtAI
                //by default all collections are entered in the first level,
                //this is for lazy creation on CreateSearchGraph(), or CreateSearchLevel()
                mImpl->InsertCollection(wc, 1);
+               NotifySearchGraphChanged();
             }
             else
             {
@@ -513,6 +560,7 @@ namespace dtAI
          {
             //passing in null will add with no parent
             mImpl->Insert(*waypoint, NULL);
+            NotifyWaypointChanged(waypoint->GetID());
          }
       }
       else //since we already have the waypoint, assume we are moving it,
@@ -524,6 +572,15 @@ namespace dtAI
          {
             wc->Recalculate();
          }
+
+         if(GetSearchLevelNum(waypoint->GetID()) == 0)
+         {
+            NotifyWaypointChanged(waypoint->GetID());
+         }
+         else
+         {
+            NotifySearchGraphChanged();
+         }
       }
    }
 
@@ -533,6 +590,7 @@ namespace dtAI
       if(!Contains(waypoint->GetID()))
       {
          mImpl->InsertCollection(waypoint, level);
+         NotifySearchGraphChanged();
       }
    }
 
@@ -543,7 +601,19 @@ namespace dtAI
 
       if(wpPtr != NULL)
       {
+         //listeners are told before a concrete waypoint goes, so they can still look it up
+         bool concrete = GetSearchLevelNum(waypoint) == 0;
+         if(concrete)
+         {
+            NotifyWaypointChanged(waypoint);
+         }
+
          RemoveWaypoint_Protected(wpPtr);
+
+         if(!concrete)
+         {
+            NotifySearchGraphChanged();
+         }
       }
    }
 
@@ -669,6 +739,12 @@ namespace dtAI
       if(wpLhs != NULL && wpRhs != NULL)
       {
          AddEdge_Protected(wpLhs, wpRhs);
+
+         //the edges above level 0 are generated from these, so only the concrete edges are reported
+         if(GetSearchLevelNum(pFrom) == 0 && GetSearchLevelNum(pTo) == 0)
+         {
+            NotifyEdgeChanged(pFrom, pTo);
+         }
       }
       else
       {
@@ -707,7 +783,13 @@ namespace dtAI
 
       if(wpLhs != NULL && wpRhs != NULL)
       {
-         return RemoveEdge_Protected(wpLhs, wpRhs);
+         bool removed = RemoveEdge_Protected(wpLhs, wpRhs);
+         //only the concrete edges are reported, the same as in AddEdge
+         if(removed && GetSearchLevelNum(wayFrom) == 0 && GetSearchLevelNum(wayTo) == 0)
+         {
+            NotifyEdgeChanged(wayFrom, wayTo);
+         }
+         return removed;
       }
       return false;
    }
@@ -741,7 +823,18 @@ namespace dtAI
 
       if(wpFrom != NULL)
       {
+         ConstWaypointArray edges;
+         if(GetSearchLevelNum(pFrom) == 0)
+         {
+            GetAllEdgesFromWaypoint_Protected(*wpFrom, edges);
+         }
+
          RemoveAllEdgesFromWaypoint_Protected(wpFrom);
+
+         for(size_t i = 0; i < edges.size(); ++i)
+         {
+            NotifyEdgeChanged(pFrom, edges[i]->GetID());
+         }
       }
    }
 
@@ -1074,6 +1167,7 @@ namespace dtAI
             wh.mParent = parentWp;
          }
 
+         NotifySearchGraphChanged();
          return true;
       }
 
@@ -1149,6 +1243,8 @@ namespace dtAI
             }
 
          }
+
+         NotifySearchGraphChanged();
       }
    }
 
@@ -42,14 +42,15 @@ namespace dtAI
 
    WaypointGraphNode* WaypointGraphAStar::CreateNode(WaypointGraphNode* pParent, const WaypointInterface* pWaypoint, float pGn, float pHn)
    {
+      // the nodes are built in the astar node pool, so their memory is reused by the next search
       WaypointGraphNode* wgn = NULL;
       if(mUseConstrainedSearch)
       {
-         wgn = new WaypointGraphNode(mWPGraph, *mSearchSpace, pParent, pWaypoint, pGn, pHn);
+         wgn = new (AllocateNode()) WaypointGraphNode(mWPGraph, *mSearchSpace, pParent, pWaypoint, pGn, pHn);
       }
       else
       {
-         wgn = new WaypointGraphNode(mWPGraph, pParent, pWaypoint, pGn, pHn);
+         wgn = new (AllocateNode()) WaypointGraphNode(mWPGraph, pParent, pWaypoint, pGn, pHn);
       }
 
       return wgn;
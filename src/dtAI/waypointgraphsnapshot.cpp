@@ -0,0 +1,151 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <dtAI/waypointgraphsnapshot.h>
+#include <dtAI/waypointgraph.h>
+#include <dtAI/waypointinterface.h>
+
+namespace dtAI
+{
+   /////////////////////////////////////////////////////////////////////////////
+   WaypointGraphSnapshot::WaypointGraphSnapshot(const WaypointGraph& graph)
+   {
+      mEdgeOffsets.push_back(0);
+
+      const WaypointGraph::SearchLevel* level = graph.GetSearchLevel(0);
+      if (level == NULL)
+      {
+         return;
+      }
+
+      const WaypointGraph::ConstWaypointArray& waypoints = level->mNodes;
+      unsigned numWaypoints = unsigned(waypoints.size());
+
+      mIDs.reserve(numWaypoints);
+      mPositions.reserve(numWaypoints);
+      mEdgeOffsets.reserve(numWaypoints + 1);
+
+      for (unsigned i = 0; i < numWaypoints; ++i)
+      {
+         mIDs.push_back(waypoints[i]->GetID());
+         mPositions.push_back(waypoints[i]->GetPosition());
+         mIndices.insert(std::make_pair(waypoints[i]->GetID(), i));
+      }
+
+      WaypointGraph::ConstWaypointArray edges;
+      for (unsigned i = 0; i < numWaypoints; ++i)
+      {
+         edges.clear();
+         graph.GetAllEdgesFromWaypoint(mIDs[i], edges);
+
+         for (unsigned j = 0; j < edges.size(); ++j)
+         {
+            unsigned index = FindIndex(edges[j]->GetID());
+            if (index != INVALID_INDEX)
+            {
+               mEdges.push_back(index);
+            }
+         }
+
+         mEdgeOffsets.push_back(unsigned(mEdges.size()));
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   WaypointGraphSnapshot::~WaypointGraphSnapshot()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned WaypointGraphSnapshot::FindIndex(WaypointID id) const
+   {
+      dtUtil::HashMap<WaypointID, unsigned>::const_iterator found = mIndices.find(id);
+      if (found == mIndices.end())
+      {
+         return INVALID_INDEX;
+      }
+      return found->second;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   /////////////////////////////////////////////////////////////////////////////
+   WaypointSnapshotAStar::WaypointSnapshotAStar()
+      : WaypointSnapshotAStarBase(WaypointSnapshotAStarCreateFunctor(this, &WaypointSnapshotAStar::CreateNode))
+      , mSnapshot(NULL)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   WaypointSnapshotAStar::~WaypointSnapshotAStar()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void WaypointSnapshotAStar::SetSnapshot(const WaypointGraphSnapshot* snapshot)
+   {
+      mSnapshot = snapshot;
+      GetCostFunction().SetSnapshot(snapshot);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   WaypointSnapshotNode* WaypointSnapshotAStar::CreateNode(WaypointSnapshotNode* pParent, unsigned index, float pGn, float pHn)
+   {
+      return new (AllocateNode()) WaypointSnapshotNode(*mSnapshot, pParent, index, pGn, pHn);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   PathFindResult WaypointSnapshotAStar::FindSingleLevelPath(WaypointID from, WaypointID to, std::vector<WaypointID>& result)
+   {
+      result.clear();
+
+      unsigned fromIndex = WaypointGraphSnapshot::INVALID_INDEX;
+      unsigned toIndex = WaypointGraphSnapshot::INVALID_INDEX;
+      if (mSnapshot != NULL)
+      {
+         fromIndex = mSnapshot->FindIndex(from);
+         toIndex = mSnapshot->FindIndex(to);
+      }
+
+      if (fromIndex == WaypointGraphSnapshot::INVALID_INDEX || toIndex == WaypointGraphSnapshot::INVALID_INDEX)
+      {
+         // nothing was searched, so don't leave the statistics of the last search on the config
+         mConfig.mResult.clear();
+         mConfig.mNodesExplored = 0;
+         mConfig.mTotalCost = 0.0f;
+         return NO_PATH;
+      }
+
+      Reset(fromIndex, toIndex);
+      PathFindResult pathResult = FindPath();
+
+      if (pathResult != NO_PATH)
+      {
+         const container_type& path = GetPath();
+         result.reserve(path.size());
+         for (container_type::const_iterator i = path.begin(), iend = path.end(); i != iend; ++i)
+         {
+            result.push_back(mSnapshot->GetWaypointID(*i));
+         }
+      }
+
+      return pathResult;
+   }
+
+} // namespace dtAI
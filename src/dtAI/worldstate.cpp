@@ -25,19 +25,69 @@
 
 namespace dtAI
 {
+   const unsigned WorldStateSchema::INVALID_SLOT;
+
+   WorldStateSchema::WorldStateSchema()
+   {
+   }
+
+   WorldStateSchema::WorldStateSchema(const WorldStateSchema& pSchema)
+      : osg::Referenced()
+      , mNames(pSchema.mNames)
+      , mNameHashes(pSchema.mNameHashes)
+      , mSlots(pSchema.mSlots)
+   {
+   }
+
+   WorldStateSchema::~WorldStateSchema()
+   {
+   }
+
+   unsigned WorldStateSchema::AddVariable(const std::string& pName)
+   {
+      unsigned slot = GetSlot(pName);
+      if (slot == INVALID_SLOT)
+      {
+         slot = unsigned(mNames.size());
+         mNames.push_back(pName);
+         mNameHashes.push_back(dtUtil::hash<std::string>()(pName));
+         mSlots.insert(std::make_pair(pName, slot));
+      }
+      return slot;
+   }
+
+   unsigned WorldStateSchema::GetSlot(const std::string& pName) const
+   {
+      dtUtil::HashMap<std::string, unsigned>::const_iterator iter = mSlots.find(pName);
+      if (iter == mSlots.end())
+      {
+         return INVALID_SLOT;
+      }
+      return iter->second;
+   }
+
    WorldState::WorldState()
       : mCost(0.0f)
+      , mSchema()
       , mStateVariables()
    {
 
    }
 
+   WorldState::WorldState(WorldStateSchema& pSchema)
+      : mCost(0.0f)
+      , mSchema(&pSchema)
+      , mStateVariables(pSchema.GetNumSlots(), static_cast<IStateVariable*>(NULL))
+   {
+
+   }
+
    struct WorldStateDeleteFunc
    {
       template<class _Type>
          void operator()(_Type p1)
       {
-         delete p1.second;
+         delete p1;
       }
    };
 
@@ -53,33 +103,117 @@ namespace dtAI
    }
 
    WorldState::WorldState(const WorldState& pWS)
+      : mCost(pWS.mCost)
+      , mSchema(pWS.mSchema)
+      , mStateVariables()
    {
+      CopyStateVariables(pWS);
+   }
+
+   WorldState& WorldState::operator =(const WorldState& pWS)
+   {
+      if (this == &pWS)
+      {
+         return *this;
+      }
+
       mCost = pWS.mCost;
 
-      StateVarMapping::const_iterator iter = pWS.mStateVariables.begin();
-      StateVarMapping::const_iterator endOfList = pWS.mStateVariables.end();
-      while (iter != endOfList)
+      if (mSchema == pWS.mSchema && mStateVariables.size() == pWS.mStateVariables.size())
       {
-         mStateVariables.insert(StringStateMapping((*iter).first , (*iter).second->Copy()));
-         ++iter;
+         // Same layout, so assign each variable in place and only copy the ones that can't be.
+         for (unsigned i = 0; i < mStateVariables.size(); ++i)
+         {
+            IStateVariable*& pDest = mStateVariables[i];
+            const IStateVariable* pSource = pWS.mStateVariables[i];
+            if (pSource == NULL)
+            {
+               delete pDest;
+               pDest = NULL;
+            }
+            else if (pDest == NULL || !pDest->Assign(*pSource))
+            {
+               delete pDest;
+               pDest = pSource->Copy();
+            }
+         }
+         return *this;
       }
 
+      FreeMem();
+      mSchema = pWS.mSchema;
+      CopyStateVariables(pWS);
+      return *this;
    }
 
-   WorldState& WorldState::operator =(const WorldState& pWS)
+   void WorldState::CopyStateVariables(const WorldState& pWS)
    {
-      FreeMem();
+      mStateVariables.resize(pWS.mStateVariables.size(), NULL);
+      for (unsigned i = 0; i < pWS.mStateVariables.size(); ++i)
+      {
+         if (pWS.mStateVariables[i] != NULL)
+         {
+            mStateVariables[i] = pWS.mStateVariables[i]->Copy();
+         }
+      }
+   }
 
-      mCost = pWS.mCost;
+   bool WorldState::operator ==(const WorldState& pWS) const
+   {
+      if (mSchema == pWS.mSchema)
+      {
+         unsigned numSlots = unsigned(std::max(mStateVariables.size(), pWS.mStateVariables.size()));
+         for (unsigned i = 0; i < numSlots; ++i)
+         {
+            const IStateVariable* pVar = GetStateInSlot(i);
+            const IStateVariable* pOtherVar = pWS.GetStateInSlot(i);
+            if (pVar != pOtherVar && (pVar == NULL || pOtherVar == NULL || !pVar->IsEqual(*pOtherVar)))
+            {
+               return false;
+            }
+         }
+         return true;
+      }
 
-      StateVarMapping::const_iterator iter = pWS.mStateVariables.begin();
-      StateVarMapping::const_iterator endOfList = pWS.mStateVariables.end();
-      while (iter != endOfList)
+      // Different schemas, so match the variables by name.
+      unsigned numVars = 0, numOtherVars = 0;
+      for (unsigned i = 0; i < mStateVariables.size(); ++i)
       {
-         mStateVariables.insert(StringStateMapping((*iter).first , (*iter).second->Copy()));
-         ++iter;
+         const IStateVariable* pVar = mStateVariables[i];
+         if (pVar != NULL)
+         {
+            ++numVars;
+            const IStateVariable* pOtherVar = pWS.GetState(mSchema->GetName(i));
+            if (pOtherVar == NULL || !pVar->IsEqual(*pOtherVar))
+            {
+               return false;
+            }
+         }
       }
-      return *this;
+      for (unsigned i = 0; i < pWS.mStateVariables.size(); ++i)
+      {
+         if (pWS.mStateVariables[i] != NULL)
+         {
+            ++numOtherVars;
+         }
+      }
+      return numVars == numOtherVars;
+   }
+
+   size_t WorldState::GetHash() const
+   {
+      // Summed so the hash doesn't depend on the order of the slots, only on the names and values.
+      size_t result = 0;
+      for (unsigned i = 0; i < mStateVariables.size(); ++i)
+      {
+         const IStateVariable* pVar = mStateVariables[i];
+         if (pVar != NULL)
+         {
+            size_t h = mSchema->GetNameHash(i) ^ (pVar->GetHash() * 2654435761U);
+            result += h ^ (h >> 16);
+         }
+      }
+      return result;
    }
 
    float WorldState::GetCost() const
@@ -94,32 +228,60 @@ namespace dtAI
 
    void WorldState::AddState(const std::string& pName, IStateVariable* pStateVar)
    {
-      StateVarMapping::iterator iter = mStateVariables.find(pName);
-      if (iter == mStateVariables.end())
+      if (!mSchema.valid())
+      {
+         mSchema = new WorldStateSchema();
+      }
+
+      unsigned slot = mSchema->GetSlot(pName);
+      if (slot == WorldStateSchema::INVALID_SLOT)
+      {
+         if (mSchema->referenceCount() > 1)
+         {
+            mSchema = new WorldStateSchema(*mSchema);
+         }
+         slot = mSchema->AddVariable(pName);
+      }
+
+      if (slot >= mStateVariables.size())
       {
-         mStateVariables.insert(StringStateMapping(pName, pStateVar));
+         mStateVariables.resize(slot + 1, NULL);
+      }
+
+      if (mStateVariables[slot] == NULL)
+      {
+         mStateVariables[slot] = pStateVar;
       }
    }
 
    IStateVariable* WorldState::GetState(const std::string& pState)
    {
-      StateVarMapping::iterator iter = mStateVariables.find(pState);
-      if (iter == mStateVariables.end())
+      if (!mSchema.valid())
       {
          return 0;
       }
-      return (*iter).second;
+      return GetStateInSlot(mSchema->GetSlot(pState));
    }
 
 
    const IStateVariable* WorldState::GetState(const std::string& pState) const
    {
-      StateVarMapping::const_iterator iter = mStateVariables.find(pState);
-      if (iter == mStateVariables.end())
+      if (!mSchema.valid())
       {
          return 0;
       }
-      return (*iter).second;
+      return GetStateInSlot(mSchema->GetSlot(pState));
+   }
+
+   void WorldState::GetStateVariables(StateVarMapping& pMapping) const
+   {
+      for (unsigned i = 0; i < mStateVariables.size(); ++i)
+      {
+         if (mStateVariables[i] != NULL)
+         {
+            pMapping.insert(StringStateMapping(mSchema->GetName(i), mStateVariables[i]));
+         }
+      }
    }
 
    class WorldStatePrintFunc
@@ -141,8 +303,10 @@ namespace dtAI
 
    std::ostream& operator << (std::ostream& o, const WorldState& worldState)
    {
+      WorldState::StateVarMapping stateVars;
+      worldState.GetStateVariables(stateVars);
       WorldStatePrintFunc printFunc(o);
-      std::for_each(worldState.GetStateVariables().begin(), worldState.GetStateVariables().end(), printFunc);
+      std::for_each(stateVars.begin(), stateVars.end(), printFunc);
       return o;
    }
 
@@ -22,6 +22,7 @@
 #include <dtActors/distancesensoractor.h>
 
 #include <dtCore/scene.h>
+#include <dtCore/spatialindex.h>
 #include <dtCore/transform.h>
 
 #include <dtCore/actoractorproperty.h>
@@ -31,6 +32,8 @@
 #include <dtGame/message.h>
 #include <dtGame/messagetype.h>
 
+#include <algorithm>
+
 namespace dtActors
 {
    const dtUtil::RefString DistanceSensorActorProxy::PROPERTY_TRIGGER_DISTANCE("Trigger Distance");
@@ -162,6 +165,27 @@ namespace dtActors
       return mTriggerDistance;
    }
 
+   ////////////////////////////////////////////////////
+   void DistanceSensorActor::FindTransformablesInRange(std::vector<dtCore::Transformable*>& toFill)
+   {
+      dtCore::Scene* scene = GetSceneParent();
+      if (scene == NULL)
+      {
+         return;
+      }
+
+      // Pick up anything that moved earlier this frame.
+      dtCore::SpatialIndex& index = scene->GetSpatialIndex();
+      index.UpdatePositions();
+
+      osg::Matrix matrix;
+      GetAbsoluteMatrix(matrix);
+
+      const size_t start = toFill.size();
+      index.FindInSphere(matrix.getTrans(), mTriggerDistance, toFill);
+      toFill.erase(std::remove(toFill.begin() + start, toFill.end(), this), toFill.end());
+   }
+
    ////////////////////////////////////////////////////
    bool DistanceSensorActor::HasRegistration(const std::string& name) const
    {
@@ -11,15 +11,138 @@ using namespace dtActors;
 
 IMPLEMENT_MANAGEMENT_LAYER(TriggerVolumeActor)
 
+////////////////////////////////////////////////////////////////////////////////
+class TriggerVolumeActor::Volume : public dtCore::SpatialVolume
+{
+public:
+   Volume(TriggerVolumeActor& owner)
+      : mOwner(owner)
+   {
+      SetAnchor(&owner);
+   }
+
+   virtual bool Accepts(const dtCore::Transformable&) const
+   {
+      // Do not send events in STAGE.
+      return !(mOwner.IsGameActorProxyValid() && mOwner.GetGameActorProxy().IsInSTAGE());
+   }
+
+   virtual void OnEnter(dtCore::Transformable& object)
+   {
+      mOwner.mOccupancyList.insert(&object);
+      mOwner.TriggerEvent(&object, ENTER_EVENT);
+   }
+
+   virtual void OnLeave(dtCore::Transformable& object)
+   {
+      mOwner.mOccupancyList.erase(&object);
+      mOwner.TriggerEvent(&object, LEAVE_EVENT);
+   }
+
+   virtual void OnOccupantDeleted()
+   {
+      // The deleted occupant is the one whose observer went NULL.
+      CollidableContainer::iterator i = mOwner.mOccupancyList.begin();
+      while (i != mOwner.mOccupancyList.end())
+      {
+         if (i->valid())
+         {
+            ++i;
+            continue;
+         }
+
+         mOwner.mOccupancyList.erase(i);
+         mOwner.TriggerEvent(NULL, LEAVE_EVENT);
+         return;
+      }
+   }
+
+private:
+   TriggerVolumeActor& mOwner;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 TriggerVolumeActor::TriggerVolumeActor(dtActors::TriggerVolumeActorProxy& proxy,
                                        const std::string& name)
    : dtGame::GameActor(proxy, name)
    , mMaxTriggerCount(0)
    , mTriggerCount(0)
+   , mVolumeIsBox(false)
+   , mVolumeRadius(5.0f)
+   , mVolumeHalfExtents(5.0f, 5.0f, 5.0f)
 {
    RegisterInstance(this);
 
+   mVolume = new Volume(*this);
+   UpdateVolumeShape();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+TriggerVolumeActor::~TriggerVolumeActor()
+{
+   // The volume can outlive the actor if the index still holds it, so it mustn't call back into it.
+   if (dtCore::Scene* scene = GetSceneParent())
+   {
+      scene->GetSpatialIndex().RemoveVolume(*mVolume);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TriggerVolumeActor::SetVolumeIsBox(bool isBox)
+{
+   mVolumeIsBox = isBox;
+   UpdateVolumeShape();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool TriggerVolumeActor::GetVolumeIsBox() const
+{
+   return mVolumeIsBox;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TriggerVolumeActor::SetVolumeRadius(float radius)
+{
+   mVolumeRadius = radius;
+   UpdateVolumeShape();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+float TriggerVolumeActor::GetVolumeRadius() const
+{
+   return mVolumeRadius;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TriggerVolumeActor::SetVolumeHalfExtents(const osg::Vec3& halfExtents)
+{
+   mVolumeHalfExtents = halfExtents;
+   UpdateVolumeShape();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+osg::Vec3 TriggerVolumeActor::GetVolumeHalfExtents() const
+{
+   return mVolumeHalfExtents;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TriggerVolumeActor::UpdateVolumeShape()
+{
+   if (mVolumeIsBox)
+   {
+      mVolume->SetBox(mVolumeHalfExtents);
+   }
+   else
+   {
+      mVolume->SetSphere(mVolumeRadius);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const dtCore::SpatialVolume& TriggerVolumeActor::GetVolume() const
+{
+   return *mVolume;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -79,16 +202,17 @@ bool TriggerVolumeActor::UnregisterListener(void* receiver)
 ////////////////////////////////////////////////////////////////////////////////
 bool TriggerVolumeActor::IsActorInVolume(dtCore::Transformable* actor)
 {
-   bool inVolume = false;
-
-   if (actor)
+   if (actor == NULL || actor == this)
    {
-      int numContacts = 0;
-
-      inVolume = numContacts > 0;
+      return false;
    }
 
-   return inVolume;
+   osg::Matrix volumeMatrix, actorMatrix;
+   GetAbsoluteMatrix(volumeMatrix);
+   actor->GetAbsoluteMatrix(actorMatrix);
+
+   mVolume->SetCenter(volumeMatrix.getTrans());
+   return mVolume->Overlaps(actorMatrix.getTrans());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -133,26 +257,37 @@ void TriggerVolumeActor::TriggerEvent(dtCore::Transformable* instigator, Trigger
    if (eventType == LEAVE_EVENT)
    {
       // If this trigger has expired, it no longer needs update messages
-      if (mMaxTriggerCount != 0 && mTriggerCount >= mMaxTriggerCount)
+      if (IsExpired())
       {
          if (mOccupancyList.empty())
          {
             DeregisterInstance(this);
+
+            if (GetSceneParent() != NULL)
+            {
+               GetSceneParent()->GetSpatialIndex().RemoveVolume(*mVolume);
+            }
          }
       }
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+bool TriggerVolumeActor::IsExpired() const
+{
+   return mMaxTriggerCount != 0 && mTriggerCount >= mMaxTriggerCount;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 void dtActors::TriggerVolumeActor::AddedToScene(dtCore::Scene* scene)
 {
-   if (scene)
+   dtGame::GameActor::AddedToScene(scene);
+
+   if (scene && !IsExpired())
    {
-      //AddSender(scene);
+      scene->GetSpatialIndex().AddVolume(*mVolume);
    }
-
-   dtGame::GameActor::AddedToScene(scene);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -160,7 +295,8 @@ void dtActors::TriggerVolumeActor::RemovedFromScene(dtCore::Scene* scene)
 {
    if (scene)
    {
-      //RemoveSender(scene);
+      scene->GetSpatialIndex().RemoveVolume(*mVolume);
+      mOccupancyList.clear();
    }
 
    dtGame::GameActor::RemovedFromScene(scene);
@@ -22,14 +22,20 @@
 #include <dtActors/triggervolumeactorproxy.h>
 #include <dtActors/triggervolumeactor.h>
 
+#include <dtCore/booleanactorproperty.h>
 #include <dtCore/datatype.h>
+#include <dtCore/floatactorproperty.h>
 #include <dtCore/intactorproperty.h>
+#include <dtCore/vectoractorproperties.h>
 #include <dtCore/actorproxyicon.h>
 
 using namespace dtActors;
 
 const dtUtil::RefString TriggerVolumeActorProxy::CLASS_NAME("dtActors::TriggerVolumeActorProxy");
 const dtUtil::RefString TriggerVolumeActorProxy::PROPERTY_MAX_TRIGGER_COUNT("MaxTriggerCount");
+const dtUtil::RefString TriggerVolumeActorProxy::PROPERTY_VOLUME_IS_BOX("VolumeIsBox");
+const dtUtil::RefString TriggerVolumeActorProxy::PROPERTY_VOLUME_RADIUS("VolumeRadius");
+const dtUtil::RefString TriggerVolumeActorProxy::PROPERTY_VOLUME_HALF_EXTENTS("VolumeHalfExtents");
 
 ////////////////////////////////////////////////////////////////////////////////
 TriggerVolumeActorProxy::TriggerVolumeActorProxy()
@@ -67,6 +73,30 @@ void TriggerVolumeActorProxy::BuildPropertyMap()
       dtCore::IntActorProperty::GetFuncType(actor, &TriggerVolumeActor::GetMaxTriggerCount),
       "Sets the maximum number of times the trigger can active.  0 means an infinite number.",
       GROUP_TRIGGER));
+
+   AddProperty(new dtCore::BooleanActorProperty(
+      TriggerVolumeActorProxy::PROPERTY_VOLUME_IS_BOX,
+      TriggerVolumeActorProxy::PROPERTY_VOLUME_IS_BOX,
+      dtCore::BooleanActorProperty::SetFuncType(actor, &TriggerVolumeActor::SetVolumeIsBox),
+      dtCore::BooleanActorProperty::GetFuncType(actor, &TriggerVolumeActor::GetVolumeIsBox),
+      "Makes the volume a box rather than a sphere.",
+      GROUP_TRIGGER));
+
+   AddProperty(new dtCore::FloatActorProperty(
+      TriggerVolumeActorProxy::PROPERTY_VOLUME_RADIUS,
+      TriggerVolumeActorProxy::PROPERTY_VOLUME_RADIUS,
+      dtCore::FloatActorProperty::SetFuncType(actor, &TriggerVolumeActor::SetVolumeRadius),
+      dtCore::FloatActorProperty::GetFuncType(actor, &TriggerVolumeActor::GetVolumeRadius),
+      "The radius of the volume when it's a sphere.",
+      GROUP_TRIGGER));
+
+   AddProperty(new dtCore::Vec3ActorProperty(
+      TriggerVolumeActorProxy::PROPERTY_VOLUME_HALF_EXTENTS,
+      TriggerVolumeActorProxy::PROPERTY_VOLUME_HALF_EXTENTS,
+      dtCore::Vec3ActorProperty::SetFuncType(actor, &TriggerVolumeActor::SetVolumeHalfExtents),
+      dtCore::Vec3ActorProperty::GetFuncType(actor, &TriggerVolumeActor::GetVolumeHalfExtents),
+      "Half the size of the volume on each axis when it's a box.",
+      GROUP_TRIGGER));
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1222,6 +1222,31 @@ namespace dtAnim
       return GetStance().GetName();
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   size_t BasicStanceState::GetHash() const
+   {
+      return dtUtil::hash<const void*>()(mStance);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool BasicStanceState::IsEqual(const dtAI::IStateVariable& pOther) const
+   {
+      const BasicStanceState* other = dynamic_cast<const BasicStanceState*>(&pOther);
+      return other != NULL && other->mStance == mStance;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool BasicStanceState::Assign(const dtAI::IStateVariable& pOther)
+   {
+      const BasicStanceState* other = dynamic_cast<const BasicStanceState*>(&pOther);
+      if (other == NULL)
+      {
+         return false;
+      }
+      mStance = other->mStance;
+      return true;
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    ////////////////////////////////////////////////////////////////////////////
    WeaponState::WeaponState():
@@ -1272,6 +1297,31 @@ namespace dtAnim
       return GetWeaponStateEnum().GetName();
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   size_t WeaponState::GetHash() const
+   {
+      return dtUtil::hash<const void*>()(mWeaponStateEnum);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool WeaponState::IsEqual(const dtAI::IStateVariable& pOther) const
+   {
+      const WeaponState* other = dynamic_cast<const WeaponState*>(&pOther);
+      return other != NULL && other->mWeaponStateEnum == mWeaponStateEnum;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   bool WeaponState::Assign(const dtAI::IStateVariable& pOther)
+   {
+      const WeaponState* other = dynamic_cast<const WeaponState*>(&pOther);
+      if (other == NULL)
+      {
+         return false;
+      }
+      mWeaponStateEnum = other->mWeaponStateEnum;
+      return true;
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    ////////////////////////////////////////////////////////////////////////////
    HumanOperator::HumanOperator(const dtUtil::RefString& pName)
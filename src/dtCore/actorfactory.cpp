@@ -26,6 +26,8 @@
 
 #include <dtUtil/log.h>
 
+#include <OpenThreads/ScopedLock>
+
 #include <osgDB/FileUtils>
 
 #include <sstream>
@@ -75,6 +77,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    bool ActorFactory::IsInRegistry(const std::string& libName) const
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       RegistryMap::const_iterator regItor = mRegistries.find(libName);
       if (regItor != mRegistries.end())
       {
@@ -89,6 +93,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    void ActorFactory::LoadActorRegistry(const std::string& libName)
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       //Used to format log messages.
       std::ostringstream msg;
 
@@ -177,6 +183,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    bool ActorFactory::AddRegistryEntry(const std::string& libName, const RegistryEntry& entry)
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       //Finally we can actually add the new registry to the library manager.
       //The map key is the system independent library name.
       bool inserted = mRegistries.insert(std::make_pair(libName,entry)).second;
@@ -213,6 +221,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    void ActorFactory::GetActorTypes(ActorTypeList& actorTypes) const
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       RegistryMapConstItor i, iend;
       i = mRegistries.begin();
       iend = mRegistries.end();
@@ -255,6 +265,8 @@ namespace dtCore
    const ActorType* ActorFactory::FindActorType(const std::string& category,
          const std::string& name) const
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       const ActorType* result = NULL;
       dtCore::RefPtr<const ActorType> typeToFind = new ActorType(name, category);
       ActorTypeMapItor itor = mActorTypeCache.find(typeToFind);
@@ -288,6 +300,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    std::string ActorFactory::FindActorTypeReplacementName(const std::string& fullName) const
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       std::string resultName;
       ActorPluginRegistry::ActorTypeReplacements::const_iterator itr = mReplacementActors.begin();
       while (itr != mReplacementActors.end())
@@ -356,6 +370,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    ActorPluginRegistry* ActorFactory::GetRegistry(const std::string& name)
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       if (mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
       {
          for (RegistryMapItor i = mRegistries.begin(); i != mRegistries.end(); ++i)
@@ -381,6 +397,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    ActorPluginRegistry* ActorFactory::GetRegistryForType(const ActorType& actorType)
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       std::ostringstream error;
 
       //To create an new actor proxy, first we search our map of actor types
@@ -425,6 +443,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    std::string ActorFactory::GetLibraryNameForRegistry(const ActorPluginRegistry& registry) const
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       std::string result;
       for (RegistryMapConstItor i = mRegistries.begin(); i != mRegistries.end(); ++i)
       {
@@ -440,6 +460,8 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    void ActorFactory::UnloadActorRegistry(const std::string& libName)
    {
+      OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(mMutex);
+
       if (libName == DEFAULT_ACTOR_LIBRARY)
       {
          mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
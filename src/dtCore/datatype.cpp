@@ -21,10 +21,15 @@
  */
 #include <prefix/dtcoreprefix.h>
 #include <dtCore/datatype.h>
+#include <climits>
 
 namespace dtCore
 {
    IMPLEMENT_ENUM(DataType);
+
+   // Zero initialized before any of the static datatypes are constructed, so the constructor can fill it in.
+   static DataType* sDataTypeIdTable[UCHAR_MAX + 1];
+
    //////////////////////////////////////
    DataType::DataType(const std::string& name, const std::string& displayName, bool resource, unsigned char id, const std::string& altName)
    : dtUtil::Enumeration(name)
@@ -34,6 +39,34 @@ namespace dtCore
    , mId(id)
    {
       AddInstance(this);
+
+      // The first one registered with an id wins, to match searching the enumeration in order.
+      if (sDataTypeIdTable[mId] == NULL)
+      {
+         sDataTypeIdTable[mId] = this;
+      }
+   }
+
+   //////////////////////////////////////////////////
+   void DataType::SetTypeId(unsigned char newId)
+   {
+      if (sDataTypeIdTable[mId] == this)
+      {
+         sDataTypeIdTable[mId] = NULL;
+      }
+
+      mId = newId;
+
+      if (sDataTypeIdTable[mId] == NULL)
+      {
+         sDataTypeIdTable[mId] = this;
+      }
+   }
+
+   //////////////////////////////////////////////////
+   DataType* DataType::GetValueForId(unsigned char id)
+   {
+      return sDataTypeIdTable[id];
    }
 
    //////////////////////////////////////////////////
@@ -43,6 +43,8 @@ namespace dtCore
 {
    const std::string Map::MAP_FILE_EXTENSION("dtmap");
    const std::string Map::PREFAB_FILE_EXTENSION("dtprefab");
+   const std::string Map::MAP_BINARY_FILE_EXTENSION("dtmapb");
+   const std::string Map::PREFAB_BINARY_FILE_EXTENSION("dtprefabb");
 
    ////////////////////////////////////////////////////////////////////////////////
    Map::Map(const std::string& mFileName, const std::string& name)
@@ -118,15 +120,18 @@ namespace dtCore
    ////////////////////////////////////////////////////////////////////////////////
    void Map::SetFileName(const std::string& newFileName)
    {
+      // A binary map renamed without an extension stays binary.
+      const bool wasBinary = IsBinaryFileName(mFileName);
+
       //if "" is passed into the constructor is SetFileName
       //then it should be ignored.
       mFileName = newFileName;
 
       //see if the file already has an extension. If it does, just use it. If
-      //not, tack on the officially sanctioned extension.
+      //not, tack on the officially sanctioned extension for the current format.
       if (!mFileName.empty() && osgDB::getFileExtension(mFileName).empty())
       {
-         mFileName += "." + MAP_FILE_EXTENSION;
+         mFileName += "." + (wasBinary ? MAP_BINARY_FILE_EXTENSION : MAP_FILE_EXTENSION);
       }
    }
 
@@ -567,6 +572,20 @@ namespace dtCore
       mMissingLibraries.insert(mMissingLibraries.end(), libs.begin(), libs.end());
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   bool Map::IsBinaryFileName(const std::string& fileName)
+   {
+      std::string name = fileName;
+      std::string ext = osgDB::getLowerCaseFileExtension(name);
+      while (ext == "backup" || ext == "saving" || ext == "backupsaving")
+      {
+         name = osgDB::getNameLessExtension(name);
+         ext = osgDB::getLowerCaseFileExtension(name);
+      }
+
+      return ext == MAP_BINARY_FILE_EXTENSION || ext == PREFAB_BINARY_FILE_EXTENSION;
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    bool Map::WildMatch(const std::string& sWild, const std::string& sString)
    {
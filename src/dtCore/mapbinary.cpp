@@ -0,0 +1,1529 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <prefix/dtcoreprefix.h>
+#include <dtCore/mapbinary.h>
+
+#include <dtCore/actoractorproperty.h>
+#include <dtCore/actorcomponentcontainer.h>
+#include <dtCore/actorfactory.h>
+#include <dtCore/actoridactorproperty.h>
+#include <dtCore/actorproperty.h>
+#include <dtCore/actortype.h>
+#include <dtCore/booleanactorproperty.h>
+#include <dtCore/datatype.h>
+#include <dtCore/doubleactorproperty.h>
+#include <dtCore/environmentactor.h>
+#include <dtCore/exceptionenum.h>
+#include <dtCore/floatactorproperty.h>
+#include <dtCore/gameevent.h>
+#include <dtCore/gameeventactorproperty.h>
+#include <dtCore/gameeventmanager.h>
+#include <dtCore/intactorproperty.h>
+#include <dtCore/mapcontenthandler.h>
+#include <dtCore/mapxmlconstants.h>
+#include <dtCore/namedparameter.h>
+#include <dtCore/project.h>
+#include <dtCore/resourceactorproperty.h>
+#include <dtCore/vectoractorproperties.h>
+
+#include <dtUtil/datastream.h>
+#include <dtUtil/datetime.h>
+#include <dtUtil/log.h>
+#include <dtUtil/mswinmacros.h>
+#include <dtUtil/stringutils.h>
+
+#ifdef DELTA_WIN32
+#   include <dtUtil/mswin.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+
+namespace dtCore
+{
+   namespace
+   {
+      const unsigned char FLAG_PREFAB = 0x01;
+
+      /// The size of the magic, version, flags and header size at the start of the file.
+      const unsigned PREAMBLE_SIZE = 4 + sizeof(unsigned short) + sizeof(unsigned char) + sizeof(unsigned);
+
+      const unsigned NUM_PRESET_CAMERAS = 10;
+
+      /// How a property value is written.
+      enum ValueEncoding
+      {
+         VALUE_STRING = 0, ///< The index of ToString() in the string table.
+         VALUE_FLOAT,
+         VALUE_DOUBLE,
+         VALUE_INT,
+         VALUE_BOOL,
+         VALUE_VEC,        ///< The vector type is the data type of the property.
+         VALUE_ID,         ///< A compact unique id of an actor or game event.
+         VALUE_RESOURCE,   ///< The display name and identifier in the string table.
+         VALUE_STREAM      ///< ActorProperty::ToDataStream
+      };
+
+      /// Writes a string as its length and its characters, with no limit on the length.
+      void WriteRawString(dtUtil::DataStream& stream, const std::string& value)
+      {
+         stream.Write(unsigned(value.size()));
+         if (!value.empty())
+         {
+            stream.WriteBinary(value.data(), unsigned(value.size()));
+         }
+      }
+
+      void ReadRawString(dtUtil::DataStream& stream, std::string& value)
+      {
+         unsigned size = 0;
+         stream.Read(size);
+         if (size > stream.GetRemainingReadSize())
+         {
+            throw dtCore::MapParsingException("A string runs past the end of the binary map.", __FILE__, __LINE__);
+         }
+         value.assign(stream.GetBuffer() + stream.GetReadPosition(), size);
+         stream.Seekg(stream.GetReadPosition() + size, dtUtil::DataStream::SeekTypeEnum::SET);
+      }
+
+      /// Writes a placeholder for a count or size that isn't known yet.  @return its position for PatchUnsigned.
+      unsigned ReserveUnsigned(dtUtil::DataStream& stream)
+      {
+         unsigned position = stream.GetWritePosition();
+         stream.Write(unsigned(0));
+         return position;
+      }
+
+      void PatchUnsigned(dtUtil::DataStream& stream, unsigned position, unsigned value)
+      {
+         unsigned end = stream.GetWritePosition();
+         stream.Seekp(position, dtUtil::DataStream::SeekTypeEnum::SET);
+         stream.Write(value);
+         stream.Seekp(end, dtUtil::DataStream::SeekTypeEnum::SET);
+      }
+
+      /// Reads a size and checks it fits in the rest of the stream.  @return the position just past the block.
+      unsigned ReadBlockEnd(dtUtil::DataStream& stream)
+      {
+         unsigned size = 0;
+         stream.Read(size);
+         if (size > stream.GetRemainingReadSize())
+         {
+            throw dtCore::MapParsingException("A record runs past the end of the binary map.", __FILE__, __LINE__);
+         }
+         return stream.GetReadPosition() + size;
+      }
+
+      template <typename PropertyType>
+      void WriteVec(dtUtil::DataStream& stream, const ActorProperty& property)
+      {
+         stream << static_cast<const PropertyType&>(property).GetValue();
+      }
+
+      template <typename PropertyType, typename VecType>
+      void ReadVec(dtUtil::DataStream& stream, ActorProperty& property)
+      {
+         VecType value;
+         stream >> value;
+         static_cast<PropertyType&>(property).SetValue(value);
+      }
+
+      template <typename PropertyType, typename ValueType>
+      void ReadScalar(dtUtil::DataStream& stream, ActorProperty& property)
+      {
+         ValueType value;
+         stream.Read(value);
+         PropertyType* typedProperty = dynamic_cast<PropertyType*>(&property);
+         if (typedProperty != NULL)
+         {
+            typedProperty->SetValue(value);
+         }
+         else
+         {
+            property.FromString(dtUtil::ToString(value));
+         }
+      }
+
+      /**
+       * The whole of a file, either mapped into memory or read into a buffer.
+       */
+      class MapFileData
+      {
+      public:
+         MapFileData()
+         : mData(NULL)
+         , mSize(0)
+         , mMapped(false)
+#ifdef DELTA_WIN32
+         , mFile(INVALID_HANDLE_VALUE)
+         , mMapping(NULL)
+#endif
+         {
+         }
+
+         ~MapFileData()
+         {
+            Close();
+         }
+
+         /// @return false if the file couldn't be opened or is empty.
+         bool Open(const std::string& path, bool useMemoryMapping)
+         {
+            Close();
+            if (useMemoryMapping && Map(path))
+            {
+               return true;
+            }
+
+            std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+            if (!file.is_open())
+            {
+               return false;
+            }
+            file.seekg(0, std::ios_base::end);
+            std::streamoff size = file.tellg();
+            file.seekg(0, std::ios_base::beg);
+            if (size <= 0)
+            {
+               return false;
+            }
+
+            mBuffer.resize(size_t(size));
+            file.read(&mBuffer[0], size);
+            if (!file)
+            {
+               mBuffer.clear();
+               return false;
+            }
+            mData = &mBuffer[0];
+            mSize = unsigned(size);
+            return true;
+         }
+
+         char* GetData() { return mData; }
+         unsigned GetSize() const { return mSize; }
+
+      private:
+         bool Map(const std::string& path)
+         {
+#ifdef DELTA_WIN32
+            mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (mFile == INVALID_HANDLE_VALUE)
+            {
+               return false;
+            }
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(mFile, &size) || size.QuadPart <= 0 || size.HighPart != 0)
+            {
+               Close();
+               return false;
+            }
+            mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mMapping == NULL)
+            {
+               Close();
+               return false;
+            }
+            mData = static_cast<char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+            if (mData == NULL)
+            {
+               Close();
+               return false;
+            }
+            mSize = unsigned(size.LowPart);
+#else
+            int file = open(path.c_str(), O_RDONLY);
+            if (file < 0)
+            {
+               return false;
+            }
+            struct stat info;
+            if (fstat(file, &info) != 0 || info.st_size <= 0)
+            {
+               close(file);
+               return false;
+            }
+            void* data = mmap(NULL, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            // The mapping keeps the file open.
+            close(file);
+            if (data == MAP_FAILED)
+            {
+               return false;
+            }
+            mData = static_cast<char*>(data);
+            mSize = unsigned(info.st_size);
+#endif
+            mMapped = true;
+            return true;
+         }
+
+         void Close()
+         {
+            if (mMapped)
+            {
+#ifdef DELTA_WIN32
+               UnmapViewOfFile(mData);
+#else
+               munmap(mData, mSize);
+#endif
+            }
+#ifdef DELTA_WIN32
+            if (mMapping != NULL)
+            {
+               CloseHandle(mMapping);
+               mMapping = NULL;
+            }
+            if (mFile != INVALID_HANDLE_VALUE)
+            {
+               CloseHandle(mFile);
+               mFile = INVALID_HANDLE_VALUE;
+            }
+#endif
+            mBuffer.clear();
+            mData = NULL;
+            mSize = 0;
+            mMapped = false;
+         }
+
+         char* mData;
+         unsigned mSize;
+         bool mMapped;
+         std::vector<char> mBuffer;
+#ifdef DELTA_WIN32
+         HANDLE mFile;
+         HANDLE mMapping;
+#endif
+      };
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   MapBinaryParser::MapBinaryParser()
+   : mLogger(&dtUtil::Log::GetInstance("mapbinary.cpp"))
+   , mUseMemoryMapping(true)
+   , mIsParsing(false)
+   , mHasDeprecatedProperty(false)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   MapBinaryParser::~MapBinaryParser()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::SetUseMemoryMapping(bool useMemoryMapping)
+   {
+      mUseMemoryMapping = useMemoryMapping;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool MapBinaryParser::GetUseMemoryMapping() const
+   {
+      return mUseMemoryMapping;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool MapBinaryParser::IsBinaryMapFile(const std::string& path)
+   {
+      std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+      char magic[sizeof(MapBinaryWriter::MAGIC)];
+      file.read(magic, sizeof(magic));
+      return file && std::memcmp(magic, MapBinaryWriter::MAGIC, sizeof(magic)) == 0;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool MapBinaryParser::Parse(const std::string& path, Map** map, bool prefab)
+   {
+      MapFileData fileData;
+      if (!fileData.Open(path, mUseMemoryMapping))
+      {
+         throw dtCore::MapParsingException("Unable to read binary map file \"" + path + "\".", __FILE__, __LINE__);
+      }
+
+      // The stream only reads, so the mapped data is never written.
+      dtUtil::DataStream stream(fileData.GetData(), fileData.GetSize(), false);
+      return Parse(stream, map, prefab);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool MapBinaryParser::Parse(dtUtil::DataStream& stream, Map** map, bool prefab)
+   {
+      Reset();
+      stream.SetForceLittleEndian(true);
+      mMap = new Map("", "");
+      mIsParsing = true;
+
+      try
+      {
+         ParseHeader(stream, *mMap, prefab);
+         ParseStringTable(stream);
+         ParseLibraries(stream);
+         ParseEvents(stream);
+
+         bool hasEnvironmentActor = false;
+         dtCore::UniqueId envActorId(false);
+         stream.Read(hasEnvironmentActor);
+         if (hasEnvironmentActor)
+         {
+            envActorId.FromCompactDataStream(stream);
+         }
+
+         unsigned numActors = 0;
+         stream.Read(numActors);
+         for (unsigned i = 0; i < numActors; ++i)
+         {
+            ParseActor(stream, NULL, prefab);
+         }
+
+         ParseGroups(stream);
+         ParsePresetCameras(stream);
+
+         LinkActors();
+         if (hasEnvironmentActor)
+         {
+            SetEnvironmentActor(envActorId);
+         }
+      }
+      catch (const dtUtil::DataStreamBufferReadError& ex)
+      {
+         mIsParsing = false;
+         mMap = NULL;
+         mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+                  "Error reading binary map: %s", ex.What().c_str());
+         throw dtCore::MapParsingException("The binary map is truncated or corrupt. See log for more information.", __FILE__, __LINE__);
+      }
+      catch (...)
+      {
+         mIsParsing = false;
+         mMap = NULL;
+         throw;
+      }
+
+      mIsParsing = false;
+      mStrings.clear();
+      mActorsByFileId.clear();
+
+      dtCore::RefPtr<Map> mapRef = mMap;
+      mMap = NULL;
+      if (map != NULL)
+      {
+         *map = mapRef.release();
+      }
+      return true;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   MapPtr MapBinaryParser::ParseMapHeaderData(const std::string& path, bool prefab) const
+   {
+      std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+      if (!file.is_open())
+      {
+         throw dtCore::MapParsingException("Unable to read binary map file \"" + path + "\".", __FILE__, __LINE__);
+      }
+
+      // Only the preamble and the header are read, not the actors.
+      std::vector<char> buffer(PREAMBLE_SIZE);
+      file.read(&buffer[0], PREAMBLE_SIZE);
+      if (!file)
+      {
+         throw dtCore::MapParsingException("\"" + path + "\" is too short to be a binary map.", __FILE__, __LINE__);
+      }
+
+      unsigned headerSize = 0;
+      {
+         dtUtil::DataStream preamble(&buffer[0], PREAMBLE_SIZE, false);
+         preamble.SetForceLittleEndian(true);
+         preamble.Seekg(PREAMBLE_SIZE - sizeof(unsigned), dtUtil::DataStream::SeekTypeEnum::SET);
+         preamble.Read(headerSize);
+      }
+
+      // Check the size against the file so a corrupt value can't wrap or make a huge allocation.
+      file.seekg(0, std::ios_base::end);
+      const std::streamoff fileSize = file.tellg();
+      file.seekg(PREAMBLE_SIZE, std::ios_base::beg);
+      if (!file || fileSize < std::streamoff(PREAMBLE_SIZE)
+               || std::streamoff(headerSize) > fileSize - std::streamoff(PREAMBLE_SIZE))
+      {
+         throw dtCore::MapParsingException("The header size in \"" + path + "\" is larger than the file.", __FILE__, __LINE__);
+      }
+
+      buffer.resize(PREAMBLE_SIZE + headerSize);
+      if (headerSize > 0)
+      {
+         file.read(&buffer[PREAMBLE_SIZE], headerSize);
+         if (!file)
+         {
+            throw dtCore::MapParsingException("The header of \"" + path + "\" is truncated.", __FILE__, __LINE__);
+         }
+      }
+
+      dtUtil::DataStream stream(&buffer[0], unsigned(buffer.size()), false);
+      return ParseMapHeaderData(stream, prefab);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   MapPtr MapBinaryParser::ParseMapHeaderData(dtUtil::DataStream& stream, bool prefab) const
+   {
+      stream.SetForceLittleEndian(true);
+      MapPtr result = new Map("", "");
+      try
+      {
+         ParseHeader(stream, *result, prefab);
+      }
+      catch (const dtUtil::DataStreamBufferReadError& ex)
+      {
+         mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+                  "Error reading binary map header: %s", ex.What().c_str());
+         throw dtCore::MapParsingException("The binary map header is truncated or corrupt. See log for more information.", __FILE__, __LINE__);
+      }
+      return result;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned char MapBinaryParser::ParseHeader(dtUtil::DataStream& stream, Map& map, bool prefab) const
+   {
+      char magic[sizeof(MapBinaryWriter::MAGIC)];
+      if (stream.ReadBinary(magic, sizeof(magic)) != sizeof(magic) ||
+               std::memcmp(magic, MapBinaryWriter::MAGIC, sizeof(magic)) != 0)
+      {
+         throw dtCore::MapParsingException("The file is not a binary map.", __FILE__, __LINE__);
+      }
+
+      unsigned short version = 0;
+      unsigned char flags = 0;
+      stream.Read(version);
+      stream.Read(flags);
+      if (version > MapBinaryWriter::FORMAT_VERSION)
+      {
+         throw dtCore::MapParsingException("The binary map was written by a newer version, " +
+                  dtUtil::ToString(version) + ", than this one can read.", __FILE__, __LINE__);
+      }
+
+      unsigned headerEnd = ReadBlockEnd(stream);
+
+      std::string name, description, author, comment, copyright, createTime, lastUpdateTime, editorVersion, iconFile;
+      ReadRawString(stream, name);
+      ReadRawString(stream, description);
+      ReadRawString(stream, author);
+      ReadRawString(stream, comment);
+      ReadRawString(stream, copyright);
+      ReadRawString(stream, createTime);
+      ReadRawString(stream, lastUpdateTime);
+      ReadRawString(stream, editorVersion);
+      ReadRawString(stream, iconFile);
+
+      // The same fields are used as when reading the xml header.
+      map.SetDescription(description);
+      map.SetCreateDateTime(createTime);
+      map.SetIconFile(iconFile);
+      if (!prefab)
+      {
+         map.SetName(name);
+         map.SetAuthor(author);
+         map.SetComment(comment);
+         map.SetCopyright(copyright);
+      }
+
+      stream.Seekg(headerEnd, dtUtil::DataStream::SeekTypeEnum::SET);
+      return flags;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParseStringTable(dtUtil::DataStream& stream)
+   {
+      unsigned numStrings = 0;
+      stream.Read(numStrings);
+      // Each string takes at least its size, so a count larger than that is corrupt rather than a huge allocation.
+      if (numStrings > stream.GetRemainingReadSize() / sizeof(unsigned))
+      {
+         throw dtCore::MapParsingException("The string table of the binary map is corrupt.", __FILE__, __LINE__);
+      }
+
+      mStrings.resize(numStrings);
+      for (unsigned i = 0; i < numStrings; ++i)
+      {
+         ReadRawString(stream, mStrings[i]);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const std::string& MapBinaryParser::ReadTableString(dtUtil::DataStream& stream) const
+   {
+      unsigned index = 0;
+      stream.Read(index);
+      if (index >= mStrings.size())
+      {
+         throw dtCore::MapParsingException("The binary map refers to a string that isn't in its string table.", __FILE__, __LINE__);
+      }
+      return mStrings[index];
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParseLibraries(dtUtil::DataStream& stream)
+   {
+      unsigned numLibraries = 0;
+      stream.Read(numLibraries);
+      for (unsigned i = 0; i < numLibraries; ++i)
+      {
+         const std::string& libName = ReadTableString(stream);
+         const std::string& libVersion = ReadTableString(stream);
+
+         try
+         {
+            if (ActorFactory::GetInstance().GetRegistry(libName) == NULL)
+            {
+               ActorFactory::GetInstance().LoadActorRegistry(libName);
+            }
+            mMap->AddLibrary(libName, libVersion);
+         }
+         catch (const dtUtil::Exception& e)
+         {
+            mMissingLibraries.push_back(libName);
+
+            mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+               "Error loading library %s version %s in the library manager.  Exception message to follow.",
+               libName.c_str(), libVersion.c_str());
+
+            e.LogException(dtUtil::Log::LOG_ERROR, *mLogger);
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParseEvents(dtUtil::DataStream& stream)
+   {
+      unsigned numEvents = 0;
+      stream.Read(numEvents);
+      for (unsigned i = 0; i < numEvents; ++i)
+      {
+         dtCore::UniqueId id(false);
+         id.FromCompactDataStream(stream);
+         const std::string& name = ReadTableString(stream);
+         const std::string& description = ReadTableString(stream);
+
+         dtCore::RefPtr<GameEvent> gameEvent = new GameEvent(name, description);
+         gameEvent->SetUniqueId(id);
+         mMap->GetEventManager().AddEvent(*gameEvent);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParseActor(dtUtil::DataStream& stream, BaseActorObject* container, bool prefab)
+   {
+      unsigned recordEnd = ReadBlockEnd(stream);
+
+      const std::string& actorTypeFullName = ReadTableString(stream);
+      ActorComponentContainer* compContainer = dynamic_cast<ActorComponentContainer*>(container);
+
+      dtCore::RefPtr<BaseActorObject> actor;
+      bool newActor = true;
+
+      // Make sure we have not tried to load this actor type already and failed.
+      if (mMissingActorTypes.find(actorTypeFullName) == mMissingActorTypes.end())
+      {
+         std::pair<std::string, std::string> typeCatPair = ActorType::ParseNameAndCategory(actorTypeFullName);
+         const std::string& actorTypeCategory = typeCatPair.second;
+         const std::string& actorTypeName = typeCatPair.first;
+
+         ActorTypePtr actorType = MapContentHandler::FindActorType(actorTypeCategory, actorTypeName);
+
+         if (compContainer != NULL)
+         {
+            ActorPtrVector existingComponents;
+            if (actorType == nullptr)
+            {
+               ActorTypePtr tempType = new dtCore::ActorType(actorTypeName, actorTypeCategory, std::string());
+               compContainer->GetComponents(tempType, existingComponents);
+               if (!existingComponents.empty())
+               {
+                  actorType = &existingComponents[0]->GetActorType();
+                  mLogger->LogMessage(dtUtil::Log::LOG_WARNING, __FUNCTION__,  __LINE__,
+                           "ActorComponent actorType \"%s\" was not found in the registry, but it was found as an existing component."
+                           "Please register this type with an actor plugin registry or register the approprate registry to avoid this problem.",
+                           actorTypeFullName.c_str());
+               }
+            }
+            else
+            {
+               compContainer->GetComponents(actorType, existingComponents);
+            }
+
+            if (!existingComponents.empty())
+            {
+               // Actor components created in code won't have their defaults initialized unless the developer
+               // created it through the factory.
+               actor = existingComponents[0];
+               actor->InitDefaults();
+               newActor = false;
+            }
+         }
+
+         if (!actor.valid() && actorType != nullptr)
+         {
+            actor = ActorFactory::GetInstance().CreateActor(*actorType);
+         }
+
+         if (!actor.valid())
+         {
+            mLogger->LogMessage(dtUtil::Log::LOG_WARNING, __FUNCTION__,  __LINE__,
+                     "ActorType \"%s\" not found.", actorTypeFullName.c_str());
+            mMissingActorTypes.insert(actorTypeFullName);
+         }
+      }
+
+      // The record size lets the actor and all its components be skipped.
+      if (!actor.valid())
+      {
+         stream.Seekg(recordEnd, dtUtil::DataStream::SeekTypeEnum::SET);
+         return;
+      }
+
+      // Notify the actor that it is being loaded.
+      actor->OnMapLoadBegin();
+
+      if (compContainer != NULL && newActor)
+      {
+         compContainer->AddComponent(*actor);
+      }
+
+      dtCore::UniqueId fileId(false);
+      fileId.FromCompactDataStream(stream);
+      if (!prefab)
+      {
+         actor->SetId(fileId);
+      }
+      mActorsByFileId[fileId] = actor.get();
+
+      actor->SetName(ReadTableString(stream));
+
+      bool hasParent = false;
+      dtCore::UniqueId parentId(false);
+      stream.Read(hasParent);
+      if (hasParent)
+      {
+         parentId.FromCompactDataStream(stream);
+      }
+
+      // Components come before the properties so that they all exist before deprecated properties are handled.
+      unsigned numComponents = 0;
+      stream.Read(numComponents);
+      for (unsigned i = 0; i < numComponents; ++i)
+      {
+         ParseActor(stream, actor.get(), prefab);
+      }
+
+      ParseProperties(stream, *actor);
+
+      if (!actor->IsActorComponent())
+      {
+         // Parents are always written before their children.
+         BaseActorObject* parent = hasParent ? FindActorByFileId(parentId) : NULL;
+         ActorComponentContainer* extendedActor = dynamic_cast<ActorComponentContainer*>(actor.get());
+         if (parent != NULL && extendedActor != NULL)
+         {
+            extendedActor->SetParentBaseActor(parent);
+         }
+
+         mMap->AddProxy(*actor);
+      }
+      actor->OnMapLoadEnd(); //notify BaseActorObject we're done loading it
+
+      stream.Seekg(recordEnd, dtUtil::DataStream::SeekTypeEnum::SET);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParseProperties(dtUtil::DataStream& stream, PropertyContainer& propContainer)
+   {
+      unsigned numProperties = 0;
+      stream.Read(numProperties);
+      for (unsigned i = 0; i < numProperties; ++i)
+      {
+         const std::string& propertyName = ReadTableString(stream);
+         unsigned char encoding = 0, dataTypeId = 0;
+         stream.Read(encoding);
+         stream.Read(dataTypeId);
+         unsigned valueEnd = ReadBlockEnd(stream);
+
+         dtCore::RefPtr<ActorProperty> property = propContainer.GetProperty(propertyName);
+         if (!property.valid())
+         {
+            property = propContainer.GetDeprecatedProperty(propertyName);
+            if (property.valid())
+            {
+               mHasDeprecatedProperty = true;
+            }
+         }
+
+         if (!property.valid())
+         {
+            mLogger->LogMessage(dtUtil::Log::LOG_INFO, __FUNCTION__, __LINE__,
+                     "Property \"%s\" was not found on the property container.", propertyName.c_str());
+         }
+         else if (property->IsReadOnly())
+         {
+            mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
+                     "Property \"%s\" is read only, so it was not loaded.", propertyName.c_str());
+         }
+         else
+         {
+            try
+            {
+               ParsePropertyValue(stream, propContainer, *property, encoding, dataTypeId);
+            }
+            catch (const dtUtil::Exception& ex)
+            {
+               // The value is bounded by its size, so the rest of the map can still be read.
+               mLogger->LogMessage(dtUtil::Log::LOG_WARNING, __FUNCTION__, __LINE__,
+                        "Unable to read the value of property \"%s\": %s", propertyName.c_str(), ex.What().c_str());
+            }
+         }
+
+         stream.Seekg(valueEnd, dtUtil::DataStream::SeekTypeEnum::SET);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParsePropertyValue(dtUtil::DataStream& stream, PropertyContainer& propContainer,
+            ActorProperty& property, unsigned char encoding, unsigned char dataTypeId)
+   {
+      const unsigned char propertyTypeId = property.GetDataType().GetTypeId();
+
+      switch (encoding)
+      {
+      case VALUE_STRING:
+         property.FromString(ReadTableString(stream));
+         return;
+      case VALUE_FLOAT:
+         ReadScalar<FloatActorProperty, float>(stream, property);
+         return;
+      case VALUE_DOUBLE:
+         ReadScalar<DoubleActorProperty, double>(stream, property);
+         return;
+      case VALUE_INT:
+         ReadScalar<IntActorProperty, int>(stream, property);
+         return;
+      case VALUE_BOOL:
+         ReadScalar<BooleanActorProperty, bool>(stream, property);
+         return;
+      case VALUE_VEC:
+         if (propertyTypeId == dataTypeId)
+         {
+            switch (dataTypeId)
+            {
+            case DataType::VEC2_ID:
+            case DataType::VEC2F_ID:
+               ReadVec<Vec2fActorProperty, osg::Vec2f>(stream, property);
+               return;
+            case DataType::VEC2D_ID:
+               ReadVec<Vec2dActorProperty, osg::Vec2d>(stream, property);
+               return;
+            case DataType::VEC3_ID:
+            case DataType::VEC3F_ID:
+               ReadVec<Vec3fActorProperty, osg::Vec3f>(stream, property);
+               return;
+            case DataType::VEC3D_ID:
+               ReadVec<Vec3dActorProperty, osg::Vec3d>(stream, property);
+               return;
+            case DataType::VEC4_ID:
+            case DataType::VEC4F_ID:
+            case DataType::RGBACOLOR_ID:
+               ReadVec<Vec4fActorProperty, osg::Vec4f>(stream, property);
+               return;
+            case DataType::VEC4D_ID:
+               ReadVec<Vec4dActorProperty, osg::Vec4d>(stream, property);
+               return;
+            default:
+               break;
+            }
+         }
+         break;
+      case VALUE_ID:
+         {
+            dtCore::UniqueId id(false);
+            id.FromCompactDataStream(stream);
+
+            if (ActorIDActorProperty* idProperty = dynamic_cast<ActorIDActorProperty*>(&property))
+            {
+               idProperty->SetValue(id);
+            }
+            else if (ActorActorProperty* actorProperty = dynamic_cast<ActorActorProperty*>(&property))
+            {
+               // The actor may not be loaded yet, so it's linked at the end.
+               ActorLink link;
+               link.mProperty = actorProperty;
+               link.mValue = id;
+               mActorLinks.push_back(link);
+            }
+            else if (GameEventActorProperty* eventProperty = dynamic_cast<GameEventActorProperty*>(&property))
+            {
+               GameEvent* gameEvent = NULL;
+               if (!id.IsNull())
+               {
+                  gameEvent = mMap->GetEventManager().FindEvent(id);
+                  if (gameEvent == NULL)
+                  {
+                     gameEvent = Project::GetInstance().GetGameEvent(id);
+                  }
+                  if (gameEvent == NULL)
+                  {
+                     mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+                              "Game Event referenced in actor property %s was not found.", property.GetName().c_str());
+                  }
+               }
+               eventProperty->SetValue(gameEvent);
+            }
+            else
+            {
+               property.FromString(id.ToString());
+            }
+         }
+         return;
+      case VALUE_RESOURCE:
+         {
+            const std::string& displayName = ReadTableString(stream);
+            const std::string& identifier = ReadTableString(stream);
+            ResourceActorProperty* resourceProperty = dynamic_cast<ResourceActorProperty*>(&property);
+            if (resourceProperty != NULL)
+            {
+               if (identifier.empty())
+               {
+                  resourceProperty->SetValue(ResourceDescriptor::NULL_RESOURCE);
+               }
+               else
+               {
+                  resourceProperty->SetValue(ResourceDescriptor(displayName, identifier));
+               }
+               return;
+            }
+         }
+         break;
+      case VALUE_STREAM:
+         if (propertyTypeId == dataTypeId)
+         {
+            if (dataTypeId == DataType::GROUP_ID)
+            {
+               // Group values may refer to actors that aren't loaded yet, so they're set at the end.
+               GroupValue groupValue;
+               groupValue.mProperty = &property;
+               groupValue.mValue = NamedParameter::CreateFromType(property.GetDataType(), property.GetName(), false);
+               if (groupValue.mValue->FromDataStream(stream))
+               {
+                  mGroupValues.push_back(groupValue);
+               }
+            }
+            else
+            {
+               property.FromDataStream(stream);
+            }
+            return;
+         }
+         break;
+      default:
+         mLogger->LogMessage(dtUtil::Log::LOG_WARNING, __FUNCTION__, __LINE__,
+                  "Property \"%s\" has an unknown encoding, %d, in the binary map.", property.GetName().c_str(), int(encoding));
+         return;
+      }
+
+      DataType* savedType = DataType::GetValueForId(dataTypeId);
+      mLogger->LogMessage(dtUtil::Log::LOG_WARNING, __FUNCTION__, __LINE__,
+               "Property \"%s\" was saved as type %s, but it is now type %s, so it was not loaded.",
+               property.GetName().c_str(), savedType != NULL ? savedType->GetName().c_str() : "unknown",
+               property.GetDataType().GetName().c_str());
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParseGroups(dtUtil::DataStream& stream)
+   {
+      unsigned numGroups = 0;
+      stream.Read(numGroups);
+      for (unsigned groupIndex = 0; groupIndex < numGroups; ++groupIndex)
+      {
+         unsigned numActors = 0;
+         stream.Read(numActors);
+         for (unsigned i = 0; i < numActors; ++i)
+         {
+            dtCore::UniqueId id(false);
+            id.FromCompactDataStream(stream);
+            BaseActorObject* actor = FindActorByFileId(id);
+            if (actor != NULL)
+            {
+               mMap->AddActorToGroup(int(groupIndex), *actor);
+            }
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::ParsePresetCameras(dtUtil::DataStream& stream)
+   {
+      unsigned numCameras = 0;
+      stream.Read(numCameras);
+      for (unsigned i = 0; i < numCameras; ++i)
+      {
+         unsigned char index = 0;
+         Map::PresetCameraData data;
+         double x = 0.0, y = 0.0, z = 0.0, w = 1.0;
+
+         stream >> index >> data.persPosition >> x >> y >> z >> w;
+         data.persRotation.set(x, y, z, w);
+         stream >> data.topPosition >> data.topZoom;
+         stream >> data.sidePosition >> data.sideZoom;
+         stream >> data.frontPosition >> data.frontZoom;
+         data.isValid = true;
+
+         if (index < NUM_PRESET_CAMERAS)
+         {
+            mMap->SetPresetCameraData(index, data);
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::LinkActors()
+   {
+      for (size_t i = 0; i < mActorLinks.size(); ++i)
+      {
+         ActorLink& link = mActorLinks[i];
+         if (link.mValue.IsNull())
+         {
+            link.mProperty->SetValue(NULL);
+            continue;
+         }
+
+         BaseActorObject* value = FindActorByFileId(link.mValue);
+         if (value == NULL)
+         {
+            mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__,  __LINE__,
+                     "Property Container was defined to have actor property %s set with actor %s, but the proxy does not exist in the new map.",
+                     link.mProperty->GetName().c_str(), link.mValue.ToString().c_str());
+            continue;
+         }
+         link.mProperty->SetValue(value);
+      }
+
+      for (size_t i = 0; i < mGroupValues.size(); ++i)
+      {
+         mGroupValues[i].mValue->ApplyValueToProperty(*mGroupValues[i].mProperty);
+      }
+
+      mActorLinks.clear();
+      mGroupValues.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::SetEnvironmentActor(const dtCore::UniqueId& envActorId)
+   {
+      dtCore::RefPtr<BaseActorObject> proxy = mMap->GetProxyById(envActorId);
+      if (!proxy.valid())
+      {
+         mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
+                  "No environment actor was located in the map.");
+         return;
+      }
+
+      IEnvironmentActor* ea = dynamic_cast<IEnvironmentActor*>(proxy->GetDrawable());
+      if (ea == NULL)
+      {
+         throw dtCore::InvalidActorException(
+            "The environment actor proxy's actor should be an environment, but a dynamic_cast failed", __FILE__, __LINE__);
+      }
+      mMap->SetEnvironmentActor(proxy.get());
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   BaseActorObject* MapBinaryParser::FindActorByFileId(const dtCore::UniqueId& id) const
+   {
+      dtUtil::HashMap<dtCore::UniqueId, BaseActorObject*>::const_iterator found = mActorsByFileId.find(id);
+      if (found == mActorsByFileId.end())
+      {
+         return NULL;
+      }
+      return found->second;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryParser::Reset()
+   {
+      mMap = NULL;
+      mIsParsing = false;
+      mHasDeprecatedProperty = false;
+      mStrings.clear();
+      mActorsByFileId.clear();
+      mActorLinks.clear();
+      mGroupValues.clear();
+      mMissingActorTypes.clear();
+      mMissingLibraries.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool MapBinaryParser::IsParsing() const
+   {
+      return mIsParsing;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   Map* MapBinaryParser::GetMapBeingParsed()
+   {
+      return mIsParsing ? mMap.get() : NULL;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const Map* MapBinaryParser::GetMapBeingParsed() const
+   {
+      return mIsParsing ? mMap.get() : NULL;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const std::set<std::string>& MapBinaryParser::GetMissingActorTypes()
+   {
+      return mMissingActorTypes;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const std::vector<std::string>& MapBinaryParser::GetMissingLibraries()
+   {
+      return mMissingLibraries;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool MapBinaryParser::HasDeprecatedProperty() const
+   {
+      return mHasDeprecatedProperty;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   //////////////////////////////////////////////////////////////////////////
+
+   const char MapBinaryWriter::MAGIC[4] = { 'D', 'T', 'M', 'B' };
+
+   /////////////////////////////////////////////////////////////////////////////
+   MapBinaryWriter::MapBinaryWriter()
+   : mLogger(&dtUtil::Log::GetInstance("mapbinary.cpp"))
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   MapBinaryWriter::~MapBinaryWriter()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryWriter::Save(Map& map, const std::string& filePath, bool prefab)
+   {
+      dtUtil::DataStream stream;
+      Save(map, stream, prefab);
+
+      std::ofstream file(filePath.c_str(), std::ios_base::trunc | std::ios_base::binary);
+      if (!file.is_open())
+      {
+         throw dtCore::MapSaveException( std::string("Unable to open map file \"") + filePath + "\" for writing.", __FILE__, __LINE__);
+      }
+      file.write(stream.GetBuffer(), stream.GetBufferSize());
+      if (!file)
+      {
+         throw dtCore::MapSaveException( std::string("Unable to write map file \"") + filePath + "\".", __FILE__, __LINE__);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryWriter::Save(Map& map, dtUtil::DataStream& stream, bool prefab)
+   {
+      map.CorrectLibraryList(false);
+      mStrings.clear();
+      mStringIndices.clear();
+
+      try
+      {
+         const std::string& utcTime = dtUtil::DateTime::ToString(dtUtil::DateTime(dtUtil::DateTime::TimeOrigin::LOCAL_TIME),
+            dtUtil::DateTime::TimeFormat::CALENDAR_DATE_AND_TIME_FORMAT);
+         if (map.GetCreateDateTime().empty())
+         {
+            map.SetCreateDateTime(utcTime);
+         }
+
+         dtUtil::DataStream header;
+         header.SetForceLittleEndian(true);
+         WriteRawString(header, map.GetName());
+         WriteRawString(header, map.GetDescription());
+         WriteRawString(header, prefab ? std::string() : map.GetAuthor());
+         WriteRawString(header, prefab ? std::string() : map.GetComment());
+         WriteRawString(header, prefab ? std::string() : map.GetCopyright());
+         WriteRawString(header, map.GetCreateDateTime());
+         WriteRawString(header, utcTime);
+         WriteRawString(header, std::string(MapXMLConstants::EDITOR_VERSION));
+         WriteRawString(header, map.GetIconFile());
+
+         // The body is written first so the string table is complete before it's written out.
+         dtUtil::DataStream body;
+         body.SetForceLittleEndian(true);
+
+         const std::vector<std::string>& libs = map.GetAllLibraries();
+         body.Write(unsigned(libs.size()));
+         for (std::vector<std::string>::const_iterator i = libs.begin(); i != libs.end(); ++i)
+         {
+            WriteTableString(body, *i);
+            WriteTableString(body, map.GetLibraryVersion(*i));
+         }
+
+         std::vector<GameEvent*> events;
+         if (!prefab)
+         {
+            map.GetEventManager().GetAllEvents(events);
+         }
+         body.Write(unsigned(events.size()));
+         for (std::vector<GameEvent*>::const_iterator i = events.begin(); i != events.end(); ++i)
+         {
+            (*i)->GetUniqueId().ToCompactDataStream(body);
+            WriteTableString(body, (*i)->GetName());
+            WriteTableString(body, (*i)->GetDescription());
+         }
+
+         bool hasEnvironmentActor = !prefab && map.GetEnvironmentActor() != NULL;
+         body.Write(hasEnvironmentActor);
+         if (hasEnvironmentActor)
+         {
+            map.GetEnvironmentActor()->GetId().ToCompactDataStream(body);
+         }
+
+         unsigned numActorsPosition = ReserveUnsigned(body);
+         unsigned numActors = 0;
+
+         typedef std::map<dtCore::UniqueId, dtCore::RefPtr<BaseActorObject> > ActorMap;
+         const ActorMap& actorMap = map.GetAllProxies();
+         for (ActorMap::const_iterator curIter = actorMap.begin(); curIter != actorMap.end(); ++curIter)
+         {
+            BaseActorObject* actor = curIter->second.get();
+            if (actor->IsActorComponent())
+            {
+               LOG_ERROR("Cannot write an ActorComponent \"" + actor->GetName()
+                  + "\" (type " + actor->GetActorType().GetName()
+                  + ") directly to the map root. The actor component must be contained within an actor.");
+               continue;
+            }
+
+            // Actors with parents are written after their parent, and ghosts aren't saved.
+            ActorComponentContainer* compContainer = dynamic_cast<ActorComponentContainer*>(actor);
+            if (actor->IsGhost() || (compContainer != NULL && compContainer->GetParentBaseActor() != NULL))
+            {
+               continue;
+            }
+
+            dtCore::RefPtr<ActorComponentContainer::ActorIterator> iter;
+            if (compContainer != NULL)
+            {
+               iter = compContainer->GetIterator();
+            }
+
+            if (!iter.valid())
+            {
+               WriteActor(body, *actor);
+               ++numActors;
+            }
+            else
+            {
+               // Iterate over the current actor and its children in order.
+               for (; !iter->IsAtEnd(); ++(*iter))
+               {
+                  BaseActorObject* curActor = *(*iter);
+                  if (!curActor->IsGhost())
+                  {
+                     WriteActor(body, *curActor);
+                     ++numActors;
+                  }
+               }
+            }
+         }
+         PatchUnsigned(body, numActorsPosition, numActors);
+
+         int groupCount = prefab ? 0 : map.GetGroupCount();
+         body.Write(unsigned(groupCount));
+         for (int groupIndex = 0; groupIndex < groupCount; ++groupIndex)
+         {
+            unsigned numGroupActorsPosition = ReserveUnsigned(body);
+            unsigned numGroupActors = 0;
+            int actorCount = map.GetGroupActorCount(groupIndex);
+            for (int actorIndex = 0; actorIndex < actorCount; ++actorIndex)
+            {
+               BaseActorObject* actor = map.GetActorFromGroup(groupIndex, actorIndex);
+               if (actor != NULL)
+               {
+                  actor->GetId().ToCompactDataStream(body);
+                  ++numGroupActors;
+               }
+            }
+            PatchUnsigned(body, numGroupActorsPosition, numGroupActors);
+         }
+
+         unsigned numCamerasPosition = ReserveUnsigned(body);
+         unsigned numCameras = 0;
+         for (unsigned presetIndex = 0; !prefab && presetIndex < NUM_PRESET_CAMERAS; ++presetIndex)
+         {
+            Map::PresetCameraData data = map.GetPresetCameraData(int(presetIndex));
+            if (!data.isValid)
+            {
+               continue;
+            }
+
+            body << (unsigned char)(presetIndex) << data.persPosition
+                 << data.persRotation.x() << data.persRotation.y() << data.persRotation.z() << data.persRotation.w();
+            body << data.topPosition << data.topZoom;
+            body << data.sidePosition << data.sideZoom;
+            body << data.frontPosition << data.frontZoom;
+            ++numCameras;
+         }
+         PatchUnsigned(body, numCamerasPosition, numCameras);
+
+         stream.SetForceLittleEndian(true);
+         stream.WriteBinary(MAGIC, sizeof(MAGIC));
+         stream.Write((unsigned short)(FORMAT_VERSION));
+         stream.Write((unsigned char)(prefab ? FLAG_PREFAB : 0));
+         stream.Write(header.GetBufferSize());
+         stream.WriteBinary(header.GetBuffer(), header.GetBufferSize());
+
+         stream.Write(unsigned(mStrings.size()));
+         for (std::vector<std::string>::const_iterator i = mStrings.begin(); i != mStrings.end(); ++i)
+         {
+            WriteRawString(stream, *i);
+         }
+
+         stream.WriteBinary(body.GetBuffer(), body.GetBufferSize());
+      }
+      catch (const dtUtil::Exception& ex)
+      {
+         mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+                             "Caught Exception \"%s\" while attempting to save map \"%s\".",
+                             ex.What().c_str(), map.GetName().c_str());
+         throw;
+      }
+
+      mStrings.clear();
+      mStringIndices.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryWriter::WriteTableString(dtUtil::DataStream& stream, const std::string& value)
+   {
+      dtUtil::HashMap<std::string, unsigned>::const_iterator found = mStringIndices.find(value);
+      if (found != mStringIndices.end())
+      {
+         stream.Write(found->second);
+         return;
+      }
+
+      unsigned index = unsigned(mStrings.size());
+      mStrings.push_back(value);
+      mStringIndices.insert(std::make_pair(value, index));
+      stream.Write(index);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryWriter::WriteActor(dtUtil::DataStream& stream, BaseActorObject& actor)
+   {
+      unsigned recordSizePosition = ReserveUnsigned(stream);
+
+      WriteTableString(stream, actor.GetActorType().GetFullName());
+      actor.GetId().ToCompactDataStream(stream);
+      WriteTableString(stream, actor.GetName());
+
+      ActorComponentContainer* compContainer = dynamic_cast<ActorComponentContainer*>(&actor);
+      BaseActorObject* parent = compContainer != NULL ? compContainer->GetParentBaseActor() : NULL;
+      stream.Write(parent != NULL);
+      if (parent != NULL)
+      {
+         parent->GetId().ToCompactDataStream(stream);
+      }
+
+      unsigned numComponentsPosition = ReserveUnsigned(stream);
+      unsigned numComponents = 0;
+      if (compContainer != NULL)
+      {
+         ActorPtrVector comps;
+         compContainer->GetAllComponents(comps);
+         for (ActorPtrVector::iterator i = comps.begin(); i != comps.end(); ++i)
+         {
+            if (!(*i)->IsGhost())
+            {
+               WriteActor(stream, **i);
+               ++numComponents;
+            }
+         }
+      }
+      PatchUnsigned(stream, numComponentsPosition, numComponents);
+
+      WriteProperties(stream, actor);
+
+      PatchUnsigned(stream, recordSizePosition, stream.GetWritePosition() - recordSizePosition - unsigned(sizeof(unsigned)));
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryWriter::WriteProperties(dtUtil::DataStream& stream, BaseActorObject& actor)
+   {
+      unsigned numPropertiesPosition = ReserveUnsigned(stream);
+      unsigned numProperties = 0;
+
+      PropertyContainer::PropertyConstVector propList;
+      actor.GetPropertyList(propList);
+      for (PropertyContainer::PropertyConstVector::const_iterator i = propList.begin(); i != propList.end(); ++i)
+      {
+         const ActorProperty& property = **i;
+         if (!actor.ShouldPropertySave(property))
+         {
+            continue;
+         }
+
+         WriteTableString(stream, property.GetName());
+         WritePropertyValue(stream, property);
+         ++numProperties;
+      }
+
+      PatchUnsigned(stream, numPropertiesPosition, numProperties);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void MapBinaryWriter::WritePropertyValue(dtUtil::DataStream& stream, const ActorProperty& property)
+   {
+      const DataType& dataType = property.GetDataType();
+      unsigned char encoding = VALUE_STRING;
+
+      // The encoding is written first and patched once the value is written.
+      unsigned encodingPosition = stream.GetWritePosition();
+      stream.Write(encoding);
+      stream.Write((unsigned char)(dataType.GetTypeId()));
+      unsigned valueSizePosition = ReserveUnsigned(stream);
+
+      switch (dataType.GetTypeId())
+      {
+      case DataType::FLOAT_ID:
+         if (const FloatActorProperty* p = dynamic_cast<const FloatActorProperty*>(&property))
+         {
+            encoding = VALUE_FLOAT;
+            stream.Write(p->GetValue());
+         }
+         break;
+      case DataType::DOUBLE_ID:
+         if (const DoubleActorProperty* p = dynamic_cast<const DoubleActorProperty*>(&property))
+         {
+            encoding = VALUE_DOUBLE;
+            stream.Write(p->GetValue());
+         }
+         break;
+      case DataType::INT_ID:
+         if (const IntActorProperty* p = dynamic_cast<const IntActorProperty*>(&property))
+         {
+            encoding = VALUE_INT;
+            stream.Write(p->GetValue());
+         }
+         break;
+      case DataType::BOOLEAN_ID:
+         if (const BooleanActorProperty* p = dynamic_cast<const BooleanActorProperty*>(&property))
+         {
+            encoding = VALUE_BOOL;
+            stream.Write(p->GetValue());
+         }
+         break;
+      case DataType::VEC2_ID:
+      case DataType::VEC2F_ID:
+         encoding = VALUE_VEC;
+         WriteVec<Vec2fActorProperty>(stream, property);
+         break;
+      case DataType::VEC2D_ID:
+         encoding = VALUE_VEC;
+         WriteVec<Vec2dActorProperty>(stream, property);
+         break;
+      case DataType::VEC3_ID:
+      case DataType::VEC3F_ID:
+         encoding = VALUE_VEC;
+         WriteVec<Vec3fActorProperty>(stream, property);
+         break;
+      case DataType::VEC3D_ID:
+         encoding = VALUE_VEC;
+         WriteVec<Vec3dActorProperty>(stream, property);
+         break;
+      case DataType::VEC4_ID:
+      case DataType::VEC4F_ID:
+      case DataType::RGBACOLOR_ID:
+         encoding = VALUE_VEC;
+         WriteVec<Vec4fActorProperty>(stream, property);
+         break;
+      case DataType::VEC4D_ID:
+         encoding = VALUE_VEC;
+         WriteVec<Vec4dActorProperty>(stream, property);
+         break;
+      case DataType::ACTOR_ID:
+         if (const ActorIDActorProperty* p = dynamic_cast<const ActorIDActorProperty*>(&property))
+         {
+            encoding = VALUE_ID;
+            p->GetValue().ToCompactDataStream(stream);
+         }
+         else if (const ActorActorProperty* p = dynamic_cast<const ActorActorProperty*>(&property))
+         {
+            encoding = VALUE_ID;
+            BaseActorObject* value = p->GetValue();
+            (value != NULL ? value->GetId() : dtCore::UniqueId(false)).ToCompactDataStream(stream);
+         }
+         break;
+      case DataType::GAMEEVENT_ID:
+         if (const GameEventActorProperty* p = dynamic_cast<const GameEventActorProperty*>(&property))
+         {
+            encoding = VALUE_ID;
+            GameEvent* value = p->GetValue();
+            (value != NULL ? value->GetUniqueId() : dtCore::UniqueId(false)).ToCompactDataStream(stream);
+         }
+         break;
+      case DataType::GROUP_ID:
+      case DataType::ARRAY_ID:
+      case DataType::CONTAINER_ID:
+      case DataType::CONTAINER_SELECTOR_ID:
+      case DataType::PROPERTY_CONTAINER_ID:
+         encoding = VALUE_STREAM;
+         property.ToDataStream(stream);
+         break;
+      default:
+         if (dataType.IsResource())
+         {
+            if (const ResourceActorProperty* p = dynamic_cast<const ResourceActorProperty*>(&property))
+            {
+               encoding = VALUE_RESOURCE;
+               ResourceDescriptor rd = p->GetValue();
+               WriteTableString(stream, rd.IsEmpty() ? std::string() : rd.GetDisplayName());
+               WriteTableString(stream, rd.IsEmpty() ? std::string() : rd.GetResourceIdentifier());
+            }
+         }
+         break;
+      }
+
+      if (encoding == VALUE_STRING)
+      {
+         WriteTableString(stream, property.ToString());
+      }
+
+      unsigned valueEnd = stream.GetWritePosition();
+      stream.Seekp(encodingPosition, dtUtil::DataStream::SeekTypeEnum::SET);
+      stream.Write(encoding);
+      stream.Seekp(valueEnd, dtUtil::DataStream::SeekTypeEnum::SET);
+      PatchUnsigned(stream, valueSizePosition, valueEnd - valueSizePosition - unsigned(sizeof(unsigned)));
+   }
+}
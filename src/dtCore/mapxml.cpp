@@ -48,6 +48,7 @@ DT_DISABLE_WARNING_END
 #include <dtCore/actorcomponentcontainer.h>
 #include <dtCore/actorpropertyserializer.h>
 #include <dtCore/mapxml.h>
+#include <dtCore/mapbinary.h>
 #include <dtCore/map.h>
 #include <dtCore/exceptionenum.h>
 #include <dtCore/gameevent.h>
@@ -238,6 +239,8 @@ namespace dtCore
    MapParser::MapParser()
    : BaseXMLParser()
    , mMapHandler(new MapContentHandler())
+   , mBinaryParser(new MapBinaryParser())
+   , mParsedBinary(false)
    {
       SetHandler(mMapHandler.get());
 
@@ -273,6 +276,13 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    bool MapParser::Parse(const std::string& path, Map** map, bool prefab)
    {
+      mParsedBinary = Map::IsBinaryFileName(path);
+      if (mParsedBinary)
+      {
+         std::string filename = dtUtil::FindFileInPathList(path);
+         return mBinaryParser->Parse(filename.empty() ? path : filename, map, prefab);
+      }
+
       bool result = false;
       dtCore::RefPtr<MapReaderWriter::MapStream> mapStreamObject;
 
@@ -339,6 +349,7 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    bool MapParser::Parse(std::istream& stream, Map** map, bool prefab)
    {
+      mParsedBinary = false;
       if (!prefab)
          mMapHandler->SetMapMode();
       else
@@ -445,6 +456,12 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    MapPtr MapParser::ParseMapHeaderData(const std::string& path, bool prefab) const
    {
+      if (Map::IsBinaryFileName(path))
+      {
+         std::string filename = dtUtil::FindFileInPathList(path);
+         return mBinaryParser->ParseMapHeaderData(filename.empty() ? path : filename, prefab);
+      }
+
       osgDB::Registry* reg = osgDB::Registry::instance();
       dtCore::RefPtr<MapReaderWriter::MapStream> mapStreamObject;
 
@@ -501,6 +518,11 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    Map* MapParser::GetMapBeingParsed()
    {
+      if (mParsedBinary)
+      {
+         return mBinaryParser->GetMapBeingParsed();
+      }
+
       if (!IsParsing())
       {
          return NULL;
@@ -512,6 +534,11 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    const Map* MapParser::GetMapBeingParsed() const
    {
+      if (mParsedBinary)
+      {
+         return mBinaryParser->GetMapBeingParsed();
+      }
+
       if (!IsParsing())
       {
          return NULL;
@@ -523,18 +550,30 @@ namespace dtCore
    /////////////////////////////////////////////////////////////////////////////
    const std::set<std::string>& MapParser::GetMissingActorTypes()
    {
+      if (mParsedBinary)
+      {
+         return mBinaryParser->GetMissingActorTypes();
+      }
       return mMapHandler->GetMissingActorTypes();
    }
 
    /////////////////////////////////////////////////////////////////////////////
    const std::vector<std::string>& MapParser::GetMissingLibraries()
    {
+      if (mParsedBinary)
+      {
+         return mBinaryParser->GetMissingLibraries();
+      }
       return mMapHandler->GetMissingLibraries();
    }
 
    /////////////////////////////////////////////////////////////////////////////
    bool MapParser::HasDeprecatedProperty() const
    {
+      if (mParsedBinary)
+      {
+         return mBinaryParser->HasDeprecatedProperty();
+      }
       return mMapHandler->HasDeprecatedProperty();
    }
 
@@ -136,17 +136,7 @@ namespace dtCore
       {
          unsigned char id;
          stream >> id;
-         dtCore::DataType* type = NULL;
-
-         for (unsigned int j = 0; j < dtCore::DataType::EnumerateType().size(); j++)
-         {
-            dtCore::DataType* d = dtCore::DataType::EnumerateType()[j];
-            if (d->GetTypeId() == id)
-            {
-               type = d;
-               break;
-            }
-         }
+         dtCore::DataType* type = dtCore::DataType::GetValueForId(id);
          if (type == NULL)
          {
             throw dtCore::BaseException( "The datatype was not found in the stream", __FILE__, __LINE__);
@@ -33,6 +33,7 @@
 #include <dtUtil/stringutils.h>
 #include <dtUtil/datapathutils.h>
 #include <dtUtil/fileutils.h>
+#include <dtUtil/hashmap.h>
 #include <dtUtil/wrapperosgobject.h>
 
 #include <dtCore/project.h>
@@ -40,6 +41,7 @@
 //just to init the constants.  being consistent on the way it works.
 #include <dtCore/projectconfigxmlhandler.h>
 #include <dtCore/map.h>
+#include <dtCore/mapbinary.h>
 #include <dtCore/mapxml.h>
 #include <dtCore/datatype.h>
 #include <dtCore/exceptionenum.h>
@@ -50,6 +52,9 @@
 #include <dtCore/actorproxy.h>
 #include <dtCore/resourcedescriptor.h>
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 #include <osgDB/Registry>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
@@ -73,6 +78,8 @@ namespace dtCore
       : mContextReadOnly(true)
       , mResourcesIndexed(false)
       , mEditMode(false)
+      , mResolvedPathCacheEnabled(true)
+      , mResolvedPathGeneration(0)
       {
          libraryManager = &ActorFactory::GetInstance();
          mLogger = &dtUtil::Log::GetInstance(Project::LOG_NAME);
@@ -109,6 +116,29 @@ namespace dtCore
       dtCore::RefPtr<ActorFactory> libraryManager;
       ResourceHelper mResourceHelper;
 
+      /// Where GetResourcePath found a resource, or that it didn't.
+      struct ResolvedResourcePath
+      {
+         ResolvedResourcePath()
+         : mFileType(dtUtil::FILE_NOT_FOUND)
+         , mFoundADir(false)
+         {
+         }
+
+         std::string mPath; //< the path relative to the contexts.
+         dtUtil::FileType mFileType;
+         bool mFoundADir;
+         std::string mFileName;
+      };
+      typedef dtUtil::HashMap<std::string, ResolvedResourcePath> ResolvedPathMap;
+
+      bool mResolvedPathCacheEnabled;
+      //< The results of GetResourcePath, including misses, by category flag and resource identifier.
+      mutable ResolvedPathMap mResolvedPaths;
+      mutable Project::ResourcePathCacheStatistics mResolvedPathStatistics;
+      mutable OpenThreads::Mutex mResolvedPathMutex;
+      unsigned mResolvedPathGeneration; //< changed whenever the cache is cleared.
+
       dtUtil::Log* mLogger;
 
       // Internal context add that doesn't refresh
@@ -128,6 +158,11 @@ namespace dtCore
 
       MapPtr InternalLoadPrefab(const std::string& fullPath, dtCore::ActorRefPtrVector& actorsOut);
 
+      //searches the contexts in order for a resource path.
+      ResolvedResourcePath SearchResourcePath(const std::string& path, bool isCategory) const;
+      //empties the GetResourcePath cache, which must happen whenever the contexts or their files change.
+      void ClearResolvedPaths();
+
       //internal handling of closing a sincle map.
       void InternalCloseMap(Map& map, bool unloadLibraries);
 
@@ -423,6 +458,7 @@ namespace dtCore
       }
 
       mContexts.push_back(dtUtil::FileUtils::GetInstance().CurrentDirectory());
+      ClearResolvedPaths();
       const std::string& context = mContexts.back();
       std::string searchPath = dtUtil::GetDataFilePathList();
 
@@ -464,6 +500,7 @@ namespace dtCore
             dtUtil::SetDataFilePathList(searchPath);
          }
          mContexts.erase(mContexts.begin() + slot);
+         ClearResolvedPaths();
       }
    }
 
@@ -558,6 +595,7 @@ namespace dtCore
       //clear out the list of mResources.
       mImpl->mResources.clear();
       mImpl->mResourcesIndexed = false;
+      mImpl->ClearResolvedPaths();
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -588,6 +626,10 @@ namespace dtCore
       {
          isMapValid = false;
       }
+      catch (dtCore::MapParsingException&)
+      {
+         isMapValid = false;
+      }
 
       return isMapValid;
    }
@@ -685,6 +727,7 @@ namespace dtCore
    {
       dtUtil::FileExtensionList extensions; ///list of acceptable file extensions
       extensions.push_back("." + dtCore::Map::MAP_FILE_EXTENSION);
+      extensions.push_back("." + dtCore::Map::MAP_BINARY_FILE_EXTENSION);
       extensions.push_back(".xml");
       extensions.push_back(""); // allow for folder recursion.
 
@@ -1113,7 +1156,7 @@ namespace dtCore
 
       std::string fileName = name, curExt;
       curExt = osgDB::getLowerCaseFileExtension(fileName);
-      if (curExt != Map::PREFAB_FILE_EXTENSION)
+      if (curExt != Map::PREFAB_FILE_EXTENSION && curExt != Map::PREFAB_BINARY_FILE_EXTENSION)
       {
          fileName.append(".").append(Map::PREFAB_FILE_EXTENSION);
       }
@@ -1576,8 +1619,7 @@ namespace dtCore
          for (ProjectImpl::MapListType::const_iterator i = mImpl->mMapList.begin();
             i != mImpl->mMapList.end(); ++i )
          {
-            const std::string& mapFileNameRef = i->second.mFileName;
-            if (newFileName == mapFileNameRef.substr(0, mapFileNameRef.size() - (Map::MAP_FILE_EXTENSION.size() + 1))
+            if (newFileName == osgDB::getNameLessExtension(i->second.mFileName)
                && i->second.mSlotId == slot)
             {
                throw dtCore::ProjectException( std::string("Map named ")
@@ -1691,8 +1733,16 @@ namespace dtCore
 
       //save the file to a separate name first so that
       //it won't blast the old one unless it is successful.
-      dtCore::RefPtr<MapWriter> writer = new MapWriter();
-      writer->Save(map, fullPathSaving, prefab);
+      if (Map::IsBinaryFileName(map.GetFileName()))
+      {
+         dtCore::RefPtr<MapBinaryWriter> writer = new MapBinaryWriter();
+         writer->Save(map, fullPathSaving, prefab);
+      }
+      else
+      {
+         dtCore::RefPtr<MapWriter> writer = new MapWriter();
+         writer->Save(map, fullPathSaving, prefab);
+      }
       return fullPathSaving;
    }
 
@@ -1784,8 +1834,16 @@ namespace dtCore
 
       //save the file to a "saving" file so that if it blows or is killed while saving, the data
       //will not be lost.
-      dtCore::RefPtr<MapWriter> writer = new MapWriter();
-      writer->Save(map, fileName);
+      if (Map::IsBinaryFileName(map.GetFileName()))
+      {
+         dtCore::RefPtr<MapBinaryWriter> writer = new MapBinaryWriter();
+         writer->Save(map, fileName);
+      }
+      else
+      {
+         dtCore::RefPtr<MapWriter> writer = new MapWriter();
+         writer->Save(map, fileName);
+      }
 
 
       //when it completes, move the file to the final name.
@@ -2122,58 +2180,65 @@ namespace dtCore
             std::string("An empty resource was passed in to process: [") + resource.GetResourceIdentifier() + "]", __FILE__, __LINE__);
       }
 
-      const std::string& path = mImpl->mResourceHelper.GetResourcePath(resource);
+      ProjectImpl::ResolvedResourcePath resolved;
+      bool cached = false;
 
+      // The category and file lookups of an identifier can have different results, so they're cached separately.
+      std::string key;
+      key.reserve(resource.GetResourceIdentifier().size() + 1);
+      key.push_back(isCategory ? 'd' : 'f');
+      key.append(resource.GetResourceIdentifier());
 
-      dtUtil::FileUtils& fileUtils = dtUtil::FileUtils::GetInstance();
-
-      // Init to file not found.
-      dtUtil::FileType ftype = dtUtil::FILE_NOT_FOUND;
-
-      dtUtil::FileType expectedType = dtUtil::REGULAR_FILE;
-      if (isCategory)
+      unsigned generation = 0;
+      bool cacheEnabled = false;
       {
-         expectedType = dtUtil::DIRECTORY;
-      }
-
-      //for proper error handling.
-      bool foundADir = false;
-
-      dtUtil::FileInfo resultInfo;
-
-      std::vector<std::string>::const_iterator i, iend;
-      i = mImpl->mContexts.begin();
-      iend = mImpl->mContexts.end();
-      for (; i != iend && ftype != expectedType; ++i)
-      {
-         resultInfo = fileUtils.GetFileInfo(*i + dtUtil::FileUtils::PATH_SEPARATOR + path, true);
-         ftype = resultInfo.fileType;
-
-         if (ftype == dtUtil::DIRECTORY)
+         // The flag is read under the lock since lookups can run on the IO threads while maps load.
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mResolvedPathMutex);
+         cacheEnabled = mImpl->mResolvedPathCacheEnabled;
+         if (cacheEnabled)
          {
-            if (!isCategory)
+            generation = mImpl->mResolvedPathGeneration;
+            ProjectImpl::ResolvedPathMap::const_iterator found = mImpl->mResolvedPaths.find(key);
+            if (found != mImpl->mResolvedPaths.end())
             {
-               // didn't find the resource, but found a directory with that same name.
-               // This is only an error if no file is found in a later path.
-               foundADir = true;
+               resolved = found->second;
+               cached = true;
+               ++mImpl->mResolvedPathStatistics.mNumHits;
+            }
+            else
+            {
+               ++mImpl->mResolvedPathStatistics.mNumMisses;
             }
          }
+      }
+
+      if (!cached)
+      {
+         // Search outside the lock so other threads can still read the cache while the file system is slow.
+         resolved = mImpl->SearchResourcePath(mImpl->mResourceHelper.GetResourcePath(resource), isCategory);
 
-         if (ftype == dtUtil::REGULAR_FILE)
+         if (cacheEnabled)
          {
-            if (isCategory)
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mResolvedPathMutex);
+            // If the cache was cleared or turned off during the search, the result may already be out of date.
+            if (generation == mImpl->mResolvedPathGeneration)
             {
-               break;
+               mImpl->mResolvedPaths.insert(std::make_pair(key, resolved));
+               mImpl->mResolvedPathStatistics.mNumEntries = unsigned(mImpl->mResolvedPaths.size());
             }
          }
       }
 
+      const std::string& path = resolved.mPath;
+      dtUtil::FileType ftype = resolved.mFileType;
+      dtUtil::FileType expectedType = isCategory ? dtUtil::DIRECTORY : dtUtil::REGULAR_FILE;
+
       if (ftype != expectedType)
       {
 
          if (!isCategory)
          {
-            if (!foundADir)
+            if (!resolved.mFoundADir)
             {
                throw ProjectFileNotFoundException(
                   std::string("The specified resource was not found: [") + path + "]", __FILE__, __LINE__);
@@ -2200,7 +2265,102 @@ namespace dtCore
 
       }
 
-      return resultInfo.fileName;
+      return resolved.mFileName;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   ProjectImpl::ResolvedResourcePath ProjectImpl::SearchResourcePath(const std::string& path, bool isCategory) const
+   {
+      dtUtil::FileUtils& fileUtils = dtUtil::FileUtils::GetInstance();
+
+      ResolvedResourcePath result;
+      result.mPath = path;
+
+      dtUtil::FileType expectedType = dtUtil::REGULAR_FILE;
+      if (isCategory)
+      {
+         expectedType = dtUtil::DIRECTORY;
+      }
+
+      dtUtil::FileInfo resultInfo;
+
+      std::vector<std::string>::const_iterator i, iend;
+      i = mContexts.begin();
+      iend = mContexts.end();
+      for (; i != iend && result.mFileType != expectedType; ++i)
+      {
+         resultInfo = fileUtils.GetFileInfo(*i + dtUtil::FileUtils::PATH_SEPARATOR + path, true);
+         result.mFileType = resultInfo.fileType;
+
+         if (result.mFileType == dtUtil::DIRECTORY)
+         {
+            if (!isCategory)
+            {
+               // didn't find the resource, but found a directory with that same name.
+               // This is only an error if no file is found in a later path.
+               result.mFoundADir = true;
+            }
+         }
+
+         if (result.mFileType == dtUtil::REGULAR_FILE)
+         {
+            if (isCategory)
+            {
+               break;
+            }
+         }
+      }
+
+      result.mFileName = resultInfo.fileName;
+      return result;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void ProjectImpl::ClearResolvedPaths()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mResolvedPathMutex);
+      mResolvedPaths.clear();
+      mResolvedPathStatistics.mNumEntries = 0;
+      ++mResolvedPathGeneration;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void Project::SetResourcePathCacheEnabled(bool enabled)
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mResolvedPathMutex);
+         mImpl->mResolvedPathCacheEnabled = enabled;
+      }
+      // This changes the generation, so a search started before the change isn't added afterwards.
+      mImpl->ClearResolvedPaths();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool Project::GetResourcePathCacheEnabled() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mResolvedPathMutex);
+      return mImpl->mResolvedPathCacheEnabled;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void Project::ClearResourcePathCache()
+   {
+      mImpl->ClearResolvedPaths();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   Project::ResourcePathCacheStatistics Project::GetResourcePathCacheStatistics() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mResolvedPathMutex);
+      return mImpl->mResolvedPathStatistics;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void Project::ResetResourcePathCacheStatistics()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mResolvedPathMutex);
+      mImpl->mResolvedPathStatistics.mNumHits = 0;
+      mImpl->mResolvedPathStatistics.mNumMisses = 0;
    }
 
 
@@ -2254,6 +2414,7 @@ namespace dtCore
          mImpl->mResourceHelper.CreateResourceCategory(category, type, curSlot, dataTypeTree, categoryInTree);
          ++curSlot;
       }
+      mImpl->ClearResolvedPaths();
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -2311,6 +2472,7 @@ namespace dtCore
          // TODO see what it does if it things it's already removed it.
          result = result && mImpl->mResourceHelper.RemoveResourceCategory(category, type, recursive, dataTypeTree);
       }
+      mImpl->ClearResolvedPaths();
       return result;
 
    }
@@ -2360,6 +2522,7 @@ namespace dtCore
          dataTypeTree = &mImpl->GetResourcesOfType(type);
 
       result = mImpl->mResourceHelper.AddResource(newName, pathToFile, category, type, dataTypeTree, slot);
+      mImpl->ClearResolvedPaths();
 
       return result;
    }
@@ -2398,6 +2561,7 @@ namespace dtCore
 
          mImpl->mResourceHelper.RemoveResource(resource, resourceTree);
       }
+      mImpl->ClearResolvedPaths();
    }
 
    //////////////////////////////////////////////////////////
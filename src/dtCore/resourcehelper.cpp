@@ -294,8 +294,10 @@ namespace dtCore
                description = "Prefab Resources";
 
                extFilter.insert(std::make_pair("dtprefab","Delta Prefab."));
+               extFilter.insert(std::make_pair("dtprefabb","Binary Delta Prefab."));
                handler = new DefaultResourceTypeHandler(d, "Delta Prefab.", extFilter);
                extMap.insert(std::make_pair("dtprefab", dtCore::RefPtr<ResourceTypeHandler>(handler)));
+               extMap.insert(std::make_pair("dtprefabb", dtCore::RefPtr<ResourceTypeHandler>(handler)));
             }
             else if (d == DataType::SHADER)
             {
@@ -12,6 +12,7 @@
 #include <dtCore/databasepager.h>
 #include <dtCore/view.h>
 #include <dtCore/batchisector.h>
+#include <dtCore/spatialindex.h>
 #include <dtUtil/cullmask.h>
 #include <dtUtil/log.h>
 
@@ -28,6 +29,7 @@ public:
       , mLights(MAX_LIGHTS)
       , mRenderMode(Scene::POINT)
       , mRenderFace(Scene::FRONT)
+      , mSpatialIndex(new SpatialIndex)
    {
    }
 
@@ -46,6 +48,8 @@ public:
    Scene::Face mRenderFace;
 
    dtCore::RefPtr<dtCore::DatabasePager> mPager;
+
+   dtCore::RefPtr<SpatialIndex> mSpatialIndex; ///<Holds the Transformables added to the scene
 };
 
 
@@ -420,12 +424,28 @@ bool Scene::GetHeightOfTerrain(float& heightOfTerrain, float x, float y, float m
 // Performs collision detection and updates physics
 void Scene::OnSystem(const dtUtil::RefString& str, double deltaSim, double deltaReal)
 {
-   if (str == dtCore::System::MESSAGE_EXIT)
+   if (str == dtCore::System::MESSAGE_FRAME_SYNCH)
+   {
+      mImpl->mSpatialIndex->Update();
+   }
+   else if (str == dtCore::System::MESSAGE_EXIT)
    {
       RemoveAllDrawables();
    }
 }
 
+/////////////////////////////////////////////
+SpatialIndex& Scene::GetSpatialIndex()
+{
+   return *mImpl->mSpatialIndex;
+}
+
+/////////////////////////////////////////////
+const SpatialIndex& Scene::GetSpatialIndex() const
+{
+   return *mImpl->mSpatialIndex;
+}
+
 
 /////////////////////////////////////////////
 template<typename T>
@@ -0,0 +1,724 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <prefix/dtcoreprefix.h>
+#include <dtCore/spatialindex.h>
+#include <dtCore/transformable.h>
+
+#include <osg/Matrix>
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dtCore
+{
+   namespace
+   {
+      /// @return true if the sphere overlaps the box.
+      inline bool SphereOverlapsBox(const osg::Vec3& center, float radius, const osg::Vec3& minCorner, const osg::Vec3& maxCorner)
+      {
+         float dist2 = 0.0f;
+         for (unsigned i = 0; i < 3; ++i)
+         {
+            float d = 0.0f;
+            if (center[i] < minCorner[i])
+            {
+               d = minCorner[i] - center[i];
+            }
+            else if (center[i] > maxCorner[i])
+            {
+               d = center[i] - maxCorner[i];
+            }
+            dist2 += d * d;
+         }
+         return dist2 <= radius * radius;
+      }
+
+      inline bool SphereOverlapsSphere(const osg::Vec3& center, float radius, const osg::Vec3& otherCenter, float otherRadius)
+      {
+         const float sum = radius + otherRadius;
+         return (center - otherCenter).length2() <= sum * sum;
+      }
+
+      inline osg::Vec3 GetAbsolutePosition(const Transformable& object)
+      {
+         osg::Matrix matrix;
+         object.GetAbsoluteMatrix(matrix);
+         return matrix.getTrans();
+      }
+
+      /// Cell coordinates are kept within this, so the cast to int is defined and the extent of a query fits in an int.
+      const int MAX_CELL_COORD = 1 << 29;
+
+      inline int ToCellCoord(float coord)
+      {
+         const float cell = std::floor(coord);
+         // Written so a NaN goes to the low end rather than through the cast.
+         if (!(cell > float(-MAX_CELL_COORD)))
+         {
+            return -MAX_CELL_COORD;
+         }
+         if (cell > float(MAX_CELL_COORD))
+         {
+            return MAX_CELL_COORD;
+         }
+         return int(cell);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   SpatialVolume::SpatialVolume()
+   : mIsBox(false)
+   , mRadius(1.0f)
+   , mHalfExtents(1.0f, 1.0f, 1.0f)
+   , mIndex(nullptr)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   SpatialVolume::~SpatialVolume()
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialVolume::SetSphere(float radius)
+   {
+      mIsBox = false;
+      mRadius = radius;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialVolume::SetBox(const osg::Vec3& halfExtents)
+   {
+      mIsBox = true;
+      mHalfExtents = halfExtents;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialVolume::SetAnchor(Transformable* anchor)
+   {
+      mAnchor = anchor;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Transformable* SpatialVolume::GetAnchor() const
+   {
+      return mAnchor.get();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool SpatialVolume::Overlaps(const osg::Vec3& center, float radius) const
+   {
+      if (mIsBox)
+      {
+         return SphereOverlapsBox(center, radius, mCenter - mHalfExtents, mCenter + mHalfExtents);
+      }
+      return SphereOverlapsSphere(center, radius, mCenter, mRadius);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   float SpatialVolume::GetBoundingRadius() const
+   {
+      return mIsBox ? mHalfExtents.length() : mRadius;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool SpatialVolume::IsOccupant(const Transformable& object) const
+   {
+      return std::binary_search(mOccupants.begin(), mOccupants.end(), const_cast<Transformable*>(&object));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool SpatialVolume::Accepts(const Transformable&) const
+   {
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialVolume::OnEnter(Transformable&)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialVolume::OnLeave(Transformable&)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialVolume::OnOccupantDeleted()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////////
+   /////////////////////////////////////////////////////////////////////////////////
+   const float SpatialIndex::DEFAULT_CELL_SIZE = 32.0f;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   SpatialIndex::SpatialIndex(float cellSize)
+   : mCellSize(cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE)
+   , mMaxRadius(0.0f)
+   , mMaxRadiusDirty(false)
+   , mAllMoved(false)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   SpatialIndex::~SpatialIndex()
+   {
+      for (ObjectMap::iterator i = mObjects.begin(); i != mObjects.end(); ++i)
+      {
+         i->first->SetSpatialIndex(nullptr);
+      }
+
+      for (unsigned i = 0; i < mVolumes.size(); ++i)
+      {
+         mVolumes[i]->mIndex = nullptr;
+         mVolumes[i]->mOccupants.clear();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::Insert(Transformable& object, float radius)
+   {
+      SpatialIndex* oldIndex = object.GetSpatialIndex();
+      if (oldIndex != nullptr && oldIndex != this)
+      {
+         oldIndex->Remove(object);
+      }
+
+      ObjectMap::iterator found = mObjects.find(&object);
+
+      if (found != mObjects.end() && radius < found->second.mRadius && found->second.mRadius >= mMaxRadius)
+      {
+         mMaxRadiusDirty = true;
+      }
+      mMaxRadius = std::max(mMaxRadius, radius);
+
+      if (found != mObjects.end())
+      {
+         found->second.mRadius = radius;
+         UpdateObject(object, found->second, true);
+         return;
+      }
+
+      ObjectEntry entry;
+      entry.mRadius = radius;
+      ObjectEntry& inserted = mObjects.insert(std::make_pair(&object, entry)).first->second;
+      UpdateObject(object, inserted, false);
+      object.SetSpatialIndex(this);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::Remove(Transformable& object, bool notifyVolumes)
+   {
+      // The volumes are told after they have all been updated, so OnLeave sees the object gone from all of them.
+      std::vector<dtCore::RefPtr<SpatialVolume> > leftVolumes;
+      if (!RemoveObject(object, leftVolumes) || !notifyVolumes)
+      {
+         return;
+      }
+
+      for (unsigned i = 0; i < leftVolumes.size(); ++i)
+      {
+         leftVolumes[i]->OnLeave(object);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::RemoveDeleted(Transformable& object)
+   {
+      // The object is half destroyed, so the volumes can't be given it.  They hear about it with the next events.
+      std::vector<dtCore::RefPtr<SpatialVolume> > leftVolumes;
+      RemoveObject(object, leftVolumes);
+
+      for (unsigned i = 0; i < leftVolumes.size(); ++i)
+      {
+         Event event;
+         event.mVolume = leftVolumes[i];
+         event.mDeleted = true;
+         mDeletedEvents.push_back(event);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool SpatialIndex::RemoveObject(Transformable& object, std::vector<dtCore::RefPtr<SpatialVolume> >& leftVolumes)
+   {
+      ObjectMap::iterator found = mObjects.find(&object);
+      if (found == mObjects.end())
+      {
+         return false;
+      }
+
+      if (found->second.mRadius > 0.0f && found->second.mRadius >= mMaxRadius)
+      {
+         mMaxRadiusDirty = true;
+      }
+
+      RemoveFromCell(found->second.mCell, object);
+      mObjects.erase(found);
+      object.SetSpatialIndex(nullptr);
+
+      for (unsigned i = 0; i < mVolumes.size(); ++i)
+      {
+         SpatialVolume::OccupantList& occupants = mVolumes[i]->mOccupants;
+         SpatialVolume::OccupantList::iterator occupant = std::lower_bound(occupants.begin(), occupants.end(), &object);
+         if (occupant != occupants.end() && *occupant == &object)
+         {
+            occupants.erase(occupant);
+            leftVolumes.push_back(mVolumes[i]);
+         }
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::UpdateMaxRadius()
+   {
+      mMaxRadius = 0.0f;
+      for (ObjectMap::const_iterator i = mObjects.begin(); i != mObjects.end(); ++i)
+      {
+         mMaxRadius = std::max(mMaxRadius, i->second.mRadius);
+      }
+      mMaxRadiusDirty = false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool SpatialIndex::Contains(const Transformable& object) const
+   {
+      return mObjects.find(const_cast<Transformable*>(&object)) != mObjects.end();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned SpatialIndex::GetNumObjects() const
+   {
+      return unsigned(mObjects.size());
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::MarkMoved(Transformable& object)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMovedMutex);
+      mMoved.push_back(&object);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::MarkAllMoved()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMovedMutex);
+      mAllMoved = true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::AddVolume(SpatialVolume& volume)
+   {
+      if (volume.mIndex == this)
+      {
+         return;
+      }
+
+      if (volume.mIndex != nullptr)
+      {
+         volume.mIndex->RemoveVolume(volume);
+      }
+
+      volume.mIndex = this;
+      mVolumes.push_back(&volume);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::RemoveVolume(SpatialVolume& volume)
+   {
+      if (volume.mIndex != this)
+      {
+         return;
+      }
+
+      volume.mIndex = nullptr;
+      volume.mOccupants.clear();
+
+      for (unsigned i = 0; i < mVolumes.size(); ++i)
+      {
+         if (mVolumes[i].get() == &volume)
+         {
+            mVolumes.erase(mVolumes.begin() + i);
+            break;
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::UpdatePositions()
+   {
+      bool allMoved = false;
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMovedMutex);
+         mMovedProcessing.swap(mMoved);
+         allMoved = mAllMoved;
+         mAllMoved = false;
+      }
+
+      if (allMoved)
+      {
+         for (ObjectMap::iterator i = mObjects.begin(); i != mObjects.end(); ++i)
+         {
+            UpdateObject(*i->first, i->second, true);
+         }
+      }
+      else
+      {
+         // An object moves once for each change to it or to something above it, but it's only read once.
+         std::sort(mMovedProcessing.begin(), mMovedProcessing.end());
+         mMovedProcessing.erase(std::unique(mMovedProcessing.begin(), mMovedProcessing.end()), mMovedProcessing.end());
+
+         for (unsigned i = 0; i < mMovedProcessing.size(); ++i)
+         {
+            // Objects removed since they moved are skipped here, so the pointer is never followed.
+            ObjectMap::iterator found = mObjects.find(mMovedProcessing[i]);
+            if (found != mObjects.end())
+            {
+               UpdateObject(*found->first, found->second, true);
+            }
+         }
+      }
+
+      mMovedProcessing.clear();
+
+      // A stale radius that is too big only makes the queries look further, so it's put off until now.
+      if (mMaxRadiusDirty)
+      {
+         UpdateMaxRadius();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::Update()
+   {
+      UpdatePositions();
+
+      // The objects deleted since the last update left their volumes first.
+      mEvents.clear();
+      mEvents.swap(mDeletedEvents);
+
+      for (unsigned v = 0; v < mVolumes.size(); ++v)
+      {
+         SpatialVolume& volume = *mVolumes[v];
+
+         Transformable* anchor = volume.GetAnchor();
+         if (anchor != nullptr && !GetPosition(*anchor, volume.mCenter))
+         {
+            volume.mCenter = GetAbsolutePosition(*anchor);
+         }
+
+         mScratchOccupants.clear();
+         FindInVolume(volume, mScratchOccupants);
+         std::sort(mScratchOccupants.begin(), mScratchOccupants.end());
+
+         // Both lists are sorted, so walk them together to find what changed.
+         const SpatialVolume::OccupantList& oldOccupants = volume.mOccupants;
+         unsigned oldIdx = 0, newIdx = 0;
+         while (oldIdx < oldOccupants.size() || newIdx < mScratchOccupants.size())
+         {
+            Event event;
+            if (newIdx == mScratchOccupants.size()
+                     || (oldIdx < oldOccupants.size() && oldOccupants[oldIdx] < mScratchOccupants[newIdx]))
+            {
+               event.mObject = oldOccupants[oldIdx++];
+               event.mEntered = false;
+            }
+            else if (oldIdx == oldOccupants.size() || mScratchOccupants[newIdx] < oldOccupants[oldIdx])
+            {
+               event.mObject = mScratchOccupants[newIdx++];
+               event.mEntered = true;
+            }
+            else
+            {
+               ++oldIdx;
+               ++newIdx;
+               continue;
+            }
+            event.mVolume = &volume;
+            mEvents.push_back(event);
+         }
+
+         volume.mOccupants.swap(mScratchOccupants);
+      }
+
+      // Callbacks may add or remove volumes and objects, so only send the events that still apply.
+      for (unsigned i = 0; i < mEvents.size(); ++i)
+      {
+         Event& event = mEvents[i];
+         if (event.mVolume->mIndex != this)
+         {
+            continue;
+         }
+
+         if (event.mDeleted)
+         {
+            event.mVolume->OnOccupantDeleted();
+         }
+         else if (!event.mObject.valid())
+         {
+            continue;
+         }
+         else if (event.mEntered)
+         {
+            event.mVolume->OnEnter(*event.mObject.get());
+         }
+         else
+         {
+            event.mVolume->OnLeave(*event.mObject.get());
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      struct SphereQuery
+      {
+         SphereQuery(const osg::Vec3& center, float radius, std::vector<Transformable*>& toFill)
+         : mCenter(center), mRadius(radius), mToFill(toFill)
+         {
+         }
+
+         void operator()(const Transformable* object, const osg::Vec3& position, float radius)
+         {
+            if (SphereOverlapsSphere(mCenter, mRadius, position, radius))
+            {
+               mToFill.push_back(const_cast<Transformable*>(object));
+            }
+         }
+
+         osg::Vec3 mCenter;
+         float mRadius;
+         std::vector<Transformable*>& mToFill;
+      };
+
+      struct BoxQuery
+      {
+         BoxQuery(const osg::Vec3& minCorner, const osg::Vec3& maxCorner, std::vector<Transformable*>& toFill)
+         : mMin(minCorner), mMax(maxCorner), mToFill(toFill)
+         {
+         }
+
+         void operator()(const Transformable* object, const osg::Vec3& position, float radius)
+         {
+            if (SphereOverlapsBox(position, radius, mMin, mMax))
+            {
+               mToFill.push_back(const_cast<Transformable*>(object));
+            }
+         }
+
+         osg::Vec3 mMin, mMax;
+         std::vector<Transformable*>& mToFill;
+      };
+
+      struct VolumeQuery
+      {
+         VolumeQuery(const SpatialVolume& volume, std::vector<Transformable*>& toFill)
+         : mVolume(volume), mAnchor(volume.GetAnchor()), mToFill(toFill)
+         {
+         }
+
+         void operator()(const Transformable* object, const osg::Vec3& position, float radius)
+         {
+            if (object != mAnchor && mVolume.Overlaps(position, radius) && mVolume.Accepts(*object))
+            {
+               mToFill.push_back(const_cast<Transformable*>(object));
+            }
+         }
+
+         const SpatialVolume& mVolume;
+         const Transformable* mAnchor;
+         std::vector<Transformable*>& mToFill;
+      };
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::FindInSphere(const osg::Vec3& center, float radius, std::vector<Transformable*>& toFill) const
+   {
+      const osg::Vec3 halfExtents(radius, radius, radius);
+      SphereQuery query(center, radius, toFill);
+      ForEachCandidate(center - halfExtents, center + halfExtents, query);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::FindInBox(const osg::Vec3& minCorner, const osg::Vec3& maxCorner, std::vector<Transformable*>& toFill) const
+   {
+      BoxQuery query(minCorner, maxCorner, toFill);
+      ForEachCandidate(minCorner, maxCorner, query);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::FindInVolume(const SpatialVolume& volume, std::vector<Transformable*>& toFill) const
+   {
+      const osg::Vec3 halfExtents = volume.IsBox() ? volume.GetHalfExtents()
+               : osg::Vec3(volume.GetRadius(), volume.GetRadius(), volume.GetRadius());
+      VolumeQuery query(volume, toFill);
+      ForEachCandidate(volume.GetCenter() - halfExtents, volume.GetCenter() + halfExtents, query);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool SpatialIndex::GetPosition(const Transformable& object, osg::Vec3& position) const
+   {
+      ObjectMap::const_iterator found = mObjects.find(const_cast<Transformable*>(&object));
+      if (found == mObjects.end())
+      {
+         return false;
+      }
+
+      const Cell& cell = mCells.find(found->second.mCell)->second;
+      for (unsigned i = 0; i < cell.size(); ++i)
+      {
+         if (cell[i].mObject == &object)
+         {
+            position = cell[i].mPosition;
+            return true;
+         }
+      }
+      return false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   SpatialIndex::CellKey SpatialIndex::GetCell(const osg::Vec3& position) const
+   {
+      return CellKey(ToCellCoord(position.x() / mCellSize),
+               ToCellCoord(position.y() / mCellSize),
+               ToCellCoord(position.z() / mCellSize));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::UpdateObject(Transformable& object, ObjectEntry& entry, bool inCell)
+   {
+      const osg::Vec3 position = GetAbsolutePosition(object);
+      const CellKey key = GetCell(position);
+
+      if (inCell && key == entry.mCell)
+      {
+         Cell& cell = mCells[key];
+         for (unsigned i = 0; i < cell.size(); ++i)
+         {
+            if (cell[i].mObject == &object)
+            {
+               cell[i].mPosition = position;
+               cell[i].mRadius = entry.mRadius;
+               break;
+            }
+         }
+         return;
+      }
+
+      if (inCell)
+      {
+         RemoveFromCell(entry.mCell, object);
+      }
+
+      CellEntry cellEntry;
+      cellEntry.mObject = &object;
+      cellEntry.mPosition = position;
+      cellEntry.mRadius = entry.mRadius;
+      mCells[key].push_back(cellEntry);
+      entry.mCell = key;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void SpatialIndex::RemoveFromCell(const CellKey& key, const Transformable& object)
+   {
+      CellMap::iterator i = mCells.find(key);
+      if (i == mCells.end())
+      {
+         return;
+      }
+
+      Cell& cell = i->second;
+      for (unsigned j = 0; j < cell.size(); ++j)
+      {
+         if (cell[j].mObject == &object)
+         {
+            // order doesn't matter, so swap with the last one rather than shifting the rest down.
+            cell[j] = cell.back();
+            cell.pop_back();
+            break;
+         }
+      }
+
+      if (cell.empty())
+      {
+         mCells.erase(i);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   template <typename Func>
+   void SpatialIndex::ForEachCandidate(const osg::Vec3& minCorner, const osg::Vec3& maxCorner, Func& func) const
+   {
+      // An object is stored by its center, so one in a cell outside the query can still reach into it.
+      const osg::Vec3 reach(mMaxRadius, mMaxRadius, mMaxRadius);
+      const CellKey minCell = GetCell(minCorner - reach);
+      const CellKey maxCell = GetCell(maxCorner + reach);
+
+      const double numQueryCells = double(maxCell.mX - minCell.mX + 1)
+               * double(maxCell.mY - minCell.mY + 1) * double(maxCell.mZ - minCell.mZ + 1);
+
+      // A query bigger than the populated part of the world is cheaper as a walk over the cells there are.
+      if (numQueryCells > double(mCells.size()))
+      {
+         for (CellMap::const_iterator cell = mCells.begin(); cell != mCells.end(); ++cell)
+         {
+            const CellKey& key = cell->first;
+            if (key.mX < minCell.mX || key.mX > maxCell.mX
+                     || key.mY < minCell.mY || key.mY > maxCell.mY
+                     || key.mZ < minCell.mZ || key.mZ > maxCell.mZ)
+            {
+               continue;
+            }
+
+            const Cell& entries = cell->second;
+            for (unsigned i = 0; i < entries.size(); ++i)
+            {
+               func(entries[i].mObject, entries[i].mPosition, entries[i].mRadius);
+            }
+         }
+         return;
+      }
+
+      for (int x = minCell.mX; x <= maxCell.mX; ++x)
+      {
+         for (int y = minCell.mY; y <= maxCell.mY; ++y)
+         {
+            for (int z = minCell.mZ; z <= maxCell.mZ; ++z)
+            {
+               CellMap::const_iterator cell = mCells.find(CellKey(x, y, z));
+               if (cell == mCells.end())
+               {
+                  continue;
+               }
+
+               const Cell& entries = cell->second;
+               for (unsigned i = 0; i < entries.size(); ++i)
+               {
+                  func(entries[i].mObject, entries[i].mPosition, entries[i].mRadius);
+               }
+            }
+         }
+      }
+   }
+}
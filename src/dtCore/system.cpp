@@ -8,6 +8,7 @@
 #include <dtUtil/bits.h>
 #include <dtUtil/mswinmacros.h>
 #include <dtCore/deltawin.h>
+#include <dtCore/transformable.h>
 
 #include <osgViewer/GraphicsWindow>
 #include <ctime>
@@ -699,6 +700,9 @@ namespace dtCore
    ////////////////////////////////////////////////////////////////////////////////
    void SystemImpl::PreFrame(const double deltaSimTime, const double deltaRealTime)
    {
+      // Transforms that aren't Transformables may have moved since the last frame.
+      Transformable::InvalidateAllAbsoluteMatrices();
+
       if (dtUtil::Bits::Has(mSystemStages, System::STAGE_PREFRAME))
       {
          StartStatTimer();
@@ -751,6 +755,9 @@ namespace dtCore
    ////////////////////////////////////////////////////////////////////////////////
    void SystemImpl::PostFrame(const double deltaSimTime, const double deltaRealTime)
    {
+      // The update traversal in the frame may have moved transforms that aren't Transformables.
+      Transformable::InvalidateAllAbsoluteMatrices();
+
       if (dtUtil::Bits::Has(mSystemStages, System::STAGE_POSTFRAME))
       {
          StartStatTimer();
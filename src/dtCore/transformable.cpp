@@ -1,6 +1,7 @@
 #include <prefix/dtcoreprefix.h>
 #include <dtCore/pointaxis.h>
 #include <dtCore/scene.h>
+#include <dtCore/spatialindex.h>
 #include <dtCore/transformable.h>
 #include <dtCore/transform.h>
 #include <dtUtil/log.h>
@@ -17,6 +18,10 @@
 #include <osg/StateSet>
 #include <osg/Version> // For #ifdef
 
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 #include <cassert>
 
 using namespace dtCore;
@@ -58,6 +63,27 @@ namespace dtCore
       osg::Node*        _haltTraversalAtNode;
       osg::NodePathList _nodePaths;
    };
+
+   /// Bumped to drop every cached absolute matrix at once.
+   static OpenThreads::Atomic gAbsoluteMatrixEpoch;
+
+   /// Invalidates the absolute matrix of the Transformables under the drawable, looking through any that aren't.
+   static void InvalidateChildAbsoluteMatrices(DeltaDrawable& drawable)
+   {
+      for (unsigned i = 0; i < drawable.GetNumChildren(); ++i)
+      {
+         DeltaDrawable* child = drawable.GetChild(i);
+         Transformable* childTransformable = child->AsTransformable();
+         if (childTransformable != nullptr)
+         {
+            childTransformable->InvalidateAbsoluteMatrix();
+         }
+         else
+         {
+            InvalidateChildAbsoluteMatrices(*child);
+         }
+      }
+   }
 }
 
 /////////////////////////////////////////////////////////////
@@ -73,6 +99,10 @@ namespace dtCore
       , mNode(&node)
       , mRenderingGeometry(false)
       , mRenderProxyNode(false)
+      , mAbsoluteMatrixValid(false)
+      , mAbsoluteMatrixEpoch(0U)
+      , mAbsoluteMatrixVersion(0U)
+      , mSpatialIndex(nullptr)
       {
 
       }
@@ -99,6 +129,18 @@ namespace dtCore
       ///used for the rendering of the proxy node
       dtCore::RefPtr<PointAxis> mPointAxis;
 
+      /// The cached world coordinate matrix.
+      osg::Matrix mAbsoluteMatrix;
+      bool mAbsoluteMatrixValid;
+      /// The value of gAbsoluteMatrixEpoch when mAbsoluteMatrix was computed.
+      unsigned mAbsoluteMatrixEpoch;
+      /// Bumped on each invalidation so a matrix computed while it was invalidated isn't stored.
+      unsigned mAbsoluteMatrixVersion;
+      /// Lets the absolute matrix be read from more than one thread.
+      OpenThreads::Mutex mAbsoluteMatrixMutex;
+
+      /// The index this is in, which is told whenever the absolute matrix changes.  It clears this when it goes away.
+      SpatialIndex* mSpatialIndex;
    };
 }
 /////////////////////////////////////////////////////////////
@@ -144,6 +186,11 @@ Transformable::~Transformable()
       mImpl->mPointAxis = nullptr;
    }
 
+   if (mImpl->mSpatialIndex != nullptr)
+   {
+      mImpl->mSpatialIndex->RemoveDeleted(*this);
+   }
+
    DeregisterInstance(this);
 
    delete mImpl;
@@ -266,6 +313,109 @@ bool Transformable::GetAbsoluteMatrix(const osg::Node* node, osg::Matrix& wcMatr
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+void Transformable::GetAbsoluteMatrix(osg::Matrix& wcMatrix) const
+{
+   const unsigned epoch = gAbsoluteMatrixEpoch;
+   unsigned version;
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mAbsoluteMatrixMutex);
+      if (mImpl->mAbsoluteMatrixValid && mImpl->mAbsoluteMatrixEpoch == epoch)
+      {
+         wcMatrix = mImpl->mAbsoluteMatrix;
+         return;
+      }
+      version = mImpl->mAbsoluteMatrixVersion;
+   }
+
+   // The lock isn't held while the parents are computed.  They lock their own caches, and invalidation
+   // runs from the top down, so holding it could deadlock.
+   GetParentAbsoluteMatrix(wcMatrix);
+   mImpl->mNode->computeLocalToWorldMatrix(wcMatrix, nullptr);
+
+   OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mAbsoluteMatrixMutex);
+   if (mImpl->mAbsoluteMatrixVersion == version)
+   {
+      mImpl->mAbsoluteMatrix = wcMatrix;
+      mImpl->mAbsoluteMatrixValid = true;
+      mImpl->mAbsoluteMatrixEpoch = epoch;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Transformable::GetParentAbsoluteMatrix(osg::Matrix& wcMatrix) const
+{
+   const TransformableNode* node = mImpl->mNode.get();
+   if (node->getNumParents() == 0U)
+   {
+      wcMatrix.makeIdentity();
+      return;
+   }
+
+   const osg::Node* parentNode = node->getParent(0);
+
+   // Use the parent Transformable's cache if there are only groups, such as the switch of an inactive
+   // drawable, between its node and this one.
+   const DeltaDrawable* parent = GetParent();
+   const Transformable* parentTransformable = parent != nullptr ? const_cast<DeltaDrawable*>(parent)->AsTransformable() : nullptr;
+   if (parentTransformable != nullptr)
+   {
+      const osg::Node* curNode = parentNode;
+      while (curNode != parentTransformable->GetOSGNode() && curNode->asTransform() == nullptr && curNode->getNumParents() > 0U)
+      {
+         curNode = curNode->getParent(0);
+      }
+
+      if (curNode == parentTransformable->GetOSGNode())
+      {
+         parentTransformable->GetAbsoluteMatrix(wcMatrix);
+         return;
+      }
+   }
+
+   if (!GetAbsoluteMatrix(parentNode, wcMatrix))
+   {
+      wcMatrix.makeIdentity();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Transformable::InvalidateAbsoluteMatrix()
+{
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImpl->mAbsoluteMatrixMutex);
+      mImpl->mAbsoluteMatrixValid = false;
+      ++mImpl->mAbsoluteMatrixVersion;
+   }
+
+   if (mImpl->mSpatialIndex != nullptr)
+   {
+      mImpl->mSpatialIndex->MarkMoved(*this);
+   }
+
+   // The children are always visited, since one attached through a node that isn't a Transformable
+   // may have cached its matrix while this one was out of date.
+   InvalidateChildAbsoluteMatrices(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+SpatialIndex* Transformable::GetSpatialIndex() const
+{
+   return mImpl->mSpatialIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Transformable::SetSpatialIndex(SpatialIndex* index)
+{
+   mImpl->mSpatialIndex = index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void Transformable::InvalidateAllAbsoluteMatrices()
+{
+   ++gAbsoluteMatrixEpoch;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void Transformable::SetTransform(const Transform& xform, CoordSysEnum cs)
 {
@@ -282,25 +432,27 @@ void Transformable::SetTransform(const Transform& xform, CoordSysEnum cs)
       {
          //get the parent's world position
          osg::Matrix parentMat;
-         GetAbsoluteMatrix(GetOSGNode()->getParent(0), parentMat);
+         GetParentAbsoluteMatrix(parentMat);
 
          //calc the difference between xform and the parent's world position
          //child * parent^-1
          osg::Matrix relMat = newMat * osg::Matrix::inverse(parentMat);
 
          //pass the rel matrix to this node
-         GetMatrixNode()->setMatrix(relMat);
+         mImpl->mNode->setMatrix(relMat);
       }
       else
       {
          //pass the xform to the this node
-         GetMatrixNode()->setMatrix(newMat);
+         mImpl->mNode->setMatrix(newMat);
       }
    }
    else if(cs == REL_CS)
    {
-     GetMatrixNode()->setMatrix(newMat);
+     mImpl->mNode->setMatrix(newMat);
    }
+
+   InvalidateAbsoluteMatrix();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -311,7 +463,7 @@ void Transformable::GetTransform(Transform& xform, CoordSysEnum cs) const
    if(cs == ABS_CS)
    {
       osg::Matrix newMat;
-      GetAbsoluteMatrix(mt, newMat);
+      GetAbsoluteMatrix(newMat);
       xform.Set(newMat);
    }
    else if(cs == REL_CS)
@@ -324,6 +476,7 @@ void Transformable::GetTransform(Transform& xform, CoordSysEnum cs) const
 ////////////////////////////////////////////////////////////////////////////////
 Transformable::TransformableNode* Transformable::GetMatrixNode()
 {
+   InvalidateAbsoluteMatrix();
    return mImpl->mNode.get();
 }
 
@@ -343,6 +496,7 @@ const osg::Matrix& Transformable::GetMatrix() const
 void Transformable::SetMatrix(const osg::Matrix& mat)
 {
    mImpl->mNode->setMatrix(mat);
+   InvalidateAbsoluteMatrix();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -351,7 +505,17 @@ bool Transformable::AddChild(DeltaDrawable* child)
    // Add the child's node to our's
    if (DeltaDrawable::AddChild(child))
    {
-      GetMatrixNode()->addChild(child->GetOSGNode());
+      mImpl->mNode->addChild(child->GetOSGNode());
+
+      Transformable* childTransformable = child->AsTransformable();
+      if (childTransformable != nullptr)
+      {
+         childTransformable->InvalidateAbsoluteMatrix();
+      }
+      else
+      {
+         InvalidateChildAbsoluteMatrices(*child);
+      }
       return true;
    }
    else
@@ -363,8 +527,18 @@ bool Transformable::AddChild(DeltaDrawable* child)
 ////////////////////////////////////////////////////////////////////////////////
 void Transformable::RemoveChild(DeltaDrawable* child)
 {
-   GetMatrixNode()->removeChild(child->GetOSGNode());
+   mImpl->mNode->removeChild(child->GetOSGNode());
    DeltaDrawable::RemoveChild(child);
+
+   Transformable* childTransformable = child->AsTransformable();
+   if (childTransformable != nullptr)
+   {
+      childTransformable->InvalidateAbsoluteMatrix();
+   }
+   else
+   {
+      InvalidateChildAbsoluteMatrices(*child);
+   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -465,9 +639,23 @@ void Transformable::AddedToScene(Scene* scene)
       }
 
       DeltaDrawable::AddedToScene(scene);
+
+      // Something put in another index on purpose stays there.
+      if (mImpl->mSpatialIndex == nullptr)
+      {
+         scene->GetSpatialIndex().Insert(*this);
+      }
    }
    else
    {
+      Scene* oldScene = GetSceneParent();
       DeltaDrawable::AddedToScene(nullptr);
+
+      if (oldScene != nullptr && mImpl->mSpatialIndex == &oldScene->GetSpatialIndex())
+      {
+         mImpl->mSpatialIndex->Remove(*this);
+      }
    }
+
+   InvalidateAbsoluteMatrix();
 }
@@ -0,0 +1,409 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <prefix/dtcoreprefix.h>
+#include <dtCore/trianglebvh.h>
+
+#include <osg/Geode>
+#include <osg/NodeVisitor>
+#include <osg/TriangleFunctor>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace dtCore
+{
+   namespace
+   {
+      /// Past this depth the tree splits at the median, which keeps it from getting deeper than the traversal stack.
+      const unsigned MAX_MIDPOINT_DEPTH = 32;
+      const unsigned TRAVERSAL_STACK_SIZE = 128;
+
+      inline void ExpandBounds(osg::Vec3& minCorner, osg::Vec3& maxCorner, const osg::Vec3& point)
+      {
+         for (unsigned i = 0; i < 3; ++i)
+         {
+            minCorner[i] = std::min(minCorner[i], point[i]);
+            maxCorner[i] = std::max(maxCorner[i], point[i]);
+         }
+      }
+
+      /// Orders triangle indices by their centroids along one axis.
+      struct CentroidLess
+      {
+         CentroidLess(const std::vector<osg::Vec3>& centroids, unsigned axis)
+         : mCentroids(centroids)
+         , mAxis(axis)
+         {
+         }
+
+         bool operator()(unsigned a, unsigned b) const
+         {
+            return mCentroids[a][mAxis] < mCentroids[b][mAxis];
+         }
+
+         const std::vector<osg::Vec3>& mCentroids;
+         unsigned mAxis;
+      };
+
+      struct CentroidBelow
+      {
+         CentroidBelow(const std::vector<osg::Vec3>& centroids, unsigned axis, float split)
+         : mCentroids(centroids)
+         , mAxis(axis)
+         , mSplit(split)
+         {
+         }
+
+         bool operator()(unsigned index) const
+         {
+            return mCentroids[index][mAxis] < mSplit;
+         }
+
+         const std::vector<osg::Vec3>& mCentroids;
+         unsigned mAxis;
+         float mSplit;
+      };
+
+      bool HitRatioLess(const TriangleBVH::Hit& a, const TriangleBVH::Hit& b)
+      {
+         return a.mRatio < b.mRatio;
+      }
+
+      /// Receives the triangles of a drawable from osg::TriangleFunctor.
+      struct TriangleCollector
+      {
+         TriangleCollector()
+         : mBVH(NULL)
+         {
+         }
+
+         void operator()(const osg::Vec3& v1, const osg::Vec3& v2, const osg::Vec3& v3, bool /*treatVertexDataAsTemporary*/)
+         {
+            mBVH->AddTriangle(v1 * mMatrix, v2 * mMatrix, v3 * mMatrix);
+         }
+
+         TriangleBVH* mBVH;
+         osg::Matrix mMatrix;
+      };
+
+      class TriangleBVHVisitor : public osg::NodeVisitor
+      {
+      public:
+         TriangleBVHVisitor(TriangleBVH& bvh)
+         : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN)
+         {
+            mFunctor.mBVH = &bvh;
+         }
+
+         virtual void apply(osg::Geode& geode)
+         {
+            mFunctor.mMatrix = osg::computeLocalToWorld(getNodePath());
+            for (unsigned i = 0; i < geode.getNumDrawables(); ++i)
+            {
+               geode.getDrawable(i)->accept(mFunctor);
+            }
+         }
+
+      private:
+         osg::TriangleFunctor<TriangleCollector> mFunctor;
+      };
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   TriangleBVH::TriangleBVH()
+   : mBuilt(false)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   TriangleBVH::~TriangleBVH()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void TriangleBVH::Clear()
+   {
+      mTriangles.clear();
+      mNodes.clear();
+      mBuildOrder.clear();
+      mBounds.init();
+      mBuilt = false;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void TriangleBVH::AddNode(osg::Node& node)
+   {
+      TriangleBVHVisitor visitor(*this);
+      node.accept(visitor);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void TriangleBVH::AddTriangles(const std::vector<osg::Vec3>& verts, const std::vector<unsigned>& indices, const osg::Matrix* matrix)
+   {
+      mTriangles.reserve(mTriangles.size() + indices.size() / 3);
+      for (unsigned i = 0; i + 2 < indices.size(); i += 3)
+      {
+         if (matrix != NULL)
+         {
+            AddTriangle(verts[indices[i]] * *matrix, verts[indices[i + 1]] * *matrix, verts[indices[i + 2]] * *matrix);
+         }
+         else
+         {
+            AddTriangle(verts[indices[i]], verts[indices[i + 1]], verts[indices[i + 2]]);
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void TriangleBVH::AddTriangle(const osg::Vec3& v0, const osg::Vec3& v1, const osg::Vec3& v2)
+   {
+      Triangle tri;
+      tri.mV0 = v0;
+      tri.mEdge1 = v1 - v0;
+      tri.mEdge2 = v2 - v0;
+      mTriangles.push_back(tri);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void TriangleBVH::Build()
+   {
+      mNodes.clear();
+      mBounds.init();
+      mBuilt = true;
+
+      if (mTriangles.empty())
+      {
+         return;
+      }
+
+      std::vector<osg::Vec3> centroids(mTriangles.size());
+      mBuildOrder.resize(mTriangles.size());
+      for (unsigned i = 0; i < mTriangles.size(); ++i)
+      {
+         const Triangle& tri = mTriangles[i];
+         centroids[i] = tri.mV0 + (tri.mEdge1 + tri.mEdge2) / 3.0f;
+         mBuildOrder[i] = i;
+      }
+
+      // A balanced tree has about two nodes per leaf.
+      mNodes.reserve(4 * mTriangles.size() / MAX_LEAF_TRIANGLES + 1);
+      BuildNode(0, unsigned(mTriangles.size()), centroids, 0);
+
+      // Store the triangles in leaf order so each leaf reads a contiguous run.
+      std::vector<Triangle> ordered(mTriangles.size());
+      for (unsigned i = 0; i < mBuildOrder.size(); ++i)
+      {
+         ordered[i] = mTriangles[mBuildOrder[i]];
+      }
+      mTriangles.swap(ordered);
+      mBuildOrder.clear();
+
+      mBounds.set(mNodes[0].mMin, mNodes[0].mMax);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned TriangleBVH::BuildNode(unsigned begin, unsigned end, const std::vector<osg::Vec3>& centroids, unsigned depth)
+   {
+      const unsigned nodeIndex = unsigned(mNodes.size());
+      mNodes.push_back(Node());
+
+      osg::Vec3 minCorner(FLT_MAX, FLT_MAX, FLT_MAX), maxCorner(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+      osg::Vec3 centroidMin(minCorner), centroidMax(maxCorner);
+      for (unsigned i = begin; i < end; ++i)
+      {
+         const Triangle& tri = mTriangles[mBuildOrder[i]];
+         ExpandBounds(minCorner, maxCorner, tri.mV0);
+         ExpandBounds(minCorner, maxCorner, tri.mV0 + tri.mEdge1);
+         ExpandBounds(minCorner, maxCorner, tri.mV0 + tri.mEdge2);
+         ExpandBounds(centroidMin, centroidMax, centroids[mBuildOrder[i]]);
+      }
+      mNodes[nodeIndex].mMin = minCorner;
+      mNodes[nodeIndex].mMax = maxCorner;
+
+      const unsigned count = end - begin;
+      if (count <= MAX_LEAF_TRIANGLES)
+      {
+         mNodes[nodeIndex].mOffset = begin;
+         mNodes[nodeIndex].mCount = count;
+         return nodeIndex;
+      }
+
+      osg::Vec3 extent = centroidMax - centroidMin;
+      unsigned axis = 0;
+      if (extent[1] > extent[axis]) axis = 1;
+      if (extent[2] > extent[axis]) axis = 2;
+
+      unsigned* first = &mBuildOrder[0] + begin;
+      unsigned* last = &mBuildOrder[0] + end;
+      unsigned* middle = first;
+      if (depth < MAX_MIDPOINT_DEPTH && extent[axis] > 0.0f)
+      {
+         float split = centroidMin[axis] + 0.5f * extent[axis];
+         middle = std::partition(first, last, CentroidBelow(centroids, axis, split));
+      }
+
+      // All the centroids fell on one side, so split the list in half instead.
+      if (middle == first || middle == last)
+      {
+         middle = first + count / 2;
+         std::nth_element(first, middle, last, CentroidLess(centroids, axis));
+      }
+
+      const unsigned mid = begin + unsigned(middle - first);
+      BuildNode(begin, mid, centroids, depth + 1);
+      unsigned secondChild = BuildNode(mid, end, centroids, depth + 1);
+      mNodes[nodeIndex].mOffset = secondChild;
+      mNodes[nodeIndex].mCount = 0;
+      return nodeIndex;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool TriangleBVH::IsBuilt() const
+   {
+      return mBuilt;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned TriangleBVH::GetNumTriangles() const
+   {
+      return unsigned(mTriangles.size());
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned TriangleBVH::GetNumNodes() const
+   {
+      return unsigned(mNodes.size());
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   const osg::BoundingBox& TriangleBVH::GetBoundingBox() const
+   {
+      return mBounds;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned TriangleBVH::IntersectSegment(const osg::Vec3& start, const osg::Vec3& end, HitList& hitsOut) const
+   {
+      hitsOut.clear();
+      if (mNodes.empty())
+      {
+         return 0;
+      }
+
+      const osg::Vec3 dir = end - start;
+
+      // Set up the slab test.  Axes the segment runs parallel to are only checked for the start being inside.
+      osg::Vec3 invDir;
+      bool parallel[3];
+      for (unsigned i = 0; i < 3; ++i)
+      {
+         parallel[i] = std::abs(dir[i]) < 1e-12f;
+         invDir[i] = parallel[i] ? 0.0f : 1.0f / dir[i];
+      }
+
+      unsigned stack[TRAVERSAL_STACK_SIZE];
+      unsigned stackSize = 0;
+      stack[stackSize++] = 0;
+
+      while (stackSize > 0)
+      {
+         const Node& node = mNodes[stack[--stackSize]];
+
+         float tMin = 0.0f, tMax = 1.0f;
+         bool overlaps = true;
+         for (unsigned i = 0; i < 3 && overlaps; ++i)
+         {
+            if (parallel[i])
+            {
+               overlaps = start[i] >= node.mMin[i] && start[i] <= node.mMax[i];
+            }
+            else
+            {
+               float t0 = (node.mMin[i] - start[i]) * invDir[i];
+               float t1 = (node.mMax[i] - start[i]) * invDir[i];
+               if (t0 > t1)
+               {
+                  std::swap(t0, t1);
+               }
+               tMin = std::max(tMin, t0);
+               tMax = std::min(tMax, t1);
+               overlaps = tMin <= tMax;
+            }
+         }
+
+         if (!overlaps)
+         {
+            continue;
+         }
+
+         if (node.mCount == 0)
+         {
+            stack[stackSize++] = node.mOffset;
+            stack[stackSize++] = unsigned(&node - &mNodes[0]) + 1;
+            continue;
+         }
+
+         for (unsigned i = node.mOffset; i < node.mOffset + node.mCount; ++i)
+         {
+            // Moller-Trumbore, accepting either winding.
+            const Triangle& tri = mTriangles[i];
+            osg::Vec3 p = dir ^ tri.mEdge2;
+            float det = tri.mEdge1 * p;
+            if (std::abs(det) < 1e-12f)
+            {
+               continue;
+            }
+
+            float invDet = 1.0f / det;
+            osg::Vec3 s = start - tri.mV0;
+            float u = (s * p) * invDet;
+            if (u < 0.0f || u > 1.0f)
+            {
+               continue;
+            }
+
+            osg::Vec3 q = s ^ tri.mEdge1;
+            float v = (dir * q) * invDet;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+               continue;
+            }
+
+            float t = (tri.mEdge2 * q) * invDet;
+            if (t < 0.0f || t > 1.0f)
+            {
+               continue;
+            }
+
+            Hit hit;
+            hit.mRatio = t;
+            hit.mPoint = start + dir * t;
+            hit.mNormal = tri.mEdge1 ^ tri.mEdge2;
+            hit.mNormal.normalize();
+            hitsOut.push_back(hit);
+         }
+      }
+
+      std::sort(hitsOut.begin(), hitsOut.end(), HitRatioLess);
+      return unsigned(hitsOut.size());
+   }
+}
@@ -5,6 +5,179 @@
 
 namespace dtCore
 {
+   namespace
+   {
+      const unsigned STRING_SIZE = 36;
+      const char HEX_DIGITS[] = "0123456789abcdef";
+
+      /// @return true if the character is a dash in the 8-4-4-4-12 form.
+      inline bool IsDashPosition(unsigned i)
+      {
+         return i == 8 || i == 13 || i == 18 || i == 23;
+      }
+
+      /// @return the value of a lowercase hex digit, or -1 for anything else, including uppercase.
+      inline int HexValue(char c)
+      {
+         if (c >= '0' && c <= '9')
+         {
+            return c - '0';
+         }
+         if (c >= 'a' && c <= 'f')
+         {
+            return c - 'a' + 10;
+         }
+         return -1;
+      }
+
+      /// The values of the first byte of the compact stream form.
+      enum CompactForm
+      {
+         COMPACT_NULL = 0,
+         COMPACT_BINARY = 1,
+         COMPACT_STRING = 2
+      };
+   }
+
+   ////////////////////////////////////////////////
+   void UniqueId::ParseBinary()
+   {
+      mHigh = 0;
+      mLow = 0;
+      mIsBinary = false;
+
+      if (mId.size() != STRING_SIZE)
+      {
+         return;
+      }
+
+      unsigned long long high = 0, low = 0;
+      unsigned digits = 0;
+      for (unsigned i = 0; i < STRING_SIZE; ++i)
+      {
+         if (IsDashPosition(i))
+         {
+            if (mId[i] != '-')
+            {
+               return;
+            }
+            continue;
+         }
+
+         int value = HexValue(mId[i]);
+         if (value < 0)
+         {
+            return;
+         }
+
+         if (digits < 16)
+         {
+            high = (high << 4) | unsigned(value);
+         }
+         else
+         {
+            low = (low << 4) | unsigned(value);
+         }
+         ++digits;
+      }
+
+      mHigh = high;
+      mLow = low;
+      mIsBinary = true;
+   }
+
+   ////////////////////////////////////////////////
+   bool UniqueId::GetBytes(unsigned char* bytes) const
+   {
+      if (!mIsBinary)
+      {
+         return false;
+      }
+
+      for (unsigned i = 0; i < 8; ++i)
+      {
+         bytes[i] = (unsigned char)(mHigh >> (56 - i * 8));
+         bytes[i + 8] = (unsigned char)(mLow >> (56 - i * 8));
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////
+   void UniqueId::SetBytes(const unsigned char* bytes)
+   {
+      unsigned long long high = 0, low = 0;
+      for (unsigned i = 0; i < 8; ++i)
+      {
+         high = (high << 8) | bytes[i];
+         low = (low << 8) | bytes[i + 8];
+      }
+      SetBinary(high, low);
+   }
+
+   ////////////////////////////////////////////////
+   void UniqueId::SetBinary(unsigned long long high, unsigned long long low)
+   {
+      mHigh = high;
+      mLow = low;
+      mIsBinary = true;
+
+      // The string is kept so ToString can return a reference.
+      mId.resize(STRING_SIZE);
+      unsigned digit = 0;
+      for (unsigned i = 0; i < STRING_SIZE; ++i)
+      {
+         if (IsDashPosition(i))
+         {
+            mId[i] = '-';
+            continue;
+         }
+
+         unsigned long long word = digit < 16 ? mHigh : mLow;
+         unsigned shift = 60 - (digit % 16) * 4;
+         mId[i] = HEX_DIGITS[(word >> shift) & 0xF];
+         ++digit;
+      }
+   }
+
+   ////////////////////////////////////////////////
+   void UniqueId::ToCompactDataStream(dtUtil::DataStream& ds) const
+   {
+      if (mIsBinary)
+      {
+         ds << (unsigned char)(COMPACT_BINARY) << mHigh << mLow;
+      }
+      else if (mId.empty())
+      {
+         ds << (unsigned char)(COMPACT_NULL);
+      }
+      else
+      {
+         ds << (unsigned char)(COMPACT_STRING) << mId;
+      }
+   }
+
+   ////////////////////////////////////////////////
+   void UniqueId::FromCompactDataStream(dtUtil::DataStream& ds)
+   {
+      unsigned char form = COMPACT_NULL;
+      ds >> form;
+      if (form == COMPACT_BINARY)
+      {
+         unsigned long long high = 0, low = 0;
+         ds >> high >> low;
+         SetBinary(high, low);
+      }
+      else if (form == COMPACT_STRING)
+      {
+         ds >> mId;
+         ParseBinary();
+      }
+      else
+      {
+         mId.clear();
+         ParseBinary();
+      }
+   }
    ////////////////////////////////////////////////
    const std::string& UniqueId::ToString() const
    {
@@ -20,6 +193,9 @@ namespace dtCore
       }
 
       mId = rhs.mId;
+      mHigh = rhs.mHigh;
+      mLow = rhs.mLow;
+      mIsBinary = rhs.mIsBinary;
       return *this;
    }
 
@@ -27,6 +203,7 @@ namespace dtCore
    UniqueId& UniqueId::operator=(const std::string& rhs)
    {
       mId = rhs;
+      ParseBinary();
       return *this;
    }
 
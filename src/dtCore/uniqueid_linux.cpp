@@ -13,10 +13,12 @@ UniqueId::UniqueId(bool createNewId)
       uuid_t uuid;
       uuid_generate( uuid );
 
-      char buffer[37];
-      uuid_unparse( uuid, buffer );
-
-      mId = std::string( buffer );
+      // writes the same lowercase string uuid_unparse would.
+      SetBytes( uuid );
+   }
+   else
+   {
+      ParseBinary();
    }
 }
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 
 #include <CoreFoundation/CoreFoundation.h>
@@ -35,10 +37,14 @@ UniqueId::UniqueId(bool createNewId)
       string = CFUUIDCreateString(NULL, uuid);
 
       mId = CFStringRefToStdString(string);
+      // CoreFoundation writes uppercase, but only the lowercase form is held in binary.
+      std::transform(mId.begin(), mId.end(), mId.begin(), ::tolower);
 
       if (string) CFRelease(string);
       CFRelease(uuid);
    }
+
+   ParseBinary();
 }
 
 //bool UniqueId::operator< ( const UniqueId& rhs ) const
@@ -42,4 +42,6 @@ UniqueId::UniqueId(bool createNewId)
          LOG_WARNING("Could not generate UniqueId." );
       }
    }
+
+   ParseBinary();
 }
@@ -109,6 +109,43 @@ size_t Connection::Receive(char* buf, size_t numbytes)
    return result;
 }
 
+size_t Connection::ReceiveBatch(std::vector<char>& buf, std::vector<size_t>& sizes,
+                                size_t packetSize, size_t maxPackets)
+{
+   sizes.clear();
+
+   if (packetSize < 1 || maxPackets < 1)
+   {
+      return 0;
+   }
+
+   if (buf.size() < packetSize * maxPackets)
+   {
+      buf.resize(packetSize * maxPackets);
+   }
+
+   // The socket is non-blocking, so keep reading until it runs dry or the batch is full.
+   while (sizes.size() < maxPackets)
+   {
+      char* slot = &buf[sizes.size() * packetSize];
+      NLint result = nlRead(mSocket, (NLvoid *)slot, (NLint)packetSize);
+
+      if (result == NL_INVALID)
+      {
+         HandleError();
+         break;
+      }
+      else if (result == 0)
+      {
+         break;
+      }
+
+      sizes.push_back(size_t(result));
+   }
+
+   return sizes.size();
+}
+
 void Connection::HandleError()
 {
    NLenum error = nlGetError();
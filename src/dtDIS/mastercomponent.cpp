@@ -31,6 +31,7 @@ MasterComponent::MasterComponent(SharedState* config)
    , mOutgoingMessage(DIS::BIG, config->GetConnectionData().exercise_id)
    , mConfig(config)
    , mDefaultPlugin(new dtDIS::DefaultPlugin())
+   , mMaxPacketsPerTick(0)
 {
    // add support for the network packets
    LoadPlugins(mConfig->GetConnectionData().plug_dir);
@@ -139,35 +140,8 @@ void MasterComponent::ProcessMessage(const dtGame::Message& msg)
    const dtGame::MessageType& mt = msg.GetMessageType();
    if(mt == dtGame::MessageType::TICK_LOCAL)
    {
-      // read the incoming packets
-      const unsigned int MTU = 1500;
-      char buffer[MTU];
-      size_t recvd(0);
-      recvd = mConnection.Receive(buffer , MTU);
-      if (recvd != 0)
-      {
-         mIncomingMessage.Process(buffer , recvd , DIS::BIG);
-      }
-
-      // write the outgoing packets
-      {
-         OutgoingMessage::DataStreamContainer& streams = mOutgoingMessage.GetData();
-
-         while (!streams.empty())
-         {
-            const DIS::DataStream& ds = streams.front();
-            if (ds.size() > MTU)
-            {
-               LOG_WARNING("Network buffer is bigger than LAN supports.")
-            }
-
-            if (ds.size() > 0)
-            {
-               mConnection.Send(&(ds[0]), ds.size());
-            }
-            streams.pop();
-         }
-      }
+      ReceivePackets();
+      SendPackets();
    }
    else if (mt == dtGame::MessageType::INFO_MAP_LOADED)
    {
@@ -186,6 +160,92 @@ void MasterComponent::ProcessMessage(const dtGame::Message& msg)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void MasterComponent::ReceivePackets()
+{
+   mLastTickStatistics = ReceiveStatistics();
+
+   bool moreQueued = true;
+   while (moreQueued)
+   {
+      size_t batchSize = RECEIVE_BATCH_SIZE;
+      if (mMaxPacketsPerTick > 0)
+      {
+         size_t remaining = mMaxPacketsPerTick - mLastTickStatistics.mPacketsReceived;
+         if (remaining < batchSize)
+         {
+            batchSize = remaining;
+         }
+      }
+
+      if (batchSize == 0)
+      {
+         break;
+      }
+
+      size_t count = mConnection.ReceiveBatch(mReceiveBuffer, mReceiveSizes, RECEIVE_SLOT_SIZE, batchSize);
+
+      // a short batch means the socket has been drained.
+      moreQueued = (count == batchSize);
+
+      for (size_t i = 0; i < count; ++i)
+      {
+         ++mLastTickStatistics.mPacketsReceived;
+
+         size_t recvd = mReceiveSizes[i];
+         // A full slot means the datagram was larger than a PDU may be, and was truncated.
+         if (recvd == 0 || recvd > MAX_PACKET_SIZE)
+         {
+            ++mLastTickStatistics.mPacketsDropped;
+            continue;
+         }
+
+         mIncomingMessage.Process(&mReceiveBuffer[i * RECEIVE_SLOT_SIZE], recvd, DIS::BIG);
+         ++mLastTickStatistics.mPacketsProcessed;
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MasterComponent::SendPackets()
+{
+   const unsigned int MTU = 1500;
+   OutgoingMessage::DataStreamContainer& streams = mOutgoingMessage.GetData();
+
+   while (!streams.empty())
+   {
+      const DIS::DataStream& ds = streams.front();
+      if (ds.size() > MTU)
+      {
+         LOG_WARNING("Network buffer is bigger than LAN supports.")
+      }
+
+      if (ds.size() > 0)
+      {
+         mConnection.Send(&(ds[0]), ds.size());
+      }
+      streams.pop();
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void MasterComponent::SetMaxPacketsPerTick(unsigned maxPackets)
+{
+   mMaxPacketsPerTick = maxPackets;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+unsigned MasterComponent::GetMaxPacketsPerTick() const
+{
+   return mMaxPacketsPerTick;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+const MasterComponent::ReceiveStatistics& MasterComponent::GetLastTickStatistics() const
+{
+   return mLastTickStatistics;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 DIS::IncomingMessage& MasterComponent::GetIncomingMessage()
 {
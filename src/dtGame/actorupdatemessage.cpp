@@ -22,8 +22,10 @@
 #include <dtGame/actorupdatemessage.h>
 #include <dtGame/exceptionenum.h>
 #include <dtGame/messageparameter.h>
+#include <dtGame/messageschematable.h>
 #include <dtCore/datatype.h>
 #include <dtCore/actorfactory.h>
+#include <dtUtil/datastream.h>
 
 namespace dtGame
 {
@@ -204,4 +206,169 @@ namespace dtGame
       static_cast<BooleanMessageParameter*>(GetParameter(IS_PARTIAL_UPDATE_PARAMETER))->SetValue(newValue);
    }
 
+   /////////////////////////////////////////////////////////////////
+   void ActorUpdateMessage::ToCompactDataStream(dtUtil::DataStream& stream, MessageSchemaTable& schemas) const
+   {
+      bool newType = false;
+      unsigned short handle = schemas.FindOrAddActorTypeSchema(GetActorTypeCategory(), GetActorTypeName(), newType);
+
+      std::vector<const MessageParameter*> params;
+      mUpdateParameters->GetParameters(params);
+
+      // Look up all the indices first so any new parameter definitions can be written before the values.
+      std::vector<unsigned short> indices(params.size());
+      std::vector<const MessageParameter*> newParams;
+      for (unsigned i = 0; i < params.size(); ++i)
+      {
+         bool newParam = false;
+         indices[i] = schemas.FindOrAddParameter(handle, *params[i], newParam);
+         if (newParam)
+         {
+            newParams.push_back(params[i]);
+         }
+      }
+
+      stream << schemas.GetEpoch();
+      stream << handle;
+      stream << newType;
+      if (newType)
+      {
+         stream << GetActorTypeCategory();
+         stream << GetActorTypeName();
+      }
+
+      stream << (unsigned short)newParams.size();
+      for (unsigned i = 0; i < newParams.size(); ++i)
+      {
+         stream << newParams[i]->GetDataType().GetTypeId();
+         stream << std::string(newParams[i]->GetName());
+         stream << newParams[i]->IsList();
+      }
+
+      stream << GetName();
+      stream << GetPrototypeName();
+      stream << GetPrototypeID();
+      stream << GetParentID();
+      stream << IsPartialUpdate();
+
+      stream << (unsigned short)params.size();
+      for (unsigned i = 0; i < params.size(); ++i)
+      {
+         stream << indices[i];
+         params[i]->ToDataStream(stream);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////
+   bool ActorUpdateMessage::FromCompactDataStream(dtUtil::DataStream& stream, MessageSchemaTable& schemas)
+   {
+      unsigned char epoch = 0;
+      unsigned short handle = 0;
+      bool newType = false;
+      stream >> epoch;
+      stream >> handle;
+      stream >> newType;
+
+      if (epoch != schemas.GetEpoch())
+      {
+         // The writer cleared its table.  The first update it writes after that defines its actor type and is sent
+         // reliably, ahead of any other update of the new epoch that is.  Best effort updates from the old epoch,
+         // or that overtake the new definitions, can't be read.
+         if (!newType)
+         {
+            throw dtGame::InvalidParameterException("Received a compact actor update from another message schema epoch.",
+                     __FILE__, __LINE__);
+         }
+         schemas.Clear();
+         schemas.SetEpoch(epoch);
+      }
+
+      if (newType)
+      {
+         std::string category, name;
+         stream >> category;
+         stream >> name;
+         schemas.DefineActorTypeSchema(handle, category, name);
+      }
+
+      const MessageSchemaTable::ActorTypeSchema* schema = schemas.GetActorTypeSchema(handle);
+      if (schema == NULL)
+      {
+         throw dtGame::InvalidParameterException("Received a compact actor update with an unknown actor type handle.  "
+                  "The sender and receiver message schema tables are out of sync.", __FILE__, __LINE__);
+      }
+
+      unsigned short newParamCount = 0;
+      stream >> newParamCount;
+      for (unsigned i = 0; i < newParamCount; ++i)
+      {
+         unsigned char typeId = 0;
+         std::string name;
+         bool isList = false;
+         stream >> typeId;
+         stream >> name;
+         stream >> isList;
+
+         dtCore::DataType* type = dtCore::DataType::GetValueForId(typeId);
+         if (type == NULL)
+         {
+            throw dtGame::InvalidParameterException("The datatype was not found in the stream", __FILE__, __LINE__);
+         }
+
+         schemas.DefineParameter(handle, MessageSchemaTable::ParameterSchema(dtUtil::RefString(name), *type, isList));
+      }
+
+      SetActorTypeCategory(schema->mCategory);
+      SetActorTypeName(schema->mName);
+
+      std::string value;
+      stream >> value;
+      SetName(value);
+      stream >> value;
+      SetPrototypeName(value);
+
+      dtCore::UniqueId id;
+      stream >> id;
+      SetPrototypeID(id);
+      stream >> id;
+      SetParentID(id);
+
+      bool partial = false;
+      stream >> partial;
+      SetPartialUpdate(partial);
+
+      bool okay = true;
+
+      unsigned short paramCount = 0;
+      stream >> paramCount;
+      for (unsigned i = 0; i < paramCount; ++i)
+      {
+         unsigned short index = 0;
+         stream >> index;
+         if (index >= schema->mParameters.size())
+         {
+            throw dtGame::InvalidParameterException("Received a compact actor update with an unknown parameter index.  "
+                     "The sender and receiver message schema tables are out of sync.", __FILE__, __LINE__);
+         }
+
+         const MessageSchemaTable::ParameterSchema& paramSchema = schema->mParameters[index];
+
+         // Same as the NamedGroupParameter, keep the old parameter if it's the same type so complex parameters can merge.
+         dtCore::RefPtr<MessageParameter> param = mUpdateParameters->GetParameter(paramSchema.mName);
+         if (param.valid() && (param->GetDataType() != *paramSchema.mDataType || param->IsList() != paramSchema.mIsList))
+         {
+            mUpdateParameters->RemoveParameter(paramSchema.mName);
+            param = NULL;
+         }
+
+         if (!param.valid())
+         {
+            param = mUpdateParameters->AddParameter(paramSchema.mName, *paramSchema.mDataType, paramSchema.mIsList);
+         }
+
+         okay = okay && param.valid() && param->FromDataStream(stream);
+      }
+
+      return okay;
+   }
 }
@@ -120,6 +120,15 @@ namespace dtGame
    //////////////////////////////////////////////////////////////////////////////
    //////////////////////////////////////////////////////////////////////////////
 
+   DT_IMPLEMENT_MESSAGE_BEGIN(MapChangeProgressMessage)
+      DT_ADD_PARAMETER(float, PercentComplete)
+      DT_ADD_PARAMETER(unsigned int, NumActorsAdded)
+      DT_ADD_PARAMETER(unsigned int, NumActorsToAdd)
+   DT_IMPLEMENT_MESSAGE_END()
+
+   //////////////////////////////////////////////////////////////////////////////
+   //////////////////////////////////////////////////////////////////////////////
+
    void GameEventMessage::SetGameEvent(const dtCore::GameEvent& event)
    {
       GameEventMessageParameter* mp = static_cast<GameEventMessageParameter*>(GetParameter("GameEvent"));
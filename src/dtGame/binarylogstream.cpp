@@ -41,7 +41,7 @@ namespace dtGame
    const std::string BinaryLogStream::LOGGER_MSGDB_MAGIC_NUMBER("GMLOGMSGDB");
    const std::string BinaryLogStream::LOGGER_INDEX_MAGIC_NUMBER("GMLOGINDEXTAB");
    const unsigned char BinaryLogStream::LOGGER_MAJOR_VERSION = 1;
-   const unsigned char BinaryLogStream::LOGGER_MINOR_VERSION = 1;
+   const unsigned char BinaryLogStream::LOGGER_MINOR_VERSION = 2;
 
    const std::string BinaryLogStream::MESSAGE_DB_EXT(".dlm");
    const std::string BinaryLogStream::INDEX_EXT(".dli");
@@ -148,6 +148,7 @@ namespace dtGame
       indexHeader.msgDBFileNameLength = mMessagesFileName.length();
       indexHeader.msgDBFileName = mMessagesFileName;
       WriteIndexTableHeader(indexHeader);
+      mCurrentMinorVersion = BinaryLogStream::LOGGER_MINOR_VERSION;
 
       mFilesAreOpenForWriting = true; // Write mode - Probably in a Record mode.
 
@@ -466,7 +467,9 @@ namespace dtGame
       unsigned int bufferSize;
       dtUtil::DataStream dataStream;
 
-      dataStream << msg.GetAboutActorId() << msg.GetSendingActorId();
+      // version 1.2 and greater write the ids in the compact form.
+      msg.GetAboutActorId().ToCompactDataStream(dataStream);
+      msg.GetSendingActorId().ToCompactDataStream(dataStream);
       msg.ToDataStream(dataStream);
       bufferSize = dataStream.GetBufferSize();
       WriteToLog((char*)&bufferSize, sizeof(unsigned int), 1, mMessagesFile);
@@ -532,8 +535,16 @@ namespace dtGame
 
          dtUtil::DataStream stream(tempBuffer, bufferSize);
 
-         dtCore::UniqueId sendingActorId, aboutActorId;
-         stream >> aboutActorId >> sendingActorId;
+         dtCore::UniqueId sendingActorId(false), aboutActorId(false);
+         if (mCurrentMinorVersion < 2)
+         {
+            stream >> aboutActorId >> sendingActorId;
+         }
+         else
+         {
+            aboutActorId.FromCompactDataStream(stream);
+            sendingActorId.FromCompactDataStream(stream);
+         }
          msg->SetAboutActorId(aboutActorId);
          msg->SetSendingActorId(sendingActorId);
          msg->FromDataStream(stream);
@@ -28,6 +28,7 @@
 #include <dtUtil/log.h>
 #include <dtUtil/mathdefines.h>
 #include <dtUtil/matrixutil.h>
+#include <dtUtil/threadpool.h>
 #include <dtCore/actortype.h>
 #include <dtGame/gameactor.h>
 #include <dtGame/messagetype.h>
@@ -45,13 +46,42 @@ namespace dtGame
          dtGame::GMComponent::BaseGMComponentType));
    const std::string DeadReckoningComponent::DEFAULT_NAME(TYPE->GetName());
 
+   //////////////////////////////////////////////////////////////////////
+   /// Dead-reckons one contiguous range of the registered actors on a thread pool thread.
+   class DeadReckonTask : public dtUtil::ThreadPoolTask
+   {
+   public:
+      DeadReckonTask()
+         : mComponent(NULL)
+         , mTickMessage(NULL)
+         , mBegin(0)
+         , mEnd(0)
+      {
+      }
+
+      /*override*/ void operator()()
+      {
+         mComponent->DeadReckonRange(mBegin, mEnd, *mTickMessage);
+      }
+
+      DeadReckoningComponent* mComponent;
+      const dtGame::TickMessage* mTickMessage;
+      unsigned mBegin, mEnd;
+   };
+
    //////////////////////////////////////////////////////////////////////
    DeadReckoningComponent::DeadReckoningComponent(dtCore::SystemComponentType& type)
       : dtGame::GMComponent(type)
       , mGroundClamper(new DefaultGroundClamper)
       , mArticSmoothTime(0.5f)
+      , mActorArraysDirty(true)
+      , mUseThreadPool(true)
    {
       mLogger = &dtUtil::Log::GetInstance("deadreckoningcomponent.cpp");
+
+      SubscribeToMessageType(dtGame::MessageType::TICK_REMOTE);
+      SubscribeToMessageType(dtGame::MessageType::INFO_ACTOR_DELETED);
+      SubscribeToMessageType(dtGame::MessageType::INFO_MAP_UNLOAD_BEGIN);
    }
 
    //////////////////////////////////////////////////////////////////////
@@ -87,6 +117,7 @@ namespace dtGame
       else if (message.GetMessageType()  == dtGame::MessageType::INFO_MAP_UNLOAD_BEGIN)
       {
          mRegisteredActors.clear();
+         mActorArraysDirty = true;
          mGroundClamper->SetEyePointActor(NULL);
          mGroundClamper->SetTerrainActor(NULL);
       }
@@ -146,6 +177,18 @@ namespace dtGame
       return *mGroundClamper;
    }
 
+   //////////////////////////////////////////////////////////////////////
+   void DeadReckoningComponent::SetUseThreadPool(bool useThreadPool)
+   {
+      mUseThreadPool = useThreadPool;
+   }
+
+   //////////////////////////////////////////////////////////////////////
+   bool DeadReckoningComponent::GetUseThreadPool() const
+   {
+      return mUseThreadPool;
+   }
+
    //////////////////////////////////////////////////////////////////////
    void DeadReckoningComponent::RegisterActor(dtGame::GameActorProxy& toRegister, DeadReckoningActorComponent& helper)
    {
@@ -179,7 +222,10 @@ namespace dtGame
             "\" is already registered with a helper in the DeadReckoingComponent with name \"" +
             GetName() +  ".\"" , __FILE__, __LINE__);
       }
-      else if (helper.IsUpdated())
+
+      mActorArraysDirty = true;
+
+      if (helper.IsUpdated())
       {
          if (helper.GetEffectiveUpdateMode(toRegister.IsRemote())
             == DeadReckoningActorComponent::UpdateMode::CALCULATE_AND_MOVE_ACTOR)
@@ -225,6 +271,7 @@ namespace dtGame
       if (itor != mRegisteredActors.end())
       {
          mRegisteredActors.erase(itor);
+         mActorArraysDirty = true;
       }
    }
 
@@ -237,48 +284,145 @@ namespace dtGame
    }
 
    //////////////////////////////////////////////////////////////////////
-   void DeadReckoningComponent::TickRemote(const dtGame::TickMessage& tickMessage)
+   void DeadReckoningComponent::BuildActorArrays()
    {
-      mGroundClamper->UpdateEyePoint();
+      mDRHelpers.clear();
+      mDRActors.clear();
+      mDRDrawables.clear();
+      mDRTasks.clear();
+
+      mDRHelpers.reserve(mRegisteredActors.size());
+      mDRActors.reserve(mRegisteredActors.size());
+      mDRDrawables.reserve(mRegisteredActors.size());
+
+      // Stays dirty if an actor isn't in the game manager yet, so it will be picked up on a later tick.
+      mActorArraysDirty = false;
 
       for (std::map<dtCore::UniqueId, dtCore::RefPtr<DeadReckoningActorComponent> >::iterator i = mRegisteredActors.begin();
          i != mRegisteredActors.end(); ++i)
       {
-
          dtGame::GameActorProxy* actor = GetGameManager()->FindGameActorById(i->first);
          if (actor == NULL)
          {
+            mActorArraysDirty = true;
             continue;
          }
 
          dtCore::Transformable* drawable = NULL;
          actor->GetDrawable(drawable);
-         DeadReckoningActorComponent& helper = *i->second;
 
-         if (mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
-         {
-            mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
-               "Dead Reckoning actor named \"%s\" with ID \"%s\" and type \"%s.\"",
-               actor->GetName().c_str(), actor->GetId().ToString().c_str(),
-               actor->GetActorType().GetFullName().c_str());
-         }
+         mDRHelpers.push_back(i->second);
+         mDRActors.push_back(actor);
+         mDRDrawables.push_back(drawable);
+      }
+
+      mDRTransforms.resize(mDRHelpers.size());
+      mDRGroundClampTypes.resize(mDRHelpers.size());
+      mDRTransformChanged.resize(mDRHelpers.size());
+   }
+
+   //////////////////////////////////////////////////////////////////////
+   void DeadReckoningComponent::DeadReckonRange(unsigned begin, unsigned end, const dtGame::TickMessage& tickMessage)
+   {
+      float simTimeDelta = tickMessage.GetDeltaSimTime();
+      double simTime = tickMessage.GetSimulationTime();
+
+      for (unsigned i = begin; i < end; ++i)
+      {
+         DeadReckoningActorComponent& helper = *mDRHelpers[i];
+         dtCore::Transform& xform = mDRTransforms[i];
 
-         dtCore::Transform xform;
          //Init the transform with the last deadreckoned position, not
          //the current actual position, because the current actual can be clamped
          xform.SetTranslation(helper.GetCurrentDeadReckonedTranslation());
          xform.SetRotation(helper.GetCurrentDeadReckonedRotation());
 
-         // Get the current time delta.
-         float simTimeDelta = tickMessage.GetDeltaSimTime();
-         helper.IncrementTimeSinceUpdate(simTimeDelta, tickMessage.GetSimulationTime());
+         helper.IncrementTimeSinceUpdate(simTimeDelta, simTime);
 
+         // NONE reads the transform back from the drawable, so it's left for the calling thread.
+         if (helper.GetDeadReckoningAlgorithm() == DeadReckoningAlgorithm::NONE)
+         {
+            continue;
+         }
 
          // Actual dead reckoning code moved into the helper..
-         BaseGroundClamper::GroundClampRangeType* groundClampingType = &BaseGroundClamper::GroundClampRangeType::NONE;
-         bool transformChanged = helper.DoDR(*drawable, xform, mLogger, groundClampingType);
+         mDRGroundClampTypes[i] = &BaseGroundClamper::GroundClampRangeType::NONE;
+         mDRTransformChanged[i] = helper.DoDR(*mDRDrawables[i], xform, mLogger, mDRGroundClampTypes[i]);
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////
+   void DeadReckoningComponent::RunDeadReckonTasks(const dtGame::TickMessage& tickMessage)
+   {
+      unsigned numActors = unsigned(mDRHelpers.size());
+
+      unsigned numTasks = 1;
+      // The helpers log from DoDR at debug level, so keep the log in order by not splitting it up.
+      if (mUseThreadPool && dtUtil::ThreadPool::IsInitialized() && !mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
+      {
+         numTasks = std::min(dtUtil::ThreadPool::GetNumImmediateWorkerThreads(), numActors / MIN_ACTORS_PER_TASK);
+      }
+
+      if (numTasks <= 1)
+      {
+         DeadReckonRange(0, numActors, tickMessage);
+         return;
+      }
+
+      while (mDRTasks.size() < numTasks)
+      {
+         mDRTasks.push_back(new DeadReckonTask);
+      }
 
-         if (helper.GetDeadReckoningAlgorithm() != DeadReckoningAlgorithm::NONE)
+      // contiguous ranges, so each thread walks its own part of the arrays.
+      unsigned rangeSize = (numActors + numTasks - 1) / numTasks;
+      for (unsigned i = 0; i < numTasks; ++i)
+      {
+         DeadReckonTask& task = *mDRTasks[i];
+         task.mComponent = this;
+         task.mTickMessage = &tickMessage;
+         task.mBegin = std::min(i * rangeSize, numActors);
+         task.mEnd = std::min(task.mBegin + rangeSize, numActors);
+         dtUtil::ThreadPool::AddTask(task);
+      }
+
+      dtUtil::ThreadPool::ExecuteTasks();
+   }
+
+   //////////////////////////////////////////////////////////////////////
+   void DeadReckoningComponent::TickRemote(const dtGame::TickMessage& tickMessage)
+   {
+      mGroundClamper->UpdateEyePoint();
+
+      if (mActorArraysDirty)
+      {
+         BuildActorArrays();
+      }
+
+      RunDeadReckonTasks(tickMessage);
+
+      // Everything from here on can touch the scene graph or the clamper, so it runs in order on this thread.
+      for (unsigned i = 0, iend = unsigned(mDRHelpers.size()); i < iend; ++i)
+      {
+         dtGame::GameActorProxy* actor = mDRActors[i].get();
+         dtCore::Transformable* drawable = mDRDrawables[i];
+         DeadReckoningActorComponent& helper = *mDRHelpers[i];
+         dtCore::Transform& xform = mDRTransforms[i];
+
+         if (mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
+         {
+            mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
+               "Dead Reckoning actor named \"%s\" with ID \"%s\" and type \"%s.\"",
+               actor->GetName().c_str(), actor->GetId().ToString().c_str(),
+               actor->GetActorType().GetFullName().c_str());
+         }
+
+         if (helper.GetDeadReckoningAlgorithm() == DeadReckoningAlgorithm::NONE)
+         {
+            BaseGroundClamper::GroundClampRangeType* groundClampingType = &BaseGroundClamper::GroundClampRangeType::NONE;
+            helper.DoDR(*drawable, xform, mLogger, groundClampingType);
+         }
+         else
          {
             // Only ground clamp and move remote objects.
             if (helper.GetEffectiveUpdateMode(actor->IsRemote())
@@ -288,9 +432,9 @@ namespace dtGame
 
                // Call the ground clamper for the current object. The ground clamper should 
                // be smart enough to know what to do with the supplied values.
-               mGroundClamper->ClampToGround(*groundClampingType, tickMessage.GetSimulationTime(),
+               mGroundClamper->ClampToGround(*mDRGroundClampTypes[i], tickMessage.GetSimulationTime(),
                         xform, *actor,
-                        helper.GetGroundClampingData(), transformChanged, velocity);
+                        helper.GetGroundClampingData(), mDRTransformChanged[i] != 0, velocity);
 
                if(mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
                {
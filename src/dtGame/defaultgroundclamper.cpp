@@ -30,6 +30,7 @@
 #include <dtUtil/boundingshapeutils.h>
 #include <dtUtil/mathdefines.h>
 #include <dtUtil/matrixutil.h>
+#include <dtUtil/threadpool.h>
 #include <osg/io_utils>
 #include <osg/Matrix>
 #include <cmath>
@@ -39,6 +40,141 @@
 
 namespace dtGame
 {
+   namespace
+   {
+      /// The most one point clamps an isector batch can hold.
+      const unsigned MAX_ISECTOR_BATCH_SIZE = 32;
+      /// Queries against the triangle tree are cheap and run in parallel, so they are batched in larger groups.
+      const unsigned MAX_BVH_BATCH_SIZE = 1024;
+      /// The number of triangle tree queries per thread pool task.
+      const unsigned BVH_QUERY_GRAIN_SIZE = 16;
+
+      /// Gives a list of triangle tree hits the interface of a BatchIsector::SingleISector, for FindClosestHit.
+      class HitListAdapter
+      {
+      public:
+         HitListAdapter(const dtCore::TriangleBVH::HitList& hits)
+         : mHits(hits)
+         {
+         }
+
+         unsigned GetNumberOfHits() const { return unsigned(mHits.size()); }
+         void GetHitPoint(osg::Vec3& xyz, int pointNum) const { xyz = mHits[pointNum].mPoint; }
+         void GetHitPointNormal(osg::Vec3& normal, int pointNum) const { normal = mHits[pointNum].mNormal; }
+
+      private:
+         const dtCore::TriangleBVH::HitList& mHits;
+      };
+
+      /// Runs the triangle tree queries of a clamp batch, on the thread pool.
+      class BVHClampQueries
+      {
+      public:
+         BVHClampQueries(const dtCore::TriangleBVH& bvh, const std::vector<osg::Vec3>& points,
+                  std::vector<dtCore::TriangleBVH::HitList>& hits)
+         : mBVH(bvh)
+         , mPoints(points)
+         , mHits(hits)
+         {
+         }
+
+         void operator()(unsigned begin, unsigned end)
+         {
+            for (unsigned i = begin; i < end; ++i)
+            {
+               const osg::Vec3& point = mPoints[i];
+               mBVH.IntersectSegment(osg::Vec3(point[0], point[1], point[2] + 100.0f),
+                        osg::Vec3(point[0], point[1], point[2] - 100.0f), mHits[i]);
+            }
+         }
+
+      private:
+         const dtCore::TriangleBVH& mBVH;
+         const std::vector<osg::Vec3>& mPoints;
+         std::vector<dtCore::TriangleBVH::HitList>& mHits;
+      };
+
+      /**
+       * Finds the hit to clamp to for DefaultGroundClamper::GetClosestHit.
+       * @param hits a SingleISector, or anything with the same hit accessors.  They MUST be ordered highest to lowest.
+       */
+      template <typename HitSource>
+      bool FindClosestHit(const HitSource& hits, GroundClampingData& data, float pointZ,
+               osg::Vec3& outHit, osg::Vec3& outNormal)
+      {
+         bool finalResult = false;
+         bool foundAbove = false, foundBelow = false;
+         float aboveDiff = FLT_MAX, belowDiff = -FLT_MAX;
+         osg::Vec3 aboveHit, aboveOutNormal, belowHit, belowOutNormal;
+         osg::Vec3 tempHit;
+         float modelHeightAllowance = 0.8f * data.GetModelDimensions().z();
+
+         // Loop through all the hits. Find the closest hit above us and below us
+         // NOTE - The hits MUST be in order - highest to lowest or this doesn't work
+         for (unsigned int i = 0; i < hits.GetNumberOfHits(); ++i)
+         {
+            hits.GetHitPoint(tempHit, i);
+            float newDiff = tempHit.z() - pointZ;
+            // The terrain is ABOVE
+            if (newDiff >= 0.0f && newDiff < aboveDiff)
+            {
+               // Keep the old hit if it is already inside the vehicle
+               // (for when you have skirts or ovelapping geometry in terrain)
+               // Note - this could get confused if you have a lot of terrain hits at similar heights.
+               if (!foundAbove || (aboveHit.z() - tempHit.z() > modelHeightAllowance))
+               //if (aboveDiff > modelHeightAllowance)
+               {
+                  aboveDiff = newDiff;
+                  aboveHit = tempHit;
+                  hits.GetHitPointNormal(aboveOutNormal, i);
+                  foundAbove = true;
+               }
+               // Else just keep the last 'above' hit we had
+            }
+            // the terrain is BELOW
+            else if (newDiff < 0.0f && newDiff > belowDiff)
+            {
+               belowDiff = newDiff;
+               belowHit = tempHit;
+               hits.GetHitPointNormal(belowOutNormal, i);
+               foundBelow = true;
+            }
+         }
+
+         // If we found both, we have to pick the right one (prevents snapping with overlapping terrain objects)
+         bool clampUp = (foundAbove && !foundBelow); // we are below ALL terrain, so clamp up.
+         bool clampDown = (foundBelow &&    // clampUp always wins over clampDown
+            data.GetGroundClampType() == GroundClampTypeEnum::FULL);
+
+         if (foundBelow && foundAbove)
+         {
+            // If most of the vehicle is intersecting with the above hit, then clamp up, cause we are intersecting both parts the terrain.
+            if (aboveDiff < modelHeightAllowance)
+            {
+               clampUp = true;
+            }
+            // it didn't fit, so clamp down or do nothing. Note - clampDown is already set above.
+         }
+
+         // Do the actual clamp UP or DOWN
+         if (clampUp)
+         {
+            outHit = aboveHit;
+            outNormal = aboveOutNormal;
+            finalResult = true;
+         }
+         else if (clampDown)
+         {
+            outHit = belowHit;
+            outNormal = belowOutNormal;
+            finalResult = true;
+         }
+         // else -- If not clamping up or down, but found a hit, we are flying above ground
+
+         return finalResult;
+      }
+   }
+
    /////////////////////////////////////////////////////////////////////////////
    // DEFAULT GROUND CLAMPER
    /////////////////////////////////////////////////////////////////////////////
@@ -46,8 +182,14 @@ namespace dtGame
       : dtGame::BaseGroundClamper()
       , mTripleIsector(new dtCore::BatchIsector)
       , mIsector(new dtCore::BatchIsector)
+      , mUseTerrainBVH(false)
+      , mTerrainBVHSetByUser(false)
+      , mTerrainBVHGeneration(0U)
+      , mCoherenceDistance(0.01f)
+      , mNumClampQueries(0U)
+      , mNumCoherentClamps(0U)
    {
-      mGroundClampBatch.reserve(32);
+      mGroundClampBatch.reserve(MAX_ISECTOR_BATCH_SIZE);
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -58,7 +200,8 @@ namespace dtGame
    /////////////////////////////////////////////////////////////////////////////
    bool DefaultGroundClamper::HasValidSurface() const
    {
-      return GetTerrainActor() != NULL;
+      return GetTerrainActor() != NULL
+         || (mUseTerrainBVH && mTerrainBVHSetByUser && mTerrainBVH->GetNumTriangles() > 0);
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -67,6 +210,132 @@ namespace dtGame
       return unsigned(mGroundClampBatch.size());
    }
 
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned DefaultGroundClamper::GetMaxClampBatchSize() const
+   {
+      return mUseTerrainBVH ? MAX_BVH_BATCH_SIZE : MAX_ISECTOR_BATCH_SIZE;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::SetUseTerrainBVH(bool useBVH)
+   {
+      mUseTerrainBVH = useBVH;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   bool DefaultGroundClamper::GetUseTerrainBVH() const
+   {
+      return mUseTerrainBVH;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::SetTerrainBVH(dtCore::TriangleBVH* bvh)
+   {
+      mTerrainBVH = bvh;
+      mTerrainBVHSetByUser = bvh != NULL;
+      mTerrainBVHSource = NULL;
+      ++mTerrainBVHGeneration;
+      if (bvh != NULL)
+      {
+         mUseTerrainBVH = true;
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   dtCore::TriangleBVH* DefaultGroundClamper::GetTerrainBVH()
+   {
+      return mTerrainBVH.get();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::RebuildTerrainBVH()
+   {
+      mTerrainBVH = NULL;
+      mTerrainBVHSetByUser = false;
+      mTerrainBVHSource = NULL;
+      ++mTerrainBVHGeneration;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned DefaultGroundClamper::GetTerrainBVHGeneration() const
+   {
+      return mTerrainBVHGeneration;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::SetCoherenceDistance(float distance)
+   {
+      mCoherenceDistance = distance;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   float DefaultGroundClamper::GetCoherenceDistance() const
+   {
+      return mCoherenceDistance;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned DefaultGroundClamper::GetNumClampQueries() const
+   {
+      return mNumClampQueries;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   unsigned DefaultGroundClamper::GetNumCoherentClamps() const
+   {
+      return mNumCoherentClamps;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::ResetClampCounts()
+   {
+      mNumClampQueries = 0U;
+      mNumCoherentClamps = 0U;
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   dtCore::TriangleBVH* DefaultGroundClamper::GetOrBuildTerrainBVH()
+   {
+      if (!mUseTerrainBVH)
+      {
+         return NULL;
+      }
+
+      if (!mTerrainBVHSetByUser)
+      {
+         dtCore::Transformable* terrain = GetTerrainActor();
+         if (terrain == NULL)
+         {
+            return NULL;
+         }
+
+         if (!mTerrainBVH.valid() || mTerrainBVHSource.get() != terrain)
+         {
+            mTerrainBVH = new dtCore::TriangleBVH;
+            mTerrainBVH->AddNode(*terrain->GetOSGNode());
+            mTerrainBVH->Build();
+            mTerrainBVHSource = terrain;
+            ++mTerrainBVHGeneration;
+
+            GetLogger().LogMessage(dtUtil::Log::LOG_INFO, __FUNCTION__, __LINE__,
+               "Built a ground clamping triangle tree of %u triangles for terrain \"%s\".",
+               mTerrainBVH->GetNumTriangles(), terrain->GetName().c_str());
+         }
+      }
+      else if (!mTerrainBVH->IsBuilt())
+      {
+         mTerrainBVH->Build();
+         ++mTerrainBVHGeneration;
+      }
+
+      if (mTerrainBVH->GetNumTriangles() == 0U)
+      {
+         return NULL;
+      }
+
+      return mTerrainBVH.get();
+   }
+
    /////////////////////////////////////////////////////////////////////////////
    dtCore::BatchIsector& DefaultGroundClamper::GetGroundClampIsector()
    {
@@ -106,76 +375,15 @@ namespace dtGame
       GroundClampingData& data, dtCore::BatchIsector::SingleISector& single, float pointZ,
       osg::Vec3& outHit, osg::Vec3& outNormal)
    {
-      bool finalResult = false; 
-      bool foundAbove = false, foundBelow = false;
-      float aboveDiff = FLT_MAX, belowDiff = -FLT_MAX;
-      osg::Vec3 aboveHit, aboveOutNormal, belowHit, belowOutNormal;
-      osg::Vec3 tempHit;
-      float modelHeightAllowance = 0.8f * data.GetModelDimensions().z();
-
-      // Loop through all the hits. Find the closest hit above us and below us
-      // NOTE - The hits MUST be in order - highest to lowest or this doesn't work
-      for (unsigned int i = 0; i < single.GetNumberOfHits(); ++i)
-      {
-         single.GetHitPoint(tempHit, i);
-         float newDiff = tempHit.z() - pointZ;
-         // The terrain is ABOVE
-         if (newDiff >= 0.0f && newDiff < aboveDiff)
-         {
-            // Keep the old hit if it is already inside the vehicle 
-            // (for when you have skirts or ovelapping geometry in terrain)
-            // Note - this could get confused if you have a lot of terrain hits at similar heights. 
-            if (!foundAbove || (aboveHit.z() - tempHit.z() > modelHeightAllowance))
-            //if (aboveDiff > modelHeightAllowance)
-            {
-               aboveDiff = newDiff;
-               aboveHit = tempHit;
-               single.GetHitPointNormal(aboveOutNormal, i);
-               foundAbove = true;
-            }
-            // Else just keep the last 'above' hit we had
-         }
-         // the terrain is BELOW
-         else if (newDiff < 0.0f && newDiff > belowDiff)
-         {
-            belowDiff = newDiff;
-            belowHit = tempHit;
-            single.GetHitPointNormal(belowOutNormal, i);
-            foundBelow = true;
-         }
-      }
-
-      // If we found both, we have to pick the right one (prevents snapping with overlapping terrain objects)
-      bool clampUp = (foundAbove && !foundBelow); // we are below ALL terrain, so clamp up.
-      bool clampDown = (foundBelow &&    // clampUp always wins over clampDown 
-         data.GetGroundClampType() == GroundClampTypeEnum::FULL); 
-
-      if (foundBelow && foundAbove)
-      {
-         // If most of the vehicle is intersecting with the above hit, then clamp up, cause we are intersecting both parts the terrain. 
-         if (aboveDiff < modelHeightAllowance)
-         {
-            clampUp = true;
-         }
-         // it didn't fit, so clamp down or do nothing. Note - clampDown is already set above.
-      }      
-
-      // Do the actual clamp UP or DOWN
-      if (clampUp)
-      {
-         outHit = aboveHit;
-         outNormal = aboveOutNormal;
-         finalResult = true;
-      }
-      else if (clampDown)
-      {
-         outHit = belowHit;
-         outNormal = belowOutNormal;
-         finalResult = true;
-      }
-      // else -- If not clamping up or down, but found a hit, we are flying above ground
+      return FindClosestHit(single, data, pointZ, outHit, outNormal);
+   }
 
-      return finalResult;
+   /////////////////////////////////////////////////////////////////////////////
+   bool DefaultGroundClamper::GetClosestHitFromList(const dtCore::TransformableActorProxy& actor,
+      GroundClampingData& data, const dtCore::TriangleBVH::HitList& hits, float pointZ,
+      osg::Vec3& outHit, osg::Vec3& outNormal)
+   {
+      return FindClosestHit(HitListAdapter(hits), data, pointZ, outHit, outNormal);
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -236,13 +444,15 @@ namespace dtGame
       dtUtil::Log& logger = GetLogger();
       bool debugEnabled = logger.IsLevelEnabled(dtUtil::Log::LOG_DEBUG);
 
-      mTripleIsector->Reset();
-      mTripleIsector->SetQueryRoot(GetTerrainActor());
+      dtCore::TriangleBVH* bvh = GetOrBuildTerrainBVH();
+      if (bvh == NULL)
+      {
+         mTripleIsector->Reset();
+         mTripleIsector->SetQueryRoot(GetTerrainActor());
+      }
 
       for (unsigned i = 0; i < 3; ++i)
       {
-         dtCore::BatchIsector::SingleISector& single = mTripleIsector->EnableAndGetISector(i);
-
          // The input point should be in world space.
          const osg::Vec3& singlePoint = inOutPoints[i];
 
@@ -262,8 +472,37 @@ namespace dtGame
             logger.LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__, 
                "Intersect point %d [%f, %f, %f].", i, singlePoint.x(), singlePoint.y(), singlePoint.z());
          } 
-         single.SetSectorAsLineSegment(osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] + 100.0f),
-            osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] - 100.0f));
+
+         if (bvh == NULL)
+         {
+            dtCore::BatchIsector::SingleISector& single = mTripleIsector->EnableAndGetISector(i);
+            single.SetSectorAsLineSegment(osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] + 100.0f),
+               osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] - 100.0f));
+         }
+      }
+
+      if (bvh != NULL)
+      {
+         dtCore::TriangleBVH::HitList hits;
+         for (unsigned i = 0; i < 3; ++i)
+         {
+            const osg::Vec3 singlePoint = inOutPoints[i];
+            bvh->IntersectSegment(osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] + 100.0f),
+               osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] - 100.0f), hits);
+
+            osg::Vec3 hp(singlePoint), normal;
+            if (GetClosestHitFromList(actor, data, hits, singlePoint.z(), hp, normal))
+            {
+               if (debugEnabled)
+               {
+                  std::ostringstream ss;
+                  ss << "Found a hit in the terrain triangle tree - old z \"" << singlePoint.z() << "\" new z \"" << hp.z() << "\".";
+                  logger.LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__, ss.str().c_str());
+               }
+               inOutPoints[i] = hp;
+            }
+         }
+         return;
       }
 
       if (mTripleIsector->Update(GetLastEyePoint(), GetEyePointActor() == NULL))
@@ -393,11 +632,7 @@ namespace dtGame
       if( (runtimeData.GetLastClampedTime() + GetIntermittentGroundClampingTimeDelta() )<= currentTime)
       {
          runtimeData.SetLastClampedTime(currentTime);
-         mGroundClampBatch.push_back(std::make_pair(xform, std::make_pair(&actor, &data)));
-         if(mGroundClampBatch.size() == 32)
-         {
-            RunClampBatch();
-         }
+         AddToClampBatch(xform, actor, data);
       }
       else
       {
@@ -420,6 +655,17 @@ namespace dtGame
 
    }
 
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::AddToClampBatch(const dtCore::Transform& xform,
+      dtCore::TransformableActorProxy& actor, GroundClampingData& data)
+   {
+      mGroundClampBatch.push_back(std::make_pair(xform, std::make_pair(&actor, &data)));
+      if (mGroundClampBatch.size() >= GetMaxClampBatchSize())
+      {
+         RunClampBatch();
+      }
+   }
+
    /////////////////////////////////////////////////////////////////////////////
    void DefaultGroundClamper::RunClampBatch()
    {
@@ -428,13 +674,23 @@ namespace dtGame
          return;
       }
 
+      dtCore::TriangleBVH* bvh = GetOrBuildTerrainBVH();
+      if (bvh != NULL)
+      {
+         RunClampBatchWithBVH(*bvh);
+         return;
+      }
+
       dtUtil::Log& logger = GetLogger();
       bool debugEnabled = logger.IsLevelEnabled(dtUtil::Log::LOG_DEBUG);
 
-      if(mGroundClampBatch.size() > 32)
+      // The batch is run in pieces if it was filled for the triangle tree, but the tree couldn't be used.
+      while (mGroundClampBatch.size() > MAX_ISECTOR_BATCH_SIZE)
       {
-         logger.LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__, 
-            "Attempted to batch %u entities, when 32 is the max.", mGroundClampBatch.size());        
+         BatchVector rest(mGroundClampBatch.begin() + MAX_ISECTOR_BATCH_SIZE, mGroundClampBatch.end());
+         mGroundClampBatch.resize(MAX_ISECTOR_BATCH_SIZE);
+         RunClampBatch();
+         mGroundClampBatch.swap(rest);
       }
 
       mIsector->Reset();
@@ -456,6 +712,7 @@ namespace dtGame
          single.SetSectorAsLineSegment(osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] + 100.0f),
                osg::Vec3(singlePoint[0], singlePoint[1], singlePoint[2] - 100.0f));
       }
+      mNumClampQueries += unsigned(mGroundClampBatch.size());
 
       bool ignoreEyePoint = GetEyePointActor() == NULL;
       if (!mIsector->Update(GetLastEyePoint(), ignoreEyePoint))
@@ -480,8 +737,6 @@ namespace dtGame
       for(; i != iend; ++i, ++index)
       {
          dtCore::Transform& xform = i->first;
-         osg::Matrix rotation;
-         xform.GetRotation(rotation);
          osg::Vec3 singlePoint;
          xform.GetTranslation(singlePoint);
 
@@ -490,47 +745,145 @@ namespace dtGame
          dtCore::TransformableActorProxy* actor = i->second.first;
          GroundClampingData* gcData = i->second.second;
 
-         // Get the actor's transformable since it has the transform data.
-         dtCore::Transformable* txable = NULL;
-         actor->GetDrawable(txable);
-
-         // Check if user runtime data is valid.
-         RuntimeData& runtimeData = GetOrCreateRuntimeData(*gcData);
-
          // Default the hit point.
          hp.set(singlePoint.x(), singlePoint.y(), 0.0f);
 
-         if(GetClosestHit(*actor, *gcData, single, singlePoint.z(), hp, normal))
+         bool foundHit = GetClosestHit(*actor, *gcData, single, singlePoint.z(), hp, normal);
+         ApplyClampResult(xform, *actor, *gcData, foundHit, hp, normal);
+      }
+      mGroundClampBatch.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::RunClampBatchWithBVH(dtCore::TriangleBVH& bvh)
+   {
+      const float coherenceDistance2 = mCoherenceDistance * mCoherenceDistance;
+
+      // Pick out the clamps that can reuse their last hit, and queue queries for the rest.
+      mBatchQueryPoints.clear();
+      mBatchQueryIndices.resize(mGroundClampBatch.size());
+      for (unsigned i = 0; i < mGroundClampBatch.size(); ++i)
+      {
+         osg::Vec3 singlePoint;
+         mGroundClampBatch[i].first.GetTranslation(singlePoint);
+
+         RuntimeData& runtimeData = GetOrCreateRuntimeData(*mGroundClampBatch[i].second.second);
+         osg::Vec3 moved = singlePoint - runtimeData.GetLastClampedPosition();
+         if (mCoherenceDistance > 0.0f && runtimeData.IsLastClampedHitValid()
+                  && runtimeData.GetLastClampedHitGeneration() == mTerrainBVHGeneration
+                  && moved.x() * moved.x() + moved.y() * moved.y() < coherenceDistance2
+                  && std::abs(moved.z()) < mCoherenceDistance)
          {
-            if(debugEnabled)
-            {
-               std::ostringstream ss;
-               ss << "Found a hit - old z " << singlePoint.z() << " new z " << hp.z();
-               logger.LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__, ss.str().c_str());
-            }
+            mBatchQueryIndices[i] = -1;
+         }
+         else
+         {
+            mBatchQueryIndices[i] = int(mBatchQueryPoints.size());
+            mBatchQueryPoints.push_back(singlePoint);
+         }
+      }
+
+      const unsigned numQueries = unsigned(mBatchQueryPoints.size());
+      if (mBatchHits.size() < numQueries)
+      {
+         mBatchHits.resize(numQueries);
+      }
 
-            runtimeData.SetLastClampedOffset(hp.z() - singlePoint.z());
+      BVHClampQueries queries(bvh, mBatchQueryPoints, mBatchHits);
+      dtUtil::ThreadPool::ParallelFor(0U, numQueries, BVH_QUERY_GRAIN_SIZE, queries);
 
-            if (gcData->GetAdjustRotationToGround())
+      mNumClampQueries += numQueries;
+      mNumCoherentClamps += unsigned(mGroundClampBatch.size()) - numQueries;
+
+      // Moving the actors isn't thread safe, so the results are applied here.
+      osg::Vec3 normal;
+      osg::Vec3 hp;
+      for (unsigned i = 0; i < mGroundClampBatch.size(); ++i)
+      {
+         dtCore::Transform& xform = mGroundClampBatch[i].first;
+         osg::Vec3 singlePoint;
+         xform.GetTranslation(singlePoint);
+
+         dtCore::TransformableActorProxy* actor = mGroundClampBatch[i].second.first;
+         GroundClampingData* gcData = mGroundClampBatch[i].second.second;
+         RuntimeData& runtimeData = GetOrCreateRuntimeData(*gcData);
+
+         bool foundHit = true;
+         int queryIndex = mBatchQueryIndices[i];
+         if (queryIndex < 0)
+         {
+            hp.set(singlePoint.x(), singlePoint.y(), runtimeData.GetLastClampedHitPoint().z());
+            normal = runtimeData.GetLastClampedNormal();
+         }
+         else
+         {
+            hp.set(singlePoint.x(), singlePoint.y(), 0.0f);
+            foundHit = GetClosestHitFromList(*actor, *gcData, mBatchHits[queryIndex], singlePoint.z(), hp, normal);
+
+            // The saved position isn't updated when the hit is reused, so slow movement still adds up to a new query.
+            if (foundHit)
             {
-               normal.normalize();
-               OrientTransform(xform, rotation, hp, normal);
-               runtimeData.SetLastClampedRotation(rotation);
+               runtimeData.SetLastClampedHit(singlePoint, hp, normal, mTerrainBVHGeneration);
             }
             else
             {
-               xform.Set(hp, rotation);
+               runtimeData.ClearLastClampedHit();
             }
+         }
 
-            txable->SetTransform(xform, dtCore::Transformable::REL_CS);
+         ApplyClampResult(xform, *actor, *gcData, foundHit, hp, normal);
+      }
+      mGroundClampBatch.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void DefaultGroundClamper::ApplyClampResult(dtCore::Transform& xform, dtCore::TransformableActorProxy& actor,
+      GroundClampingData& data, bool foundHit, const osg::Vec3& hitPoint, const osg::Vec3& normal)
+   {
+      dtUtil::Log& logger = GetLogger();
+
+      osg::Matrix rotation;
+      xform.GetRotation(rotation);
+      osg::Vec3 singlePoint;
+      xform.GetTranslation(singlePoint);
+
+      // Get the actor's transformable since it has the transform data.
+      dtCore::Transformable* txable = NULL;
+      actor.GetDrawable(txable);
+
+      // Check if user runtime data is valid.
+      RuntimeData& runtimeData = GetOrCreateRuntimeData(data);
+
+      if (foundHit)
+      {
+         if(logger.IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
+         {
+            std::ostringstream ss;
+            ss << "Found a hit - old z " << singlePoint.z() << " new z " << hitPoint.z();
+            logger.LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__, ss.str().c_str());
+         }
+
+         runtimeData.SetLastClampedOffset(hitPoint.z() - singlePoint.z());
+
+         if (data.GetAdjustRotationToGround())
+         {
+            osg::Vec3 unitNormal(normal);
+            unitNormal.normalize();
+            OrientTransform(xform, rotation, hitPoint, unitNormal);
+            runtimeData.SetLastClampedRotation(rotation);
          }
          else
          {
-            runtimeData.SetLastClampedOffset(0);
-            txable->SetTransform(xform, dtCore::Transformable::REL_CS);
+            xform.Set(hitPoint, rotation);
          }
+
+         txable->SetTransform(xform, dtCore::Transformable::REL_CS);
+      }
+      else
+      {
+         runtimeData.SetLastClampedOffset(0);
+         txable->SetTransform(xform, dtCore::Transformable::REL_CS);
       }
-      mGroundClampBatch.clear();
    }
 
    /////////////////////////////////////////////////////////////////////////////
@@ -595,12 +948,7 @@ namespace dtGame
                   && GetHighResGroundClampingRange() > 0.0f
                   && distanceToEyeSqr > GetHighResGroundClampingRange2()))
          {
-            // this should be moved.
-            mGroundClampBatch.push_back(std::make_pair(xform, std::make_pair(&actor, &data)));
-            if (mGroundClampBatch.size() == 32)
-            {
-               RunClampBatch();
-            }
+            AddToClampBatch(xform, actor, data);
          }
          else
          {
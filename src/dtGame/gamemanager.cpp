@@ -51,10 +51,13 @@
 
 #include <dtCore/system.h>
 #include <dtCore/scene.h>
+#include <dtCore/spatialindex.h>
+#include <dtCore/transformable.h>
 
 #include <dtUtil/stringutils.h>
 #include <dtUtil/log.h>
 
+#include <algorithm>
 #include <list>
 
 namespace dtGame
@@ -435,7 +438,8 @@ namespace dtGame
             // Update mLoadedMaps only when a Map Change takes place.
             // This check is needed to keep the name vec consistent, as single maps may be loaded/unloaded
             // without changing the whole set.
-            if ((*pPrevState == MapChangeStateData::MapChangeState::LOAD || *pPrevState == MapChangeStateData::MapChangeState::UNLOAD) &&
+            if ((*pPrevState == MapChangeStateData::MapChangeState::LOAD || *pPrevState == MapChangeStateData::MapChangeState::UNLOAD
+                  || *pPrevState == MapChangeStateData::MapChangeState::OPEN) &&
                mGMImpl->mMapChangeStateData->GetCurrentState() == MapChangeStateData::MapChangeState::IDLE)
             {
                mGMImpl->mLoadedMaps = mGMImpl->mMapChangeStateData->GetNewMapNames();
@@ -549,16 +553,50 @@ namespace dtGame
       {
          mGMImpl->mGMStatistics.mStatsNumSendNetworkMessages += 1;
 
-         if (!mGMImpl->mSendNetworkMessageQueue.front().valid())
+         // Take it off the queue first because components can send more messages while it's dispatched.
+         dtCore::RefPtr<const Message> messageRef = mGMImpl->mSendNetworkMessageQueue.front();
+         mGMImpl->mSendNetworkMessageQueue.pop();
+
+         if (!messageRef.valid())
          {
             mGMImpl->mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
                "Message in send to network queue is NULL.  Something is majorly wrong with the GameManager.");
             continue;
          }
 
-         DoSendMessageToComponents(*mGMImpl->mSendNetworkMessageQueue.front(), true);
-         mGMImpl->mSendNetworkMessageQueue.pop();
+         DoSendMessageToComponents(*messageRef, true);
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Registers the index of the component receiving a message while it is dispatched,
+   // and unregisters it on the way out, including when shutting down throws.
+   class ComponentDispatchCursor
+   {
+   public:
+      ComponentDispatchCursor(std::vector<size_t*>& cursors)
+         : mCursors(cursors)
+         , mIndex(0)
+      {
+         mCursors.push_back(&mIndex);
+      }
+
+      ~ComponentDispatchCursor()
+      {
+         mCursors.pop_back();
       }
+
+      size_t& GetIndex() { return mIndex; }
+
+   private:
+      std::vector<size_t*>& mCursors;
+      size_t mIndex;
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+   bool IsComponentRemoved(const dtCore::RefPtr<GMComponent>& component)
+   {
+      return !component.valid();
    }
 
    ///////////////////////////////////////////////////////////////////////////////
@@ -566,78 +604,90 @@ namespace dtGame
    {
       //statistics stuff.
       bool logComponents = mGMImpl->mGMStatistics.ShouldWeLogComponents();
-      dtCore::Timer_t frameTickStartCurrent(0);
       bool isATickLocalMessage = (message.GetMessageType() == MessageType::TICK_LOCAL);
 
-      // Components get messages first
-      GMImpl::GMComponentContainer::iterator compItr = mGMImpl->mComponentList.begin();
-      while (compItr != mGMImpl->mComponentList.end())
+      GMImpl::GMComponentContainer& components = mGMImpl->mComponentList;
+
+      // Only change the containers when no other dispatch is walking them.
+      if (mGMImpl->mComponentDispatchCursors.empty())
       {
-         if (mGMImpl->mShuttingDown)
-         {
-            throw GMShutdownException();
-         }
+         // Erase the components set to NULL by RemoveComponent
+         components.erase(std::remove_if(components.begin(), components.end(), IsComponentRemoved), components.end());
 
-         if (compItr->valid() == false) //set from a previous call to RemoveComponent()
+         if (mGMImpl->mComponentSubscribersDirty)
          {
-            //Erase this value from the container and move on. Iterator gets pointed to next in container.
-            compItr = mGMImpl->mComponentList.erase(compItr);
-            continue;
+            mGMImpl->BuildComponentSubscribers();
          }
+      }
 
-         // Statistics information
-         if (logComponents)
-         {
-            frameTickStartCurrent = mGMImpl->mGMStatistics.mStatsTickClock.Tick();
-         }
+      ComponentDispatchCursor cursor(mGMImpl->mComponentDispatchCursors);
 
-         //RefPtr in case it get deleted during a Message. We need to hang onto it for a bit.
-         dtCore::RefPtr<GMComponent>& component = *compItr;
+      // Components that subscribed to message types only get process messages of those types.
+      bool filter = !toNetwork && mGMImpl->mNumSubscribingComponents > 0;
 
-         if (mGMImpl->mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
-         {
-            mGMImpl->mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
-               "Sending Message Type \"" + message.GetMessageType().GetName() + "\" to GMComponent \"" +
-               component->GetName() + "\"");
-         }
+      if (filter && !mGMImpl->mComponentSubscribersDirty)
+      {
+         const GMImpl::GMComponentContainer& subscribers = mGMImpl->GetComponentSubscribers(message.GetMessageType());
+         mGMImpl->mGMStatistics.mStatsNumComponentDispatchesSkipped +=
+            long(mGMImpl->mNumComponentsInSubscribers - subscribers.size());
 
-         try
+         // The table isn't rebuilt while a dispatch is running, so it is safe to walk it.
+         for (size_t i = 0; i < subscribers.size(); ++i)
          {
-            if (toNetwork)
+            if (mGMImpl->mShuttingDown)
             {
-               component->DispatchNetworkMessage(message);
+               throw GMShutdownException();
             }
-            else
+
+            //RefPtr in case it get deleted during a Message. We need to hang onto it for a bit.
+            dtCore::RefPtr<GMComponent> component = subscribers[i];
+
+            if (component->GetGameManager() != this) // removed during this dispatch
             {
-               component->ProcessMessage(message);
+               continue;
+            }
+
+            mGMImpl->SendMessageToComponent(*component, message, toNetwork, logComponents, isATickLocalMessage);
+
+            // Shutdown may have been called from the component, so don't touch the table again.
+            if (mGMImpl->mShuttingDown)
+            {
+               throw GMShutdownException();
             }
          }
-         catch (const dtUtil::Exception& ex)
+         return;
+      }
+
+      // Components get messages first
+      size_t& index = cursor.GetIndex();
+      for (; index < components.size(); ++index)
+      {
+         if (mGMImpl->mShuttingDown)
          {
-            ex.LogException(dtUtil::Log::LOG_ERROR, *mGMImpl->mLogger);
+            throw GMShutdownException();
          }
-         catch (const std::exception& ex)
+
+         //RefPtr in case it get deleted during a Message. We need to hang onto it for a bit.
+         dtCore::RefPtr<GMComponent> component = components[index];
+
+         if (!component.valid()) //set from a call to RemoveComponent() during a dispatch
          {
-            LOG_ERROR(std::string("Caught a std::exception derivative: ") + ex.what());
+            continue;
          }
-         catch (...)
+
+         // The subscriptions changed during a dispatch, so the table is out of date.
+         if (filter && !component->IsSubscribedToMessageType(message.GetMessageType()))
          {
-            LOG_ERROR("Caught an unknown exception in the GM!  Continuing.");
+            ++mGMImpl->mGMStatistics.mStatsNumComponentDispatchesSkipped;
+            continue;
          }
 
-         // Statistics information
-         if (logComponents)
-         {
-            double frameTickDelta =
-               mGMImpl->mGMStatistics.mStatsTickClock.DeltaSec(frameTickStartCurrent,
-                                                               mGMImpl->mGMStatistics.mStatsTickClock.Tick());
+         mGMImpl->SendMessageToComponent(*component, message, toNetwork, logComponents, isATickLocalMessage);
 
-            mGMImpl->mGMStatistics.UpdateDebugStats(component->GetId(),
-                                                    component->GetName(),
-                                                    frameTickDelta, true, isATickLocalMessage);
+         if (mGMImpl->mShuttingDown)
+         {
+            throw GMShutdownException();
          }
-
-         ++compItr;
       }
    }
 
@@ -986,10 +1036,31 @@ namespace dtGame
       component.SetGameManager(this);
       component.SetComponentPriority(priority);
 
-      mGMImpl->mComponentList.push_back(dtCore::RefPtr<GMComponent>(&component)); //vector, list
+      // Insert it after the components of the same or higher priority so that components of
+      // higher priority get messages first, and ones of equal priority in the order they were added.
+      GMImpl::GMComponentContainer& components = mGMImpl->mComponentList;
+      dtCore::RefPtr<GMComponent> componentRef(&component);
+      size_t insertAt = 0;
+      for (size_t i = 0; i < components.size(); ++i)
+      {
+         if (components[i].valid() && CompareComponentPriority(componentRef, components[i]))
+         {
+            break;
+         }
+         insertAt = i + 1;
+      }
+      components.insert(components.begin() + insertAt, componentRef);
 
-      // we sort the items by priority so that components of higher priority get messages first.
-      mGMImpl->mComponentList.sort(CompareComponentPriority);
+      // keep any message being dispatched on the component it was sent to.
+      std::vector<size_t*>& cursors = mGMImpl->mComponentDispatchCursors;
+      for (size_t i = 0; i < cursors.size(); ++i)
+      {
+         if (*cursors[i] >= insertAt)
+         {
+            ++(*cursors[i]);
+         }
+      }
+      mGMImpl->mComponentSubscribersDirty = true;
 
       // notify the component that it was added to the GM
       component.OnAddedToGM();
@@ -1006,9 +1077,16 @@ namespace dtGame
          (*found)->OnRemovedFromGM();
          (*found)->SetGameManager(NULL);
          (*found) = NULL; //RefPtr will be erased from the container later on
+         mGMImpl->mComponentSubscribersDirty = true;
       }
    }
 
+   ///////////////////////////////////////////////////////////////////////////////
+   void GameManager::OnComponentSubscriptionsChanged()
+   {
+      mGMImpl->mComponentSubscribersDirty = true;
+   }
+
    ///////////////////////////////////////////////////////////////////////////////
    void GameManager::GetAllComponents(std::vector<GMComponent*>& toFill)
    {
@@ -1881,6 +1959,30 @@ namespace dtGame
       }
    }
 
+   ///////////////////////////////////////////////////////////////////////////////
+   void GameManager::FindActorsWithinRadius(const osg::Vec3& center, float radius, dtCore::ActorPtrVector& toFill)
+   {
+      toFill.clear();
+
+      dtCore::SpatialIndex& index = GetScene().GetSpatialIndex();
+      // Pick up anything that moved earlier this frame.
+      index.UpdatePositions();
+
+      std::vector<dtCore::Transformable*> found;
+      index.FindInSphere(center, radius, found);
+
+      // The drawable of an actor has the id of the actor, so the id leads back to it.  Drawables that aren't
+      // the drawable of an actor, such as parts of one, are left out.
+      for (unsigned i = 0; i < found.size(); ++i)
+      {
+         dtCore::BaseActorObject* actor = FindActorById(found[i]->GetUniqueId());
+         if (actor != NULL && actor->GetDrawable() == found[i])
+         {
+            toFill.push_back(actor);
+         }
+      }
+   }
+
    ///////////////////////////////////////////////////////////////////////////////
    void GameManager::FindPrototypesByActorType(const dtCore::ActorType& type, dtCore::ActorPtrVector& toFill) const
    {
@@ -2003,6 +2105,9 @@ namespace dtGame
    {
       NameVector actuallyLoadedMaps;
 
+      // Project::GetMap can't be called while a map change is opening maps on the IO thread.
+      mGMImpl->mMapChangeStateData->WaitForMapsToOpen();
+
       // Loop on map vec, and directly load all of them.
       // This will send
       NameVector::const_iterator mapItor = mapNames.begin();
@@ -2054,6 +2159,8 @@ namespace dtGame
    {
       NameVector actuallyUnloadedMaps;
 
+      mGMImpl->mMapChangeStateData->WaitForMapsToOpen();
+
       // loop on maps to unload
       NameVector::const_iterator mapItor = mapNames.begin();
       for(; mapItor != mapNames.end(); ++mapItor)
@@ -2358,7 +2465,11 @@ namespace dtGame
    ///////////////////////////////////////////////////////////////////////////////
    void GameManager::Shutdown()
    {
-      if (!mGMImpl->mLoadedMaps.empty())
+      // Stop any map change first, so no maps are being opened on the IO thread while they are closed.
+      bool changingMaps = mGMImpl->mMapChangeStateData->GetCurrentState() != MapChangeStateData::MapChangeState::IDLE;
+      mGMImpl->mMapChangeStateData->CancelMapChange();
+
+      if (changingMaps || !mGMImpl->mLoadedMaps.empty())
       {
          dtCore::Project& project = dtCore::Project::GetInstance();
 
@@ -2386,31 +2497,31 @@ namespace dtGame
       DoSendNetworkMessages();
 
       //tell all the components they've been removed
-      GMImpl::GMComponentContainer::iterator compItr = mGMImpl->mComponentList.begin();
-      while (compItr != mGMImpl->mComponentList.end())
+      for (size_t i = 0; i < mGMImpl->mComponentList.size(); ++i)
       {
-         if (compItr->valid())
+         if (mGMImpl->mComponentList[i].valid())
          {
-            RemoveComponent(**compItr);
+            RemoveComponent(*mGMImpl->mComponentList[i]);
          }
-         ++compItr;
       }
 
       //now purge the component container for real
       mGMImpl->mComponentList.clear();
-
-      mGMImpl->mGMStatistics.mDebugLoggerInformation.clear();
-
-      while (!mGMImpl->mSendNetworkMessageQueue.empty())
+      // A dispatch that called Shutdown may still be walking the subscriber table.
+      if (mGMImpl->mComponentDispatchCursors.empty())
       {
-         mGMImpl->mSendNetworkMessageQueue.pop();
+         mGMImpl->BuildComponentSubscribers();
       }
-
-      while (!mGMImpl->mSendMessageQueue.empty())
+      else
       {
-         mGMImpl->mSendMessageQueue.pop();
+         mGMImpl->mComponentSubscribersDirty = true;
       }
 
+      mGMImpl->mGMStatistics.mDebugLoggerInformation.clear();
+
+      mGMImpl->mSendNetworkMessageQueue.clear();
+      mGMImpl->mSendMessageQueue.clear();
+
       mGMImpl->mShuttingDown = true;
    }
 
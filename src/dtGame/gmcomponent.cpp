@@ -21,8 +21,11 @@
 #include <prefix/dtgameprefix.h>
 #include <dtGame/gmcomponent.h>
 #include <dtGame/message.h>
+#include <dtGame/messagetype.h>
 #include <dtCore/propertymacros.h>
 
+#include <algorithm>
+
 namespace dtGame
 {
    //////////////////////////////////////////////
@@ -74,6 +77,60 @@ namespace dtGame
    {
    }
 
+   //////////////////////////////////////////////
+   void GMComponent::SubscribeToMessageType(const MessageType& type)
+   {
+      if (std::find(mSubscribedMessageTypes.begin(), mSubscribedMessageTypes.end(), &type) != mSubscribedMessageTypes.end())
+      {
+         return;
+      }
+
+      mSubscribedMessageTypes.push_back(&type);
+      if (GetGameManager() != NULL)
+      {
+         GetGameManager()->OnComponentSubscriptionsChanged();
+      }
+   }
+
+   //////////////////////////////////////////////
+   void GMComponent::UnsubscribeFromMessageType(const MessageType& type)
+   {
+      std::vector<const MessageType*>::iterator found =
+         std::find(mSubscribedMessageTypes.begin(), mSubscribedMessageTypes.end(), &type);
+      if (found == mSubscribedMessageTypes.end())
+      {
+         return;
+      }
+
+      mSubscribedMessageTypes.erase(found);
+      if (GetGameManager() != NULL)
+      {
+         GetGameManager()->OnComponentSubscriptionsChanged();
+      }
+   }
+
+   //////////////////////////////////////////////
+   void GMComponent::ClearMessageTypeSubscriptions()
+   {
+      if (mSubscribedMessageTypes.empty())
+      {
+         return;
+      }
+
+      mSubscribedMessageTypes.clear();
+      if (GetGameManager() != NULL)
+      {
+         GetGameManager()->OnComponentSubscriptionsChanged();
+      }
+   }
+
+   //////////////////////////////////////////////
+   bool GMComponent::IsSubscribedToMessageType(const MessageType& type) const
+   {
+      return mSubscribedMessageTypes.empty()
+         || std::find(mSubscribedMessageTypes.begin(), mSubscribedMessageTypes.end(), &type) != mSubscribedMessageTypes.end();
+   }
+
    DT_IMPLEMENT_ACCESSOR(GMComponent, dtUtil::EnumerationPointer<GameManager::ComponentPriority>, ComponentPriority)
 
    //////////////////////////////////////////////
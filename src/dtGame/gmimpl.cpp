@@ -22,6 +22,7 @@
 #include <dtGame/gmimpl.h>
 #include <dtGame/basemessages.h>
 #include <dtGame/messagetype.h>
+#include <dtUtil/log.h>
 
 namespace dtGame
 {
@@ -76,6 +77,9 @@ GMImpl::GMImpl(dtCore::Scene& scene) : mGMStatistics()
 //, mSendCreatesAndDeletes(true)
 //, mAddActorsToScene(true)
 , mFactory("GameManager MessageFactory", *mMachineInfo, "")
+, mNumComponentsInSubscribers(0)
+, mNumSubscribingComponents(0)
+, mComponentSubscribersDirty(false)
 , mScene(&scene)
 , mLibMgr(&dtCore::ActorFactory::GetInstance())
 , mApplication(NULL)
@@ -84,8 +88,134 @@ GMImpl::GMImpl(dtCore::Scene& scene) : mGMStatistics()
 , mRemoveGameEventsOnMapChange(true)
 , mShuttingDown(false)
 {
+   // The GM creates these every frame and nothing should hold on to them, so reuse them.
+   mFactory.SetMessageTypePooled(MessageType::TICK_LOCAL, true);
+   mFactory.SetMessageTypePooled(MessageType::TICK_REMOTE, true);
+   mFactory.SetMessageTypePooled(MessageType::TICK_END_OF_FRAME, true);
+   mFactory.SetMessageTypePooled(MessageType::SYSTEM_POST_EVENT_TRAVERSAL, true);
+   mFactory.SetMessageTypePooled(MessageType::SYSTEM_FRAME_SYNCH, true);
+   mFactory.SetMessageTypePooled(MessageType::SYSTEM_POST_FRAME, true);
+}
+////////////////////////////////////////////////////////////////////////////////
+void GMImpl::BuildComponentSubscribers()
+{
+   mComponentSubscribers.clear();
+   mBroadcastComponents.clear();
+   mNumComponentsInSubscribers = 0;
+   mNumSubscribingComponents = 0;
+
+   // make an entry for every type subscribed to first, so the components that get every message can be added to all of them.
+   for (size_t i = 0; i < mComponentList.size(); ++i)
+   {
+      if (!mComponentList[i].valid() || mComponentList[i]->GetReceivesAllMessages())
+      {
+         continue;
+      }
+
+      ++mNumSubscribingComponents;
+      const std::vector<const MessageType*>& types = mComponentList[i]->GetSubscribedMessageTypes();
+      for (size_t j = 0; j < types.size(); ++j)
+      {
+         mComponentSubscribers[types[j]];
+      }
+   }
+
+   // The component list is in priority order, so each list will be too.
+   for (size_t i = 0; i < mComponentList.size(); ++i)
+   {
+      GMComponent* component = mComponentList[i].get();
+      if (component == NULL)
+      {
+         continue;
+      }
+
+      ++mNumComponentsInSubscribers;
+      if (component->GetReceivesAllMessages())
+      {
+         mBroadcastComponents.push_back(component);
+         for (ComponentSubscriberMap::iterator j = mComponentSubscribers.begin(), jend = mComponentSubscribers.end(); j != jend; ++j)
+         {
+            j->second.push_back(component);
+         }
+      }
+      else
+      {
+         const std::vector<const MessageType*>& types = component->GetSubscribedMessageTypes();
+         for (size_t j = 0; j < types.size(); ++j)
+         {
+            mComponentSubscribers[types[j]].push_back(component);
+         }
+      }
+   }
+
+   mComponentSubscribersDirty = false;
+}
 
+////////////////////////////////////////////////////////////////////////////////
+const GMImpl::GMComponentContainer& GMImpl::GetComponentSubscribers(const MessageType& type) const
+{
+   ComponentSubscriberMap::const_iterator found = mComponentSubscribers.find(&type);
+   if (found == mComponentSubscribers.end())
+   {
+      return mBroadcastComponents;
+   }
+   return found->second;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+void GMImpl::SendMessageToComponent(GMComponent& component, const Message& message, bool toNetwork,
+         bool logComponents, bool isATickLocalMessage)
+{
+   // Statistics information
+   dtCore::Timer_t frameTickStartCurrent(0);
+   if (logComponents)
+   {
+      frameTickStartCurrent = mGMStatistics.mStatsTickClock.Tick();
+   }
+
+   if (mLogger->IsLevelEnabled(dtUtil::Log::LOG_DEBUG))
+   {
+      mLogger->LogMessage(dtUtil::Log::LOG_DEBUG, __FUNCTION__, __LINE__,
+         "Sending Message Type \"" + message.GetMessageType().GetName() + "\" to GMComponent \"" +
+         component.GetName() + "\"");
+   }
+
+   try
+   {
+      if (toNetwork)
+      {
+         component.DispatchNetworkMessage(message);
+      }
+      else
+      {
+         component.ProcessMessage(message);
+      }
+   }
+   catch (const dtUtil::Exception& ex)
+   {
+      ex.LogException(dtUtil::Log::LOG_ERROR, *mLogger);
+   }
+   catch (const std::exception& ex)
+   {
+      mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+         std::string("Caught a std::exception derivative: ") + ex.what());
+   }
+   catch (...)
+   {
+      mLogger->LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+         "Caught an unknown exception in the GM!  Continuing.");
+   }
+
+   // Statistics information
+   if (logComponents)
+   {
+      double frameTickDelta =
+         mGMStatistics.mStatsTickClock.DeltaSec(frameTickStartCurrent, mGMStatistics.mStatsTickClock.Tick());
+
+      mGMStatistics.UpdateDebugStats(component.GetId(), component.GetName(), frameTickDelta, true, isATickLocalMessage);
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GMImpl::ProcessTimers(GameManager& gm, std::set<TimerInfo>& listToProcess, dtCore::Timer_t clockTime)
 {
@@ -31,6 +31,8 @@ namespace dtGame
       : mServerRole(true)
       , mClientRole(true)
       , mEditorMode(false)
+      , mLoadMapsInBackground(false)
+      , mMapLoadFrameBudgetMs(0.0f)
    {
    }
 
@@ -45,5 +47,9 @@ namespace dtGame
 
    DT_IMPLEMENT_ACCESSOR(GMSettings, bool, EditorMode);
 
+   DT_IMPLEMENT_ACCESSOR(GMSettings, bool, LoadMapsInBackground);
+
+   DT_IMPLEMENT_ACCESSOR(GMSettings, float, MapLoadFrameBudgetMs);
+
 
 } // namespace dtGame
@@ -39,6 +39,7 @@ namespace dtGame
       : mStatsLastFragmentDump(0)
       , mStatsNumProcMessages(0)
       , mStatsNumSendNetworkMessages(0)
+      , mStatsNumComponentDispatchesSkipped(0)
       , mStatsNumFrames(0)
       , mStatsCumGMProcessTime(0)
       , mStatsCurFrameActorTotal(0.0f)
@@ -203,7 +204,8 @@ namespace dtGame
          "%, " << truncCumGMTime << "s], ReportTime[" << truncRealTime <<
          "s], Ticks[" << mStatsNumFrames << "], FPS[" << fps <<
          "], #Msgs[" << mStatsNumProcMessages << " Local/" << mStatsNumSendNetworkMessages <<
-         " Ntwrk], #Actors[" << ourGm.GetNumAllActors() << "/ Game/" <<
+         " Ntwrk], #CompDispatchesSkipped[" << mStatsNumComponentDispatchesSkipped <<
+         "], #Actors[" << ourGm.GetNumAllActors() << "/ Game/" <<
          ourGm.GetNumGameActors() << "]" << std::endl;
 
       // reset values for next fragment
@@ -211,6 +213,7 @@ namespace dtGame
       mStatsNumProcMessages   = 0;
       mStatsCumGMProcessTime  = 0;
       mStatsNumSendNetworkMessages = 0;
+      mStatsNumComponentDispatchesSkipped = 0;
 
       // Build up all the information in the stream
       std::map<dtCore::UniqueId, dtCore::RefPtr<LogDebugInformation> >::iterator iter = mDebugLoggerInformation.begin();
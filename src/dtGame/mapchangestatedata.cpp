@@ -21,6 +21,7 @@
 #include <prefix/dtgameprefix.h>
 #include <dtUtil/log.h>
 #include <dtUtil/exception.h>
+#include <dtUtil/threadpool.h>
 
 #include <dtCore/project.h>
 #include <dtCore/map.h>
@@ -37,14 +38,78 @@
 #include <dtGame/gmcomponent.h>
 
 #include <dtCore/system.h>
+#include <dtCore/timer.h>
+
+#include <OpenThreads/Atomic>
+
 namespace dtGame
 {
    IMPLEMENT_ENUM(MapChangeStateData::MapChangeState);
 
+   ///////////////////////////////////////////////////////////////////////////////
+   /**
+    * Opens the maps, which parses them and creates all their actors, on an IO thread.  Nothing is logged
+    * or sent from here, the main thread checks on it each frame.
+    */
+   class MapChangeStateData::OpenMapsTask : public dtUtil::ThreadPoolTask
+   {
+   public:
+      OpenMapsTask(const MapChangeStateData::NameVector& mapNames)
+         : mMapNames(mapNames)
+      {
+      }
+
+      virtual void operator()()
+      {
+         MapChangeStateData::NameVector::const_iterator i = mMapNames.begin();
+         MapChangeStateData::NameVector::const_iterator end = mMapNames.end();
+         for (; i != end; ++i)
+         {
+            try
+            {
+               dtCore::Project::GetInstance().GetMap(*i);
+            }
+            catch (const dtUtil::Exception& ex)
+            {
+               mFailedMapName = *i;
+               mError = ex.ToString();
+               break;
+            }
+            catch (const std::exception& ex)
+            {
+               mFailedMapName = *i;
+               mError = ex.what();
+               break;
+            }
+            ++mNumMapsOpened;
+         }
+         // Set last so the results above are complete when the main thread sees it.
+         ++mDone;
+      }
+
+      bool IsDone() const { return unsigned(mDone) != 0; }
+      unsigned GetNumMapsOpened() const { return unsigned(mNumMapsOpened); }
+
+      /// Only valid once the task is done.
+      bool Failed() const { return !mFailedMapName.empty(); }
+      const std::string& GetFailedMapName() const { return mFailedMapName; }
+      const std::string& GetError() const { return mError; }
+
+   private:
+      MapChangeStateData::NameVector mMapNames;
+      OpenThreads::Atomic mNumMapsOpened;
+      OpenThreads::Atomic mDone;
+      std::string mFailedMapName;
+      std::string mError;
+   };
+
 
    ///////////////////////////////////////////////////////////////////////////////
    const MapChangeStateData::MapChangeState MapChangeStateData::MapChangeState::UNLOAD("UNLOAD");
 
+   ///////////////////////////////////////////////////////////////////////////////
+   const MapChangeStateData::MapChangeState MapChangeStateData::MapChangeState::OPEN("OPEN");
+
    ///////////////////////////////////////////////////////////////////////////////
    const MapChangeStateData::MapChangeState MapChangeStateData::MapChangeState::LOAD("LOAD");
 
@@ -54,8 +119,57 @@ namespace dtGame
    ///////////////////////////////////////////////////////////////////////////////
    MapChangeStateData::MapChangeStateData(GameManager& gm):
       osg::Referenced(), mGameManager(&gm), mCurrentState(&MapChangeStateData::MapChangeState::IDLE),
-      mAddBillboards(false)
+      mAddBillboards(false), mNumActorsAdded(0), mActorsPrepared(false)
+   {
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   MapChangeStateData::~MapChangeStateData()
+   {
+      // The maps are being opened into the project, so let that finish.
+      WaitForMapsToOpen();
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::WaitForMapsToOpen()
+   {
+      if (mOpenMapsTask.valid())
+      {
+         mOpenMapsTask->WaitUntilComplete();
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::CancelMapChange()
+   {
+      WaitForMapsToOpen();
+      mOpenMapsTask = NULL;
+
+      mActorsToAdd.clear();
+      mNumActorsAdded = 0;
+      mActorsPrepared = false;
+
+      if (*mCurrentState != MapChangeState::IDLE)
+      {
+         mCurrentState = &MapChangeState::IDLE;
+         // BeginMapChange paused the GM.
+         if (mGameManager.valid())
+         {
+            mGameManager->SetPaused(false);
+         }
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   bool MapChangeStateData::IsIncrementalLoad() const
    {
+      if (!mGameManager.valid())
+      {
+         return false;
+      }
+      const GMSettings& settings = mGameManager->GetGMSettings();
+      return (settings.GetLoadMapsInBackground() && dtUtil::ThreadPool::IsInitialized())
+            || settings.GetMapLoadFrameBudgetMs() > 0.0f;
    }
 
    ///////////////////////////////////////////////////////////////////////////////
@@ -68,12 +182,18 @@ namespace dtGame
          throw dtGame::GeneralGameManagerException( msg, __FUNCTION__, __LINE__);
       }
 
+      // A map change can only start from IDLE, but make sure nothing is still opening maps in the project.
+      WaitForMapsToOpen();
+
       // set the app to pause so we dont get a huge timestep when we're through
       mGameManager->SetPaused(true);
 
       mOldMapNames = oldMapNames;
       mNewMapNames = newMapNames;
       mAddBillboards = addBillboards;
+      mActorsToAdd.clear();
+      mNumActorsAdded = 0;
+      mActorsPrepared = false;
 
       mCurrentState = &MapChangeState::UNLOAD;
 
@@ -178,14 +298,8 @@ namespace dtGame
             }
             catch (const dtUtil::Exception& ex)
             {
-               // if we can't load a map, we go back to idle and send and
-               // empty string map change ended message
-               mCurrentState = &MapChangeState::IDLE;
-               SendMapMessage(MessageType::INFO_MAP_CHANGED, MapChangeStateData::NameVector());
-               dtUtil::Log::GetInstance("mapchangestatedata.cpp").LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
-                  "Critical failure occurred while opening map[%s].", (*i).c_str()); 
                ex.LogException(dtUtil::Log::LOG_ERROR, dtUtil::Log::GetInstance("mapchangestatedata.cpp"));
-               mNewMapNames.clear();
+               FailMapChange(*i);
                success = false;
                break;
             }
@@ -204,9 +318,50 @@ namespace dtGame
    }
 
    ///////////////////////////////////////////////////////////////////////////////
-   void MapChangeStateData::LoadSingleMapIntoGM(const std::string& mapName)
+   void MapChangeStateData::FailMapChange(const std::string& mapName)
+   {
+      // if we can't load a map, we go back to idle and send and
+      // empty string map change ended message
+      mCurrentState = &MapChangeState::IDLE;
+      SendMapMessage(MessageType::INFO_MAP_CHANGED, MapChangeStateData::NameVector());
+      dtUtil::Log::GetInstance("mapchangestatedata.cpp").LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+         "Critical failure occurred while opening map[%s].", mapName.c_str());
+      mNewMapNames.clear();
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::StartOpeningNewMaps()
+   {
+      mOpenMapsTask = new OpenMapsTask(mNewMapNames);
+      mOpenMapsTask->SetName("OpenMaps");
+      dtUtil::ThreadPool::AddTask(*mOpenMapsTask, dtUtil::ThreadPool::IO);
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   bool MapChangeStateData::ContinueOpeningNewMaps()
+   {
+      if (!mOpenMapsTask->IsDone())
+      {
+         SendProgressMessage(50.0f * float(mOpenMapsTask->GetNumMapsOpened()) / float(mNewMapNames.size()));
+         return false;
+      }
+
+      dtCore::RefPtr<OpenMapsTask> task = mOpenMapsTask;
+      mOpenMapsTask = NULL;
+      if (task->Failed())
+      {
+         LOGN_ERROR("mapchangestatedata.cpp", task->GetError());
+         FailMapChange(task->GetFailedMapName());
+         return false;
+      }
+
+      SendMapMessage(MessageType::INFO_MAP_LOAD_BEGIN, mNewMapNames);
+      return true;
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::PrepareMapForGM(dtCore::Map& map, dtCore::ActorRefPtrVector& actorsToAdd)
    {
-      dtCore::Map& map = dtCore::Project::GetInstance().GetMap(mapName);
       // add all the events in the map to the game manager.
       std::vector<dtCore::GameEvent* > events;
       map.GetEventManager().GetAllEvents(events);
@@ -223,8 +378,6 @@ namespace dtGame
          }
       }
 
-      ScopedGMBatchAdd batch(*mGameManager);
-
       if (map.GetEnvironmentActor() != NULL)
       {
          dtGame::IEnvGameActorProxy* eap =
@@ -236,6 +389,7 @@ namespace dtGame
       dtCore::ActorRefPtrVector proxies;
       map.GetAllProxies(proxies);
 
+      actorsToAdd.reserve(actorsToAdd.size() + proxies.size());
       for (unsigned int i = 0; i < proxies.size(); ++i)
       {
          dtCore::BaseActorObject& curAddActor = *proxies[i];
@@ -249,21 +403,85 @@ namespace dtGame
          {
             continue;
          }
-         else
+         actorsToAdd.push_back(&curAddActor);
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::AddActorToGM(dtCore::BaseActorObject& actor)
+   {
+      try
+      {
+         mGameManager->AddActor(actor);
+      }
+      catch (const dtUtil::Exception& ex)
+      {
+         dtUtil::Log::GetInstance("mapchangestatedata.cpp").LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
+               "A problem occurred adding Actor with name \"%s\" of type \"%s\" to the GameManager.",
+               actor.GetName().c_str(), actor.GetActorType().GetFullName().c_str());
+         ex.LogException(dtUtil::Log::LOG_ERROR, dtUtil::Log::GetInstance("mapchangestatedata.cpp"));
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::LoadSingleMapIntoGM(const std::string& mapName)
+   {
+      dtCore::Map& map = dtCore::Project::GetInstance().GetMap(mapName);
+
+      ScopedGMBatchAdd batch(*mGameManager);
+
+      dtCore::ActorRefPtrVector actorsToAdd;
+      PrepareMapForGM(map, actorsToAdd);
+
+      for (unsigned int i = 0; i < actorsToAdd.size(); ++i)
+      {
+         AddActorToGM(*actorsToAdd[i]);
+      }
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   bool MapChangeStateData::AddActorsToGM()
+   {
+      ScopedGMBatchAdd batch(*mGameManager);
+
+      if (!mActorsPrepared)
+      {
+         MapChangeStateData::NameVector::const_iterator i = mNewMapNames.begin();
+         MapChangeStateData::NameVector::const_iterator iend = mNewMapNames.end();
+         for (; i != iend; ++i)
          {
-            try
-            {
-               mGameManager->AddActor(curAddActor);
-            }
-            catch (const dtUtil::Exception& ex)
-            {
-               dtUtil::Log::GetInstance("mapchangestatedata.cpp").LogMessage(dtUtil::Log::LOG_ERROR, __FUNCTION__, __LINE__,
-                     "A problem occurred adding Actor with name \"%s\" of type \"%s\" to the GameManager.",
-                     curAddActor.GetName().c_str(), curAddActor.GetActorType().GetFullName().c_str());
-               ex.LogException(dtUtil::Log::LOG_ERROR, dtUtil::Log::GetInstance("mapchangestatedata.cpp"));
-            }
+            PrepareMapForGM(dtCore::Project::GetInstance().GetMap(*i), mActorsToAdd);
+         }
+         mActorsPrepared = true;
+      }
+
+      const float budgetMs = mGameManager->GetGMSettings().GetMapLoadFrameBudgetMs();
+      const dtCore::Timer& timer = *dtCore::Timer::Instance();
+      const dtCore::Timer_t start = timer.Tick();
+
+      while (mNumActorsAdded < mActorsToAdd.size())
+      {
+         AddActorToGM(*mActorsToAdd[mNumActorsAdded]);
+         ++mNumActorsAdded;
+
+         // Always add at least one actor so the load can't stall.
+         if (budgetMs > 0.0f && timer.DeltaMil(start, timer.Tick()) >= double(budgetMs))
+         {
+            break;
          }
       }
+
+      if (mNumActorsAdded < mActorsToAdd.size())
+      {
+         SendProgressMessage(50.0f + 50.0f * float(mNumActorsAdded) / float(mActorsToAdd.size()));
+         return false;
+      }
+
+      SendProgressMessage(100.0f);
+      mActorsToAdd.clear();
+      mNumActorsAdded = 0;
+      mActorsPrepared = false;
+      return true;
    }
 
    ///////////////////////////////////////////////////////////////////////////////
@@ -286,7 +504,13 @@ namespace dtGame
       {
          CloseOldMaps();
 
-         if (OpenNewMaps())
+         if (!mNewMapNames.empty() && mGameManager->GetGMSettings().GetLoadMapsInBackground()
+               && dtUtil::ThreadPool::IsInitialized())
+         {
+            StartOpeningNewMaps();
+            mCurrentState = &MapChangeState::OPEN;
+         }
+         else if (OpenNewMaps())
          {
             mCurrentState = &MapChangeState::LOAD;
          }
@@ -297,14 +521,23 @@ namespace dtGame
             mCurrentState = &MapChangeState::IDLE;
          }
       }
+      else if (mCurrentState == &MapChangeState::OPEN)
+      {
+         if (ContinueOpeningNewMaps())
+         {
+            mCurrentState = &MapChangeState::LOAD;
+         }
+         else if (mCurrentState == &MapChangeState::IDLE)
+         {
+            // set the app to unpause so time stepping is correct
+            mGameManager->SetPaused(false);
+         }
+      }
       else if (mCurrentState == &MapChangeState::LOAD)
       {
-         MapChangeStateData::NameVector::const_iterator i = mNewMapNames.begin();
-         MapChangeStateData::NameVector::const_iterator iend = mNewMapNames.end();
-
-         for (; i != iend; ++i)
+         if (!AddActorsToGM())
          {
-            LoadSingleMapIntoGM(*i);
+            return;
          }
 
          // set the app to unpause so time stepping is correct
@@ -327,5 +560,23 @@ namespace dtGame
       mGameManager->SendMessage(*mapMessage);
    }
 
+   ///////////////////////////////////////////////////////////////////////////////
+   void MapChangeStateData::SendProgressMessage(float percentComplete)
+   {
+      if (!IsIncrementalLoad())
+      {
+         return;
+      }
+
+      dtCore::RefPtr<MapChangeProgressMessage> progressMessage;
+      mGameManager->GetMessageFactory().CreateMessage(MessageType::INFO_MAP_CHANGE_PROGRESS, progressMessage);
+      progressMessage->SetMapNames(mNewMapNames);
+      progressMessage->SetPercentComplete(percentComplete);
+      progressMessage->SetNumActorsAdded(mNumActorsAdded);
+      progressMessage->SetNumActorsToAdd(mActorsToAdd.size());
+
+      mGameManager->SendMessage(*progressMessage);
+   }
+
    
 } // namespace dtGame
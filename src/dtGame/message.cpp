@@ -157,6 +157,18 @@ namespace dtGame
 
       return okay;
    }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   void Message::ToCompactDataStream(DataStream& stream, MessageSchemaTable& schemas) const
+   {
+      ToDataStream(stream);
+   }
+
+   ///////////////////////////////////////////////////////////////////////////////
+   bool Message::FromCompactDataStream(DataStream& stream, MessageSchemaTable& schemas)
+   {
+      return FromDataStream(stream);
+   }
   
    ///////////////////////////////////////////////////////////////////////////////
    void Message::AddParameter(dtCore::NamedParameter* param)
@@ -28,6 +28,10 @@
 #include <dtGame/messagefactory.h>
 #include <dtGame/messagetype.h>
 #include <dtCore/refptr.h>
+#include <dtUtil/hashmap.h>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+#include <algorithm>
 #include <sstream>
 
 #include <typeinfo>
@@ -39,12 +43,76 @@ namespace dtGame
 
    std::map<unsigned short, const MessageType*> MessageFactory::mIdMap;
 
+   /////////////////////////////////////////////////////////////////
+   /**
+    * The messages kept for reuse, by type.  A message is free once the pool holds its only reference.
+    * It is locked because network components create messages from their own threads.
+    */
+   class MessageFactory::MessagePool
+   {
+   public:
+      /// How many pooled messages to look at for a free one before giving up and allocating.
+      static const unsigned MAX_SEARCH = 8;
+
+      struct TypePool
+      {
+         TypePool()
+            : mNext(0)
+            , mMaxSize(DEFAULT_POOL_SIZE)
+         {
+         }
+
+         std::vector<dtCore::RefPtr<Message> > mMessages;
+         /// a message as CreateMessage first makes it, for resetting the reused ones
+         dtCore::RefPtr<Message> mPrototype;
+         unsigned mNext;
+         unsigned mMaxSize;
+      };
+
+      MessagePool()
+         : mNumAllocated(0)
+         , mNumRecycled(0)
+      {
+      }
+
+      /// @return a pooled message no one else references, or NULL.
+      Message* FindFree(TypePool& pool)
+      {
+         unsigned size = unsigned(pool.mMessages.size());
+         unsigned toSearch = std::min(size, unsigned(MAX_SEARCH));
+         for (unsigned i = 0; i < toSearch; ++i)
+         {
+            unsigned index = (pool.mNext + i) % size;
+            Message* msg = pool.mMessages[index].get();
+            if (msg->referenceCount() == 1)
+            {
+               pool.mNext = (index + 1) % size;
+               return msg;
+            }
+         }
+         // start past the ones just searched next time.
+         if (size > 0)
+         {
+            pool.mNext = (pool.mNext + toSearch) % size;
+         }
+         return NULL;
+      }
+
+      typedef dtUtil::HashMap<const MessageType*, TypePool> TypePoolMap;
+
+      OpenThreads::Mutex mMutex;
+      TypePoolMap mTypePools;
+      unsigned mNumAllocated;
+      unsigned mNumRecycled;
+   };
+
    /////////////////////////////////////////////////////////////////
    MessageFactory::MessageFactory(const std::string& name,
                                   const MachineInfo& machine,
                                   const std::string& desc) :
    mName(name),
    mDescription(desc),
+   mPool(new MessagePool),
    mMachine(&machine)
    {
    }
@@ -52,7 +120,7 @@ namespace dtGame
    /////////////////////////////////////////////////////////////////
    MessageFactory::~MessageFactory()
    {
-
+      delete mPool;
    }
 
    /////////////////////////////////////////////////////////////////
@@ -80,6 +148,42 @@ namespace dtGame
 
    /////////////////////////////////////////////////////////////////
    dtCore::RefPtr<Message> MessageFactory::CreateMessage(const MessageType& msgType) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPool->mMutex);
+
+      MessagePool::TypePoolMap::iterator found = mPool->mTypePools.find(&msgType);
+      if (found == mPool->mTypePools.end())
+      {
+         ++mPool->mNumAllocated;
+         return AllocateMessage(msgType);
+      }
+
+      MessagePool::TypePool& pool = found->second;
+      dtCore::RefPtr<Message> msg = mPool->FindFree(pool);
+      if (msg.valid())
+      {
+         // put it back the way it was created.
+         pool.mPrototype->CopyDataTo(*msg);
+         msg->SetCausingMessage(NULL);
+         ++mPool->mNumRecycled;
+         return msg;
+      }
+
+      msg = AllocateMessage(msgType);
+      ++mPool->mNumAllocated;
+      if (pool.mPrototype == NULL)
+      {
+         pool.mPrototype = AllocateMessage(msgType);
+      }
+      if (pool.mMessages.size() < pool.mMaxSize)
+      {
+         pool.mMessages.push_back(msg);
+      }
+      return msg;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   dtCore::RefPtr<Message> MessageFactory::AllocateMessage(const MessageType& msgType) const
    {
       dtCore::RefPtr<Message> msg = mMessageFactory->CreateObject(&msgType);
 
@@ -96,6 +200,54 @@ namespace dtGame
       return msg;
    }
 
+   /////////////////////////////////////////////////////////////////
+   void MessageFactory::SetMessageTypePooled(const MessageType& msgType, bool pooled, unsigned maxPooled)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPool->mMutex);
+      if (!pooled)
+      {
+         mPool->mTypePools.erase(&msgType);
+         return;
+      }
+
+      MessagePool::TypePool& pool = mPool->mTypePools[&msgType];
+      pool.mMaxSize = maxPooled;
+      if (pool.mMessages.size() > maxPooled)
+      {
+         pool.mMessages.resize(maxPooled);
+         pool.mNext = 0;
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////
+   bool MessageFactory::IsMessageTypePooled(const MessageType& msgType) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPool->mMutex);
+      return mPool->mTypePools.find(&msgType) != mPool->mTypePools.end();
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned MessageFactory::GetNumMessagesAllocated() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPool->mMutex);
+      return mPool->mNumAllocated;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned MessageFactory::GetNumMessagesRecycled() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPool->mMutex);
+      return mPool->mNumRecycled;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   void MessageFactory::ResetPoolStatistics()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPool->mMutex);
+      mPool->mNumAllocated = 0;
+      mPool->mNumRecycled = 0;
+   }
+
    /////////////////////////////////////////////////////////////////
    dtCore::RefPtr<Message> MessageFactory::CloneMessage(const Message& msg) const
    {
@@ -214,6 +366,7 @@ namespace dtGame
    const MessageType MessageType::INFO_MAP_CHANGE_UNLOAD_BEGIN("Map Unload Began", MessageType::CATEGORY_INFO, "Sent when unloading a map has begun.", 24, (MapMessage*)(NULL));
    const MessageType MessageType::INFO_MAP_CHANGE_BEGIN("Map Change Began", MessageType::CATEGORY_INFO, "Sent when the program has begun to unload a map and load a new one.  Unload and load messages will be sent", 25, (MapMessage*)(NULL));
    const MessageType MessageType::INFO_MAP_CHANGE_END("Map Changed", MessageType::CATEGORY_INFO, "Sent when the program has completed unloading and loading a new map.", 26, (MapMessage*)(NULL));
+   const MessageType MessageType::INFO_MAP_CHANGE_PROGRESS("Map Change Progress", MessageType::CATEGORY_INFO, "Sent each frame while the new maps are opened and their actors are added, with the percentage done.", 27, (MapChangeProgressMessage*)(NULL));
 
    ////////////////////
    // Deprecated
@@ -0,0 +1,187 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <prefix/dtgameprefix.h>
+#include <dtGame/messageschematable.h>
+#include <dtGame/exceptionenum.h>
+#include <dtCore/datatype.h>
+#include <dtCore/namedparameter.h>
+#include <climits>
+
+namespace dtGame
+{
+   /////////////////////////////////////////////////////////////////
+   MessageSchemaTable::ParameterSchema::ParameterSchema()
+   : mName("")
+   , mDataType(&dtCore::DataType::UNKNOWN)
+   , mIsList(false)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////
+   MessageSchemaTable::ParameterSchema::ParameterSchema(const dtUtil::RefString& name, dtCore::DataType& dataType, bool isList)
+   : mName(name)
+   , mDataType(&dataType)
+   , mIsList(isList)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////
+   MessageSchemaTable::MessageSchemaTable()
+   : mNumDefinitionsWritten(0)
+   , mEpoch(0)
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////
+   MessageSchemaTable::~MessageSchemaTable()
+   {
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned short MessageSchemaTable::FindOrAddActorTypeSchema(const std::string& category, const std::string& name, bool& isNew)
+   {
+      std::string key = category + "." + name;
+
+      std::map<std::string, unsigned short>::const_iterator found = mHandleMap.find(key);
+      if (found != mHandleMap.end())
+      {
+         isNew = false;
+         return found->second;
+      }
+
+      if (mSchemas.size() >= USHRT_MAX)
+      {
+         throw dtGame::InvalidParameterException("Too many actor types have been sent to fit in a message schema table.",
+                  __FILE__, __LINE__);
+      }
+
+      unsigned short handle = (unsigned short)mSchemas.size();
+      mSchemas.push_back(ActorTypeSchema());
+      mSchemas.back().mCategory = category;
+      mSchemas.back().mName = name;
+      mHandleMap.insert(std::make_pair(key, handle));
+      ++mNumDefinitionsWritten;
+
+      isNew = true;
+      return handle;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned short MessageSchemaTable::FindOrAddParameter(unsigned short handle, const dtCore::NamedParameter& param, bool& isNew)
+   {
+      ActorTypeSchema& schema = mSchemas.at(handle);
+
+      std::map<std::string, unsigned short>::iterator found = schema.mIndexMap.find(param.GetName());
+      if (found != schema.mIndexMap.end())
+      {
+         const ParameterSchema& existing = schema.mParameters[found->second];
+         if (*existing.mDataType == param.GetDataType() && existing.mIsList == param.IsList())
+         {
+            isNew = false;
+            return found->second;
+         }
+      }
+
+      if (schema.mParameters.size() >= USHRT_MAX)
+      {
+         throw dtGame::InvalidParameterException("Too many parameters have been sent for actor type \""
+                  + schema.mCategory + "." + schema.mName + "\" to fit in a message schema.", __FILE__, __LINE__);
+      }
+
+      // A parameter that changed type gets a new index.  The old index is left so the indices stay in sync with the reader.
+      unsigned short index = (unsigned short)schema.mParameters.size();
+      schema.mParameters.push_back(ParameterSchema(param.GetName(), param.GetDataType(), param.IsList()));
+      schema.mIndexMap[param.GetName()] = index;
+      ++mNumDefinitionsWritten;
+
+      isNew = true;
+      return index;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   void MessageSchemaTable::DefineActorTypeSchema(unsigned short handle, const std::string& category, const std::string& name)
+   {
+      if (handle >= mSchemas.size())
+      {
+         mSchemas.resize(handle + 1);
+      }
+
+      ActorTypeSchema& schema = mSchemas[handle];
+      schema.mCategory = category;
+      schema.mName = name;
+      schema.mParameters.clear();
+      schema.mIndexMap.clear();
+   }
+
+   /////////////////////////////////////////////////////////////////
+   void MessageSchemaTable::DefineParameter(unsigned short handle, const ParameterSchema& param)
+   {
+      if (handle >= mSchemas.size())
+      {
+         throw dtGame::InvalidParameterException("A parameter was defined for a message schema that does not exist.",
+                  __FILE__, __LINE__);
+      }
+
+      mSchemas[handle].mParameters.push_back(param);
+   }
+
+   /////////////////////////////////////////////////////////////////
+   const MessageSchemaTable::ActorTypeSchema* MessageSchemaTable::GetActorTypeSchema(unsigned short handle) const
+   {
+      if (handle >= mSchemas.size())
+      {
+         return NULL;
+      }
+      return &mSchemas[handle];
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned MessageSchemaTable::GetSchemaCount() const
+   {
+      return unsigned(mSchemas.size());
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned MessageSchemaTable::GetNumDefinitionsWritten() const
+   {
+      return mNumDefinitionsWritten;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   unsigned char MessageSchemaTable::GetEpoch() const
+   {
+      return mEpoch;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   void MessageSchemaTable::SetEpoch(unsigned char epoch)
+   {
+      mEpoch = epoch;
+   }
+
+   /////////////////////////////////////////////////////////////////
+   void MessageSchemaTable::Clear()
+   {
+      mSchemas.clear();
+      mHandleMap.clear();
+      ++mEpoch;
+   }
+}
@@ -0,0 +1,543 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <dtNetGM/interestmanager.h>
+#include <dtGame/actorupdatemessage.h>
+#include <dtGame/deadreckoninghelper.h>
+#include <dtGame/messageparameter.h>
+#include <dtGame/messagetype.h>
+#include <dtCore/namedvectorparameters.h>
+#include <dtCore/transformableactorproxy.h>
+
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dtNetGM
+{
+   namespace
+   {
+      /// @return true if a point this far from the center of the region is in it.
+      bool IsInRegion(const InterestRegion& region, const osg::Vec3& offset)
+      {
+         if (region.mIsBox)
+         {
+            return std::abs(offset.x()) <= region.mHalfExtents.x()
+                     && std::abs(offset.y()) <= region.mHalfExtents.y()
+                     && std::abs(offset.z()) <= region.mHalfExtents.z();
+         }
+         return offset.length2() <= region.mRadius * region.mRadius;
+      }
+
+      /// @return true if the update can be left out for a client, that is it's only about where the actor is.
+      bool IsDeadReckoningOnly(const dtGame::ActorUpdateMessage& update)
+      {
+         if (!update.IsPartialUpdate())
+         {
+            return false;
+         }
+
+         std::vector<const dtGame::MessageParameter*> params;
+         update.GetUpdateParameters(params);
+         for (unsigned i = 0; i < params.size(); ++i)
+         {
+            if (!InterestManager::IsDeadReckoningParameter(params[i]->GetName()))
+            {
+               return false;
+            }
+         }
+         return !params.empty();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestRegion::InterestRegion()
+      : mIsBox(false)
+      , mRadius(0.0f)
+      , mAnchorActorId(false)
+      , mFullRateRadius(0.0f)
+      , mDistantUpdateInterval(1.0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestRegion InterestRegion::Sphere(const osg::Vec3& center, float radius)
+   {
+      InterestRegion region;
+      region.mCenter = center;
+      region.mRadius = radius;
+      return region;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestRegion InterestRegion::Box(const osg::Vec3& center, const osg::Vec3& halfExtents)
+   {
+      InterestRegion region;
+      region.mIsBox = true;
+      region.mCenter = center;
+      region.mHalfExtents = halfExtents;
+      return region;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestManager::ClientStatistics::ClientStatistics()
+      : mNumUpdatesSent(0)
+      , mNumOutsideRegion(0)
+      , mNumFilteredByType(0)
+      , mNumThrottled(0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   const float InterestManager::DEFAULT_CELL_SIZE = 250.0f;
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestManager::InterestManager(float cellSize)
+      : mCellSize(cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE)
+      , mCurrentTime(0.0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestManager::~InterestManager()
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::SetClientInterest(const dtCore::UniqueId& clientId, const InterestRegion& region)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      mClients[clientId].mRegion = region;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::RemoveClient(const dtCore::UniqueId& clientId)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      mClients.erase(clientId);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool InterestManager::HasClientInterest(const dtCore::UniqueId& clientId) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      return mClients.find(clientId) != mClients.end();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::SetCurrentTime(double time)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      mCurrentTime = time;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::ObserveMessage(const dtGame::Message& message)
+   {
+      const dtGame::MessageType& type = message.GetMessageType();
+      if (type == dtGame::MessageType::INFO_ACTOR_DELETED)
+      {
+         RemoveActor(message.GetAboutActorId());
+         return;
+      }
+
+      if (type != dtGame::MessageType::INFO_ACTOR_UPDATED && type != dtGame::MessageType::INFO_ACTOR_CREATED)
+      {
+         return;
+      }
+
+      const dtGame::ActorUpdateMessage& update = static_cast<const dtGame::ActorUpdateMessage&>(message);
+
+      // Remote actors are dead reckoned from the last known translation, so it's the position the clients see.
+      const dtCore::NamedParameter* param = update.GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_TRANSLATION);
+      if (param == NULL)
+      {
+         param = update.GetUpdateParameter(dtCore::TransformableActorProxy::PROPERTY_TRANSLATION);
+      }
+
+      const dtCore::NamedVec3Parameter* translation = dynamic_cast<const dtCore::NamedVec3Parameter*>(param);
+      if (translation != NULL)
+      {
+         std::string typeFullName;
+         if (!update.GetActorTypeName().empty())
+         {
+            typeFullName = update.GetActorTypeCategory() + "." + update.GetActorTypeName();
+         }
+         UpdateActor(update.GetAboutActorId(), translation->GetValue(), typeFullName);
+      }
+
+      StoreDeadReckoningState(update);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::UpdateActor(const dtCore::UniqueId& actorId, const osg::Vec3& position, const std::string& typeFullName)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      CellKey cell = GetCell(position);
+
+      ActorMap::iterator i = mActors.find(actorId);
+      if (i == mActors.end())
+      {
+         ActorEntry& entry = mActors[actorId];
+         entry.mPosition = position;
+         entry.mCell = cell;
+         entry.mTypeFullName = typeFullName;
+         mCells[cell].push_back(actorId);
+         return;
+      }
+
+      ActorEntry& entry = i->second;
+      entry.mPosition = position;
+      if (!typeFullName.empty())
+      {
+         entry.mTypeFullName = typeFullName;
+      }
+
+      if (entry.mCell < cell || cell < entry.mCell)
+      {
+         RemoveFromCell(entry.mCell, actorId);
+         entry.mCell = cell;
+         mCells[cell].push_back(actorId);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::RemoveActor(const dtCore::UniqueId& actorId)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ActorMap::iterator i = mActors.find(actorId);
+      if (i == mActors.end())
+      {
+         return;
+      }
+
+      RemoveFromCell(i->second.mCell, actorId);
+      mActors.erase(i);
+
+      for (ClientMap::iterator c = mClients.begin(); c != mClients.end(); ++c)
+      {
+         c->second.mLastSentTimes.erase(actorId);
+         c->second.mMissedUpdates.erase(actorId);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool InterestManager::ShouldSend(const dtGame::Message& message, const dtCore::UniqueId& clientId, bool* addDeadReckoningStateOut)
+   {
+      if (addDeadReckoningStateOut != NULL)
+      {
+         *addDeadReckoningStateOut = false;
+      }
+
+      if (message.GetMessageType() != dtGame::MessageType::INFO_ACTOR_UPDATED)
+      {
+         return true;
+      }
+
+      const dtGame::ActorUpdateMessage& update = static_cast<const dtGame::ActorUpdateMessage&>(message);
+      if (IsDeadReckoningOnly(update) && !ShouldSendActorUpdate(update.GetAboutActorId(), clientId))
+      {
+         return false;
+      }
+
+      if (addDeadReckoningStateOut != NULL)
+      {
+         *addDeadReckoningStateOut = ClearMissedUpdates(update.GetAboutActorId(), clientId);
+      }
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool InterestManager::ShouldSendActorUpdate(const dtCore::UniqueId& actorId, const dtCore::UniqueId& clientId)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ClientMap::iterator c = mClients.find(clientId);
+      if (c == mClients.end())
+      {
+         return true;
+      }
+
+      ClientEntry& client = c->second;
+      const InterestRegion& region = client.mRegion;
+
+      ActorMap::const_iterator a = mActors.find(actorId);
+      if (a == mActors.end())
+      {
+         ++client.mStatistics.mNumUpdatesSent;
+         return true;
+      }
+
+      const ActorEntry& actor = a->second;
+      if (!region.mActorTypes.empty() && region.mActorTypes.find(actor.mTypeFullName) == region.mActorTypes.end())
+      {
+         ++client.mStatistics.mNumFilteredByType;
+         client.mMissedUpdates.insert(actorId);
+         return false;
+      }
+
+      osg::Vec3 offset = actor.mPosition - GetRegionCenter(region);
+      if (!IsInRegion(region, offset))
+      {
+         ++client.mStatistics.mNumOutsideRegion;
+         client.mMissedUpdates.insert(actorId);
+         return false;
+      }
+
+      if (region.mFullRateRadius > 0.0f && offset.length2() > region.mFullRateRadius * region.mFullRateRadius)
+      {
+         dtUtil::HashMap<dtCore::UniqueId, double>::iterator lastSent = client.mLastSentTimes.find(actorId);
+         if (lastSent != client.mLastSentTimes.end())
+         {
+            if (mCurrentTime - lastSent->second < region.mDistantUpdateInterval)
+            {
+               ++client.mStatistics.mNumThrottled;
+               client.mMissedUpdates.insert(actorId);
+               return false;
+            }
+            lastSent->second = mCurrentTime;
+         }
+         else
+         {
+            client.mLastSentTimes.insert(std::make_pair(actorId, mCurrentTime));
+         }
+      }
+      else
+      {
+         // Coming back in from the distance, the next far update should be sent right away.
+         client.mLastSentTimes.erase(actorId);
+      }
+
+      ++client.mStatistics.mNumUpdatesSent;
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::AddDeadReckoningState(dtGame::ActorUpdateMessage& update) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ActorMap::const_iterator a = mActors.find(update.GetAboutActorId());
+      if (a == mActors.end() || !a->second.mDeadReckoningState.valid())
+      {
+         return;
+      }
+
+      std::vector<const dtCore::NamedParameter*> params;
+      a->second.mDeadReckoningState->GetParameters(params);
+      for (unsigned i = 0; i < params.size(); ++i)
+      {
+         const dtCore::NamedParameter& param = *params[i];
+         if (update.GetUpdateParameter(param.GetName()) == NULL)
+         {
+            update.AddUpdateParameter(param.GetName(), param.GetDataType())->CopyFrom(param);
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool InterestManager::IsDeadReckoningParameter(const std::string& name)
+   {
+      return name == dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_TRANSLATION
+               || name == dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_ROTATION
+               || name == dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR
+               || name == dtGame::DeadReckoningHelper::PROPERTY_ACCELERATION_VECTOR
+               || name == dtGame::DeadReckoningHelper::PROPERTY_ANGULAR_VELOCITY_VECTOR
+               || name == dtCore::TransformableActorProxy::PROPERTY_TRANSLATION
+               || name == dtCore::TransformableActorProxy::PROPERTY_ROTATION;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::GetActorsInRegion(const dtCore::UniqueId& clientId, std::vector<dtCore::UniqueId>& actorsOut) const
+   {
+      actorsOut.clear();
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ClientMap::const_iterator c = mClients.find(clientId);
+      if (c == mClients.end())
+      {
+         return;
+      }
+
+      const InterestRegion& region = c->second.mRegion;
+      const osg::Vec3 center = GetRegionCenter(region);
+      const osg::Vec3 halfExtents = region.mIsBox ? region.mHalfExtents : osg::Vec3(region.mRadius, region.mRadius, region.mRadius);
+      const CellKey minCell = GetCell(center - halfExtents);
+      const CellKey maxCell = GetCell(center + halfExtents);
+
+      for (int x = minCell.mX; x <= maxCell.mX; ++x)
+      {
+         for (int y = minCell.mY; y <= maxCell.mY; ++y)
+         {
+            for (int z = minCell.mZ; z <= maxCell.mZ; ++z)
+            {
+               CellMap::const_iterator cell = mCells.find(CellKey(x, y, z));
+               if (cell == mCells.end())
+               {
+                  continue;
+               }
+
+               const std::vector<dtCore::UniqueId>& ids = cell->second;
+               for (unsigned i = 0; i < ids.size(); ++i)
+               {
+                  const ActorEntry& actor = mActors.find(ids[i])->second;
+                  if (IsInRegion(region, actor.mPosition - center))
+                  {
+                     actorsOut.push_back(ids[i]);
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestManager::ClientStatistics InterestManager::GetClientStatistics(const dtCore::UniqueId& clientId) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ClientMap::const_iterator c = mClients.find(clientId);
+      if (c == mClients.end())
+      {
+         return ClientStatistics();
+      }
+      return c->second.mStatistics;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::ResetStatistics()
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      for (ClientMap::iterator c = mClients.begin(); c != mClients.end(); ++c)
+      {
+         c->second.mStatistics = ClientStatistics();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned InterestManager::GetNumActors() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+      return unsigned(mActors.size());
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::StoreDeadReckoningState(const dtGame::ActorUpdateMessage& update)
+   {
+      std::vector<const dtGame::MessageParameter*> params;
+      update.GetUpdateParameters(params);
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ActorMap::iterator a = mActors.find(update.GetAboutActorId());
+      if (a == mActors.end())
+      {
+         return;
+      }
+
+      ActorEntry& actor = a->second;
+      for (unsigned i = 0; i < params.size(); ++i)
+      {
+         const dtGame::MessageParameter& param = *params[i];
+         if (!IsDeadReckoningParameter(param.GetName()))
+         {
+            continue;
+         }
+
+         if (!actor.mDeadReckoningState.valid())
+         {
+            actor.mDeadReckoningState = new dtCore::NamedGroupParameter(dtUtil::RefString("DeadReckoningState"));
+         }
+
+         dtCore::NamedParameter* stored = actor.mDeadReckoningState->GetParameter(param.GetName());
+         if (stored == NULL)
+         {
+            stored = actor.mDeadReckoningState->AddParameter(param.GetName(), param.GetDataType());
+         }
+         stored->CopyFrom(param);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool InterestManager::ClearMissedUpdates(const dtCore::UniqueId& actorId, const dtCore::UniqueId& clientId)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      ClientMap::iterator c = mClients.find(clientId);
+      if (c == mClients.end())
+      {
+         return false;
+      }
+      return c->second.mMissedUpdates.erase(actorId) > 0;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestManager::CellKey InterestManager::GetCell(const osg::Vec3& position) const
+   {
+      return CellKey(int(std::floor(position.x() / mCellSize)),
+               int(std::floor(position.y() / mCellSize)),
+               int(std::floor(position.z() / mCellSize)));
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void InterestManager::RemoveFromCell(const CellKey& cell, const dtCore::UniqueId& actorId)
+   {
+      CellMap::iterator i = mCells.find(cell);
+      if (i == mCells.end())
+      {
+         return;
+      }
+
+      std::vector<dtCore::UniqueId>& ids = i->second;
+      std::vector<dtCore::UniqueId>::iterator found = std::find(ids.begin(), ids.end(), actorId);
+      if (found != ids.end())
+      {
+         // order doesn't matter, so swap with the last one rather than shifting the rest down.
+         *found = ids.back();
+         ids.pop_back();
+      }
+
+      if (ids.empty())
+      {
+         mCells.erase(i);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   osg::Vec3 InterestManager::GetRegionCenter(const InterestRegion& region) const
+   {
+      if (!region.mAnchorActorId.IsNull())
+      {
+         ActorMap::const_iterator anchor = mActors.find(region.mAnchorActorId);
+         if (anchor != mActors.end())
+         {
+            return anchor->second.mPosition;
+         }
+      }
+      return region.mCenter;
+   }
+}
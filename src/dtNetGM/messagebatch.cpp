@@ -0,0 +1,309 @@
+/*
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+
+#include <dtNetGM/messagebatch.h>
+#include <dtGame/message.h>
+#include <dtGame/messageschematable.h>
+#include <dtGame/messagetype.h>
+#include <dtGame/machineinfo.h>
+
+namespace dtNetGM
+{
+   namespace
+   {
+      /// Set on the type id of a message with a compact body, the same as NetworkComponent::COMPACT_ENCODING_FLAG.
+      const unsigned short COMPACT_BODY_FLAG = 0x8000;
+
+      const unsigned char FLAG_DESTINATION = 0x01;
+      const unsigned char FLAG_SENDING_IS_ABOUT = 0x02;
+
+      /// The body size written when the real size follows as an unsigned int.
+      const unsigned short LARGE_BODY_SIZE = 0xFFFF;
+
+      // Each id is written as one byte, which is either the index of an id earlier in the frame or one of these.
+      const unsigned char ID_NULL = 0xFE;
+      const unsigned char ID_FOLLOWS = 0xFF;
+      const unsigned MAX_FRAME_IDS = ID_NULL;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   MessageBatchWriter::MessageBatchWriter(unsigned maxFrameSize)
+      : mMaxFrameSize(maxFrameSize)
+      , mNumMessagesInFrame(0)
+      , mFrameAddsSchemaDefinitions(false)
+      , mNumMessagesWritten(0)
+      , mNumFramesWritten(0)
+      , mNumBytesWritten(0)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   MessageBatchWriter::~MessageBatchWriter()
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void MessageBatchWriter::AddMessage(const dtGame::Message& message, dtGame::MessageSchemaTable* schemas)
+   {
+      // The body doesn't depend on the frame, so it's only written once even if the frame fills.
+      mBody.ClearBuffer();
+      unsigned short messageTypeId = message.GetMessageType().GetId();
+      bool addsSchemaDefinitions = false;
+      if (schemas != NULL)
+      {
+         messageTypeId |= COMPACT_BODY_FLAG;
+         unsigned numDefinitions = schemas->GetNumDefinitionsWritten();
+         message.ToCompactDataStream(mBody, *schemas);
+         addsSchemaDefinitions = schemas->GetNumDefinitionsWritten() != numDefinitions;
+      }
+      else
+      {
+         message.ToDataStream(mBody);
+      }
+
+      size_t numFrameIds = mFrameIds.size();
+      WriteEntryHeader(message, messageTypeId);
+
+      if (mNumMessagesInFrame > 0 &&
+            mFrame.GetBufferSize() + mEntry.GetBufferSize() + mBody.GetBufferSize() > mMaxFrameSize)
+      {
+         // The ids were written against the frame that's being finished.
+         mFrameIds.resize(numFrameIds);
+         Flush();
+         WriteEntryHeader(message, messageTypeId);
+      }
+
+      if (mNumMessagesInFrame == 0)
+      {
+         mFrame.Write(BATCH_FRAME_ID);
+      }
+
+      mFrame.WriteBinary(mEntry.GetBuffer(), mEntry.GetBufferSize());
+      mFrame.WriteBinary(mBody.GetBuffer(), mBody.GetBufferSize());
+      mFrameAddsSchemaDefinitions = mFrameAddsSchemaDefinitions || addsSchemaDefinitions;
+
+      ++mNumMessagesInFrame;
+      ++mNumMessagesWritten;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void MessageBatchWriter::Flush()
+   {
+      if (mNumMessagesInFrame == 0)
+      {
+         return;
+      }
+
+      ++mNumFramesWritten;
+      mNumBytesWritten += mFrame.GetBufferSize();
+
+      OnFrameFinished(mFrame);
+
+      mFrame.ClearBuffer();
+      mFrameIds.clear();
+      mNumMessagesInFrame = 0;
+      mFrameAddsSchemaDefinitions = false;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void MessageBatchWriter::WriteEntryHeader(const dtGame::Message& message, unsigned short messageTypeId)
+   {
+      mEntry.ClearBuffer();
+
+      unsigned char flags = 0;
+      if (message.GetDestination() != NULL)
+      {
+         flags |= FLAG_DESTINATION;
+      }
+      if (message.GetSendingActorId() == message.GetAboutActorId())
+      {
+         flags |= FLAG_SENDING_IS_ABOUT;
+      }
+
+      mEntry.Write(messageTypeId);
+      mEntry.Write(flags);
+      if (mBody.GetBufferSize() < LARGE_BODY_SIZE)
+      {
+         mEntry.Write((unsigned short)(mBody.GetBufferSize()));
+      }
+      else
+      {
+         mEntry.Write(LARGE_BODY_SIZE);
+         mEntry.Write((unsigned)(mBody.GetBufferSize()));
+      }
+
+      WriteId(mEntry, message.GetSource().GetUniqueId());
+      if (message.GetDestination() != NULL)
+      {
+         WriteId(mEntry, message.GetDestination()->GetUniqueId());
+      }
+      WriteId(mEntry, message.GetAboutActorId());
+      if ((flags & FLAG_SENDING_IS_ABOUT) == 0)
+      {
+         WriteId(mEntry, message.GetSendingActorId());
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void MessageBatchWriter::WriteId(dtUtil::DataStream& stream, const dtCore::UniqueId& id)
+   {
+      if (id.IsNull())
+      {
+         stream.Write(ID_NULL);
+         return;
+      }
+
+      for (unsigned i = 0; i < mFrameIds.size(); ++i)
+      {
+         if (mFrameIds[i] == id)
+         {
+            stream.Write((unsigned char)(i));
+            return;
+         }
+      }
+
+      stream.Write(ID_FOLLOWS);
+      id.ToCompactDataStream(stream);
+      if (mFrameIds.size() < MAX_FRAME_IDS)
+      {
+         mFrameIds.push_back(id);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   MessageBatchReader::Header::Header()
+      : mMessageTypeId(0)
+      , mCompact(false)
+      , mSource(false)
+      , mDestination(false)
+      , mSendingActor(false)
+      , mAboutActor(false)
+   {
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool MessageBatchReader::IsBatchFrame(dtUtil::DataStream& stream)
+   {
+      if (stream.GetRemainingReadSize() < sizeof(unsigned short))
+      {
+         return false;
+      }
+
+      unsigned readPosition = stream.GetReadPosition();
+      unsigned short id = 0;
+      stream.Read(id);
+      stream.Seekg(readPosition, dtUtil::DataStream::SeekTypeEnum::SET);
+      return id == MessageBatchWriter::BATCH_FRAME_ID;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   MessageBatchReader::MessageBatchReader(dtUtil::DataStream& frame)
+      : mFrame(frame)
+      , mNextMessagePosition(0)
+   {
+      unsigned short id = 0;
+      mFrame.Read(id);
+      if (id != MessageBatchWriter::BATCH_FRAME_ID)
+      {
+         throw dtUtil::DataStreamBufferReadError("The data stream is not a batch of messages.", __FILE__, __LINE__);
+      }
+      mNextMessagePosition = mFrame.GetReadPosition();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool MessageBatchReader::ReadHeader(Header& header)
+   {
+      mFrame.Seekg(mNextMessagePosition, dtUtil::DataStream::SeekTypeEnum::SET);
+      if (mFrame.GetRemainingReadSize() == 0)
+      {
+         return false;
+      }
+
+      unsigned short messageTypeId = 0;
+      unsigned char flags = 0;
+      unsigned short shortBodySize = 0;
+      mFrame.Read(messageTypeId);
+      mFrame.Read(flags);
+      mFrame.Read(shortBodySize);
+
+      unsigned bodySize = shortBodySize;
+      if (shortBodySize == LARGE_BODY_SIZE)
+      {
+         mFrame.Read(bodySize);
+      }
+
+      header.mCompact = (messageTypeId & COMPACT_BODY_FLAG) != 0;
+      header.mMessageTypeId = messageTypeId & ~COMPACT_BODY_FLAG;
+
+      ReadId(header.mSource);
+      if ((flags & FLAG_DESTINATION) != 0)
+      {
+         ReadId(header.mDestination);
+      }
+      else
+      {
+         header.mDestination = dtCore::UniqueId(false);
+      }
+      ReadId(header.mAboutActor);
+      if ((flags & FLAG_SENDING_IS_ABOUT) != 0)
+      {
+         header.mSendingActor = header.mAboutActor;
+      }
+      else
+      {
+         ReadId(header.mSendingActor);
+      }
+
+      if (bodySize > mFrame.GetRemainingReadSize())
+      {
+         throw dtUtil::DataStreamBufferReadError("A message in a batch runs past the end of the frame.", __FILE__, __LINE__);
+      }
+      mNextMessagePosition = mFrame.GetReadPosition() + bodySize;
+      return true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void MessageBatchReader::ReadId(dtCore::UniqueId& id)
+   {
+      unsigned char code = 0;
+      mFrame.Read(code);
+      if (code == ID_NULL)
+      {
+         id = dtCore::UniqueId(false);
+      }
+      else if (code == ID_FOLLOWS)
+      {
+         id.FromCompactDataStream(mFrame);
+         if (mFrameIds.size() < MAX_FRAME_IDS)
+         {
+            mFrameIds.push_back(id);
+         }
+      }
+      else if (code < mFrameIds.size())
+      {
+         id = mFrameIds[code];
+      }
+      else
+      {
+         throw dtUtil::DataStreamBufferReadError("A message in a batch refers to an id that isn't in the frame.", __FILE__, __LINE__);
+      }
+   }
+}
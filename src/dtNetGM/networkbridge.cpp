@@ -37,7 +37,14 @@ namespace dtNetGM
       , mMachineInfo(new dtGame::MachineInfo())
       , mGneConnection(NULL)
       , mConnectedClient(false)
+      , mSendSchemas(new dtGame::MessageSchemaTable)
+      , mReceiveSchemas(new dtGame::MessageSchemaTable)
+      , mReceiveSchemaErrorEpoch(0)
+      , mNumReceiveSchemaErrors(0)
       , mLastStream(0)
+      , mNumDataStreamsSent(0)
+      , mNumPacketsSent(0)
+      , mNumBytesSent(0)
    {
       mMachineInfo->SetName("Not Connected");
       mMachineInfo->SetHostName("");
@@ -201,8 +208,8 @@ namespace dtNetGM
 
    void NetworkBridge::SendDataStream(dtUtil::DataStream& dataStream, bool allowBestEffort)
    {
-      // Unreliable;
-      bool reliable = allowBestEffort && mGneConnection->getStats(0).openSockets == 0;
+      // Best effort only if it's allowed and there is an unreliable socket to send it on.
+      bool reliable = !allowBestEffort || mGneConnection->getStats(0).openSockets == 0;
 
       static unsigned int streamId = 0;
       // create packets
@@ -246,10 +253,26 @@ namespace dtNetGM
             // write packet to reliable stream
             mGneConnection->stream().writePacket(packet, reliable);
          }
+         ++mNumDataStreamsSent;
+         mNumPacketsSent += packetCount;
+         mNumBytesSent += dataStreamSize;
          LOG_DEBUG("Send DataStream[" + dtUtil::ToString(streamId) + "] in " + dtUtil::ToString(packetCount) + " packet(s) to " + GetHostDescription());
       }
    }
 
+   bool NetworkBridge::AddReceiveSchemaError()
+   {
+      // Start counting again whenever the host has reset its table.
+      if (mReceiveSchemas->GetEpoch() != mReceiveSchemaErrorEpoch)
+      {
+         mReceiveSchemaErrorEpoch = mReceiveSchemas->GetEpoch();
+         mNumReceiveSchemaErrors = 0;
+      }
+
+      ++mNumReceiveSchemaErrors;
+      return mNumReceiveSchemaErrors == MAX_RECEIVE_SCHEMA_ERRORS;
+   }
+
    void NetworkBridge::OnFailure(GNE::Connection& conn, const GNE::Error& error)
    {
       // forward to NetworkComponent
@@ -23,6 +23,7 @@
 
 #include <dtNetGM/networkcomponent.h>
 #include <dtNetGM/datastreampacket.h>
+#include <dtNetGM/messagebatch.h>
 //#include <dtNetGM/machineinfomessage.h>
 #include <dtNetGM/networkbridge.h>
 //#include <dtNetGM/serverframesyncmessage.h>
@@ -31,6 +32,8 @@
 #include <dtGame/messagetype.h>
 #include <dtGame/messagefactory.h>
 #include <dtGame/basemessages.h>
+#include <dtGame/messageschematable.h>
+#include <dtGame/exceptionenum.h>
 #include <dtUtil/log.h>
 #include <dtUtil/threadpool.h>
 #include <dtCore/system.h>
@@ -67,6 +70,25 @@ namespace dtNetGM
       OpenThreads::Atomic mQueued;
    };
 
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+   class BridgeBatchWriter: public MessageBatchWriter
+   {
+   public:
+      BridgeBatchWriter()
+      : mBridge(NULL)
+      {
+      }
+
+      NetworkBridge* mBridge;
+
+   protected:
+      virtual void OnFrameFinished(dtUtil::DataStream& frame)
+      {
+         mBridge->SendDataStream(frame, !GetFrameAddsSchemaDefinitions());
+      }
+   };
+
    ////////////////////////////////////////////////////////////////////////////////
    ////////////////////////////////////////////////////////////////////////////////
    IMPLEMENT_ENUM(MessageActionCode);
@@ -99,6 +121,8 @@ namespace dtNetGM
 
    NetworkComponent::NetworkComponent(dtCore::SystemComponentType& type)
    : dtGame::GMComponent(*TYPE)
+   , mCompactActorUpdates(false)
+   , mBatchMessages(false)
    , mShuttingDown(false)
    , mReliable(true)
    , mRateOut(0)
@@ -117,6 +141,8 @@ namespace dtNetGM
    , mGameName(gameName)
    , mGameVersion(gameVersion)
    , mGNELogFile(logFile)
+   , mCompactActorUpdates(false)
+   , mBatchMessages(false)
    , mShuttingDown(false)
    , mReliable(true)
    , mRateOut(0)
@@ -144,6 +170,8 @@ namespace dtNetGM
    DT_IMPLEMENT_ACCESSOR(NetworkComponent, std::string, GameName);
    DT_IMPLEMENT_ACCESSOR(NetworkComponent, int, GameVersion);
    DT_IMPLEMENT_ACCESSOR(NetworkComponent, std::string, GNELogFile);
+   DT_IMPLEMENT_ACCESSOR(NetworkComponent, bool, CompactActorUpdates);
+   DT_IMPLEMENT_ACCESSOR(NetworkComponent, bool, BatchMessages);
 
    ////////////////////////////////////////////////////////////////////////////////
    void NetworkComponent::BuildPropertyMap()
@@ -156,6 +184,10 @@ namespace dtNetGM
       DT_REGISTER_PROPERTY(GameName, "The Name of this game from the perspective or the networking.", RegHelperType, propReg);
       DT_REGISTER_PROPERTY(GameVersion, "The version this game from the perspective or the networking.", RegHelperType, propReg);
       DT_REGISTER_PROPERTY(GNELogFile, "The log file for the GNE networking library.", RegHelperType, propReg);
+      DT_REGISTER_PROPERTY(CompactActorUpdates, "Send actor updates using property indices negotiated per connection instead of names.  "
+               "All the hosts must support it.", RegHelperType, propReg);
+      DT_REGISTER_PROPERTY(BatchMessages, "Send the messages of each tick packed into as few packets as they fit in.  "
+               "All the hosts must support it.", RegHelperType, propReg);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -542,6 +574,28 @@ namespace dtNetGM
          return;
       }
 
+      dataStream.Rewind();
+      if (networkBridge.IsConnectedClient() && dataStream.GetRemainingReadSize() == sizeof(unsigned short))
+      {
+         unsigned short streamId = 0;
+         dataStream.Read(streamId);
+         dataStream.Rewind();
+         if (streamId == SCHEMA_RESET_REQUEST_ID)
+         {
+            LOGN_INFO("dtNetGM", networkBridge.GetHostDescription() + " asked to reset the message schemas sent to it.");
+            // The send schema tables are shared with the send task.
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            networkBridge.GetSendSchemaTable().Clear();
+            return;
+         }
+      }
+
+      if (networkBridge.IsConnectedClient() && MessageBatchReader::IsBatchFrame(dataStream))
+      {
+         ReceiveBatchFrame(networkBridge, dataStream);
+         return;
+      }
+
       dtCore::RefPtr<dtGame::Message> message;
       if (!networkBridge.IsConnectedClient())
       {
@@ -550,6 +604,7 @@ namespace dtNetGM
          unsigned short msgId = 0;
          dataStream.Read(msgId);
          dataStream.Rewind();
+         msgId &= ~COMPACT_ENCODING_FLAG;
 
          if (msgId == dtGame::MessageType::NETCLIENT_REQUEST_CONNECTION.GetId()
                || msgId == dtGame::MessageType::NETSERVER_ACCEPT_CONNECTION.GetId())
@@ -599,11 +654,39 @@ namespace dtNetGM
          //         }
 
          // forward the message to any other connections
-         dtUtil::DataStream dataStreamFwd = CreateDataStream(message);
+         const bool compact = GetCompactActorUpdates();
+         dtUtil::DataStream dataStreamFwd;
+         if (!compact)
+         {
+            dataStreamFwd = CreateDataStream(message);
+         }
+
          for (std::vector<dtNetGM::NetworkBridge*>::iterator iter = mConnections.begin(); iter != mConnections.end(); iter++)
          {
             dtNetGM::NetworkBridge* bridge = *iter;
-            if (bridge != &networkBridge && bridge->IsConnectedClient() && bridge->GetMachineInfo() != message.GetSource())
+            if (bridge == &networkBridge || !bridge->IsConnectedClient() || bridge->GetMachineInfo() == message.GetSource())
+            {
+               continue;
+            }
+
+            dtCore::RefPtr<const dtGame::Message> toSend = GetMessageForClient(message, *bridge);
+            if (!toSend.valid())
+            {
+               continue;
+            }
+
+            if (compact)
+            {
+               // The send schema tables are shared with the send task, and the definitions they write
+               // must reach the host in the same order they were added, so encode and send under the lock.
+               OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+               SendMessageTo(*toSend, *bridge, GetSendSchemaTableFor(*bridge));
+            }
+            else if (toSend.get() != &message)
+            {
+               bridge->SendDataStream(CreateDataStream(*toSend), true);
+            }
+            else
             {
                bridge->SendDataStream(dataStreamFwd, true);
             }
@@ -666,7 +749,8 @@ namespace dtNetGM
 
       AddMessageToOutputBuffer(message);
 
-      if (mMessageBufferOut.size() > 5)
+      // When batching, everything waits for the end of the tick so it can be packed together.
+      if (!GetBatchMessages() && mMessageBufferOut.size() > 5)
       {
          StartSendTask();
       }
@@ -692,6 +776,12 @@ namespace dtNetGM
    /////////////////////////////////////////////////////////////
    void NetworkComponent::SendNetworkMessages(MessageBufferType& messageBuffer)
    {
+      if (GetBatchMessages())
+      {
+         SendBatchedNetworkMessages(messageBuffer);
+         return;
+      }
+
       MessageBufferType::iterator i, iend;
       i = messageBuffer.begin();
       iend = messageBuffer.end();
@@ -727,6 +817,92 @@ namespace dtNetGM
       }
    }
 
+   /////////////////////////////////////////////////////////////
+   void NetworkComponent::SendBatchedNetworkMessages(MessageBufferType& messageBuffer)
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+      if (IsShuttingDown())
+      {
+         return;
+      }
+
+      const bool compact = GetCompactActorUpdates();
+      BridgeBatchWriter writer;
+      for (std::vector<NetworkBridge*>::iterator iter = mConnections.begin(); iter != mConnections.end(); iter++)
+      {
+         NetworkBridge& bridge = **iter;
+         writer.mBridge = &bridge;
+         dtGame::MessageSchemaTable* schemas = compact ? GetSendSchemaTableFor(bridge) : NULL;
+
+         MessageBufferType::iterator i, iend;
+         i = messageBuffer.begin();
+         iend = messageBuffer.end();
+         for (; i != iend; ++i)
+         {
+            dtCore::RefPtr<const dtGame::Message> toSend = GetMessageFor(**i, bridge);
+            if (!toSend.valid())
+            {
+               continue;
+            }
+
+            const dtGame::Message& message = *toSend;
+
+            // Hosts that haven't been accepted yet can't read frames, and a causing message has no place in one.
+            if (bridge.IsConnectedClient() && message.GetCausingMessage() == NULL)
+            {
+               writer.AddMessage(message, schemas);
+            }
+            else
+            {
+               // Finish the frame first so the host gets the messages in the order they were sent.
+               writer.Flush();
+               SendMessageTo(message, bridge, schemas);
+            }
+         }
+
+         writer.Flush();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   dtCore::RefPtr<const dtGame::Message> NetworkComponent::GetMessageFor(const dtGame::Message& message, const NetworkBridge& networkBridge)
+   {
+      if (message.GetDestination() == NULL)
+      {
+         // A connection request goes to the hosts that aren't clients yet, everything else to all the clients.
+         if (message.GetMessageType() == dtGame::MessageType::NETCLIENT_REQUEST_CONNECTION)
+         {
+            if (networkBridge.IsConnectedClient())
+            {
+               return NULL;
+            }
+            return &message;
+         }
+
+         if (!networkBridge.IsConnectedClient())
+         {
+            return NULL;
+         }
+         return GetMessageForClient(message, networkBridge);
+      }
+
+      // trying to send a message across the network to ourselves, or to another host
+      if (*message.GetDestination() == GetGameManager()->GetMachineInfo()
+            || networkBridge.GetMachineInfo() != *message.GetDestination())
+      {
+         return NULL;
+      }
+
+      return &message;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   dtCore::RefPtr<const dtGame::Message> NetworkComponent::GetMessageForClient(const dtGame::Message& message, const NetworkBridge& /*networkBridge*/)
+   {
+      return &message;
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    void NetworkComponent::SendNetworkMessage(const dtGame::Message& message, const DestinationType& destinationType)
    {
@@ -737,8 +913,14 @@ namespace dtNetGM
          return;
       }
 
-      // Create the MessageDataStream
-      dtUtil::DataStream dataStream = CreateDataStream(message);
+      // Create the MessageDataStream.  With the compact encoding, each connection has its own schema table, so
+      // the stream has to be written for each destination.
+      const bool compact = GetCompactActorUpdates();
+      dtUtil::DataStream dataStream;
+      if (!compact)
+      {
+         dataStream = CreateDataStream(message);
+      }
 
       if (destinationType == DestinationType::DESTINATION)
       {
@@ -746,60 +928,134 @@ namespace dtNetGM
          {
             if ((*iter)->GetMachineInfo() == *(message.GetDestination()))
             {
-               (*iter)->SendDataStream(dataStream, true);
+               if (compact)
+               {
+                  SendMessageTo(message, **iter, GetSendSchemaTableFor(**iter));
+               }
+               else
+               {
+                  (*iter)->SendDataStream(dataStream, true);
+               }
                return;
             }
          }
       } // DestinationType::DESTINATION
       else
       {
-         if (destinationType == DestinationType::ALL_CLIENTS)
+         // ALL_CLIENTS sends to the accepted clients, ALL_NOT_CLIENTS to the rest.
+         const bool toClients = destinationType == DestinationType::ALL_CLIENTS;
+         for (std::vector<NetworkBridge*>::iterator iter = mConnections.begin(); iter != mConnections.end(); iter++)
          {
-            for (std::vector<NetworkBridge*>::iterator iter = mConnections.begin(); iter != mConnections.end(); iter++)
+            if ((*iter)->IsConnectedClient() != toClients)
             {
-               if ((*iter)->IsConnectedClient())
-               {
-                  (*iter)->SendDataStream(dataStream, true);
-               }
+               continue;
             }
-         } // DestinationType::ALL_CLIENTS
-         else
-         {
-            // DestinationType::ALL_NOT_CLIENTS
-            for (std::vector<NetworkBridge*>::iterator iter = mConnections.begin(); iter != mConnections.end(); iter++)
+
+            dtCore::RefPtr<const dtGame::Message> toSend = &message;
+            if (toClients)
             {
-               if (!(*iter)->IsConnectedClient())
-               {
-                  (*iter)->SendDataStream(dataStream, true);
-               }
+               toSend = GetMessageForClient(message, **iter);
+            }
+            if (!toSend.valid())
+            {
+               continue;
+            }
+
+            if (compact)
+            {
+               SendMessageTo(*toSend, **iter, GetSendSchemaTableFor(**iter));
+            }
+            else if (toSend.get() != &message)
+            {
+               (*iter)->SendDataStream(CreateDataStream(*toSend), true);
+            }
+            else
+            {
+               (*iter)->SendDataStream(dataStream, true);
             }
-         } // DestinationType::ALL_NOT_CLIENTS
+         }
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   dtGame::MessageSchemaTable* NetworkComponent::GetSendSchemaTableFor(NetworkBridge& networkBridge)
+   {
+      // The connection handshake is always sent with the full encoding.
+      if (!networkBridge.IsConnectedClient())
+      {
+         return NULL;
+      }
+      return &networkBridge.GetSendSchemaTable();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void NetworkComponent::SendMessageTo(const dtGame::Message& message, NetworkBridge& networkBridge, dtGame::MessageSchemaTable* schemas)
+   {
+      unsigned numDefinitions = 0;
+      if (schemas != NULL)
+      {
+         numDefinitions = schemas->GetNumDefinitionsWritten();
       }
+
+      dtUtil::DataStream dataStream = CreateDataStream(message, schemas);
+
+      const bool addsDefinitions = schemas != NULL && schemas->GetNumDefinitionsWritten() != numDefinitions;
+      networkBridge.SendDataStream(dataStream, !addsDefinitions);
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   dtUtil::DataStream NetworkComponent::CreateDataStream(const dtGame::Message& message)
+   dtUtil::DataStream NetworkComponent::CreateDataStream(const dtGame::Message& message, dtGame::MessageSchemaTable* schemas)
    {
       dtUtil::DataStream stream;
 
-      stream.Write(message.GetMessageType().GetId()); // MessageType.mId
-      stream.Write(message.GetSource().GetUniqueId().ToString()); // Source
-      if (message.GetDestination() != NULL)
+      unsigned short msgId = message.GetMessageType().GetId();
+      if (schemas != NULL)
       {
-         stream.Write(message.GetDestination()->GetUniqueId().ToString()); // Destination
+         msgId |= COMPACT_ENCODING_FLAG;
+      }
+      stream.Write(msgId); // MessageType.mId
+      if (schemas != NULL)
+      {
+         // The compact encoding also writes the ids in binary.
+         message.GetSource().GetUniqueId().ToCompactDataStream(stream); // Source
+         if (message.GetDestination() != NULL)
+         {
+            message.GetDestination()->GetUniqueId().ToCompactDataStream(stream); // Destination
+         }
+         else
+         {
+            dtCore::UniqueId(false).ToCompactDataStream(stream);
+         }
+         message.GetSendingActorId().ToCompactDataStream(stream); // Sending Actor
+         message.GetAboutActorId().ToCompactDataStream(stream); // About Actor
       }
       else
       {
-         stream.Write(std::string(""));
+         stream.Write(message.GetSource().GetUniqueId().ToString()); // Source
+         if (message.GetDestination() != NULL)
+         {
+            stream.Write(message.GetDestination()->GetUniqueId().ToString()); // Destination
+         }
+         else
+         {
+            stream.Write(std::string(""));
+         }
+         stream.Write(message.GetSendingActorId().ToString()); // Sending Actor
+         stream.Write(message.GetAboutActorId().ToString()); // About Actor
       }
-      stream.Write(message.GetSendingActorId().ToString()); // Sending Actor
-      stream.Write(message.GetAboutActorId().ToString()); // About Actor
 
-      message.ToDataStream(stream);
+      if (schemas != NULL)
+      {
+         message.ToCompactDataStream(stream, *schemas);
+      }
+      else
+      {
+         message.ToDataStream(stream);
+      }
 
       if (message.GetCausingMessage() != NULL)
       {
-         stream.AppendDataStream(CreateDataStream(*message.GetCausingMessage()));
+         stream.AppendDataStream(CreateDataStream(*message.GetCausingMessage(), schemas));
          // append causing message??
       }
 
@@ -807,7 +1063,71 @@ namespace dtNetGM
    }
 
    ////////////////////////////////////////////////////////////////////////////////
-   dtCore::RefPtr<dtGame::Message> NetworkComponent::CreateMessage(dtUtil::DataStream& dataStream, const NetworkBridge& networkBridge)
+   dtCore::RefPtr<dtGame::Message> NetworkComponent::CreateMessage(dtUtil::DataStream& dataStream, NetworkBridge& networkBridge)
+   {
+      unsigned short msgId = 0;
+
+      // MessageType.mId
+      dataStream.Read(msgId);
+
+      const bool compact = (msgId & COMPACT_ENCODING_FLAG) != 0;
+      msgId &= ~COMPACT_ENCODING_FLAG;
+
+      dtCore::RefPtr<dtGame::Message> msg = CreateMessageOfType(msgId);
+      if (!msg.valid())
+      {
+         return NULL;
+      }
+
+      dtCore::UniqueId sourceId(false), destinationId(false), sendingActorId(false), aboutActorId(false);
+      if (compact)
+      {
+         sourceId.FromCompactDataStream(dataStream);
+         destinationId.FromCompactDataStream(dataStream);
+         sendingActorId.FromCompactDataStream(dataStream);
+         aboutActorId.FromCompactDataStream(dataStream);
+      }
+      else
+      {
+         std::string szUniqueId;
+         dataStream.Read(szUniqueId);
+         sourceId = szUniqueId;
+         dataStream.Read(szUniqueId);
+         destinationId = szUniqueId;
+         dataStream.Read(szUniqueId);
+         sendingActorId = szUniqueId;
+         dataStream.Read(szUniqueId);
+         aboutActorId = szUniqueId;
+      }
+
+      SetReceivedMessageIds(*msg, networkBridge, sourceId, destinationId, sendingActorId, aboutActorId);
+
+      if (compact)
+      {
+         if (!ReadCompactBody(*msg, dataStream, networkBridge))
+         {
+            return NULL;
+         }
+      }
+      else
+      {
+         msg->FromDataStream(dataStream);
+      }
+
+      if (dataStream.GetRemainingReadSize() != 0)
+      {
+         dtCore::RefPtr<dtGame::Message> msg = CreateMessage(dataStream, networkBridge);
+         if (msg.valid())
+         {
+            // more information, there must be a causing message!
+            msg->SetCausingMessage(msg);
+         }
+      }
+      return msg;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   dtCore::RefPtr<dtGame::Message> NetworkComponent::CreateMessageOfType(unsigned short msgId)
    {
       //Sometimes the thread isn't stopped yet when the component is removed from the GM, so this ends up as NULL
       dtGame::GameManager* gm = GetGameManager();
@@ -817,11 +1137,6 @@ namespace dtNetGM
       }
 
       dtCore::RefPtr<dtGame::Message> msg;
-      unsigned short msgId = 0;
-
-      // MessageType.mId
-      dataStream.Read(msgId);
-
       try
       {
          const dtGame::MessageType& messageType = gm->GetMessageFactory().GetMessageTypeById(msgId);
@@ -850,51 +1165,104 @@ namespace dtNetGM
          return NULL;
       }
 
-      std::string szUniqueId;
+      return msg;
+   }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   void NetworkComponent::SetReceivedMessageIds(dtGame::Message& msg, const NetworkBridge& networkBridge,
+            const dtCore::UniqueId& sourceId, const dtCore::UniqueId& destinationId,
+            const dtCore::UniqueId& sendingActorId, const dtCore::UniqueId& aboutActorId)
+   {
       // Source
-      dataStream.Read(szUniqueId);
-
-      const dtGame::MachineInfo* machInfo = GetMachineInfo(dtCore::UniqueId(szUniqueId));
+      const dtGame::MachineInfo* machInfo = GetMachineInfo(sourceId);
 
       if (machInfo != NULL)
       {
-         msg->SetSource(*machInfo);
+         msg.SetSource(*machInfo);
       }
       else
       {
          // It's either from a host that this client is talking to, or it could be the
          // first message to come over.  Either way, the machine info for the source may not be NULL.
-         msg->SetSource(networkBridge.GetMachineInfo());
+         msg.SetSource(networkBridge.GetMachineInfo());
       }
 
       // Destination
-      dataStream.Read(szUniqueId);
-      if (szUniqueId.size() != 0)
+      if (!destinationId.IsNull())
       {
-         msg->SetDestination(GetMachineInfo(dtCore::UniqueId(szUniqueId)));
+         msg.SetDestination(GetMachineInfo(destinationId));
       }
 
-      // Sending Actor
-      dataStream.Read(szUniqueId);
-      msg->SetSendingActorId(dtCore::UniqueId(szUniqueId));
+      msg.SetSendingActorId(sendingActorId);
+      msg.SetAboutActorId(aboutActorId);
+   }
 
-      // About Actor
-      dataStream.Read(szUniqueId);
-      msg->SetAboutActorId(dtCore::UniqueId(szUniqueId));
+   ////////////////////////////////////////////////////////////////////////////////
+   void NetworkComponent::ReceiveBatchFrame(NetworkBridge& networkBridge, dtUtil::DataStream& frame)
+   {
+      try
+      {
+         MessageBatchReader reader(frame);
+         MessageBatchReader::Header header;
+         while (reader.ReadHeader(header))
+         {
+            // The reader skips the body of a message that can't be created on the next ReadHeader.
+            dtCore::RefPtr<dtGame::Message> message = CreateMessageOfType(header.mMessageTypeId);
+            if (!message.valid())
+            {
+               continue;
+            }
 
-      msg->FromDataStream(dataStream);
+            SetReceivedMessageIds(*message, networkBridge, header.mSource, header.mDestination,
+                     header.mSendingActor, header.mAboutActor);
 
-      if (dataStream.GetRemainingReadSize() != 0)
+            if (header.mCompact)
+            {
+               // The reader moves past the rest of the body of a dropped message on the next ReadHeader.
+               if (!ReadCompactBody(*message, frame, networkBridge))
+               {
+                  continue;
+               }
+            }
+            else
+            {
+               message->FromDataStream(frame);
+            }
+
+            OnReceivedNetworkMessage(*message, networkBridge);
+            ForwardMessage(*message, networkBridge);
+         }
+      }
+      catch (const dtUtil::Exception& ex)
       {
-         dtCore::RefPtr<dtGame::Message> msg = CreateMessage(dataStream, networkBridge);
-         if (msg.valid())
+         LOGN_ERROR("dtNetGM", "Unable to read a batch of messages from " + networkBridge.GetHostDescription() + ": " + ex.ToString());
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool NetworkComponent::ReadCompactBody(dtGame::Message& msg, dtUtil::DataStream& dataStream, NetworkBridge& networkBridge)
+   {
+      try
+      {
+         msg.FromCompactDataStream(dataStream, networkBridge.GetReceiveSchemaTable());
+      }
+      catch (const dtGame::InvalidParameterException& ex)
+      {
+         LOGN_WARNING("dtNetGM", "Dropping a " + msg.GetMessageType().GetName() + " message from "
+                  + networkBridge.GetHostDescription() + ": " + ex.ToString());
+
+         if (networkBridge.AddReceiveSchemaError())
          {
-            // more information, there must be a causing message!
-            msg->SetCausingMessage(msg);
+            LOGN_WARNING("dtNetGM", "The message schemas of " + networkBridge.GetHostDescription()
+                     + " are out of sync.  Asking it to reset them.");
+            dtUtil::DataStream request;
+            request.Write(SCHEMA_RESET_REQUEST_ID);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            networkBridge.SendDataStream(request, false);
          }
+         return false;
       }
-      return msg;
+      return true;
    }
 
    ////////////////////////////////////////////////////////////////////////////////
@@ -25,6 +25,7 @@
 #include <dtNetGM/networkcomponent.h>
 #include <dtNetGM/networkbridge.h>
 #include <dtNetGM/serverconnectionlistener.h>
+#include <dtGame/actorupdatemessage.h>
 #include <dtGame/basemessages.h>
 #include <dtGame/messagefactory.h>
 #include <dtGame/messagetype.h>
@@ -127,10 +128,88 @@ namespace dtNetGM
          AddMessageToOutputBuffer(*frameSync); // Note - should go to all clients
       }
 
+      if (mInterestManager.valid())
+      {
+         mInterestManager->SetCurrentTime(GetGameManager()->GetSimulationTime());
+      }
+
       BaseClass::DoEndOfTick();
 
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   void ServerNetworkComponent::SetInterestManager(InterestManager* interestManager)
+   {
+      mInterestManager = interestManager;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   InterestManager* ServerNetworkComponent::GetInterestManager()
+   {
+      return mInterestManager.get();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   const InterestManager* ServerNetworkComponent::GetInterestManager() const
+   {
+      return mInterestManager.get();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ServerNetworkComponent::SetClientInterest(const dtGame::MachineInfo& client, const InterestRegion& region)
+   {
+      if (!mInterestManager.valid())
+      {
+         mInterestManager = new InterestManager();
+      }
+      mInterestManager->SetClientInterest(client.GetUniqueId(), region);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ServerNetworkComponent::DispatchNetworkMessage(const dtGame::Message& message)
+   {
+      if (mInterestManager.valid())
+      {
+         mInterestManager->ObserveMessage(message);
+      }
+      BaseClass::DispatchNetworkMessage(message);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void ServerNetworkComponent::ForwardMessage(const dtGame::Message& message, NetworkBridge& networkBridge)
+   {
+      if (mInterestManager.valid())
+      {
+         mInterestManager->ObserveMessage(message);
+      }
+      BaseClass::ForwardMessage(message, networkBridge);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   dtCore::RefPtr<const dtGame::Message> ServerNetworkComponent::GetMessageForClient(const dtGame::Message& message, const NetworkBridge& networkBridge)
+   {
+      if (!mInterestManager.valid())
+      {
+         return &message;
+      }
+
+      bool addDeadReckoningState = false;
+      if (!mInterestManager->ShouldSend(message, networkBridge.GetMachineInfo().GetUniqueId(), &addDeadReckoningState))
+      {
+         return NULL;
+      }
+
+      if (!addDeadReckoningState)
+      {
+         return &message;
+      }
+
+      // The client missed some updates of the actor, so it gets a copy with all of the dead reckoning values.
+      dtCore::RefPtr<dtGame::Message> fullUpdate = GetGameManager()->GetMessageFactory().CloneMessage(message);
+      mInterestManager->AddDeadReckoningState(static_cast<dtGame::ActorUpdateMessage&>(*fullUpdate));
+      return fullUpdate.get();
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    void ServerNetworkComponent::SendFrameSyncControlMessage()
    {
@@ -220,8 +299,7 @@ namespace dtNetGM
    ////////////////////////////////////////////////////////////////////////////////
    void ServerNetworkComponent::OnDisconnect(NetworkBridge& networkBridge)
    {
-      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-
+      // Not under mMutex, because sending the message and removing the connection both lock it, and it isn't recursive.
       if (networkBridge.IsConnectedClient() && !IsShuttingDown())
       {
          networkBridge.SetClientConnected(false);
@@ -234,6 +312,11 @@ namespace dtNetGM
          SendNetworkMessage(*machineMsg, DestinationType::ALL_CLIENTS);
       }
 
+      if (mInterestManager.valid())
+      {
+         mInterestManager->RemoveClient(networkBridge.GetMachineInfo().GetUniqueId());
+      }
+
       // remove Connection
       NetworkComponent::OnDisconnect(networkBridge);
    }
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cfloat>
+#include <algorithm>
 
 #include <dtUtil/matrixutil.h>
 #include <dtUtil/coordinates.h>
@@ -9,6 +10,11 @@
 #include <dtUtil/stringutils.h>
 #include <dtUtil/mathdefines.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DELTA_COORDINATES_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace dtUtil
 {
    /////////////////////////////////////////////////////////////////////////////
@@ -122,6 +128,36 @@ namespace dtUtil
       return ((double) (TranMerc_a * (1.e0 - TranMerc_es) / pow(DENOM(Latitude), 3)));
    }
 
+   namespace
+   {
+      /// Sets up the transverse mercator parameters for a UTM zone and hemisphere.
+      void CalcUTMZoneParameters(UTMParameters& params, unsigned zone, char hemisphere)
+      {
+         double Origin_Latitude = 0.0;
+         double Central_Meridian = 0.0;
+         double False_Easting = 500000;
+         double False_Northing = 0;
+
+         if (zone >= 31)
+         {
+            Central_Meridian = osg::DegreesToRadians(double(6 * zone - 183));
+         }
+         else
+         {
+            Central_Meridian = osg::DegreesToRadians(double(6 * zone + 177));
+         }
+
+         // If we are projecting in the southern hemisphere, set the false northing.
+         if (hemisphere == 'S' || hemisphere == 's')
+         {
+            False_Northing = 10000000;
+         }
+
+         params.CalcTransverseMercatorParameters(Geocent_a, Geocent_f, Origin_Latitude,
+                                         Central_Meridian, False_Easting, False_Northing, CentralMeridianScale);
+      }
+   }
+
    IMPLEMENT_ENUM(IncomingCoordinateType)
    const IncomingCoordinateType IncomingCoordinateType::GEOCENTRIC("Geocentric");
    const IncomingCoordinateType IncomingCoordinateType::GEODETIC("Geodetic");
@@ -938,6 +974,574 @@ namespace dtUtil
       return rotation;
    }
 
+   /////////////////////////////////////////////////////////////////////////////
+   // Batch conversions
+   //
+   // The batch versions work on blocks of points kept as separate arrays of each component.  Everything that
+   // depends only on the configuration is set up once per call, the sines of the multiple angles in the
+   // meridional distance come from one sine and cosine, and the geocentric to geodetic kernel runs two points at
+   // a time with SSE2 where the compiler targets it.
+   /////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      /// The number of points converted at a time, which keeps the block arrays small enough for the stack.
+      const unsigned BATCH_BLOCK_SIZE = 64;
+
+      /// Same as UTMParameters::SPHTMD, with the sine and cosine of the latitude already calculated.
+      inline double MeridionalDistance(const UTMParameters& params, double latitude, double s, double c)
+      {
+         const double sin2 = 2.0 * s * c;
+         const double cos2 = c * c - s * s;
+         const double sin4 = 2.0 * sin2 * cos2;
+         const double cos4 = cos2 * cos2 - sin2 * sin2;
+         const double sin6 = sin4 * cos2 + cos4 * sin2;
+         const double sin8 = 2.0 * sin4 * cos4;
+         return params.TranMerc_ap * latitude
+            - params.TranMerc_bp * sin2 + params.TranMerc_cp * sin4
+            - params.TranMerc_dp * sin6 + params.TranMerc_ep * sin8;
+      }
+
+      /// One point of Bowring's method, as in Coordinates::ConvertGeocentricToGeodetic, but not for points on the z axis.
+      inline void GeocentricToGeodeticPoint(double x, double y, double z, double& sinLat, double& cosLat, double& elevation)
+      {
+         const double Geocent_b = Geocent_a * (1 - Geocent_f);
+         double W2 = x*x + y*y;
+         double W = sqrt(W2);
+         double T0 = z * AD_C;
+         double S0 = sqrt(T0 * T0 + W2);
+         double Sin_B0 = T0 / S0;
+         double Cos_B0 = W / S0;
+         double Sin3_B0 = Sin_B0 * Sin_B0 * Sin_B0;
+         double T1 = z + Geocent_b * Geocent_ep2 * Sin3_B0;
+         double Sum = W - Geocent_a * Geocent_e2 * Cos_B0 * Cos_B0 * Cos_B0;
+         double S1 = sqrt(T1*T1 + Sum * Sum);
+         double Sin_p1 = T1 / S1;
+         double Cos_p1 = Sum / S1;
+         double Rn = Geocent_a / sqrt(1.0 - Geocent_e2 * Sin_p1 * Sin_p1);
+         if (std::abs(Cos_p1) >= COS_67P5)
+         {
+            elevation = W / std::abs(Cos_p1) - Rn;
+         }
+         else
+         {
+            elevation = z / Sin_p1 + Rn * (Geocent_e2 - 1.0);
+         }
+         sinLat = Sin_p1;
+         cosLat = Cos_p1;
+      }
+
+      /**
+       * Bowring's method for a block of points.  The latitude is atan(sinLat / cosLat), which is left to the caller.
+       * The points may not be on the z axis.
+       */
+      void GeocentricToGeodeticBlock(const double* x, const double* y, const double* z,
+               double* sinLat, double* cosLat, double* elevation, unsigned count)
+      {
+         unsigned i = 0;
+#ifdef DELTA_COORDINATES_SSE2
+         const __m128d one = _mm_set1_pd(1.0);
+         const __m128d signMask = _mm_set1_pd(-0.0);
+         const __m128d adc = _mm_set1_pd(AD_C);
+         const __m128d a = _mm_set1_pd(Geocent_a);
+         const __m128d bEp2 = _mm_set1_pd(Geocent_a * (1 - Geocent_f) * Geocent_ep2);
+         const __m128d aE2 = _mm_set1_pd(Geocent_a * Geocent_e2);
+         const __m128d e2 = _mm_set1_pd(Geocent_e2);
+         const __m128d e2Minus1 = _mm_set1_pd(Geocent_e2 - 1.0);
+         const __m128d cos67p5 = _mm_set1_pd(COS_67P5);
+
+         for (; i + 2 <= count; i += 2)
+         {
+            const __m128d vx = _mm_loadu_pd(x + i);
+            const __m128d vy = _mm_loadu_pd(y + i);
+            const __m128d vz = _mm_loadu_pd(z + i);
+
+            const __m128d W2 = _mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy));
+            const __m128d W = _mm_sqrt_pd(W2);
+            const __m128d T0 = _mm_mul_pd(vz, adc);
+            const __m128d S0 = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(T0, T0), W2));
+            const __m128d Sin_B0 = _mm_div_pd(T0, S0);
+            const __m128d Cos_B0 = _mm_div_pd(W, S0);
+            const __m128d Sin3_B0 = _mm_mul_pd(_mm_mul_pd(Sin_B0, Sin_B0), Sin_B0);
+            const __m128d T1 = _mm_add_pd(vz, _mm_mul_pd(bEp2, Sin3_B0));
+            const __m128d Sum = _mm_sub_pd(W, _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(aE2, Cos_B0), Cos_B0), Cos_B0));
+            const __m128d S1 = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(T1, T1), _mm_mul_pd(Sum, Sum)));
+            const __m128d Sin_p1 = _mm_div_pd(T1, S1);
+            const __m128d Cos_p1 = _mm_div_pd(Sum, S1);
+            const __m128d Rn = _mm_div_pd(a, _mm_sqrt_pd(_mm_sub_pd(one, _mm_mul_pd(_mm_mul_pd(e2, Sin_p1), Sin_p1))));
+
+            // Both elevations are calculated, and the one for the latitude is picked.
+            const __m128d absCos_p1 = _mm_andnot_pd(signMask, Cos_p1);
+            const __m128d lowLatitude = _mm_sub_pd(_mm_div_pd(W, absCos_p1), Rn);
+            const __m128d highLatitude = _mm_add_pd(_mm_div_pd(vz, Sin_p1), _mm_mul_pd(Rn, e2Minus1));
+            const __m128d useLow = _mm_cmpge_pd(absCos_p1, cos67p5);
+            const __m128d elev = _mm_or_pd(_mm_and_pd(useLow, lowLatitude), _mm_andnot_pd(useLow, highLatitude));
+
+            _mm_storeu_pd(sinLat + i, Sin_p1);
+            _mm_storeu_pd(cosLat + i, Cos_p1);
+            _mm_storeu_pd(elevation + i, elev);
+         }
+#endif
+         for (; i < count; ++i)
+         {
+            GeocentricToGeodeticPoint(x[i], y[i], z[i], sinLat[i], cosLat[i], elevation[i]);
+         }
+      }
+
+      /**
+       * Coordinates::ConvertGeodeticToUTM for a block of points, including its longitude wrapping.
+       * @param tmdo the meridional distance of the latitude of origin.
+       */
+      void GeodeticToTransverseMercatorBlock(const UTMParameters& params, double tmdo,
+               const double* latitude, const double* longitude, const double* sinLat, const double* cosLat,
+               double* easting, double* northing, unsigned count)
+      {
+         const double k = params.TranMerc_Scale_Factor;
+         for (unsigned i = 0; i < count; ++i)
+         {
+            double lon = longitude[i];
+            lon = lon < 0 ? lon + ((2*osg::PI) + 1.0e-10) : lon;
+            lon = lon > osg::PI ? lon - (2 * osg::PI) : lon;
+
+            double dlam = lon - params.TranMerc_Origin_Long;
+            dlam = dlam > osg::PI ? dlam - (2 * osg::PI) : dlam;
+            dlam = dlam < -osg::PI ? dlam + (2 * osg::PI) : dlam;
+            dlam = std::abs(dlam) < 2.e-10 ? 0.0 : dlam;
+
+            const double s = sinLat[i];
+            const double c = cosLat[i];
+            const double c2 = c * c;
+            const double c3 = c2 * c;
+            const double c5 = c3 * c2;
+            const double c7 = c5 * c2;
+            const double t = s / c;
+            const double tan2 = t * t;
+            const double tan4 = tan2 * tan2;
+            const double tan6 = tan4 * tan2;
+            const double eta = params.TranMerc_ebs * c2;
+            const double eta2 = eta * eta;
+            const double eta3 = eta2 * eta;
+            const double eta4 = eta3 * eta;
+
+            const double sn = params.TranMerc_a / sqrt(1.e0 - params.TranMerc_es * s * s);
+            const double tmd = MeridionalDistance(params, latitude[i], s, c);
+
+            const double t1 = (tmd - tmdo) * k;
+            const double t2 = sn * s * c * k / 2.e0;
+            const double t3 = sn * s * c3 * k * (5.e0 - tan2 + 9.e0 * eta + 4.e0 * eta2) / 24.e0;
+            const double t4 = sn * s * c5 * k * (61.e0 - 58.e0 * tan2
+                     + tan4 + 270.e0 * eta - 330.e0 * tan2 * eta + 445.e0 * eta2
+                     + 324.e0 * eta3 -680.e0 * tan2 * eta2 + 88.e0 * eta4
+                     -600.e0 * tan2 * eta3 - 192.e0 * tan2 * eta4) / 720.e0;
+            const double t5 = sn * s * c7 * k * (1385.e0 - 3111.e0 * tan2 + 543.e0 * tan4 - tan6) / 40320.e0;
+
+            const double dlam2 = dlam * dlam;
+            const double dlam4 = dlam2 * dlam2;
+            const double dlam6 = dlam4 * dlam2;
+            const double dlam8 = dlam4 * dlam4;
+            northing[i] = params.TranMerc_False_Northing + t1 + dlam2 * t2
+               + dlam4 * t3 + dlam6 * t4 + dlam8 * t5;
+
+            const double t6 = sn * c * k;
+            const double t7 = sn * c3 * k * (1.e0 - tan2 + eta) / 6.e0;
+            const double t8 = sn * c5 * k * (5.e0 - 18.e0 * tan2 + tan4
+                     + 14.e0 * eta - 58.e0 * tan2 * eta + 13.e0 * eta2 + 4.e0 * eta3
+                     - 64.e0 * tan2 * eta2 - 24.e0 * tan2 * eta3) / 120.e0;
+            const double t9 = sn * c7 * k * (61.e0 - 479.e0 * tan2 + 179.e0 * tan4 - tan6) / 5040.e0;
+
+            easting[i] = params.TranMerc_False_Easting + dlam * t6 + dlam2 * dlam * t7
+               + dlam4 * dlam * t8 + dlam6 * dlam * t9;
+         }
+      }
+
+      /**
+       * Coordinates::ConvertTransverseMercatorToGeodetic for a block of points.
+       * @param tmdo the meridional distance of the latitude of origin.
+       */
+      void TransverseMercatorToGeodeticBlock(const UTMParameters& params, double tmdo,
+               const double* easting, const double* northing, double* latitude, double* longitude, unsigned count)
+      {
+         const double k = params.TranMerc_Scale_Factor;
+         const double k2 = k * k;
+         const double k3 = k2 * k;
+         const double k4 = k2 * k2;
+         const double k5 = k4 * k;
+         const double k6 = k4 * k2;
+         const double k7 = k6 * k;
+         const double k8 = k4 * k4;
+         const double srNumerator = params.TranMerc_a * (1.e0 - params.TranMerc_es);
+
+         double tmd[BATCH_BLOCK_SIZE];
+         double ftphi[BATCH_BLOCK_SIZE];
+         double s[BATCH_BLOCK_SIZE];
+         double c[BATCH_BLOCK_SIZE];
+
+         for (unsigned start = 0; start < count; start += BATCH_BLOCK_SIZE)
+         {
+            const unsigned n = std::min(count - start, BATCH_BLOCK_SIZE);
+
+            // The footpoint latitude, starting from the radius of curvature at the equator.
+            for (unsigned i = 0; i < n; ++i)
+            {
+               tmd[i] = tmdo + (northing[start + i] - params.TranMerc_False_Northing) / k;
+               ftphi[i] = tmd[i] / srNumerator;
+            }
+
+            for (unsigned iteration = 0; iteration < 5; ++iteration)
+            {
+               for (unsigned i = 0; i < n; ++i)
+               {
+                  s[i] = sin(ftphi[i]);
+                  c[i] = cos(ftphi[i]);
+               }
+
+               for (unsigned i = 0; i < n; ++i)
+               {
+                  const double denom = sqrt(1.e0 - params.TranMerc_es * s[i] * s[i]);
+                  const double sr = srNumerator / (denom * denom * denom);
+                  ftphi[i] = ftphi[i] + (tmd[i] - MeridionalDistance(params, ftphi[i], s[i], c[i])) / sr;
+               }
+            }
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+               s[i] = sin(ftphi[i]);
+               c[i] = cos(ftphi[i]);
+            }
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+               const double denom = sqrt(1.e0 - params.TranMerc_es * s[i] * s[i]);
+               const double sr = srNumerator / (denom * denom * denom);
+               const double sn = params.TranMerc_a / denom;
+               const double sn3 = sn * sn * sn;
+               const double sn5 = sn3 * sn * sn;
+               const double sn7 = sn5 * sn * sn;
+
+               const double t = s[i] / c[i];
+               const double tan2 = t * t;
+               const double tan4 = tan2 * tan2;
+               const double tan6 = tan4 * tan2;
+               const double eta = params.TranMerc_ebs * c[i] * c[i];
+               const double eta2 = eta * eta;
+               const double eta3 = eta2 * eta;
+               const double eta4 = eta3 * eta;
+
+               double de = easting[start + i] - params.TranMerc_False_Easting;
+               de = std::abs(de) < 0.0001 ? 0.0 : de;
+               const double de2 = de * de;
+               const double de4 = de2 * de2;
+               const double de6 = de4 * de2;
+               const double de8 = de4 * de4;
+
+               const double t10 = t / (2.e0 * sr * sn * k2);
+               const double t11 = t * (5.e0  + 3.e0 * tan2 + eta - 4.e0 * eta2
+                        - 9.e0 * tan2 * eta) / (24.e0 * sr * sn3 * k4);
+               const double t12 = t * (61.e0 + 90.e0 * tan2 + 46.e0 * eta + 45.E0 * tan4
+                        - 252.e0 * tan2 * eta  - 3.e0 * eta2 + 100.e0
+                        * eta3 - 66.e0 * tan2 * eta2 - 90.e0 * tan4
+                        * eta + 88.e0 * eta4 + 225.e0 * tan4 * eta2
+                        + 84.e0 * tan2* eta3 - 192.e0 * tan2 * eta4)
+                        / (720.e0 * sr * sn5 * k6);
+               const double t13 = t * (1385.e0 + 3633.e0 * tan2 + 4095.e0 * tan4 + 1575.e0 * tan6)
+                        / (40320.e0 * sr * sn7 * k8);
+               latitude[start + i] = ftphi[i] - de2 * t10 + de4 * t11 - de6 * t12 + de8 * t13;
+
+               const double t14 = 1.e0 / (sn * c[i] * k);
+               const double t15 = (1.e0 + 2.e0 * tan2 + eta) / (6.e0 * sn3 * c[i] * k3);
+               const double t16 = (5.e0 + 6.e0 * eta + 28.e0 * tan2 - 3.e0 * eta2
+                        + 8.e0 * tan2 * eta + 24.e0 * tan4 - 4.e0
+                        * eta3 + 4.e0 * tan2 * eta2 + 24.e0
+                        * tan2 * eta3) / (120.e0 * sn5 * c[i] * k5);
+               const double t17 = (61.e0 +  662.e0 * tan2 + 1320.e0 * tan4 + 720.e0 * tan6)
+                        / (5040.e0 * sn7 * c[i] * k7);
+
+               const double dlam = de * t14 - de2 * de * t15 + de4 * de * t16 - de6 * de * t17;
+               double lon = params.TranMerc_Origin_Long + dlam;
+               longitude[start + i] = lon > osg::PI ? lon - (2 * osg::PI) : lon;
+            }
+         }
+      }
+
+      /// Coordinates::GeodeticToGeocentric for a block of points.
+      void GeodeticToGeocentricBlock(const double* latitude, const double* longitude, const double* elevation,
+               double* x, double* y, double* z, unsigned count)
+      {
+         const double esqu = 2.0 * Geocent_f - Geocent_f*Geocent_f;
+         double sinLat[BATCH_BLOCK_SIZE], cosLat[BATCH_BLOCK_SIZE], sinLon[BATCH_BLOCK_SIZE], cosLon[BATCH_BLOCK_SIZE];
+
+         for (unsigned start = 0; start < count; start += BATCH_BLOCK_SIZE)
+         {
+            const unsigned n = std::min(count - start, BATCH_BLOCK_SIZE);
+            for (unsigned i = 0; i < n; ++i)
+            {
+               sinLat[i] = sin(latitude[start + i]);
+               cosLat[i] = cos(latitude[start + i]);
+               sinLon[i] = sin(longitude[start + i]);
+               cosLon[i] = cos(longitude[start + i]);
+            }
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+               const double rn = Geocent_a / sqrt(1.0 - esqu * sinLat[i] * sinLat[i]);
+               const double h = elevation[start + i];
+               x[start + i] = (rn + h) * cosLat[i] * cosLon[i];
+               y[start + i] = (rn + h) * cosLat[i] * sinLon[i];
+               z[start + i] = (rn * (1.0 - esqu) + h) * sinLat[i];
+            }
+         }
+      }
+
+      template <typename VecType>
+      inline void ClearNonFinite(VecType& v)
+      {
+         for (unsigned i = 0; i < 3; ++i)
+         {
+            if (!IsFinite(v[i]))
+            {
+               v[i] = 0.0;
+            }
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void Coordinates::ConvertToLocalTranslations(const osg::Vec3d* locs, osg::Vec3* translationsOut, unsigned count)
+   {
+      const bool toUTM = *mLocalCoordinateType == LocalCoordinateType::CARTESIAN_UTM;
+      const bool toFlatEarth = *mLocalCoordinateType == LocalCoordinateType::CARTESIAN_FLAT_EARTH;
+      const bool fromGeocentric = *mIncomingCoordinateType == IncomingCoordinateType::GEOCENTRIC;
+      const bool fromGeodetic = *mIncomingCoordinateType == IncomingCoordinateType::GEODETIC;
+      const bool fromUTM = *mIncomingCoordinateType == IncomingCoordinateType::UTM;
+
+      if (!(toUTM && (fromGeocentric || fromGeodetic)) && !(toFlatEarth && (fromGeocentric || fromUTM)))
+      {
+         // The other combinations are only a few operations per point.
+         for (unsigned i = 0; i < count; ++i)
+         {
+            translationsOut[i] = ConvertToLocalTranslation(locs[i]);
+         }
+         return;
+      }
+
+      UTMParameters params;
+      CalcUTMZoneParameters(params, mUTMZone, mUTMHemisphere);
+      const double tmdo = params.SPHTMD(params.TranMerc_Origin_Lat);
+
+      osg::Vec3d localOffset;
+      GetLocalOffset(localOffset);
+
+      double x[BATCH_BLOCK_SIZE], y[BATCH_BLOCK_SIZE], z[BATCH_BLOCK_SIZE];
+      double sinLat[BATCH_BLOCK_SIZE], cosLat[BATCH_BLOCK_SIZE];
+      double lat[BATCH_BLOCK_SIZE], lon[BATCH_BLOCK_SIZE], elevation[BATCH_BLOCK_SIZE];
+
+      for (unsigned start = 0; start < count; start += BATCH_BLOCK_SIZE)
+      {
+         const unsigned n = std::min(count - start, BATCH_BLOCK_SIZE);
+         const osg::Vec3d* blockLocs = locs + start;
+         osg::Vec3* blockOut = translationsOut + start;
+
+         if (fromGeocentric)
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               x[i] = blockLocs[i].x();
+               y[i] = blockLocs[i].y();
+               z[i] = blockLocs[i].z();
+            }
+
+            GeocentricToGeodeticBlock(x, y, z, sinLat, cosLat, elevation, n);
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+               // atan, not atan2, like ConvertGeocentricToGeodetic, so the sine and cosine are flipped to match.
+               lat[i] = atan(sinLat[i] / cosLat[i]);
+               lon[i] = atan2(y[i], x[i]);
+               if (cosLat[i] < 0.0)
+               {
+                  sinLat[i] = -sinLat[i];
+                  cosLat[i] = -cosLat[i];
+               }
+            }
+         }
+         else if (fromGeodetic)
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               lat[i] = osg::DegreesToRadians(blockLocs[i].x());
+               lon[i] = osg::DegreesToRadians(blockLocs[i].y());
+               elevation[i] = blockLocs[i].z();
+               sinLat[i] = sin(lat[i]);
+               cosLat[i] = cos(lat[i]);
+            }
+         }
+         else
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               x[i] = blockLocs[i].x();
+               y[i] = blockLocs[i].y();
+               elevation[i] = blockLocs[i].z();
+            }
+
+            TransverseMercatorToGeodeticBlock(params, tmdo, x, y, lat, lon, n);
+         }
+
+         if (toUTM)
+         {
+            // x and y are done with, so they hold the easting and northing.
+            GeodeticToTransverseMercatorBlock(params, tmdo, lat, lon, sinLat, cosLat, x, y, n);
+
+            for (unsigned i = 0; i < n; ++i)
+            {
+               blockOut[i].set(x[i] - localOffset.x(), y[i] - localOffset.y(), elevation[i] - localOffset.z());
+            }
+         }
+         else
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               osg::Vec3d xyz;
+               ConvertLatLonToFlatEarth(xyz, osg::Vec3d(osg::RadiansToDegrees(lat[i]), osg::RadiansToDegrees(lon[i]), elevation[i]),
+                        mFlatEarthOrigin, mConvergence);
+               blockOut[i].set(xyz.x() - localOffset.x(), xyz.y() - localOffset.y(), xyz.z() - localOffset.z());
+            }
+         }
+
+         for (unsigned i = 0; i < n; ++i)
+         {
+            // The block kernels don't handle the poles and the center of the earth.
+            if (fromGeocentric && blockLocs[i].x() == 0.0 && blockLocs[i].y() == 0.0)
+            {
+               blockOut[i] = ConvertToLocalTranslation(blockLocs[i]);
+            }
+            ClearNonFinite(blockOut[i]);
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void Coordinates::ConvertToRemoteTranslations(const osg::Vec3* translations, osg::Vec3d* locsOut, unsigned count)
+   {
+      const bool fromUTM = *mLocalCoordinateType == LocalCoordinateType::CARTESIAN_UTM;
+      const bool fromFlatEarth = *mLocalCoordinateType == LocalCoordinateType::CARTESIAN_FLAT_EARTH;
+      const bool toGeocentric = *mIncomingCoordinateType == IncomingCoordinateType::GEOCENTRIC;
+      const bool toGeodetic = *mIncomingCoordinateType == IncomingCoordinateType::GEODETIC;
+
+      if (!(fromUTM && (toGeocentric || toGeodetic)) && !(fromFlatEarth && toGeocentric))
+      {
+         for (unsigned i = 0; i < count; ++i)
+         {
+            locsOut[i] = ConvertToRemoteTranslation(translations[i]);
+         }
+         return;
+      }
+
+      UTMParameters params;
+      CalcUTMZoneParameters(params, mUTMZone, mUTMHemisphere);
+      const double tmdo = params.SPHTMD(params.TranMerc_Origin_Lat);
+
+      osg::Vec3d localOffset;
+      GetLocalOffset(localOffset);
+
+      double x[BATCH_BLOCK_SIZE], y[BATCH_BLOCK_SIZE], z[BATCH_BLOCK_SIZE];
+      double lat[BATCH_BLOCK_SIZE], lon[BATCH_BLOCK_SIZE], elevation[BATCH_BLOCK_SIZE];
+
+      for (unsigned start = 0; start < count; start += BATCH_BLOCK_SIZE)
+      {
+         const unsigned n = std::min(count - start, BATCH_BLOCK_SIZE);
+         const osg::Vec3* blockTranslations = translations + start;
+         osg::Vec3d* blockOut = locsOut + start;
+
+         if (fromUTM)
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               x[i] = blockTranslations[i].x() + localOffset.x();
+               y[i] = blockTranslations[i].y() + localOffset.y();
+               elevation[i] = blockTranslations[i].z() + localOffset.z();
+            }
+
+            TransverseMercatorToGeodeticBlock(params, tmdo, x, y, lat, lon, n);
+         }
+         else
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               osg::Vec3d lle;
+               ConvertFlatEarthToLatLon(lle, osg::Vec3d(blockTranslations[i]) + localOffset, mFlatEarthOrigin, mConvergence);
+               lat[i] = osg::DegreesToRadians(lle[0]);
+               lon[i] = osg::DegreesToRadians(lle[1]);
+               elevation[i] = lle[2];
+            }
+         }
+
+         if (toGeocentric)
+         {
+            GeodeticToGeocentricBlock(lat, lon, elevation, x, y, z, n);
+            for (unsigned i = 0; i < n; ++i)
+            {
+               blockOut[i].set(x[i], y[i], z[i]);
+            }
+         }
+         else
+         {
+            for (unsigned i = 0; i < n; ++i)
+            {
+               blockOut[i].set(osg::RadiansToDegrees(lat[i]), osg::RadiansToDegrees(lon[i]), elevation[i]);
+            }
+         }
+
+         for (unsigned i = 0; i < n; ++i)
+         {
+            ClearNonFinite(blockOut[i]);
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   void Coordinates::ConvertToRemoteRotations(const osg::Vec3* hprs, osg::Vec3d* rotationsOut, unsigned count)
+   {
+      if (*mLocalCoordinateType != LocalCoordinateType::CARTESIAN_UTM &&
+               *mLocalCoordinateType != LocalCoordinateType::CARTESIAN_FLAT_EARTH)
+      {
+         for (unsigned i = 0; i < count; ++i)
+         {
+            rotationsOut[i] = ConvertToRemoteRotation(hprs[i]);
+         }
+         return;
+      }
+
+      if (mRotationDirty)
+      {
+         ReconfigureRotationMatrix();
+      }
+
+      const bool flop = *mIncomingCoordinateType == IncomingCoordinateType::GEOCENTRIC;
+      const osg::Matrix& originRotation = GetOriginRotationMatrix();
+
+      for (unsigned i = 0; i < count; ++i)
+      {
+         osg::Matrix rotMat;
+         MatrixUtil::HprToMatrix(rotMat, hprs[i]);
+         if (flop)
+         {
+            ZFlop(rotMat);
+         }
+
+         // Both are rotations, so inverse(rotMat * originInverse) is originRotation * transpose(rotMat).
+         osg::Matrix transposed(rotMat(0,0), rotMat(1,0), rotMat(2,0), 0.0,
+                                rotMat(0,1), rotMat(1,1), rotMat(2,1), 0.0,
+                                rotMat(0,2), rotMat(1,2), rotMat(2,2), 0.0,
+                                0.0, 0.0, 0.0, 1.0);
+         rotMat.mult(originRotation, transposed);
+
+         float psi, theta, phi;
+         MatrixToEulers(rotMat, psi, theta, phi);
+         rotationsOut[i].set(psi, theta, phi);
+         ClearNonFinite(rotationsOut[i]);
+      }
+   }
+
    /////////////////////////////////////////////////////////////////////////////
    void Coordinates::ZFlop(osg::Matrix& toFlop)
    {
@@ -1048,11 +1652,6 @@ namespace dtUtil
    void Coordinates::ConvertGeodeticToUTM (double Latitude, double Longitude,
                                            unsigned Zone, char Hemisphere, double& Easting, double& Northing)
    {
-      double Origin_Latitude = 0.0;
-      double Central_Meridian = 0.0;
-      double False_Easting = 500000;
-      double False_Northing = 0;
-
       // no errors
       if (Longitude < 0)
       {
@@ -1062,24 +1661,8 @@ namespace dtUtil
       //char nsZone;
       //CalculateUTMZone(osg::RadiansToDegrees(Latitude), osg::RadiansToDegrees(Longitude), Zone, nsZone);
 
-      if (Zone >= 31)
-      {
-         Central_Meridian = osg::DegreesToRadians(double(6 * Zone - 183));
-      }
-      else
-      {
-         Central_Meridian = osg::DegreesToRadians(double(6 * Zone + 177));
-      }
-
-      // If we are projecting in the southern hemisphere, set the false northing.
-      if (Hemisphere == 'S' || Hemisphere == 's')
-      {
-         False_Northing = 10000000;
-      }
-
       UTMParameters params;
-      params.CalcTransverseMercatorParameters(Geocent_a, Geocent_f, Origin_Latitude,
-                                      Central_Meridian, False_Easting, False_Northing, CentralMeridianScale);
+      CalcUTMZoneParameters(params, Zone, Hemisphere);
       ConvertGeodeticToTransverseMercator(params, Latitude, Longitude, Easting, Northing);
    } // END OF Convert_Geodetic_To_UTM
 
@@ -1101,28 +1684,8 @@ namespace dtUtil
        *    Longitude         : Longitude in radians                   (output)
        */
 
-      double Origin_Latitude = 0;
-      double Central_Meridian = 0;
-      double False_Easting = 500000;
-      double False_Northing = 0;
-
-      if (zone >= 31)
-      {
-         Central_Meridian = ((6 * zone - 183) * osg::PI / 180.0 /*+ 0.00000005*/);
-      }
-      else
-      {
-         Central_Meridian = ((6 * zone + 177) * osg::PI / 180.0 /*+ 0.00000005*/);
-      }
-
-      if (hemisphere == 'S' || hemisphere == 's')
-      {
-         False_Northing = 10000000;
-      }
-
       UTMParameters params;
-      params.CalcTransverseMercatorParameters(Geocent_a, Geocent_f, Origin_Latitude,
-                                      Central_Meridian, False_Easting, False_Northing, CentralMeridianScale);
+      CalcUTMZoneParameters(params, zone, hemisphere);
 
       ConvertTransverseMercatorToGeodetic(params, easting,northing,latitude,longitude);
    }
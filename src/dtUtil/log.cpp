@@ -32,8 +32,10 @@
 
 
 
+#include <OpenThreads/Atomic>
 #include <OpenThreads/Mutex>
 #include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
 
 #include <algorithm>
 #include <cstdarg>
@@ -57,6 +59,88 @@ namespace dtUtil
    static Log::LogMessageType DEFAULT_LOG_LEVEL(Log::LOG_WARNING);
 
 
+   //////////////////////////////////////////////////////////////////////////
+   //////////////////////////////////////////////////////////////////////////
+   class LogImpl //: std::stringbuf
+   {
+   public:
+      LogImpl(const std::string& name)
+      : mOutputStreamBit(Log::STANDARD)
+      , mName(name)
+      , mLevel(DEFAULT_LOG_LEVEL)
+      , mObservers()
+      {
+      }
+
+      /// Sends the message to the outputs.  The caller must hold the log manager mutex.
+      void Dispatch(unsigned int outputStreamBit, LogObserver::LogData& logData) const;
+
+      unsigned int mOutputStreamBit; ///<the current output stream option
+      std::string mName;
+      Log::LogMessageType mLevel;
+      Log::LogObserverContainer mObservers;
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+   /**
+    * The queue and writer thread for asynchronous logging.  The queue is a bounded ring buffer with many
+    * producers and one consumer.  A producer claims a slot by incrementing the write index, fills it in, then bumps
+    * the slot sequence number to hand it to the writer, so logging threads only touch atomics.
+    */
+   class AsyncLogWriter : public osg::Referenced, public OpenThreads::Thread
+   {
+   public:
+      struct PendingMessage
+      {
+         const LogImpl* mLog;
+         unsigned int mOutputStreamBit;
+         LogObserver::LogData mData;
+      };
+
+      AsyncLogWriter(unsigned queueSize, Log::AsyncOverflowPolicy policy, Log& reportLog);
+
+      /// Queues a message.  Called from any thread.  @return false if the message was dropped.
+      bool Push(const LogImpl& log, unsigned int outputStreamBit, LogObserver::LogData& logData);
+
+      /// Waits until all of the messages queued before the call are written.
+      void Flush();
+
+      /// Writes out the rest of the queue and stops the thread.
+      void Stop();
+
+      virtual void run();
+
+      unsigned GetDroppedCount() const { return mDropped; }
+
+      volatile Log::AsyncOverflowPolicy mPolicy;
+
+   protected:
+      virtual ~AsyncLogWriter();
+
+   private:
+      struct Slot
+      {
+         OpenThreads::Atomic mSequence;
+         PendingMessage mMessage;
+      };
+
+      bool DispatchNext();
+      void DispatchBacklog();
+      void ReportDropped();
+
+      unsigned mCapacity;
+      unsigned mMask;
+      Slot* mSlots;
+      OpenThreads::Atomic mWriteIndex;
+      OpenThreads::Atomic mReadIndex;
+      OpenThreads::Atomic mDropped;
+      unsigned mDroppedReported;
+      /// Messages logged by the observers on the writer thread.  They can't wait on the queue, which only this thread drains.
+      std::vector<PendingMessage> mBacklog;
+      Log& mReportLog;
+      volatile bool mDone;
+   };
+
    //////////////////////////////////////////////////////////////////////////
    class LogManager: public osg::Referenced
    {
@@ -71,12 +155,26 @@ namespace dtUtil
       : mLogObserverConsole(new LogObserverConsole())
       , mLogObserverFile(new LogObserverFile())
       , mLogTimeProvider(NULL)
+      , mDroppedByStoppedWriters(0U)
       {
       }
 
+      ////////////////////////////////////////////////////////////////
+      void StopAsyncWriter()
+      {
+         if (mAsyncWriter.valid())
+         {
+            mAsyncWriter->Stop();
+            mDroppedByStoppedWriters += mAsyncWriter->GetDroppedCount();
+            mAsyncWriter = NULL;
+         }
+      }
+
       ////////////////////////////////////////////////////////////////
       ~LogManager()
       {
+         // The queued messages point to the log instances, so they must be written first.
+         StopAsyncWriter();
          mInstances.clear();
          mLogObserverConsole = NULL;
          mLogObserverFile = NULL;
@@ -126,6 +224,9 @@ namespace dtUtil
       }
 
       OpenThreads::Mutex mMutex;
+      /// Only set in asynchronous mode.
+      osg::ref_ptr<AsyncLogWriter> mAsyncWriter;
+      unsigned mDroppedByStoppedWriters;
    private:
       dtUtil::HashMap<std::string, osg::ref_ptr<Log> > mInstances;
    };
@@ -151,6 +252,7 @@ namespace dtUtil
       else if (!sameName)
       {
          // reset open failed if the file name changes.
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
          LOG_MANAGER->mLogObserverFile->mOpenFailed = false;
          LOG_MANAGER->mLogObserverFile->OpenFile();
       }
@@ -172,23 +274,235 @@ namespace dtUtil
    }
 
    //////////////////////////////////////////////////////////////////////////
+   static void SetLogDataTime(LogObserver::LogData& logData)
+   {
+      if (LOG_MANAGER->IsLogTimeProviderValid())
+      {
+         logData.frameNumber = LOG_MANAGER->mLogTimeProvider->GetFrameNumber();
+         logData.time = LOG_MANAGER->mLogTimeProvider->GetDateTime();
+      }
+      else
+      {
+         logData.time.SetToLocalTime();
+      }
+   }
+
    //////////////////////////////////////////////////////////////////////////
-   class LogImpl //: std::stringbuf
+   void LogImpl::Dispatch(unsigned int outputStreamBit, LogObserver::LogData& logData) const
    {
-   public:
-      LogImpl(const std::string& name)
-      : mOutputStreamBit(Log::STANDARD)
-      , mName(name)
-      , mLevel(DEFAULT_LOG_LEVEL)
-      , mObservers()
+      logData.file = osgDB::getSimpleFileName(logData.file);
+
+      if (dtUtil::Bits::Has(outputStreamBit, Log::TO_FILE))
       {
+         LOG_MANAGER->mLogObserverFile->LogMessage(logData);
       }
 
-      unsigned int mOutputStreamBit; ///<the current output stream option
-      std::string mName;
-      Log::LogMessageType mLevel;
-      Log::LogObserverContainer mObservers;
-   };
+      if (dtUtil::Bits::Has(outputStreamBit, Log::TO_CONSOLE))
+      {
+         LOG_MANAGER->mLogObserverConsole->LogMessage(logData);
+      }
+
+      if (dtUtil::Bits::Has(outputStreamBit, Log::TO_OBSERVER) && !mObservers.empty())
+      {
+         Log::LogObserverContainer::const_iterator itr = mObservers.begin();
+         while (itr != mObservers.end())
+         {
+            (*itr)->LogMessage(logData);
+            ++itr;
+         }
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   //////////////////////////////////////////////////////////////////////////
+   AsyncLogWriter::AsyncLogWriter(unsigned queueSize, Log::AsyncOverflowPolicy policy, Log& reportLog)
+   : osg::Referenced(true)
+   , mPolicy(policy)
+   , mCapacity(16U)
+   , mMask(0U)
+   , mSlots(NULL)
+   , mWriteIndex(0U)
+   , mReadIndex(0U)
+   , mDropped(0U)
+   , mDroppedReported(0U)
+   , mReportLog(reportLog)
+   , mDone(false)
+   {
+      // A power of 2 keeps the slot index right when the indices wrap around.
+      while (mCapacity < queueSize && mCapacity < 0x80000000U)
+      {
+         mCapacity <<= 1;
+      }
+      mMask = mCapacity - 1U;
+
+      mSlots = new Slot[mCapacity];
+      for (unsigned i = 0; i < mCapacity; ++i)
+      {
+         mSlots[i].mSequence.exchange(i);
+         mSlots[i].mMessage.mLog = NULL;
+         mSlots[i].mMessage.mOutputStreamBit = Log::NO_OUTPUT;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   AsyncLogWriter::~AsyncLogWriter()
+   {
+      Stop();
+      delete[] mSlots;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   bool AsyncLogWriter::Push(const LogImpl& log, unsigned int outputStreamBit, LogObserver::LogData& logData)
+   {
+      if (OpenThreads::Thread::CurrentThread() == this)
+      {
+         mBacklog.push_back(PendingMessage());
+         mBacklog.back().mLog = &log;
+         mBacklog.back().mOutputStreamBit = outputStreamBit;
+         std::swap(mBacklog.back().mData, logData);
+         return true;
+      }
+
+      // Check for room before claiming a slot, because a claimed slot has to be filled.  Producers that pass the check
+      // at the same moment can overrun it by a few messages, and they wait below for the writer to free their slot.
+      while (unsigned(mWriteIndex) - unsigned(mReadIndex) >= mCapacity)
+      {
+         if (mPolicy != Log::OVERFLOW_BLOCK)
+         {
+            ++mDropped;
+            return false;
+         }
+         OpenThreads::Thread::YieldCurrentThread();
+      }
+
+      unsigned pos = ++mWriteIndex - 1U;
+      Slot& slot = mSlots[pos & mMask];
+      while (unsigned(slot.mSequence) != pos)
+      {
+         OpenThreads::Thread::YieldCurrentThread();
+      }
+
+      slot.mMessage.mLog = &log;
+      slot.mMessage.mOutputStreamBit = outputStreamBit;
+      std::swap(slot.mMessage.mData, logData);
+      // Hands the slot to the writer.
+      slot.mSequence.exchange(pos + 1U);
+      return true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   bool AsyncLogWriter::DispatchNext()
+   {
+      unsigned pos = mReadIndex;
+      Slot& slot = mSlots[pos & mMask];
+      if (unsigned(slot.mSequence) != pos + 1U)
+      {
+         return false;
+      }
+
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
+         slot.mMessage.mLog->Dispatch(slot.mMessage.mOutputStreamBit, slot.mMessage.mData);
+      }
+
+      // Frees the slot for the producer one lap ahead.
+      slot.mSequence.exchange(pos + mCapacity);
+      mReadIndex.exchange(pos + 1U);
+
+      DispatchBacklog();
+      return true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   void AsyncLogWriter::DispatchBacklog()
+   {
+      std::vector<PendingMessage> pending;
+      while (!mBacklog.empty())
+      {
+         pending.swap(mBacklog);
+         for (unsigned i = 0; i < pending.size(); ++i)
+         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
+            pending[i].mLog->Dispatch(pending[i].mOutputStreamBit, pending[i].mData);
+         }
+         pending.clear();
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   void AsyncLogWriter::ReportDropped()
+   {
+      unsigned dropped = mDropped;
+      if (dropped != mDroppedReported)
+      {
+         if (mPolicy == Log::OVERFLOW_COUNT)
+         {
+            mReportLog.LogMessage(__FILE__, __FUNCTION__, __LINE__,
+               dtUtil::ToString(dropped - mDroppedReported) + " log messages were dropped because the asynchronous log queue was full.",
+               Log::LOG_WARNING);
+            DispatchBacklog();
+         }
+         mDroppedReported = dropped;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   void AsyncLogWriter::run()
+   {
+      unsigned idleCount = 0;
+      while (!mDone)
+      {
+         if (DispatchNext())
+         {
+            idleCount = 0;
+            continue;
+         }
+
+         ReportDropped();
+
+         // Spin briefly so a burst of messages is picked up quickly, then sleep so an idle writer costs nothing.
+         if (++idleCount < 64)
+         {
+            OpenThreads::Thread::YieldCurrentThread();
+         }
+         else
+         {
+            OpenThreads::Thread::microSleep(1000);
+         }
+      }
+
+      while (DispatchNext())
+      {
+      }
+      ReportDropped();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   void AsyncLogWriter::Flush()
+   {
+      if (OpenThreads::Thread::CurrentThread() == this || !isRunning())
+      {
+         return;
+      }
+
+      unsigned target = mWriteIndex;
+      // Compared as a signed difference so the indices can wrap.
+      while (int(unsigned(mReadIndex) - target) < 0 && isRunning())
+      {
+         OpenThreads::Thread::YieldCurrentThread();
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   void AsyncLogWriter::Stop()
+   {
+      if (isRunning())
+      {
+         mDone = true;
+         join();
+      }
+   }
+
 //   /** Stream buffer calling notify handler when buffer is synchronized (usually on std::endl).
 //    * Stream stores last notification severity to pass it to handler call.
 //    */
@@ -260,46 +574,26 @@ namespace dtUtil
       }
 
 
-      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
-      bool hasLogTimeProvider = LOG_MANAGER->IsLogTimeProviderValid();
+      AsyncLogWriter* asyncWriter = LOG_MANAGER->mAsyncWriter.get();
 
       LogObserver::LogData logData;
-      if (hasLogTimeProvider)
-      {
-    	  logData.frameNumber = LOG_MANAGER->mLogTimeProvider->GetFrameNumber();
-    	  logData.time = LOG_MANAGER->mLogTimeProvider->GetDateTime();
-      }
-      else
-      {
-    	  logData.time.SetToLocalTime();
-      }
-
       logData.type = msgType;
       logData.logName = mImpl->mName;
-      logData.file = osgDB::getSimpleFileName(file);
+      logData.file = file;
       logData.method = method;
       logData.line = line;
       logData.msg = msg;
 
-
-      if (dtUtil::Bits::Has(mImpl->mOutputStreamBit, Log::TO_FILE))
+      if (asyncWriter != NULL)
       {
-         LOG_MANAGER->mLogObserverFile->LogMessage(logData);
+         SetLogDataTime(logData);
+         asyncWriter->Push(*mImpl, mImpl->mOutputStreamBit, logData);
       }
-
-      if (dtUtil::Bits::Has(mImpl->mOutputStreamBit, Log::TO_CONSOLE))
+      else
       {
-         LOG_MANAGER->mLogObserverConsole->LogMessage(logData);
-      }
-
-      if (dtUtil::Bits::Has(mImpl->mOutputStreamBit, Log::TO_OBSERVER) && !mImpl->mObservers.empty())
-      {
-         Log::LogObserverContainer::iterator itr = mImpl->mObservers.begin();
-         while (itr != mImpl->mObservers.end())
-         {
-            (*itr)->LogMessage(logData);
-            ++itr;
-         }
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
+         SetLogDataTime(logData);
+         mImpl->Dispatch(mImpl->mOutputStreamBit, logData);
       }
    }
 
@@ -355,6 +649,9 @@ namespace dtUtil
 
       if (dtUtil::Bits::Has(mImpl->mOutputStreamBit, Log::TO_FILE))
       {
+         // Keeps the rule after the messages logged before it.
+         Flush();
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
          LOG_MANAGER->mLogObserverFile->LogHorizRule();
       }
    }
@@ -508,9 +805,81 @@ namespace dtUtil
 	  }
    }
 
+   ////////////////////////////////////////////////////////////////////////////////
+   void Log::EnableAsyncLogging(unsigned queueSize, AsyncOverflowPolicy policy)
+   {
+      // Make sure the log used to report dropped messages exists, since creating logs isn't thread safe.
+      Log& reportLog = GetInstance();
+
+      LOG_MANAGER->StopAsyncWriter();
+      LOG_MANAGER->mAsyncWriter = new AsyncLogWriter(queueSize, policy, reportLog);
+      LOG_MANAGER->mAsyncWriter->start();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void Log::DisableAsyncLogging()
+   {
+      if (LOG_MANAGER.valid())
+      {
+         LOG_MANAGER->StopAsyncWriter();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   bool Log::IsAsyncLoggingEnabled()
+   {
+      return LOG_MANAGER.valid() && LOG_MANAGER->mAsyncWriter.valid();
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void Log::SetAsyncOverflowPolicy(AsyncOverflowPolicy policy)
+   {
+      if (IsAsyncLoggingEnabled())
+      {
+         LOG_MANAGER->mAsyncWriter->mPolicy = policy;
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   Log::AsyncOverflowPolicy Log::GetAsyncOverflowPolicy()
+   {
+      if (IsAsyncLoggingEnabled())
+      {
+         return LOG_MANAGER->mAsyncWriter->mPolicy;
+      }
+      return OVERFLOW_BLOCK;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   void Log::Flush()
+   {
+      if (IsAsyncLoggingEnabled())
+      {
+         LOG_MANAGER->mAsyncWriter->Flush();
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   unsigned Log::GetDroppedMessageCount()
+   {
+      if (!LOG_MANAGER.valid())
+      {
+         return 0U;
+      }
+
+      unsigned result = LOG_MANAGER->mDroppedByStoppedWriters;
+      if (LOG_MANAGER->mAsyncWriter.valid())
+      {
+         result += LOG_MANAGER->mAsyncWriter->GetDroppedCount();
+      }
+      return result;
+   }
+
    ////////////////////////////////////////////////////////////////////////////////
    void Log::AddObserver(LogObserver& observer)
    {
+      // The writer thread reads the observers in asynchronous mode.
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
       mImpl->mObservers.push_back(&observer);
    }
 
@@ -529,6 +898,7 @@ namespace dtUtil
    ////////////////////////////////////////////////////////////////////////////////
    void Log::RemoveObserver(LogObserver& observer)
    {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(LOG_MANAGER->mMutex);
       LogObserverContainer::iterator found = std::find(mImpl->mObservers.begin(),
                                                        mImpl->mObservers.end(), &observer);
       if (found != mImpl->mObservers.end())
@@ -33,6 +33,8 @@
 #include <OpenThreads/Atomic>
 #include <OpenThreads/Block>
 #include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+#include <deque>
 #include <queue>
 #include <set>
 #include <map>
@@ -44,6 +46,9 @@ namespace dtUtil
 
    class TaskThread;
 
+   /// Releases the tasks waiting on the task, and queues the dependents that are ready.  Defined with ThreadPoolImpl.
+   static void FinishTask(ThreadPoolTask& task);
+
 template<class _Ty,
    class _Container = std::vector<_Ty>,
    class _Pr = std::less<typename _Container::value_type> >
@@ -75,6 +80,13 @@ template<class _Ty,
       /** Return true if the operation queue is empty. */
       bool Empty() const { return mTasks.empty(); }
 
+      /** Same as Empty, but safe to call while other threads use the queue. */
+      bool EmptyLocked()
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mTasksMutex);
+         return Empty();
+      }
+
       /** Return the num of pending tasks that are sitting in the TaskQueue.*/
       unsigned int GetNumTasksInQueue() const { return unsigned(mTasks.size()); }
 
@@ -298,7 +310,7 @@ template<class _Ty,
          }
          else
          {
-            currentTask->ReleaseWaitBlock();
+            FinishTask(*currentTask);
          }
 
          --mInProcessTasks[queueId];
@@ -440,6 +452,10 @@ template<class _Ty,
    : osg::Referenced(true)
    , mName("Task")
    , mKeep(false)
+   , mNumDependencies(0U)
+   , mRemainingDependencies(0U)
+   , mWaitingForDependencies(false)
+   , mWaitingQueue(ThreadPool::IMMEDIATE)
    {
       //default it to released.
       mBlockUntilComplete.release();
@@ -479,6 +495,157 @@ template<class _Ty,
       return result;
    }
 
+   //////////////////////////////////////
+   void ThreadPoolTask::AddDependency(ThreadPoolTask& prerequisite)
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(prerequisite.mDependencyMutex);
+         prerequisite.mDependents.push_back(this);
+      }
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mDependencyMutex);
+      ++mNumDependencies;
+      ++mRemainingDependencies;
+   }
+
+   //////////////////////////////////////
+   unsigned ThreadPoolTask::GetNumDependencies() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mDependencyMutex);
+      return mNumDependencies;
+   }
+
+   //////////////////////////////////////////////////
+   //////////////////////////////////////////////////
+   ThreadPool::QueueStatistics::QueueStatistics()
+   : mTasksExecuted(0U)
+   , mTasksStolen(0U)
+   , mFailedSteals(0U)
+   , mLockContentions(0U)
+   {
+   }
+
+   /**
+    * The IMMEDIATE tasks of one worker thread, or of the threads that aren't workers.  The owner takes tasks from
+    * the back, and other threads steal them from the front, so a thief gets the oldest, and usually the biggest, piece.
+    */
+   class WorkQueue : public osg::Referenced
+   {
+   public:
+      WorkQueue()
+      : osg::Referenced(true)
+      {
+      }
+
+      void PushBack(ThreadPoolTask& task)
+      {
+         Lock();
+         mTasks.push_back(&task);
+         mMutex.unlock();
+      }
+
+      void PushFront(ThreadPoolTask& task)
+      {
+         Lock();
+         mTasks.push_front(&task);
+         mMutex.unlock();
+      }
+
+      bool PopBack(dtCore::RefPtr<ThreadPoolTask>& taskOut)
+      {
+         bool result = false;
+         Lock();
+         if (!mTasks.empty())
+         {
+            taskOut = mTasks.back();
+            mTasks.pop_back();
+            result = true;
+         }
+         mMutex.unlock();
+         return result;
+      }
+
+      bool PopFront(dtCore::RefPtr<ThreadPoolTask>& taskOut)
+      {
+         bool result = false;
+         Lock();
+         if (!mTasks.empty())
+         {
+            taskOut = mTasks.front();
+            mTasks.pop_front();
+            result = true;
+         }
+         mMutex.unlock();
+         return result;
+      }
+
+      void RemoveAllTasks()
+      {
+         Lock();
+         mTasks.clear();
+         mMutex.unlock();
+      }
+
+      void GetStatistics(ThreadPool::QueueStatistics& stats) const
+      {
+         stats.mTasksExecuted = unsigned(mTasksExecuted);
+         stats.mTasksStolen = unsigned(mTasksStolen);
+         stats.mFailedSteals = unsigned(mFailedSteals);
+         stats.mLockContentions = unsigned(mLockContentions);
+      }
+
+      void ResetStatistics()
+      {
+         mTasksExecuted.exchange(0U);
+         mTasksStolen.exchange(0U);
+         mFailedSteals.exchange(0U);
+         mLockContentions.exchange(0U);
+      }
+
+      OpenThreads::Atomic mTasksExecuted;
+      OpenThreads::Atomic mTasksStolen;
+      OpenThreads::Atomic mFailedSteals;
+
+   protected:
+      virtual ~WorkQueue()
+      {
+      }
+
+   private:
+      /// Locks the mutex, counting it when another thread has it.
+      void Lock()
+      {
+         if (mMutex.trylock() != 0)
+         {
+            ++mLockContentions;
+            mMutex.lock();
+         }
+      }
+
+      OpenThreads::Mutex mMutex;
+      std::deque<dtCore::RefPtr<ThreadPoolTask> > mTasks;
+      OpenThreads::Atomic mLockContentions;
+   };
+
+   /// A thread that runs IMMEDIATE tasks, stealing them when its own queue is empty, and BACKGROUND tasks when there are none.
+   class WorkerThread : public osg::Referenced, public OpenThreads::Thread
+   {
+   public:
+      WorkerThread(unsigned queueIndex);
+
+      virtual void run();
+
+      virtual int cancel();
+
+      unsigned GetQueueIndex() const { return mQueueIndex; }
+
+   protected:
+      virtual ~WorkerThread();
+
+      unsigned mQueueIndex;
+      volatile bool mDone;
+   };
+
    //////////////////////////////////////////////////
    //////////////////////////////////////////////////
 
@@ -491,17 +658,312 @@ template<class _Ty,
       {
       }
 
-      dtCore::RefPtr<TaskQueue> mTaskQueue;
+      /// @return the index of the work queue of the current thread.
+      unsigned GetCurrentQueueIndex() const
+      {
+         WorkerThread* worker = dynamic_cast<WorkerThread*>(OpenThreads::Thread::CurrentThread());
+         if (worker != NULL)
+         {
+            return worker->GetQueueIndex();
+         }
+         return GetSharedQueueIndex();
+      }
+
+      /// @return the index of the queue shared by the threads that aren't workers.
+      unsigned GetSharedQueueIndex() const { return unsigned(mWorkQueues.size()) - 1U; }
+
+      void AddTask(ThreadPoolTask& task, ThreadPool::PoolQueue queue)
+      {
+         task.ResetWaitBlock();
+
+         if (queue == ThreadPool::IMMEDIATE)
+         {
+            // Counted right away so ExecuteTasks waits for the tasks still waiting on dependencies.
+            ++mImmediateInProcess;
+         }
+
+         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(task.mDependencyMutex);
+            if (task.mRemainingDependencies > 0U)
+            {
+               task.mWaitingForDependencies = true;
+               task.mWaitingQueue = queue;
+               return;
+            }
+         }
+
+         Schedule(task, queue);
+      }
+
+      /// Puts a task that's ready to run in its queue.
+      void Schedule(ThreadPoolTask& task, ThreadPool::PoolQueue queue)
+      {
+         if (queue == ThreadPool::IMMEDIATE)
+         {
+            unsigned index = GetCurrentQueueIndex();
+            if (index == GetSharedQueueIndex())
+            {
+               // Spread the tasks from other threads over all of the queues, so the workers don't all steal from one.
+               index = unsigned(++mNextQueue) % unsigned(mWorkQueues.size());
+            }
+            // Counted before it's pushed, so the count is never less than the number of queued tasks.
+            ++mImmediateQueued;
+            mWorkQueues[index]->PushBack(task);
+            Wake();
+         }
+         else if (queue == ThreadPool::BACKGROUND)
+         {
+            // in cases where worker threads > 0, the workers run the background queue when they have nothing else.
+            mBackgroundQueue->Add(task, 1);
+            Wake();
+         }
+         else if (queue == ThreadPool::IO)
+         {
+            mIOQueue->Add(task, 1);
+         }
+      }
+
+      void FinishTask(ThreadPoolTask& task)
+      {
+         std::vector<dtCore::RefPtr<ThreadPoolTask> > dependents;
+         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(task.mDependencyMutex);
+            dependents = task.mDependents;
+            // Ready to wait for the dependencies again the next time it's added.
+            task.mRemainingDependencies = task.mNumDependencies;
+         }
+
+         task.ReleaseWaitBlock();
+
+         for (unsigned i = 0; i < dependents.size(); ++i)
+         {
+            ThreadPoolTask& dependent = *dependents[i];
+            bool ready = false;
+            int queue = ThreadPool::IMMEDIATE;
+            {
+               OpenThreads::ScopedLock<OpenThreads::Mutex> lock(dependent.mDependencyMutex);
+               if (dependent.mRemainingDependencies > 0U)
+               {
+                  --dependent.mRemainingDependencies;
+               }
+
+               if (dependent.mRemainingDependencies == 0U && dependent.mWaitingForDependencies)
+               {
+                  dependent.mWaitingForDependencies = false;
+                  queue = dependent.mWaitingQueue;
+                  ready = true;
+               }
+            }
+
+            if (ready)
+            {
+               Schedule(dependent, ThreadPool::PoolQueue(queue));
+            }
+         }
+      }
+
+      /**
+       * Runs one IMMEDIATE task from the given queue, or stolen from another queue if it's empty.
+       * @return true if a task was run.
+       */
+      bool ExecuteSingleImmediateTask(unsigned queueIndex)
+      {
+         WorkQueue& ownQueue = *mWorkQueues[queueIndex];
+         dtCore::RefPtr<ThreadPoolTask> task;
+
+         if (!ownQueue.PopBack(task))
+         {
+            const unsigned numQueues = unsigned(mWorkQueues.size());
+            for (unsigned i = 1; i < numQueues && !task.valid(); ++i)
+            {
+               mWorkQueues[(queueIndex + i) % numQueues]->PopFront(task);
+            }
+
+            if (!task.valid())
+            {
+               ++ownQueue.mFailedSteals;
+               return false;
+            }
+
+            ++ownQueue.mTasksStolen;
+         }
+
+         --mImmediateQueued;
+
+         (*task)();
+         ++ownQueue.mTasksExecuted;
+
+         if (task->GetKeep())
+         {
+            // It goes to the end of the line, and stays counted, so code won't think all tasks are done.
+            ++mImmediateQueued;
+            ownQueue.PushFront(*task);
+         }
+         else
+         {
+            FinishTask(*task);
+            --mImmediateInProcess;
+         }
+
+         return true;
+      }
+
+      /// Runs IMMEDIATE tasks on this thread until all of them, including the ones added while running, are done.
+      void ExecuteTasks()
+      {
+         const unsigned queueIndex = GetCurrentQueueIndex();
+         while (ExecuteSingleImmediateTask(queueIndex) || unsigned(mImmediateInProcess) > 0U)
+         {
+            if (unsigned(mImmediateQueued) == 0U)
+            {
+               OpenThreads::Thread::YieldCurrentThread();
+            }
+         }
+      }
+
+      /// Blocks a worker until there may be work for it.
+      void WaitForWork()
+      {
+         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mWakeMutex);
+            if (unsigned(mImmediateQueued) == 0U && mBackgroundQueue->EmptyLocked())
+            {
+               mWakeBlock.reset();
+            }
+         }
+         mWakeBlock.block(100);
+      }
+
+      /// Releases the workers blocked in WaitForWork.
+      void Wake()
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mWakeMutex);
+         mWakeBlock.release();
+      }
+
       dtCore::RefPtr<TaskQueue> mBackgroundQueue;
       dtCore::RefPtr<TaskQueue> mIOQueue;
 
+      /// One queue per worker thread, then one more shared by the other threads.
+      std::vector<dtCore::RefPtr<WorkQueue> > mWorkQueues;
+      std::vector<dtCore::RefPtr<WorkerThread> > mWorkerThreads;
+      /// The background only thread, if there are no workers, and the io thread.
       std::vector<dtCore::RefPtr<TaskThread> > mTaskThreads;
+
+      /// IMMEDIATE tasks that have been added and not finished, including the ones waiting for dependencies.
+      OpenThreads::Atomic mImmediateInProcess;
+      /// IMMEDIATE tasks in the work queues.
+      OpenThreads::Atomic mImmediateQueued;
+      OpenThreads::Atomic mNextQueue;
+
+      OpenThreads::Mutex mWakeMutex;
+      OpenThreads::Block mWakeBlock;
+
       bool mTaskThreadForBackgroundOnly;
       bool mInitialized;
    };
 
    static ThreadPoolImpl gThreadPoolImpl;
 
+   //////////////////////////////////////////////////
+   static void FinishTask(ThreadPoolTask& task)
+   {
+      gThreadPoolImpl.FinishTask(task);
+   }
+
+   //////////////////////////////////////////////////
+   //////////////////////////////////////////////////
+   WorkerThread::WorkerThread(unsigned queueIndex)
+   : osg::Referenced(true)
+   , mQueueIndex(queueIndex)
+   , mDone(false)
+   {
+   }
+
+   WorkerThread::~WorkerThread()
+   {
+      cancel();
+   }
+
+   int WorkerThread::cancel()
+   {
+      if (isRunning())
+      {
+         mDone = true;
+
+         // then wait for the the thread to stop running.
+         while (isRunning())
+         {
+            gThreadPoolImpl.Wake();
+            OpenThreads::Thread::YieldCurrentThread();
+         }
+      }
+
+      return 0;
+   }
+
+   void WorkerThread::run()
+   {
+      while (!mDone)
+      {
+         if (!gThreadPoolImpl.ExecuteSingleImmediateTask(mQueueIndex)
+                  && !gThreadPoolImpl.mBackgroundQueue->ExecuteSingleTask(false)
+                  && !mDone)
+         {
+            gThreadPoolImpl.WaitForWork();
+         }
+
+         testCancel();
+      }
+
+      //Probably not required. If we got here, we're already canceled.
+      OpenThreads::Thread::cancel();
+      mDone = true;
+   }
+
+   //////////////////////////////////////////////////
+   /// A piece of a ParallelFor range.  It hands half of itself to the pool until it's no bigger than the grain size.
+   class ParallelForTask : public ThreadPoolTask
+   {
+   public:
+      ParallelForTask(ParallelForBody& body, unsigned begin, unsigned end, unsigned grainSize, OpenThreads::Atomic& outstanding)
+      : mBody(body)
+      , mBegin(begin)
+      , mEnd(end)
+      , mGrainSize(grainSize)
+      , mOutstanding(outstanding)
+      {
+      }
+
+      virtual void operator()()
+      {
+         while (mEnd - mBegin > mGrainSize)
+         {
+            unsigned middle = mBegin + (mEnd - mBegin) / 2U;
+            ++mOutstanding;
+            gThreadPoolImpl.AddTask(*new ParallelForTask(mBody, middle, mEnd, mGrainSize, mOutstanding), ThreadPool::IMMEDIATE);
+            mEnd = middle;
+         }
+
+         mBody(mBegin, mEnd);
+
+         // The last thing it does, since ParallelFor returns, and the body and counter go away, once it's zero.
+         --mOutstanding;
+      }
+
+   protected:
+      virtual ~ParallelForTask()
+      {
+      }
+
+   private:
+      ParallelForBody& mBody;
+      unsigned mBegin;
+      unsigned mEnd;
+      unsigned mGrainSize;
+      OpenThreads::Atomic& mOutstanding;
+   };
+
    //////////////////////////////////////////////////
    //////////////////////////////////////////////////
    bool ThreadPool::IsInitialized()
@@ -522,28 +984,32 @@ template<class _Ty,
          numThreads = OpenThreads::GetNumberOfProcessors() - 1;
       }
 
-      gThreadPoolImpl.mTaskQueue = new TaskQueue;
-      gThreadPoolImpl.mBackgroundQueue = gThreadPoolImpl.mTaskQueue;
+      gThreadPoolImpl.mBackgroundQueue = new TaskQueue;
+      gThreadPoolImpl.mIOQueue = new TaskQueue;
 
       if (numThreads <= 0)
       {
          // On a single core box, or if the user specifies 0 worker threads,
          // we still have to create one thread for background processes.
          // Immediate stuff will only be run when ExecuteTasks is called.
-         numThreads = 1;
+         numThreads = 0;
          gThreadPoolImpl.mTaskThreadForBackgroundOnly = true;
-         gThreadPoolImpl.mBackgroundQueue = new TaskQueue;
+
+         dtCore::RefPtr<TaskThread> newThread = new TaskThread(*gThreadPoolImpl.mBackgroundQueue);
+         gThreadPoolImpl.mTaskThreads.push_back(newThread);
+         newThread->start();
       }
 
-      gThreadPoolImpl.mIOQueue = new TaskQueue;
+      // one per worker, and one shared by the other threads.
+      for (int i = 0; i <= numThreads; ++i)
+      {
+         gThreadPoolImpl.mWorkQueues.push_back(new WorkQueue);
+      }
 
       for (int i = 0; i < numThreads; ++i)
       {
-         dtCore::RefPtr<TaskThread> newThread;
-         // the background queue may also be the main task queue.
-         newThread = new TaskThread(*gThreadPoolImpl.mBackgroundQueue);
-
-         gThreadPoolImpl.mTaskThreads.push_back(newThread);
+         dtCore::RefPtr<WorkerThread> newThread = new WorkerThread(unsigned(i));
+         gThreadPoolImpl.mWorkerThreads.push_back(newThread);
          newThread->start();
       }
 
@@ -562,47 +1028,107 @@ template<class _Ty,
    //////////////////////////////////////////////////
    void ThreadPool::Shutdown()
    {
+      gThreadPoolImpl.mWorkerThreads.clear();
       gThreadPoolImpl.mTaskThreads.clear();
-      gThreadPoolImpl.mTaskQueue = NULL;
+      gThreadPoolImpl.mWorkQueues.clear();
       gThreadPoolImpl.mBackgroundQueue = NULL;
       gThreadPoolImpl.mIOQueue = NULL;
+      gThreadPoolImpl.mImmediateInProcess.exchange(0U);
+      gThreadPoolImpl.mImmediateQueued.exchange(0U);
+      gThreadPoolImpl.mTaskThreadForBackgroundOnly = false;
       gThreadPoolImpl.mInitialized = false;
    }
 
    //////////////////////////////////////////////////
    void ThreadPool::AddTask(ThreadPoolTask& task, PoolQueue queue)
    {
-      task.ResetWaitBlock();
-      if (queue == IMMEDIATE)
+      gThreadPoolImpl.AddTask(task, queue);
+   }
+
+   //////////////////////////////////////////////////
+   void ThreadPool::ExecuteTasks()
+   {
+      gThreadPoolImpl.ExecuteTasks();
+   }
+
+   //////////////////////////////////////////////////
+   unsigned ThreadPool::GetNumImmediateWorkerThreads()
+   {
+      if (gThreadPoolImpl.mTaskThreadForBackgroundOnly)
+      {
+         return 1U;
+      }
+
+      return unsigned(gThreadPoolImpl.mWorkerThreads.size()) + 1U;
+   }
+
+   //////////////////////////////////////////////////
+   unsigned ThreadPool::GetNumBackgroundWorkerThreads()
+   {
+      if (gThreadPoolImpl.mTaskThreadForBackgroundOnly)
+      {
+         return 1U;
+      }
+
+      return unsigned(gThreadPoolImpl.mWorkerThreads.size());
+   }
+
+   //////////////////////////////////////////////////
+   void ThreadPool::ParallelFor(unsigned begin, unsigned end, unsigned grainSize, ParallelForBody& body)
+   {
+      if (grainSize == 0U)
+      {
+         grainSize = 1U;
+      }
+
+      if (end <= begin)
       {
-         gThreadPoolImpl.mTaskQueue->Add(task, 0);
+         return;
       }
-      else if (queue == BACKGROUND)
+
+      if (!gThreadPoolImpl.mInitialized || gThreadPoolImpl.mWorkerThreads.empty())
       {
-         // in cases where worker threads > 0, the background queue is the same pointer as the task queue
-         gThreadPoolImpl.mBackgroundQueue->Add(task, 1);
+         for (unsigned i = begin; i < end; i += std::min(grainSize, end - i))
+         {
+            body(i, i + std::min(grainSize, end - i));
+         }
+         return;
       }
-      else if (queue == IO)
+
+      OpenThreads::Atomic outstanding;
+      ++outstanding;
+
+      // The first piece runs right here, and this thread helps with the rest until they're all done.
+      dtCore::RefPtr<ParallelForTask> root = new ParallelForTask(body, begin, end, grainSize, outstanding);
+      (*root)();
+
+      const unsigned queueIndex = gThreadPoolImpl.GetCurrentQueueIndex();
+      while (unsigned(outstanding) > 0U)
       {
-         gThreadPoolImpl.mIOQueue->Add(task, 1);
+         if (!gThreadPoolImpl.ExecuteSingleImmediateTask(queueIndex))
+         {
+            OpenThreads::Thread::YieldCurrentThread();
+         }
       }
    }
 
    //////////////////////////////////////////////////
-   void ThreadPool::ExecuteTasks()
+   void ThreadPool::GetStatistics(std::vector<QueueStatistics>& stats)
    {
-      gThreadPoolImpl.mTaskQueue->ExecuteTasks(true, 0);
+      stats.resize(gThreadPoolImpl.mWorkQueues.size());
+      for (unsigned i = 0; i < gThreadPoolImpl.mWorkQueues.size(); ++i)
+      {
+         gThreadPoolImpl.mWorkQueues[i]->GetStatistics(stats[i]);
+      }
    }
 
    //////////////////////////////////////////////////
-   unsigned ThreadPool::GetNumImmediateWorkerThreads()
+   void ThreadPool::ResetStatistics()
    {
-      if (gThreadPoolImpl.mTaskThreadForBackgroundOnly)
+      for (unsigned i = 0; i < gThreadPoolImpl.mWorkQueues.size(); ++i)
       {
-         return 1U;
+         gThreadPoolImpl.mWorkQueues[i]->ResetStatistics();
       }
-
-      return gThreadPoolImpl.mTaskThreads.size();
    }
 
    //////////////////////////////////////////////////
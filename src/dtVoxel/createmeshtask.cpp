@@ -27,29 +27,46 @@
 #include <dtUtil/log.h>
 
 #include <tbb/parallel_for.h>
-#include <tbb/blocked_range3d.h>
-#include <tbb/mutex.h>
+#include <tbb/blocked_range.h>
 #include <tbb/task_scheduler_init.h>
 
 #include <dtCore/timer.h>
 
+#include <OpenThreads/ScopedLock>
+
+#include <cmath>
+
 namespace dtVoxel
 {
-   int HashVec3WithMap(std::map<osg::Vec3, int>& vectorMap, const osg::Vec3& vec, bool& inserted)
+   namespace
    {
-      inserted = true;
-      int index = vectorMap.size();
-      auto insertResult = vectorMap.insert(std::make_pair(vec, index));
-      //if insert fails
-      if (!insertResult.second)
+      /**
+       * Each slab keeps seven vertex slots per lattice point (i, j) of its z layer: the x and y edges and the corner
+       * on its bottom, the z edge, and the x and y edges and the corner on its top.  The top slots of one layer are
+       * the bottom slots of the next.
+       */
+      enum EdgeSlot { BOTTOM_X, BOTTOM_Y, BOTTOM_CORNER, VERTICAL_Z, TOP_X, TOP_Y, TOP_CORNER, NUM_EDGE_SLOTS };
+      const unsigned BOTTOM_TO_TOP = TOP_X - BOTTOM_X;
+
+      struct CubeEdgeSlot
       {
-         //take the existing index
-         index = insertResult.first->second;
-         inserted = false;
-      }
-
-      return index;
-   }   
+         int mDI, mDJ;
+         EdgeSlot mSlot;
+      };
+
+      /**
+       * The lattice point offset and slot for each of the 12 marching cubes edges, numbered as in marchingcubes.cpp,
+       * followed by the 8 corners.
+       */
+      const CubeEdgeSlot CUBE_EDGE_SLOTS[20] =
+      {
+         { 0, 0, BOTTOM_X }, { 1, 0, BOTTOM_Y }, { 0, 1, BOTTOM_X }, { 0, 0, BOTTOM_Y },
+         { 0, 0, TOP_X }, { 1, 0, TOP_Y }, { 0, 1, TOP_X }, { 0, 0, TOP_Y },
+         { 0, 0, VERTICAL_Z }, { 1, 0, VERTICAL_Z }, { 1, 1, VERTICAL_Z }, { 0, 1, VERTICAL_Z },
+         { 0, 0, BOTTOM_CORNER }, { 1, 0, BOTTOM_CORNER }, { 1, 1, BOTTOM_CORNER }, { 0, 1, BOTTOM_CORNER },
+         { 0, 0, TOP_CORNER }, { 1, 0, TOP_CORNER }, { 1, 1, TOP_CORNER }, { 0, 1, TOP_CORNER }
+      };
+   }
 
    CreateMeshTask::CreateMeshTask(const osg::Vec3& offset, const osg::Vec3& texelSize, const osg::Vec3i& resolution, double isolevel, openvdb::FloatGrid::Ptr grid)
       : mSkipBackFaces(true)
@@ -58,22 +75,27 @@ namespace dtVoxel
       , mIsDone(false)     
       , mMode(Default)
       , mUseCache(false)
-      , mUseBoundingBox(false)
       , mTime(0.0)
       , mIsoLevel(isolevel)
       , mOffset(offset)
       , mTexelSize(texelSize)
       , mResolution(resolution)
-      , mDirtyBounds()
+      , mNumBricks((resolution[0] + BRICK_SIZE - 1) / BRICK_SIZE, (resolution[1] + BRICK_SIZE - 1) / BRICK_SIZE, (resolution[2] + BRICK_SIZE - 1) / BRICK_SIZE)
       , mMesh(new osg::Geode())
       , mGrid(grid)
       , mCacheData()
+      , mNumPendingEdits(0U)
+      , mHasRun(false)
+      , mLastNumEdits(0U)
+      , mLastRemeshedCells(0U)
    {
       if (mCacheTriangleData)
       {
          mCacheData.resize(mResolution[0] * mResolution[1] * mResolution[2]);
          mOccupancy.resize(mResolution[0] * mResolution[1] * mResolution[2], 0);
       }
+
+      mPendingBricks.resize(mNumBricks[0] * mNumBricks[1] * mNumBricks[2], 0);
    }
 
    CreateMeshTask::~CreateMeshTask()
@@ -82,6 +104,17 @@ namespace dtVoxel
       mGrid = nullptr;
       mOccupancy.clear();
       mCacheData.clear();
+      mSlabs.clear();
+   }
+
+   void CreateMeshTask::SetMode(GenerateMode mode)
+   {
+      mMode = mode;
+   }
+
+   CreateMeshTask::GenerateMode CreateMeshTask::GetMode() const
+   {
+      return mMode;
    }
 
    bool CreateMeshTask::IsDone() const
@@ -101,6 +134,8 @@ namespace dtVoxel
 
    void CreateMeshTask::operator()()
    {
+      BeginUpdate();
+
       switch (mMode)
       {
       case RunInSingleThread:
@@ -119,60 +154,29 @@ namespace dtVoxel
    {
       dtCore::Timer_t startTime = dtCore::Timer::Instance()->Tick();
 
-      openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler> sampler(mGrid->getConstAccessor(), mGrid->transform());
-
-      TRIANGLE triangles[5];
-
-      std::map<osg::Vec3, int> vectorMap;
-
-      dtCore::RefPtr<osg::Geometry> geom = new osg::Geometry();
-      dtCore::RefPtr<osg::Vec3Array> vertArray = new osg::Vec3Array();
-      dtCore::RefPtr<osg::DrawElementsUInt> drawElements = new osg::DrawElementsUInt(GL_TRIANGLES);
+      FastSampler sampler(mGrid->getConstAccessor(), mGrid->transform());
 
-      for (int i = 0; i < mResolution[0]; ++i)
+      mSlabs.resize(mResolution[2]);
+      for (int k = 0; k < mResolution[2]; ++k)
       {
-         for (int j = 0; j < mResolution[1]; ++j)
+         if (IsSlabDirty(k))
          {
-            for (int k = 0; k < mResolution[2]; ++k)
-            {
-               int numTriangles = SampleSingleCell(i, j, k, sampler, triangles);
-
-               for (int n = 0; n < numTriangles; ++n)
-               {
-                  if (mSkipBackFaces && triangles[n].n[0].z() < 0.0 && triangles[n].n[1].z() < 0.0 && triangles[n].n[2].z() < 0.0)
-                  {
-                     //skipping triangle 
-                  }
-                  else
-                  {
-                     for (int i = 0; i < 3; ++i)
-                     {
-                        bool inserted = false;
-                        int numVerts = vertArray->size();
-                        int index = HashVec3WithMap(vectorMap, triangles[n].p[i], inserted);
-
-                        if (inserted)
-                        {
-                           vertArray->push_back(triangles[n].p[i]);
-                        }
-
-                        drawElements->addElement(index);
-                     }
-                  }
-               }
-            }
+            MeshSingleSlab(k, sampler, mSlabs[k]);
          }
       }
 
-      //std::cout << "Num Verts " << vertArray->getNumElements() << std::endl;
-
-
-      geom->setVertexArray(vertArray);
-      geom->addPrimitiveSet(drawElements);
+      MergeSlabs(mSlabs, false);
 
-      mMesh->addDrawable(geom);
+      if (mCacheTriangleData)
+      {
+         //setup to use the cache next time through
+         mUseCache = true;
+      }
+      else
+      {
+         mSlabs.clear();
+      }
 
-      vectorMap.clear();
       mIsDone = true;
    
       mTime = dtCore::Timer::Instance()->DeltaMil(startTime, dtCore::Timer::Instance()->Tick());
@@ -181,121 +185,206 @@ namespace dtVoxel
 
    void CreateMeshTask::RunMultiThreads()
    {
-      int trianglesSkipped = 0;
-      if (mMode == UseMaxThreads)
-      {
-         tbb::task_scheduler_init init();
-      }
-      else
-      {
-         tbb::task_scheduler_init init(mNumThreads);
-      }
+      // This has to live until the work is done, or it doesn't limit anything.
+      tbb::task_scheduler_init init(mMode == UseMaxThreads ? int(tbb::task_scheduler_init::automatic) : mNumThreads);
 
       dtCore::Timer_t startTime = dtCore::Timer::Instance()->Tick();
-      dtCore::RefPtr<osg::Geometry> geom = new osg::Geometry();
-      dtCore::RefPtr<osg::Vec3Array> vertArray = new osg::Vec3Array();
-      dtCore::RefPtr<osg::DrawElementsUInt> drawElements = new osg::DrawElementsUInt(GL_TRIANGLES);
 
-      tbb::mutex /*hashMtx,*/ elemMtx;
+      mSlabs.resize(mResolution[2]);
 
-      tbb::parallel_for(tbb::blocked_range3d<int>(0, mResolution[0], 1U, 0, mResolution[1], 16U, 0, mResolution[2], 9U),
-         [&](const tbb::blocked_range3d<int>& r)
+      tbb::parallel_for(tbb::blocked_range<int>(0, mResolution[2]),
+         [&](const tbb::blocked_range<int>& r)
       {
-         openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler> sampler(mGrid->getConstAccessor(), mGrid->transform());
-         // It may not be as efficient for rendering to have one per thread, but having to lock a shared kills performance.
-         std::map<osg::Vec3, int> vectorMap;
+         FastSampler sampler(mGrid->getConstAccessor(), mGrid->transform());
+         for (int k = r.begin(); k < r.end(); ++k)
+         {
+            if (IsSlabDirty(k))
+            {
+               MeshSingleSlab(k, sampler, mSlabs[k]);
+            }
+         }
+      });
 
-         dtCore::RefPtr<osg::Vec3Array> vertArraySub = new osg::Vec3Array();
-         dtCore::RefPtr<osg::DrawElementsUInt> drawElementsSub = new osg::DrawElementsUInt(GL_TRIANGLES);
+      MergeSlabs(mSlabs, true);
 
-         int numTrisDropped = 0;
+      if (mCacheTriangleData)
+      {
+         //setup to use the cache next time through
+         mUseCache = true;
+      }
+      else
+      {
+         mSlabs.clear();
+      }
 
-         //this is always 1 because the actual values are interploated from 0-1 using the iso value property now
-         const float isolevel = 1.0f;
+      mIsDone = true;
+      mTime = dtCore::Timer::Instance()->DeltaMil(startTime, dtCore::Timer::Instance()->Tick());
+      LOGN_DEBUG("createmeshtask.cpp", "Time to update cell ms: " + dtUtil::ToString(mTime));
+   }
+
+   void CreateMeshTask::MeshSingleSlab(int k, FastSampler& sampler, MeshSlab& slab)
+   {
+      const int latticeWidth = mResolution[0] + 1;
+      slab.mVerts.clear();
+      slab.mVertSlots.clear();
+      slab.mIndices.clear();
+      slab.mSlotVerts.assign(latticeWidth * (mResolution[1] + 1) * NUM_EDGE_SLOTS, -1);
 
-         //reusing this improves performance by quite a bit
-         osg::Vec3 vertlist[12];
-         GRIDCELL grid;
-         TRIANGLE triangles[5];
+      TRIANGLE triangles[5];
+      int triangleEdges[15];
 
-         for (int k = r.cols().begin(); k < r.cols().end(); ++k)
+      for (int j = 0; j < mResolution[1]; ++j)
+      {
+         for (int i = 0; i < mResolution[0]; ++i)
          {
-            for (int j = r.rows().begin(); j < r.rows().end(); ++j)
+            int numTriangles = SampleSingleCell(i, j, k, sampler, triangles, triangleEdges);
+
+            for (int n = 0; n < numTriangles; ++n)
             {
-               for (int i = r.pages().begin(); i < r.pages().end(); ++i)
+               if (mSkipBackFaces && triangles[n].n[0].z() < 0.0 && triangles[n].n[1].z() < 0.0 && triangles[n].n[2].z() < 0.0)
                {
-                  int numTriangles = SampleSingleCell(i, j, k, sampler, triangles);
+                  //skipping triangle 
+                  continue;
+               }
+
+               unsigned slots[3];
+               for (int v = 0; v < 3; ++v)
+               {
+                  const CubeEdgeSlot& edge = CUBE_EDGE_SLOTS[triangleEdges[n * 3 + v]];
+                  slots[v] = ((j + edge.mDJ) * latticeWidth + i + edge.mDI) * NUM_EDGE_SLOTS + edge.mSlot;
+               }
 
-                  for (int n = 0; n < numTriangles; ++n)
+               // Two vertices welded to the same corner leave nothing to draw.
+               if (slots[0] == slots[1] || slots[1] == slots[2] || slots[0] == slots[2])
+               {
+                  continue;
+               }
+
+               for (int v = 0; v < 3; ++v)
+               {
+                  int& vert = slab.mSlotVerts[slots[v]];
+                  if (vert < 0)
                   {
-                     if (mSkipBackFaces && triangles[n].n[0].z() < 0.0 && triangles[n].n[1].z() < 0.0 && triangles[n].n[2].z() < 0.0)
-                     {
-                        //skipping triangle 
-                        ++numTrisDropped;
-                     }
-                     else
-                     {
-                        for (int i = 0; i < 3; ++i)
-                        {
-                           bool inserted = false;
-                           int index = -1;
-                           {
-                              index = HashVec3WithMap(vectorMap, triangles[n].p[i], inserted);
-                              if (inserted)
-                              {
-                                 vertArraySub->push_back(triangles[n].p[i]);
-                                 if ((vertArraySub->size() - 1) != unsigned(index))
-                                 {
-                                    printf("Error! %lu %d\n", vertArraySub->size(), index);
-                                 }
-                              }
-                           }
-
-                           drawElementsSub->addElement(index);
-
-                        }
-                     }
+                     vert = int(slab.mVerts.size());
+                     slab.mVerts.push_back(triangles[n].p[v]);
+                     slab.mVertSlots.push_back(slots[v]);
                   }
+
+                  slab.mIndices.push_back(unsigned(vert));
                }
             }
          }
-         tbb::mutex::scoped_lock sl(elemMtx);
+      }
+   }
 
-         //this seems to cause a performance bottleneck in VS2013 x64
-         vertArray->reserve(vertArray->size() + vertArraySub->size());
+   void CreateMeshTask::ResolveSharedVerts(MeshSlab& slab, const MeshSlab* below) const
+   {
+      slab.mOwnedIndex.resize(slab.mVerts.size());
+      slab.mNumOwnedVerts = 0;
+      for (unsigned v = 0; v < slab.mVerts.size(); ++v)
+      {
+         unsigned slot = slab.mVertSlots[v];
+         unsigned edgeSlot = slot % NUM_EDGE_SLOTS;
+         if (below != NULL && edgeSlot <= BOTTOM_CORNER)
+         {
+            // The bottom of this layer is the top of the one below, so take its vertex if it made one.
+            int belowVert = below->mSlotVerts[slot + BOTTOM_TO_TOP];
+            if (belowVert >= 0)
+            {
+               slab.mOwnedIndex[v] = -1 - belowVert;
+               continue;
+            }
+         }
 
-         int startingIdx = vertArray->size();
-         vertArray->insert(vertArray->end(), vertArraySub->begin(), vertArraySub->end());
+         slab.mOwnedIndex[v] = int(slab.mNumOwnedVerts);
+         ++slab.mNumOwnedVerts;
+      }
+   }
 
-         //this seems to cause a performance bottleneck in VS2013 x64
-         drawElements->reserve(drawElements->size() + drawElementsSub->size());
+   void CreateMeshTask::CopySlab(const MeshSlab& slab, const MeshSlab* below, unsigned vertOffset, unsigned belowVertOffset, unsigned indexOffset,
+            osg::Vec3Array& vertArray, osg::DrawElementsUInt& drawElements) const
+   {
+      for (unsigned v = 0; v < slab.mVerts.size(); ++v)
+      {
+         if (slab.mOwnedIndex[v] >= 0)
+         {
+            vertArray[vertOffset + slab.mOwnedIndex[v]] = slab.mVerts[v];
+         }
+      }
 
-         for (auto itr = drawElementsSub->begin(), itrEnd = drawElementsSub->end(); itr != itrEnd; ++itr)
+      for (unsigned n = 0; n < slab.mIndices.size(); ++n)
+      {
+         int owned = slab.mOwnedIndex[slab.mIndices[n]];
+         if (owned >= 0)
+         {
+            drawElements[indexOffset + n] = vertOffset + unsigned(owned);
+         }
+         else
          {
-            drawElements->push_back((*itr) + startingIdx);
+            // The top vertices of a slab are always its own, so this is the index among the vertices the slab below owns.
+            drawElements[indexOffset + n] = belowVertOffset + unsigned(below->mOwnedIndex[-1 - owned]);
          }
+      }
+   }
 
-         trianglesSkipped += numTrisDropped;
-         //drawElements->insert(drawElements->end(), drawElementsSub->begin(), drawElementsSub->end());
-      });
-      //std::cout << "Num Verts " << vertArray->getNumElements() << std::endl;
+   void CreateMeshTask::MergeSlabs(std::vector<MeshSlab>& slabs, bool parallel)
+   {
+      const int numSlabs = int(slabs.size());
 
+      if (parallel)
+      {
+         tbb::parallel_for(tbb::blocked_range<int>(0, numSlabs),
+            [&](const tbb::blocked_range<int>& r)
+         {
+            for (int k = r.begin(); k < r.end(); ++k)
+            {
+               ResolveSharedVerts(slabs[k], k > 0 ? &slabs[k - 1] : NULL);
+            }
+         });
+      }
+      else
+      {
+         for (int k = 0; k < numSlabs; ++k)
+         {
+            ResolveSharedVerts(slabs[k], k > 0 ? &slabs[k - 1] : NULL);
+         }
+      }
 
-      geom->setVertexArray(vertArray);
-      geom->addPrimitiveSet(drawElements);
+      // Prefix sums of the vertex and index counts give each slab its place in the combined arrays.
+      std::vector<unsigned> vertOffsets(numSlabs + 1, 0U), indexOffsets(numSlabs + 1, 0U);
+      for (int k = 0; k < numSlabs; ++k)
+      {
+         vertOffsets[k + 1] = vertOffsets[k] + slabs[k].mNumOwnedVerts;
+         indexOffsets[k + 1] = indexOffsets[k] + unsigned(slabs[k].mIndices.size());
+      }
 
-      mMesh->addDrawable(geom);
+      dtCore::RefPtr<osg::Geometry> geom = new osg::Geometry();
+      dtCore::RefPtr<osg::Vec3Array> vertArray = new osg::Vec3Array(vertOffsets[numSlabs]);
+      dtCore::RefPtr<osg::DrawElementsUInt> drawElements = new osg::DrawElementsUInt(GL_TRIANGLES, indexOffsets[numSlabs]);
 
-      if (mCacheTriangleData)
+      if (parallel)
       {
-         //setup to use the cache next time through
-         mUseCache = true;
+         tbb::parallel_for(tbb::blocked_range<int>(0, numSlabs),
+            [&](const tbb::blocked_range<int>& r)
+         {
+            for (int k = r.begin(); k < r.end(); ++k)
+            {
+               CopySlab(slabs[k], k > 0 ? &slabs[k - 1] : NULL, vertOffsets[k], k > 0 ? vertOffsets[k - 1] : 0U, indexOffsets[k], *vertArray, *drawElements);
+            }
+         });
+      }
+      else
+      {
+         for (int k = 0; k < numSlabs; ++k)
+         {
+            CopySlab(slabs[k], k > 0 ? &slabs[k - 1] : NULL, vertOffsets[k], k > 0 ? vertOffsets[k - 1] : 0U, indexOffsets[k], *vertArray, *drawElements);
+         }
       }
 
-      mIsDone = true;
-      mTime = dtCore::Timer::Instance()->DeltaMil(startTime, dtCore::Timer::Instance()->Tick());
-      LOGN_DEBUG("createmeshtask.cpp", "Time to update cell ms: " + dtUtil::ToString(mTime));
-      //LOGN_DEBUG("createmeshtask.cpp", "Num Backfaces Removed " + dtUtil::ToString(trianglesSkipped));
+      geom->setVertexArray(vertArray);
+      geom->addPrimitiveSet(drawElements);
+
+      mMesh->addDrawable(geom);
    }
 
    double CreateMeshTask::SampleCoord(double x, double y, double z, openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler>& fastSampler)
@@ -313,7 +402,63 @@ namespace dtVoxel
       return (k * mResolution[1] * mResolution[0]) + (j * mResolution[0]) + i;
    }
 
-   int CreateMeshTask::SampleSingleCell(int i, int j, int k, openvdb::tools::GridSampler<openvdb::FloatGrid::ConstAccessor, openvdb::tools::PointSampler>& sampler, TRIANGLE* triangles)
+   int CreateMeshTask::ComputeBrickIndex(int bi, int bj, int bk) const
+   {
+      return (bk * mNumBricks[1] * mNumBricks[0]) + (bj * mNumBricks[0]) + bi;
+   }
+
+   void CreateMeshTask::BeginUpdate()
+   {
+      {
+         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingMutex);
+         mBricksToMesh.swap(mPendingBricks);
+         mPendingBricks.assign(mBricksToMesh.size(), 0);
+         mPendingBounds.init();
+         mLastNumEdits = mUseCache ? mNumPendingEdits : 0U;
+         mNumPendingEdits = 0U;
+         mHasRun = true;
+      }
+
+      mMesh = new osg::Geode();
+
+      // Without the cache everything is remeshed.
+      mDirtyBrickLayers.assign(mNumBricks[2], mUseCache ? 0 : 1);
+      mLastRemeshedCells = 0U;
+      for (int bk = 0; bk < mNumBricks[2]; ++bk)
+      {
+         for (int bj = 0; bj < mNumBricks[1]; ++bj)
+         {
+            for (int bi = 0; bi < mNumBricks[0]; ++bi)
+            {
+               if (!mUseCache || mBricksToMesh[ComputeBrickIndex(bi, bj, bk)] != 0)
+               {
+                  mDirtyBrickLayers[bk] = 1;
+
+                  // The bricks on the far sides may be cut short by the resolution.
+                  unsigned cells = 1U;
+                  const int brick[3] = { bi, bj, bk };
+                  for (int axis = 0; axis < 3; ++axis)
+                  {
+                     cells *= unsigned(dtUtil::Min(int(BRICK_SIZE), mResolution[axis] - brick[axis] * BRICK_SIZE));
+                  }
+                  mLastRemeshedCells += cells;
+               }
+            }
+         }
+      }
+   }
+
+   bool CreateMeshTask::IsCellDirty(int i, int j, int k) const
+   {
+      return !mUseCache || mBricksToMesh[ComputeBrickIndex(i / BRICK_SIZE, j / BRICK_SIZE, k / BRICK_SIZE)] != 0;
+   }
+
+   bool CreateMeshTask::IsSlabDirty(int k) const
+   {
+      return mDirtyBrickLayers[k / BRICK_SIZE] != 0;
+   }
+
+   int CreateMeshTask::SampleSingleCell(int i, int j, int k, FastSampler& sampler, TRIANGLE* triangles, int* triangleEdges)
    {  
       //this is always 1 because the actual values are interploated from 0-1 using the iso value property now
       const float isolevel = 1.0f;
@@ -327,32 +472,19 @@ namespace dtVoxel
       osg::Vec3 from(worldX, worldY, worldZ);
 
 
-      if (mUseCache)
+      //only read the cached data if we did not modify this cell
+      if (!IsCellDirty(i, j, k))
       {
-         if (!mUseBoundingBox)
-         {         
-            LOGN_WARNING("createmeshtask.cpp", "No Bounding Box set, but task is attempting to load from cache.");
-         }
-         else
-         {
-            osg::Vec3 origin(worldX, worldY, worldZ);
-            osg::BoundingBox cellBB(from - (mTexelSize * 1.5), from + (mTexelSize * 2.0));
-            
-            //only read the cached data if we did not modify this cell
-            if (!mDirtyBounds.intersects(cellBB))
-            {
-               int numTriangles = mOccupancy[index];
-
-               CopyTriangleData(&(mCacheData[index].mTris[0]), triangles, numTriangles);
+         int numTriangles = mOccupancy[index];
 
-               //exit out early with cached data
-               return numTriangles;
-            }            
-            else
-            {
-               //continue and regenerate cached data
-            }
+         CopyTriangleData(&(mCacheData[index].mTris[0]), triangles, numTriangles);
+         for (int edge = 0; edge < numTriangles * 3; ++edge)
+         {
+            triangleEdges[edge] = mCacheData[index].mEdges[edge];
          }
+
+         //exit out early with cached data
+         return numTriangles;
       }
 
 
@@ -384,7 +516,7 @@ namespace dtVoxel
       grid.val[7] = SampleCoord(grid.p[7].x(), grid.p[7].y(), grid.p[7].z(), sampler);
 
 
-      int numTriangles = PolygonizeCube(grid, isolevel, triangles, &vertlist[0]);
+      int numTriangles = PolygonizeCube(grid, isolevel, triangles, &vertlist[0], triangleEdges);
       
       if (mCacheTriangleData)
       {
@@ -393,6 +525,10 @@ namespace dtVoxel
          if (numTriangles > 0)
          {
             CopyTriangleData(triangles, &(mCacheData[index].mTris[0]), numTriangles);
+            for (int edge = 0; edge < numTriangles * 3; ++edge)
+            {
+               mCacheData[index].mEdges[edge] = static_cast<unsigned char>(triangleEdges[edge]);
+            }
          }
       }
 
@@ -414,17 +550,61 @@ namespace dtVoxel
 
    void CreateMeshTask::UpdateWithBounds(const osg::BoundingBox& bb)
    {
-      if (!mIsDone)
+      // A cell samples the nearest voxel to each of its corners, so the edit reaches the cells a little way outside of it.
+      int start[3], end[3];
+      for (int axis = 0; axis < 3; ++axis)
       {
-         mDirtyBounds.expandBy(bb);
+         start[axis] = dtUtil::Max(int(std::ceil((bb._min[axis] - mOffset[axis]) / mTexelSize[axis] - 2.0f)), 0);
+         end[axis] = dtUtil::Min(int(std::floor((bb._max[axis] - mOffset[axis]) / mTexelSize[axis] + 1.5f)), mResolution[axis] - 1);
+         if (start[axis] > end[axis])
+         {
+            // The edit misses this block of cells.
+            return;
+         }
       }
-      else
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingMutex);
+      for (int bk = start[2] / BRICK_SIZE; bk <= end[2] / BRICK_SIZE; ++bk)
       {
-         mDirtyBounds = bb;
-         mMesh = new osg::Geode();
-         mIsDone = false;
-         mUseBoundingBox = true;
+         for (int bj = start[1] / BRICK_SIZE; bj <= end[1] / BRICK_SIZE; ++bj)
+         {
+            for (int bi = start[0] / BRICK_SIZE; bi <= end[0] / BRICK_SIZE; ++bi)
+            {
+               mPendingBricks[ComputeBrickIndex(bi, bj, bk)] = 1;
+            }
+         }
       }
+
+      mPendingBounds.expandBy(bb);
+      ++mNumPendingEdits;
+   }
+
+   bool CreateMeshTask::NeedsUpdate() const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingMutex);
+      return !mHasRun || mNumPendingEdits > 0U;
+   }
+
+   bool CreateMeshTask::GetPendingBounds(osg::BoundingBox& bbOut) const
+   {
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingMutex);
+      bbOut = mPendingBounds;
+      return mNumPendingEdits > 0U;
+   }
+
+   unsigned CreateMeshTask::GetLastNumEdits() const
+   {
+      return mLastNumEdits;
+   }
+
+   unsigned CreateMeshTask::GetLastRemeshedCells() const
+   {
+      return mLastRemeshedCells;
+   }
+
+   double CreateMeshTask::GetLastRemeshedVolume() const
+   {
+      return double(mLastRemeshedCells) * mTexelSize[0] * mTexelSize[1] * mTexelSize[2];
    }
 
    
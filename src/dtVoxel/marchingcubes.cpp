@@ -48,14 +48,16 @@ namespace dtVoxel
       p[2] = p1[2] + mu * (p2[2] - p1[2]);
 */
 
-      if (valp1 != valp2)
+      if (isolevel == valp2 && valp1 != valp2)
+         p = p2;
+      else if (valp1 != valp2)
          p = p1 + (p2 - p1) / (valp2 - valp1)*(isolevel - valp1);
       else
          p = p1;
       return p;      
    }
 
-   int PolygonizeCube(GRIDCELL g, float iso, TRIANGLE *tri, osg::Vec3* vertArray)
+   int PolygonizeCube(GRIDCELL g, float iso, TRIANGLE *tri, osg::Vec3* vertArray, int* triangleEdges)
    {
       int i, ntri = 0;
       int cubeindex;
@@ -408,6 +410,11 @@ namespace dtVoxel
       { 0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
       { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 } };
 
+      /* The corners at either end of each edge */
+      static const int edgeCorners[12][2] = {
+         { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, { 4, 5 }, { 5, 6 },
+         { 6, 7 }, { 7, 4 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+
       /*
       Determine the index into the edge table which
       tells us which vertices are inside of the surface
@@ -470,6 +477,22 @@ namespace dtVoxel
          tri[ntri].p[1] = vertArray[triTable[cubeindex][i + 1]];
          tri[ntri].p[2] = vertArray[triTable[cubeindex][i + 2]];
 
+         if (triangleEdges != NULL)
+         {
+            for (int v = 0; v < 3; ++v)
+            {
+               int edge = triTable[cubeindex][i + v];
+               int corner1 = edgeCorners[edge][0], corner2 = edgeCorners[edge][1];
+               // Match VertexInterp, which returns the first corner when the values are equal.
+               if (g.val[corner1] == iso || g.val[corner1] == g.val[corner2])
+                  triangleEdges[i + v] = 12 + corner1;
+               else if (g.val[corner2] == iso)
+                  triangleEdges[i + v] = 12 + corner2;
+               else
+                  triangleEdges[i + v] = edge;
+            }
+         }
+
          //generate normals         
          osg::Vec3 normal(tri[ntri].p[1] - tri[ntri].p[0]);
          osg::Vec3 tempv3(tri[ntri].p[2] - tri[ntri].p[0]);
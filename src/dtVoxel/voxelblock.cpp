@@ -206,21 +206,9 @@ namespace dtVoxel
 
                               if (!vc->IsDirty())
                               {
-                                 fv.mLOD->setNumChildrenThatCannotBeExpired(fv.mLOD->getNumChildren());
-
-                                 VoxelCellUpdateInfo updateInfo;
-                                 updateInfo.mBlock = this;
-                                 updateInfo.mCell = vc;
-                                 updateInfo.mNodeToUpdate = fv.mFoundNode;
-                                 updateInfo.mCellIndex.set(x, y, z);
-                                 updateInfo.mStarted = false;
-                                 updateInfo.mLODNode = fv.mLOD;
-
-                                 vc->SetDirty(true);
-
                                  //std::cout << "Adding nodes to dirty cells" << std::endl;
 
-                                 dirtyCells.push_back(updateInfo);
+                                 AddCellUpdate(vc, osg::Vec3i(x, y, z), fv.mFoundNode, fv.mLOD, dirtyCells);
                               }
 
                               osg::Vec3 pos(x * mWSCellDimensions[0], y * mWSCellDimensions[1], z * mWSCellDimensions[2]);
@@ -251,6 +239,43 @@ namespace dtVoxel
    }
 
 
+   bool VoxelBlock::RequeueCell(VoxelCell* cell, const osg::Vec3i& cellIndex, std::list<VoxelCellUpdateInfo>& dirtyCells)
+   {
+      if (cell == nullptr || cell->IsDirty())
+      {
+         return false;
+      }
+
+      FindVoxelCellVisitor fv(GetCellName(cellIndex.x(), cellIndex.y(), cellIndex.z()));
+      GetOSGNode()->accept(fv);
+
+      if (fv.mFoundNode == nullptr || fv.mLOD == nullptr)
+      {
+         return false;
+      }
+
+      AddCellUpdate(cell, cellIndex, fv.mFoundNode, fv.mLOD, dirtyCells);
+      return true;
+   }
+
+   void VoxelBlock::AddCellUpdate(VoxelCell* cell, const osg::Vec3i& cellIndex, osg::Group* nodeToUpdate, osg::PagedLOD* lod, std::list<VoxelCellUpdateInfo>& dirtyCells)
+   {
+      lod->setNumChildrenThatCannotBeExpired(lod->getNumChildren());
+
+      VoxelCellUpdateInfo updateInfo;
+      updateInfo.mBlock = this;
+      updateInfo.mCell = cell;
+      updateInfo.mNodeToUpdate = nodeToUpdate;
+      updateInfo.mCellIndex = cellIndex;
+      updateInfo.mStarted = false;
+      updateInfo.mLODNode = lod;
+
+      cell->SetDirty(true);
+
+      dirtyCells.push_back(updateInfo);
+   }
+
+
    void VoxelBlock::RegenerateCell(VoxelActor& voxelActor, VoxelCell* cell, osg::Group* nodeToUpdate, const osg::Vec3i& cellIndex, const osg::Vec3i& textureResolution, float viewDistance)
    {
       //std::cout << "Voxel Block, regenerate cell" << std::endl;
@@ -254,7 +254,7 @@ namespace dtVoxel
 
    bool VoxelCell::RunTask(bool allowBackgroundThreading)
    {
-      if (!mImpl->mCreateMeshTask->IsDone())
+      if (mImpl->mCreateMeshTask->NeedsUpdate())
       {
          if (allowBackgroundThreading)
          {
@@ -269,6 +269,16 @@ namespace dtVoxel
       return false;
    }
 
+   bool VoxelCell::GetPendingMeshBounds(osg::BoundingBox& bbOut) const
+   {
+      return mImpl->mCreateMeshTask.valid() && mImpl->mCreateMeshTask->GetPendingBounds(bbOut);
+   }
+
+   double VoxelCell::GetLastRemeshedVolume() const
+   {
+      return mImpl->mCreateMeshTask.valid() ? mImpl->mCreateMeshTask->GetLastRemeshedVolume() : 0.0;
+   }
+
    void VoxelCell::TakeGeometry()
    {
       mImpl->mMeshNode = new osg::Group();
@@ -68,6 +68,8 @@ namespace dtVoxel
       , mBlockVisibility()
       , mDirtyCells()
       , mBlocks(nullptr)
+      , mNumEdits(0U)
+      , mRemeshedVolume(0.0)
    {
    }
 
@@ -133,6 +135,33 @@ namespace dtVoxel
    }
 
    void VoxelGrid::MarkDirtyAABB(const osg::BoundingBox& bb)
+   {
+      ++mNumEdits;
+      CollectDirtyCells(bb);
+   }
+
+   unsigned VoxelGrid::GetNumEdits() const
+   {
+      return mNumEdits;
+   }
+
+   double VoxelGrid::GetRemeshedVolume() const
+   {
+      return mRemeshedVolume;
+   }
+
+   double VoxelGrid::GetRemeshedVolumePerEdit() const
+   {
+      return mNumEdits > 0U ? mRemeshedVolume / double(mNumEdits) : 0.0;
+   }
+
+   void VoxelGrid::ResetRemeshStatistics()
+   {
+      mNumEdits = 0U;
+      mRemeshedVolume = 0.0;
+   }
+
+   void VoxelGrid::CollectDirtyCells(const osg::BoundingBox& bb)
    {            
       //std::cout << "Mark Dirty AABB, offset " << mGridOffset << std::endl;
       osg::BoundingBox bounds(mGridOffset, mGridOffset + mWSDimensions);
@@ -181,6 +210,8 @@ namespace dtVoxel
       std::list<VoxelCellUpdateInfo>::iterator iter = mDirtyCells.begin();
       std::list<VoxelCellUpdateInfo>::iterator iterEnd = mDirtyCells.end();
 
+      std::list<VoxelCellUpdateInfo> requeuedCells;
+
       for (; iter != iterEnd;)
       {
          VoxelCellUpdateInfo& updateInfo = *iter;
@@ -188,6 +219,15 @@ namespace dtVoxel
          if (updateInfo.mStarted && updateInfo.mCell->CheckTaskStatus())
          {
             updateInfo.mBlock->RegenerateCell(*mVoxelActor, updateInfo.mCell, updateInfo.mNodeToUpdate.get(), updateInfo.mCellIndex, mDynamicResolution, mViewDistance);
+            mRemeshedVolume += updateInfo.mCell->GetLastRemeshedVolume();
+
+            // Edits that came in while the mesh was being made missed it, so the cell has to go around again.
+            // The task already holds those edits, so only this cell is queued, and the bounds aren't passed in again.
+            osg::BoundingBox pendingBounds;
+            if (updateInfo.mCell->GetPendingMeshBounds(pendingBounds))
+            {
+               updateInfo.mBlock->RequeueCell(updateInfo.mCell, updateInfo.mCellIndex, requeuedCells);
+            }
 
             iter = mDirtyCells.erase(iter);
          }
@@ -197,6 +237,8 @@ namespace dtVoxel
          }
       }
 
+      mDirtyCells.splice(mDirtyCells.end(), requeuedCells);
+
    }
 
    void VoxelGrid::BeginNewUpdates(const osg::Vec3& newCameraPos, unsigned maxCellsToUpdate, bool allowBackgroundThreading)
@@ -205,7 +247,7 @@ namespace dtVoxel
       for (auto iter = mDirtyCells.begin(); runCount > 0 && iter != mDirtyCells.end(); ++iter)
       {
          VoxelCellUpdateInfo& updateInfo = *iter;
-         if (updateInfo.mCell->RunTask(allowBackgroundThreading))
+         if (!updateInfo.mStarted && updateInfo.mCell->RunTask(allowBackgroundThreading))
          {
             updateInfo.mStarted = true;
             --runCount;
@@ -0,0 +1,148 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <dtABC/action.h>
+#include <dtABC/proximitytrigger.h>
+#include <dtCore/refptr.h>
+#include <dtCore/scene.h>
+#include <dtCore/spatialindex.h>
+#include <dtCore/system.h>
+#include <dtCore/transformable.h>
+
+namespace
+{
+   /// Counts the times the trigger starts it.
+   class CountingAction : public dtABC::Action
+   {
+   public:
+      CountingAction() : mNumStarts(0) {}
+
+      unsigned mNumStarts;
+
+   protected:
+      virtual ~CountingAction() {}
+
+      virtual bool OnNextStep() { return false; }
+      virtual void OnStart() { ++mNumStarts; }
+      virtual void OnPause() {}
+      virtual void OnUnPause() {}
+   };
+
+   void MoveTo(dtCore::Transformable& transformable, const osg::Vec3& position)
+   {
+      transformable.SetMatrix(osg::Matrix::translate(position));
+   }
+}
+
+class ProximityTriggerTests : public CPPUNIT_NS::TestFixture
+{
+   CPPUNIT_TEST_SUITE(ProximityTriggerTests);
+   CPPUNIT_TEST(TestIsPointInVolume);
+   CPPUNIT_TEST(TestFiresOnEnter);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void setUp()
+   {
+      mScene = new dtCore::Scene();
+      mTrigger = new dtABC::ProximityTrigger();
+      mAction = new CountingAction();
+      mTrigger->GetTrigger()->SetAction(mAction.get());
+      mTrigger->GetTrigger()->SetTimesActive(-1);
+      mScene->AddChild(mTrigger.get());
+
+      mVisitor = new dtCore::Transformable("Visitor");
+      MoveTo(*mVisitor, osg::Vec3(20.0f, 0.0f, 0.0f));
+      mScene->AddChild(mVisitor.get());
+
+      dtCore::System::GetInstance().Start();
+   }
+
+   void tearDown()
+   {
+      dtCore::System::GetInstance().Stop();
+      mScene->RemoveAllDrawables();
+      mVisitor = NULL;
+      mAction = NULL;
+      mTrigger = NULL;
+      mScene = NULL;
+   }
+
+   void TestIsPointInVolume()
+   {
+      CPPUNIT_ASSERT_EQUAL(5.0f, mTrigger->GetRadius());
+      CPPUNIT_ASSERT(mTrigger->IsPointInVolume(4.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(!mTrigger->IsPointInVolume(6.0f, 0.0f, 0.0f));
+
+      mTrigger->SetRadius(10.0f);
+      CPPUNIT_ASSERT_EQUAL(10.0f, mTrigger->GetRadius());
+      CPPUNIT_ASSERT(mTrigger->IsPointInVolume(6.0f, 0.0f, 0.0f));
+
+      // The sphere is centered on the trigger.
+      MoveTo(*mTrigger, osg::Vec3(20.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(!mTrigger->IsPointInVolume(6.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(mTrigger->IsPointInVolume(15.0f, 0.0f, 0.0f));
+   }
+
+   void TestFiresOnEnter()
+   {
+      // The volume is updated on the frame synch, and the trigger starts the action on the next pre frame.
+      StepTwice();
+      CPPUNIT_ASSERT_EQUAL(0U, mAction->mNumStarts);
+
+      MoveTo(*mVisitor, osg::Vec3(3.0f, 0.0f, 0.0f));
+      StepTwice();
+      CPPUNIT_ASSERT_EQUAL(1U, mAction->mNumStarts);
+
+      // It fires once per touch, not every frame the visitor is inside.
+      MoveTo(*mVisitor, osg::Vec3(-3.0f, 0.0f, 0.0f));
+      StepTwice();
+      CPPUNIT_ASSERT_EQUAL(1U, mAction->mNumStarts);
+
+      MoveTo(*mVisitor, osg::Vec3(-30.0f, 0.0f, 0.0f));
+      StepTwice();
+      MoveTo(*mVisitor, osg::Vec3(0.0f, 2.0f, 0.0f));
+      StepTwice();
+      CPPUNIT_ASSERT_EQUAL(2U, mAction->mNumStarts);
+
+      // Taken out of the scene, it stops watching.
+      mScene->RemoveChild(mTrigger.get());
+      CPPUNIT_ASSERT_EQUAL(0U, mScene->GetSpatialIndex().GetNumVolumes());
+   }
+
+private:
+   void StepTwice()
+   {
+      dtCore::System::GetInstance().Step(0.016f);
+      dtCore::System::GetInstance().Step(0.016f);
+   }
+
+   dtCore::RefPtr<dtCore::Scene> mScene;
+   dtCore::RefPtr<dtABC::ProximityTrigger> mTrigger;
+   dtCore::RefPtr<CountingAction> mAction;
+   dtCore::RefPtr<dtCore::Transformable> mVisitor;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ProximityTriggerTests);
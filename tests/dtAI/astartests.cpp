@@ -25,6 +25,11 @@
 #include <prefix/unittestprefix.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "testastarutils.h"
+#include <dtCore/timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
 #include <list>
 
 using namespace dtAI;
@@ -38,6 +43,84 @@ dtAI::PathCostData* dtAI::PathCostData::sCostData = NULL;
 typedef std::list<float> PATH;
 //////////////////////////////////////////////////////////////////////////
 
+namespace dtTest
+{
+   /**
+    * An eight connected grid with some cells blocked, for benchmarking AStar on a large graph.
+    */
+   class AStarTestGrid
+   {
+   public:
+      AStarTestGrid(unsigned size, unsigned blockedPercent, unsigned seed)
+         : mSize(size)
+         , mNeighbors(size * size)
+         , mBlocked(size * size, false)
+      {
+         srand(seed);
+         for (unsigned i = 0; i < mBlocked.size(); ++i)
+         {
+            mBlocked[i] = unsigned(rand() % 100) < blockedPercent;
+         }
+
+         for (unsigned i = 0; i < mNeighbors.size(); ++i)
+         {
+            if (mBlocked[i]) continue;
+
+            int x = int(i % size), y = int(i / size);
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+               for (int dx = -1; dx <= 1; ++dx)
+               {
+                  int nx = x + dx, ny = y + dy;
+                  if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= int(size) || ny >= int(size)) continue;
+
+                  unsigned neighbor = unsigned(ny) * size + unsigned(nx);
+                  if (!mBlocked[neighbor])
+                  {
+                     mNeighbors[i].push_back(neighbor);
+                  }
+               }
+            }
+         }
+      }
+
+      float Distance(unsigned from, unsigned to) const
+      {
+         float dx = float(from % mSize) - float(to % mSize);
+         float dy = float(from / mSize) - float(to / mSize);
+         return std::sqrt(dx * dx + dy * dy);
+      }
+
+      unsigned mSize;
+      std::vector<std::vector<unsigned> > mNeighbors;
+      std::vector<bool> mBlocked;
+
+      static AStarTestGrid* sGrid;
+   };
+
+   AStarTestGrid* AStarTestGrid::sGrid = NULL;
+
+   class GridNode: public AStarNode<GridNode, unsigned, std::vector<unsigned>::const_iterator, float>
+   {
+   public:
+      GridNode(node_type* pParent, unsigned pData, cost_type pGn, cost_type pHn): BaseType(pParent, pData, pGn, pHn){}
+
+      /*virtual*/ iterator begin() const { return AStarTestGrid::sGrid->mNeighbors[mData].begin(); }
+      /*virtual*/ iterator end() const { return AStarTestGrid::sGrid->mNeighbors[mData].end(); }
+   };
+
+   class GridCostFunc: public AStarCostFunc<unsigned, float>
+   {
+   public:
+      float operator()(unsigned pIn1, unsigned pIn2) const
+      {
+         return AStarTestGrid::sGrid->Distance(pIn1, pIn2);
+      }
+   };
+
+   typedef AStar<GridNode, GridCostFunc, std::list<unsigned>, AStarTimer > GridAStar;
+}
+
 
 namespace dtTest
 {
@@ -47,6 +130,8 @@ namespace dtTest
       CPPUNIT_TEST(TestCreatePath);
       CPPUNIT_TEST(TestCreatePathVector);
       CPPUNIT_TEST(TestNavMesh);
+      CPPUNIT_TEST(TestGridPath);
+      //CPPUNIT_TEST(TestGridPathPerformance); //disabled - just used for benchmarking
       CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -58,6 +143,8 @@ namespace dtTest
       void TestCreatePath();
       void TestCreatePathVector();
       void TestNavMesh();
+      void TestGridPath();
+      void TestGridPathPerformance();
 
    private:
       void PrintStats(const TestAStar::config_type& pConfig);
@@ -346,4 +433,84 @@ namespace dtTest
       std::cout << "Total Cost: " << pConfig.mTotalCost << std::endl << std::endl;*/
    }
 
+   void AStarTests::TestGridPath()
+   {
+      // no blocked cells, so the cost along the diagonal is known
+      AStarTestGrid grid(20, 0, 1);
+      AStarTestGrid::sGrid = &grid;
+
+      GridAStar astar;
+      astar.Reset(0, 399);
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, astar.FindPath());
+      CPPUNIT_ASSERT_EQUAL(size_t(20), astar.GetPath().size());
+      CPPUNIT_ASSERT(dtUtil::Equivalent(19.0f * std::sqrt(2.0f), astar.GetConfig().mTotalCost, 0.001f));
+
+      // the same search again should reuse the node memory
+      unsigned nodesCreated = astar.GetNodePool().GetNumAllocated();
+      unsigned capacity = astar.GetNodePool().GetCapacity();
+      CPPUNIT_ASSERT(nodesCreated > 0);
+
+      astar.Reset(0, 399);
+      CPPUNIT_ASSERT_EQUAL(1U, astar.GetNodePool().GetNumAllocated());
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, astar.FindPath());
+      CPPUNIT_ASSERT_EQUAL(nodesCreated, astar.GetNodePool().GetNumAllocated());
+      CPPUNIT_ASSERT_EQUAL(capacity, astar.GetNodePool().GetCapacity());
+
+      // a wall with a gap at the far end forces a detour
+      for (unsigned y = 0; y < 19; ++y)
+      {
+         grid.mNeighbors[y * 20 + 10].clear();
+         for (unsigned i = 0; i < grid.mNeighbors.size(); ++i)
+         {
+            std::vector<unsigned>& n = grid.mNeighbors[i];
+            n.erase(std::remove(n.begin(), n.end(), y * 20 + 10), n.end());
+         }
+      }
+
+      astar.Reset(20 * 5 + 2, 20 * 5 + 17);
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, astar.FindPath());
+      const std::list<unsigned>& path = astar.GetPath();
+      CPPUNIT_ASSERT(std::find(path.begin(), path.end(), 19U * 20U + 10U) != path.end());
+
+      AStarTestGrid::sGrid = NULL;
+   }
+
+   void AStarTests::TestGridPathPerformance()
+   {
+      // about 50k nodes
+      const unsigned size = 224;
+      const unsigned queries = 100;
+
+      AStarTestGrid grid(size, 25, 7);
+      AStarTestGrid::sGrid = &grid;
+
+      GridAStar astar;
+      dtCore::Timer timer;
+      double totalMs = 0.0, worstMs = 0.0;
+      unsigned found = 0, explored = 0;
+
+      srand(11);
+      for (unsigned i = 0; i < queries; ++i)
+      {
+         unsigned from = 0, to = 0;
+         do { from = unsigned(rand()) % (size * size); } while (grid.mBlocked[from]);
+         do { to = unsigned(rand()) % (size * size); } while (grid.mBlocked[to]);
+
+         dtCore::Timer_t start = timer.Tick();
+         astar.Reset(from, to);
+         if (astar.FindPath() == PATH_FOUND) ++found;
+         double ms = timer.DeltaMil(start, timer.Tick());
+
+         totalMs += ms;
+         worstMs = std::max(worstMs, ms);
+         explored += astar.GetConfig().mNodesExplored;
+      }
+
+      std::cout << std::endl << "AStar on a " << size << "x" << size << " grid: " << queries << " queries, "
+               << found << " found, " << (explored / queries) << " nodes explored each, "
+               << (totalMs / queries) << "ms average, " << worstMs << "ms worst." << std::endl;
+
+      AStarTestGrid::sGrid = NULL;
+   }
+
 } // namespace dtTest
@@ -0,0 +1,389 @@
+/* -*-c++-*-
+* allTests - This source file (.h & .cpp) - Using 'The MIT License'
+* Copyright (C) 2014, Alion Science and Technology
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <dtAI/aiactorregistry.h>
+#include <dtAI/aiinterfaceactor.h>
+#include <dtAI/aiplugininterface.h>
+#include <dtAI/pathquerycomponent.h>
+#include <dtAI/waypointgraph.h>
+#include <dtAI/waypointgraphastar.h>
+#include <dtAI/waypointgraphsnapshot.h>
+#include <dtAI/waypointtypes.h>
+
+#include <dtCore/actorfactory.h>
+#include <dtCore/refptr.h>
+#include <dtCore/scene.h>
+#include <dtCore/timer.h>
+#include <dtGame/basemessages.h>
+#include <dtGame/gamemanager.h>
+#include <dtGame/messagefactory.h>
+#include <dtGame/messagetype.h>
+#include <dtUtil/threadpool.h>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace dtAI
+{
+   class PathQueryTests : public CPPUNIT_NS::TestFixture
+   {
+      CPPUNIT_TEST_SUITE(PathQueryTests);
+      CPPUNIT_TEST(TestSnapshot);
+      CPPUNIT_TEST(TestQueries);
+      CPPUNIT_TEST(TestCancelQuery);
+      CPPUNIT_TEST(TestBackToBackBatches);
+      //CPPUNIT_TEST(TestPathQueryPerformance); //disabled - just used for benchmarking
+      CPPUNIT_TEST_SUITE_END();
+
+   public:
+      void setUp();
+      void tearDown();
+
+      void TestSnapshot();
+      void TestQueries();
+      void TestCancelQuery();
+      void TestBackToBackBatches();
+      void TestPathQueryPerformance();
+
+      void OnPathQueryResult(const PathQueryResult& result)
+      {
+         mResults.push_back(result);
+      }
+
+   private:
+      /// Makes an eight connected grid of waypoints with a wall down the middle that has a gap at the top.
+      void CreateGrid(int size);
+      void Tick();
+
+      std::vector<WaypointID> mGrid;
+      std::vector<PathQueryResult> mResults;
+      dtCore::RefPtr<AIPluginInterface> mAIInterface;
+      dtCore::RefPtr<dtGame::GameManager> mGM;
+      dtCore::RefPtr<PathQueryComponent> mComponent;
+   };
+
+   // Registers the fixture into the 'registry'
+   CPPUNIT_TEST_SUITE_REGISTRATION(PathQueryTests);
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::setUp()
+   {
+      dtCore::ActorFactory& libMan = dtCore::ActorFactory::GetInstance();
+      libMan.LoadActorRegistry("dtAI");
+      dtCore::RefPtr<dtCore::BaseActorObject> proxy = libMan.CreateActor(*AIActorRegistry::AI_INTERFACE_ACTOR_TYPE);
+      mAIInterface = dynamic_cast<dtAI::AIInterfaceActor*>(proxy.get())->GetAIInterface();
+
+      dtCore::RefPtr<dtCore::Scene> scene = new dtCore::Scene();
+      mGM = new dtGame::GameManager(*scene);
+      mComponent = new PathQueryComponent();
+      mGM->AddComponent(*mComponent, dtGame::GameManager::ComponentPriority::NORMAL);
+
+      mResults.clear();
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::tearDown()
+   {
+      mGM->RemoveComponent(*mComponent);
+      mComponent = NULL;
+      mGM = NULL;
+
+      mAIInterface->ClearMemory();
+      mAIInterface = NULL;
+      mGrid.clear();
+
+      dtCore::ActorFactory::GetInstance().UnloadActorRegistry("dtAI");
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::CreateGrid(int size)
+   {
+      mGrid.resize(size * size);
+      for (int y = 0; y < size; ++y)
+      {
+         for (int x = 0; x < size; ++x)
+         {
+            mGrid[y * size + x] = mAIInterface->CreateWaypoint(osg::Vec3(float(x), float(y), 0.0f), *WaypointTypes::DEFAULT_WAYPOINT)->GetID();
+         }
+      }
+
+      int wall = size / 2;
+      for (int y = 0; y < size; ++y)
+      {
+         for (int x = 0; x < size; ++x)
+         {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+               for (int dx = -1; dx <= 1; ++dx)
+               {
+                  int nx = x + dx, ny = y + dy;
+                  bool inWall = (x == wall || nx == wall) && (y < size - 1 || ny < size - 1);
+                  if ((dx != 0 || dy != 0) && nx >= 0 && ny >= 0 && nx < size && ny < size && !inWall)
+                  {
+                     mAIInterface->AddEdge(mGrid[y * size + x], mGrid[ny * size + nx]);
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::Tick()
+   {
+      dtCore::RefPtr<dtGame::TickMessage> tickMessage;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::TICK_LOCAL, tickMessage);
+      mComponent->ProcessMessage(*tickMessage);
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::TestSnapshot()
+   {
+      CreateGrid(10);
+
+      dtCore::RefPtr<WaypointGraphSnapshot> snapshot = new WaypointGraphSnapshot(mAIInterface->GetWaypointGraph());
+      CPPUNIT_ASSERT_EQUAL(unsigned(mGrid.size()), snapshot->GetNumWaypoints());
+
+      for (unsigned i = 0; i < mGrid.size(); ++i)
+      {
+         unsigned index = snapshot->FindIndex(mGrid[i]);
+         CPPUNIT_ASSERT(index != WaypointGraphSnapshot::INVALID_INDEX);
+         CPPUNIT_ASSERT_EQUAL(mGrid[i], snapshot->GetWaypointID(index));
+
+         WaypointGraph::ConstWaypointArray edges;
+         mAIInterface->GetWaypointGraph().GetAllEdgesFromWaypoint(mGrid[i], edges);
+         CPPUNIT_ASSERT_EQUAL(edges.size(), size_t(snapshot->GetEdgesEnd(index) - snapshot->GetEdgesBegin(index)));
+      }
+
+      WaypointID missing = mGrid.back() + 1000;
+      CPPUNIT_ASSERT_EQUAL(WaypointGraphSnapshot::INVALID_INDEX, snapshot->FindIndex(missing));
+
+      // the snapshot must find paths just as good as the graph.
+      WaypointSnapshotAStar snapshotAStar;
+      snapshotAStar.SetSnapshot(snapshot.get());
+      WaypointGraphAStar graphAStar(mAIInterface->GetWaypointGraph());
+
+      std::vector<WaypointID> path;
+      WaypointGraph::ConstWaypointArray graphPath;
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, snapshotAStar.FindSingleLevelPath(mGrid[0], mGrid[9], path));
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, graphAStar.FindSingleLevelPath(mGrid[0], mGrid[9], graphPath));
+      CPPUNIT_ASSERT_EQUAL(mGrid[0], path.front());
+      CPPUNIT_ASSERT_EQUAL(mGrid[9], path.back());
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(graphAStar.GetConfig().mTotalCost, snapshotAStar.GetConfig().mTotalCost, 0.001f);
+
+      CPPUNIT_ASSERT_EQUAL(NO_PATH, snapshotAStar.FindSingleLevelPath(mGrid[0], missing, path));
+      CPPUNIT_ASSERT(path.empty());
+
+      // Changes to the graph are not seen by the snapshot.
+      CPPUNIT_ASSERT(mAIInterface->RemoveWaypoint(mAIInterface->GetWaypointById(mGrid[5])));
+      CPPUNIT_ASSERT(snapshot->FindIndex(mGrid[5]) != WaypointGraphSnapshot::INVALID_INDEX);
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::TestQueries()
+   {
+      CreateGrid(10);
+      mComponent->SetWaypointGraph(&mAIInterface->GetWaypointGraph());
+      CPPUNIT_ASSERT(mComponent->GetSnapshot() != NULL);
+
+      PathQueryCallback callback(this, &PathQueryTests::OnPathQueryResult);
+      PathQueryHandle found = mComponent->SubmitQuery(mGrid[0], mGrid[9], callback);
+      PathQueryHandle missing = mComponent->SubmitQuery(mGrid[0], mGrid.back() + 1000, callback);
+      PathQueryConfig limited;
+      limited.mMaxNodesExplored = 2;
+      PathQueryHandle partial = mComponent->SubmitQuery(mGrid[0], mGrid[9], callback, limited);
+
+      CPPUNIT_ASSERT(found != PathQueryComponent::INVALID_HANDLE);
+      CPPUNIT_ASSERT(found != missing && missing != partial);
+      CPPUNIT_ASSERT_EQUAL(3U, mComponent->GetQueueDepth());
+      CPPUNIT_ASSERT(mComponent->IsQueryPending(found));
+
+      // the first tick starts the batch, the results come on a later tick.
+      Tick();
+      CPPUNIT_ASSERT_EQUAL(0U, mComponent->GetQueueDepth());
+      CPPUNIT_ASSERT_EQUAL(3U, mComponent->GetNumQueriesInFlight());
+      CPPUNIT_ASSERT(mResults.empty());
+
+      mComponent->WaitForQueries();
+      Tick();
+
+      CPPUNIT_ASSERT_EQUAL(size_t(3), mResults.size());
+      CPPUNIT_ASSERT_EQUAL(0U, mComponent->GetNumQueriesInFlight());
+      CPPUNIT_ASSERT(!mComponent->IsQueryPending(found));
+      CPPUNIT_ASSERT_EQUAL(3U, mComponent->GetNumQueriesCompleted());
+
+      CPPUNIT_ASSERT_EQUAL(found, mResults[0].mHandle);
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, mResults[0].mResult);
+      CPPUNIT_ASSERT_EQUAL(mGrid[0], mResults[0].mPath.front());
+      CPPUNIT_ASSERT_EQUAL(mGrid[9], mResults[0].mPath.back());
+      CPPUNIT_ASSERT(mResults[0].mCost > 9.0f);
+      CPPUNIT_ASSERT(mResults[0].mNodesExplored > 0);
+      CPPUNIT_ASSERT(mResults[0].mSearchTimeMs >= 0.0);
+
+      CPPUNIT_ASSERT_EQUAL(missing, mResults[1].mHandle);
+      CPPUNIT_ASSERT_EQUAL(NO_PATH, mResults[1].mResult);
+      CPPUNIT_ASSERT(mResults[1].mPath.empty());
+
+      CPPUNIT_ASSERT_EQUAL(partial, mResults[2].mHandle);
+      CPPUNIT_ASSERT_EQUAL(PARTIAL_PATH, mResults[2].mResult);
+
+      // Queries on a graph that was removed don't find anything.
+      mComponent->SetWaypointGraph(NULL);
+      mResults.clear();
+      mComponent->SubmitQuery(mGrid[0], mGrid[9], callback);
+      Tick();
+      mComponent->WaitForQueries();
+      Tick();
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mResults.size());
+      CPPUNIT_ASSERT_EQUAL(NO_PATH, mResults[0].mResult);
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::TestCancelQuery()
+   {
+      CreateGrid(10);
+      mComponent->SetWaypointGraph(&mAIInterface->GetWaypointGraph());
+
+      PathQueryCallback callback(this, &PathQueryTests::OnPathQueryResult);
+      PathQueryHandle queued = mComponent->SubmitQuery(mGrid[0], mGrid[9], callback);
+      PathQueryHandle running = mComponent->SubmitQuery(mGrid[0], mGrid[99], callback);
+      PathQueryHandle kept = mComponent->SubmitQuery(mGrid[9], mGrid[90], callback);
+
+      CPPUNIT_ASSERT(mComponent->CancelQuery(queued));
+      CPPUNIT_ASSERT(!mComponent->CancelQuery(queued));
+      CPPUNIT_ASSERT(!mComponent->IsQueryPending(queued));
+      CPPUNIT_ASSERT_EQUAL(2U, mComponent->GetQueueDepth());
+
+      Tick();
+      CPPUNIT_ASSERT(mComponent->CancelQuery(running));
+      CPPUNIT_ASSERT(!mComponent->IsQueryPending(running));
+      CPPUNIT_ASSERT(mComponent->IsQueryPending(kept));
+
+      mComponent->WaitForQueries();
+      Tick();
+
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mResults.size());
+      CPPUNIT_ASSERT_EQUAL(kept, mResults[0].mHandle);
+      CPPUNIT_ASSERT_EQUAL(PATH_FOUND, mResults[0].mResult);
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::TestBackToBackBatches()
+   {
+      CreateGrid(20);
+      mComponent->SetWaypointGraph(&mAIInterface->GetWaypointGraph());
+
+      unsigned oldNumThreads = dtUtil::ThreadPool::IsInitialized() ? dtUtil::ThreadPool::GetNumImmediateWorkerThreads() : 0;
+      bool wasInitialized = dtUtil::ThreadPool::IsInitialized();
+      dtUtil::ThreadPool::Shutdown();
+      dtUtil::ThreadPool::Init(4);
+
+      PathQueryCallback callback(this, &PathQueryTests::OnPathQueryResult);
+      std::vector<PathQueryHandle> handles;
+
+      // Queries are submitted every tick without waiting, so a batch often starts on the same tick
+      // the one before it is delivered, while the pool may still be finishing its tasks.
+      srand(5);
+      for (unsigned t = 0; t < 200; ++t)
+      {
+         for (unsigned i = 0; i < 16; ++i)
+         {
+            handles.push_back(mComponent->SubmitQuery(mGrid[rand() % mGrid.size()], mGrid[rand() % mGrid.size()], callback));
+         }
+         Tick();
+      }
+
+      for (unsigned t = 0; t < 1000 && mResults.size() < handles.size(); ++t)
+      {
+         mComponent->WaitForQueries();
+         Tick();
+      }
+
+      dtUtil::ThreadPool::Shutdown();
+      if (wasInitialized)
+      {
+         dtUtil::ThreadPool::Init(oldNumThreads);
+      }
+
+      // Each result is delivered once, in the order submitted.
+      CPPUNIT_ASSERT_EQUAL(handles.size(), mResults.size());
+      for (unsigned i = 0; i < handles.size(); ++i)
+      {
+         CPPUNIT_ASSERT_EQUAL(handles[i], mResults[i].mHandle);
+      }
+   }
+
+   /////////////////////////////////////////////////////////////
+   void PathQueryTests::TestPathQueryPerformance()
+   {
+      const int size = 150;
+      const unsigned queries = 2000;
+      const unsigned threadCounts[] = { 1, 2, 4, 8 };
+
+      CreateGrid(size);
+      mComponent->SetWaypointGraph(&mAIInterface->GetWaypointGraph());
+
+      unsigned oldNumThreads = dtUtil::ThreadPool::IsInitialized() ? dtUtil::ThreadPool::GetNumImmediateWorkerThreads() : 0;
+      bool wasInitialized = dtUtil::ThreadPool::IsInitialized();
+
+      PathQueryCallback callback(this, &PathQueryTests::OnPathQueryResult);
+      dtCore::Timer timer;
+
+      std::cout << std::endl;
+      for (unsigned t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+      {
+         dtUtil::ThreadPool::Shutdown();
+         dtUtil::ThreadPool::Init(threadCounts[t]);
+         mComponent->SetMaxWorkers(threadCounts[t]);
+         mComponent->ResetStatistics();
+         mResults.clear();
+
+         srand(17);
+         dtCore::Timer_t start = timer.Tick();
+         for (unsigned i = 0; i < queries; ++i)
+         {
+            mComponent->SubmitQuery(mGrid[rand() % mGrid.size()], mGrid[rand() % mGrid.size()], callback);
+         }
+
+         unsigned peakQueueDepth = mComponent->GetQueueDepth();
+         while (mResults.size() < queries)
+         {
+            Tick();
+            mComponent->WaitForQueries();
+         }
+         double seconds = timer.DeltaSec(start, timer.Tick());
+
+         std::cout << threadCounts[t] << " worker threads: " << (double(queries) / seconds) << " paths per second, queue depth "
+                  << peakQueueDepth << ", search " << mComponent->GetAverageSearchTimeMs() << "ms average "
+                  << mComponent->GetMaxSearchTimeMs() << "ms worst, latency " << mComponent->GetAverageLatencyMs() << "ms average." << std::endl;
+      }
+
+      dtUtil::ThreadPool::Shutdown();
+      if (wasInitialized)
+      {
+         dtUtil::ThreadPool::Init(oldNumThreads);
+      }
+   }
+
+} // namespace dtAI
@@ -27,10 +27,16 @@
 
 #include "testplannerutils.h"
 #include <dtAI/basenpc.h>
+#include <dtAI/basenpcutils.h>
 #include <dtAI/npcparser.h>
+#include <dtAI/planner.h>
 #include <dtCore/refptr.h>
+#include <dtCore/timer.h>
 #include <dtUtil/datapathutils.h>
 
+#include <iostream>
+#include <sstream>
+
 using namespace dtAI;
 
 
@@ -41,6 +47,9 @@ namespace dtTest
       CPPUNIT_TEST_SUITE(PlannerTests);
          CPPUNIT_TEST(TestCreatePlan);
          CPPUNIT_TEST(TestPlannerScript);
+         CPPUNIT_TEST(TestWorldStateSchema);
+         CPPUNIT_TEST(TestPlannerClosedSetAndPool);
+         //CPPUNIT_TEST(TestPlannerPerformance); //disabled - just used for benchmarking
       CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -49,9 +58,23 @@ namespace dtTest
 
       void TestCreatePlan();
       void TestPlannerScript();
+      void TestWorldStateSchema();
+      void TestPlannerClosedSetAndPool();
+      void TestPlannerPerformance();
 
    private:
 
+      /**
+       * Adds numVars bool variables, all false, and an operator to set and one to clear each.  Setting
+       * a variable requires the one before it to be set, so the goal of setting them all takes numVars steps.
+       */
+      void SetupChainProblem(PlannerHelper& helper, unsigned numVars);
+
+      float ChainRemainingCost(const WorldState* pWS) const;
+      bool ChainIsDesiredState(const WorldState* pWS) const;
+
+      std::vector<std::string> mChainVarNames;
+
       void VerifyPlan(std::list<const Operator*>& pPlan, bool pCallGrandma);
 
    };
@@ -113,6 +136,203 @@ namespace dtTest
       VerifyPlan(pOperators, true);
    }
 
+   void PlannerTests::TestWorldStateSchema()
+   {
+      dtCore::RefPtr<WorldStateSchema> schema = new WorldStateSchema();
+      unsigned hungrySlot = schema->AddVariable("Hungry");
+      unsigned foodSlot = schema->AddVariable("Food");
+      CPPUNIT_ASSERT_EQUAL(hungrySlot, schema->AddVariable("Hungry"));
+      CPPUNIT_ASSERT_EQUAL(2U, schema->GetNumSlots());
+      CPPUNIT_ASSERT_EQUAL(foodSlot, schema->GetSlot("Food"));
+      CPPUNIT_ASSERT_EQUAL(WorldStateSchema::INVALID_SLOT, schema->GetSlot("Sleepy"));
+      CPPUNIT_ASSERT_EQUAL(std::string("Food"), schema->GetName(foodSlot));
+
+      WorldState ws(*schema);
+      CPPUNIT_ASSERT(ws.GetSchema() == schema.get());
+      CPPUNIT_ASSERT(ws.GetState("Hungry") == NULL);
+      ws.AddState("Hungry", new StateVar<bool>(true));
+      ws.AddState("Food", new StateVar<unsigned>(2U));
+      CPPUNIT_ASSERT(ws.GetStateInSlot(hungrySlot) == ws.GetState("Hungry"));
+
+      WorldState copy(ws);
+      CPPUNIT_ASSERT(copy.GetSchema() == schema.get());
+      CPPUNIT_ASSERT(copy == ws);
+      CPPUNIT_ASSERT_EQUAL(ws.GetHash(), copy.GetHash());
+
+      StateVar<unsigned>* food = GetWorldStateVariable<unsigned>(&copy, "Food");
+      CPPUNIT_ASSERT(food != NULL);
+      food->Set(1U);
+      CPPUNIT_ASSERT(copy != ws);
+
+      // Assigning a state of the same schema reuses the variables.
+      copy = ws;
+      CPPUNIT_ASSERT(copy == ws);
+      CPPUNIT_ASSERT_MESSAGE("The variable should have been assigned in place.",
+               GetWorldStateVariable<unsigned>(&copy, "Food") == food);
+      CPPUNIT_ASSERT_EQUAL(2U, food->Get());
+
+      // The cost isn't part of the state.
+      copy.AddCost(3.0f);
+      CPPUNIT_ASSERT(copy == ws);
+
+      // A new name doesn't change the shared schema.
+      copy.AddState("Sleepy", new StateVar<bool>(false));
+      CPPUNIT_ASSERT(copy.GetSchema() != schema.get());
+      CPPUNIT_ASSERT_EQUAL(2U, schema->GetNumSlots());
+      CPPUNIT_ASSERT(ws.GetState("Sleepy") == NULL);
+      CPPUNIT_ASSERT(copy.GetState("Sleepy") != NULL);
+      CPPUNIT_ASSERT(copy != ws);
+
+      // States built without a schema compare by name, whatever order the variables were added in.
+      WorldState byName;
+      byName.AddState("Food", new StateVar<unsigned>(2U));
+      byName.AddState("Hungry", new StateVar<bool>(true));
+      CPPUNIT_ASSERT(byName.GetSchema() != schema.get());
+      CPPUNIT_ASSERT(byName == ws);
+      CPPUNIT_ASSERT(ws == byName);
+      CPPUNIT_ASSERT_EQUAL(ws.GetHash(), byName.GetHash());
+
+      WorldState::StateVarMapping mapping;
+      byName.GetStateVariables(mapping);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), mapping.size());
+      CPPUNIT_ASSERT(mapping["Hungry"] == byName.GetState("Hungry"));
+   }
+
+   void PlannerTests::SetupChainProblem(PlannerHelper& helper, unsigned numVars)
+   {
+      mChainVarNames.clear();
+      for (unsigned i = 0; i < numVars; ++i)
+      {
+         std::ostringstream ss;
+         ss << "Var" << i;
+         mChainVarNames.push_back(ss.str());
+      }
+
+      dtCore::RefPtr<WorldStateSchema> schema = new WorldStateSchema();
+      for (unsigned i = 0; i < numVars; ++i)
+      {
+         schema->AddVariable(mChainVarNames[i]);
+      }
+
+      WorldState initialState(*schema);
+      for (unsigned i = 0; i < numVars; ++i)
+      {
+         const std::string& name = mChainVarNames[i];
+         initialState.AddState(name, new StateVariable(false));
+
+         NPCOperator* setOp = new NPCOperator("Set" + name);
+         setOp->SetCost(1.0f);
+         if (i > 0)
+         {
+            setOp->AddPreCondition(new Precondition(mChainVarNames[i - 1], true));
+         }
+         setOp->AddEffect(new NPCOperator::EffectType(name, true));
+         helper.AddOperator(setOp);
+
+         NPCOperator* clearOp = new NPCOperator("Clear" + name);
+         clearOp->SetCost(1.0f);
+         clearOp->AddPreCondition(new Precondition(name, true));
+         clearOp->AddEffect(new NPCOperator::EffectType(name, false));
+         helper.AddOperator(clearOp);
+      }
+
+      helper.SetCurrentState(initialState);
+   }
+
+   float PlannerTests::ChainRemainingCost(const WorldState* pWS) const
+   {
+      float result = 0.0f;
+      for (unsigned i = 0; i < mChainVarNames.size(); ++i)
+      {
+         const StateVariable* var = GetWorldStateVariable<bool>(pWS, mChainVarNames[i]);
+         if (!var->Get())
+         {
+            result += 1.0f;
+         }
+      }
+      // Underestimate so there is something to search.
+      return result * 0.5f;
+   }
+
+   bool PlannerTests::ChainIsDesiredState(const WorldState* pWS) const
+   {
+      return ChainRemainingCost(pWS) == 0.0f;
+   }
+
+   void PlannerTests::TestPlannerClosedSetAndPool()
+   {
+      const unsigned numVars = 6;
+      PlannerHelper helper(PlannerHelper::RemainingCostFunctor(this, &PlannerTests::ChainRemainingCost),
+               PlannerHelper::DesiredStateFunctor(this, &PlannerTests::ChainIsDesiredState));
+      SetupChainProblem(helper, numVars);
+
+      Planner planner;
+      planner.Reset(&helper);
+      CPPUNIT_ASSERT_EQUAL(Planner::PLAN_FOUND, planner.GeneratePlan());
+
+      Planner::OperatorVector plan = planner.GetPlanAsVector();
+      CPPUNIT_ASSERT_EQUAL(size_t(numVars), plan.size());
+      for (unsigned i = 0; i < numVars; ++i)
+      {
+         CPPUNIT_ASSERT_EQUAL("Set" + mChainVarNames[i], plan[i]->GetName());
+      }
+
+      // Each of the 2^6 states can be expanded at most once.
+      unsigned numExpanded = planner.GetNumNodesExpanded();
+      CPPUNIT_ASSERT(numExpanded > 0U);
+      CPPUNIT_ASSERT(numExpanded <= 64U);
+
+      // Planning again uses the pooled nodes.
+      unsigned numPooled = planner.GetNumPooledNodes();
+      CPPUNIT_ASSERT(numPooled > 0U);
+      planner.Reset(&helper);
+      CPPUNIT_ASSERT_EQUAL(Planner::PLAN_FOUND, planner.GeneratePlan());
+      CPPUNIT_ASSERT_EQUAL(numPooled, planner.GetNumPooledNodes());
+      CPPUNIT_ASSERT_EQUAL(numExpanded, planner.GetNumNodesExpanded());
+      CPPUNIT_ASSERT_EQUAL(size_t(numVars), planner.GetPlan().size());
+
+      // Trimming keeps only what is in use, the nodes of the last search.
+      planner.TrimNodePool();
+      CPPUNIT_ASSERT_EQUAL(numPooled, planner.GetNumPooledNodes());
+      planner.Reset(&helper);
+      planner.TrimNodePool();
+      CPPUNIT_ASSERT_EQUAL(1U, planner.GetNumPooledNodes());
+
+      // Nothing sets the first variable, so the search has to run out of states.
+      Operator* setFirst = const_cast<Operator*>(helper.GetOperator("SetVar0"));
+      helper.RemoveOperator(setFirst);
+      delete setFirst;
+      planner.Reset(&helper);
+      CPPUNIT_ASSERT_EQUAL(Planner::NO_PLAN, planner.GeneratePlan());
+      CPPUNIT_ASSERT_EQUAL(1U, planner.GetNumNodesExpanded());
+   }
+
+   void PlannerTests::TestPlannerPerformance()
+   {
+      // 32 operators
+      const unsigned numVars = 16;
+      const unsigned numPlans = 20;
+
+      PlannerHelper helper(PlannerHelper::RemainingCostFunctor(this, &PlannerTests::ChainRemainingCost),
+               PlannerHelper::DesiredStateFunctor(this, &PlannerTests::ChainIsDesiredState));
+      SetupChainProblem(helper, numVars);
+
+      Planner planner;
+      dtCore::Timer timer;
+      dtCore::Timer_t start = timer.Tick();
+      for (unsigned i = 0; i < numPlans; ++i)
+      {
+         planner.Reset(&helper);
+         CPPUNIT_ASSERT_EQUAL(Planner::PLAN_FOUND, planner.GeneratePlan());
+         CPPUNIT_ASSERT_EQUAL(size_t(numVars), planner.GetPlan().size());
+      }
+      double totalTime = timer.DeltaSec(start, timer.Tick());
+
+      std::cout << std::endl << "Planning with " << helper.GetOperators().size() << " operators expanded "
+               << planner.GetNumNodesExpanded() << " nodes using " << planner.GetNumPooledNodes()
+               << " pooled nodes in " << (totalTime / numPlans) * 1000.0 << " ms per plan" << std::endl;
+   }
+
    void PlannerTests::VerifyPlan(std::list<const Operator*>& pOperators, bool pCallGrandma)
    {
       if (pCallGrandma)
@@ -30,6 +30,7 @@
 #include <dtAI/waypointgraphbuilder.h>
 #include <dtAI/waypointtypes.h>
 #include <dtAI/waypointgraphastar.h>
+#include <dtAI/hierarchicalpathfinder.h>
 #include <dtAI/aiplugininterface.h>
 #include <dtAI/aiinterfaceactor.h>
 #include <dtAI/aiactorregistry.h>
@@ -37,8 +38,11 @@
 #include <dtCore/project.h>
 
 #include <dtCore/refptr.h>
+#include <dtCore/timer.h>
 #include <dtUtil/mathdefines.h>
 #include <algorithm>
+#include <cstdlib>
+#include <iostream>
 
 namespace dtAI
 {
@@ -57,6 +61,10 @@ namespace dtAI
       CPPUNIT_TEST(TestLoadSave);
       CPPUNIT_TEST(TestClearMemory);
       CPPUNIT_TEST(TestAddDuplicates);
+      CPPUNIT_TEST(TestHierarchicalPathfinder);
+      CPPUNIT_TEST(TestHierarchicalPathfinderInvalidation);
+      //CPPUNIT_TEST(TestPathfindingPerformance); //disabled - just used for benchmarking
+      //CPPUNIT_TEST(TestHierarchicalPathfindingPerformance); //disabled - just used for benchmarking
       CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -75,9 +83,16 @@ namespace dtAI
       void TestCollectionBounds();
       void TestAddDuplicates();
       void TestTreeTraversal();
+      void TestPathfindingPerformance();
+      void TestHierarchicalPathfinder();
+      void TestHierarchicalPathfinderInvalidation();
+      void TestHierarchicalPathfindingPerformance();
 
    private:
       void CreateWaypoints();
+      void CheckPath(WaypointID from, WaypointID to, const WaypointGraph::ConstWaypointArray& path);
+      float GetPathCost(const WaypointGraph::ConstWaypointArray& path);
+      bool PathContains(const WaypointGraph::ConstWaypointArray& path, WaypointID id);
 
       std::vector<WaypointID> wpArray;
       dtCore::RefPtr<WaypointGraph> mGraph;
@@ -741,5 +756,312 @@ void WaypointGraphTests::TestAddDuplicates()
 
 }
 
+void WaypointGraphTests::TestPathfindingPerformance()
+{
+   mAIInterface->ClearMemory();
+
+   // an eight connected grid of about 50k waypoints
+   const int size = 224;
+   const unsigned queries = 100;
+
+   std::vector<WaypointID> grid(size * size);
+   for (int y = 0; y < size; ++y)
+   {
+      for (int x = 0; x < size; ++x)
+      {
+         grid[y * size + x] = mAIInterface->CreateWaypoint(osg::Vec3(float(x), float(y), 0.0f), *WaypointTypes::DEFAULT_WAYPOINT)->GetID();
+      }
+   }
+
+   for (int y = 0; y < size; ++y)
+   {
+      for (int x = 0; x < size; ++x)
+      {
+         for (int dy = -1; dy <= 1; ++dy)
+         {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+               int nx = x + dx, ny = y + dy;
+               if ((dx != 0 || dy != 0) && nx >= 0 && ny >= 0 && nx < size && ny < size)
+               {
+                  mAIInterface->AddEdge(grid[y * size + x], grid[ny * size + nx]);
+               }
+            }
+         }
+      }
+   }
+
+   // benchmark on a graph loaded from a file, the way an application gets one
+   std::string fullFilename = "./WaypointGraphTests_PathfindingPerformance.ai";
+   CPPUNIT_ASSERT(mAIInterface->SaveWaypointFile(fullFilename));
+   mAIInterface->ClearMemory();
+   CPPUNIT_ASSERT(mAIInterface->LoadWaypointFile(fullFilename));
+
+   WaypointGraphAStar astar(*mGraph);
+   WaypointGraph::ConstWaypointArray path;
+
+   dtCore::Timer timer;
+   double totalMs = 0.0, worstMs = 0.0;
+   unsigned found = 0;
+
+   srand(11);
+   for (unsigned i = 0; i < queries; ++i)
+   {
+      WaypointID from = grid[rand() % grid.size()];
+      WaypointID to = grid[rand() % grid.size()];
+
+      path.clear();
+      dtCore::Timer_t start = timer.Tick();
+      if (astar.FindSingleLevelPath(from, to, path) == PATH_FOUND) ++found;
+      double ms = timer.DeltaMil(start, timer.Tick());
+
+      totalMs += ms;
+      worstMs = std::max(worstMs, ms);
+   }
+
+   std::cout << std::endl << "AStar on a loaded WaypointGraph of " << grid.size() << " waypoints: " << queries << " queries, "
+            << found << " found, " << (totalMs / queries) << "ms average, " << worstMs << "ms worst." << std::endl;
+
+   mAIInterface->ClearMemory();
+}
+
+void WaypointGraphTests::CheckPath(WaypointID from, WaypointID to, const WaypointGraph::ConstWaypointArray& path)
+{
+   CPPUNIT_ASSERT(!path.empty());
+   CPPUNIT_ASSERT_EQUAL(from, path.front()->GetID());
+   CPPUNIT_ASSERT_EQUAL(to, path.back()->GetID());
+
+   WaypointGraph::ConstWaypointArray edges;
+   for (unsigned i = 1; i < path.size(); ++i)
+   {
+      edges.clear();
+      mGraph->GetAllEdgesFromWaypoint(path[i - 1]->GetID(), edges);
+      CPPUNIT_ASSERT_MESSAGE("Each step of the path should follow an edge.",
+               std::find(edges.begin(), edges.end(), path[i]) != edges.end());
+   }
+}
+
+float WaypointGraphTests::GetPathCost(const WaypointGraph::ConstWaypointArray& path)
+{
+   float cost = 0.0f;
+   for (unsigned i = 1; i < path.size(); ++i)
+   {
+      cost += (path[i]->GetPosition() - path[i - 1]->GetPosition()).length();
+   }
+   return cost;
+}
+
+bool WaypointGraphTests::PathContains(const WaypointGraph::ConstWaypointArray& path, WaypointID id)
+{
+   for (unsigned i = 0; i < path.size(); ++i)
+   {
+      if (path[i]->GetID() == id)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+void WaypointGraphTests::TestHierarchicalPathfinder()
+{
+   CreateWaypoints();
+
+   dtCore::RefPtr<HierarchicalPathfinder> pathfinder = new HierarchicalPathfinder(*mGraph, 1);
+   CPPUNIT_ASSERT_EQUAL(1U, pathfinder->GetClusterLevel());
+   CPPUNIT_ASSERT(pathfinder->GetUseCorridor());
+   CPPUNIT_ASSERT_EQUAL(0U, pathfinder->GetNumCachedPaths());
+
+   WaypointGraphAStar astar(*mGraph);
+   WaypointGraph::ConstWaypointArray path, flatPath;
+
+   for (int i = 1; i < 17; ++i)
+   {
+      for (int j = 1; j < 17; ++j)
+      {
+         if (i == j)
+         {
+            continue;
+         }
+
+         flatPath.clear();
+         CPPUNIT_ASSERT_EQUAL(PATH_FOUND, astar.FindSingleLevelPath(wpArray[i], wpArray[j], flatPath));
+
+         // the corridor may make the path a bit longer, but never shorter
+         pathfinder->SetUseCorridor(true);
+         CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[i], wpArray[j], path));
+         CheckPath(wpArray[i], wpArray[j], path);
+         CPPUNIT_ASSERT(GetPathCost(path) >= GetPathCost(flatPath) - 0.01f);
+         CPPUNIT_ASSERT_DOUBLES_EQUAL(GetPathCost(path), pathfinder->GetLastStatistics().mPathCost, 0.01f);
+
+         // without it the portal search is exact
+         pathfinder->SetUseCorridor(false);
+         CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[i], wpArray[j], path));
+         CheckPath(wpArray[i], wpArray[j], path);
+         CPPUNIT_ASSERT_DOUBLES_EQUAL(GetPathCost(flatPath), GetPathCost(path), 0.01f);
+      }
+   }
+
+   CPPUNIT_ASSERT(pathfinder->GetNumCachedPaths() > 0);
+
+   // the second time around the paths inside the clusters come from the cache
+   pathfinder->SetUseCorridor(true);
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[1], wpArray[14], path));
+   CPPUNIT_ASSERT_EQUAL(0U, pathfinder->GetLastStatistics().mCacheMisses);
+   CPPUNIT_ASSERT_EQUAL(0U, pathfinder->GetLastStatistics().mClusterNodesExpanded);
+   CPPUNIT_ASSERT(pathfinder->GetLastStatistics().mCacheHits > 0);
+
+   CPPUNIT_ASSERT_EQUAL(NO_PATH, pathfinder->FindPath(wpArray[1], 0xFFFFFFFF, path));
+   CPPUNIT_ASSERT(path.empty());
+
+   pathfinder->ClearCache();
+   CPPUNIT_ASSERT_EQUAL(0U, pathfinder->GetNumCachedPaths());
+
+   // rebuilding the graph drops the cache as well
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[1], wpArray[14], path));
+   CPPUNIT_ASSERT(pathfinder->GetNumCachedPaths() > 0);
+   mGraph->Clear();
+   CPPUNIT_ASSERT_EQUAL(0U, pathfinder->GetNumCachedPaths());
+}
+
+void WaypointGraphTests::TestHierarchicalPathfinderInvalidation()
+{
+   CreateWaypoints();
+
+   dtCore::RefPtr<HierarchicalPathfinder> pathfinder = new HierarchicalPathfinder(*mGraph, 1);
+   WaypointGraphAStar astar(*mGraph);
+   WaypointGraph::ConstWaypointArray path, flatPath;
+
+   // the short way from 5 to 14 goes through 7, the long way around goes through 2 and 15
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[5], wpArray[14], path));
+   CheckPath(wpArray[5], wpArray[14], path);
+   CPPUNIT_ASSERT(PathContains(path, wpArray[7]));
+
+   unsigned numCached = pathfinder->GetNumCachedPaths();
+   mAIInterface->RemoveEdge(wpArray[6], wpArray[7]);
+   mAIInterface->RemoveEdge(wpArray[7], wpArray[6]);
+   CPPUNIT_ASSERT_MESSAGE("Removing an edge should drop the cached paths of its cluster.",
+            pathfinder->GetNumCachedPaths() < numCached);
+
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[5], wpArray[14], path));
+   CheckPath(wpArray[5], wpArray[14], path);
+   CPPUNIT_ASSERT(!PathContains(path, wpArray[7]));
+   CPPUNIT_ASSERT(PathContains(path, wpArray[15]));
+
+   flatPath.clear();
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, astar.FindSingleLevelPath(wpArray[5], wpArray[14], flatPath));
+   CPPUNIT_ASSERT(GetPathCost(path) >= GetPathCost(flatPath) - 0.01f);
+
+   mAIInterface->RemoveEdge(wpArray[2], wpArray[15]);
+   mAIInterface->RemoveEdge(wpArray[15], wpArray[2]);
+   CPPUNIT_ASSERT_EQUAL(NO_PATH, pathfinder->FindPath(wpArray[5], wpArray[14], path));
+   CPPUNIT_ASSERT(path.empty());
+
+   // adding an edge back makes the short way usable again
+   mAIInterface->AddEdge(wpArray[6], wpArray[7]);
+   mAIInterface->AddEdge(wpArray[7], wpArray[6]);
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[5], wpArray[14], path));
+   CheckPath(wpArray[5], wpArray[14], path);
+   CPPUNIT_ASSERT(PathContains(path, wpArray[7]));
+
+   // and removing the waypoint closes it for good
+   mAIInterface->RemoveEdge(wpArray[6], wpArray[7]);
+   mAIInterface->RemoveEdge(wpArray[8], wpArray[7]);
+   mAIInterface->RemoveWaypoint(mAIInterface->GetWaypointById(wpArray[7]));
+   CPPUNIT_ASSERT(!mGraph->Contains(wpArray[7]));
+   CPPUNIT_ASSERT_EQUAL(NO_PATH, pathfinder->FindPath(wpArray[5], wpArray[14], path));
+   CPPUNIT_ASSERT_EQUAL(PATH_FOUND, pathfinder->FindPath(wpArray[5], wpArray[1], path));
+   CheckPath(wpArray[5], wpArray[1], path);
 }
 
+void WaypointGraphTests::TestHierarchicalPathfindingPerformance()
+{
+   mAIInterface->ClearMemory();
+
+   // an eight connected grid, small enough for the builder to make the search levels in a reasonable time
+   const int size = 100;
+   const unsigned queries = 100;
+
+   std::vector<WaypointID> grid(size * size);
+   for (int y = 0; y < size; ++y)
+   {
+      for (int x = 0; x < size; ++x)
+      {
+         grid[y * size + x] = mAIInterface->CreateWaypoint(osg::Vec3(float(x), float(y), 0.0f), *WaypointTypes::DEFAULT_WAYPOINT)->GetID();
+      }
+   }
+
+   for (int y = 0; y < size; ++y)
+   {
+      for (int x = 0; x < size; ++x)
+      {
+         for (int dy = -1; dy <= 1; ++dy)
+         {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+               int nx = x + dx, ny = y + dy;
+               if ((dx != 0 || dy != 0) && nx >= 0 && ny >= 0 && nx < size && ny < size)
+               {
+                  mAIInterface->AddEdge(grid[y * size + x], grid[ny * size + nx]);
+               }
+            }
+         }
+      }
+   }
+
+   dtCore::RefPtr<WaypointGraphBuilder> builder = new WaypointGraphBuilder(*mAIInterface, *mGraph);
+   mGraph->CreateSearchGraph(builder.get(), 10);
+
+   std::vector<std::pair<WaypointID, WaypointID> > pairs;
+   srand(11);
+   for (unsigned i = 0; i < queries; ++i)
+   {
+      pairs.push_back(std::make_pair(grid[rand() % grid.size()], grid[rand() % grid.size()]));
+   }
+
+   WaypointGraphAStar astar(*mGraph);
+   WaypointGraph::ConstWaypointArray path;
+   dtCore::Timer timer;
+
+   double flatMs = 0.0, flatCost = 0.0;
+   unsigned long flatNodes = 0;
+   for (unsigned i = 0; i < queries; ++i)
+   {
+      path.clear();
+      dtCore::Timer_t start = timer.Tick();
+      astar.FindSingleLevelPath(pairs[i].first, pairs[i].second, path);
+      flatMs += timer.DeltaMil(start, timer.Tick());
+      flatNodes += astar.GetConfig().mNodesExplored;
+      flatCost += GetPathCost(path);
+   }
+
+   std::cout << std::endl << "Flat AStar on " << grid.size() << " waypoints: " << (flatMs / queries) << "ms and "
+            << (flatNodes / queries) << " nodes expanded per query." << std::endl;
+
+   for (unsigned clusterLevel = 1; clusterLevel <= 4; ++clusterLevel)
+   {
+      dtCore::RefPtr<HierarchicalPathfinder> pathfinder = new HierarchicalPathfinder(*mGraph, clusterLevel);
+
+      // once with an empty cache and once with the paths inside the clusters cached
+      for (unsigned pass = 0; pass < 2; ++pass)
+      {
+         double ms = 0.0, cost = 0.0;
+         unsigned long nodes = 0;
+         for (unsigned i = 0; i < queries; ++i)
+         {
+            pathfinder->FindPath(pairs[i].first, pairs[i].second, path);
+            ms += pathfinder->GetLastStatistics().mSearchTimeMs;
+            nodes += pathfinder->GetLastStatistics().GetTotalNodesExpanded();
+            cost += GetPathCost(path);
+         }
+
+         std::cout << "Hierarchical, cluster level " << clusterLevel << (pass == 0 ? ", cold cache: " : ", warm cache: ")
+                  << (ms / queries) << "ms and " << (nodes / queries) << " nodes expanded per query, paths "
+                  << (100.0 * (cost - flatCost) / flatCost) << "% longer." << std::endl;
+      }
+   }
+
+   mAIInterface->ClearMemory();
+}
+
+}
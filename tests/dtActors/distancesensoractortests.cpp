@@ -38,12 +38,15 @@
 #include <dtCore/actoractorproperty.h>
 #include <dtCore/floatactorproperty.h>
 #include <dtCore/actorfactory.h>
+#include <dtCore/scene.h>
 #include <dtCore/system.h>
+#include <dtCore/transform.h>
 
 #include <dtUtil/stringutils.h>
 
 #include "../dtGame/basegmtests.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace dtActors
@@ -59,6 +62,7 @@ namespace dtActors
          CPPUNIT_TEST(TestTriggerDistanceProperty);
          CPPUNIT_TEST(TestAttachTo);
          CPPUNIT_TEST(TestRegistration);
+         CPPUNIT_TEST(TestFindTransformablesInRange);
       CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -178,6 +182,44 @@ namespace dtActors
                   !dsActor->HasRegistration(TEST_NAME));
       }
 
+      ///////////////////////////////////////////////////////////////////////////////
+      void TestFindTransformablesInRange()
+      {
+         mGM->AddActor(*mDSProxy1, false, false);
+
+         DistanceSensorActor* dsActor;
+         mDSProxy1->GetDrawable(dsActor);
+         dsActor->SetTriggerDistance(10.0f);
+
+         dtCore::RefPtr<dtCore::Transformable> nearby = new dtCore::Transformable("Nearby");
+         dtCore::RefPtr<dtCore::Transformable> farAway = new dtCore::Transformable("FarAway");
+         dtCore::Transform xform;
+         xform.SetTranslation(osg::Vec3(6.0f, 0.0f, 0.0f));
+         nearby->SetTransform(xform);
+         xform.SetTranslation(osg::Vec3(0.0f, 40.0f, 0.0f));
+         farAway->SetTransform(xform);
+         mGM->GetScene().AddChild(nearby.get());
+         mGM->GetScene().AddChild(farAway.get());
+
+         std::vector<dtCore::Transformable*> found;
+         dsActor->FindTransformablesInRange(found);
+         CPPUNIT_ASSERT(std::find(found.begin(), found.end(), nearby.get()) != found.end());
+         CPPUNIT_ASSERT(std::find(found.begin(), found.end(), farAway.get()) == found.end());
+         CPPUNIT_ASSERT_MESSAGE("The sensor shouldn't find itself.",
+                  std::find(found.begin(), found.end(), dsActor) == found.end());
+
+         // The vector isn't cleared, and a move this frame is seen right away.
+         const size_t numFound = found.size();
+         xform.SetTranslation(osg::Vec3(0.0f, 9.0f, 0.0f));
+         farAway->SetTransform(xform);
+         dsActor->FindTransformablesInRange(found);
+         CPPUNIT_ASSERT_EQUAL(2 * numFound + 1, found.size());
+         CPPUNIT_ASSERT(std::find(found.begin(), found.end(), farAway.get()) != found.end());
+
+         mGM->GetScene().RemoveChild(nearby.get());
+         mGM->GetScene().RemoveChild(farAway.get());
+      }
+
    private:
       dtCore::RefPtr<dtGame::GameActorProxy> mParentProxy;
       dtCore::RefPtr<DistanceSensorActorProxy> mDSProxy1;
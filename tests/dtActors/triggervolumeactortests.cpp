@@ -0,0 +1,225 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This software was developed by Alion Science and Technology Corporation under
+ * circumstances in which the U. S. Government may have rights in the software.
+ */
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <dtActors/engineactorregistry.h>
+#include <dtActors/triggervolumeactor.h>
+#include <dtActors/triggervolumeactorproxy.h>
+
+#include <dtCore/scene.h>
+#include <dtCore/spatialindex.h>
+#include <dtCore/system.h>
+#include <dtCore/transform.h>
+#include <dtCore/transformable.h>
+
+#include "../dtGame/basegmtests.h"
+
+#include <vector>
+
+namespace dtActors
+{
+   class TriggerVolumeActorTests : public dtGame::BaseGMTestFixture
+   {
+      CPPUNIT_TEST_SUITE(TriggerVolumeActorTests);
+         CPPUNIT_TEST(TestEnterAndLeave);
+         CPPUNIT_TEST(TestBoxVolume);
+         CPPUNIT_TEST(TestIsActorInVolume);
+         CPPUNIT_TEST(TestDeletedOccupantLeaves);
+      CPPUNIT_TEST_SUITE_END();
+
+   public:
+      ///////////////////////////////////////////////////////////////////////////////
+      void setUp() override
+      {
+         dtGame::BaseGMTestFixture::setUp();
+         try
+         {
+            mGM->CreateActor(*dtActors::EngineActorRegistry::TRIGGER_VOLUME_ACTOR_TYPE, mTriggerProxy);
+            CPPUNIT_ASSERT(mTriggerProxy.valid());
+            mTriggerProxy->GetDrawable(mTrigger);
+            CPPUNIT_ASSERT(mTrigger != NULL);
+
+            mTrigger->RegisterListener(this, TriggerVolumeActor::EventFuncType(this, &TriggerVolumeActorTests::OnTriggerEvent));
+            mGM->AddActor(*mTriggerProxy, false, false);
+
+            mVisitor = new dtCore::Transformable("Visitor");
+            MoveTo(*mVisitor, osg::Vec3(20.0f, 0.0f, 0.0f));
+            mGM->GetScene().AddChild(mVisitor.get());
+
+            dtCore::System::GetInstance().Step(0.016f);
+            mEvents.clear();
+         }
+         catch (const dtUtil::Exception& e)
+         {
+            CPPUNIT_FAIL(e.ToString());
+         }
+      }
+
+      ///////////////////////////////////////////////////////////////////////////////
+      void tearDown() override
+      {
+         if (mVisitor.valid())
+         {
+            mGM->GetScene().RemoveChild(mVisitor.get());
+         }
+         mVisitor = NULL;
+         mTrigger = NULL;
+         mTriggerProxy = NULL;
+         mEvents.clear();
+         dtGame::BaseGMTestFixture::tearDown();
+      }
+
+      ///////////////////////////////////////////////////////////////////////////////
+      void TestEnterAndLeave()
+      {
+         CPPUNIT_ASSERT(mTrigger->GetOccupants().empty());
+
+         MoveTo(*mVisitor, osg::Vec3(3.0f, 0.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(1U, CountEvents(mVisitor.get(), TriggerVolumeActor::ENTER_EVENT));
+         CPPUNIT_ASSERT_EQUAL(size_t(1), mTrigger->GetOccupants().count(mVisitor.get()));
+
+         // Moving around inside doesn't send anything.
+         MoveTo(*mVisitor, osg::Vec3(-3.0f, 1.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(1U, CountEvents(mVisitor.get(), TriggerVolumeActor::ENTER_EVENT));
+         CPPUNIT_ASSERT_EQUAL(0U, CountEvents(mVisitor.get(), TriggerVolumeActor::LEAVE_EVENT));
+
+         MoveTo(*mVisitor, osg::Vec3(-30.0f, 0.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(1U, CountEvents(mVisitor.get(), TriggerVolumeActor::LEAVE_EVENT));
+         CPPUNIT_ASSERT(mTrigger->GetOccupants().empty());
+
+         // The volume follows the actor.
+         MoveTo(*mTrigger, osg::Vec3(-28.0f, 0.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(2U, CountEvents(mVisitor.get(), TriggerVolumeActor::ENTER_EVENT));
+      }
+
+      ///////////////////////////////////////////////////////////////////////////////
+      void TestBoxVolume()
+      {
+         mTrigger->SetVolumeIsBox(true);
+         mTrigger->SetVolumeHalfExtents(osg::Vec3(2.0f, 10.0f, 2.0f));
+         CPPUNIT_ASSERT(mTrigger->GetVolume().IsBox());
+
+         // Outside the default sphere, but inside the box.
+         MoveTo(*mVisitor, osg::Vec3(0.0f, 8.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(1U, CountEvents(mVisitor.get(), TriggerVolumeActor::ENTER_EVENT));
+
+         MoveTo(*mVisitor, osg::Vec3(3.0f, 0.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(1U, CountEvents(mVisitor.get(), TriggerVolumeActor::LEAVE_EVENT));
+      }
+
+      ///////////////////////////////////////////////////////////////////////////////
+      void TestIsActorInVolume()
+      {
+         CPPUNIT_ASSERT(!mTrigger->IsActorInVolume(NULL));
+         CPPUNIT_ASSERT(!mTrigger->IsActorInVolume(mTrigger));
+         CPPUNIT_ASSERT(!mTrigger->IsActorInVolume(mVisitor.get()));
+
+         // It checks the current positions rather than waiting for the index to be updated.
+         MoveTo(*mVisitor, osg::Vec3(3.0f, 0.0f, 0.0f));
+         CPPUNIT_ASSERT(mTrigger->IsActorInVolume(mVisitor.get()));
+
+         mTrigger->SetVolumeRadius(2.0f);
+         CPPUNIT_ASSERT(!mTrigger->IsActorInVolume(mVisitor.get()));
+
+         mTrigger->SetVolumeIsBox(true);
+         mTrigger->SetVolumeHalfExtents(osg::Vec3(4.0f, 4.0f, 4.0f));
+         MoveTo(*mVisitor, osg::Vec3(3.5f, 3.5f, 3.5f));
+         CPPUNIT_ASSERT(mTrigger->IsActorInVolume(mVisitor.get()));
+         MoveTo(*mTrigger, osg::Vec3(-1.0f, 0.0f, 0.0f));
+         CPPUNIT_ASSERT(!mTrigger->IsActorInVolume(mVisitor.get()));
+      }
+
+      ///////////////////////////////////////////////////////////////////////////////
+      void TestDeletedOccupantLeaves()
+      {
+         mTrigger->SetMaxTriggerCount(1);
+
+         // Put straight into the index of the scene, so it's deleted while it's still in the index.
+         dtCore::SpatialIndex& index = mGM->GetScene().GetSpatialIndex();
+         dtCore::RefPtr<dtCore::Transformable> doomed = new dtCore::Transformable("Doomed");
+         index.Insert(*doomed);
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(1U, CountEvents(doomed.get(), TriggerVolumeActor::ENTER_EVENT));
+         CPPUNIT_ASSERT_EQUAL(size_t(1), mTrigger->GetOccupants().size());
+
+         const unsigned numVolumes = index.GetNumVolumes();
+         doomed = NULL;
+         dtCore::System::GetInstance().Step(0.016f);
+
+         CPPUNIT_ASSERT_EQUAL_MESSAGE("A deleted occupant should leave with a NULL instigator.",
+                  1U, CountEvents(NULL, TriggerVolumeActor::LEAVE_EVENT));
+         CPPUNIT_ASSERT(mTrigger->GetOccupants().empty());
+         CPPUNIT_ASSERT_EQUAL_MESSAGE("The expired trigger should leave the index once it's empty.",
+                  numVolumes - 1, index.GetNumVolumes());
+
+         // An expired trigger doesn't see anything else.
+         MoveTo(*mVisitor, osg::Vec3(1.0f, 0.0f, 0.0f));
+         dtCore::System::GetInstance().Step(0.016f);
+         CPPUNIT_ASSERT_EQUAL(0U, CountEvents(mVisitor.get(), TriggerVolumeActor::ENTER_EVENT));
+      }
+
+   private:
+      void OnTriggerEvent(dtCore::Transformable* instigator, TriggerVolumeActor::TriggerEventType eventType)
+      {
+         mEvents.push_back(std::make_pair(instigator, eventType));
+      }
+
+      unsigned CountEvents(const dtCore::Transformable* instigator, TriggerVolumeActor::TriggerEventType eventType) const
+      {
+         unsigned count = 0;
+         for (unsigned i = 0; i < mEvents.size(); ++i)
+         {
+            if (mEvents[i].first == instigator && mEvents[i].second == eventType)
+            {
+               ++count;
+            }
+         }
+         return count;
+      }
+
+      static void MoveTo(dtCore::Transformable& transformable, const osg::Vec3& position)
+      {
+         dtCore::Transform xform;
+         xform.SetTranslation(position);
+         transformable.SetTransform(xform);
+      }
+
+      dtCore::RefPtr<TriggerVolumeActorProxy> mTriggerProxy;
+      TriggerVolumeActor* mTrigger;
+      dtCore::RefPtr<dtCore::Transformable> mVisitor;
+      std::vector<std::pair<dtCore::Transformable*, TriggerVolumeActor::TriggerEventType> > mEvents;
+   };
+
+   //Registers the fixture into the 'registry'
+   CPPUNIT_TEST_SUITE_REGISTRATION(TriggerVolumeActorTests);
+} // namespace dtActors
@@ -55,6 +55,7 @@
 #include <dtCore/intactorproperty.h>
 #include <dtCore/actorfactory.h>
 #include <dtCore/map.h>
+#include <dtCore/mapbinary.h>
 #include <dtCore/mapxml.h>
 #include <dtCore/namedactorparameter.h>
 #include <dtCore/namedbooleanparameter.h>
@@ -80,10 +81,12 @@
 #include <dtCore/mapxml.h>
 
 #include <dtUtil/datapathutils.h>
+#include <dtUtil/datastream.h>
 #include <dtUtil/exception.h>
 #include <dtUtil/fileutils.h>
 #include <dtUtil/log.h>
 #include <dtUtil/mathdefines.h>
+#include <dtUtil/stringutils.h>
 #include <dtUtil/xercesutils.h>
 
 #include <cppunit/extensions/HelperMacros.h>
@@ -93,8 +96,10 @@
 #include <osg/io_utils>
 #include <osg/Math>
 
+#include <algorithm>
 #include <cstdio>
 #include <ctime>
+#include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -132,6 +137,11 @@ class MapTests : public CPPUNIT_NS::TestFixture
    CPPUNIT_TEST(TestCreateMapsMultiContext);
    CPPUNIT_TEST(TestSaveAsMultiContext);
    CPPUNIT_TEST(TestParsingMapHeaderData);
+   CPPUNIT_TEST(TestBinaryMapSaveAndLoad);
+   CPPUNIT_TEST(TestBinaryMapHeaderAndPrefab);
+   CPPUNIT_TEST(TestBinaryMapCorruptHeaderSize);
+   CPPUNIT_TEST(TestBinaryMapSaveAs);
+   //CPPUNIT_TEST(TestBinaryMapLoadPerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -165,6 +175,11 @@ public:
    void TestCreateMapsMultiContext();
    void TestSaveAsMultiContext();
    void TestParsingMapHeaderData();
+   void TestBinaryMapSaveAndLoad();
+   void TestBinaryMapHeaderAndPrefab();
+   void TestBinaryMapCorruptHeaderSize();
+   void TestBinaryMapSaveAs();
+   void TestBinaryMapLoadPerformance();
 
    static const std::string TEST_PROJECT_DIR;
    static const std::string TEST_PROJECT_DIR_2;
@@ -2199,3 +2214,316 @@ void MapTests::TestParsingMapHeaderData()
    dtCore::Project::GetInstance().DeleteMap(mapName, true);
    dtCore::Project::GetInstance().ClearAllContexts();
 }
+
+///////////////////////////////////////////////////////////////////////////////////////
+void MapTests::TestBinaryMapSaveAndLoad()
+{
+   try
+   {
+      dtCore::Project& project = dtCore::Project::GetInstance();
+
+      const std::string mapName("Binary Map");
+      const std::string mapFileName("binarymap." + dtCore::Map::MAP_BINARY_FILE_EXTENSION);
+
+      dtCore::Map* map = &project.CreateMap(mapName, mapFileName);
+      map->SetDescription("A binary map");
+      map->SetAuthor("Someone");
+      map->SetComment("Some comment");
+      map->SetCopyright("Some copyright");
+
+      dtCore::RefPtr<dtCore::GameEvent> gameEvent = new dtCore::GameEvent("Binary Event", "Saved in a binary map.");
+      map->GetEventManager().AddEvent(*gameEvent);
+
+      createActors(*map);
+
+      // The group property holds the ids of actors added after it, like TestMapSaveAndLoadActorGroups.
+      const dtCore::ActorType* at = dtCore::ActorFactory::GetInstance().FindActorType("dtcore.Tasks", "Task Actor");
+      CPPUNIT_ASSERT(at != NULL);
+      dtCore::RefPtr<dtCore::BaseActorObject> taskActor = dtCore::ActorFactory::GetInstance().CreateActor(*at);
+      map->AddProxy(*taskActor);
+      std::vector<dtCore::UniqueId> subTasks;
+      for (unsigned i = 0; i < 5; ++i)
+      {
+         dtCore::RefPtr<dtCore::BaseActorObject> subTask = dtCore::ActorFactory::GetInstance().CreateActor(*at);
+         subTasks.push_back(subTask->GetId());
+         map->AddProxy(*subTask);
+      }
+      dtCore::ArrayActorProperty<dtCore::UniqueId>* arrayProp = NULL;
+      taskActor->GetProperty("SubTaskList", arrayProp);
+      CPPUNIT_ASSERT(arrayProp != NULL);
+      arrayProp->SetValue(subTasks);
+
+      // Write the same map as xml, so the binary map can be checked against it.
+      const std::string xmlFileName = project.GetContext() + dtUtil::FileUtils::PATH_SEPARATOR + "binarymapref." + dtCore::Map::MAP_FILE_EXTENSION;
+      dtCore::RefPtr<dtCore::MapWriter> xmlWriter = new dtCore::MapWriter();
+      xmlWriter->Save(*map, xmlFileName);
+
+      const unsigned numActors = unsigned(map->GetAllProxies().size());
+      project.SaveMap(*map);
+      project.CloseMap(*map);
+
+      const std::string binaryFileName = project.GetContext() + dtUtil::FileUtils::PATH_SEPARATOR + "maps"
+         + dtUtil::FileUtils::PATH_SEPARATOR + mapFileName;
+      CPPUNIT_ASSERT_MESSAGE("The project should save a map with the binary extension in the binary format.",
+         dtCore::MapBinaryParser::IsBinaryMapFile(binaryFileName));
+      CPPUNIT_ASSERT(!dtCore::MapBinaryParser::IsBinaryMapFile(xmlFileName));
+
+      map = &project.GetMap(mapName);
+
+      dtCore::RefPtr<dtCore::MapParser> parser = new dtCore::MapParser();
+      dtCore::Map* xmlMapPtr = NULL;
+      CPPUNIT_ASSERT(parser->Parse(xmlFileName, &xmlMapPtr));
+      dtCore::MapPtr xmlMap = xmlMapPtr;
+
+      CPPUNIT_ASSERT_EQUAL(std::string("A binary map"), map->GetDescription());
+      CPPUNIT_ASSERT_EQUAL(std::string("Someone"), map->GetAuthor());
+      CPPUNIT_ASSERT_EQUAL(std::string("Some comment"), map->GetComment());
+      CPPUNIT_ASSERT_EQUAL(std::string("Some copyright"), map->GetCopyright());
+      CPPUNIT_ASSERT(map->GetAllLibraries() == xmlMap->GetAllLibraries());
+
+      dtCore::GameEvent* loadedEvent = map->GetEventManager().FindEvent(gameEvent->GetUniqueId());
+      CPPUNIT_ASSERT(loadedEvent != NULL);
+      CPPUNIT_ASSERT_EQUAL(gameEvent->GetName(), loadedEvent->GetName());
+      CPPUNIT_ASSERT_EQUAL(std::string("Saved in a binary map."), std::string(loadedEvent->GetDescription()));
+
+      CPPUNIT_ASSERT_EQUAL(numActors, unsigned(map->GetAllProxies().size()));
+      CPPUNIT_ASSERT_EQUAL(xmlMap->GetAllProxies().size(), map->GetAllProxies().size());
+
+      typedef std::map<dtCore::UniqueId, dtCore::RefPtr<dtCore::BaseActorObject> > ActorMap;
+      const ActorMap& xmlActors = xmlMap->GetAllProxies();
+      for (ActorMap::const_iterator i = xmlActors.begin(); i != xmlActors.end(); ++i)
+      {
+         dtCore::BaseActorObject* xmlActor = i->second.get();
+         dtCore::BaseActorObject* binaryActor = map->GetProxyById(i->first);
+         CPPUNIT_ASSERT_MESSAGE("Actor " + xmlActor->GetName() + " is missing from the binary map.", binaryActor != NULL);
+         CPPUNIT_ASSERT(xmlActor->GetActorType() == binaryActor->GetActorType());
+         CPPUNIT_ASSERT_EQUAL(xmlActor->GetName(), binaryActor->GetName());
+
+         std::vector<const dtCore::ActorProperty*> props;
+         xmlActor->GetPropertyList(props);
+         for (unsigned j = 0; j < props.size(); ++j)
+         {
+            const dtCore::ActorProperty* binaryProp = binaryActor->GetProperty(props[j]->GetName());
+            CPPUNIT_ASSERT(binaryProp != NULL);
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("Property " + props[j]->GetName() + " of actor type " + xmlActor->GetActorType().GetFullName()
+               + " should load the same from the binary map as from the xml map.", props[j]->ToString(), binaryProp->ToString());
+         }
+      }
+
+      taskActor = map->GetProxyById(taskActor->GetId());
+      CPPUNIT_ASSERT(taskActor.valid());
+      taskActor->GetProperty("SubTaskList", arrayProp);
+      CPPUNIT_ASSERT(subTasks == arrayProp->GetValue());
+
+      project.DeleteMap(*map, true);
+      dtUtil::FileUtils::GetInstance().FileDelete(xmlFileName);
+   }
+   catch (const dtUtil::Exception& e)
+   {
+      CPPUNIT_FAIL(std::string("Error: ") + e.ToString());
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void MapTests::TestBinaryMapHeaderAndPrefab()
+{
+   try
+   {
+      dtCore::MapPtr prefab = new dtCore::Map("test." + dtCore::Map::PREFAB_BINARY_FILE_EXTENSION, "Test Prefab");
+      prefab->SetDescription("A binary prefab");
+      prefab->SetIconFile("icon.png");
+
+      const dtCore::ActorType* at = dtCore::ActorFactory::GetInstance().FindActorType("dtcore.Tasks", "Task Actor");
+      CPPUNIT_ASSERT(at != NULL);
+      dtCore::RefPtr<dtCore::BaseActorObject> actor = dtCore::ActorFactory::GetInstance().CreateActor(*at);
+      actor->SetName("Prefab Task");
+      prefab->AddProxy(*actor);
+
+      dtUtil::DataStream stream;
+      dtCore::RefPtr<dtCore::MapBinaryWriter> writer = new dtCore::MapBinaryWriter();
+      writer->Save(*prefab, stream, true);
+
+      dtCore::RefPtr<dtCore::MapBinaryParser> parser = new dtCore::MapBinaryParser();
+
+      stream.Seekg(0, dtUtil::DataStream::SeekTypeEnum::SET);
+      dtCore::MapPtr header = parser->ParseMapHeaderData(stream, true);
+      CPPUNIT_ASSERT_EQUAL(std::string("A binary prefab"), header->GetDescription());
+      CPPUNIT_ASSERT_EQUAL(std::string("icon.png"), header->GetIconFile());
+      CPPUNIT_ASSERT(header->GetAllProxies().empty());
+
+      stream.Seekg(0, dtUtil::DataStream::SeekTypeEnum::SET);
+      dtCore::Map* loadedPtr = NULL;
+      CPPUNIT_ASSERT(parser->Parse(stream, &loadedPtr, true));
+      dtCore::MapPtr loaded = loadedPtr;
+      CPPUNIT_ASSERT(!parser->IsParsing());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), loaded->GetAllProxies().size());
+
+      dtCore::BaseActorObject* loadedActor = loaded->GetAllProxies().begin()->second.get();
+      CPPUNIT_ASSERT_EQUAL(std::string("Prefab Task"), loadedActor->GetName());
+      CPPUNIT_ASSERT_MESSAGE("Prefab actors should get new ids when they are loaded.", loadedActor->GetId() != actor->GetId());
+
+      // A truncated file should fail to parse rather than crash.
+      dtUtil::DataStream truncated(const_cast<char*>(stream.GetBuffer()), stream.GetBufferSize() / 2, false);
+      loadedPtr = NULL;
+      CPPUNIT_ASSERT_THROW(parser->Parse(truncated, &loadedPtr, true), dtCore::MapParsingException);
+      CPPUNIT_ASSERT(loadedPtr == NULL);
+      CPPUNIT_ASSERT(!parser->IsParsing());
+   }
+   catch (const dtUtil::Exception& e)
+   {
+      CPPUNIT_FAIL(std::string("Error: ") + e.ToString());
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void MapTests::TestBinaryMapCorruptHeaderSize()
+{
+   const std::string fileName("corruptheader." + dtCore::Map::MAP_BINARY_FILE_EXTENSION);
+   try
+   {
+      dtCore::MapPtr map = new dtCore::Map(fileName, "Corrupt Header");
+      map->SetDescription("A map with a bad header size");
+
+      dtUtil::DataStream stream;
+      dtCore::RefPtr<dtCore::MapBinaryWriter> writer = new dtCore::MapBinaryWriter();
+      writer->Save(*map, stream, false);
+
+      // The header size is the last field of the preamble, after the magic, version and flags.
+      const unsigned headerSizeOffset = 4 + sizeof(unsigned short) + sizeof(unsigned char);
+      const unsigned char hugeSize[] = { 0xFF, 0xFF, 0xFF, 0xFF };
+      const unsigned char largeSize[] = { 0x00, 0x00, 0x00, 0x40 };
+      const unsigned char* badSizes[] = { hugeSize, largeSize };
+
+      dtCore::RefPtr<dtCore::MapBinaryParser> parser = new dtCore::MapBinaryParser();
+      for (unsigned i = 0; i < 2; ++i)
+      {
+         std::vector<char> bytes(stream.GetBuffer(), stream.GetBuffer() + stream.GetBufferSize());
+         std::copy(badSizes[i], badSizes[i] + 4, bytes.begin() + headerSizeOffset);
+         {
+            std::ofstream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            file.write(&bytes[0], bytes.size());
+         }
+         CPPUNIT_ASSERT_THROW_MESSAGE("A header size larger than the file should fail to parse rather than wrap or allocate it.",
+            parser->ParseMapHeaderData(fileName), dtCore::MapParsingException);
+      }
+
+      // The real header size with the header cut short.
+      {
+         std::ofstream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+         file.write(stream.GetBuffer(), headerSizeOffset + sizeof(unsigned) + 2);
+      }
+      CPPUNIT_ASSERT_THROW(parser->ParseMapHeaderData(fileName), dtCore::MapParsingException);
+   }
+   catch (const dtUtil::Exception& e)
+   {
+      dtUtil::FileUtils::GetInstance().FileDelete(fileName);
+      CPPUNIT_FAIL(std::string("Error: ") + e.ToString());
+   }
+   dtUtil::FileUtils::GetInstance().FileDelete(fileName);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void MapTests::TestBinaryMapSaveAs()
+{
+   try
+   {
+      dtCore::Project& project = dtCore::Project::GetInstance();
+      dtUtil::FileUtils& fileUtils = dtUtil::FileUtils::GetInstance();
+      const std::string mapsDir = project.GetContext() + dtUtil::FileUtils::PATH_SEPARATOR + "maps" + dtUtil::FileUtils::PATH_SEPARATOR;
+
+      dtCore::Map* map = &project.CreateMap("Binary Save As", "binarysaveas." + dtCore::Map::MAP_BINARY_FILE_EXTENSION);
+      createActors(*map);
+      const size_t numActors = map->GetAllProxies().size();
+
+      // The new file name has no extension, so it should keep the binary one.
+      project.SaveMapAs(*map, "Binary Save As Copy", "binarysaveascopy");
+      CPPUNIT_ASSERT_EQUAL(std::string("binarysaveascopy." + dtCore::Map::MAP_BINARY_FILE_EXTENSION), map->GetFileName());
+
+      const std::string copyFileName = mapsDir + map->GetFileName();
+      CPPUNIT_ASSERT(fileUtils.FileExists(copyFileName));
+      CPPUNIT_ASSERT_MESSAGE("Saving a binary map under a new name should keep it binary.",
+         dtCore::MapBinaryParser::IsBinaryMapFile(copyFileName));
+      CPPUNIT_ASSERT(!fileUtils.FileExists(mapsDir + "binarysaveascopy." + dtCore::Map::MAP_FILE_EXTENSION));
+
+      project.CloseMap(*map);
+      map = &project.GetMap("Binary Save As Copy");
+      CPPUNIT_ASSERT_EQUAL(numActors, map->GetAllProxies().size());
+      project.DeleteMap(*map, true);
+
+      // An xml map stays xml.
+      map = &project.CreateMap("Xml Save As", "xmlsaveas");
+      project.SaveMapAs(*map, "Xml Save As Copy", "xmlsaveascopy");
+      CPPUNIT_ASSERT_EQUAL(std::string("xmlsaveascopy." + dtCore::Map::MAP_FILE_EXTENSION), map->GetFileName());
+      CPPUNIT_ASSERT(!dtCore::MapBinaryParser::IsBinaryMapFile(mapsDir + map->GetFileName()));
+      project.DeleteMap(*map, true);
+
+      project.DeleteMap("Binary Save As", true);
+      project.DeleteMap("Xml Save As", true);
+   }
+   catch (const dtUtil::Exception& e)
+   {
+      CPPUNIT_FAIL(std::string("Error: ") + e.ToString());
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void MapTests::TestBinaryMapLoadPerformance()
+{
+   const unsigned numActors = 2000;
+   const unsigned numLoads = 5;
+
+   dtCore::ActorFactory::GetInstance().LoadActorRegistry(mExampleLibraryName);
+
+   dtCore::MapPtr map = new dtCore::Map("perf", "Performance Map");
+   map->AddLibrary(mExampleLibraryName, "1.0");
+   for (unsigned i = 0; i < numActors; ++i)
+   {
+      dtCore::RefPtr<dtCore::BaseActorObject> actor = dtCore::ActorFactory::GetInstance().CreateActor(*ExampleActorLib::TEST_ACTOR_PROPERTY_TYPE.get());
+      actor->SetName(dtUtil::ToString(i));
+      map->AddProxy(*actor);
+   }
+
+   const std::string contextDir = dtCore::Project::GetInstance().GetContext() + dtUtil::FileUtils::PATH_SEPARATOR;
+   const std::string xmlFileName = contextDir + "perf." + dtCore::Map::MAP_FILE_EXTENSION;
+   const std::string binaryFileName = contextDir + "perf." + dtCore::Map::MAP_BINARY_FILE_EXTENSION;
+
+   dtCore::Timer timer;
+   dtCore::Timer_t start = timer.Tick();
+   dtCore::RefPtr<dtCore::MapWriter> xmlWriter = new dtCore::MapWriter();
+   xmlWriter->Save(*map, xmlFileName);
+   double xmlSaveTime = timer.DeltaSec(start, timer.Tick());
+
+   start = timer.Tick();
+   dtCore::RefPtr<dtCore::MapBinaryWriter> binaryWriter = new dtCore::MapBinaryWriter();
+   binaryWriter->Save(*map, binaryFileName);
+   double binarySaveTime = timer.DeltaSec(start, timer.Tick());
+
+   double xmlLoadTime = 0.0, binaryLoadTime = 0.0;
+   for (unsigned i = 0; i < numLoads; ++i)
+   {
+      dtCore::RefPtr<dtCore::MapParser> parser = new dtCore::MapParser();
+      dtCore::Map* loaded = NULL;
+
+      start = timer.Tick();
+      CPPUNIT_ASSERT(parser->Parse(xmlFileName, &loaded));
+      xmlLoadTime += timer.DeltaSec(start, timer.Tick());
+      dtCore::MapPtr xmlMap = loaded;
+      CPPUNIT_ASSERT_EQUAL(size_t(numActors), xmlMap->GetAllProxies().size());
+
+      start = timer.Tick();
+      CPPUNIT_ASSERT(parser->Parse(binaryFileName, &loaded));
+      binaryLoadTime += timer.DeltaSec(start, timer.Tick());
+      dtCore::MapPtr binaryMap = loaded;
+      CPPUNIT_ASSERT_EQUAL(size_t(numActors), binaryMap->GetAllProxies().size());
+   }
+
+   std::ostringstream ss;
+   ss << "Map with " << numActors << " actors.  Save xml " << xmlSaveTime << "s, binary " << binarySaveTime
+      << "s.  Load xml " << xmlLoadTime / numLoads << "s, binary " << binaryLoadTime / numLoads << "s.  Size xml "
+      << dtUtil::FileUtils::GetInstance().GetFileInfo(xmlFileName).size << " bytes, binary "
+      << dtUtil::FileUtils::GetInstance().GetFileInfo(binaryFileName).size << " bytes.";
+   LOG_ALWAYS(ss.str());
+
+   dtUtil::FileUtils::GetInstance().FileDelete(xmlFileName);
+   dtUtil::FileUtils::GetInstance().FileDelete(binaryFileName);
+}
@@ -33,6 +33,7 @@
 #include <dtCore/refptr.h>
 #include <dtCore/scene.h>
 #include <dtCore/system.h>
+#include <dtCore/timer.h>
 
 #include <dtCore/actortype.h>
 #include <dtCore/actoractorproperty.h>
@@ -50,6 +51,7 @@
 #include <dtUtil/datapathutils.h>
 #include <dtUtil/log.h>
 #include <dtUtil/mathdefines.h>
+#include <dtUtil/stringutils.h>
 
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -104,6 +106,9 @@ class NamedParameterTests : public CPPUNIT_NS::TestFixture
       CPPUNIT_TEST(TestFloatByteSwappedTypeCasts);
       CPPUNIT_TEST(TestDoubleByteSwappedTypeCasts);
 
+      CPPUNIT_TEST(TestDataTypeIdLookup);
+      //CPPUNIT_TEST(TestNamedGroupParameterStreamPerformance); //disabled - just used for benchmarking
+
    CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -148,6 +153,9 @@ public:
    void TestFloatByteSwappedTypeCasts();
    void TestDoubleByteSwappedTypeCasts();
 
+   void TestDataTypeIdLookup();
+   void TestNamedGroupParameterStreamPerformance();
+
 
    //this templated function can be used for an osg vector type and NamedVecParameter subclass.
    template <class VecType, class ParamType>
@@ -2054,4 +2062,62 @@ void NamedParameterTests::TestNamedVec3ToFromDataStream()
    }
 }
 
+///////////////////////////////////////////////////////////////////////
+void NamedParameterTests::TestDataTypeIdLookup()
+{
+   const std::vector<dtCore::DataType*>& types = dtCore::DataType::EnumerateType();
+   for (unsigned i = 0; i < types.size(); ++i)
+   {
+      dtCore::DataType* found = dtCore::DataType::GetValueForId(types[i]->GetTypeId());
+      CPPUNIT_ASSERT_MESSAGE("Datatype " + types[i]->GetName() + " should be found by its id.", found != NULL);
+      CPPUNIT_ASSERT_EQUAL(types[i]->GetTypeId(), found->GetTypeId());
+
+      // The lookup has to return the same type the old search of the enumeration did.
+      dtCore::DataType* firstMatch = NULL;
+      for (unsigned j = 0; j < types.size() && firstMatch == NULL; ++j)
+      {
+         if (types[j]->GetTypeId() == types[i]->GetTypeId())
+         {
+            firstMatch = types[j];
+         }
+      }
+      CPPUNIT_ASSERT(firstMatch == found);
+   }
+
+   CPPUNIT_ASSERT(dtCore::DataType::GetValueForId(dtCore::DataType::FLOAT_ID) == &dtCore::DataType::FLOAT);
+   CPPUNIT_ASSERT(dtCore::DataType::GetValueForId(dtCore::DataType::GROUP_ID) == &dtCore::DataType::GROUP);
+   CPPUNIT_ASSERT(dtCore::DataType::GetValueForId(255) == NULL);
+}
+
+///////////////////////////////////////////////////////////////////////
+void NamedParameterTests::TestNamedGroupParameterStreamPerformance()
+{
+   const unsigned numParams = 50;
+   const unsigned iterations = 10000;
+
+   dtCore::DataType* typesToUse[] = { &dtCore::DataType::FLOAT, &dtCore::DataType::INT, &dtCore::DataType::BOOLEAN,
+            &dtCore::DataType::VEC3, &dtCore::DataType::STRING };
+   const unsigned numTypes = sizeof(typesToUse) / sizeof(typesToUse[0]);
+
+   dtCore::RefPtr<dtCore::NamedGroupParameter> group = new dtCore::NamedGroupParameter("update");
+   for (unsigned i = 0; i < numParams; ++i)
+   {
+      group->AddParameter(std::string("param") + dtUtil::ToString(i), *typesToUse[i % numTypes]);
+   }
 
+   dtUtil::DataStream ds;
+   group->ToDataStream(ds);
+
+   dtCore::Timer timer;
+   dtCore::Timer_t start = timer.Tick();
+   for (unsigned i = 0; i < iterations; ++i)
+   {
+      dtCore::RefPtr<dtCore::NamedGroupParameter> received = new dtCore::NamedGroupParameter("update");
+      ds.Rewind();
+      received->FromDataStream(ds);
+   }
+   double elapsed = timer.DeltaSec(start, timer.Tick());
+
+   std::cout << std::endl << "Decoded a group of " << numParams << " parameters " << iterations << " times in "
+            << elapsed << "s, " << (elapsed * 1000000.0 / double(iterations)) << "us each." << std::endl;
+}
@@ -28,6 +28,7 @@
 #include <prefix/unittestprefix.h>
 #include <vector>
 #include <set>
+#include <sstream>
 #include <string>
 
 #include <cstdio>
@@ -53,6 +54,7 @@
 // Resource Actor Property has a helper function to make it easier to get a resource path, so it's easiest to test it with
 // project.
 #include <dtCore/resourceactorproperty.h>
+#include <dtCore/timer.h>
 
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -75,6 +77,8 @@ class ProjectTests : public CPPUNIT_NS::TestFixture
    CPPUNIT_TEST(TestLoadProjectConfigFromFile);
    CPPUNIT_TEST(TestCategories);
    CPPUNIT_TEST(TestResources);
+   CPPUNIT_TEST(TestResourcePathCache);
+   //CPPUNIT_TEST(TestResourcePathCachePerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST(TestDeletingBackupFromReadOnlyContext);
    CPPUNIT_TEST(TestNonModifiedMapBackup);
    CPPUNIT_TEST(TestModifiedMapBackup);
@@ -98,6 +102,8 @@ class ProjectTests : public CPPUNIT_NS::TestFixture
       void TestReadonlyFailure();
       void TestCreateContextWithMapsDir();
       void TestResources();
+      void TestResourcePathCache();
+      void TestResourcePathCachePerformance();
       void TestDeletingBackupFromReadOnlyContext();
       void TestNonModifiedMapBackup();
       void TestModifiedMapBackup();
@@ -1273,3 +1279,145 @@ void ProjectTests::TestMapSaveAsBackups()
 
    project.DeleteMap(*map);
 }
+
+///////////////////////////////////////////////////////////////////////////////////////
+void ProjectTests::TestResourcePathCache()
+{
+   try
+   {
+      dtCore::Project& p = dtCore::Project::GetInstance();
+      dtUtil::FileUtils& fileUtils = dtUtil::FileUtils::GetInstance();
+
+      p.CreateContext("WorkingProject");
+      p.AddContext("WorkingProject");
+
+      CPPUNIT_ASSERT(p.GetResourcePathCacheEnabled());
+
+      dtCore::ResourceDescriptor rd = p.AddResource("flatdirt", std::string(DATA_DIR + "/StaticMeshes/flatdirt.ive"),
+            "cache", dtCore::DataType::STATIC_MESH, 0);
+      const std::string expectedPath = p.GetContext(0) + dtUtil::FileUtils::PATH_SEPARATOR + dtCore::DataType::STATIC_MESH.GetName()
+            + dtUtil::FileUtils::PATH_SEPARATOR + "cache" + dtUtil::FileUtils::PATH_SEPARATOR + "flatdirt.ive";
+
+      p.ResetResourcePathCacheStatistics();
+      CPPUNIT_ASSERT_EQUAL(expectedPath, p.GetResourcePath(rd));
+      CPPUNIT_ASSERT_EQUAL(expectedPath, p.GetResourcePath(rd));
+
+      dtCore::Project::ResourcePathCacheStatistics stats = p.GetResourcePathCacheStatistics();
+      CPPUNIT_ASSERT_EQUAL(1U, stats.mNumMisses);
+      CPPUNIT_ASSERT_EQUAL(1U, stats.mNumHits);
+      CPPUNIT_ASSERT_EQUAL(1U, stats.mNumEntries);
+
+      // Misses are cached too, and still throw.
+      dtCore::ResourceDescriptor missingRD(dtCore::DataType::STATIC_MESH.GetName() + ":cache:missing.ive");
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(missingRD), dtCore::ProjectFileNotFoundException);
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(missingRD), dtCore::ProjectFileNotFoundException);
+      stats = p.GetResourcePathCacheStatistics();
+      CPPUNIT_ASSERT_EQUAL(2U, stats.mNumMisses);
+      CPPUNIT_ASSERT_EQUAL(2U, stats.mNumHits);
+      CPPUNIT_ASSERT_EQUAL(2U, stats.mNumEntries);
+
+      // A category lookup is separate from a file lookup of the same identifier.
+      dtCore::ResourceDescriptor categoryRD(dtCore::DataType::STATIC_MESH.GetName() + ":cache");
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(categoryRD), dtCore::ProjectResourceErrorException);
+      CPPUNIT_ASSERT_NO_THROW(p.GetResourcePath(categoryRD, true));
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(categoryRD), dtCore::ProjectResourceErrorException);
+
+      // A file added behind the project's back isn't seen until the cache is cleared.
+      const std::string missingPath = p.GetContext(0) + dtUtil::FileUtils::PATH_SEPARATOR + dtCore::DataType::STATIC_MESH.GetName()
+            + dtUtil::FileUtils::PATH_SEPARATOR + "cache" + dtUtil::FileUtils::PATH_SEPARATOR + "missing.ive";
+      fileUtils.FileCopy(expectedPath, missingPath, false);
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(missingRD), dtCore::ProjectFileNotFoundException);
+      p.ClearResourcePathCache();
+      CPPUNIT_ASSERT_EQUAL(0U, p.GetResourcePathCacheStatistics().mNumEntries);
+      CPPUNIT_ASSERT_EQUAL(missingPath, p.GetResourcePath(missingRD));
+
+      // Changes made through the project clear the cache.
+      p.RemoveResource(rd);
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(rd), dtCore::ProjectFileNotFoundException);
+      p.RemoveResource(missingRD);
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(missingRD), dtCore::ProjectFileNotFoundException);
+
+      p.SetResourcePathCacheEnabled(false);
+      p.ResetResourcePathCacheStatistics();
+      CPPUNIT_ASSERT_THROW(p.GetResourcePath(rd), dtCore::ProjectFileNotFoundException);
+      stats = p.GetResourcePathCacheStatistics();
+      CPPUNIT_ASSERT_EQUAL(0U, stats.mNumHits + stats.mNumMisses);
+      CPPUNIT_ASSERT_EQUAL(0U, stats.mNumEntries);
+      p.SetResourcePathCacheEnabled(true);
+   }
+   catch (const dtUtil::Exception& ex)
+   {
+      dtCore::Project::GetInstance().SetResourcePathCacheEnabled(true);
+      CPPUNIT_FAIL(ex.ToString());
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+void ProjectTests::TestResourcePathCachePerformance()
+{
+   // Resolves resources the way loading a map does: a set of meshes shared by many actors, some of them missing,
+   // looked up across several contexts.
+   const unsigned numResources = 200;
+   const unsigned numActorsPerResource = 50;
+   const unsigned numMissing = 20;
+
+   dtCore::Project& p = dtCore::Project::GetInstance();
+   p.CreateContext("WorkingProject");
+   p.CreateContext("TestProject1");
+   p.CreateContext("TestProject2");
+   p.AddContext("TestProject1");
+   p.AddContext("TestProject2");
+   p.AddContext("WorkingProject");
+
+   std::vector<dtCore::ResourceDescriptor> resources;
+   resources.push_back(p.AddResource("flatdirt", std::string(DATA_DIR + "/StaticMeshes/flatdirt.ive"),
+         "perf", dtCore::DataType::STATIC_MESH, 2));
+   for (unsigned i = 1; i < numResources; ++i)
+   {
+      const std::string name = "mesh" + dtUtil::ToString(i);
+      std::string identifier = dtCore::DataType::STATIC_MESH.GetName() + ":perf:" + name + ".ive";
+      if (i >= numMissing)
+      {
+         resources.push_back(p.AddResource(name, std::string(DATA_DIR + "/StaticMeshes/flatdirt.ive"),
+               "perf", dtCore::DataType::STATIC_MESH, 2));
+      }
+      else
+      {
+         resources.push_back(dtCore::ResourceDescriptor(identifier));
+      }
+   }
+
+   double times[2] = { 0.0, 0.0 };
+   for (unsigned pass = 0; pass < 2; ++pass)
+   {
+      const bool cacheEnabled = pass == 1;
+      p.SetResourcePathCacheEnabled(cacheEnabled);
+      p.ResetResourcePathCacheStatistics();
+
+      dtCore::Timer timer;
+      dtCore::Timer_t start = timer.Tick();
+      unsigned numFound = 0;
+      for (unsigned actor = 0; actor < numActorsPerResource; ++actor)
+      {
+         for (unsigned i = 0; i < resources.size(); ++i)
+         {
+            try
+            {
+               p.GetResourcePath(resources[i]);
+               ++numFound;
+            }
+            catch (const dtCore::ProjectFileNotFoundException&)
+            {
+            }
+         }
+      }
+      times[pass] = timer.DeltaSec(start, timer.Tick());
+      CPPUNIT_ASSERT_EQUAL((numResources - numMissing + 1) * numActorsPerResource, numFound);
+   }
+
+   dtCore::Project::ResourcePathCacheStatistics stats = p.GetResourcePathCacheStatistics();
+   std::ostringstream ss;
+   ss << numResources * numActorsPerResource << " resource lookups in 3 contexts.  Uncached " << times[0]
+      << "s, cached " << times[1] << "s, " << stats.mNumHits << " hits, " << stats.mNumMisses << " misses.";
+   LOG_ALWAYS(ss.str());
+}
@@ -0,0 +1,411 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <dtCore/scene.h>
+#include <dtCore/spatialindex.h>
+#include <dtCore/transformable.h>
+#include <dtCore/timer.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace dtCore;
+
+namespace
+{
+   /// Counts the enter and leave events it gets.  A deleted occupant counts as leaving.
+   class CountingVolume : public SpatialVolume
+   {
+   public:
+      CountingVolume() : mEntered(0), mLeft(0), mDeleted(0) {}
+
+      virtual void OnEnter(Transformable&) { ++mEntered; }
+      virtual void OnLeave(Transformable&) { ++mLeft; }
+      virtual void OnOccupantDeleted() { ++mLeft; ++mDeleted; }
+
+      unsigned mEntered;
+      unsigned mLeft;
+      unsigned mDeleted;
+   };
+
+   void MoveTo(Transformable& transformable, const osg::Vec3& position)
+   {
+      transformable.SetMatrix(osg::Matrix::translate(position));
+   }
+}
+
+class SpatialIndexTests : public CPPUNIT_NS::TestFixture
+{
+   CPPUNIT_TEST_SUITE(SpatialIndexTests);
+   CPPUNIT_TEST(TestInsertAndFind);
+   CPPUNIT_TEST(TestMove);
+   CPPUNIT_TEST(TestObjectRadius);
+   CPPUNIT_TEST(TestHugeCoordinates);
+   CPPUNIT_TEST(TestVolumeEvents);
+   CPPUNIT_TEST(TestAnchoredBoxVolume);
+   CPPUNIT_TEST(TestRemove);
+   CPPUNIT_TEST(TestSceneIndex);
+   //CPPUNIT_TEST(TestSpatialIndexPerformance); //disabled - just used for benchmarking
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   void setUp()
+   {
+      mIndex = new SpatialIndex(10.0f);
+      mNear = new Transformable("Near");
+      mFar = new Transformable("Far");
+      MoveTo(*mNear, osg::Vec3(1.0f, 1.0f, 1.0f));
+      MoveTo(*mFar, osg::Vec3(100.0f, 0.0f, 0.0f));
+      mIndex->Insert(*mNear);
+      mIndex->Insert(*mFar);
+   }
+
+   void tearDown()
+   {
+      mNear = NULL;
+      mFar = NULL;
+      mIndex = NULL;
+   }
+
+   void TestInsertAndFind()
+   {
+      CPPUNIT_ASSERT_EQUAL(2U, mIndex->GetNumObjects());
+      CPPUNIT_ASSERT(mIndex->Contains(*mNear));
+      CPPUNIT_ASSERT(mNear->GetSpatialIndex() == mIndex.get());
+
+      osg::Vec3 position;
+      CPPUNIT_ASSERT(mIndex->GetPosition(*mFar, position));
+      CPPUNIT_ASSERT_EQUAL(osg::Vec3(100.0f, 0.0f, 0.0f), position);
+
+      std::vector<Transformable*> found;
+      mIndex->FindInSphere(osg::Vec3(), 5.0f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), found.size());
+      CPPUNIT_ASSERT(found[0] == mNear.get());
+
+      found.clear();
+      mIndex->FindInBox(osg::Vec3(90.0f, -1.0f, -1.0f), osg::Vec3(110.0f, 1.0f, 1.0f), found);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), found.size());
+      CPPUNIT_ASSERT(found[0] == mFar.get());
+
+      found.clear();
+      mIndex->FindInSphere(osg::Vec3(), 1000.0f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), found.size());
+   }
+
+   void TestMove()
+   {
+      std::vector<Transformable*> found;
+
+      // The index doesn't see the move until it's updated.
+      MoveTo(*mFar, osg::Vec3(2.0f, 0.0f, 0.0f));
+      mIndex->FindInSphere(osg::Vec3(), 5.0f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), found.size());
+
+      mIndex->UpdatePositions();
+      found.clear();
+      mIndex->FindInSphere(osg::Vec3(), 5.0f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), found.size());
+
+      // Moving a parent moves the children in the index.
+      RefPtr<Transformable> parent = new Transformable("Parent");
+      parent->AddChild(mNear.get());
+      mIndex->UpdatePositions();
+      MoveTo(*parent, osg::Vec3(-50.0f, 0.0f, 0.0f));
+      mIndex->UpdatePositions();
+
+      osg::Vec3 position;
+      CPPUNIT_ASSERT(mIndex->GetPosition(*mNear, position));
+      CPPUNIT_ASSERT_EQUAL(osg::Vec3(-49.0f, 1.0f, 1.0f), position);
+
+      parent->RemoveChild(mNear.get());
+   }
+
+   void TestObjectRadius()
+   {
+      std::vector<Transformable*> found;
+      mIndex->FindInSphere(osg::Vec3(90.0f, 0.0f, 0.0f), 1.0f, found);
+      CPPUNIT_ASSERT(found.empty());
+
+      // Far reaches into the query from a cell the query doesn't cover.
+      mIndex->Insert(*mFar, 10.0f);
+      CPPUNIT_ASSERT_EQUAL(2U, mIndex->GetNumObjects());
+      mIndex->FindInSphere(osg::Vec3(89.5f, 0.0f, 0.0f), 1.0f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), found.size());
+      CPPUNIT_ASSERT(found[0] == mFar.get());
+      CPPUNIT_ASSERT_EQUAL(10.0f, mIndex->GetMaxObjectRadius());
+
+      // The queries stop reaching out once the big object shrinks or goes.
+      mIndex->Insert(*mFar, 2.0f);
+      mIndex->UpdatePositions();
+      CPPUNIT_ASSERT_EQUAL(2.0f, mIndex->GetMaxObjectRadius());
+
+      mIndex->Insert(*mFar, 10.0f);
+      mIndex->Remove(*mFar);
+      mIndex->UpdatePositions();
+      CPPUNIT_ASSERT_EQUAL(0.0f, mIndex->GetMaxObjectRadius());
+   }
+
+   void TestHugeCoordinates()
+   {
+      // The cell coordinates are clamped, so none of these overflow the cast to int or the loop over the cells.
+      std::vector<Transformable*> found;
+      mIndex->FindInSphere(osg::Vec3(), 1e30f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), found.size());
+
+      found.clear();
+      mIndex->FindInBox(osg::Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX), osg::Vec3(FLT_MAX, FLT_MAX, FLT_MAX), found);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), found.size());
+
+      found.clear();
+      mIndex->FindInSphere(osg::Vec3(1e30f, -1e30f, 0.0f), 1.0f, found);
+      CPPUNIT_ASSERT(found.empty());
+
+      const osg::Vec3 farAway(1e20f, 0.0f, -1e20f);
+      MoveTo(*mFar, farAway);
+      mIndex->UpdatePositions();
+      mIndex->FindInSphere(farAway, 1.0f, found);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), found.size());
+      CPPUNIT_ASSERT(found[0] == mFar.get());
+   }
+
+   void TestVolumeEvents()
+   {
+      RefPtr<CountingVolume> volume = new CountingVolume;
+      volume->SetSphere(5.0f);
+      mIndex->AddVolume(*volume);
+      CPPUNIT_ASSERT_EQUAL(1U, mIndex->GetNumVolumes());
+
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mEntered);
+      CPPUNIT_ASSERT(volume->IsOccupant(*mNear));
+      CPPUNIT_ASSERT(!volume->IsOccupant(*mFar));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mIndex->GetLastEvents().size());
+      CPPUNIT_ASSERT(mIndex->GetLastEvents()[0].mEntered);
+
+      // Nothing changed, so nothing is sent.
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mEntered);
+      CPPUNIT_ASSERT(mIndex->GetLastEvents().empty());
+
+      MoveTo(*mFar, osg::Vec3(0.0f, 3.0f, 0.0f));
+      MoveTo(*mNear, osg::Vec3(0.0f, 30.0f, 0.0f));
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(2U, volume->mEntered);
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mLeft);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), volume->GetOccupants().size());
+      CPPUNIT_ASSERT(volume->IsOccupant(*mFar));
+
+      mIndex->RemoveVolume(*volume);
+      CPPUNIT_ASSERT_EQUAL(0U, mIndex->GetNumVolumes());
+      CPPUNIT_ASSERT(volume->GetOccupants().empty());
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mLeft);
+   }
+
+   void TestAnchoredBoxVolume()
+   {
+      RefPtr<CountingVolume> volume = new CountingVolume;
+      volume->SetBox(osg::Vec3(2.0f, 2.0f, 2.0f));
+      volume->SetAnchor(mFar.get());
+      mIndex->AddVolume(*volume);
+
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(osg::Vec3(100.0f, 0.0f, 0.0f), volume->GetCenter());
+      // The anchor isn't in its own volume.
+      CPPUNIT_ASSERT(volume->GetOccupants().empty());
+
+      MoveTo(*mFar, osg::Vec3(2.0f, 2.0f, 0.0f));
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(osg::Vec3(2.0f, 2.0f, 0.0f), volume->GetCenter());
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mEntered);
+      CPPUNIT_ASSERT(volume->IsOccupant(*mNear));
+
+      MoveTo(*mFar, osg::Vec3(4.0f, 4.0f, 4.0f));
+      mIndex->Update();
+      CPPUNIT_ASSERT(!volume->Overlaps(osg::Vec3(1.0f, 1.0f, 1.0f)));
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mLeft);
+   }
+
+   void TestRemove()
+   {
+      RefPtr<CountingVolume> volume = new CountingVolume;
+      volume->SetSphere(5.0f);
+      mIndex->AddVolume(*volume);
+      mIndex->Update();
+
+      mIndex->Remove(*mNear);
+      CPPUNIT_ASSERT(!mIndex->Contains(*mNear));
+      CPPUNIT_ASSERT(mNear->GetSpatialIndex() == NULL);
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mLeft);
+      CPPUNIT_ASSERT(volume->GetOccupants().empty());
+
+      // A transformable that is deleted takes itself out, and the volume hears about it on the next update.
+      RefPtr<Transformable> temp = new Transformable("Temp");
+      mIndex->Insert(*temp);
+      mIndex->Update();
+      CPPUNIT_ASSERT(volume->IsOccupant(*temp));
+      MoveTo(*temp, osg::Vec3(1.0f, 0.0f, 0.0f));
+      temp = NULL;
+      CPPUNIT_ASSERT_EQUAL(1U, mIndex->GetNumObjects());
+      CPPUNIT_ASSERT(volume->GetOccupants().empty());
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mLeft);
+
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(2U, volume->mLeft);
+      CPPUNIT_ASSERT_EQUAL(1U, volume->mDeleted);
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mIndex->GetLastEvents().size());
+      CPPUNIT_ASSERT(mIndex->GetLastEvents()[0].mDeleted);
+      CPPUNIT_ASSERT(!mIndex->GetLastEvents()[0].mEntered);
+
+      // It's only sent once.
+      mIndex->Update();
+      CPPUNIT_ASSERT_EQUAL(2U, volume->mLeft);
+
+      // Inserting into another index takes it out of this one.
+      RefPtr<SpatialIndex> otherIndex = new SpatialIndex;
+      otherIndex->Insert(*mFar);
+      CPPUNIT_ASSERT(!mIndex->Contains(*mFar));
+      CPPUNIT_ASSERT(mFar->GetSpatialIndex() == otherIndex.get());
+      otherIndex = NULL;
+      CPPUNIT_ASSERT(mFar->GetSpatialIndex() == NULL);
+   }
+
+   void TestSceneIndex()
+   {
+      RefPtr<Scene> scene = new Scene;
+      RefPtr<Transformable> parent = new Transformable("Parent");
+      RefPtr<Transformable> child = new Transformable("Child");
+      parent->AddChild(child.get());
+
+      scene->AddChild(parent.get());
+      CPPUNIT_ASSERT(scene->GetSpatialIndex().Contains(*parent));
+      CPPUNIT_ASSERT(scene->GetSpatialIndex().Contains(*child));
+
+      scene->RemoveChild(parent.get());
+      CPPUNIT_ASSERT_EQUAL(0U, scene->GetSpatialIndex().GetNumObjects());
+      CPPUNIT_ASSERT(child->GetSpatialIndex() == NULL);
+
+      // Something put in another index on purpose stays there.
+      mIndex->Insert(*parent);
+      scene->AddChild(parent.get());
+      CPPUNIT_ASSERT(parent->GetSpatialIndex() == mIndex.get());
+      CPPUNIT_ASSERT(scene->GetSpatialIndex().Contains(*child));
+      scene->RemoveChild(parent.get());
+      CPPUNIT_ASSERT(parent->GetSpatialIndex() == mIndex.get());
+   }
+
+   void TestSpatialIndexPerformance()
+   {
+      const unsigned numObjects = 10000;
+      const unsigned numVolumes = 500;
+      const unsigned numFrames = 20;
+      const float worldSize = 2000.0f;
+
+      srand(1);
+      RefPtr<SpatialIndex> index = new SpatialIndex;
+
+      std::vector<RefPtr<Transformable> > objects;
+      std::vector<osg::Vec3> positions;
+      for (unsigned i = 0; i < numObjects; ++i)
+      {
+         positions.push_back(osg::Vec3(RandomCoord(worldSize), RandomCoord(worldSize), RandomCoord(50.0f)));
+         objects.push_back(new Transformable);
+         MoveTo(*objects.back(), positions.back());
+         index->Insert(*objects.back());
+      }
+
+      std::vector<RefPtr<CountingVolume> > volumes;
+      for (unsigned i = 0; i < numVolumes; ++i)
+      {
+         volumes.push_back(new CountingVolume);
+         volumes.back()->SetSphere(20.0f);
+         volumes.back()->SetCenter(osg::Vec3(RandomCoord(worldSize), RandomCoord(worldSize), 0.0f));
+         index->AddVolume(*volumes.back());
+      }
+      index->Update();
+
+      dtCore::Timer timer;
+      double indexSeconds = 0.0, bruteSeconds = 0.0;
+      std::vector<std::vector<Transformable*> > bruteOccupants(numVolumes);
+
+      for (unsigned frame = 0; frame < numFrames; ++frame)
+      {
+         for (unsigned i = 0; i < numObjects; ++i)
+         {
+            positions[i] += osg::Vec3(RandomCoord(4.0f), RandomCoord(4.0f), 0.0f);
+            MoveTo(*objects[i], positions[i]);
+         }
+
+         dtCore::Timer_t start = timer.Tick();
+         index->Update();
+         indexSeconds += timer.DeltaSec(start, timer.Tick());
+
+         // Every object against every volume, the way the triggers would without the index.
+         start = timer.Tick();
+         osg::Matrix matrix;
+         for (unsigned v = 0; v < numVolumes; ++v)
+         {
+            bruteOccupants[v].clear();
+            for (unsigned i = 0; i < numObjects; ++i)
+            {
+               objects[i]->GetAbsoluteMatrix(matrix);
+               if (volumes[v]->Overlaps(matrix.getTrans()))
+               {
+                  bruteOccupants[v].push_back(objects[i].get());
+               }
+            }
+            std::sort(bruteOccupants[v].begin(), bruteOccupants[v].end());
+         }
+         bruteSeconds += timer.DeltaSec(start, timer.Tick());
+
+         for (unsigned v = 0; v < numVolumes; ++v)
+         {
+            CPPUNIT_ASSERT(bruteOccupants[v] == volumes[v]->GetOccupants());
+         }
+      }
+
+      std::cout << std::endl << numObjects << " moving transformables, " << numVolumes << " volumes, "
+         << numFrames << " frames:" << std::endl
+         << "   brute force:   " << bruteSeconds << " s" << std::endl
+         << "   spatial index: " << indexSeconds << " s" << std::endl;
+
+      CPPUNIT_ASSERT(indexSeconds < bruteSeconds);
+   }
+
+private:
+   static float RandomCoord(float size)
+   {
+      return (float(rand()) / float(RAND_MAX) - 0.5f) * size;
+   }
+
+   RefPtr<SpatialIndex> mIndex;
+   RefPtr<Transformable> mNear;
+   RefPtr<Transformable> mFar;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SpatialIndexTests);
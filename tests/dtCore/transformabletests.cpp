@@ -32,11 +32,14 @@
 #include <dtCore/object.h>
 #include <dtCore/camera.h>
 #include <dtCore/view.h>
+#include <dtCore/timer.h>
 
 #include <osg/MatrixTransform>
 #include <osg/io_utils>
 #include <sstream>
 #include <limits>
+#include <iostream>
+#include <vector>
 
 using namespace dtCore;
 
@@ -66,6 +69,8 @@ class TransformableTests : public CPPUNIT_NS::TestFixture
    CPPUNIT_TEST(TestGetTransformNotInScene);
    CPPUNIT_TEST(TestGetTransformFromInactiveTransformable);
    CPPUNIT_TEST(TestGetTransformFromInactiveParent);
+   CPPUNIT_TEST(TestAbsoluteMatrixCache);
+   //CPPUNIT_TEST(TestAbsoluteMatrixPerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -95,6 +100,8 @@ public:
    void TestGetTransformNotInScene();
    void TestGetTransformFromInactiveTransformable();
    void TestGetTransformFromInactiveParent();
+   void TestAbsoluteMatrixCache();
+   void TestAbsoluteMatrixPerformance();
 
 private:
    bool CompareMatrix(const osg::Matrix& rhs, const osg::Matrix& lhs) const;
@@ -680,3 +687,155 @@ void TransformableTests::TestGetTransformFromInactiveParent()
       dtUtil::Equivalent(childStartXYZ+parentStartXYZ, endXform.GetTranslation(), TEST_EPSILON));
 }
 
+
+//////////////////////////////////////////////////////////////////////////
+void TransformableTests::TestAbsoluteMatrixCache()
+{
+   using namespace dtCore;
+   RefPtr<Transformable> grandParent = new Transformable("grandParent");
+   RefPtr<Transformable> parent = new Transformable("parent");
+   RefPtr<Transformable> child = new Transformable("child");
+   grandParent->AddChild(parent.get());
+   parent->AddChild(child.get());
+
+   Transform xform;
+   xform.Set(1.0f, 2.0f, 3.0f, 30.0f, 0.0f, 0.0f);
+   grandParent->SetTransform(xform, Transformable::REL_CS);
+   xform.Set(0.0f, 5.0f, 0.0f, 0.0f, 10.0f, 0.0f);
+   parent->SetTransform(xform, Transformable::REL_CS);
+   xform.Set(2.0f, 0.0f, 1.0f, 0.0f, 0.0f, 45.0f);
+   child->SetTransform(xform, Transformable::REL_CS);
+
+   osg::Matrix cached, expected;
+   child->GetAbsoluteMatrix(cached);
+   Transformable::GetAbsoluteMatrix(child->GetOSGNode(), expected);
+   CPPUNIT_ASSERT(CompareMatrix(cached, expected));
+
+   // Moving something above the child has to invalidate its cache.
+   xform.Set(-7.0f, 3.0f, 0.0f, 90.0f, 0.0f, 0.0f);
+   grandParent->SetTransform(xform, Transformable::ABS_CS);
+   child->GetAbsoluteMatrix(cached);
+   Transformable::GetAbsoluteMatrix(child->GetOSGNode(), expected);
+   CPPUNIT_ASSERT_MESSAGE("Moving the grandparent should move the child.", CompareMatrix(cached, expected));
+
+   osg::Matrix parentMatrix = parent->GetMatrix();
+   parentMatrix.setTrans(osg::Vec3(4.0f, 4.0f, 4.0f));
+   parent->GetMatrixNode()->setMatrix(parentMatrix);
+   child->GetAbsoluteMatrix(cached);
+   Transformable::GetAbsoluteMatrix(child->GetOSGNode(), expected);
+   CPPUNIT_ASSERT_MESSAGE("Changing the matrix node directly should move the child.", CompareMatrix(cached, expected));
+
+   // Taking the parent out of the hierarchy.
+   grandParent->RemoveChild(parent.get());
+   child->GetAbsoluteMatrix(cached);
+   Transformable::GetAbsoluteMatrix(child->GetOSGNode(), expected);
+   CPPUNIT_ASSERT_MESSAGE("Removing the parent from its parent should move the child.", CompareMatrix(cached, expected));
+
+   // A transform that isn't a Transformable is only picked up when all the caches are dropped.
+   RefPtr<osg::MatrixTransform> osgTransform = new osg::MatrixTransform();
+   osgTransform->addChild(parent->GetOSGNode());
+   osgTransform->setMatrix(osg::Matrix::translate(100.0f, 0.0f, 0.0f));
+   Transformable::InvalidateAllAbsoluteMatrices();
+   child->GetAbsoluteMatrix(cached);
+   Transformable::GetAbsoluteMatrix(child->GetOSGNode(), expected);
+   CPPUNIT_ASSERT(CompareMatrix(cached, expected));
+
+   // The absolute set goes through the cached parent matrix.
+   xform.Set(10.0f, 20.0f, 30.0f, 15.0f, 25.0f, 35.0f);
+   child->SetTransform(xform, Transformable::ABS_CS);
+   Transform result;
+   child->GetTransform(result, Transformable::ABS_CS);
+   osg::Matrix setMatrix, resultMatrix;
+   xform.Get(setMatrix);
+   result.Get(resultMatrix);
+   CPPUNIT_ASSERT(CompareMatrix(setMatrix, resultMatrix));
+
+   // And through an inactive child, which has a switch node above it.
+   osgTransform->removeChild(parent->GetOSGNode());
+   RefPtr<Scene> scene = new Scene();
+   scene->AddChild(parent.get());
+   child->SetActive(false);
+   xform.Set(-1.0f, 2.0f, -3.0f, 0.0f, 0.0f, 0.0f);
+   parent->SetTransform(xform, Transformable::ABS_CS);
+   child->GetAbsoluteMatrix(cached);
+   Transformable::GetAbsoluteMatrix(child->GetOSGNode(), expected);
+   CPPUNIT_ASSERT(CompareMatrix(cached, expected));
+}
+
+//////////////////////////////////////////////////////////////////////////
+void TransformableTests::TestAbsoluteMatrixPerformance()
+{
+   using namespace dtCore;
+   const unsigned numTransformables = 10000;
+   const unsigned maxDepth = 8;
+   const unsigned numQueriesPerFrame = 10;
+   const unsigned numFrames = 10;
+
+   // Chains of varied depths, with the leaf of each moved every frame.
+   std::vector<RefPtr<Transformable> > transformables;
+   std::vector<Transformable*> leaves;
+   transformables.reserve(numTransformables);
+   while (transformables.size() < numTransformables)
+   {
+      unsigned depth = 1 + transformables.size() % maxDepth;
+      Transformable* parent = NULL;
+      for (unsigned i = 0; i < depth && transformables.size() < numTransformables; ++i)
+      {
+         RefPtr<Transformable> transformable = new Transformable();
+         Transform xform;
+         xform.Set(1.0f, 2.0f, 3.0f, float(i) * 10.0f, 5.0f, 0.0f);
+         transformable->SetTransform(xform, Transformable::REL_CS);
+         if (parent != NULL)
+         {
+            parent->AddChild(transformable.get());
+         }
+         parent = transformable.get();
+         transformables.push_back(transformable);
+      }
+      leaves.push_back(parent);
+   }
+
+   dtCore::Timer timer;
+   osg::Matrix matrix;
+
+   dtCore::Timer_t start = timer.Tick();
+   for (unsigned frame = 0; frame < numFrames; ++frame)
+   {
+      for (unsigned i = 0; i < leaves.size(); ++i)
+      {
+         leaves[i]->SetMatrix(osg::Matrix::translate(float(frame), 0.0f, 0.0f));
+      }
+      for (unsigned query = 0; query < numQueriesPerFrame; ++query)
+      {
+         for (unsigned i = 0; i < transformables.size(); ++i)
+         {
+            Transformable::GetAbsoluteMatrix(transformables[i]->GetOSGNode(), matrix);
+         }
+      }
+   }
+   double walkSeconds = timer.DeltaSec(start, timer.Tick());
+
+   start = timer.Tick();
+   for (unsigned frame = 0; frame < numFrames; ++frame)
+   {
+      for (unsigned i = 0; i < leaves.size(); ++i)
+      {
+         leaves[i]->SetMatrix(osg::Matrix::translate(float(frame), 0.0f, 0.0f));
+      }
+      for (unsigned query = 0; query < numQueriesPerFrame; ++query)
+      {
+         for (unsigned i = 0; i < transformables.size(); ++i)
+         {
+            transformables[i]->GetAbsoluteMatrix(matrix);
+         }
+      }
+   }
+   double cachedSeconds = timer.DeltaSec(start, timer.Tick());
+
+   std::cout << std::endl << numTransformables << " transformables up to " << maxDepth << " deep, "
+      << numQueriesPerFrame << " absolute queries each per frame for " << numFrames << " frames:" << std::endl
+      << "   parent walk: " << walkSeconds << " s" << std::endl
+      << "   cached:      " << cachedSeconds << " s" << std::endl;
+
+   CPPUNIT_ASSERT(cachedSeconds < walkSeconds);
+}
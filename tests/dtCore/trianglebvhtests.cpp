@@ -0,0 +1,234 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <dtCore/refptr.h>
+#include <dtCore/trianglebvh.h>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace dtCore;
+
+namespace
+{
+   float RandomFloat(float minValue, float maxValue)
+   {
+      return minValue + (maxValue - minValue) * (float(std::rand()) / float(RAND_MAX));
+   }
+
+   /// Adds a rolling height field of size by size quads, one unit apart.
+   void AddHeightField(unsigned size, std::vector<osg::Vec3>& verts, std::vector<unsigned>& indices)
+   {
+      for (unsigned y = 0; y <= size; ++y)
+      {
+         for (unsigned x = 0; x <= size; ++x)
+         {
+            verts.push_back(osg::Vec3(float(x), float(y), 5.0f * std::sin(0.1f * x) + 3.0f * std::cos(0.07f * y)));
+         }
+      }
+
+      for (unsigned y = 0; y < size; ++y)
+      {
+         for (unsigned x = 0; x < size; ++x)
+         {
+            unsigned corner = y * (size + 1) + x;
+            indices.push_back(corner);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + size + 2);
+            indices.push_back(corner);
+            indices.push_back(corner + size + 2);
+            indices.push_back(corner + size + 1);
+         }
+      }
+   }
+
+   /// @return the ratios along the segment of every triangle it passes through, sorted, by testing each one.
+   std::vector<float> IntersectAll(const std::vector<osg::Vec3>& corners, const osg::Vec3& start, const osg::Vec3& end)
+   {
+      std::vector<float> ratios;
+      osg::Vec3 dir = end - start;
+      for (unsigned i = 0; i + 2 < corners.size(); i += 3)
+      {
+         osg::Vec3 edge1 = corners[i + 1] - corners[i];
+         osg::Vec3 edge2 = corners[i + 2] - corners[i];
+         osg::Vec3 p = dir ^ edge2;
+         float det = edge1 * p;
+         if (std::abs(det) < 1e-12f)
+         {
+            continue;
+         }
+
+         float invDet = 1.0f / det;
+         osg::Vec3 s = start - corners[i];
+         float u = (s * p) * invDet;
+         osg::Vec3 q = s ^ edge1;
+         float v = (dir * q) * invDet;
+         float t = (edge2 * q) * invDet;
+         if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= 1.0f)
+         {
+            ratios.push_back(t);
+         }
+      }
+      std::sort(ratios.begin(), ratios.end());
+      return ratios;
+   }
+}
+
+class TriangleBVHTests : public CPPUNIT_NS::TestFixture
+{
+   CPPUNIT_TEST_SUITE(TriangleBVHTests);
+   CPPUNIT_TEST(TestEmpty);
+   CPPUNIT_TEST(TestMatchesBruteForce);
+   CPPUNIT_TEST(TestAddNode);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   void TestEmpty()
+   {
+      RefPtr<TriangleBVH> bvh = new TriangleBVH;
+      CPPUNIT_ASSERT(!bvh->IsBuilt());
+      bvh->Build();
+      CPPUNIT_ASSERT(bvh->IsBuilt());
+      CPPUNIT_ASSERT_EQUAL(0U, bvh->GetNumTriangles());
+
+      TriangleBVH::HitList hits;
+      CPPUNIT_ASSERT_EQUAL(0U, bvh->IntersectSegment(osg::Vec3(0.0f, 0.0f, 10.0f), osg::Vec3(0.0f, 0.0f, -10.0f), hits));
+
+      bvh->AddTriangle(osg::Vec3(-1.0f, -1.0f, 0.0f), osg::Vec3(1.0f, -1.0f, 0.0f), osg::Vec3(0.0f, 1.0f, 0.0f));
+      bvh->Build();
+      CPPUNIT_ASSERT_EQUAL(1U, bvh->IntersectSegment(osg::Vec3(0.0f, 0.0f, 10.0f), osg::Vec3(0.0f, 0.0f, -10.0f), hits));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5f, hits[0].mRatio, 1e-5f);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0f, hits[0].mNormal.z(), 1e-5f);
+
+      bvh->Clear();
+      CPPUNIT_ASSERT(!bvh->IsBuilt());
+      CPPUNIT_ASSERT_EQUAL(0U, bvh->GetNumTriangles());
+      CPPUNIT_ASSERT_EQUAL(0U, bvh->IntersectSegment(osg::Vec3(0.0f, 0.0f, 10.0f), osg::Vec3(0.0f, 0.0f, -10.0f), hits));
+   }
+
+   void TestMatchesBruteForce()
+   {
+      std::srand(7);
+
+      std::vector<osg::Vec3> verts;
+      std::vector<unsigned> indices;
+      AddHeightField(50, verts, indices);
+
+      RefPtr<TriangleBVH> bvh = new TriangleBVH;
+      bvh->AddTriangles(verts, indices);
+
+      std::vector<osg::Vec3> corners;
+      for (unsigned i = 0; i < indices.size(); ++i)
+      {
+         corners.push_back(verts[indices[i]]);
+      }
+
+      // Some scattered triangles overlapping the height field, like buildings on a terrain.
+      for (unsigned i = 0; i < 500; ++i)
+      {
+         osg::Vec3 center(RandomFloat(0.0f, 50.0f), RandomFloat(0.0f, 50.0f), RandomFloat(-10.0f, 10.0f));
+         osg::Vec3 tri[3];
+         for (unsigned j = 0; j < 3; ++j)
+         {
+            tri[j] = center + osg::Vec3(RandomFloat(-2.0f, 2.0f), RandomFloat(-2.0f, 2.0f), RandomFloat(-2.0f, 2.0f));
+            corners.push_back(tri[j]);
+         }
+         bvh->AddTriangle(tri[0], tri[1], tri[2]);
+      }
+
+      bvh->Build();
+      CPPUNIT_ASSERT_EQUAL(unsigned(corners.size() / 3), bvh->GetNumTriangles());
+      CPPUNIT_ASSERT(bvh->GetNumNodes() > 1U);
+      CPPUNIT_ASSERT(bvh->GetBoundingBox().contains(osg::Vec3(25.0f, 25.0f, 0.0f)));
+
+      TriangleBVH::HitList hits;
+      unsigned totalHits = 0;
+      for (unsigned i = 0; i < 2000; ++i)
+      {
+         osg::Vec3 start, end;
+         if (i % 2 == 0)
+         {
+            // Vertical, like ground clamping.
+            float x = RandomFloat(-1.0f, 51.0f), y = RandomFloat(-1.0f, 51.0f);
+            start.set(x, y, 100.0f);
+            end.set(x, y, -100.0f);
+         }
+         else
+         {
+            start.set(RandomFloat(-5.0f, 55.0f), RandomFloat(-5.0f, 55.0f), RandomFloat(-15.0f, 15.0f));
+            end.set(RandomFloat(-5.0f, 55.0f), RandomFloat(-5.0f, 55.0f), RandomFloat(-15.0f, 15.0f));
+         }
+
+         std::vector<float> expected = IntersectAll(corners, start, end);
+         CPPUNIT_ASSERT_EQUAL(unsigned(expected.size()), bvh->IntersectSegment(start, end, hits));
+         for (unsigned j = 0; j < hits.size(); ++j)
+         {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j], hits[j].mRatio, 1e-5f);
+            osg::Vec3 point = start + (end - start) * hits[j].mRatio;
+            CPPUNIT_ASSERT((point - hits[j].mPoint).length() < 1e-3f);
+         }
+         totalHits += unsigned(hits.size());
+      }
+      CPPUNIT_ASSERT(totalHits > 1000U);
+   }
+
+   void TestAddNode()
+   {
+      osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+      osg::ref_ptr<osg::Vec3Array> verts = new osg::Vec3Array;
+      verts->push_back(osg::Vec3(-1.0f, -1.0f, 0.0f));
+      verts->push_back(osg::Vec3(1.0f, -1.0f, 0.0f));
+      verts->push_back(osg::Vec3(1.0f, 1.0f, 0.0f));
+      verts->push_back(osg::Vec3(-1.0f, 1.0f, 0.0f));
+      geometry->setVertexArray(verts.get());
+      geometry->addPrimitiveSet(new osg::DrawArrays(osg::PrimitiveSet::QUADS, 0, 4));
+
+      osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+      geode->addDrawable(geometry.get());
+
+      osg::ref_ptr<osg::MatrixTransform> transform = new osg::MatrixTransform;
+      transform->setMatrix(osg::Matrix::translate(100.0f, 0.0f, 7.0f));
+      transform->addChild(geode.get());
+
+      RefPtr<TriangleBVH> bvh = new TriangleBVH;
+      bvh->AddNode(*transform);
+      bvh->Build();
+      CPPUNIT_ASSERT_EQUAL(2U, bvh->GetNumTriangles());
+
+      TriangleBVH::HitList hits;
+      CPPUNIT_ASSERT_EQUAL(0U, bvh->IntersectSegment(osg::Vec3(0.0f, 0.0f, 100.0f), osg::Vec3(0.0f, 0.0f, -100.0f), hits));
+      CPPUNIT_ASSERT_EQUAL(1U, bvh->IntersectSegment(osg::Vec3(100.5f, 0.25f, 100.0f), osg::Vec3(100.5f, 0.25f, -100.0f), hits));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(7.0f, hits[0].mPoint.z(), 1e-4f);
+   }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TriangleBVHTests);
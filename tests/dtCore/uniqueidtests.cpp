@@ -0,0 +1,232 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <dtCore/uniqueid.h>
+#include <dtCore/timer.h>
+#include <dtUtil/datastream.h>
+#include <dtUtil/hashmap.h>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+class UniqueIdTests : public CPPUNIT_NS::TestFixture
+{
+   CPPUNIT_TEST_SUITE(UniqueIdTests);
+      CPPUNIT_TEST(TestGeneratedIdsAreBinary);
+      CPPUNIT_TEST(TestStringRoundTrip);
+      CPPUNIT_TEST(TestLegacyIds);
+      CPPUNIT_TEST(TestOrdering);
+      CPPUNIT_TEST(TestBytes);
+      CPPUNIT_TEST(TestCompactDataStream);
+      //CPPUNIT_TEST(TestLookupPerformance); //disabled - just used for benchmarking
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void setUp() {}
+   void tearDown() {}
+
+   void TestGeneratedIdsAreBinary()
+   {
+      dtCore::UniqueId id;
+      CPPUNIT_ASSERT(!id.IsNull());
+      CPPUNIT_ASSERT(id.IsBinary());
+      CPPUNIT_ASSERT_EQUAL(size_t(36), id.ToString().size());
+
+      dtCore::UniqueId nullId(false);
+      CPPUNIT_ASSERT(nullId.IsNull());
+      CPPUNIT_ASSERT(!nullId.IsBinary());
+      CPPUNIT_ASSERT(nullId == dtCore::UniqueId(""));
+   }
+
+   void TestStringRoundTrip()
+   {
+      const std::string idString("8bc34d1e-0a55-4c68-a4b1-2f07cd6e9a03");
+      dtCore::UniqueId id(idString);
+      CPPUNIT_ASSERT(id.IsBinary());
+      CPPUNIT_ASSERT_EQUAL(idString, id.ToString());
+
+      dtCore::UniqueId copy(id.ToString());
+      CPPUNIT_ASSERT(copy == id);
+      CPPUNIT_ASSERT_EQUAL(id.GetHash(), copy.GetHash());
+
+      std::ostringstream ss;
+      ss << id;
+      dtCore::UniqueId streamed(false);
+      std::istringstream iss(ss.str());
+      iss >> streamed;
+      CPPUNIT_ASSERT(streamed == id);
+      CPPUNIT_ASSERT(streamed.IsBinary());
+
+      dtCore::UniqueId assigned(false);
+      assigned = idString;
+      CPPUNIT_ASSERT(assigned == id);
+   }
+
+   void TestLegacyIds()
+   {
+      dtCore::UniqueId legacy("my hand written id");
+      CPPUNIT_ASSERT(!legacy.IsBinary());
+      CPPUNIT_ASSERT_EQUAL(std::string("my hand written id"), legacy.ToString());
+
+      // Uppercase is kept as it was written so it saves back out the same.
+      const std::string upper("8BC34D1E-0A55-4C68-A4B1-2F07CD6E9A03");
+      dtCore::UniqueId upperId(upper);
+      CPPUNIT_ASSERT(!upperId.IsBinary());
+      CPPUNIT_ASSERT_EQUAL(upper, upperId.ToString());
+      CPPUNIT_ASSERT(upperId != dtCore::UniqueId("8bc34d1e-0a55-4c68-a4b1-2f07cd6e9a03"));
+
+      CPPUNIT_ASSERT(!dtCore::UniqueId("8bc34d1e-0a55-4c68-a4b1-2f07cd6e9a0").IsBinary());
+      CPPUNIT_ASSERT(!dtCore::UniqueId("8bc34d1e_0a55-4c68-a4b1-2f07cd6e9a03").IsBinary());
+      CPPUNIT_ASSERT(!dtCore::UniqueId("8bc34d1e-0a55-4c68-a4b1-2f07cd6e9a0g").IsBinary());
+
+      CPPUNIT_ASSERT(legacy == dtCore::UniqueId("my hand written id"));
+      CPPUNIT_ASSERT_EQUAL(legacy.GetHash(), dtCore::UniqueId("my hand written id").GetHash());
+   }
+
+   void TestOrdering()
+   {
+      std::vector<dtCore::UniqueId> ids;
+      for (unsigned i = 0; i < 200; ++i)
+      {
+         ids.push_back(dtCore::UniqueId());
+      }
+      ids.push_back(dtCore::UniqueId(false));
+      ids.push_back(dtCore::UniqueId("legacy"));
+      ids.push_back(dtCore::UniqueId("00000000-0000-0000-0000-000000000001"));
+      ids.push_back(dtCore::UniqueId("ffffffff-ffff-ffff-ffff-ffffffffffff"));
+
+      // The binary comparisons must order ids the same way the strings always have.
+      for (unsigned i = 0; i < ids.size(); ++i)
+      {
+         for (unsigned j = 0; j < ids.size(); ++j)
+         {
+            CPPUNIT_ASSERT_EQUAL(ids[i].ToString() < ids[j].ToString(), ids[i] < ids[j]);
+            CPPUNIT_ASSERT_EQUAL(ids[i].ToString() > ids[j].ToString(), ids[i] > ids[j]);
+            CPPUNIT_ASSERT_EQUAL(ids[i].ToString() == ids[j].ToString(), ids[i] == ids[j]);
+         }
+      }
+   }
+
+   void TestBytes()
+   {
+      dtCore::UniqueId id("00112233-4455-6677-8899-aabbccddeeff");
+      unsigned char bytes[dtCore::UniqueId::BINARY_SIZE];
+      CPPUNIT_ASSERT(id.GetBytes(bytes));
+      for (unsigned i = 0; i < dtCore::UniqueId::BINARY_SIZE; ++i)
+      {
+         CPPUNIT_ASSERT_EQUAL(unsigned(i * 0x11), unsigned(bytes[i]));
+      }
+
+      dtCore::UniqueId fromBytes(false);
+      fromBytes.SetBytes(bytes);
+      CPPUNIT_ASSERT(fromBytes == id);
+      CPPUNIT_ASSERT_EQUAL(id.ToString(), fromBytes.ToString());
+
+      CPPUNIT_ASSERT(!dtCore::UniqueId("legacy").GetBytes(bytes));
+   }
+
+   void TestCompactDataStream()
+   {
+      dtCore::UniqueId ids[] = { dtCore::UniqueId(), dtCore::UniqueId(false), dtCore::UniqueId("legacy") };
+      for (unsigned i = 0; i < 3; ++i)
+      {
+         dtUtil::DataStream ds;
+         ids[i].ToCompactDataStream(ds);
+         ds.Rewind();
+
+         dtCore::UniqueId read;
+         read.FromCompactDataStream(ds);
+         CPPUNIT_ASSERT(read == ids[i]);
+         CPPUNIT_ASSERT_EQUAL(ids[i].ToString(), read.ToString());
+         CPPUNIT_ASSERT_EQUAL(ids[i].IsBinary(), read.IsBinary());
+         CPPUNIT_ASSERT_EQUAL(0U, ds.GetRemainingReadSize());
+      }
+
+      dtUtil::DataStream compact, full;
+      ids[0].ToCompactDataStream(compact);
+      full << ids[0];
+      CPPUNIT_ASSERT_EQUAL(1U + dtCore::UniqueId::BINARY_SIZE, compact.GetBufferSize());
+      CPPUNIT_ASSERT(compact.GetBufferSize() < full.GetBufferSize());
+   }
+
+   void TestLookupPerformance()
+   {
+      const unsigned numIds = 10000;
+      const unsigned numLookups = 1000000;
+
+      std::vector<dtCore::UniqueId> ids;
+      std::vector<std::string> strings;
+      dtUtil::HashMap<dtCore::UniqueId, unsigned> idMap;
+      dtUtil::HashMap<std::string, unsigned> stringMap;
+      std::map<dtCore::UniqueId, unsigned> orderedMap;
+      for (unsigned i = 0; i < numIds; ++i)
+      {
+         ids.push_back(dtCore::UniqueId());
+         strings.push_back(ids.back().ToString());
+         idMap.insert(std::make_pair(ids.back(), i));
+         stringMap.insert(std::make_pair(strings.back(), i));
+         orderedMap.insert(std::make_pair(ids.back(), i));
+      }
+
+      dtCore::Timer timer;
+      unsigned found = 0;
+
+      dtCore::Timer_t start = timer.Tick();
+      for (unsigned i = 0; i < numLookups; ++i)
+      {
+         found += stringMap.find(strings[i % numIds])->second;
+      }
+      double stringMicros = timer.DeltaMicro(start, timer.Tick());
+
+      start = timer.Tick();
+      for (unsigned i = 0; i < numLookups; ++i)
+      {
+         found += idMap.find(ids[i % numIds])->second;
+      }
+      double hashMicros = timer.DeltaMicro(start, timer.Tick());
+
+      start = timer.Tick();
+      for (unsigned i = 0; i < numLookups; ++i)
+      {
+         found += orderedMap.find(ids[i % numIds])->second;
+      }
+      double orderedMicros = timer.DeltaMicro(start, timer.Tick());
+
+      dtUtil::DataStream compact, full;
+      ids[0].ToCompactDataStream(compact);
+      full << ids[0];
+
+      std::cout << std::endl << numLookups << " lookups in " << numIds << " ids (" << found << ")." << std::endl
+               << "String hash map: " << stringMicros * 1000.0 / double(numLookups) << " ns per lookup" << std::endl
+               << "UniqueId hash map: " << hashMicros * 1000.0 / double(numLookups) << " ns per lookup" << std::endl
+               << "UniqueId std::map: " << orderedMicros * 1000.0 / double(numLookups) << " ns per lookup" << std::endl
+               << "Encoded size: " << full.GetBufferSize() << " bytes as a string, "
+               << compact.GetBufferSize() << " bytes compact." << std::endl;
+   }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(UniqueIdTests);
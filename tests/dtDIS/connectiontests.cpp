@@ -23,11 +23,17 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 #include <dtDIS/connection.h>
+#include <dtDIS/mastercomponent.h>
 #include <DIS/DataStream.h>
+#include <DIS/EntityStatePdu.h>
+
+#include "initializepdu.h"
 
 #include <dtCore/timer.h>
 
 #include <cstdlib>  // for NULL
+#include <iostream>
+#include <vector>
 
 
 namespace dtDIS
@@ -40,9 +46,13 @@ namespace dtDIS
       void teardown(); 
 
       void TestConnection();
+      void TestReceiveBatch();
+      void TestReceiveBatchPerformance();
 
       CPPUNIT_TEST_SUITE( ConnectionTests );
          CPPUNIT_TEST( TestConnection );
+         CPPUNIT_TEST( TestReceiveBatch );
+         //CPPUNIT_TEST( TestReceiveBatchPerformance ); //disabled - just used for benchmarking
       CPPUNIT_TEST_SUITE_END();
    };
 
@@ -103,3 +113,135 @@ void ConnectionTests::TestConnection()
    discon.Disconnect();
 }
 
+
+void ConnectionTests::TestReceiveBatch()
+{
+   unsigned int inport( 1258 );
+   std::string host("234.235.236.237");
+   DIS::Endian endian(DIS::BIG);
+   const size_t mtu(1500);
+   const int numPackets(5);
+
+   dtDIS::Connection discon;
+   discon.Connect(inport, host.c_str(), false);
+
+   for (int i = 0; i < numPackets; ++i)
+   {
+      DIS::DataStream outbuf(endian);
+      outbuf << i;
+      discon.Send( &(outbuf[0]), outbuf.size() );
+   }
+
+   dtCore::AppSleep(1);
+
+   std::vector<char> buffer;
+   std::vector<size_t> sizes;
+
+   // a batch smaller than what is queued must leave the rest for the next read.
+   size_t r = discon.ReceiveBatch(buffer, sizes, mtu, 2);
+   CPPUNIT_ASSERT_EQUAL_MESSAGE("Wrong number of packets read. If 0, check your firewall settings.", size_t(2), r);
+   CPPUNIT_ASSERT_EQUAL(r, sizes.size());
+
+   r += discon.ReceiveBatch(buffer, sizes, mtu, numPackets);
+   CPPUNIT_ASSERT_EQUAL_MESSAGE("The second batch should drain the rest of the packets.", size_t(numPackets), r);
+
+   // the last packets read should be in order in their own slots.
+   for (size_t i = 0; i < sizes.size(); ++i)
+   {
+      CPPUNIT_ASSERT_EQUAL(sizeof(int), sizes[i]);
+
+      DIS::DataStream inbuf(endian);
+      inbuf.SetStream( &buffer[i * mtu], sizes[i], endian );
+      int value(-1);
+      inbuf >> value;
+      CPPUNIT_ASSERT_EQUAL( int(i + 2), value );
+   }
+
+   CPPUNIT_ASSERT_EQUAL_MESSAGE("Nothing should be left to read.",
+            size_t(0), discon.ReceiveBatch(buffer, sizes, mtu, numPackets));
+
+   // A PDU of the largest legal size must fit in a MasterComponent receive slot without looking truncated.
+   const size_t largestSize = MasterComponent::MAX_PACKET_SIZE;
+   std::vector<char> largest(largestSize, 'p');
+   discon.Send(&largest[0], largest.size());
+   dtCore::AppSleep(1);
+   CPPUNIT_ASSERT_EQUAL(size_t(1), discon.ReceiveBatch(buffer, sizes, MasterComponent::RECEIVE_SLOT_SIZE, numPackets));
+   CPPUNIT_ASSERT_EQUAL(largestSize, sizes[0]);
+
+   discon.Disconnect();
+}
+
+void ConnectionTests::TestReceiveBatchPerformance()
+{
+   unsigned int inport( 1258 );
+   std::string host("234.235.236.237");
+   DIS::Endian endian(DIS::BIG);
+   const size_t mtu(8192);
+
+   // replay rate and length of the stream, tweak these to match the exercise being simulated.
+   const unsigned packetsPerSecond(20000);
+   const unsigned ticksPerSecond(60);
+   const unsigned seconds(5);
+   const unsigned packetsPerTick = packetsPerSecond / ticksPerSecond;
+
+   dtDIS::Connection discon;
+   discon.Connect(inport, host.c_str(), false);
+
+   // the recorded stream is a single entity state repeated with a changing entity id.
+   DIS::EntityStatePdu pdu;
+   dtTest::InitializePdu()(pdu);
+
+   std::vector<char> buffer;
+   std::vector<size_t> sizes;
+
+   unsigned sent(0), received(0), singleReceived(0);
+   double batchTime(0.0), singleTime(0.0);
+   dtCore::Timer timer;
+
+   for (unsigned tick = 0; tick < ticksPerSecond * seconds; ++tick)
+   {
+      for (unsigned i = 0; i < packetsPerTick; ++i)
+      {
+         DIS::EntityID id = pdu.getEntityID();
+         id.setEntity((unsigned short)(sent & 0xFFFF));
+         pdu.setEntityID(id);
+
+         DIS::DataStream outbuf(endian);
+         pdu.marshal(outbuf);
+         discon.Send( &(outbuf[0]), outbuf.size() );
+         ++sent;
+      }
+
+      // alternate between the old single read per tick and the batch drain.
+      dtCore::Timer_t start = timer.Tick();
+      if (tick % 2 == 0)
+      {
+         char single[mtu];
+         if (discon.Receive(single, mtu) > 0)
+         {
+            ++singleReceived;
+         }
+         singleTime += timer.DeltaSec(start, timer.Tick());
+      }
+      else
+      {
+         size_t count = 0;
+         do
+         {
+            count = discon.ReceiveBatch(buffer, sizes, mtu, 64);
+            received += unsigned(count);
+         }
+         while (count == 64);
+         batchTime += timer.DeltaSec(start, timer.Tick());
+      }
+
+      dtCore::AppSleep(1000 / ticksPerSecond);
+   }
+
+   std::cout << std::endl
+             << "Sent " << sent << " entity state pdus at " << packetsPerSecond << " per second." << std::endl
+             << "Single reads: " << singleReceived << " packets in " << singleTime << " seconds." << std::endl
+             << "Batch reads: " << received << " packets in " << batchTime << " seconds." << std::endl;
+
+   discon.Disconnect();
+}
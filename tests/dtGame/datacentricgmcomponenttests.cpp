@@ -0,0 +1,194 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2013, David Guthrie
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <dtGame/datacentricgmcomponent.h>
+#include <dtGame/gamemanager.h>
+#include <dtGame/gameactorproxy.h>
+#include <dtActors/engineactorregistry.h>
+#include <dtUtil/threadpool.h>
+#include <osg/Timer>
+
+#include <cmath>
+#include <iostream>
+
+#include "basegmtests.h"
+
+namespace dtGame
+{
+   /// Stands in for an actor component with an update that costs a set amount of math.
+   class SyntheticActorComponent : public osg::Referenced
+   {
+   public:
+      SyntheticActorComponent(unsigned work)
+      : mWork(work)
+      , mUpdateCount(0U)
+      {
+      }
+
+      void Update(float dt)
+      {
+         volatile double sum = 0.0;
+         for (unsigned i = 0; i < mWork; ++i)
+         {
+            sum += std::sqrt(double(i));
+         }
+         ++mUpdateCount;
+      }
+
+      unsigned mWork;
+      unsigned mUpdateCount;
+   };
+
+   typedef DataCentricGMComponent<SyntheticActorComponent> SyntheticDataCentricComponent;
+
+   class DataCentricGMComponentTests : public BaseGMTestFixture
+   {
+      typedef BaseGMTestFixture BaseClass;
+
+      CPPUNIT_TEST_SUITE(DataCentricGMComponentTests);
+
+         CPPUNIT_TEST(TestRegistrationChanges);
+         CPPUNIT_TEST(TestUpdateCosts);
+         //CPPUNIT_TEST(TestSkewedUpdatePerformance); //disabled - just used for benchmarking
+
+      CPPUNIT_TEST_SUITE_END();
+
+      public:
+
+         /*override*/ void setUp()
+         {
+            BaseClass::setUp();
+            mComponent = new SyntheticDataCentricComponent("SyntheticDataCentricComponent");
+         }
+
+         /*override*/ void tearDown()
+         {
+            mComponent = NULL;
+            mActorComps.clear();
+            mActors.clear();
+            BaseClass::tearDown();
+         }
+
+         void TestRegistrationChanges()
+         {
+            CreateActors(100, 10, 1000U, 1000U);
+
+            mComponent->TickLocal(0.016f);
+            for (unsigned i = 0; i < mActorComps.size(); ++i)
+            {
+               CPPUNIT_ASSERT_EQUAL(1U, mActorComps[i]->mUpdateCount);
+            }
+
+            // Actors registered and unregistered after the first frame must be picked up.
+            CreateActors(10, 10, 1000U, 1000U);
+            CPPUNIT_ASSERT(mComponent->UnregisterActor(mActors[3]->GetId()));
+            mComponent->TickLocal(0.016f);
+            for (unsigned i = 0; i < mActorComps.size(); ++i)
+            {
+               unsigned expected = i < 100 ? 2U : 1U;
+               if (i == 3)
+               {
+                  expected = 1U;
+               }
+               CPPUNIT_ASSERT_EQUAL(expected, mActorComps[i]->mUpdateCount);
+            }
+
+            mComponent->ClearRegisteredActors();
+            mComponent->TickLocal(0.016f);
+            CPPUNIT_ASSERT_EQUAL(2U, mActorComps[0]->mUpdateCount);
+
+            std::vector<double> taskTimes;
+            mComponent->GetLastUpdateTaskTimes(taskTimes);
+            CPPUNIT_ASSERT(taskTimes.empty());
+            CPPUNIT_ASSERT_EQUAL(1.0, mComponent->GetLastUpdateImbalance());
+         }
+
+         void TestUpdateCosts()
+         {
+            CreateActors(40, 10, 200000U, 1000U);
+
+            for (unsigned frame = 0; frame < 5; ++frame)
+            {
+               mComponent->TickLocal(0.016f);
+            }
+
+            CPPUNIT_ASSERT(mComponent->GetUpdateCost(mActors[0]->GetId()) > mComponent->GetUpdateCost(mActors[1]->GetId()));
+            CPPUNIT_ASSERT_EQUAL(0.0f, mComponent->GetUpdateCost(dtCore::UniqueId()));
+
+            std::vector<double> taskTimes;
+            mComponent->GetLastUpdateTaskTimes(taskTimes);
+            CPPUNIT_ASSERT(!taskTimes.empty());
+            CPPUNIT_ASSERT(taskTimes.size() <= dtUtil::ThreadPool::GetNumImmediateWorkerThreads());
+            CPPUNIT_ASSERT(mComponent->GetLastUpdateImbalance() >= 1.0);
+         }
+
+         void TestSkewedUpdatePerformance()
+         {
+            // A few detailed characters among many cheap ones.
+            CreateActors(2000, 100, 500000U, 5000U);
+
+            osg::Timer* timer = osg::Timer::instance();
+            const unsigned numFrames = 60;
+            for (unsigned frame = 0; frame < numFrames; ++frame)
+            {
+               osg::Timer_t start = timer->tick();
+               mComponent->TickLocal(0.016f);
+               double millis = timer->delta_m(start, timer->tick());
+
+               // The first frame is chunked by count, since nothing has been measured yet.
+               if (frame == 0 || frame == numFrames - 1)
+               {
+                  std::cout << std::endl << (frame == 0 ? "Unmeasured" : "Balanced") << " frame, "
+                           << dtUtil::ThreadPool::GetNumImmediateWorkerThreads() << " threads: "
+                           << millis << " ms, imbalance " << mComponent->GetLastUpdateImbalance() << std::endl;
+               }
+            }
+         }
+
+      private:
+
+         /// Creates and registers numActors actors.  Every expensiveEvery'th one gets the expensive work.
+         void CreateActors(unsigned numActors, unsigned expensiveEvery, unsigned expensiveWork, unsigned cheapWork)
+         {
+            for (unsigned i = 0; i < numActors; ++i)
+            {
+               dtCore::RefPtr<GameActorProxy> actor;
+               mGM->CreateActor(*dtActors::EngineActorRegistry::GAME_MESH_ACTOR_TYPE, actor);
+               mActors.push_back(actor);
+
+               unsigned work = (i % expensiveEvery) == 0 ? expensiveWork : cheapWork;
+               mActorComps.push_back(new SyntheticActorComponent(work));
+               CPPUNIT_ASSERT(mComponent->RegisterActor(*actor, *mActorComps.back()));
+            }
+         }
+
+         dtCore::RefPtr<SyntheticDataCentricComponent> mComponent;
+         std::vector<dtCore::RefPtr<GameActorProxy> > mActors;
+         std::vector<dtCore::RefPtr<SyntheticActorComponent> > mActorComps;
+   };
+
+   CPPUNIT_TEST_SUITE_REGISTRATION(DataCentricGMComponentTests);
+}
@@ -28,6 +28,8 @@
 
 #include <prefix/unittestprefix.h>
 
+#include <iostream>
+
 #include <osg/Vec3>
 #include <osg/Math>
 #include <osg/Group>
@@ -37,10 +39,13 @@
 #include <dtUtil/mathdefines.h>
 
 #include <dtCore/system.h>
+#include <dtCore/timer.h>
 #include <dtCore/transform.h>
 #include <dtCore/transformable.h>
 #include <dtCore/scene.h>
 #include <dtUtil/nodecollector.h>
+#include <dtUtil/stringutils.h>
+#include <dtUtil/threadpool.h>
 #include <dtCore/batchisector.h>
 
 
@@ -157,6 +162,8 @@ namespace dtGame
          CPPUNIT_TEST(TestDoDRStatic);
          CPPUNIT_TEST(TestDoDRStaticInitialConditions);
          CPPUNIT_TEST(TestDoDRNoDR);
+         CPPUNIT_TEST(TestThreadedMatchesSerial);
+         //CPPUNIT_TEST(TestDeadReckoningPerformance); //disabled - just used for benchmarking
 
       CPPUNIT_TEST_SUITE_END();
 
@@ -796,8 +803,167 @@ namespace dtGame
                float(helper->GetAverageTimeBetweenRotationUpdates()), helper->GetRotationEndSmoothingTime());
          }
 
+         void TestThreadedMatchesSerial()
+         {
+            unsigned oldNumThreads = dtUtil::ThreadPool::IsInitialized() ? dtUtil::ThreadPool::GetNumImmediateWorkerThreads() : 0;
+            bool wasInitialized = dtUtil::ThreadPool::IsInitialized();
+
+            std::vector<dtCore::Transform> serial, threaded;
+            RunDeadReckoningFrames(0, serial);
+            RunDeadReckoningFrames(4, threaded);
+
+            dtUtil::ThreadPool::Shutdown();
+            if (wasInitialized)
+            {
+               dtUtil::ThreadPool::Init(oldNumThreads);
+            }
+
+            CPPUNIT_ASSERT_EQUAL(serial.size(), threaded.size());
+            for (unsigned i = 0; i < serial.size(); ++i)
+            {
+               osg::Vec3 serialPos, threadedPos, serialHPR, threadedHPR;
+               serial[i].Get(serialPos, serialHPR);
+               threaded[i].Get(threadedPos, threadedHPR);
+               CPPUNIT_ASSERT_MESSAGE("Actor " + dtUtil::ToString(i) + " should be dead reckoned to the same place with the thread pool.",
+                        serialPos == threadedPos && serialHPR == threadedHPR);
+            }
+
+            // It should have moved, or it's not testing anything.
+            osg::Vec3 endPos, hpr;
+            serial[1].Get(endPos, hpr);
+            CPPUNIT_ASSERT(endPos.y() > 0.1f);
+         }
+
+         void TestDeadReckoningPerformance()
+         {
+            const unsigned numActors = 5000;
+            const unsigned numFrames = 200;
+
+            std::vector<dtCore::RefPtr<DeadReckoningActorComponent> > helpers;
+            helpers.reserve(numActors);
+            for (unsigned i = 0; i < numActors; ++i)
+            {
+               dtCore::RefPtr<GameActorProxy> actor;
+               mGM->CreateActor(*dtActors::EngineActorRegistry::GAME_MESH_ACTOR_TYPE, actor);
+               mGM->AddActor(*actor, true, false);
+
+               dtCore::RefPtr<DeadReckoningActorComponent> helper = new DeadReckoningActorComponent;
+               helper->SetDeadReckoningAlgorithm(DeadReckoningAlgorithm::VELOCITY_AND_ACCELERATION);
+               helper->SetGroundClampType(dtGame::GroundClampTypeEnum::NONE);
+               helper->SetLastKnownTranslation(osg::Vec3(float(i), 0.0f, 0.0f));
+               helper->SetLastKnownVelocity(osg::Vec3(1.0f, 2.0f, 0.0f));
+               helper->SetLastKnownAngularVelocity(osg::Vec3(0.1f, 0.0f, 0.0f));
+               mDeadReckoningComponent->RegisterActor(*actor, *helper);
+               helpers.push_back(helper);
+            }
+
+            dtCore::RefPtr<dtGame::TickMessage> tickMessage;
+            mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::TICK_REMOTE, tickMessage);
+            tickMessage->SetDeltaSimTime(0.016f);
+
+            for (unsigned pass = 0; pass < 2; ++pass)
+            {
+               bool useThreadPool = pass == 1;
+               mDeadReckoningComponent->SetUseThreadPool(useThreadPool);
+
+               dtCore::Timer timer;
+               dtCore::Timer_t start = timer.Tick();
+               for (unsigned frame = 0; frame < numFrames; ++frame)
+               {
+                  // mark a tenth of the actors as updated each frame, like a network update would.
+                  for (unsigned i = frame % 10; i < numActors; i += 10)
+                  {
+                     helpers[i]->SetLastKnownVelocity(osg::Vec3(1.0f, 2.0f, float(frame % 3)));
+                  }
+                  tickMessage->SetSimulationTime(tickMessage->GetSimulationTime() + 0.016);
+                  mDeadReckoningComponent->ProcessMessage(*tickMessage);
+               }
+               double micros = timer.DeltaMicro(start, timer.Tick());
+
+               std::cout << std::endl << numActors << " actors, " << numFrames << " frames, "
+                        << (useThreadPool ? dtUtil::ThreadPool::GetNumImmediateWorkerThreads() : 1U) << " threads." << std::endl
+                        << "Microseconds per actor per frame: " << micros / double(numActors * numFrames) << std::endl;
+            }
+         }
+
       private:
 
+         /**
+          * Restarts the thread pool with the given number of workers, dead reckons a new set of remote actors for
+          * a few frames, then deletes them.
+          * @param transforms filled with the final transform of each actor.
+          */
+         void RunDeadReckoningFrames(unsigned numThreads, std::vector<dtCore::Transform>& transforms)
+         {
+            const unsigned numActors = 1000;
+            const unsigned numFrames = 10;
+
+            dtUtil::ThreadPool::Shutdown();
+            dtUtil::ThreadPool::Init(numThreads);
+            mDeadReckoningComponent->SetUseThreadPool(true);
+
+            std::vector<dtCore::RefPtr<GameActorProxy> > actors;
+            std::vector<dtCore::RefPtr<DeadReckoningActorComponent> > helpers;
+            for (unsigned i = 0; i < numActors; ++i)
+            {
+               dtCore::RefPtr<GameActorProxy> actor;
+               mGM->CreateActor(*dtActors::EngineActorRegistry::GAME_MESH_ACTOR_TYPE, actor);
+               mGM->AddActor(*actor, true, false);
+
+               dtCore::RefPtr<DeadReckoningActorComponent> helper = new DeadReckoningActorComponent;
+               switch (i % 3)
+               {
+               case 0:
+                  helper->SetDeadReckoningAlgorithm(DeadReckoningAlgorithm::VELOCITY_AND_ACCELERATION);
+                  break;
+               case 1:
+                  helper->SetDeadReckoningAlgorithm(DeadReckoningAlgorithm::VELOCITY_ONLY);
+                  break;
+               default:
+                  helper->SetDeadReckoningAlgorithm(DeadReckoningAlgorithm::STATIC);
+                  break;
+               }
+               helper->SetGroundClampType(dtGame::GroundClampTypeEnum::NONE);
+               helper->SetLastKnownTranslation(osg::Vec3(float(i), 0.0f, 0.0f));
+               helper->SetLastKnownRotation(osg::Vec3(float(i % 360), 0.0f, 0.0f));
+               helper->SetLastKnownVelocity(osg::Vec3(1.0f, 2.0f, 0.5f));
+               helper->SetLastKnownAcceleration(osg::Vec3(0.0f, 0.5f, 0.0f));
+               helper->SetLastKnownAngularVelocity(osg::Vec3(0.1f, 0.0f, 0.2f));
+               mDeadReckoningComponent->RegisterActor(*actor, *helper);
+               actors.push_back(actor);
+               helpers.push_back(helper);
+            }
+
+            dtCore::RefPtr<dtGame::TickMessage> tickMessage;
+            mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::TICK_REMOTE, tickMessage);
+            tickMessage->SetDeltaSimTime(0.05f);
+            tickMessage->SetSimulationTime(10.0);
+
+            for (unsigned frame = 0; frame < numFrames; ++frame)
+            {
+               // Some updates partway through, so the smoothing is run too.
+               if (frame == numFrames / 2)
+               {
+                  for (unsigned i = 0; i < numActors; i += 7)
+                  {
+                     helpers[i]->SetLastKnownTranslation(osg::Vec3(float(i), 1.0f, 0.0f));
+                     helpers[i]->SetLastKnownVelocity(osg::Vec3(0.0f, 3.0f, 0.0f));
+                  }
+               }
+               tickMessage->SetSimulationTime(tickMessage->GetSimulationTime() + 0.05);
+               mDeadReckoningComponent->ProcessMessage(*tickMessage);
+            }
+
+            transforms.resize(numActors);
+            for (unsigned i = 0; i < numActors; ++i)
+            {
+               actors[i]->GetDrawable<dtCore::Transformable>()->GetTransform(transforms[i]);
+               mDeadReckoningComponent->UnregisterActor(*actors[i]);
+               mGM->DeleteActor(*actors[i]);
+            }
+            dtCore::System::GetInstance().Step();
+         }
+
          void SimulateMapUnloaded()
          {
             dtGame::MessageFactory& msgFac = mGM->GetMessageFactory();
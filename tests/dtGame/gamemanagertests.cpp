@@ -44,6 +44,8 @@
 #include <dtCore/refptr.h>
 #include <dtCore/scene.h>
 #include <dtCore/system.h>
+#include <dtCore/timer.h>
+#include <dtCore/transform.h>
 
 #include <dtCore/actortype.h>
 #include <dtCore/datatype.h>
@@ -69,6 +71,7 @@
 #include <dtUtil/datapathutils.h>
 #include <dtUtil/datastream.h>
 #include <dtUtil/log.h>
+#include <dtUtil/stringutils.h>
 
 #include "basegmtests.h"
 
@@ -76,6 +79,7 @@
 #include <osg/io_utils>
 #include <osg/Math>
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 
@@ -104,6 +108,7 @@ class GameManagerTests : public dtGame::BaseGMTestFixture
         CPPUNIT_TEST(TestAddRemoveComponents);
         CPPUNIT_TEST(TestComponentPriority);
         CPPUNIT_TEST(TestFindActorById);
+        CPPUNIT_TEST(TestFindActorsWithinRadius);
         CPPUNIT_TEST(TestFindGameActorById);
         CPPUNIT_TEST(TestPrototypeActors);
         CPPUNIT_TEST(TestGMShutdown);
@@ -122,6 +127,9 @@ class GameManagerTests : public dtGame::BaseGMTestFixture
 
         CPPUNIT_TEST(TestSwitchToLocal);
         CPPUNIT_TEST(TestSwitchToRemote);
+
+        CPPUNIT_TEST(TestMessagePooling);
+        //CPPUNIT_TEST(TestMessageThroughputPerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -148,6 +156,7 @@ public:
    void TestAddRemoveComponents();
    void TestComponentPriority();
    void TestFindActorById();
+   void TestFindActorsWithinRadius();
    void TestFindGameActorById();
    void TestPrototypeActors();
    void TestGMShutdown();
@@ -167,6 +176,9 @@ public:
    void TestSwitchToLocal();
    void TestSwitchToRemote();
 
+   void TestMessagePooling();
+   void TestMessageThroughputPerformance();
+
 private:
 
 };
@@ -1594,6 +1606,53 @@ void GameManagerTests::TestTimers()
    CPPUNIT_ASSERT_MESSAGE("The number of received messages should be equal to the number of timers set", msgCount == numToTest);
 }
 
+/////////////////////////////////////////////////
+void GameManagerTests::TestFindActorsWithinRadius()
+{
+   const osg::Vec3 positions[] = { osg::Vec3(3.0f, 0.0f, 0.0f), osg::Vec3(0.0f, -4.0f, 1.0f), osg::Vec3(50.0f, 0.0f, 0.0f) };
+   dtCore::RefPtr<dtActors::GameMeshActor> actors[3];
+   for (unsigned i = 0; i < 3; ++i)
+   {
+      mGM->CreateActor(*dtActors::EngineActorRegistry::GAME_MESH_ACTOR_TYPE, actors[i]);
+      CPPUNIT_ASSERT(actors[i].valid());
+      mGM->AddActor(*actors[i], false, false);
+
+      dtCore::Transformable* drawable = NULL;
+      actors[i]->GetDrawable(drawable);
+      dtCore::Transform xform;
+      xform.SetTranslation(positions[i]);
+      drawable->SetTransform(xform);
+   }
+
+   // A part of an actor is in the scene, but it isn't an actor itself.
+   dtCore::RefPtr<dtCore::Transformable> part = new dtCore::Transformable("Part");
+   actors[2]->GetDrawable()->AddChild(part.get());
+   dtCore::Transform partXform;
+   partXform.SetTranslation(osg::Vec3(1.0f, 0.0f, 0.0f));
+   part->SetTransform(partXform);
+
+   dtCore::ActorPtrVector found;
+   mGM->FindActorsWithinRadius(osg::Vec3(), 5.0f, found);
+   CPPUNIT_ASSERT_EQUAL(size_t(2), found.size());
+   CPPUNIT_ASSERT(std::find(found.begin(), found.end(), actors[0].get()) != found.end());
+   CPPUNIT_ASSERT(std::find(found.begin(), found.end(), actors[1].get()) != found.end());
+
+   // A move earlier in the frame is seen without waiting for the scene to update the index.
+   dtCore::Transformable* farDrawable = NULL;
+   actors[2]->GetDrawable(farDrawable);
+   dtCore::Transform xform;
+   xform.SetTranslation(osg::Vec3(-2.0f, 0.0f, 0.0f));
+   farDrawable->SetTransform(xform);
+
+   mGM->FindActorsWithinRadius(osg::Vec3(), 5.0f, found);
+   CPPUNIT_ASSERT_MESSAGE("The vector should be cleared first.", found.size() == 3);
+
+   mGM->FindActorsWithinRadius(osg::Vec3(100.0f, 0.0f, 0.0f), 5.0f, found);
+   CPPUNIT_ASSERT(found.empty());
+
+   actors[2]->GetDrawable()->RemoveChild(part.get());
+}
+
 /////////////////////////////////////////////////
 void GameManagerTests::TestFindActorById()
 {
@@ -2197,3 +2256,116 @@ void GameManagerTests::TestSwitchToRemote()
    CPPUNIT_ASSERT(gameMeshActor->GetDrawable()->GetSceneParent() != NULL);
    CPPUNIT_ASSERT(!gameMeshActor->IsPublished());
 }
+
+void GameManagerTests::TestMessagePooling()
+{
+   dtCore::RefPtr<dtGame::MachineInfo> machine = new dtGame::MachineInfo("pool test");
+   dtGame::MessageFactory factory("pool test", *machine);
+
+   CPPUNIT_ASSERT(!factory.IsMessageTypePooled(dtGame::MessageType::TICK_LOCAL));
+   factory.SetMessageTypePooled(dtGame::MessageType::TICK_LOCAL, true);
+   CPPUNIT_ASSERT(factory.IsMessageTypePooled(dtGame::MessageType::TICK_LOCAL));
+
+   dtCore::RefPtr<dtGame::TickMessage> tick;
+   factory.CreateMessage(dtGame::MessageType::TICK_LOCAL, tick);
+   dtGame::TickMessage* firstTick = tick.get();
+   tick->SetDeltaSimTime(3.0f);
+   tick->SetSimTimeScale(2.0f);
+   tick->SetAboutActorId(dtCore::UniqueId());
+   tick->SetDestination(&mGM->GetMachineInfo());
+   tick->SetCausingMessage(factory.CreateMessage(dtGame::MessageType::INFO_PAUSED).get());
+
+   dtCore::RefPtr<dtGame::TickMessage> tick2;
+   factory.CreateMessage(dtGame::MessageType::TICK_LOCAL, tick2);
+   CPPUNIT_ASSERT_MESSAGE("A message that is still referenced may not be reused.", tick2.get() != firstTick);
+   CPPUNIT_ASSERT_EQUAL(3U, factory.GetNumMessagesAllocated());
+   CPPUNIT_ASSERT_EQUAL(0U, factory.GetNumMessagesRecycled());
+
+   tick = NULL;
+   factory.CreateMessage(dtGame::MessageType::TICK_LOCAL, tick);
+   CPPUNIT_ASSERT_MESSAGE("A released message should be reused.", tick.get() == firstTick);
+   CPPUNIT_ASSERT_EQUAL(3U, factory.GetNumMessagesAllocated());
+   CPPUNIT_ASSERT_EQUAL(1U, factory.GetNumMessagesRecycled());
+
+   // It should look the same as a new one.
+   CPPUNIT_ASSERT(tick->GetMessageType() == dtGame::MessageType::TICK_LOCAL);
+   CPPUNIT_ASSERT_EQUAL(0.0f, tick->GetDeltaSimTime());
+   CPPUNIT_ASSERT_EQUAL(1.0f, tick->GetSimTimeScale());
+   CPPUNIT_ASSERT(tick->GetAboutActorId().ToString().empty());
+   CPPUNIT_ASSERT(tick->GetDestination() == NULL);
+   CPPUNIT_ASSERT(tick->GetCausingMessage() == NULL);
+   CPPUNIT_ASSERT(tick->GetSource() == *machine);
+
+   // Types that aren't pooled are always allocated.
+   factory.ResetPoolStatistics();
+   dtCore::RefPtr<dtGame::Message> paused = factory.CreateMessage(dtGame::MessageType::INFO_PAUSED);
+   paused = factory.CreateMessage(dtGame::MessageType::INFO_PAUSED);
+   CPPUNIT_ASSERT_EQUAL(2U, factory.GetNumMessagesAllocated());
+   CPPUNIT_ASSERT_EQUAL(0U, factory.GetNumMessagesRecycled());
+
+   factory.SetMessageTypePooled(dtGame::MessageType::TICK_LOCAL, false);
+   CPPUNIT_ASSERT(!factory.IsMessageTypePooled(dtGame::MessageType::TICK_LOCAL));
+   tick = NULL;
+   factory.CreateMessage(dtGame::MessageType::TICK_LOCAL, tick);
+   CPPUNIT_ASSERT_EQUAL(0U, factory.GetNumMessagesRecycled());
+
+   // The game manager pools its tick messages, so a steady frame shouldn't allocate them.
+   mGM->RemoveComponent(*mTestComp);
+   dtCore::System::GetInstance().Step(0.016f);
+   mGM->GetMessageFactory().ResetPoolStatistics();
+   dtCore::System::GetInstance().Step(0.016f);
+   CPPUNIT_ASSERT_EQUAL(0U, mGM->GetMessageFactory().GetNumMessagesAllocated());
+   CPPUNIT_ASSERT(mGM->GetMessageFactory().GetNumMessagesRecycled() >= 3U);
+}
+
+void GameManagerTests::TestMessageThroughputPerformance()
+{
+   const unsigned numComponents = 50;
+   const unsigned numActors = 500;
+   const unsigned numFrames = 500;
+   const unsigned messagesPerFrame = 100;
+
+   // the test component keeps every message it gets.
+   mGM->RemoveComponent(*mTestComp);
+
+   for (unsigned i = 0; i < numComponents; ++i)
+   {
+      dtCore::RefPtr<TestOrderComponent> component = new TestOrderComponent();
+      component->SetName("throughput" + dtUtil::ToString(i));
+      mGM->AddComponent(*component, dtGame::GameManager::ComponentPriority::NORMAL);
+   }
+
+   for (unsigned i = 0; i < numActors; ++i)
+   {
+      dtCore::RefPtr<dtGame::GameActorProxy> actor;
+      mGM->CreateActor(*TestGameActorLibrary::TEST1_GAME_ACTOR_TYPE, actor);
+      mGM->AddActor(*actor, false, false);
+   }
+
+   dtCore::System::GetInstance().Step(0.016f);
+   mGM->GetMessageFactory().ResetPoolStatistics();
+
+   dtCore::Timer timer;
+   dtCore::Timer_t start = timer.Tick();
+   for (unsigned frame = 0; frame < numFrames; ++frame)
+   {
+      for (unsigned i = 0; i < messagesPerFrame; ++i)
+      {
+         dtCore::RefPtr<dtGame::Message> msg;
+         mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_GAME_EVENT, msg);
+         mGM->SendMessage(*msg);
+      }
+      dtCore::System::GetInstance().Step(0.016f);
+   }
+   double seconds = timer.DeltaSec(start, timer.Tick());
+
+   // the tick local, tick remote, end of frame and system messages, plus the ones sent each frame
+   const unsigned gmMessagesPerFrame = 6 + messagesPerFrame;
+   double messagesPerSecond = double(numFrames * gmMessagesPerFrame) / seconds;
+   double allocationsPerFrame = double(mGM->GetMessageFactory().GetNumMessagesAllocated()) / double(numFrames);
+   double recycledPerFrame = double(mGM->GetMessageFactory().GetNumMessagesRecycled()) / double(numFrames);
+
+   std::cout << std::endl << numComponents << " components, " << numActors << " actors, " << numFrames << " frames." << std::endl
+            << "Messages per second: " << messagesPerSecond << std::endl
+            << "Message allocations per frame: " << allocationsPerFrame << ", reused per frame: " << recycledPerFrame << std::endl;
+}
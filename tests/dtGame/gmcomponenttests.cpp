@@ -32,14 +32,20 @@
 #include <dtCore/system.h>
 #include <dtGame/gamemanager.h>
 #include <dtGame/gmcomponent.h>
+#include <dtGame/message.h>
+#include <dtGame/messagetype.h>
 #include <dtUtil/stringutils.h>
 
+#include <map>
+
 class GMComponentTests : public CPPUNIT_NS::TestFixture
 {
    CPPUNIT_TEST_SUITE(GMComponentTests);
    CPPUNIT_TEST(TestComponentRemovingItselfDuringMessage);
    CPPUNIT_TEST(TestComponentRemovingAnotherDuringMessage);
    CPPUNIT_TEST(TestComponentAddingAnotherDuringMessage);
+   CPPUNIT_TEST(TestComponentMessageSubscriptions);
+   CPPUNIT_TEST(TestComponentShutdownDuringSubscribedMessage);
    //CPPUNIT_TEST(TestComponentMessagePerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
@@ -50,6 +56,8 @@ public:
    void TestComponentRemovingItselfDuringMessage();
    void TestComponentRemovingAnotherDuringMessage();
    void TestComponentAddingAnotherDuringMessage();
+   void TestComponentMessageSubscriptions();
+   void TestComponentShutdownDuringSubscribedMessage();
    void TestComponentMessagePerformance();
 };
 
@@ -194,6 +202,129 @@ void GMComponentTests::TestComponentAddingAnotherDuringMessage()
    scene = NULL;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+class CountingComp : public dtGame::GMComponent
+{
+public:
+   CountingComp(const std::string& name):
+      dtGame::GMComponent(name)
+      {}
+
+      virtual void ProcessMessage(const dtGame::Message& message)
+      {
+         ++mCounts[&message.GetMessageType()];
+      }
+
+      unsigned GetCount(const dtGame::MessageType& type) const
+      {
+         std::map<const dtGame::MessageType*, unsigned>::const_iterator found = mCounts.find(&type);
+         return found == mCounts.end() ? 0U : found->second;
+      }
+
+      unsigned GetNumTypes() const { return unsigned(mCounts.size()); }
+
+      std::map<const dtGame::MessageType*, unsigned> mCounts;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+void GMComponentTests::TestComponentMessageSubscriptions()
+{
+   dtCore::RefPtr<dtCore::Scene> scene = new dtCore::Scene();
+   dtCore::RefPtr<dtGame::GameManager> gm = new dtGame::GameManager(*scene);
+
+   dtCore::RefPtr<CountingComp> subscriber = new CountingComp("subscriber");
+   dtCore::RefPtr<CountingComp> everything = new CountingComp("everything");
+
+   CPPUNIT_ASSERT(subscriber->GetReceivesAllMessages());
+   CPPUNIT_ASSERT(subscriber->IsSubscribedToMessageType(dtGame::MessageType::INFO_GAME_EVENT));
+
+   subscriber->SubscribeToMessageType(dtGame::MessageType::TICK_LOCAL);
+   subscriber->SubscribeToMessageType(dtGame::MessageType::TICK_LOCAL);
+   CPPUNIT_ASSERT(!subscriber->GetReceivesAllMessages());
+   CPPUNIT_ASSERT_EQUAL(size_t(1), subscriber->GetSubscribedMessageTypes().size());
+   CPPUNIT_ASSERT(subscriber->IsSubscribedToMessageType(dtGame::MessageType::TICK_LOCAL));
+   CPPUNIT_ASSERT(!subscriber->IsSubscribedToMessageType(dtGame::MessageType::INFO_GAME_EVENT));
+
+   gm->AddComponent(*subscriber, dtGame::GameManager::ComponentPriority::HIGHER);
+   gm->AddComponent(*everything);
+
+   dtCore::System::GetInstance().Start();
+   dtCore::System::GetInstance().Step();
+
+   CPPUNIT_ASSERT_EQUAL(1U, subscriber->GetCount(dtGame::MessageType::TICK_LOCAL));
+   CPPUNIT_ASSERT_EQUAL_MESSAGE("The subscriber should only get the type it subscribed to.", 1U, subscriber->GetNumTypes());
+   CPPUNIT_ASSERT_EQUAL(1U, everything->GetCount(dtGame::MessageType::TICK_LOCAL));
+   CPPUNIT_ASSERT(everything->GetCount(dtGame::MessageType::TICK_REMOTE) > 0U);
+
+   // subscribing after being added should take effect on the next message.
+   subscriber->SubscribeToMessageType(dtGame::MessageType::TICK_REMOTE);
+   dtCore::System::GetInstance().Step();
+   CPPUNIT_ASSERT_EQUAL(2U, subscriber->GetCount(dtGame::MessageType::TICK_LOCAL));
+   CPPUNIT_ASSERT_EQUAL(1U, subscriber->GetCount(dtGame::MessageType::TICK_REMOTE));
+   CPPUNIT_ASSERT_EQUAL(2U, subscriber->GetNumTypes());
+
+   subscriber->UnsubscribeFromMessageType(dtGame::MessageType::TICK_LOCAL);
+   dtCore::System::GetInstance().Step();
+   CPPUNIT_ASSERT_EQUAL(2U, subscriber->GetCount(dtGame::MessageType::TICK_LOCAL));
+   CPPUNIT_ASSERT_EQUAL(2U, subscriber->GetCount(dtGame::MessageType::TICK_REMOTE));
+
+   // With no subscriptions left, it goes back to getting everything.
+   subscriber->UnsubscribeFromMessageType(dtGame::MessageType::TICK_REMOTE);
+   CPPUNIT_ASSERT(subscriber->GetReceivesAllMessages());
+   subscriber->mCounts.clear();
+   everything->mCounts.clear();
+   dtCore::System::GetInstance().Step();
+   CPPUNIT_ASSERT(subscriber->mCounts == everything->mCounts);
+
+   gm->Shutdown();
+   gm = NULL;
+   scene = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void GMComponentTests::TestComponentShutdownDuringSubscribedMessage()
+{
+   dtCore::RefPtr<dtCore::Scene> scene = new dtCore::Scene();
+   dtCore::RefPtr<dtGame::GameManager> gm = new dtGame::GameManager(*scene);
+
+   class ShutdownComp : public dtGame::GMComponent
+   {
+   public:
+      ShutdownComp():
+         dtGame::GMComponent("ShutdownComp")
+         {}
+
+         virtual void ProcessMessage(const dtGame::Message& message)
+         {
+            GetGameManager()->Shutdown();
+         }
+   };
+
+   dtCore::RefPtr<ShutdownComp> shutdownComp = new ShutdownComp();
+   shutdownComp->SubscribeToMessageType(dtGame::MessageType::TICK_LOCAL);
+   dtCore::RefPtr<CountingComp> after = new CountingComp("after");
+   after->SubscribeToMessageType(dtGame::MessageType::TICK_LOCAL);
+
+   gm->AddComponent(*shutdownComp, dtGame::GameManager::ComponentPriority::HIGHEST);
+   gm->AddComponent(*after, dtGame::GameManager::ComponentPriority::LOWEST);
+
+   dtCore::System::GetInstance().Start();
+   // ShutdownComp shuts the GM down in the middle of walking the subscribers.
+   dtCore::System::GetInstance().Step();
+
+   CPPUNIT_ASSERT_EQUAL_MESSAGE("The dispatch should stop once the GM is shut down.",
+                                0U, after->GetCount(dtGame::MessageType::TICK_LOCAL));
+   CPPUNIT_ASSERT(shutdownComp->GetGameManager() == NULL);
+   CPPUNIT_ASSERT(after->GetGameManager() == NULL);
+
+   std::vector<dtGame::GMComponent*> comps;
+   gm->GetAllComponents(comps);
+   CPPUNIT_ASSERT(comps.empty());
+
+   gm = NULL;
+   scene = NULL;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void GMComponentTests::TestComponentMessagePerformance()
 {
@@ -42,6 +42,7 @@
 #include <dtCore/scene.h>
 #include <dtCore/infiniteterrain.h>
 #include <dtCore/system.h>
+#include <dtCore/trianglebvh.h>
 
 #include <dtGame/basemessages.h>
 #include <dtGame/gameactorproxy.h>
@@ -57,6 +58,11 @@
 
 #include <dtABC/application.h>
 
+#include <osg/Timer>
+
+#include <cstdlib>
+#include <iostream>
+
 #include "basegmtests.h"
 extern dtABC::Application& GetGlobalApplication();
 
@@ -142,6 +148,11 @@ namespace dtGame
             return BaseClass::GetOrCreateRuntimeData(data);
          }
 
+         dtCore::TriangleBVH* GetOrBuildTerrainBVH()
+         {
+            return BaseClass::GetOrBuildTerrainBVH();
+         }
+
       protected:
          virtual ~TestClamper()
          {
@@ -171,6 +182,11 @@ namespace dtGame
          CPPUNIT_TEST(TestClampThreePoint);
          CPPUNIT_TEST(TestClampIntermittent);
          CPPUNIT_TEST(TestClampTransformUnchanged);
+         CPPUNIT_TEST(TestTerrainBVHProperties);
+         CPPUNIT_TEST(TestClampWithTerrainBVH);
+         CPPUNIT_TEST(TestCoherentClamp);
+         CPPUNIT_TEST(TestCoherentClampAfterBVHChange);
+         //CPPUNIT_TEST(TestClampPerformance); //disabled - just used for benchmarking
 
       CPPUNIT_TEST_SUITE_END();
 
@@ -230,6 +246,32 @@ namespace dtGame
             dtCore::System::GetInstance().Step();
          }
 
+         ///////////////////////////////////////////////////////////////////////
+         dtCore::RefPtr<dtCore::TriangleBVH> CreateFlatBVH(float height)
+         {
+            dtCore::RefPtr<dtCore::TriangleBVH> bvh = new dtCore::TriangleBVH;
+            bvh->AddTriangle(osg::Vec3(-10.0f, -10.0f, height), osg::Vec3(10.0f, -10.0f, height), osg::Vec3(0.0f, 10.0f, height));
+            return bvh;
+         }
+
+         ///////////////////////////////////////////////////////////////////////
+         /// Runs a one point clamp of the test actor from the position and returns the height it ends up at.
+         float ClampOnePoint(const osg::Vec3& position, GroundClampingData& data,
+            DefaultGroundClamper::RuntimeData& runtimeData, double simTime)
+         {
+            dtCore::Transform xform;
+            xform.SetTranslation(position);
+            mGroundClamper->ClampToGroundIntermittent(simTime, xform, *mTestGameActor, data, runtimeData);
+            mGroundClamper->FinishUp();
+
+            dtCore::Transformable* txable = NULL;
+            mTestGameActor->GetDrawable(txable);
+            txable->GetTransform(xform);
+            osg::Vec3 pos;
+            xform.GetTranslation(pos);
+            return pos.z();
+         }
+
          ///////////////////////////////////////////////////////////////////////
          bool IsEqual(const osg::Vec3& result, const osg::Vec3& testValue, float errorTolerance = 0.00001f)
          {
@@ -1020,6 +1062,263 @@ namespace dtGame
             CPPUNIT_ASSERT(CompareMatrices(forcedRotation, rotation, errorThreshold));
          }
 
+         ///////////////////////////////////////////////////////////////////////
+         void TestTerrainBVHProperties()
+         {
+            CPPUNIT_ASSERT(!mGroundClamper->GetUseTerrainBVH());
+            CPPUNIT_ASSERT(mGroundClamper->GetTerrainBVH() == NULL);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(0.01f, mGroundClamper->GetCoherenceDistance(), 0.0001f);
+            unsigned isectorBatchSize = mGroundClamper->GetMaxClampBatchSize();
+
+            mGroundClamper->SetUseTerrainBVH(true);
+            CPPUNIT_ASSERT(mGroundClamper->GetUseTerrainBVH());
+            CPPUNIT_ASSERT(mGroundClamper->GetMaxClampBatchSize() > isectorBatchSize);
+            mGroundClamper->SetUseTerrainBVH(false);
+            CPPUNIT_ASSERT_EQUAL(isectorBatchSize, mGroundClamper->GetMaxClampBatchSize());
+
+            mGroundClamper->SetCoherenceDistance(0.5f);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5f, mGroundClamper->GetCoherenceDistance(), 0.0001f);
+
+            // A tree from elsewhere, such as physics vertex data, turns it on and is a surface by itself.
+            CPPUNIT_ASSERT(!mGroundClamper->HasValidSurface());
+            dtCore::RefPtr<dtCore::TriangleBVH> bvh = new dtCore::TriangleBVH;
+            bvh->AddTriangle(osg::Vec3(-10.0f, -10.0f, 3.0f), osg::Vec3(10.0f, -10.0f, 3.0f), osg::Vec3(0.0f, 10.0f, 3.0f));
+            mGroundClamper->SetTerrainBVH(bvh.get());
+            CPPUNIT_ASSERT(mGroundClamper->GetUseTerrainBVH());
+            CPPUNIT_ASSERT(mGroundClamper->GetTerrainBVH() == bvh.get());
+            CPPUNIT_ASSERT(mGroundClamper->HasValidSurface());
+
+            GroundClampingData data;
+            data.SetGroundClampType(dtGame::GroundClampTypeEnum::FULL);
+            dtCore::Transform xform;
+            osg::Vec3 points[3];
+            mGroundClamper->GetSurfacePoints(*mTestGameActor, data, xform, points);
+            CPPUNIT_ASSERT(bvh->IsBuilt());
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0f, points[0].z(), 0.0001f);
+
+            mGroundClamper->RebuildTerrainBVH();
+            CPPUNIT_ASSERT(mGroundClamper->GetTerrainBVH() == NULL);
+            CPPUNIT_ASSERT(!mGroundClamper->HasValidSurface());
+         }
+
+         ///////////////////////////////////////////////////////////////////////
+         void TestClampWithTerrainBVH()
+         {
+            dtCore::RefPtr<dtActors::InfiniteTerrainActorProxy> terrainActor;
+            dtCore::InfiniteTerrain* terrain = NULL;
+            CreateTestTerrain(terrainActor, terrain);
+            mGroundClamper->SetTerrainActor(terrain);
+            mGroundClamper->SetUseTerrainBVH(true);
+            mGroundClamper->SetIntermittentGroundClampingTimeDelta(0.0f);
+
+            dtCore::Transformable* txable = NULL;
+            mTestGameActor->GetDrawable(txable);
+
+            // One point clamps through the batch.
+            const float errorTolerance = 0.1f;
+            osg::Vec3 positions[2] = { osg::Vec3(10.0f, 10.0f, 0.0f), osg::Vec3(-40.0f, 25.0f, 0.0f) };
+            for (unsigned i = 0; i < 2; ++i)
+            {
+               GroundClampingData data;
+               data.SetGroundClampType(dtGame::GroundClampTypeEnum::FULL);
+               DefaultGroundClamper::RuntimeData& runtimeData = mGroundClamper->GetOrCreateRuntimeData(data);
+
+               dtCore::Transform xform;
+               xform.SetTranslation(positions[i]);
+               mGroundClamper->ClampToGroundIntermittent(1.0, xform, *mTestGameActor, data, runtimeData);
+               mGroundClamper->FinishUp();
+
+               txable->GetTransform(xform);
+               osg::Vec3 pos;
+               xform.GetTranslation(pos);
+               CPPUNIT_ASSERT_DOUBLES_EQUAL(terrain->GetHeight(positions[i].x(), positions[i].y(), true), pos.z(), errorTolerance);
+               CPPUNIT_ASSERT(runtimeData.IsLastClampedHitValid());
+               CPPUNIT_ASSERT(IsEqual(positions[i], runtimeData.GetLastClampedPosition()));
+            }
+
+            CPPUNIT_ASSERT(mGroundClamper->GetTerrainBVH() != NULL);
+            CPPUNIT_ASSERT(mGroundClamper->GetTerrainBVH()->GetNumTriangles() > 0U);
+            CPPUNIT_ASSERT_EQUAL(2U, mGroundClamper->GetNumClampQueries());
+
+            // Three point clamps must find the same points as the scene graph isector.
+            GroundClampingData data;
+            data.SetGroundClampType(dtGame::GroundClampTypeEnum::FULL);
+            dtCore::Transform xform;
+            osg::Vec3 bvhPoints[3], isectorPoints[3];
+            bvhPoints[0].set(-100.0f, -50.0f, 0.0f);
+            bvhPoints[1].set(100.0f, -50.0f, 0.0f);
+            bvhPoints[2].set(0.0f, 100.0f, 0.0f);
+            for (unsigned i = 0; i < 3; ++i)
+            {
+               isectorPoints[i] = bvhPoints[i];
+            }
+
+            mGroundClamper->GetSurfacePoints(*mTestGameActor, data, xform, bvhPoints);
+            mGroundClamper->SetUseTerrainBVH(false);
+            mGroundClamper->GetSurfacePoints(*mTestGameActor, data, xform, isectorPoints);
+            for (unsigned i = 0; i < 3; ++i)
+            {
+               CPPUNIT_ASSERT(isectorPoints[i].z() != 0.0f);
+               CPPUNIT_ASSERT(IsEqual(isectorPoints[i], bvhPoints[i], 0.001f));
+            }
+         }
+
+         ///////////////////////////////////////////////////////////////////////
+         void TestCoherentClamp()
+         {
+            dtCore::RefPtr<dtActors::InfiniteTerrainActorProxy> terrainActor;
+            dtCore::InfiniteTerrain* terrain = NULL;
+            CreateTestTerrain(terrainActor, terrain);
+            mGroundClamper->SetTerrainActor(terrain);
+            mGroundClamper->SetUseTerrainBVH(true);
+            mGroundClamper->SetIntermittentGroundClampingTimeDelta(0.0f);
+            mGroundClamper->SetCoherenceDistance(0.05f);
+
+            dtCore::Transformable* txable = NULL;
+            mTestGameActor->GetDrawable(txable);
+
+            GroundClampingData data;
+            data.SetGroundClampType(dtGame::GroundClampTypeEnum::FULL);
+            DefaultGroundClamper::RuntimeData& runtimeData = mGroundClamper->GetOrCreateRuntimeData(data);
+
+            osg::Vec3 start(10.0f, 10.0f, 0.0f);
+            const float groundZ = terrain->GetHeight(start.x(), start.y(), true);
+            const float errorTolerance = 0.1f;
+
+            // A few small steps reuse the first hit, since they are measured from where it was found.
+            for (unsigned i = 0; i < 4; ++i)
+            {
+               dtCore::Transform xform;
+               xform.SetTranslation(start + osg::Vec3(0.01f * float(i), 0.0f, 0.0f));
+               mGroundClamper->ClampToGroundIntermittent(double(i + 1), xform, *mTestGameActor, data, runtimeData);
+               mGroundClamper->FinishUp();
+
+               txable->GetTransform(xform);
+               osg::Vec3 pos;
+               xform.GetTranslation(pos);
+               CPPUNIT_ASSERT_DOUBLES_EQUAL(groundZ, pos.z(), errorTolerance);
+               CPPUNIT_ASSERT_DOUBLES_EQUAL(start.x() + 0.01f * float(i), pos.x(), 0.0001f);
+            }
+            CPPUNIT_ASSERT_EQUAL(1U, mGroundClamper->GetNumClampQueries());
+            CPPUNIT_ASSERT_EQUAL(3U, mGroundClamper->GetNumCoherentClamps());
+
+            // Moving away runs the clamp again.
+            osg::Vec3 moved(60.0f, -30.0f, 0.0f);
+            dtCore::Transform xform;
+            xform.SetTranslation(moved);
+            mGroundClamper->ClampToGroundIntermittent(10.0, xform, *mTestGameActor, data, runtimeData);
+            mGroundClamper->FinishUp();
+            CPPUNIT_ASSERT_EQUAL(2U, mGroundClamper->GetNumClampQueries());
+            txable->GetTransform(xform);
+            osg::Vec3 pos;
+            xform.GetTranslation(pos);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(terrain->GetHeight(moved.x(), moved.y(), true), pos.z(), errorTolerance);
+
+            // With coherence off, every clamp runs.
+            mGroundClamper->ResetClampCounts();
+            mGroundClamper->SetCoherenceDistance(0.0f);
+            xform.SetTranslation(moved);
+            mGroundClamper->ClampToGroundIntermittent(11.0, xform, *mTestGameActor, data, runtimeData);
+            mGroundClamper->FinishUp();
+            CPPUNIT_ASSERT_EQUAL(1U, mGroundClamper->GetNumClampQueries());
+            CPPUNIT_ASSERT_EQUAL(0U, mGroundClamper->GetNumCoherentClamps());
+         }
+
+         ///////////////////////////////////////////////////////////////////////
+         void TestCoherentClampAfterBVHChange()
+         {
+            mGroundClamper->SetIntermittentGroundClampingTimeDelta(0.0f);
+            mGroundClamper->SetCoherenceDistance(0.05f);
+
+            GroundClampingData data;
+            data.SetGroundClampType(dtGame::GroundClampTypeEnum::FULL);
+            DefaultGroundClamper::RuntimeData& runtimeData = mGroundClamper->GetOrCreateRuntimeData(data);
+
+            // The actor never moves, so only a change of the tree should make it clamp again.
+            const osg::Vec3 position(1.0f, 1.0f, 0.0f);
+            dtCore::RefPtr<dtCore::TriangleBVH> bvh = CreateFlatBVH(3.0f);
+            mGroundClamper->SetTerrainBVH(bvh.get());
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0f, ClampOnePoint(position, data, runtimeData, 1.0), 0.0001f);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0f, ClampOnePoint(position, data, runtimeData, 2.0), 0.0001f);
+            CPPUNIT_ASSERT_EQUAL(1U, mGroundClamper->GetNumClampQueries());
+            CPPUNIT_ASSERT_EQUAL(1U, mGroundClamper->GetNumCoherentClamps());
+
+            // Replacing the tree.
+            unsigned generation = mGroundClamper->GetTerrainBVHGeneration();
+            mGroundClamper->SetTerrainBVH(CreateFlatBVH(7.0f).get());
+            CPPUNIT_ASSERT(mGroundClamper->GetTerrainBVHGeneration() != generation);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(7.0f, ClampOnePoint(position, data, runtimeData, 3.0), 0.0001f);
+            CPPUNIT_ASSERT_EQUAL(2U, mGroundClamper->GetNumClampQueries());
+
+            // Changing the triangles of a tree and setting it again.
+            bvh->Clear();
+            bvh->AddTriangle(osg::Vec3(-10.0f, -10.0f, -2.0f), osg::Vec3(10.0f, -10.0f, -2.0f), osg::Vec3(0.0f, 10.0f, -2.0f));
+            mGroundClamper->SetTerrainBVH(bvh.get());
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.0f, ClampOnePoint(position, data, runtimeData, 4.0), 0.0001f);
+            CPPUNIT_ASSERT_EQUAL(3U, mGroundClamper->GetNumClampQueries());
+
+            // Rebuilding the tree from the terrain.
+            dtCore::RefPtr<dtActors::InfiniteTerrainActorProxy> terrainActor;
+            dtCore::InfiniteTerrain* terrain = NULL;
+            CreateTestTerrain(terrainActor, terrain);
+            mGroundClamper->SetTerrainActor(terrain);
+            mGroundClamper->RebuildTerrainBVH();
+            mGroundClamper->SetUseTerrainBVH(true);
+            const float groundZ = terrain->GetHeight(position.x(), position.y(), true);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(groundZ, ClampOnePoint(position, data, runtimeData, 5.0), 0.1f);
+            CPPUNIT_ASSERT_EQUAL(4U, mGroundClamper->GetNumClampQueries());
+
+            mGroundClamper->RebuildTerrainBVH();
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(groundZ, ClampOnePoint(position, data, runtimeData, 6.0), 0.1f);
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("A hit from before a rebuild shouldn't be reused.", 5U, mGroundClamper->GetNumClampQueries());
+            CPPUNIT_ASSERT_EQUAL(1U, mGroundClamper->GetNumCoherentClamps());
+         }
+
+         ///////////////////////////////////////////////////////////////////////
+         void TestClampPerformance()
+         {
+            dtCore::RefPtr<dtActors::InfiniteTerrainActorProxy> terrainActor;
+            dtCore::InfiniteTerrain* terrain = NULL;
+            CreateTestTerrain(terrainActor, terrain);
+            mGroundClamper->SetTerrainActor(terrain);
+            mGroundClamper->SetIntermittentGroundClampingTimeDelta(0.0f);
+
+            // Many clamps of the one actor stand in for many actors.
+            const unsigned numClamps = 4096;
+            std::vector<GroundClampingData> data(numClamps);
+            std::vector<osg::Vec3> positions(numClamps);
+            std::srand(11);
+            for (unsigned i = 0; i < numClamps; ++i)
+            {
+               data[i].SetGroundClampType(dtGame::GroundClampTypeEnum::FULL);
+               positions[i].set(float(std::rand() % 1000) - 500.0f, float(std::rand() % 1000) - 500.0f, 0.0f);
+            }
+
+            const char* names[3] = { "Scene graph isector", "Terrain triangle tree", "Terrain triangle tree, unmoved" };
+            for (unsigned pass = 0; pass < 3; ++pass)
+            {
+               mGroundClamper->SetUseTerrainBVH(pass > 0);
+               // Build the tree outside of the timing, since it's done once per terrain.
+               mGroundClamper->GetOrBuildTerrainBVH();
+               mGroundClamper->ResetClampCounts();
+
+               osg::Timer* timer = osg::Timer::instance();
+               osg::Timer_t start = timer->tick();
+               for (unsigned i = 0; i < numClamps; ++i)
+               {
+                  dtCore::Transform xform;
+                  xform.SetTranslation(positions[i]);
+                  DefaultGroundClamper::RuntimeData& runtimeData = mGroundClamper->GetOrCreateRuntimeData(data[i]);
+                  mGroundClamper->ClampToGroundIntermittent(double(pass + 1), xform, *mTestGameActor, data[i], runtimeData);
+               }
+               mGroundClamper->FinishUp();
+               double millis = timer->delta_m(start, timer->tick());
+
+               std::cout << std::endl << names[pass] << ": " << double(numClamps) / millis << " clamps per ms, "
+                        << mGroundClamper->GetNumClampQueries() << " queries" << std::endl;
+            }
+         }
+
       private:
 
          dtCore::RefPtr<TestClamper> mGroundClamper;
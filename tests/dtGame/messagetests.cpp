@@ -50,6 +50,7 @@
 
 #include <dtUtil/fileutils.h>
 #include <dtUtil/datastream.h>
+#include <dtUtil/threadpool.h>
 
 #include <dtGame/messageparameter.h>
 #include <dtGame/machineinfo.h>
@@ -59,9 +60,12 @@
 #include <dtGame/messagefactory.h>
 #include <dtGame/gamemanager.h>
 #include <dtGame/actorupdatemessage.h>
+#include <dtGame/messageschematable.h>
 #include <dtGame/exceptionenum.h>
 #include <dtGame/defaultnetworkpublishingcomponent.h>
 #include <dtGame/defaultmessageprocessor.h>
+#include <dtGame/gmsettings.h>
+#include <dtGame/mapchangestatedata.h>
 
 #include <testGameActorLibrary/testgameactorlibrary.h>
 #include <testGameActorLibrary/testgameactor.h>
@@ -90,6 +94,8 @@ class MessageTests : public CPPUNIT_NS::TestFixture
       CPPUNIT_TEST(TestChangeMap);
       CPPUNIT_TEST(TestChangeMapGameEvents);
       CPPUNIT_TEST(TestChangeMapErrorConditions);
+      CPPUNIT_TEST(TestChangeMapIncremental);
+      CPPUNIT_TEST(TestShutdownDuringBackgroundMapOpen);
       CPPUNIT_TEST(TestDefaultMessageProcessorWithPauseResumeRequests);
       CPPUNIT_TEST(TestDefaultMessageProcessorWithMapRequests);
       CPPUNIT_TEST(TestDefaultMessageProcessorWithPauseResumeCommands);
@@ -105,6 +111,9 @@ class MessageTests : public CPPUNIT_NS::TestFixture
       CPPUNIT_TEST(TestActorEnteredWorldMessage);
       CPPUNIT_TEST(TestPartialUpdateDoesNotCreateActor);
       CPPUNIT_TEST(TestNonPartialUpdateDoesCreateActor);
+      CPPUNIT_TEST(TestCompactActorUpdateEncoding);
+      CPPUNIT_TEST(TestCompactActorUpdateSchemaReset);
+      //CPPUNIT_TEST(TestCompactActorUpdatePerformance); //disabled - just used for benchmarking
 
    CPPUNIT_TEST_SUITE_END();
 
@@ -125,6 +134,8 @@ public:
    void TestChangeMapGameEvents();
    void TestChangeMap();
    void TestChangeMapErrorConditions();
+   void TestChangeMapIncremental();
+   void TestShutdownDuringBackgroundMapOpen();
    void TestDefaultMessageProcessorWithPauseResumeRequests();
    void TestDefaultMessageProcessorWithMapRequests();
    void TestDefaultMessageProcessorWithPauseResumeCommands();
@@ -140,6 +151,9 @@ public:
    void TestActorEnteredWorldMessage();
    void TestPartialUpdateDoesNotCreateActor();
    void TestNonPartialUpdateDoesCreateActor();
+   void TestCompactActorUpdateEncoding();
+   void TestCompactActorUpdateSchemaReset();
+   void TestCompactActorUpdatePerformance();
 
 private:
    static const char* mTestGameActorLibrary;
@@ -155,6 +169,7 @@ private:
    void CheckMapNames(const dtGame::MapMessage& mapLoadedMsg,
       const dtGame::GameManager::NameVector& mapNames);
    void DoTestOfPartialUpdateDoesNotCreateActor(bool testWithPartial);
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> CreateCompactTestUpdate(unsigned numParams);
 
    dtUtil::Log* mLogger;
 
@@ -1395,6 +1410,119 @@ void MessageTests::TestChangeMap()
 //   }
 }
 
+void MessageTests::TestChangeMapIncremental()
+{
+   try
+   {
+      dtCore::Project& project = dtCore::Project::GetInstance();
+      dtGame::GameManager::NameVector mapNamesExpected;
+      mapNamesExpected.push_back("Many Game Actors Incremental");
+
+      dtCore::RefPtr<dtCore::Map> map = &project.CreateMap(mapNamesExpected[0], "mgi");
+      createActors(*map);
+      map->AddLibrary(mTestGameActorLibrary, "1.0");
+      map->AddLibrary(mTestActorLibrary, "1.0");
+      const size_t numProxies = map->GetAllProxies().size();
+      project.SaveMap(*map);
+      project.CloseMap(*map);
+      map = NULL;
+
+      dtGame::TestComponent& tc = *new dtGame::TestComponent("name");
+      mGameManager->AddComponent(tc, dtGame::GameManager::ComponentPriority::NORMAL);
+
+      // The tiniest budget possible, so only one actor is added each frame.
+      mGameManager->GetGMSettings().SetLoadMapsInBackground(true);
+      mGameManager->GetGMSettings().SetMapLoadFrameBudgetMs(1e-6f);
+
+      mGameManager->ChangeMapSet(mapNamesExpected, false);
+
+      unsigned numFrames = 0;
+      float lastPercent = 0.0f;
+      unsigned numProgressMessages = 0;
+      while (!tc.FindProcessMessageOfType(dtGame::MessageType::INFO_MAP_CHANGE_END).valid())
+      {
+         CPPUNIT_ASSERT_MESSAGE("The map change should finish.", numFrames < 5000);
+
+         tc.reset();
+         dtCore::System::GetInstance().Step();
+         ++numFrames;
+
+         std::vector<dtCore::RefPtr<const dtGame::Message> >& msgs = tc.GetReceivedProcessMessages();
+         for (unsigned i = 0; i < msgs.size(); ++i)
+         {
+            if (msgs[i]->GetMessageType() == dtGame::MessageType::INFO_MAP_CHANGE_PROGRESS)
+            {
+               const dtGame::MapChangeProgressMessage& progress = static_cast<const dtGame::MapChangeProgressMessage&>(*msgs[i]);
+               CPPUNIT_ASSERT_MESSAGE("The progress should never go backwards.", progress.GetPercentComplete() >= lastPercent);
+               CPPUNIT_ASSERT(progress.GetNumActorsAdded() <= progress.GetNumActorsToAdd());
+               CheckMapNames(progress, mapNamesExpected);
+               lastPercent = progress.GetPercentComplete();
+               ++numProgressMessages;
+            }
+         }
+      }
+
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(100.0f, lastPercent, 0.001f);
+      CPPUNIT_ASSERT_MESSAGE("Adding the actors should have been spread over many frames.",
+            numProgressMessages > numProxies / 2);
+      CPPUNIT_ASSERT(numFrames > numProxies / 2);
+      CPPUNIT_ASSERT(mGameManager->GetCurrentMapSet() == mapNamesExpected);
+      CPPUNIT_ASSERT_MESSAGE("The game manager should be unpaused after the map change.", !mGameManager->IsPaused());
+
+      // The crash actor throws when it's added, so it's not in the GM.
+      CPPUNIT_ASSERT_EQUAL(numProxies - 1, mGameManager->GetNumAllActors());
+   }
+   catch(const dtUtil::Exception& e)
+   {
+      CPPUNIT_FAIL(e.ToString());
+   }
+}
+
+void MessageTests::TestShutdownDuringBackgroundMapOpen()
+{
+   try
+   {
+      dtCore::Project& project = dtCore::Project::GetInstance();
+      dtGame::GameManager::NameVector mapNames;
+      mapNames.push_back("Many Game Actors Shutdown");
+
+      dtCore::RefPtr<dtCore::Map> map = &project.CreateMap(mapNames[0], "mgs");
+      createActors(*map);
+      map->AddLibrary(mTestGameActorLibrary, "1.0");
+      map->AddLibrary(mTestActorLibrary, "1.0");
+      project.SaveMap(*map);
+      project.CloseMap(*map);
+      map = NULL;
+
+      dtGame::TestComponent& tc = *new dtGame::TestComponent("name");
+      mGameManager->AddComponent(tc, dtGame::GameManager::ComponentPriority::NORMAL);
+
+      mGameManager->GetGMSettings().SetLoadMapsInBackground(true);
+      mGameManager->ChangeMapSet(mapNames, false);
+
+      // Unloads the old maps and starts opening the new one on the IO thread.
+      dtCore::System::GetInstance().Step();
+
+      // Shutting down must wait for the map to open rather than closing it out from under the IO thread.
+      mGameManager->Shutdown();
+
+      CPPUNIT_ASSERT_MESSAGE("Shutdown should close the map that was being opened.", !project.IsMapOpen(mapNames[0]));
+      CPPUNIT_ASSERT_EQUAL(size_t(0), mGameManager->GetNumAllActors());
+      CPPUNIT_ASSERT_MESSAGE("The game manager should be unpaused after the map change is cancelled.", !mGameManager->IsPaused());
+
+      // The cancelled map change must not carry on.
+      dtCore::System::GetInstance().Step();
+      CPPUNIT_ASSERT(!project.IsMapOpen(mapNames[0]));
+      CPPUNIT_ASSERT(mGameManager->GetCurrentMapSet().empty());
+
+      project.DeleteMap(mapNames[0]);
+   }
+   catch(const dtUtil::Exception& e)
+   {
+      CPPUNIT_FAIL(e.ToString());
+   }
+}
+
 void MessageTests::TestGameEventMessage()
 {
    try
@@ -2125,3 +2253,181 @@ void MessageTests::DoTestOfPartialUpdateDoesNotCreateActor(bool testWithPartial)
       CPPUNIT_ASSERT_MESSAGE("Not partial - actor should exist.", gapRemote != NULL);
    }
 }
+
+//////////////////////////////////////////////////////////////////////////
+dtCore::RefPtr<dtGame::ActorUpdateMessage> MessageTests::CreateCompactTestUpdate(unsigned numParams)
+{
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum = new dtGame::ActorUpdateMessage;
+   aum->SetActorTypeCategory("ExampleActors");
+   aum->SetActorTypeName("Test1Actor");
+   aum->SetName("Bob");
+   aum->SetPrototypeID(dtCore::UniqueId());
+   aum->SetAboutActorId(dtCore::UniqueId());
+
+   for (unsigned i = 0; i < numParams; ++i)
+   {
+      dtGame::MessageParameter* param = aum->AddUpdateParameter("Some Long Property Name " + dtUtil::ToString(i), dtCore::DataType::VEC3);
+      static_cast<dtGame::Vec3MessageParameter*>(param)->SetValue(osg::Vec3(float(i), 2.0f, 3.0f));
+   }
+
+   return aum;
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MessageTests::TestCompactActorUpdateEncoding()
+{
+   dtCore::RefPtr<dtGame::MessageSchemaTable> sendSchemas = new dtGame::MessageSchemaTable;
+   dtCore::RefPtr<dtGame::MessageSchemaTable> receiveSchemas = new dtGame::MessageSchemaTable;
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum1 = CreateCompactTestUpdate(5);
+   aum1->SetPartialUpdate(true);
+   aum1->SetPrototypeName("Proto");
+
+   dtUtil::DataStream firstStream;
+   aum1->ToCompactDataStream(firstStream, *sendSchemas);
+   CPPUNIT_ASSERT_EQUAL(1U, sendSchemas->GetSchemaCount());
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum2 = new dtGame::ActorUpdateMessage;
+   CPPUNIT_ASSERT(aum2->FromCompactDataStream(firstStream, *receiveSchemas));
+   CPPUNIT_ASSERT_EQUAL(1U, receiveSchemas->GetSchemaCount());
+
+   CPPUNIT_ASSERT_EQUAL(aum1->GetActorTypeCategory(), aum2->GetActorTypeCategory());
+   CPPUNIT_ASSERT_EQUAL(aum1->GetActorTypeName(), aum2->GetActorTypeName());
+   CPPUNIT_ASSERT_EQUAL(aum1->GetName(), aum2->GetName());
+   CPPUNIT_ASSERT_EQUAL(aum1->GetPrototypeName(), aum2->GetPrototypeName());
+   CPPUNIT_ASSERT_EQUAL(aum1->GetPrototypeID(), aum2->GetPrototypeID());
+   CPPUNIT_ASSERT_EQUAL(aum1->GetParentID(), aum2->GetParentID());
+   CPPUNIT_ASSERT_EQUAL(aum1->IsPartialUpdate(), aum2->IsPartialUpdate());
+
+   std::vector<const dtGame::MessageParameter*> params;
+   aum1->GetUpdateParameters(params);
+   CPPUNIT_ASSERT_EQUAL(size_t(5), params.size());
+   for (unsigned i = 0; i < params.size(); ++i)
+   {
+      const dtGame::MessageParameter* received = aum2->GetUpdateParameter(params[i]->GetName());
+      CPPUNIT_ASSERT_MESSAGE(std::string("The parameter ") + params[i]->GetName() + " should have been received.", received != NULL);
+      CPPUNIT_ASSERT(*params[i] == *received);
+   }
+
+   // The second update of the same type should not carry the names, and a new parameter should be appended to the schema.
+   dtGame::MessageParameter* extra = aum1->AddUpdateParameter("Extra", dtCore::DataType::INT);
+   static_cast<dtGame::IntMessageParameter*>(extra)->SetValue(42);
+
+   dtUtil::DataStream secondStream;
+   aum1->ToCompactDataStream(secondStream, *sendSchemas);
+   dtUtil::DataStream fullStream;
+   aum1->ToDataStream(fullStream);
+   CPPUNIT_ASSERT_MESSAGE("The compact encoding should be smaller than the full encoding once the schema is known.",
+            secondStream.GetBufferSize() < fullStream.GetBufferSize());
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum3 = new dtGame::ActorUpdateMessage;
+   CPPUNIT_ASSERT(aum3->FromCompactDataStream(secondStream, *receiveSchemas));
+   CPPUNIT_ASSERT_EQUAL(aum1->GetActorTypeName(), aum3->GetActorTypeName());
+   const dtGame::IntMessageParameter* extraReceived =
+            dynamic_cast<const dtGame::IntMessageParameter*>(aum3->GetUpdateParameter("Extra"));
+   CPPUNIT_ASSERT(extraReceived != NULL);
+   CPPUNIT_ASSERT_EQUAL(42, extraReceived->GetValue());
+
+   // A reader that never saw the schema definition can't decode the update.
+   dtCore::RefPtr<dtGame::MessageSchemaTable> freshSchemas = new dtGame::MessageSchemaTable;
+   dtUtil::DataStream thirdStream;
+   aum1->ToCompactDataStream(thirdStream, *sendSchemas);
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum4 = new dtGame::ActorUpdateMessage;
+   CPPUNIT_ASSERT_THROW(aum4->FromCompactDataStream(thirdStream, *freshSchemas), dtGame::InvalidParameterException);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MessageTests::TestCompactActorUpdateSchemaReset()
+{
+   dtCore::RefPtr<dtGame::MessageSchemaTable> sendSchemas = new dtGame::MessageSchemaTable;
+   dtCore::RefPtr<dtGame::MessageSchemaTable> receiveSchemas = new dtGame::MessageSchemaTable;
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum = CreateCompactTestUpdate(3);
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> received = new dtGame::ActorUpdateMessage;
+
+   // The actor type and its three parameters are each one definition.
+   dtUtil::DataStream definingStream;
+   aum->ToCompactDataStream(definingStream, *sendSchemas);
+   CPPUNIT_ASSERT_EQUAL(4U, sendSchemas->GetNumDefinitionsWritten());
+   CPPUNIT_ASSERT(received->FromCompactDataStream(definingStream, *receiveSchemas));
+
+   dtUtil::DataStream staleStream;
+   aum->ToCompactDataStream(staleStream, *sendSchemas);
+   CPPUNIT_ASSERT_EQUAL(4U, sendSchemas->GetNumDefinitionsWritten());
+
+   // After the writer is cleared, the next update defines everything again in a new epoch.
+   sendSchemas->Clear();
+   CPPUNIT_ASSERT_EQUAL(0U, sendSchemas->GetSchemaCount());
+   CPPUNIT_ASSERT_EQUAL(1, int(sendSchemas->GetEpoch()));
+
+   dtUtil::DataStream resetStream;
+   aum->ToCompactDataStream(resetStream, *sendSchemas);
+   CPPUNIT_ASSERT_EQUAL(8U, sendSchemas->GetNumDefinitionsWritten());
+
+   dtUtil::DataStream newStream;
+   aum->ToCompactDataStream(newStream, *sendSchemas);
+
+   // An update of the new epoch that overtakes the definitions can't be read.
+   CPPUNIT_ASSERT_THROW(received->FromCompactDataStream(newStream, *receiveSchemas), dtGame::InvalidParameterException);
+   CPPUNIT_ASSERT_EQUAL(0, int(receiveSchemas->GetEpoch()));
+
+   newStream.Rewind();
+   CPPUNIT_ASSERT(received->FromCompactDataStream(resetStream, *receiveSchemas));
+   CPPUNIT_ASSERT_EQUAL(1, int(receiveSchemas->GetEpoch()));
+   CPPUNIT_ASSERT_EQUAL(1U, receiveSchemas->GetSchemaCount());
+   CPPUNIT_ASSERT(received->FromCompactDataStream(newStream, *receiveSchemas));
+   CPPUNIT_ASSERT_EQUAL(aum->GetActorTypeName(), received->GetActorTypeName());
+
+   // An update from the old epoch that arrives late must not be read against the new schemas.
+   CPPUNIT_ASSERT_THROW(received->FromCompactDataStream(staleStream, *receiveSchemas), dtGame::InvalidParameterException);
+}
+
+//////////////////////////////////////////////////////////////////////////
+void MessageTests::TestCompactActorUpdatePerformance()
+{
+   const unsigned numParams = 20;
+   const unsigned iterations = 10000;
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> aum = CreateCompactTestUpdate(numParams);
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> received = new dtGame::ActorUpdateMessage;
+
+   dtCore::RefPtr<dtGame::MessageSchemaTable> sendSchemas = new dtGame::MessageSchemaTable;
+   dtCore::RefPtr<dtGame::MessageSchemaTable> receiveSchemas = new dtGame::MessageSchemaTable;
+
+   // Prime the schema tables so the benchmark measures the steady state.
+   {
+      dtUtil::DataStream stream;
+      aum->ToCompactDataStream(stream, *sendSchemas);
+      received->FromCompactDataStream(stream, *receiveSchemas);
+   }
+
+   dtCore::Timer timer;
+   double fullEncode = 0.0, fullDecode = 0.0, compactEncode = 0.0, compactDecode = 0.0;
+   unsigned fullBytes = 0, compactBytes = 0;
+
+   for (unsigned i = 0; i < iterations; ++i)
+   {
+      dtUtil::DataStream fullStream;
+      dtCore::Timer_t start = timer.Tick();
+      aum->ToDataStream(fullStream);
+      dtCore::Timer_t encoded = timer.Tick();
+      received->FromDataStream(fullStream);
+      dtCore::Timer_t decoded = timer.Tick();
+      fullEncode += timer.DeltaSec(start, encoded);
+      fullDecode += timer.DeltaSec(encoded, decoded);
+      fullBytes = fullStream.GetBufferSize();
+
+      dtUtil::DataStream compactStream;
+      start = timer.Tick();
+      aum->ToCompactDataStream(compactStream, *sendSchemas);
+      encoded = timer.Tick();
+      received->FromCompactDataStream(compactStream, *receiveSchemas);
+      decoded = timer.Tick();
+      compactEncode += timer.DeltaSec(start, encoded);
+      compactDecode += timer.DeltaSec(encoded, decoded);
+      compactBytes = compactStream.GetBufferSize();
+   }
+
+   std::cout << std::endl << "Actor update with " << numParams << " parameters, " << iterations << " iterations." << std::endl
+            << "Full:    " << fullBytes << " bytes, encode " << fullEncode << "s, decode " << fullDecode << "s" << std::endl
+            << "Compact: " << compactBytes << " bytes, encode " << compactEncode << "s, decode " << compactDecode << "s" << std::endl;
+}
@@ -0,0 +1,388 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "../dtGame/basegmtests.h"
+
+#include <dtNetGM/interestmanager.h>
+#include <dtGame/actorupdatemessage.h>
+#include <dtGame/deadreckoninghelper.h>
+#include <dtGame/messagefactory.h>
+#include <dtGame/messageparameter.h>
+#include <dtGame/messagetype.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+class InterestManagerTests : public dtGame::BaseGMTestFixture
+{
+   CPPUNIT_TEST_SUITE(InterestManagerTests);
+      CPPUNIT_TEST(TestSphereRegion);
+      CPPUNIT_TEST(TestBoxRegion);
+      CPPUNIT_TEST(TestActorTypeFilter);
+      CPPUNIT_TEST(TestAnchorActor);
+      CPPUNIT_TEST(TestDistantUpdatesThrottled);
+      CPPUNIT_TEST(TestObserveMessages);
+      CPPUNIT_TEST(TestMissedUpdatesCaughtUp);
+      CPPUNIT_TEST(TestActorsInRegion);
+      CPPUNIT_TEST(TestSimulatedClients);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   void setUp()
+   {
+      dtGame::BaseGMTestFixture::setUp();
+      mInterestManager = new dtNetGM::InterestManager(50.0f);
+   }
+
+   void tearDown()
+   {
+      mInterestManager = NULL;
+      dtGame::BaseGMTestFixture::tearDown();
+   }
+
+   void TestSphereRegion()
+   {
+      dtCore::UniqueId client, nearActor, farActor, unknown;
+      mInterestManager->SetClientInterest(client, dtNetGM::InterestRegion::Sphere(osg::Vec3(100.0f, 0.0f, 0.0f), 30.0f));
+      mInterestManager->UpdateActor(nearActor, osg::Vec3(120.0f, 10.0f, 0.0f));
+      mInterestManager->UpdateActor(farActor, osg::Vec3(140.0f, 0.0f, 0.0f));
+
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(nearActor, client));
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSendActorUpdate(farActor, client));
+      CPPUNIT_ASSERT_MESSAGE("An actor with no known position should be sent.",
+            mInterestManager->ShouldSendActorUpdate(unknown, client));
+      CPPUNIT_ASSERT_MESSAGE("A client without a region should get everything.",
+            mInterestManager->ShouldSendActorUpdate(farActor, dtCore::UniqueId()));
+
+      // Moving the actor into the region.
+      mInterestManager->UpdateActor(farActor, osg::Vec3(110.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(farActor, client));
+
+      mInterestManager->RemoveActor(farActor);
+      CPPUNIT_ASSERT_EQUAL(1U, mInterestManager->GetNumActors());
+
+      dtNetGM::InterestManager::ClientStatistics stats = mInterestManager->GetClientStatistics(client);
+      CPPUNIT_ASSERT_EQUAL(3U, stats.mNumUpdatesSent);
+      CPPUNIT_ASSERT_EQUAL(1U, stats.mNumOutsideRegion);
+
+      mInterestManager->RemoveClient(client);
+      CPPUNIT_ASSERT(!mInterestManager->HasClientInterest(client));
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(nearActor, client));
+   }
+
+   void TestBoxRegion()
+   {
+      dtCore::UniqueId client, inside, outside;
+      mInterestManager->SetClientInterest(client, dtNetGM::InterestRegion::Box(osg::Vec3(), osg::Vec3(100.0f, 10.0f, 5.0f)));
+      mInterestManager->UpdateActor(inside, osg::Vec3(-95.0f, 9.0f, 4.0f));
+      mInterestManager->UpdateActor(outside, osg::Vec3(0.0f, 11.0f, 0.0f));
+
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(inside, client));
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSendActorUpdate(outside, client));
+   }
+
+   void TestActorTypeFilter()
+   {
+      dtCore::UniqueId client, vehicle, person;
+      dtNetGM::InterestRegion region = dtNetGM::InterestRegion::Sphere(osg::Vec3(), 100.0f);
+      region.mActorTypes.insert("Entities.Vehicle");
+      mInterestManager->SetClientInterest(client, region);
+
+      mInterestManager->UpdateActor(vehicle, osg::Vec3(), "Entities.Vehicle");
+      mInterestManager->UpdateActor(person, osg::Vec3(), "Entities.Person");
+
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(vehicle, client));
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSendActorUpdate(person, client));
+
+      // An update without a type keeps the one already known.
+      mInterestManager->UpdateActor(person, osg::Vec3(1.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSendActorUpdate(person, client));
+
+      CPPUNIT_ASSERT_EQUAL(2U, mInterestManager->GetClientStatistics(client).mNumFilteredByType);
+   }
+
+   void TestAnchorActor()
+   {
+      dtCore::UniqueId client, player, other;
+      dtNetGM::InterestRegion region = dtNetGM::InterestRegion::Sphere(osg::Vec3(), 20.0f);
+      region.mAnchorActorId = player;
+      mInterestManager->SetClientInterest(client, region);
+
+      mInterestManager->UpdateActor(other, osg::Vec3(500.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSendActorUpdate(other, client));
+
+      mInterestManager->UpdateActor(player, osg::Vec3(490.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT_MESSAGE("The region should follow the anchor actor.",
+            mInterestManager->ShouldSendActorUpdate(other, client));
+
+      std::vector<dtCore::UniqueId> actors;
+      mInterestManager->GetActorsInRegion(client, actors);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), actors.size());
+   }
+
+   void TestDistantUpdatesThrottled()
+   {
+      dtCore::UniqueId client, nearActor, distant;
+      dtNetGM::InterestRegion region = dtNetGM::InterestRegion::Sphere(osg::Vec3(), 100.0f);
+      region.mFullRateRadius = 20.0f;
+      region.mDistantUpdateInterval = 1.0;
+      mInterestManager->SetClientInterest(client, region);
+
+      mInterestManager->UpdateActor(nearActor, osg::Vec3(10.0f, 0.0f, 0.0f));
+      mInterestManager->UpdateActor(distant, osg::Vec3(80.0f, 0.0f, 0.0f));
+
+      mInterestManager->SetCurrentTime(10.0);
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(nearActor, client));
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(distant, client));
+
+      mInterestManager->SetCurrentTime(10.5);
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(nearActor, client));
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSendActorUpdate(distant, client));
+
+      mInterestManager->SetCurrentTime(11.0);
+      CPPUNIT_ASSERT(mInterestManager->ShouldSendActorUpdate(distant, client));
+
+      CPPUNIT_ASSERT_EQUAL(1U, mInterestManager->GetClientStatistics(client).mNumThrottled);
+
+      mInterestManager->ResetStatistics();
+      CPPUNIT_ASSERT_EQUAL(0U, mInterestManager->GetClientStatistics(client).mNumUpdatesSent);
+   }
+
+   void TestObserveMessages()
+   {
+      dtCore::RefPtr<dtGame::MachineInfo> clientMachine = new dtGame::MachineInfo("client");
+      mInterestManager->SetClientInterest(clientMachine->GetUniqueId(), dtNetGM::InterestRegion::Sphere(osg::Vec3(), 50.0f));
+
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> create;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_CREATED, create);
+      create->SetAboutActorId(dtCore::UniqueId());
+      create->SetActorTypeCategory("Entities");
+      create->SetActorTypeName("Vehicle");
+      SetTranslation(*create, osg::Vec3(200.0f, 0.0f, 0.0f));
+      mInterestManager->ObserveMessage(*create);
+      CPPUNIT_ASSERT_EQUAL(1U, mInterestManager->GetNumActors());
+
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> update;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_UPDATED, update);
+      update->SetAboutActorId(create->GetAboutActorId());
+      update->SetPartialUpdate(true);
+      SetTranslation(*update, osg::Vec3(200.0f, 0.0f, 0.0f));
+
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSend(*update, clientMachine->GetUniqueId()));
+      CPPUNIT_ASSERT_MESSAGE("Creates should always be sent.", mInterestManager->ShouldSend(*create, clientMachine->GetUniqueId()));
+
+      SetTranslation(*update, osg::Vec3(10.0f, 0.0f, 0.0f));
+      mInterestManager->ObserveMessage(*update);
+      CPPUNIT_ASSERT(mInterestManager->ShouldSend(*update, clientMachine->GetUniqueId()));
+
+      dtCore::RefPtr<dtGame::Message> deleted;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_DELETED, deleted);
+      deleted->SetAboutActorId(create->GetAboutActorId());
+      mInterestManager->ObserveMessage(*deleted);
+      CPPUNIT_ASSERT_EQUAL(0U, mInterestManager->GetNumActors());
+   }
+
+   void TestMissedUpdatesCaughtUp()
+   {
+      dtCore::UniqueId client, actor;
+      mInterestManager->SetClientInterest(client, dtNetGM::InterestRegion::Sphere(osg::Vec3(), 50.0f));
+
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> update = CreatePartialUpdate(actor);
+      SetTranslation(*update, osg::Vec3(10.0f, 0.0f, 0.0f));
+      mInterestManager->ObserveMessage(*update);
+      bool addState = true;
+      CPPUNIT_ASSERT(mInterestManager->ShouldSend(*update, client, &addState));
+      CPPUNIT_ASSERT(!addState);
+
+      // The actor leaves the region, and changes its velocity out there.
+      update = CreatePartialUpdate(actor);
+      SetTranslation(*update, osg::Vec3(200.0f, 0.0f, 0.0f));
+      static_cast<dtGame::Vec3MessageParameter*>(update->AddUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR,
+            dtCore::DataType::VEC3))->SetValue(osg::Vec3(-5.0f, 0.0f, 0.0f));
+      mInterestManager->ObserveMessage(*update);
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSend(*update, client, &addState));
+
+      // Changes to anything else still reach the client.
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> otherChange = CreatePartialUpdate(actor);
+      otherChange->AddUpdateParameter("Damage State", dtCore::DataType::STRING);
+      mInterestManager->ObserveMessage(*otherChange);
+      CPPUNIT_ASSERT_MESSAGE("A change that isn't about the position should be sent to a client out of range.",
+            mInterestManager->ShouldSend(*otherChange, client, &addState));
+      CPPUNIT_ASSERT_MESSAGE("The first update sent after missing some should catch the client up.", addState);
+
+      mInterestManager->AddDeadReckoningState(*otherChange);
+      const dtCore::NamedParameter* velocity = otherChange->GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR);
+      CPPUNIT_ASSERT(velocity != NULL);
+      CPPUNIT_ASSERT(static_cast<const dtGame::Vec3MessageParameter*>(velocity)->GetValue() == osg::Vec3(-5.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(otherChange->GetUpdateParameter("Damage State") != NULL);
+
+      update = CreatePartialUpdate(actor);
+      SetTranslation(*update, osg::Vec3(150.0f, 0.0f, 0.0f));
+      mInterestManager->ObserveMessage(*update);
+      CPPUNIT_ASSERT(!mInterestManager->ShouldSend(*update, client, &addState));
+
+      // Back in range, the next position update carries everything the client missed.
+      update = CreatePartialUpdate(actor);
+      SetTranslation(*update, osg::Vec3(20.0f, 0.0f, 0.0f));
+      mInterestManager->ObserveMessage(*update);
+      CPPUNIT_ASSERT(mInterestManager->ShouldSend(*update, client, &addState));
+      CPPUNIT_ASSERT(addState);
+
+      mInterestManager->AddDeadReckoningState(*update);
+      dtCore::NamedParameter* translation = update->GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_TRANSLATION);
+      CPPUNIT_ASSERT(static_cast<dtGame::Vec3MessageParameter*>(translation)->GetValue() == osg::Vec3(20.0f, 0.0f, 0.0f));
+      CPPUNIT_ASSERT(update->GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR) != NULL);
+      CPPUNIT_ASSERT(update->GetUpdateParameter("Damage State") == NULL);
+
+      // Caught up, so the update after that goes out as it is.
+      CPPUNIT_ASSERT(mInterestManager->ShouldSend(*update, client, &addState));
+      CPPUNIT_ASSERT(!addState);
+   }
+
+   void TestActorsInRegion()
+   {
+      dtCore::UniqueId client;
+      const osg::Vec3 center(37.0f, -12.0f, 5.0f);
+      const float radius = 120.0f;
+      mInterestManager->SetClientInterest(client, dtNetGM::InterestRegion::Sphere(center, radius));
+
+      std::vector<dtCore::UniqueId> expected;
+      srand(1234);
+      for (unsigned i = 0; i < 500; ++i)
+      {
+         dtCore::UniqueId actor;
+         osg::Vec3 position = RandomPosition(500.0f);
+         mInterestManager->UpdateActor(actor, position);
+         if ((position - center).length() <= radius)
+         {
+            expected.push_back(actor);
+         }
+      }
+
+      std::vector<dtCore::UniqueId> actors;
+      mInterestManager->GetActorsInRegion(client, actors);
+
+      std::sort(expected.begin(), expected.end());
+      std::sort(actors.begin(), actors.end());
+      CPPUNIT_ASSERT(!expected.empty());
+      CPPUNIT_ASSERT(expected == actors);
+   }
+
+   /// Moves many actors around and checks every client gets exactly the updates a brute force check says it should.
+   void TestSimulatedClients()
+   {
+      const unsigned numClients = 8;
+      const unsigned numActors = 400;
+      const unsigned numFrames = 20;
+      const float radius = 150.0f;
+
+      srand(4321);
+
+      std::vector<dtCore::UniqueId> clients(numClients);
+      std::vector<osg::Vec3> centers;
+      for (unsigned i = 0; i < numClients; ++i)
+      {
+         centers.push_back(RandomPosition(400.0f));
+         mInterestManager->SetClientInterest(clients[i], dtNetGM::InterestRegion::Sphere(centers[i], radius));
+      }
+
+      std::vector<dtCore::UniqueId> actors(numActors);
+      std::vector<osg::Vec3> positions;
+      for (unsigned i = 0; i < numActors; ++i)
+      {
+         positions.push_back(RandomPosition(500.0f));
+      }
+
+      std::vector<unsigned> expectedSent(numClients, 0);
+      unsigned numSentWithoutFiltering = 0;
+      for (unsigned frame = 0; frame < numFrames; ++frame)
+      {
+         for (unsigned i = 0; i < numActors; ++i)
+         {
+            positions[i] += RandomPosition(10.0f);
+            mInterestManager->UpdateActor(actors[i], positions[i]);
+
+            for (unsigned c = 0; c < numClients; ++c)
+            {
+               bool expected = (positions[i] - centers[c]).length() <= radius;
+               CPPUNIT_ASSERT_EQUAL(expected, mInterestManager->ShouldSendActorUpdate(actors[i], clients[c]));
+               if (expected)
+               {
+                  ++expectedSent[c];
+               }
+               ++numSentWithoutFiltering;
+            }
+         }
+      }
+
+      unsigned numSent = 0;
+      for (unsigned c = 0; c < numClients; ++c)
+      {
+         dtNetGM::InterestManager::ClientStatistics stats = mInterestManager->GetClientStatistics(clients[c]);
+         CPPUNIT_ASSERT_EQUAL(expectedSent[c], stats.mNumUpdatesSent);
+         CPPUNIT_ASSERT_EQUAL(numActors * numFrames, stats.mNumUpdatesSent + stats.mNumOutsideRegion);
+         numSent += stats.mNumUpdatesSent;
+      }
+
+      CPPUNIT_ASSERT_MESSAGE("Filtering should cut the number of updates sent.", numSent < numSentWithoutFiltering / 2);
+   }
+
+private:
+
+   static osg::Vec3 RandomPosition(float range)
+   {
+      return osg::Vec3(RandomFloat(range), RandomFloat(range), RandomFloat(range * 0.1f));
+   }
+
+   static float RandomFloat(float range)
+   {
+      return (float(rand()) / float(RAND_MAX) * 2.0f - 1.0f) * range;
+   }
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> CreatePartialUpdate(const dtCore::UniqueId& actorId)
+   {
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> update;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_UPDATED, update);
+      update->SetAboutActorId(actorId);
+      update->SetPartialUpdate(true);
+      return update;
+   }
+
+   static void SetTranslation(dtGame::ActorUpdateMessage& message, const osg::Vec3& translation)
+   {
+      dtGame::MessageParameter* param = message.GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_TRANSLATION);
+      if (param == NULL)
+      {
+         param = message.AddUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_TRANSLATION, dtCore::DataType::VEC3);
+      }
+      static_cast<dtGame::Vec3MessageParameter*>(param)->SetValue(translation);
+   }
+
+   dtCore::RefPtr<dtNetGM::InterestManager> mInterestManager;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InterestManagerTests);
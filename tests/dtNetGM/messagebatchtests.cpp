@@ -0,0 +1,390 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "../dtGame/basegmtests.h"
+
+#include <dtNetGM/messagebatch.h>
+#include <dtGame/actorupdatemessage.h>
+#include <dtGame/machineinfo.h>
+#include <dtGame/messagefactory.h>
+#include <dtGame/messageparameter.h>
+#include <dtGame/messageschematable.h>
+#include <dtGame/messagetype.h>
+#include <dtCore/timer.h>
+#include <dtUtil/datastream.h>
+#include <dtUtil/stringutils.h>
+
+#include <iostream>
+#include <vector>
+
+namespace
+{
+   /// Keeps a copy of every frame written.
+   class TestBatchWriter : public dtNetGM::MessageBatchWriter
+   {
+   public:
+      explicit TestBatchWriter(unsigned maxFrameSize = DEFAULT_MAX_FRAME_SIZE)
+      : dtNetGM::MessageBatchWriter(maxFrameSize)
+      {
+      }
+
+      std::vector<std::vector<char> > mFrames;
+      std::vector<bool> mFramesAddSchemaDefinitions;
+
+   protected:
+      virtual void OnFrameFinished(dtUtil::DataStream& frame)
+      {
+         mFrames.push_back(std::vector<char>(frame.GetBuffer(), frame.GetBuffer() + frame.GetBufferSize()));
+         mFramesAddSchemaDefinitions.push_back(GetFrameAddsSchemaDefinitions());
+      }
+   };
+}
+
+class MessageBatchTests : public dtGame::BaseGMTestFixture
+{
+   CPPUNIT_TEST_SUITE(MessageBatchTests);
+      CPPUNIT_TEST(TestRoundTrip);
+      CPPUNIT_TEST(TestCompactRoundTrip);
+      CPPUNIT_TEST(TestFrameSize);
+      CPPUNIT_TEST(TestRepeatedIds);
+      CPPUNIT_TEST(TestIsBatchFrame);
+      //CPPUNIT_TEST(TestBatchingPerformance); //disabled - just used for benchmarking
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   void setUp()
+   {
+      dtGame::BaseGMTestFixture::setUp();
+      mRemoteMachine = new dtGame::MachineInfo("remote");
+   }
+
+   void tearDown()
+   {
+      mRemoteMachine = NULL;
+      dtGame::BaseGMTestFixture::tearDown();
+   }
+
+   void TestRoundTrip()
+   {
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > messages;
+      CreateUpdates(messages, 20, 3);
+      messages[5]->SetDestination(mRemoteMachine.get());
+      messages[7]->SetSendingActorId(dtCore::UniqueId());
+
+      TestBatchWriter writer;
+      for (unsigned i = 0; i < messages.size(); ++i)
+      {
+         writer.AddMessage(*messages[i], NULL);
+      }
+      writer.Flush();
+
+      CPPUNIT_ASSERT_EQUAL(unsigned(messages.size()), writer.GetNumMessagesWritten());
+      CPPUNIT_ASSERT_EQUAL(unsigned(writer.mFrames.size()), writer.GetNumFramesWritten());
+
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > received;
+      ReadFrames(writer, NULL, received);
+      CheckReceived(messages, received);
+   }
+
+   void TestCompactRoundTrip()
+   {
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > messages;
+      CreateUpdates(messages, 20, 4);
+
+      dtCore::RefPtr<dtGame::MessageSchemaTable> sendSchemas = new dtGame::MessageSchemaTable;
+      dtCore::RefPtr<dtGame::MessageSchemaTable> receiveSchemas = new dtGame::MessageSchemaTable;
+
+      TestBatchWriter writer(200);
+      for (unsigned i = 0; i < messages.size(); ++i)
+      {
+         writer.AddMessage(*messages[i], sendSchemas.get());
+      }
+      writer.Flush();
+
+      // Only the first frame defines the schema, so only it has to be sent reliably.
+      CPPUNIT_ASSERT(writer.mFrames.size() > 1);
+      CPPUNIT_ASSERT(writer.mFramesAddSchemaDefinitions[0]);
+      for (unsigned i = 1; i < writer.mFramesAddSchemaDefinitions.size(); ++i)
+      {
+         CPPUNIT_ASSERT(!writer.mFramesAddSchemaDefinitions[i]);
+      }
+
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > received;
+      ReadFrames(writer, receiveSchemas.get(), received);
+      CheckReceived(messages, received);
+   }
+
+   void TestFrameSize()
+   {
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > messages;
+      CreateUpdates(messages, 50, 10);
+
+      const unsigned maxFrameSize = 300;
+      TestBatchWriter writer(maxFrameSize);
+      for (unsigned i = 0; i < messages.size(); ++i)
+      {
+         writer.AddMessage(*messages[i], NULL);
+      }
+      // Nothing is written until the frame is full.
+      CPPUNIT_ASSERT(writer.mFrames.size() < writer.GetNumMessagesWritten());
+      writer.Flush();
+      writer.Flush();
+
+      CPPUNIT_ASSERT(writer.mFrames.size() > 1);
+      CPPUNIT_ASSERT_EQUAL(unsigned(writer.mFrames.size()), writer.GetNumFramesWritten());
+
+      unsigned totalBytes = 0;
+      for (unsigned i = 0; i < writer.mFrames.size(); ++i)
+      {
+         CPPUNIT_ASSERT(writer.mFrames[i].size() <= maxFrameSize);
+         totalBytes += unsigned(writer.mFrames[i].size());
+      }
+      CPPUNIT_ASSERT_EQUAL(totalBytes, writer.GetNumBytesWritten());
+
+      // Each frame starts its own id table, so each must read on its own.
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > received;
+      ReadFrames(writer, NULL, received);
+      CheckReceived(messages, received);
+
+      // A message larger than a frame still gets one of its own.
+      TestBatchWriter tinyWriter(16);
+      tinyWriter.AddMessage(*messages[0], NULL);
+      tinyWriter.AddMessage(*messages[1], NULL);
+      tinyWriter.Flush();
+      CPPUNIT_ASSERT_EQUAL(2U, tinyWriter.GetNumFramesWritten());
+   }
+
+   void TestRepeatedIds()
+   {
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > messages;
+      CreateUpdates(messages, 1, 1);
+
+      TestBatchWriter oneWriter(10000);
+      oneWriter.AddMessage(*messages[0], NULL);
+      oneWriter.Flush();
+
+      TestBatchWriter twoWriter(10000);
+      twoWriter.AddMessage(*messages[0], NULL);
+      twoWriter.AddMessage(*messages[0], NULL);
+      twoWriter.Flush();
+
+      // The source and about actor are written in full only once, the second time they are one byte each.
+      const unsigned frameHeader = sizeof(unsigned short);
+      const unsigned first = oneWriter.GetNumBytesWritten() - frameHeader;
+      const unsigned second = twoWriter.GetNumBytesWritten() - oneWriter.GetNumBytesWritten();
+      CPPUNIT_ASSERT_EQUAL(first - 2 * dtCore::UniqueId::BINARY_SIZE - 2, second);
+   }
+
+   void TestIsBatchFrame()
+   {
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > messages;
+      CreateUpdates(messages, 1, 1);
+
+      TestBatchWriter writer;
+      writer.AddMessage(*messages[0], NULL);
+      writer.Flush();
+
+      dtUtil::DataStream frame(&writer.mFrames[0][0], unsigned(writer.mFrames[0].size()), false);
+      CPPUNIT_ASSERT(dtNetGM::MessageBatchReader::IsBatchFrame(frame));
+      CPPUNIT_ASSERT_EQUAL(0U, frame.GetReadPosition());
+
+      dtUtil::DataStream single;
+      single.Write(dtGame::MessageType::INFO_ACTOR_UPDATED.GetId());
+      CPPUNIT_ASSERT(!dtNetGM::MessageBatchReader::IsBatchFrame(single));
+      CPPUNIT_ASSERT_EQUAL(0U, single.GetReadPosition());
+
+      CPPUNIT_ASSERT_THROW(dtNetGM::MessageBatchReader reader(single), dtUtil::Exception);
+
+      dtUtil::DataStream empty;
+      CPPUNIT_ASSERT(!dtNetGM::MessageBatchReader::IsBatchFrame(empty));
+   }
+
+   void TestBatchingPerformance()
+   {
+      const unsigned numActors = 2000;
+      const unsigned numTicks = 20;
+
+      std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> > messages;
+      CreateUpdates(messages, numActors, numActors);
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> received = new dtGame::ActorUpdateMessage;
+
+      dtCore::Timer timer;
+
+      // One data stream per message with the ids as strings, the same as NetworkComponent::CreateDataStream.
+      unsigned unbatchedBytes = 0, unbatchedPackets = 0;
+      dtCore::Timer_t start = timer.Tick();
+      for (unsigned tick = 0; tick < numTicks; ++tick)
+      {
+         for (unsigned i = 0; i < messages.size(); ++i)
+         {
+            const dtGame::Message& message = *messages[i];
+            dtUtil::DataStream stream;
+            stream.Write(message.GetMessageType().GetId());
+            stream.Write(message.GetSource().GetUniqueId().ToString());
+            stream.Write(std::string(""));
+            stream.Write(message.GetSendingActorId().ToString());
+            stream.Write(message.GetAboutActorId().ToString());
+            message.ToDataStream(stream);
+
+            unbatchedBytes += stream.GetBufferSize();
+            unbatchedPackets += 1 + (stream.GetBufferSize() - 1) / dtNetGM::MessageBatchWriter::DEFAULT_MAX_FRAME_SIZE;
+
+            stream.Rewind();
+            unsigned short msgId = 0;
+            std::string id;
+            stream.Read(msgId);
+            stream.Read(id);
+            stream.Read(id);
+            stream.Read(id);
+            stream.Read(id);
+            received->FromDataStream(stream);
+         }
+      }
+      double unbatchedSeconds = timer.DeltaSec(start, timer.Tick());
+
+      unsigned batchedPackets = 0;
+      unsigned batchedBytes = 0;
+      start = timer.Tick();
+      for (unsigned tick = 0; tick < numTicks; ++tick)
+      {
+         TestBatchWriter writer;
+         for (unsigned i = 0; i < messages.size(); ++i)
+         {
+            writer.AddMessage(*messages[i], NULL);
+         }
+         writer.Flush();
+
+         for (unsigned f = 0; f < writer.mFrames.size(); ++f)
+         {
+            dtUtil::DataStream frame(&writer.mFrames[f][0], unsigned(writer.mFrames[f].size()), false);
+            dtNetGM::MessageBatchReader reader(frame);
+            dtNetGM::MessageBatchReader::Header header;
+            while (reader.ReadHeader(header))
+            {
+               received->FromDataStream(frame);
+            }
+            batchedPackets += 1 + (unsigned(writer.mFrames[f].size()) - 1) / dtNetGM::MessageBatchWriter::DEFAULT_MAX_FRAME_SIZE;
+         }
+         batchedBytes += writer.GetNumBytesWritten();
+      }
+      double batchedSeconds = timer.DeltaSec(start, timer.Tick());
+
+      const double numMessages = double(numActors) * double(numTicks);
+      std::cout << std::endl << numActors << " actor updates a tick for " << numTicks << " ticks, written and read back." << std::endl
+               << "Unbatched: " << numMessages / unbatchedSeconds << " messages/s, "
+               << unbatchedBytes / numTicks << " bytes in " << unbatchedPackets / numTicks << " packets a tick" << std::endl
+               << "Batched:   " << numMessages / batchedSeconds << " messages/s, "
+               << batchedBytes / numTicks << " bytes in " << batchedPackets / numTicks << " packets a tick" << std::endl;
+   }
+
+private:
+
+   /// Creates actor updates about numActors actors, so messages after the first numActors repeat actor ids.
+   void CreateUpdates(std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> >& messages, unsigned count, unsigned numActors)
+   {
+      std::vector<dtCore::UniqueId> actorIds(numActors);
+      for (unsigned i = 0; i < count; ++i)
+      {
+         dtCore::RefPtr<dtGame::ActorUpdateMessage> aum;
+         mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_UPDATED, aum);
+         aum->SetAboutActorId(actorIds[i % numActors]);
+         aum->SetSendingActorId(actorIds[i % numActors]);
+         aum->SetName("Actor " + dtUtil::ToString(i % numActors));
+         aum->SetActorTypeCategory("ExampleActors");
+         aum->SetActorTypeName("Test1Actor");
+
+         dtGame::MessageParameter* param = aum->AddUpdateParameter("Translation", dtCore::DataType::VEC3);
+         static_cast<dtGame::Vec3MessageParameter*>(param)->SetValue(osg::Vec3(float(i), 2.0f, 3.0f));
+         param = aum->AddUpdateParameter("Velocity", dtCore::DataType::VEC3);
+         static_cast<dtGame::Vec3MessageParameter*>(param)->SetValue(osg::Vec3(1.0f, float(i), 3.0f));
+
+         messages.push_back(aum);
+      }
+   }
+
+   /// Reads every message in the frames, checking the header of each.
+   void ReadFrames(TestBatchWriter& writer, dtGame::MessageSchemaTable* schemas,
+            std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> >& received)
+   {
+      for (unsigned f = 0; f < writer.mFrames.size(); ++f)
+      {
+         dtUtil::DataStream frame(&writer.mFrames[f][0], unsigned(writer.mFrames[f].size()), false);
+         CPPUNIT_ASSERT(dtNetGM::MessageBatchReader::IsBatchFrame(frame));
+
+         dtNetGM::MessageBatchReader reader(frame);
+         dtNetGM::MessageBatchReader::Header header;
+         while (reader.ReadHeader(header))
+         {
+            CPPUNIT_ASSERT_EQUAL(dtGame::MessageType::INFO_ACTOR_UPDATED.GetId(), header.mMessageTypeId);
+            CPPUNIT_ASSERT_EQUAL(schemas != NULL, header.mCompact);
+            CPPUNIT_ASSERT(header.mSource == mGM->GetMachineInfo().GetUniqueId());
+
+            dtCore::RefPtr<dtGame::ActorUpdateMessage> aum;
+            mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_UPDATED, aum);
+            if (!header.mDestination.IsNull())
+            {
+               CPPUNIT_ASSERT(header.mDestination == mRemoteMachine->GetUniqueId());
+               aum->SetDestination(mRemoteMachine.get());
+            }
+            aum->SetSendingActorId(header.mSendingActor);
+            aum->SetAboutActorId(header.mAboutActor);
+
+            if (schemas != NULL)
+            {
+               CPPUNIT_ASSERT(aum->FromCompactDataStream(frame, *schemas));
+            }
+            else
+            {
+               CPPUNIT_ASSERT(aum->FromDataStream(frame));
+            }
+            received.push_back(aum);
+         }
+      }
+   }
+
+   void CheckReceived(const std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> >& sent,
+            const std::vector<dtCore::RefPtr<dtGame::ActorUpdateMessage> >& received)
+   {
+      CPPUNIT_ASSERT_EQUAL(sent.size(), received.size());
+      for (unsigned i = 0; i < sent.size(); ++i)
+      {
+         CPPUNIT_ASSERT(sent[i]->GetAboutActorId() == received[i]->GetAboutActorId());
+         CPPUNIT_ASSERT(sent[i]->GetSendingActorId() == received[i]->GetSendingActorId());
+         CPPUNIT_ASSERT_EQUAL(sent[i]->GetDestination() != NULL, received[i]->GetDestination() != NULL);
+         CPPUNIT_ASSERT_EQUAL(sent[i]->GetName(), received[i]->GetName());
+         CPPUNIT_ASSERT_EQUAL(sent[i]->GetActorTypeName(), received[i]->GetActorTypeName());
+
+         const dtGame::MessageParameter* sentParam = sent[i]->GetUpdateParameter("Translation");
+         const dtGame::MessageParameter* receivedParam = received[i]->GetUpdateParameter("Translation");
+         CPPUNIT_ASSERT(receivedParam != NULL);
+         CPPUNIT_ASSERT(*sentParam == *receivedParam);
+      }
+   }
+
+   dtCore::RefPtr<dtGame::MachineInfo> mRemoteMachine;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MessageBatchTests);
@@ -0,0 +1,283 @@
+/* -*-c++-*-
+ * allTests - This source file (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "../dtGame/basegmtests.h"
+
+#include <dtNetGM/interestmanager.h>
+#include <dtNetGM/networkbridge.h>
+#include <dtNetGM/servernetworkcomponent.h>
+#include <dtGame/actorupdatemessage.h>
+#include <dtGame/deadreckoninghelper.h>
+#include <dtGame/machineinfo.h>
+#include <dtGame/messagefactory.h>
+#include <dtGame/messageparameter.h>
+#include <dtGame/messagetype.h>
+#include <dtUtil/datastream.h>
+
+#include <vector>
+
+namespace
+{
+   /// Stands in for a connected client, keeping the data streams sent to it rather than sending them.
+   class RecordingBridge : public dtNetGM::NetworkBridge
+   {
+   public:
+      RecordingBridge(dtNetGM::NetworkComponent* networkComp, const std::string& name)
+         : dtNetGM::NetworkBridge(networkComp)
+      {
+         dtCore::RefPtr<dtGame::MachineInfo> machineInfo = new dtGame::MachineInfo(name);
+         SetMachineInfo(*machineInfo);
+         SetClientConnected(true);
+      }
+
+      void SendDataStream(dtUtil::DataStream& dataStream, bool allowBestEffort) override
+      {
+         mSent.push_back(dataStream);
+      }
+
+      std::vector<dtUtil::DataStream> mSent;
+
+   protected:
+      virtual ~RecordingBridge() {}
+   };
+
+   /// Opens up what the tests need to connect the stand in clients and to send without the background task.
+   class TestServerComponent : public dtNetGM::ServerNetworkComponent
+   {
+   public:
+      void AddClient(dtNetGM::NetworkBridge& bridge)
+      {
+         AddConnection(&bridge);
+      }
+
+      int GetNumClients() const
+      {
+         return GetConnectionCount();
+      }
+
+      /// Sends a message right away, the same way the dispatch task sends the buffered ones.
+      void SendNow(const dtGame::Message& message)
+      {
+         MessageBufferType messages;
+         messages.push_back(&message);
+         SendNetworkMessages(messages);
+      }
+
+   protected:
+      virtual ~TestServerComponent() {}
+   };
+}
+
+class ServerNetworkComponentTests : public dtGame::BaseGMTestFixture
+{
+   CPPUNIT_TEST_SUITE(ServerNetworkComponentTests);
+      CPPUNIT_TEST(TestNoInterestSendsEverything);
+      CPPUNIT_TEST(TestServerUpdatesFiltered);
+      CPPUNIT_TEST(TestForwardedUpdatesFiltered);
+      CPPUNIT_TEST(TestDisconnectRemovesClient);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   void setUp()
+   {
+      dtGame::BaseGMTestFixture::setUp();
+      mServer = new TestServerComponent();
+      mGM->AddComponent(*mServer, dtGame::GameManager::ComponentPriority::NORMAL);
+      mServer->SetCompactActorUpdates(false);
+      mServer->SetBatchMessages(false);
+
+      mClientA = new RecordingBridge(mServer.get(), "Client A");
+      mClientB = new RecordingBridge(mServer.get(), "Client B");
+      mClientC = new RecordingBridge(mServer.get(), "Client C");
+      mServer->AddClient(*mClientA);
+      mServer->AddClient(*mClientB);
+      mServer->AddClient(*mClientC);
+   }
+
+   void tearDown()
+   {
+      // The component only holds raw pointers to the bridges, so it goes first.
+      if (mServer.valid())
+      {
+         mGM->RemoveComponent(*mServer);
+      }
+      mServer = NULL;
+      mClientA = NULL;
+      mClientB = NULL;
+      mClientC = NULL;
+      dtGame::BaseGMTestFixture::tearDown();
+   }
+
+   void TestNoInterestSendsEverything()
+   {
+      CPPUNIT_ASSERT(mServer->GetInterestManager() == NULL);
+
+      dtCore::UniqueId actor;
+      SendFromServer(*CreateUpdate(actor, osg::Vec3(5000.0f, 0.0f, 0.0f)));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientA->mSent.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientB->mSent.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientC->mSent.size());
+
+      mServer->SetClientInterest(mClientA->GetMachineInfo(), dtNetGM::InterestRegion::Sphere(osg::Vec3(), 50.0f));
+      CPPUNIT_ASSERT_MESSAGE("Setting a client's interest should create the interest manager.", mServer->GetInterestManager() != NULL);
+      CPPUNIT_ASSERT(mServer->GetInterestManager()->HasClientInterest(mClientA->GetMachineInfo().GetUniqueId()));
+   }
+
+   void TestServerUpdatesFiltered()
+   {
+      mServer->SetClientInterest(mClientA->GetMachineInfo(), dtNetGM::InterestRegion::Sphere(osg::Vec3(), 50.0f));
+
+      dtCore::UniqueId actor;
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> create;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_CREATED, create);
+      create->SetAboutActorId(actor);
+      SetTranslation(*create, osg::Vec3(200.0f, 0.0f, 0.0f));
+      SendFromServer(*create);
+      CPPUNIT_ASSERT_MESSAGE("Every client should hear about a new actor.", mClientA->mSent.size() == 1 && mClientB->mSent.size() == 1);
+
+      SendFromServer(*CreateUpdate(actor, osg::Vec3(210.0f, 0.0f, 0.0f)));
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("The client should not get the movement out of its region.", size_t(1), mClientA->mSent.size());
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("A client without a region should get everything.", size_t(2), mClientB->mSent.size());
+
+      SendFromServer(*CreateUpdate(actor, osg::Vec3(10.0f, 0.0f, 0.0f)));
+      CPPUNIT_ASSERT_EQUAL(size_t(2), mClientA->mSent.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(3), mClientB->mSent.size());
+
+      dtNetGM::InterestManager::ClientStatistics stats = mServer->GetInterestManager()->GetClientStatistics(mClientA->GetMachineInfo().GetUniqueId());
+      CPPUNIT_ASSERT_EQUAL(1U, stats.mNumOutsideRegion);
+   }
+
+   void TestForwardedUpdatesFiltered()
+   {
+      // Client B publishes the actor, A only cares about the area around the origin, and C wants everything.
+      mServer->SetClientInterest(mClientA->GetMachineInfo(), dtNetGM::InterestRegion::Sphere(osg::Vec3(), 50.0f));
+
+      dtCore::UniqueId actor;
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> update = CreateUpdate(actor, osg::Vec3(200.0f, 0.0f, 0.0f));
+      static_cast<dtGame::Vec3MessageParameter*>(update->AddUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR,
+            dtCore::DataType::VEC3))->SetValue(osg::Vec3(-5.0f, 0.0f, 0.0f));
+      ForwardFromB(*update);
+      CPPUNIT_ASSERT(mClientA->mSent.empty());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientC->mSent.size());
+      CPPUNIT_ASSERT_MESSAGE("The sender should not get its own message back.", mClientB->mSent.empty());
+
+      // Coming into the region, A gets a copy that catches it up on the velocity it missed.
+      ForwardFromB(*CreateUpdate(actor, osg::Vec3(20.0f, 0.0f, 0.0f)));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientA->mSent.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(2), mClientC->mSent.size());
+
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> received = ReadUpdate(*mClientA, 0);
+      CPPUNIT_ASSERT(received->GetAboutActorId() == actor);
+      const dtGame::MessageParameter* velocity = received->GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR);
+      CPPUNIT_ASSERT(velocity != NULL);
+      CPPUNIT_ASSERT(static_cast<const dtGame::Vec3MessageParameter*>(velocity)->GetValue() == osg::Vec3(-5.0f, 0.0f, 0.0f));
+
+      received = ReadUpdate(*mClientC, 1);
+      CPPUNIT_ASSERT_MESSAGE("A client that didn't miss anything should get the update as it was sent.",
+            received->GetUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_VELOCITY_VECTOR) == NULL);
+
+      // Out of the region again, only changes to something besides the position reach A.
+      ForwardFromB(*CreateUpdate(actor, osg::Vec3(300.0f, 0.0f, 0.0f)));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientA->mSent.size());
+
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> otherChange;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_UPDATED, otherChange);
+      otherChange->SetAboutActorId(actor);
+      otherChange->SetPartialUpdate(true);
+      otherChange->AddUpdateParameter("Damage State", dtCore::DataType::STRING);
+      ForwardFromB(*otherChange);
+      CPPUNIT_ASSERT_EQUAL(size_t(2), mClientA->mSent.size());
+      CPPUNIT_ASSERT_EQUAL(size_t(4), mClientC->mSent.size());
+      CPPUNIT_ASSERT(ReadUpdate(*mClientA, 1)->GetUpdateParameter("Damage State") != NULL);
+      CPPUNIT_ASSERT(mClientB->mSent.empty());
+   }
+
+   void TestDisconnectRemovesClient()
+   {
+      mServer->SetClientInterest(mClientA->GetMachineInfo(), dtNetGM::InterestRegion::Sphere(osg::Vec3(), 50.0f));
+      CPPUNIT_ASSERT_EQUAL(3, mServer->GetNumClients());
+
+      mServer->OnDisconnect(*mClientA);
+      CPPUNIT_ASSERT_EQUAL(2, mServer->GetNumClients());
+      CPPUNIT_ASSERT(!mServer->GetInterestManager()->HasClientInterest(mClientA->GetMachineInfo().GetUniqueId()));
+
+      // The other clients are told, but not the one that left.
+      CPPUNIT_ASSERT(mClientA->mSent.empty());
+      CPPUNIT_ASSERT_EQUAL(size_t(1), mClientB->mSent.size());
+      mClientB->mSent[0].Rewind();
+      dtCore::RefPtr<dtGame::Message> notify = mServer->CreateMessage(mClientB->mSent[0], *mClientB);
+      CPPUNIT_ASSERT(notify.valid());
+      CPPUNIT_ASSERT(notify->GetMessageType() == dtGame::MessageType::NETCLIENT_NOTIFY_DISCONNECT);
+   }
+
+private:
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> CreateUpdate(const dtCore::UniqueId& actorId, const osg::Vec3& translation)
+   {
+      dtCore::RefPtr<dtGame::ActorUpdateMessage> update;
+      mGM->GetMessageFactory().CreateMessage(dtGame::MessageType::INFO_ACTOR_UPDATED, update);
+      update->SetAboutActorId(actorId);
+      update->SetPartialUpdate(true);
+      SetTranslation(*update, translation);
+      return update;
+   }
+
+   static void SetTranslation(dtGame::ActorUpdateMessage& message, const osg::Vec3& translation)
+   {
+      static_cast<dtGame::Vec3MessageParameter*>(message.AddUpdateParameter(dtGame::DeadReckoningHelper::PROPERTY_LAST_KNOWN_TRANSLATION,
+            dtCore::DataType::VEC3))->SetValue(translation);
+   }
+
+   /// Dispatches a message of the server's own, and sends it without waiting for the end of the tick.
+   void SendFromServer(const dtGame::Message& message)
+   {
+      mServer->DispatchNetworkMessage(message);
+      mServer->SendNow(message);
+   }
+
+   void ForwardFromB(dtGame::Message& message)
+   {
+      message.SetSource(mClientB->GetMachineInfo());
+      mServer->ForwardMessage(message, *mClientB);
+   }
+
+   dtCore::RefPtr<dtGame::ActorUpdateMessage> ReadUpdate(RecordingBridge& client, unsigned index)
+   {
+      CPPUNIT_ASSERT(index < client.mSent.size());
+      client.mSent[index].Rewind();
+      dtCore::RefPtr<dtGame::Message> message = mServer->CreateMessage(client.mSent[index], client);
+      CPPUNIT_ASSERT(message.valid());
+      CPPUNIT_ASSERT(message->GetMessageType() == dtGame::MessageType::INFO_ACTOR_UPDATED);
+      return static_cast<dtGame::ActorUpdateMessage*>(message.get());
+   }
+
+   dtCore::RefPtr<TestServerComponent> mServer;
+   dtCore::RefPtr<RecordingBridge> mClientA;
+   dtCore::RefPtr<RecordingBridge> mClientB;
+   dtCore::RefPtr<RecordingBridge> mClientC;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ServerNetworkComponentTests);
@@ -37,6 +37,8 @@
 #include <iostream>
 #include <osg/io_utils>
 #include <osg/Math>
+#include <osg/Timer>
+#include <vector>
 
 /**
  * @class CoordinateTests
@@ -59,6 +61,8 @@ class CoordinateTests : public CPPUNIT_NS::TestFixture
       CPPUNIT_TEST(TestMGRSvsXYZ);
       CPPUNIT_TEST(TestConvertGeodeticToUTM );
       CPPUNIT_TEST(TestConvertUTMToGeodetic);
+      CPPUNIT_TEST(TestBatchConversions);
+      //CPPUNIT_TEST(TestBatchConversionPerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -80,10 +84,16 @@ class CoordinateTests : public CPPUNIT_NS::TestFixture
       void TestConvertGeodeticToUTM();
       void TestMGRSvsXYZ();
       void TestConvertUTMToGeodetic();
+      void TestBatchConversions();
+      void TestBatchConversionPerformance();
 
    private:
 
       void CheckMilsConversion(float degrees, unsigned expectedMils, float expectedReverseDegrees);
+      /// Fills remote locations in the configured incoming coordinate type spread around southern california.
+      void MakeRemoteLocations(std::vector<osg::Vec3d>& locs, unsigned count);
+      /// Checks the batch conversions against the single point ones with the current configuration.
+      void CheckBatchConversions(const std::vector<osg::Vec3d>& locs);
 
       dtUtil::Log* mLogger;
       dtUtil::Coordinates* converter;
@@ -812,3 +822,189 @@ void CoordinateTests::TestConvertUTMToGeodetic()
    CPPUNIT_ASSERT_DOUBLES_EQUAL( -45.1, osg::RadiansToDegrees(lat), epsilon );
    CPPUNIT_ASSERT_DOUBLES_EQUAL( -123.0, osg::RadiansToDegrees(lon), epsilon );
 }
+
+//////////////////////////////////////////////////////////////////////////////
+void CoordinateTests::MakeRemoteLocations(std::vector<osg::Vec3d>& locs, unsigned count)
+{
+   locs.resize(count);
+   for (unsigned i = 0; i < count; ++i)
+   {
+      double lat = 32.0 + 4.0 * double(i % 17) / 17.0;
+      double lon = -120.0 + 6.0 * double(i % 23) / 23.0;
+      double elevation = 2000.0 * double(i % 7) / 7.0;
+
+      if (converter->GetIncomingCoordinateType() == dtUtil::IncomingCoordinateType::GEOCENTRIC)
+      {
+         converter->GeodeticToGeocentric(osg::DegreesToRadians(lat), osg::DegreesToRadians(lon), elevation,
+                  locs[i].x(), locs[i].y(), locs[i].z());
+      }
+      else if (converter->GetIncomingCoordinateType() == dtUtil::IncomingCoordinateType::GEODETIC)
+      {
+         locs[i].set(lat, lon, elevation);
+      }
+      else
+      {
+         double easting, northing;
+         converter->ConvertGeodeticToUTM(osg::DegreesToRadians(lat), osg::DegreesToRadians(lon),
+                  converter->GetUTMZone(), converter->GetUTMHemisphere(), easting, northing);
+         locs[i].set(easting, northing, elevation);
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void CoordinateTests::CheckBatchConversions(const std::vector<osg::Vec3d>& locs)
+{
+   const unsigned count = unsigned(locs.size());
+
+   std::vector<osg::Vec3> translations(count);
+   converter->ConvertToLocalTranslations(&locs[0], &translations[0], count);
+   for (unsigned i = 0; i < count; ++i)
+   {
+      osg::Vec3 expected = converter->ConvertToLocalTranslation(locs[i]);
+      std::ostringstream ss;
+      ss << "Local translation " << i << " of " << locs[i] << " Expected: " << expected << ", Actual: " << translations[i];
+      // A float a few hundred kilometers out is only good to a few centimeters.
+      CPPUNIT_ASSERT_MESSAGE(ss.str(), dtUtil::Equivalent(expected, translations[i], 0.1f));
+   }
+
+   std::vector<osg::Vec3d> remoteLocs(count);
+   converter->ConvertToRemoteTranslations(&translations[0], &remoteLocs[0], count);
+   for (unsigned i = 0; i < count; ++i)
+   {
+      osg::Vec3d expected = converter->ConvertToRemoteTranslation(translations[i]);
+      std::ostringstream ss;
+      ss << "Remote translation " << i << " of " << translations[i] << " Expected: " << expected << ", Actual: " << remoteLocs[i];
+      CPPUNIT_ASSERT_MESSAGE(ss.str(), dtUtil::Equivalent(expected, remoteLocs[i], 1e-3));
+   }
+
+   std::vector<osg::Vec3> hprs(count);
+   for (unsigned i = 0; i < count; ++i)
+   {
+      hprs[i].set(float(i % 360) - 180.0f, float(i % 170) - 85.0f, float(i % 50) * 7.0f - 175.0f);
+   }
+
+   std::vector<osg::Vec3d> rotations(count);
+   converter->ConvertToRemoteRotations(&hprs[0], &rotations[0], count);
+   for (unsigned i = 0; i < count; ++i)
+   {
+      osg::Vec3d expected = converter->ConvertToRemoteRotation(hprs[i]);
+      // Compare the matrices, since an angle of pi could come back as -pi.
+      osg::Matrix expectedMatrix, actualMatrix;
+      dtUtil::Coordinates::EulersToMatrix(expectedMatrix, expected[0], expected[1], expected[2]);
+      dtUtil::Coordinates::EulersToMatrix(actualMatrix, rotations[i][0], rotations[i][1], rotations[i][2]);
+      std::ostringstream ss;
+      ss << "Remote rotation " << i << " of " << hprs[i] << " Expected: " << expected << ", Actual: " << rotations[i];
+      for (unsigned row = 0; row < 3; ++row)
+      {
+         for (unsigned col = 0; col < 3; ++col)
+         {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(ss.str(), expectedMatrix(row, col), actualMatrix(row, col), 1e-3);
+         }
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void CoordinateTests::TestBatchConversions()
+{
+   // More than one block, and not a multiple of the block size.
+   const unsigned count = 150;
+   std::vector<osg::Vec3d> locs;
+
+   converter->SetUTMZone(11);
+   converter->SetFlatEarthOrigin(osg::Vec2d(32.0, -120.0));
+
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::GEOCENTRIC);
+   converter->SetLocalCoordinateType(dtUtil::LocalCoordinateType::CARTESIAN_UTM);
+   converter->SetLocalOffset(osg::Vec3d(562078.225268, 3788040.632974, -32.0));
+   MakeRemoteLocations(locs, count);
+   // The poles don't go through the block kernel.
+   locs[3].set(0.0, 0.0, 6356752.3);
+   CheckBatchConversions(locs);
+
+   converter->SetRemoteReferenceForOriginRotationMatrix(locs[0]);
+   CheckBatchConversions(locs);
+
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::GEODETIC);
+   MakeRemoteLocations(locs, count);
+   CheckBatchConversions(locs);
+
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::UTM);
+   MakeRemoteLocations(locs, count);
+   CheckBatchConversions(locs);
+
+   converter->SetLocalCoordinateType(dtUtil::LocalCoordinateType::CARTESIAN_FLAT_EARTH);
+   converter->SetLocalOffset(osg::Vec3d(0.0, 0.0, 0.0));
+   CheckBatchConversions(locs);
+
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::GEOCENTRIC);
+   MakeRemoteLocations(locs, count);
+   CheckBatchConversions(locs);
+
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::GEODETIC);
+   MakeRemoteLocations(locs, count);
+   CheckBatchConversions(locs);
+
+   converter->SetUTMZone(56);
+   converter->SetUTMHemisphere('S');
+   converter->SetLocalCoordinateType(dtUtil::LocalCoordinateType::CARTESIAN_UTM);
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::GEOCENTRIC);
+   for (unsigned i = 0; i < count; ++i)
+   {
+      converter->GeodeticToGeocentric(osg::DegreesToRadians(-34.0 + double(i % 13) / 13.0),
+               osg::DegreesToRadians(151.0 + double(i % 11) / 11.0), 50.0, locs[i].x(), locs[i].y(), locs[i].z());
+   }
+   double easting, northing;
+   converter->ConvertGeodeticToUTM(osg::DegreesToRadians(-34.0), osg::DegreesToRadians(151.0), 56, 'S', easting, northing);
+   converter->SetLocalOffset(osg::Vec3d(easting, northing, 0.0));
+   CheckBatchConversions(locs);
+
+   converter->SetLocalCoordinateType(dtUtil::LocalCoordinateType::GLOBE);
+   CheckBatchConversions(locs);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void CoordinateTests::TestBatchConversionPerformance()
+{
+   const unsigned count = 100000;
+   std::vector<osg::Vec3d> locs;
+
+   converter->SetIncomingCoordinateType(dtUtil::IncomingCoordinateType::GEOCENTRIC);
+   converter->SetLocalCoordinateType(dtUtil::LocalCoordinateType::CARTESIAN_UTM);
+   converter->SetLocalOffset(osg::Vec3d(562078.225268, 3788040.632974, -32.0));
+   converter->SetUTMZone(11);
+   MakeRemoteLocations(locs, count);
+
+   std::vector<osg::Vec3> translations(count);
+   std::vector<osg::Vec3d> remoteLocs(count);
+
+   osg::Timer* timer = osg::Timer::instance();
+
+   osg::Timer_t start = timer->tick();
+   for (unsigned i = 0; i < count; ++i)
+   {
+      translations[i] = converter->ConvertToLocalTranslation(locs[i]);
+   }
+   double singleLocal = timer->delta_s(start, timer->tick());
+
+   start = timer->tick();
+   converter->ConvertToLocalTranslations(&locs[0], &translations[0], count);
+   double batchLocal = timer->delta_s(start, timer->tick());
+
+   start = timer->tick();
+   for (unsigned i = 0; i < count; ++i)
+   {
+      remoteLocs[i] = converter->ConvertToRemoteTranslation(translations[i]);
+   }
+   double singleRemote = timer->delta_s(start, timer->tick());
+
+   start = timer->tick();
+   converter->ConvertToRemoteTranslations(&translations[0], &remoteLocs[0], count);
+   double batchRemote = timer->delta_s(start, timer->tick());
+
+   std::cout << std::endl << "Geocentric to UTM, " << count << " points: single "
+            << double(count) / singleLocal / 1.0e6 << " Mpts/s, batch " << double(count) / batchLocal / 1.0e6 << " Mpts/s" << std::endl;
+   std::cout << "UTM to geocentric, " << count << " points: single "
+            << double(count) / singleRemote / 1.0e6 << " Mpts/s, batch " << double(count) / batchRemote / 1.0e6 << " Mpts/s" << std::endl;
+}
@@ -33,7 +33,13 @@
 #include <dtUtil/fileutils.h>
 #include <dtUtil/logobserver.h>
 #include <dtUtil/datapathutils.h>
+#include <dtUtil/stringutils.h>
 #include <cppunit/extensions/HelperMacros.h>
+#include <OpenThreads/Thread>
+#include <osg/Timer>
+#include <algorithm>
+#include <iostream>
+#include <vector>
 
 /**
  * @class LogTests
@@ -51,6 +57,9 @@ class LogTests : public CPPUNIT_NS::TestFixture
       CPPUNIT_TEST(TestOutputStream);
       CPPUNIT_TEST(TestAddingCustomLogObserver);
       CPPUNIT_TEST(TestTriggeringCustomLogObserver);
+      CPPUNIT_TEST(TestAsyncLogging);
+      CPPUNIT_TEST(TestAsyncLoggingOverflow);
+      //CPPUNIT_TEST(TestAsyncLoggingPerformance); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -84,6 +93,10 @@ class LogTests : public CPPUNIT_NS::TestFixture
 
       void TestTriggeringCustomLogObserver();
 
+      void TestAsyncLogging();
+      void TestAsyncLoggingOverflow();
+      void TestAsyncLoggingPerformance();
+
    private:
       std::string mMsgStr;
       std::string mSource;
@@ -408,3 +421,195 @@ void LogTests::TestTriggeringCustomLogObserver()
 
    Log::GetInstance().RemoveObserver(*testObserver);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+class CountingObserver : public dtUtil::LogObserver
+{
+public:
+   CountingObserver(unsigned delayMicroseconds = 0)
+   : mCount(0)
+   , mDelayMicroseconds(delayMicroseconds)
+   , mInOrder(true)
+   {
+   }
+
+   virtual void LogMessage(const LogData& logData)
+   {
+      if (mDelayMicroseconds > 0)
+      {
+         OpenThreads::Thread::microSleep(mDelayMicroseconds);
+      }
+      if (logData.msg != dtUtil::ToString(mCount))
+      {
+         mInOrder = false;
+      }
+      ++mCount;
+   }
+
+   unsigned mCount;
+   unsigned mDelayMicroseconds;
+   bool mInOrder;
+protected:
+   virtual ~CountingObserver() {};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// Logs a number of messages and records how long each call took.
+class LogProducerThread : public OpenThreads::Thread
+{
+public:
+   LogProducerThread(dtUtil::Log& log, unsigned count)
+   : mLog(log)
+   , mCount(count)
+   {
+      mLatencies.reserve(count);
+   }
+
+   virtual void run()
+   {
+      osg::Timer* timer = osg::Timer::instance();
+      for (unsigned i = 0; i < mCount; ++i)
+      {
+         osg::Timer_t start = timer->tick();
+         mLog.LogMessage(DT_LOG_SOURCE, "Benchmark message", dtUtil::Log::LOG_INFO);
+         mLatencies.push_back(timer->delta_u(start, timer->tick()));
+      }
+   }
+
+   dtUtil::Log& mLog;
+   unsigned mCount;
+   std::vector<double> mLatencies;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+void LogTests::TestAsyncLogging()
+{
+   using namespace dtUtil;
+
+   Log& log = Log::GetInstance("AsyncLogTest");
+   log.SetLogLevel(Log::LOG_DEBUG);
+   log.SetOutputStreamBit(Log::TO_OBSERVER);
+
+   dtCore::RefPtr<CountingObserver> observer = new CountingObserver;
+   log.AddObserver(*observer);
+
+   CPPUNIT_ASSERT(!Log::IsAsyncLoggingEnabled());
+   Log::EnableAsyncLogging(64, Log::OVERFLOW_BLOCK);
+   CPPUNIT_ASSERT(Log::IsAsyncLoggingEnabled());
+   CPPUNIT_ASSERT_EQUAL(Log::OVERFLOW_BLOCK, Log::GetAsyncOverflowPolicy());
+
+   // More than the queue holds, so the block policy gets used.
+   const unsigned count = 1000;
+   for (unsigned i = 0; i < count; ++i)
+   {
+      log.LogMessage(DT_LOG_SOURCE, dtUtil::ToString(i), Log::LOG_DEBUG);
+   }
+
+   Log::Flush();
+   CPPUNIT_ASSERT_EQUAL(count, observer->mCount);
+   CPPUNIT_ASSERT_MESSAGE("The messages from one thread should be written in order.", observer->mInOrder);
+
+   log.LogMessage(DT_LOG_SOURCE, dtUtil::ToString(count), Log::LOG_DEBUG);
+   Log::DisableAsyncLogging();
+   CPPUNIT_ASSERT(!Log::IsAsyncLoggingEnabled());
+   CPPUNIT_ASSERT_EQUAL_MESSAGE("Disabling the asynchronous mode should write the queued messages.",
+            count + 1, observer->mCount);
+
+   // Back to synchronous.
+   log.LogMessage(DT_LOG_SOURCE, dtUtil::ToString(count + 1), Log::LOG_DEBUG);
+   CPPUNIT_ASSERT_EQUAL(count + 2, observer->mCount);
+
+   log.RemoveObserver(*observer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LogTests::TestAsyncLoggingOverflow()
+{
+   using namespace dtUtil;
+
+   Log& log = Log::GetInstance("AsyncLogTest");
+   log.SetLogLevel(Log::LOG_DEBUG);
+   log.SetOutputStreamBit(Log::TO_OBSERVER);
+
+   // A slow observer so the queue fills up.
+   dtCore::RefPtr<CountingObserver> observer = new CountingObserver(1000);
+   log.AddObserver(*observer);
+
+   unsigned droppedBefore = Log::GetDroppedMessageCount();
+
+   Log::EnableAsyncLogging(16, Log::OVERFLOW_DROP);
+   const unsigned count = 200;
+   for (unsigned i = 0; i < count; ++i)
+   {
+      log.LogMessage(DT_LOG_SOURCE, "overflow", Log::LOG_DEBUG);
+   }
+   Log::DisableAsyncLogging();
+
+   unsigned dropped = Log::GetDroppedMessageCount() - droppedBefore;
+   CPPUNIT_ASSERT_MESSAGE("Some messages should have been dropped.", dropped > 0);
+   CPPUNIT_ASSERT_EQUAL(count, observer->mCount + dropped);
+
+   log.RemoveObserver(*observer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void RunLogBenchmark(dtUtil::Log& log, unsigned numThreads, unsigned messagesPerThread, const std::string& label)
+{
+   std::vector<LogProducerThread*> threads;
+   for (unsigned i = 0; i < numThreads; ++i)
+   {
+      threads.push_back(new LogProducerThread(log, messagesPerThread));
+   }
+
+   osg::Timer* timer = osg::Timer::instance();
+   osg::Timer_t start = timer->tick();
+   for (unsigned i = 0; i < numThreads; ++i)
+   {
+      threads[i]->start();
+   }
+   std::vector<double> latencies;
+   for (unsigned i = 0; i < numThreads; ++i)
+   {
+      threads[i]->join();
+      latencies.insert(latencies.end(), threads[i]->mLatencies.begin(), threads[i]->mLatencies.end());
+      delete threads[i];
+   }
+   double producerSeconds = timer->delta_s(start, timer->tick());
+   dtUtil::Log::Flush();
+   double totalSeconds = timer->delta_s(start, timer->tick());
+
+   std::sort(latencies.begin(), latencies.end());
+   double total = double(numThreads * messagesPerThread);
+   std::cout << label << " " << numThreads << " threads: "
+            << unsigned(total / producerSeconds) << " msg/s logged, "
+            << unsigned(total / totalSeconds) << " msg/s written, latency us p50 " << latencies[latencies.size() / 2]
+            << " p99 " << latencies[latencies.size() * 99 / 100]
+            << " max " << latencies.back() << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LogTests::TestAsyncLoggingPerformance()
+{
+   using namespace dtUtil;
+
+   const unsigned messagesPerThread = 20000;
+
+   Log& log = Log::GetInstance("AsyncLogBenchmark");
+   log.SetLogLevel(Log::LOG_INFO);
+   log.SetOutputStreamBit(Log::TO_FILE | Log::TO_OBSERVER);
+
+   dtCore::RefPtr<CountingObserver> observer = new CountingObserver;
+   log.AddObserver(*observer);
+
+   std::cout << std::endl;
+   for (unsigned numThreads = 1; numThreads <= 8; numThreads *= 2)
+   {
+      RunLogBenchmark(log, numThreads, messagesPerThread, "Synchronous ");
+
+      Log::EnableAsyncLogging(Log::DEFAULT_ASYNC_QUEUE_SIZE, Log::OVERFLOW_BLOCK);
+      RunLogBenchmark(log, numThreads, messagesPerThread, "Asynchronous");
+      Log::DisableAsyncLogging();
+   }
+
+   log.RemoveObserver(*observer);
+}
@@ -30,6 +30,10 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <dtUtil/threadpool.h>
 #include <dtUtil/log.h>
+#include <OpenThreads/ScopedLock>
+#include <osg/Timer>
+#include <cmath>
+#include <iostream>
 
 class TestTask : public dtUtil::ThreadPoolTask
 {
@@ -71,6 +75,105 @@ public:
    DT_DECLARE_ACCESSOR_INLINE(bool, OkayToDelete);
 };
 
+/// Records the order tasks in a dependency graph ran in.
+class OrderedTask : public dtUtil::ThreadPoolTask
+{
+public:
+   OrderedTask(std::vector<int>& order, OpenThreads::Mutex& orderMutex, int stage)
+   : mOrder(order)
+   , mOrderMutex(orderMutex)
+   , mStage(stage)
+   {
+   }
+
+   virtual void operator()()
+   {
+      // Do a bit of work so later stages have a chance to run early if the dependencies are broken.
+      volatile double sum = 0.0;
+      for (unsigned i = 0; i < 10000; ++i)
+      {
+         sum += std::sqrt(double(i));
+      }
+
+      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mOrderMutex);
+      mOrder.push_back(mStage);
+   }
+
+private:
+   std::vector<int>& mOrder;
+   OpenThreads::Mutex& mOrderMutex;
+   int mStage;
+};
+
+/// Counts how many times each index is visited by a ParallelFor.
+class VisitCounter
+{
+public:
+   VisitCounter(std::vector<unsigned>& visits)
+   : mVisits(visits)
+   {
+   }
+
+   void operator()(unsigned begin, unsigned end)
+   {
+      for (unsigned i = begin; i < end; ++i)
+      {
+         ++mVisits[i];
+      }
+   }
+
+private:
+   std::vector<unsigned>& mVisits;
+};
+
+/// Runs a ParallelFor over 100 indices for every index it is given.
+class NestedVisitCounter
+{
+public:
+   NestedVisitCounter(std::vector<unsigned>& visits)
+   : mVisits(visits)
+   {
+   }
+
+   void operator()(unsigned begin, unsigned end)
+   {
+      VisitCounter counter(mVisits);
+      for (unsigned i = begin; i < end; ++i)
+      {
+         dtUtil::ThreadPool::ParallelFor(i * 100U, i * 100U + 100U, 7U, counter);
+      }
+   }
+
+private:
+   std::vector<unsigned>& mVisits;
+};
+
+/// Enough math per index to make a ParallelFor worth splitting.
+class SqrtWork
+{
+public:
+   SqrtWork(std::vector<double>& results)
+   : mResults(results)
+   {
+   }
+
+   void operator()(unsigned begin, unsigned end)
+   {
+      for (unsigned i = begin; i < end; ++i)
+      {
+         double x = double(i);
+         for (unsigned j = 0; j < 200; ++j)
+         {
+            x = std::sqrt(x + double(j));
+         }
+         mResults[i] = x;
+      }
+   }
+
+private:
+   std::vector<double>& mResults;
+};
+
 /**
  * @class ThreadPoolTests
  * @brief Unit tests for the string utils class
@@ -79,6 +182,11 @@ class ThreadPoolTests : public CPPUNIT_NS::TestFixture {
    CPPUNIT_TEST_SUITE(ThreadPoolTests);
    CPPUNIT_TEST(TestImmediateTasks);
    CPPUNIT_TEST(TestBackgroundTasksWithBlock);
+   CPPUNIT_TEST(TestParallelFor);
+   CPPUNIT_TEST(TestParallelForWithoutWorkers);
+   CPPUNIT_TEST(TestTaskDependencies);
+   CPPUNIT_TEST(TestStatistics);
+   //CPPUNIT_TEST(TestParallelForScaling); //disabled - just used for benchmarking
    CPPUNIT_TEST_SUITE_END();
 
    public:
@@ -144,6 +252,190 @@ class ThreadPoolTests : public CPPUNIT_NS::TestFixture {
       }
    }
 
+   void CheckParallelFor()
+   {
+      const unsigned grainSizes[] = { 0U, 1U, 7U, 64U, 100000U };
+      const unsigned numIndices = 10007U;
+      for (unsigned g = 0; g < sizeof(grainSizes) / sizeof(grainSizes[0]); ++g)
+      {
+         std::vector<unsigned> visits(numIndices);
+         VisitCounter counter(visits);
+         dtUtil::ThreadPool::ParallelFor(0U, numIndices, grainSizes[g], counter);
+         for (unsigned i = 0; i < numIndices; ++i)
+         {
+            CPPUNIT_ASSERT_EQUAL(1U, visits[i]);
+         }
+      }
+
+      // An empty range should not call the body at all.
+      std::vector<unsigned> visits(1);
+      VisitCounter counter(visits);
+      dtUtil::ThreadPool::ParallelFor(5U, 5U, 1U, counter);
+      CPPUNIT_ASSERT_EQUAL(0U, visits[0]);
+
+      // A ParallelFor run from inside a ParallelFor has to help rather than wait, or it would deadlock.
+      std::vector<unsigned> nestedVisits(5000U);
+      NestedVisitCounter nestedCounter(nestedVisits);
+      dtUtil::ThreadPool::ParallelFor(0U, 50U, 1U, nestedCounter);
+      for (unsigned i = 0; i < nestedVisits.size(); ++i)
+      {
+         CPPUNIT_ASSERT_EQUAL(1U, nestedVisits[i]);
+      }
+   }
+
+   void TestParallelFor()
+   {
+      dtUtil::ThreadPool::Shutdown();
+      dtUtil::ThreadPool::Init(3);
+      CheckParallelFor();
+   }
+
+   void TestParallelForWithoutWorkers()
+   {
+      dtUtil::ThreadPool::Shutdown();
+      dtUtil::ThreadPool::Init(0);
+      CheckParallelFor();
+
+      dtUtil::ThreadPool::Shutdown();
+      CheckParallelFor();
+      dtUtil::ThreadPool::Init();
+   }
+
+   void TestTaskDependencies()
+   {
+      dtUtil::ThreadPool::Shutdown();
+      dtUtil::ThreadPool::Init(3);
+
+      std::vector<int> order;
+      OpenThreads::Mutex orderMutex;
+
+      // physics -> dead reckoning -> (animation, sound) -> publish
+      dtCore::RefPtr<OrderedTask> physics = new OrderedTask(order, orderMutex, 0);
+      dtCore::RefPtr<OrderedTask> deadReckoning = new OrderedTask(order, orderMutex, 1);
+      dtCore::RefPtr<OrderedTask> animation = new OrderedTask(order, orderMutex, 2);
+      dtCore::RefPtr<OrderedTask> sound = new OrderedTask(order, orderMutex, 2);
+      dtCore::RefPtr<OrderedTask> publish = new OrderedTask(order, orderMutex, 3);
+
+      deadReckoning->AddDependency(*physics);
+      animation->AddDependency(*deadReckoning);
+      sound->AddDependency(*deadReckoning);
+      publish->AddDependency(*animation);
+      publish->AddDependency(*sound);
+
+      CPPUNIT_ASSERT_EQUAL(0U, physics->GetNumDependencies());
+      CPPUNIT_ASSERT_EQUAL(1U, deadReckoning->GetNumDependencies());
+      CPPUNIT_ASSERT_EQUAL(2U, publish->GetNumDependencies());
+
+      // The same graph is run every "frame", and the tasks are added in reverse order so they have to wait.
+      for (unsigned frame = 0; frame < 50; ++frame)
+      {
+         order.clear();
+         dtUtil::ThreadPool::AddTask(*publish);
+         dtUtil::ThreadPool::AddTask(*animation);
+         // A background task may depend on, and be depended on by, immediate tasks.
+         dtUtil::ThreadPool::AddTask(*sound, (frame % 2) == 0 ? dtUtil::ThreadPool::IMMEDIATE : dtUtil::ThreadPool::BACKGROUND);
+         dtUtil::ThreadPool::AddTask(*deadReckoning);
+         dtUtil::ThreadPool::AddTask(*physics);
+
+         dtUtil::ThreadPool::ExecuteTasks();
+         CPPUNIT_ASSERT(publish->WaitUntilComplete(1000));
+
+         CPPUNIT_ASSERT_EQUAL(size_t(5), order.size());
+         CPPUNIT_ASSERT_EQUAL(0, order[0]);
+         CPPUNIT_ASSERT_EQUAL(1, order[1]);
+         CPPUNIT_ASSERT_EQUAL(2, order[2]);
+         CPPUNIT_ASSERT_EQUAL(2, order[3]);
+         CPPUNIT_ASSERT_EQUAL(3, order[4]);
+      }
+   }
+
+   void TestStatistics()
+   {
+      dtUtil::ThreadPool::Shutdown();
+      dtUtil::ThreadPool::Init(3);
+
+      std::vector<dtUtil::ThreadPool::QueueStatistics> stats;
+      dtUtil::ThreadPool::GetStatistics(stats);
+      CPPUNIT_ASSERT_EQUAL(size_t(dtUtil::ThreadPool::GetNumImmediateWorkerThreads()), stats.size());
+
+      std::vector<dtCore::RefPtr<TestTask> > testTasks;
+      const unsigned numTasks = 20U;
+      for (unsigned i = 0; i < numTasks; ++i)
+      {
+         testTasks.push_back(new TestTask(0));
+         dtUtil::ThreadPool::AddTask(*testTasks.back());
+      }
+      dtUtil::ThreadPool::ExecuteTasks();
+
+      unsigned executed = 0;
+      dtUtil::ThreadPool::GetStatistics(stats);
+      for (unsigned i = 0; i < stats.size(); ++i)
+      {
+         executed += stats[i].mTasksExecuted;
+         CPPUNIT_ASSERT(stats[i].mTasksStolen <= stats[i].mTasksExecuted);
+      }
+      CPPUNIT_ASSERT_EQUAL(numTasks, executed);
+
+      dtUtil::ThreadPool::ResetStatistics();
+      dtUtil::ThreadPool::GetStatistics(stats);
+      for (unsigned i = 0; i < stats.size(); ++i)
+      {
+         CPPUNIT_ASSERT_EQUAL(0U, stats[i].mTasksExecuted);
+         CPPUNIT_ASSERT_EQUAL(0U, stats[i].mTasksStolen);
+         CPPUNIT_ASSERT_EQUAL(0U, stats[i].mFailedSteals);
+         CPPUNIT_ASSERT_EQUAL(0U, stats[i].mLockContentions);
+      }
+
+      for (unsigned i = 0; i < numTasks; ++i)
+      {
+         testTasks[i]->SetOkayToDelete(true);
+      }
+   }
+
+   void TestParallelForScaling()
+   {
+      const unsigned numIndices = 400000U;
+      const unsigned numRuns = 5U;
+      std::vector<double> results(numIndices);
+      SqrtWork work(results);
+
+      osg::Timer* timer = osg::Timer::instance();
+      double singleThreadTime = 0.0;
+      const unsigned threadCounts[] = { 1U, 2U, 4U, 8U, 16U };
+      for (unsigned t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+      {
+         // The thread calling ParallelFor does its share, so it needs one less worker.
+         dtUtil::ThreadPool::Shutdown();
+         dtUtil::ThreadPool::Init(int(threadCounts[t]) - 1);
+         dtUtil::ThreadPool::ResetStatistics();
+
+         osg::Timer_t start = timer->tick();
+         for (unsigned run = 0; run < numRuns; ++run)
+         {
+            dtUtil::ThreadPool::ParallelFor(0U, numIndices, 256U, work);
+         }
+         double elapsed = timer->delta_m(start, timer->tick()) / double(numRuns);
+         if (t == 0)
+         {
+            singleThreadTime = elapsed;
+         }
+
+         std::vector<dtUtil::ThreadPool::QueueStatistics> stats;
+         dtUtil::ThreadPool::GetStatistics(stats);
+         unsigned stolen = 0, failedSteals = 0, contentions = 0;
+         for (unsigned i = 0; i < stats.size(); ++i)
+         {
+            stolen += stats[i].mTasksStolen;
+            failedSteals += stats[i].mFailedSteals;
+            contentions += stats[i].mLockContentions;
+         }
+
+         std::cout << "ParallelFor " << threadCounts[t] << " threads: " << elapsed << " ms, speedup "
+                   << singleThreadTime / elapsed << ", stolen " << stolen << ", failed steals " << failedSteals
+                   << ", lock contentions " << contentions << std::endl;
+      }
+   }
+
    private:
       unsigned mOldNumImmediateWorkerThreads;
 };
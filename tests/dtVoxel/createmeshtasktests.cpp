@@ -0,0 +1,339 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2016, Caper Holdings, LLC
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <prefix/unittestprefix.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <dtVoxel/createmeshtask.h>
+#include <dtCore/timer.h>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Vec4>
+
+#include <openvdb/openvdb.h>
+#include <openvdb/tools/LevelSetSphere.h>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+namespace dtVoxel
+{
+   class CreateMeshTaskTests : public CPPUNIT_NS::TestFixture
+   {
+      CPPUNIT_TEST_SUITE(CreateMeshTaskTests);
+
+         CPPUNIT_TEST(testSameMeshForAnyThreadCount);
+         CPPUNIT_TEST(testVertsWelded);
+         CPPUNIT_TEST(testIncrementalRemeshMatchesFullRemesh);
+         CPPUNIT_TEST(testEditsCoalesced);
+         //CPPUNIT_TEST(testMeshingPerformance); //disabled - just used for benchmarking
+         //CPPUNIT_TEST(testSmallEditReplayPerformance); //disabled - just used for benchmarking
+
+      CPPUNIT_TEST_SUITE_END();
+
+   public:
+      void setUp() override
+      {
+         openvdb::initialize();
+         CreateGrid();
+      }
+
+      void tearDown() override
+      {
+         mGrid = nullptr;
+      }
+
+      void testSameMeshForAnyThreadCount()
+      {
+         for (int skipBackFaces = 0; skipBackFaces < 2; ++skipBackFaces)
+         {
+            osg::ref_ptr<osg::Vec3Array> singleVerts;
+            osg::ref_ptr<osg::DrawElementsUInt> singleElements;
+            CreateMesh(CreateMeshTask::RunInSingleThread, 1, skipBackFaces != 0, 64, singleVerts, singleElements);
+            CPPUNIT_ASSERT(!singleElements->empty());
+
+            const int threadCounts[] = { 1, 2, 4, 8 };
+            for (unsigned t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+            {
+               osg::ref_ptr<osg::Vec3Array> verts;
+               osg::ref_ptr<osg::DrawElementsUInt> elements;
+               CreateMesh(CreateMeshTask::UseSetNumThreads, threadCounts[t], skipBackFaces != 0, 64, verts, elements);
+
+               CPPUNIT_ASSERT_EQUAL(singleVerts->size(), verts->size());
+               CPPUNIT_ASSERT_EQUAL(singleElements->size(), elements->size());
+               CPPUNIT_ASSERT(std::memcmp(&singleVerts->front(), &verts->front(), verts->size() * sizeof(osg::Vec3)) == 0);
+               CPPUNIT_ASSERT(std::memcmp(&singleElements->front(), &elements->front(), elements->size() * sizeof(GLuint)) == 0);
+            }
+         }
+      }
+
+      void testVertsWelded()
+      {
+         osg::ref_ptr<osg::Vec3Array> verts;
+         osg::ref_ptr<osg::DrawElementsUInt> elements;
+         CreateMesh(CreateMeshTask::UseSetNumThreads, 4, false, 64, verts, elements);
+
+         std::vector<bool> used(verts->size(), false);
+         std::map<std::pair<unsigned, unsigned>, unsigned> edgeUses;
+         for (unsigned i = 0; i < elements->size(); i += 3)
+         {
+            for (unsigned v = 0; v < 3; ++v)
+            {
+               unsigned a = (*elements)[i + v], b = (*elements)[i + (v + 1) % 3];
+               CPPUNIT_ASSERT(a < verts->size());
+               CPPUNIT_ASSERT_MESSAGE("No triangle should be degenerate", a != b);
+               used[a] = true;
+               ++edgeUses[std::make_pair(std::min(a, b), std::max(a, b))];
+            }
+         }
+
+         for (unsigned i = 0; i < used.size(); ++i)
+         {
+            CPPUNIT_ASSERT(used[i]);
+         }
+
+         // If every vertex is welded to its neighbors, the sphere is closed, so each edge is in exactly two triangles.
+         std::map<std::pair<unsigned, unsigned>, unsigned>::const_iterator i, iend = edgeUses.end();
+         for (i = edgeUses.begin(); i != iend; ++i)
+         {
+            CPPUNIT_ASSERT_EQUAL(2U, i->second);
+         }
+
+         int eulerCharacteristic = int(verts->size()) - int(edgeUses.size()) + int(elements->size() / 3);
+         CPPUNIT_ASSERT_EQUAL(2, eulerCharacteristic);
+      }
+
+      void testIncrementalRemeshMatchesFullRemesh()
+      {
+         const CreateMeshTask::GenerateMode modes[] = { CreateMeshTask::RunInSingleThread, CreateMeshTask::UseSetNumThreads };
+         for (unsigned m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+         {
+            CreateGrid();
+
+            dtCore::RefPtr<CreateMeshTask> task = NewTask(modes[m], 4, false, 64);
+            CPPUNIT_ASSERT(task->NeedsUpdate());
+            (*task)();
+            osg::ref_ptr<osg::Vec3Array> verts;
+            osg::ref_ptr<osg::DrawElementsUInt> elements;
+            TakeMesh(*task, verts, elements);
+            CPPUNIT_ASSERT(!task->NeedsUpdate());
+            CPPUNIT_ASSERT_EQUAL(64U * 64U * 64U, task->GetLastRemeshedCells());
+
+            // Craters on the surface, one of them on the edge of the block and one across a brick corner.
+            const osg::Vec4 craters[] = { osg::Vec4(5.5f, 0.0f, 0.0f, 1.0f), osg::Vec4(0.0f, 0.0f, -5.5f, 0.75f),
+                     osg::Vec4(-3.2f, 3.2f, 2.0f, 1.5f), osg::Vec4(4.0f, 4.0f, 0.0f, 0.5f) };
+            for (unsigned c = 0; c < sizeof(craters) / sizeof(craters[0]); ++c)
+            {
+               osg::BoundingBox bb = CarveCrater(osg::Vec3(craters[c].x(), craters[c].y(), craters[c].z()), craters[c].w());
+               task->UpdateWithBounds(bb);
+               CPPUNIT_ASSERT(task->NeedsUpdate());
+               (*task)();
+               TakeMesh(*task, verts, elements);
+
+               CPPUNIT_ASSERT_EQUAL(1U, task->GetLastNumEdits());
+               CPPUNIT_ASSERT(task->GetLastRemeshedCells() > 0U);
+               CPPUNIT_ASSERT(task->GetLastRemeshedCells() < 64U * 64U * 64U / 4U);
+               CPPUNIT_ASSERT(task->GetLastRemeshedVolume() > 0.0);
+
+               // Remeshing part of the cell has to give exactly what remeshing all of it would.
+               osg::ref_ptr<osg::Vec3Array> fullVerts;
+               osg::ref_ptr<osg::DrawElementsUInt> fullElements;
+               CreateMesh(modes[m], 4, false, 64, fullVerts, fullElements);
+               CPPUNIT_ASSERT_EQUAL(fullVerts->size(), verts->size());
+               CPPUNIT_ASSERT_EQUAL(fullElements->size(), elements->size());
+               CPPUNIT_ASSERT(std::memcmp(&fullVerts->front(), &verts->front(), verts->size() * sizeof(osg::Vec3)) == 0);
+               CPPUNIT_ASSERT(std::memcmp(&fullElements->front(), &elements->front(), elements->size() * sizeof(GLuint)) == 0);
+            }
+         }
+      }
+
+      void testEditsCoalesced()
+      {
+         dtCore::RefPtr<CreateMeshTask> task = NewTask(CreateMeshTask::UseSetNumThreads, 4, false, 64);
+         (*task)();
+         osg::ref_ptr<osg::Vec3Array> verts;
+         osg::ref_ptr<osg::DrawElementsUInt> elements;
+         TakeMesh(*task, verts, elements);
+
+         osg::BoundingBox bbA = CarveCrater(osg::Vec3(5.5f, 0.0f, 0.0f), 0.75f);
+         osg::BoundingBox bbB = CarveCrater(osg::Vec3(5.5f, 0.5f, 0.0f), 0.75f);
+         task->UpdateWithBounds(bbA);
+         task->UpdateWithBounds(bbB);
+         // This one misses the task's cells entirely.
+         task->UpdateWithBounds(osg::BoundingBox(osg::Vec3(100.0f, 100.0f, 100.0f), osg::Vec3(101.0f, 101.0f, 101.0f)));
+
+         osg::BoundingBox bothBB = bbA;
+         bothBB.expandBy(bbB);
+         osg::BoundingBox pendingBB;
+         CPPUNIT_ASSERT(task->GetPendingBounds(pendingBB));
+         CPPUNIT_ASSERT(pendingBB._min == bothBB._min && pendingBB._max == bothBB._max);
+
+         (*task)();
+         TakeMesh(*task, verts, elements);
+         CPPUNIT_ASSERT(!task->GetPendingBounds(pendingBB));
+         CPPUNIT_ASSERT_EQUAL(2U, task->GetLastNumEdits());
+
+         // Overlapping edits cost what one edit of both would, not the sum of the two.
+         dtCore::RefPtr<CreateMeshTask> unionTask = NewTask(CreateMeshTask::UseSetNumThreads, 4, false, 64);
+         (*unionTask)();
+         unionTask->UpdateWithBounds(bothBB);
+         (*unionTask)();
+         osg::ref_ptr<osg::Vec3Array> unionVerts;
+         osg::ref_ptr<osg::DrawElementsUInt> unionElements;
+         TakeMesh(*unionTask, unionVerts, unionElements);
+         CPPUNIT_ASSERT_EQUAL(unionTask->GetLastRemeshedCells(), task->GetLastRemeshedCells());
+         CPPUNIT_ASSERT_EQUAL(unionElements->size(), elements->size());
+
+         // With nothing edited, nothing is resampled and the mesh stays the same.
+         (*task)();
+         osg::ref_ptr<osg::Vec3Array> sameVerts;
+         osg::ref_ptr<osg::DrawElementsUInt> sameElements;
+         TakeMesh(*task, sameVerts, sameElements);
+         CPPUNIT_ASSERT_EQUAL(0U, task->GetLastRemeshedCells());
+         CPPUNIT_ASSERT_EQUAL(elements->size(), sameElements->size());
+         CPPUNIT_ASSERT(std::memcmp(&elements->front(), &sameElements->front(), elements->size() * sizeof(GLuint)) == 0);
+      }
+
+      void testMeshingPerformance()
+      {
+         const int numRuns = 5;
+         const int threadCounts[] = { 1, 2, 4, 8 };
+         for (unsigned t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+         {
+            dtCore::Timer_t start = dtCore::Timer::Instance()->Tick();
+            unsigned numTriangles = 0;
+            for (int run = 0; run < numRuns; ++run)
+            {
+               osg::ref_ptr<osg::Vec3Array> verts;
+               osg::ref_ptr<osg::DrawElementsUInt> elements;
+               CreateMesh(CreateMeshTask::UseSetNumThreads, threadCounts[t], true, 128, verts, elements);
+               numTriangles += unsigned(elements->size() / 3);
+            }
+            double seconds = dtCore::Timer::Instance()->DeltaSec(start, dtCore::Timer::Instance()->Tick());
+
+            std::cout << std::endl << threadCounts[t] << " threads: " << numTriangles / numRuns << " triangles in "
+                     << seconds * 1000.0 / numRuns << " ms, " << double(numTriangles) / seconds << " triangles per second" << std::endl;
+         }
+      }
+
+      void testSmallEditReplayPerformance()
+      {
+         const int resolution = 128;
+         const unsigned numEdits = 100;
+
+         dtCore::RefPtr<CreateMeshTask> task = NewTask(CreateMeshTask::UseSetNumThreads, 4, true, resolution);
+         dtCore::Timer_t start = dtCore::Timer::Instance()->Tick();
+         (*task)();
+         double fullMillis = dtCore::Timer::Instance()->DeltaMil(start, dtCore::Timer::Instance()->Tick());
+         osg::ref_ptr<osg::Vec3Array> verts;
+         osg::ref_ptr<osg::DrawElementsUInt> elements;
+         TakeMesh(*task, verts, elements);
+
+         // Small craters spiraling around the sphere, one remesh each, as if they came in one per frame.
+         double remeshedVolume = 0.0;
+         start = dtCore::Timer::Instance()->Tick();
+         for (unsigned e = 0; e < numEdits; ++e)
+         {
+            float z = -4.5f + 9.0f * float(e) / float(numEdits);
+            float angle = float(e) * 2.4f;
+            float r = std::sqrt(5.5f * 5.5f - z * z);
+            task->UpdateWithBounds(CarveCrater(osg::Vec3(r * std::cos(angle), r * std::sin(angle), z), 0.5f));
+            (*task)();
+            TakeMesh(*task, verts, elements);
+            remeshedVolume += task->GetLastRemeshedVolume();
+         }
+         double editMillis = dtCore::Timer::Instance()->DeltaMil(start, dtCore::Timer::Instance()->Tick()) / numEdits;
+
+         std::cout << std::endl << "Full remesh " << fullMillis << " ms, remesh per small edit " << editMillis << " ms, "
+                  << remeshedVolume / numEdits << " of " << 16.0 * 16.0 * 16.0 << " cubic units remeshed per edit" << std::endl;
+      }
+
+   private:
+      void CreateGrid()
+      {
+         // The surface ends up half a unit outside of the sphere, since the iso level is 0.5.
+         mGrid = openvdb::tools::createLevelSetSphere<openvdb::FloatGrid>(5.0f, openvdb::Vec3f(0.0f, 0.0f, 0.0f), 0.25f, 3.0f);
+      }
+
+      /// Pushes every voxel within the radius of the center out of the surface, and returns the bounds of the change.
+      osg::BoundingBox CarveCrater(const osg::Vec3& center, float radius)
+      {
+         openvdb::FloatGrid::Accessor accessor = mGrid->getAccessor();
+         const double voxelSize = mGrid->voxelSize()[0];
+         const openvdb::Coord centerIndex = mGrid->transform().worldToIndexCellCentered(openvdb::Vec3d(center.x(), center.y(), center.z()));
+         const int indexRadius = int(std::ceil(radius / voxelSize));
+         for (int x = -indexRadius; x <= indexRadius; ++x)
+         {
+            for (int y = -indexRadius; y <= indexRadius; ++y)
+            {
+               for (int z = -indexRadius; z <= indexRadius; ++z)
+               {
+                  if ((x * x + y * y + z * z) * voxelSize * voxelSize <= radius * radius)
+                  {
+                     accessor.setValue(centerIndex.offsetBy(x, y, z), mGrid->background());
+                  }
+               }
+            }
+         }
+
+         // The center was rounded to the nearest voxel.
+         const float extent = radius + float(voxelSize);
+         return osg::BoundingBox(center - osg::Vec3(extent, extent, extent), center + osg::Vec3(extent, extent, extent));
+      }
+
+      CreateMeshTask* NewTask(CreateMeshTask::GenerateMode mode, int numThreads, bool skipBackFaces, int resolution)
+      {
+         const float texel = 16.0f / float(resolution);
+         CreateMeshTask* task = new CreateMeshTask(osg::Vec3(-8.0f, -8.0f, -8.0f), osg::Vec3(texel, texel, texel),
+                  osg::Vec3i(resolution, resolution, resolution), 0.5, mGrid);
+         task->SetMode(mode);
+         task->SetNumThreads(numThreads);
+         task->SetSkipBackFaces(skipBackFaces);
+         return task;
+      }
+
+      void CreateMesh(CreateMeshTask::GenerateMode mode, int numThreads, bool skipBackFaces, int resolution,
+               osg::ref_ptr<osg::Vec3Array>& vertsOut, osg::ref_ptr<osg::DrawElementsUInt>& elementsOut)
+      {
+         dtCore::RefPtr<CreateMeshTask> task = NewTask(mode, numThreads, skipBackFaces, resolution);
+         (*task)();
+         TakeMesh(*task, vertsOut, elementsOut);
+      }
+
+      void TakeMesh(CreateMeshTask& task, osg::ref_ptr<osg::Vec3Array>& vertsOut, osg::ref_ptr<osg::DrawElementsUInt>& elementsOut)
+      {
+         CPPUNIT_ASSERT(task.IsDone());
+
+         osg::ref_ptr<osg::Geode> geode = task.TakeGeometry();
+         CPPUNIT_ASSERT_EQUAL(1U, geode->getNumDrawables());
+         osg::Geometry* geom = geode->getDrawable(0)->asGeometry();
+         CPPUNIT_ASSERT(geom != NULL);
+         vertsOut = dynamic_cast<osg::Vec3Array*>(geom->getVertexArray());
+         elementsOut = dynamic_cast<osg::DrawElementsUInt*>(geom->getPrimitiveSet(0));
+         CPPUNIT_ASSERT(vertsOut.valid() && elementsOut.valid());
+      }
+
+      openvdb::FloatGrid::Ptr mGrid;
+   };
+
+   CPPUNIT_TEST_SUITE_REGISTRATION(CreateMeshTaskTests);
+}
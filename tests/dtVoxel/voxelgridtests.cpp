@@ -0,0 +1,229 @@
+/* -*-c++-*-
+ * Delta3D Open Source Game and Simulation Engine
+ * Copyright (C) 2016, Caper Holdings, LLC
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 2.1 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <prefix/unittestprefix.h>
+#include <dtVoxel/voxelactor.h>
+#include <dtVoxel/voxelactorregistry.h>
+#include <dtVoxel/voxelblock.h>
+#include <dtVoxel/voxelgrid.h>
+#include <dtUtil/exception.h>
+#include <dtUtil/fileutils.h>
+#include <dtCore/project.h>
+#include <dtCore/refptr.h>
+#include "../dtGame/basegmtests.h"
+
+#include <osg/NodeVisitor>
+#include <osg/PagedLOD>
+
+#include <openvdb/openvdb.h>
+#include <openvdb/tools/LevelSetSphere.h>
+
+namespace dtVoxel
+{
+   /// Stands in for the database pager, giving each block's paged LOD a child with a node for each cell.
+   class PageInCellsVisitor : public osg::NodeVisitor
+   {
+   public:
+      PageInCellsVisitor(VoxelBlock& block, int cellsPerSide)
+         : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+         , mBlock(block)
+         , mCellsPerSide(cellsPerSide)
+      {
+      }
+
+      virtual void apply(osg::PagedLOD& lod)
+      {
+         if (lod.getNumChildren() == 0)
+         {
+            dtCore::RefPtr<osg::Group> cells = new osg::Group;
+            for (int z = 0; z < mCellsPerSide; ++z)
+            {
+               for (int y = 0; y < mCellsPerSide; ++y)
+               {
+                  for (int x = 0; x < mCellsPerSide; ++x)
+                  {
+                     dtCore::RefPtr<osg::Group> cell = new osg::Group;
+                     cell->setName(mBlock.GetCellName(x, y, z));
+                     cells->addChild(cell);
+                  }
+               }
+            }
+            lod.addChild(cells);
+         }
+      }
+
+   private:
+      VoxelBlock& mBlock;
+      int mCellsPerSide;
+   };
+
+   class VoxelGridTests : public dtGame::BaseGMTestFixture
+   {
+      typedef dtGame::BaseGMTestFixture BaseClass;
+      CPPUNIT_TEST_SUITE(VoxelGridTests);
+
+         CPPUNIT_TEST(testEditDuringUpdateRequeuesOnlyItsCell);
+
+      CPPUNIT_TEST_SUITE_END();
+
+   public:
+      void GetRequiredLibraries(NameVector& names) override
+      {
+         static const std::string voxelLib("dtVoxel");
+         names.push_back(voxelLib);
+      }
+
+      void setUp() override
+      {
+         BaseClass::setUp();
+         openvdb::initialize();
+
+         mVolumesDir = dtCore::Project::GetInstance().GetContext() + "/Volumes/";
+         mMadeVolumesDir = !dtUtil::FileUtils::GetInstance().DirExists(mVolumesDir);
+         if (mMadeVolumesDir)
+         {
+            dtUtil::FileUtils::GetInstance().MakeDirectory(mVolumesDir);
+         }
+
+         // A sphere in the middle of one block of 2 x 2 x 2 cells, 8 units on a side.
+         openvdb::FloatGrid::Ptr grid = openvdb::tools::createLevelSetSphere<openvdb::FloatGrid>(5.0f, openvdb::Vec3f(8.0f, 8.0f, 8.0f), 0.5f, 3.0f);
+         openvdb::GridPtrVec grids;
+         grids.push_back(grid);
+         openvdb::io::File file(mVolumesDir + VOLUME_FILE);
+         file.write(grids);
+         file.close();
+      }
+
+      void tearDown() override
+      {
+         mGrid = NULL;
+         mVoxelActor = NULL;
+         BaseClass::tearDown();
+
+         dtUtil::FileUtils& fileUtils = dtUtil::FileUtils::GetInstance();
+         if (mMadeVolumesDir)
+         {
+            fileUtils.DirDelete(mVolumesDir, true);
+         }
+         else
+         {
+            fileUtils.FileDelete(mVolumesDir + VOLUME_FILE);
+            if (fileUtils.DirExists(mVolumesDir + "cache/" + VOLUME_FILE))
+            {
+               fileUtils.DirDelete(mVolumesDir + "cache/" + VOLUME_FILE, true);
+            }
+         }
+      }
+
+      void testEditDuringUpdateRequeuesOnlyItsCell()
+      {
+         try
+         {
+            CreateVoxelGrid();
+            VoxelBlock* block = mGrid->GetBlockFromIndex(0);
+            const double cellVolume = 8.0 * 8.0 * 8.0;
+
+            // Both edits are well inside of cell 0, 0, 0, and the second one is inside of a single brick of it.
+            const osg::BoundingBox firstEdit(osg::Vec3(3.0f, 6.5f, 6.5f), osg::Vec3(4.0f, 7.5f, 7.5f));
+            const osg::BoundingBox secondEdit(osg::Vec3(1.5f, 1.5f, 1.5f), osg::Vec3(2.5f, 2.5f, 2.5f));
+
+            mGrid->MarkDirtyAABB(firstEdit);
+            CPPUNIT_ASSERT(block->GetCellFromIndex(0, 0, 0)->IsDirty());
+            CPPUNIT_ASSERT(!block->GetCellFromIndex(1, 0, 0)->IsDirty());
+
+            // The first mesh of the cell covers all of it.  Running it in the foreground leaves it finished but not yet
+            // collected, so the second edit comes in while the cell is still being updated.
+            mGrid->BeginNewUpdates(osg::Vec3(), 8, false);
+            mGrid->MarkDirtyAABB(secondEdit);
+
+            mGrid->UpdateGrid(osg::Vec3());
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(cellVolume, mGrid->GetRemeshedVolume(), 0.01);
+            CPPUNIT_ASSERT_MESSAGE("The edit that missed the mesh should put the cell back in the queue.",
+                     block->GetCellFromIndex(0, 0, 0)->IsDirty());
+            for (int z = 0; z < 2; ++z)
+            {
+               for (int y = 0; y < 2; ++y)
+               {
+                  for (int x = 0; x < 2; ++x)
+                  {
+                     if (x + y + z > 0)
+                     {
+                        CPPUNIT_ASSERT_MESSAGE("Requeueing a cell shouldn't dirty its neighbors.", !block->GetCellFromIndex(x, y, z)->IsDirty());
+                     }
+                  }
+               }
+            }
+
+            // The second time around only remeshes the part around the edit that was held back.
+            mGrid->BeginNewUpdates(osg::Vec3(), 8, false);
+            mGrid->UpdateGrid(osg::Vec3());
+            CPPUNIT_ASSERT(!block->GetCellFromIndex(0, 0, 0)->IsDirty());
+            const double secondRun = block->GetCellFromIndex(0, 0, 0)->GetLastRemeshedVolume();
+            CPPUNIT_ASSERT(secondRun > 0.0);
+            CPPUNIT_ASSERT(secondRun < cellVolume);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(cellVolume + secondRun, mGrid->GetRemeshedVolume(), 0.01);
+
+            // Each edit is counted once, and with both remeshed, nothing is left to do.
+            CPPUNIT_ASSERT_EQUAL(2U, mGrid->GetNumEdits());
+            CPPUNIT_ASSERT_DOUBLES_EQUAL((cellVolume + secondRun) / 2.0, mGrid->GetRemeshedVolumePerEdit(), 0.01);
+            mGrid->BeginNewUpdates(osg::Vec3(), 8, false);
+            mGrid->UpdateGrid(osg::Vec3());
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(cellVolume + secondRun, mGrid->GetRemeshedVolume(), 0.01);
+         }
+         catch(const dtUtil::Exception& ex)
+         {
+            CPPUNIT_FAIL(ex.ToString());
+         }
+      }
+
+   private:
+      void CreateVoxelGrid()
+      {
+         mGM->CreateActor(*VoxelActorRegistry::VOXEL_ACTOR_TYPE, mVoxelActor);
+         mVoxelActor->SetIsoLevel(0.0f);
+         mVoxelActor->SetDatabase(dtCore::ResourceDescriptor("Volumes:" + VOLUME_FILE));
+         mVoxelActor->CompleteLoad();
+         CPPUNIT_ASSERT_EQUAL(size_t(1U), mVoxelActor->GetNumGrids());
+
+         // The actor isn't added to the game manager, so this grid is the only one updating.
+         mGrid = new VoxelGrid();
+         mGrid->Init(osg::Vec3(), osg::Vec3(16.0f, 16.0f, 16.0f), osg::Vec3(16.0f, 16.0f, 16.0f), osg::Vec3(8.0f, 8.0f, 8.0f),
+                  osg::Vec3i(16, 16, 16), osg::Vec3i(16, 16, 16));
+         mGrid->SetViewDistance(100.0f);
+         mGrid->CreatePagedLODGrid(osg::Vec3(), *mVoxelActor);
+         CPPUNIT_ASSERT_EQUAL(1, mGrid->GetNumBlocks());
+
+         VoxelBlock* block = mGrid->GetBlockFromIndex(0);
+         PageInCellsVisitor pageIn(*block, 2);
+         block->GetOSGNode()->accept(pageIn);
+      }
+
+      static const std::string VOLUME_FILE;
+
+      std::string mVolumesDir;
+      bool mMadeVolumesDir;
+      dtCore::RefPtr<VoxelActor> mVoxelActor;
+      dtCore::RefPtr<VoxelGrid> mGrid;
+   };
+
+   const std::string VoxelGridTests::VOLUME_FILE("voxelgridtests_sphere.vdb");
+
+   CPPUNIT_TEST_SUITE_REGISTRATION(VoxelGridTests);
+
+} /* namespace dtVoxel */
@@ -0,0 +1,120 @@
+/* -*-c++-*-
+ * MapConvert - main (.h & .cpp) - Using 'The MIT License'
+ * Copyright (C) 2014, Alion Science and Technology
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+///Utility to convert a map or prefab between the XML and binary formats.
+///The format of each file is picked by its extension.
+/// Examples
+///     MapConvert.exe "c:/DemoMap" "c:/DemoMap/maps/MyCoolMap.dtmap" MyCoolMap.dtmapb
+///            will write MyCoolMap in the binary format
+///     MapConvert.exe "c:/DemoMap" Tree.dtprefabb Tree.dtprefab
+///            will write the binary Tree prefab as XML
+
+#include <dtUtil/log.h>
+#include <dtCore/project.h>
+#include <dtCore/exceptionenum.h>
+#include <dtCore/map.h>
+#include <dtCore/mapbinary.h>
+#include <dtCore/mapxml.h>
+#include <osgDB/FileNameUtils>
+
+void usage(const std::string& progName)
+{
+   LOG_ALWAYS("usage:" + progName + " <Project Context Path> <input map file> <output map file>");
+   LOG_ALWAYS("   Files ending in ." + dtCore::Map::MAP_BINARY_FILE_EXTENSION + " or ."
+            + dtCore::Map::PREFAB_BINARY_FILE_EXTENSION + " are binary, anything else is XML.");
+}
+
+bool IsPrefab(const std::string& fileName)
+{
+   std::string ext = osgDB::getLowerCaseFileExtension(fileName);
+   return ext == dtCore::Map::PREFAB_FILE_EXTENSION || ext == dtCore::Map::PREFAB_BINARY_FILE_EXTENSION;
+}
+
+int main(int argc, char** argv)
+{
+   if (argc < 4)
+   {
+      usage(std::string(argv[0]));
+      return 1;
+   }
+
+   const std::string contextPath(argv[1]);
+   const std::string inputFilename(argv[2]);
+   const std::string outputFilename(argv[3]);
+   const bool prefab = IsPrefab(inputFilename);
+
+   try
+   {
+      dtCore::Project::GetInstance().SetContext(contextPath, true);
+   }
+   catch (dtCore::ProjectInvalidContextException& e)
+   {
+      LOG_ERROR("Could not load project context");
+      e.LogException();
+      return 1;
+   }
+
+   dtCore::MapPtr map;
+   try
+   {
+      dtCore::Map* loadedMap = NULL;
+      dtCore::RefPtr<dtCore::MapParser> parser = new dtCore::MapParser();
+      if (parser->Parse(inputFilename, &loadedMap, prefab))
+      {
+         map = loadedMap;
+      }
+   }
+   catch (const dtUtil::Exception& e)
+   {
+      e.LogException();
+      return 1;
+   }
+
+   if (!map.valid())
+   {
+      LOG_ERROR("Unable to load: " + inputFilename);
+      return 1;
+   }
+
+   try
+   {
+      if (dtCore::Map::IsBinaryFileName(outputFilename))
+      {
+         dtCore::RefPtr<dtCore::MapBinaryWriter> writer = new dtCore::MapBinaryWriter();
+         writer->Save(*map, outputFilename, prefab);
+      }
+      else
+      {
+         dtCore::RefPtr<dtCore::MapWriter> writer = new dtCore::MapWriter();
+         writer->Save(*map, outputFilename, prefab);
+      }
+   }
+   catch (const dtUtil::Exception& e)
+   {
+      e.LogException();
+      return 1;
+   }
+
+   LOG_ALWAYS("Map written to: " + outputFilename);
+   return 0;
+}